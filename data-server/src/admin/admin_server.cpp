@@ -1,5 +1,6 @@
 #include "admin_server.h"
 
+#include "common/ds_config.h"
 #include "net/session.h"
 #include "frame/sf_logger.h"
 #include "server/range_server.h"
@@ -24,6 +25,10 @@ Status AdminServer::Start(uint16_t port) {
     sops.io_threads_num = 0;
     sops.max_connections = 200;
     net_server_.reset(new net::Server(sops));
+    net_server_->SetHttpHandler(
+            [this](const net::Context& ctx, const net::HttpRequest& req, net::HttpResponse* resp) {
+                onHttp(ctx, req, resp);
+            });
 
     auto ret = net_server_->ListenAndServe("0.0.0.0", port,
             [this](const net::Context& ctx, const net::MessagePtr& msg) {
@@ -45,6 +50,32 @@ Status AdminServer::checkAuth(const AdminAuth& auth) {
     return Status::OK();
 }
 
+Status AdminServer::checkHttpAuth(const net::HttpRequest& req) {
+    const std::string token(ds_config.metric_config.http_token);
+    if (token.empty()) {
+        return Status(Status::kNotSupported, "http token is not configured", "");
+    }
+    auto it = req.headers.find("authorization");
+    if (it == req.headers.end()) {
+        return Status(Status::kInvalidArgument, "missing authorization", "");
+    }
+    static const std::string kBearer = "Bearer ";
+    const auto& value = it->second;
+    if (value.size() != kBearer.size() + token.size() ||
+        value.compare(0, kBearer.size(), kBearer) != 0) {
+        return Status(Status::kInvalidArgument, "invalid authorization", "");
+    }
+    // 比较时间与内容无关
+    unsigned char diff = 0;
+    for (size_t i = 0; i < token.size(); ++i) {
+        diff |= static_cast<unsigned char>(value[kBearer.size() + i] ^ token[i]);
+    }
+    if (diff != 0) {
+        return Status(Status::kInvalidArgument, "invalid authorization", "");
+    }
+    return Status::OK();
+}
+
 Status AdminServer::execute(const AdminRequest& req, AdminResponse* resp) {
     switch (req.typ()) {
         case SET_CONFIG:
@@ -22,7 +22,13 @@ public:
 private:
     void onMessage(const net::Context& ctx, const net::MessagePtr& msg);
 
+    // GET /metrics: prometheus格式的监控指标
+    void onHttp(const net::Context& ctx, const net::HttpRequest& req, net::HttpResponse* resp);
+    std::string exportMetrics();
+
     Status checkAuth(const ds_adminpb::AdminAuth& auth);
+    // http请求按metric.http_token做bearer token校验
+    Status checkHttpAuth(const net::HttpRequest& req);
     Status execute(const ds_adminpb::AdminRequest& req, ds_adminpb::AdminResponse* resp);
 
     Status setConfig(const ds_adminpb::SetConfigRequest& req, ds_adminpb::SetConfigResponse* resp);
@@ -78,6 +78,9 @@ static const ConfigGeterMap cfg_getters = {
         ADD_CFG_GETTER(raft, log_file_size),
         ADD_CFG_GETTER(raft, max_log_files),
         ADD_CFG_GETTER(raft, allow_log_corrupt),
+        ADD_CFG_GETTER(raft, log_preallocate),
+        ADD_CFG_GETTER(raft, log_recycle_files),
+        ADD_CFG_GETTER(raft, log_disk_budget),
         ADD_CFG_GETTER(raft, consensus_threads),
         ADD_CFG_GETTER(raft, consensus_queue),
         ADD_CFG_GETTER(raft, apply_threads),
@@ -112,6 +115,8 @@ static const ConfigGeterMap cfg_getters = {
         {"heartbeat.master_num", []{ return std::to_string(ds_config.hb_config.master_num); }},
         {"heartbeat.node_heartbeat_interval", []{ return std::to_string(ds_config.hb_config.node_interval); }},
         {"heartbeat.range_heartbeat_interval", []{ return std::to_string(ds_config.hb_config.range_interval); }},
+        {"heartbeat.range_heartbeat_batch", []{ return std::to_string(ds_config.hb_config.range_batch); }},
+        {"heartbeat.range_heartbeat_full_rounds", []{ return std::to_string(ds_config.hb_config.range_full_rounds); }},
         {"heartbeat.master_host", []{
             std::string result;
             for (int i = 0; i < ds_config.hb_config.master_num; i++) {
@@ -5,6 +5,8 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include "monitor/request_trace.h"
+#include "proto/gen/funcpb.pb.h"
 #include "server/version.h"
 #include "server/range_server.h"
 #include "server/run_status.h"
@@ -142,6 +144,35 @@ static Status getRaftInfo(ContextServer* ctx, const vector<string>& path, JsonWr
         writer.Uint64(ss.total_snap_applying);
         writer.Key("snap_send");
         writer.Uint64(ss.total_snap_sending);
+        writer.Key("consensus_busy_percents");
+        writer.StartArray();
+        for (auto p : ss.consensus_busy_percents) {
+            writer.Uint64(p);
+        }
+        writer.EndArray();
+        writer.Key("apply_busy_percents");
+        writer.StartArray();
+        for (auto p : ss.apply_busy_percents) {
+            writer.Uint64(p);
+        }
+        writer.EndArray();
+        writer.Key("rebalance_migrations");
+        writer.Uint64(ss.rebalance_migrations);
+        writer.Key("rebalance_decisions");
+        writer.StartArray();
+        for (const auto& d : ss.rebalance_decisions) {
+            writer.String(d.c_str());
+        }
+        writer.EndArray();
+        writer.Key("inflight_bytes_capacity_per_node");
+        writer.Uint64(ss.inflight_bytes_capacity_per_node);
+        writer.Key("inflight_bytes_per_node");
+        writer.StartObject();
+        for (const auto& kv : ss.inflight_bytes_per_node) {
+            writer.Key(std::to_string(kv.first).c_str());
+            writer.Uint64(kv.second);
+        }
+        writer.EndObject();
         return Status::OK();
     }
 
@@ -192,10 +223,49 @@ static Status getRaftInfo(ContextServer* ctx, const vector<string>& path, JsonWr
         writer.Bool(pr.second.snapshotting);
         writer.Key("state");
         writer.String(pr.second.state.c_str());
+        writer.Key("inflight_msgs");
+        writer.Uint64(pr.second.inflight_msgs);
+        writer.Key("inflight_bytes");
+        writer.Uint64(pr.second.inflight_bytes);
+        writer.Key("window_bytes");
+        writer.Uint64(pr.second.window_bytes);
+        writer.Key("srtt_us");
+        writer.Int64(pr.second.srtt_us);
+        writer.Key("min_rtt_us");
+        writer.Int64(pr.second.min_rtt_us);
+        writer.Key("bandwidth");
+        writer.Uint64(pr.second.bandwidth);
         writer.EndObject();
     }
     writer.EndArray();
 
+    const auto& gc = stat.log_gc;
+    writer.Key("log_gc");
+    writer.StartObject();
+    writer.Key("first_index");
+    writer.Uint64(gc.first_index);
+    writer.Key("files");
+    writer.Uint64(gc.files);
+    writer.Key("bytes");
+    writer.Uint64(gc.bytes);
+    writer.Key("free_bytes");
+    writer.Uint64(gc.free_bytes);
+    writer.Key("hold_index");
+    writer.Uint64(gc.hold_index);
+    writer.Key("hold_node");
+    writer.Uint64(gc.hold_node);
+    writer.Key("pressure");
+    writer.String(gc.pressure.c_str());
+    writer.Key("truncated_index");
+    writer.Uint64(gc.truncated_index);
+    writer.Key("reason");
+    writer.String(gc.reason.c_str());
+    writer.Key("truncations");
+    writer.Uint64(gc.truncations);
+    writer.Key("forced_truncations");
+    writer.Uint64(gc.forced_truncations);
+    writer.EndObject();
+
     return Status::OK();
 }
 
@@ -205,12 +275,106 @@ static Status getRocksdbInfo(ContextServer* ctx, const vector<string>& path, Jso
     return Status::OK();
 }
 
+static Status getSlowTraceInfo(ContextServer* ctx, const vector<string>& path, JsonWriter& writer) {
+    using monitor::TraceStage;
+    using monitor::kTraceStageNum;
+
+    writer.Key("threshold_us");
+    writer.Int64(monitor::g_tracer.SlowThreshold());
+
+    // 各阶段启动以来的耗时分布
+    writer.Key("stages");
+    writer.StartObject();
+    for (uint32_t i = 1; i < kTraceStageNum; ++i) {
+        auto stage = static_cast<TraceStage>(i);
+        monitor::HistogramSnapshot snapshot;
+        monitor::g_tracer.StageSnapshot(stage, &snapshot);
+        writer.Key(monitor::TraceStageName(stage));
+        writer.StartObject();
+        writer.Key("count");
+        writer.Uint64(snapshot.num);
+        writer.Key("p50");
+        writer.Double(snapshot.Percentile(50));
+        writer.Key("p99");
+        writer.Double(snapshot.Percentile(99));
+        writer.Key("p999");
+        writer.Double(snapshot.Percentile(99.9));
+        writer.EndObject();
+    }
+    writer.EndObject();
+
+    std::vector<monitor::RequestTrace> traces;
+    monitor::g_tracer.DumpSlow(&traces);
+    writer.Key("traces");
+    writer.StartArray();
+    for (const auto& trace : traces) {
+        writer.StartObject();
+        writer.Key("trace_id");
+        writer.Uint64(trace.trace_id);
+        writer.Key("msg_id");
+        writer.Int64(trace.msg_id);
+        writer.Key("range_id");
+        writer.Uint64(trace.range_id);
+        writer.Key("func");
+        writer.String(funcpb::FunctionID_Name(static_cast<funcpb::FunctionID>(trace.func_id)).c_str());
+        writer.Key("total_us");
+        writer.Int64(trace.Total());
+
+        int64_t spans[kTraceStageNum];
+        trace.Spans(spans);
+        for (uint32_t i = 0; i < kTraceStageNum; ++i) {
+            if (spans[i] >= 0) {
+                writer.Key(monitor::TraceStageName(static_cast<TraceStage>(i)));
+                writer.Int64(spans[i]);
+            }
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+    return Status::OK();
+}
+
+static Status getCpuInfo(ContextServer* ctx, const vector<string>& path, JsonWriter& writer) {
+    monitor::CpuSample sample;
+    if (!ctx->run_status->GetCpuUsage(&sample)) {
+        return Status(Status::kNotFound, "cpu usage", "not sampled yet");
+    }
+
+    writer.Key("cpu_count");
+    writer.Uint(sample.cpu_count);
+    writer.Key("system_usage");
+    writer.Double(sample.system_usage);
+    writer.Key("process_usage");
+    writer.Double(sample.process_usage);
+    writer.Key("interval_ms");
+    writer.Int64(sample.interval_ms);
+
+    writer.Key("threads");
+    writer.StartArray();
+    for (const auto& g : sample.groups) {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(g.name.c_str());
+        writer.Key("threads");
+        writer.Uint(g.threads);
+        writer.Key("usage");
+        writer.Double(g.usage);
+        writer.Key("max");
+        writer.Double(g.max);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    return Status::OK();
+}
+
 static const GetInfoFunMap get_info_funcs = {
         {"", getServerInfo},
         {"server", getServerInfo},
         {"raft", getRaftInfo},
         {"range", getRangeInfo},
         {"rocksdb", getRocksdbInfo},
+        {"slow_trace", getSlowTraceInfo},
+        {"cpu", getCpuInfo},
 };
 
 Status AdminServer::getInfo(const ds_adminpb::GetInfoRequest& req, ds_adminpb::GetInfoResponse* resp) {
@@ -0,0 +1,321 @@
+#include "admin_server.h"
+
+#include "frame/sf_logger.h"
+#include "monitor/prometheus.h"
+#include "monitor/request_trace.h"
+#include "server/range_server.h"
+#include "server/run_status.h"
+#include "server/worker.h"
+#include "storage/metric.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace admin {
+
+using monitor::PrometheusWriter;
+
+// 每个指标只读取原子变量或者短暂持有锁，不能阻塞请求处理路径
+static const size_t kTopRangeNum = 10;
+
+// 导出的直方图上界(us)
+static const std::vector<uint64_t> kLatencyBounds = {
+    100,    250,    500,     1000,    2500,    5000,    10000,   25000,
+    50000,  100000, 250000,  500000,  1000000, 2500000, 5000000, 10000000,
+};
+
+static const std::vector<std::pair<uint32_t, const char*>> kRocksdbTickers = {
+    {rocksdb::BLOCK_CACHE_HIT, "block_cache_hit"},
+    {rocksdb::BLOCK_CACHE_MISS, "block_cache_miss"},
+    {rocksdb::ROW_CACHE_HIT, "row_cache_hit"},
+    {rocksdb::ROW_CACHE_MISS, "row_cache_miss"},
+    {rocksdb::NUMBER_KEYS_READ, "keys_read"},
+    {rocksdb::NUMBER_KEYS_WRITTEN, "keys_written"},
+    {rocksdb::BYTES_READ, "bytes_read"},
+    {rocksdb::BYTES_WRITTEN, "bytes_written"},
+    {rocksdb::COMPACT_READ_BYTES, "compact_read_bytes"},
+    {rocksdb::COMPACT_WRITE_BYTES, "compact_write_bytes"},
+    {rocksdb::FLUSH_WRITE_BYTES, "flush_write_bytes"},
+    {rocksdb::STALL_MICROS, "stall_micros"},
+};
+
+static const std::vector<std::pair<const char*, const char*>> kRocksdbProperties = {
+    {"rocksdb.estimate-table-readers-mem", "estimate_table_readers_mem"},
+    {"rocksdb.cur-size-all-mem-tables", "cur_size_all_mem_tables"},
+    {"rocksdb.estimate-num-keys", "estimate_num_keys"},
+    {"rocksdb.estimate-live-data-size", "estimate_live_data_size"},
+    {"rocksdb.estimate-pending-compaction-bytes", "estimate_pending_compaction_bytes"},
+    {"rocksdb.num-running-compactions", "num_running_compactions"},
+    {"rocksdb.num-running-flushes", "num_running_flushes"},
+};
+
+static std::vector<double> latencyBounds() {
+    std::vector<double> bounds;
+    for (auto b : kLatencyBounds) {
+        bounds.push_back(static_cast<double>(b) / 1000000);
+    }
+    return bounds;
+}
+
+static void exportLatency(server::ContextServer* ctx, PrometheusWriter& w) {
+    auto bounds = latencyBounds();
+
+    const auto& stats = ctx->run_status->GetStatistics();
+    for (uint32_t i = 0; i < monitor::kHistogramTypeNum; ++i) {
+        auto type = static_cast<monitor::HistogramType>(i);
+        monitor::HistogramBuckets buckets;
+        stats.GetCumulative(type, kLatencyBounds, &buckets);
+        w.Histogram("sharkstore_ds_request_duration_seconds",
+                    "Request latency by processing stage.", bounds, buckets.counts,
+                    buckets.count, static_cast<double>(buckets.sum) / 1000000,
+                    {{"stage", monitor::HistogramTypeName(type)}});
+    }
+}
+
+static void exportTrace(PrometheusWriter& w) {
+    auto bounds = latencyBounds();
+
+    // kRecv是起点，没有对应的耗时
+    for (uint32_t i = 1; i < monitor::kTraceStageNum; ++i) {
+        auto stage = static_cast<monitor::TraceStage>(i);
+        monitor::HistogramSnapshot snapshot;
+        monitor::g_tracer.StageSnapshot(stage, &snapshot);
+        monitor::HistogramBuckets buckets;
+        monitor::CumulativeBuckets(snapshot, kLatencyBounds, &buckets);
+        w.Histogram("sharkstore_ds_request_stage_seconds",
+                    "Traced request latency between consecutive stages.", bounds,
+                    buckets.counts, buckets.count, static_cast<double>(buckets.sum) / 1000000,
+                    {{"stage", monitor::TraceStageName(stage)}});
+    }
+}
+
+static void exportWorker(server::ContextServer* ctx, PrometheusWriter& w) {
+    auto worker = ctx->worker;
+    w.Gauge("sharkstore_ds_worker_queue_size", "Pending requests in the worker queues.",
+            worker->FastQueueSize(), {{"queue", "fast"}});
+    w.Gauge("sharkstore_ds_worker_queue_size", "Pending requests in the worker queues.",
+            worker->SlowQueueSize(), {{"queue", "slow"}});
+
+    server::AdmissionStats stats;
+    worker->GetAdmissionStats(&stats);
+    const char* shed_help = "Requests rejected with ServerIsBusy before queueing.";
+    w.Counter("sharkstore_ds_worker_shed_total", shed_help, stats.shed_queue_delay,
+              {{"reason", "queue_delay"}});
+    w.Counter("sharkstore_ds_worker_shed_total", shed_help, stats.shed_deadline,
+              {{"reason", "deadline"}});
+    w.Counter("sharkstore_ds_worker_shed_total", shed_help, stats.shed_quota,
+              {{"reason", "quota"}});
+    w.Counter("sharkstore_ds_worker_expired_total", "Requests expired in the worker queues.",
+              stats.expired);
+    w.Counter("sharkstore_ds_worker_dequeued_total", "Requests taken by worker threads.",
+              stats.dequeued);
+    w.Counter("sharkstore_ds_worker_queue_delay_seconds_total",
+              "Total time requests spent in the worker queues.",
+              static_cast<double>(stats.total_queue_delay) / 1000000);
+}
+
+static void exportCpu(server::ContextServer* ctx, PrometheusWriter& w) {
+    monitor::CpuSample sample;
+    if (!ctx->run_status->GetCpuUsage(&sample)) return;
+
+    w.Gauge("sharkstore_ds_cpu_percent", "CPU usage of the node, 0-100.", sample.system_usage,
+            {{"scope", "system"}});
+    w.Gauge("sharkstore_ds_cpu_percent", "CPU usage of the node, 0-100.",
+            sample.process_usage / (sample.cpu_count > 0 ? sample.cpu_count : 1),
+            {{"scope", "process"}});
+    // 同一个指标需要连续输出
+    for (const auto& g : sample.groups) {
+        w.Gauge("sharkstore_ds_thread_cpu_percent",
+                "CPU usage of the threads grouped by name, 100 means one full core.", g.usage,
+                {{"group", g.name}});
+    }
+    for (const auto& g : sample.groups) {
+        w.Gauge("sharkstore_ds_thread_cpu_max_percent",
+                "CPU usage of the busiest thread in the group.", g.max, {{"group", g.name}});
+    }
+    for (const auto& g : sample.groups) {
+        w.Gauge("sharkstore_ds_thread_count", "Threads in the group.", g.threads,
+                {{"group", g.name}});
+    }
+}
+
+static void exportRaft(server::ContextServer* ctx, PrometheusWriter& w) {
+    raft::ServerStatus status;
+    ctx->raft_server->GetStatus(&status);
+
+    w.Gauge("sharkstore_ds_raft_count", "Raft groups on this node.", status.total_rafts_count);
+    w.Gauge("sharkstore_ds_raft_snapshot_sending", "Snapshots being sent.",
+            status.total_snap_sending);
+    w.Gauge("sharkstore_ds_raft_snapshot_applying", "Snapshots being applied.",
+            status.total_snap_applying);
+
+    const char* help = "Pending tasks in the raft work thread queues.";
+    for (size_t i = 0; i < status.consensus_queue_sizes.size(); ++i) {
+        w.Gauge("sharkstore_ds_raft_queue_size", help, status.consensus_queue_sizes[i],
+                {{"type", "consensus"}, {"thread", std::to_string(i)}});
+    }
+    for (size_t i = 0; i < status.apply_queue_sizes.size(); ++i) {
+        w.Gauge("sharkstore_ds_raft_queue_size", help, status.apply_queue_sizes[i],
+                {{"type", "apply"}, {"thread", std::to_string(i)}});
+    }
+    const char* busy_help = "Busy time percent of the raft work threads in the last period.";
+    for (size_t i = 0; i < status.consensus_busy_percents.size(); ++i) {
+        w.Gauge("sharkstore_ds_raft_thread_busy_percent", busy_help,
+                status.consensus_busy_percents[i],
+                {{"type", "consensus"}, {"thread", std::to_string(i)}});
+    }
+    for (size_t i = 0; i < status.apply_busy_percents.size(); ++i) {
+        w.Gauge("sharkstore_ds_raft_thread_busy_percent", busy_help,
+                status.apply_busy_percents[i],
+                {{"type", "apply"}, {"thread", std::to_string(i)}});
+    }
+    w.Counter("sharkstore_ds_raft_rebalance_migrations_total",
+              "Raft groups moved between work threads by load.", status.rebalance_migrations);
+
+    w.Gauge("sharkstore_ds_raft_entry_cache_bytes", "Bytes held by the raft entry cache.",
+            status.entry_cache_size);
+    w.Gauge("sharkstore_ds_raft_entry_cache_capacity_bytes", "Raft entry cache capacity.",
+            status.entry_cache_capacity);
+    const char* lookup_help = "Raft log reads below the unstable log, by entry cache result.";
+    w.Counter("sharkstore_ds_raft_entry_cache_lookups_total", lookup_help,
+              status.entry_cache_hits, {{"result", "hit"}});
+    w.Counter("sharkstore_ds_raft_entry_cache_lookups_total", lookup_help,
+              status.entry_cache_misses, {{"result", "miss"}});
+
+    const char* inflight_help = "Unacknowledged raft replication bytes by destination node.";
+    for (const auto& kv : status.inflight_bytes_per_node) {
+        w.Gauge("sharkstore_ds_raft_inflight_bytes", inflight_help, kv.second,
+                {{"node", std::to_string(kv.first)}});
+    }
+    w.Gauge("sharkstore_ds_raft_inflight_capacity_bytes",
+            "Limit of unacknowledged raft replication bytes per destination node.",
+            status.inflight_bytes_capacity_per_node);
+
+    w.Gauge("sharkstore_ds_raft_log_disk_bytes", "Disk space used by raft logs of all ranges.",
+            status.log_disk_bytes, {{"type", "total"}});
+    w.Gauge("sharkstore_ds_raft_log_disk_bytes", "Disk space used by raft logs of all ranges.",
+            status.log_disk_free_bytes, {{"type", "free"}});
+    w.Gauge("sharkstore_ds_raft_log_disk_budget_bytes",
+            "Limit of raft log disk space, 0 means unlimited.", status.log_disk_budget);
+    w.Gauge("sharkstore_ds_raft_log_pool_files", "Retired raft log files waiting for reuse.",
+            status.log_pool_files);
+    w.Counter("sharkstore_ds_raft_log_recycled_files_total",
+              "Truncated raft log files moved into the recycle pool.",
+              status.log_recycled_files);
+    w.Counter("sharkstore_ds_raft_log_reused_files_total",
+              "Raft log files created from the recycle pool.", status.log_reused_files);
+
+    const char* bytes_help =
+        "Raft append and snapshot messages above the compression threshold, in bytes.";
+    w.Counter("sharkstore_ds_raft_transport_compress_bytes_total", bytes_help,
+              status.compress_raw_bytes, {{"stage", "before"}});
+    w.Counter("sharkstore_ds_raft_transport_compress_bytes_total", bytes_help,
+              status.compress_sent_bytes, {{"stage", "after"}});
+    const char* msgs_help = "Raft messages by compression result.";
+    w.Counter("sharkstore_ds_raft_transport_compress_messages_total", msgs_help,
+              status.compressed_msgs, {{"result", "compressed"}});
+    w.Counter("sharkstore_ds_raft_transport_compress_messages_total", msgs_help,
+              status.compress_skipped_msgs, {{"result", "skipped"}});
+}
+
+static void exportRange(server::ContextServer* ctx, PrometheusWriter& w) {
+    auto rs = ctx->range_server;
+    w.Gauge("sharkstore_ds_range_count", "Ranges on this node.", rs->GetRangesSize());
+    w.Gauge("sharkstore_ds_range_leader_count", "Ranges led by this node.",
+            ctx->run_status->GetLeaderCount());
+    w.Gauge("sharkstore_ds_range_split_count", "Ranges being split.",
+            ctx->run_status->GetSplitCount());
+    w.Gauge("sharkstore_ds_disk_usage_percent", "Used percent of the data disk.",
+            ctx->run_status->GetFilesystemUsedPercent());
+
+    // 节点和range的速率都是最近一次心跳采集的结果
+    storage::MetricStat node_stat;
+    storage::g_metric.LastStat(&node_stat);
+    w.Gauge("sharkstore_ds_keys_read_per_second", "Keys read per second.",
+            node_stat.keys_read_per_sec);
+    w.Gauge("sharkstore_ds_keys_write_per_second", "Keys written per second.",
+            node_stat.keys_write_per_sec);
+    w.Gauge("sharkstore_ds_bytes_read_per_second", "Bytes read per second.",
+            node_stat.bytes_read_per_sec);
+    w.Gauge("sharkstore_ds_bytes_write_per_second", "Bytes written per second.",
+            node_stat.bytes_write_per_sec);
+
+    std::vector<server::RangeServer::RangeMetric> top_read, top_write;
+    rs->TopRangeMetrics(kTopRangeNum, &top_read, &top_write);
+    for (const auto& m : top_read) {
+        w.Gauge("sharkstore_ds_top_range_keys_read_per_second",
+                "Keys read per second of the hottest leader ranges.", m.stat.keys_read_per_sec,
+                {{"range_id", std::to_string(m.range_id)}});
+    }
+    for (const auto& m : top_write) {
+        w.Gauge("sharkstore_ds_top_range_keys_write_per_second",
+                "Keys written per second of the hottest leader ranges.",
+                m.stat.keys_write_per_sec, {{"range_id", std::to_string(m.range_id)}});
+    }
+}
+
+static void exportRocksdb(server::ContextServer* ctx, PrometheusWriter& w) {
+    auto db = ctx->rocks_db;
+    for (const auto& prop : kRocksdbProperties) {
+        uint64_t value = 0;
+        if (db->GetIntProperty(prop.first, &value)) {
+            w.Gauge("sharkstore_ds_rocksdb_property", "RocksDB integer properties.", value,
+                    {{"name", prop.second}});
+        }
+    }
+
+    const char* cache_help = "RocksDB cache memory usage in bytes.";
+    w.Gauge("sharkstore_ds_rocksdb_cache_bytes", cache_help, ctx->block_cache->GetUsage(),
+            {{"cache", "block"}, {"type", "usage"}});
+    w.Gauge("sharkstore_ds_rocksdb_cache_bytes", cache_help, ctx->block_cache->GetPinnedUsage(),
+            {{"cache", "block"}, {"type", "pinned"}});
+    if (ctx->row_cache) {
+        w.Gauge("sharkstore_ds_rocksdb_cache_bytes", cache_help, ctx->row_cache->GetUsage(),
+                {{"cache", "row"}, {"type", "usage"}});
+    }
+
+    auto stat = ctx->db_stats;
+    if (stat) {
+        for (const auto& ticker : kRocksdbTickers) {
+            w.Counter("sharkstore_ds_rocksdb_ticker_total", "RocksDB statistics tickers.",
+                      stat->getTickerCount(ticker.first), {{"name", ticker.second}});
+        }
+    }
+}
+
+std::string AdminServer::exportMetrics() {
+    PrometheusWriter writer;
+    exportLatency(context_, writer);
+    exportTrace(writer);
+    exportWorker(context_, writer);
+    exportCpu(context_, writer);
+    exportRaft(context_, writer);
+    exportRange(context_, writer);
+    exportRocksdb(context_, writer);
+    return writer.Text();
+}
+
+void AdminServer::onHttp(const net::Context& ctx, const net::HttpRequest& req,
+                         net::HttpResponse* resp) {
+    auto ret = checkHttpAuth(req);
+    if (!ret.ok()) {
+        FLOG_WARN("[Admin] http request %s %s from %s denied: %s", req.method.c_str(),
+                  req.path.c_str(), ctx.remote_addr.c_str(), ret.ToString().c_str());
+        resp->status = 401;
+        resp->body = "unauthorized\n";
+        return;
+    }
+
+    if (req.path == "/metrics") {
+        resp->content_type = PrometheusWriter::kContentType;
+        resp->body = exportMetrics();
+    } else {
+        FLOG_WARN("[Admin] unknown http request %s %s from %s", req.method.c_str(),
+                  req.path.c_str(), ctx.remote_addr.c_str());
+        resp->status = 404;
+        resp->body = "not found\n";
+    }
+}
+
+} // namespace admin
+} // namespace dataserver
+} // namespace sharkstore
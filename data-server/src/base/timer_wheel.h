@@ -0,0 +1,136 @@
+_Pragma("once");
+
+#include <cstddef>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace sharkstore {
+
+// 分层时间轮，添加和取消都是O(1)，适合大量短时间定时器频繁重设的场景
+// 每层64个槽，第0层一个槽是一个tick，第n层一个槽是64^n个tick
+// 超过最大范围的先放在最高层，转到时再重新放置
+// 不是线程安全的，由调用方加锁
+template <typename T>
+class TimerWheel {
+public:
+    static const int kLevels = 4;
+    static const int kSlotBits = 6;
+    static const uint64_t kSlots = 1 << kSlotBits;
+
+    // tick_ms: 时间精度，now_ms: 当前时间(毫秒)
+    TimerWheel(int64_t tick_ms, int64_t now_ms)
+        : tick_ms_(tick_ms > 0 ? tick_ms : 1), current_(toTick(now_ms)) {
+        for (auto& level : wheels_) {
+            level.resize(kSlots);
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // 添加一个expire_ms(绝对时间，毫秒)到期的定时器，返回定时器id(不会是0)
+    uint64_t Add(int64_t expire_ms, const T& data) {
+        uint64_t id = ++last_id_;
+        uint64_t tick = toTick(expire_ms);
+        // 向上取整，保证不会提前到期
+        if (static_cast<int64_t>(tick) * tick_ms_ < expire_ms) ++tick;
+        timers_.emplace(id, Entry{tick, data});
+        place(id, tick);
+        return id;
+    }
+
+    // 取消定时器，已经到期或者不存在的返回false
+    // 槽里的id不立即删除，转到时发现不在timers_里直接跳过
+    bool Cancel(uint64_t id) { return timers_.erase(id) > 0; }
+
+    // 推进到now_ms，到期的定时器追加到expired
+    void Advance(int64_t now_ms, std::vector<T>* expired) {
+        uint64_t target = toTick(now_ms);
+        while (current_ < target) {
+            ++current_;
+            cascade();
+            auto& slot = wheels_[0][current_ & (kSlots - 1)];
+            if (slot.empty()) continue;
+
+            std::vector<uint64_t> ids;
+            ids.swap(slot);
+            for (auto id : ids) {
+                auto it = timers_.find(id);
+                if (it == timers_.end()) continue;
+                if (it->second.tick <= current_) {
+                    expired->push_back(std::move(it->second.data));
+                    timers_.erase(it);
+                } else {
+                    place(id, it->second.tick);
+                }
+            }
+        }
+    }
+
+    size_t Size() const { return timers_.size(); }
+
+private:
+    struct Entry {
+        uint64_t tick;
+        T data;
+    };
+
+    uint64_t toTick(int64_t ms) const {
+        return ms > 0 ? static_cast<uint64_t>(ms / tick_ms_) : 0;
+    }
+
+    void place(uint64_t id, uint64_t tick) {
+        if (tick <= current_) {
+            // 已经到期的放到下一个tick
+            tick = current_ + 1;
+        }
+        uint64_t delta = tick - current_;
+        for (int level = 0; level < kLevels; ++level) {
+            if (delta < (kSlots << (level * kSlotBits))) {
+                auto slot = (tick >> (level * kSlotBits)) & (kSlots - 1);
+                wheels_[level][slot].push_back(id);
+                return;
+            }
+        }
+        // 超出范围，放到最高层最远的槽
+        int top = kLevels - 1;
+        auto far = current_ + (kSlots - 1) * (uint64_t(1) << (top * kSlotBits));
+        wheels_[top][(far >> (top * kSlotBits)) & (kSlots - 1)].push_back(id);
+    }
+
+    // 低层转完一圈时把高层对应槽里的定时器重新放置
+    void cascade() {
+        for (int level = 1; level < kLevels; ++level) {
+            if ((current_ & ((uint64_t(1) << (level * kSlotBits)) - 1)) != 0) {
+                return;
+            }
+            auto& slot = wheels_[level][(current_ >> (level * kSlotBits)) & (kSlots - 1)];
+            if (slot.empty()) continue;
+            std::vector<uint64_t> ids;
+            ids.swap(slot);
+            for (auto id : ids) {
+                auto it = timers_.find(id);
+                if (it != timers_.end()) {
+                    place(id, it->second.tick);
+                }
+            }
+        }
+    }
+
+private:
+    const int64_t tick_ms_;
+    uint64_t current_ = 0;
+    uint64_t last_id_ = 0;
+    std::unordered_map<uint64_t, Entry> timers_;
+    std::vector<std::vector<uint64_t>> wheels_[kLevels];
+};
+
+template <typename T>
+const int TimerWheel<T>::kLevels;
+template <typename T>
+const int TimerWheel<T>::kSlotBits;
+template <typename T>
+const uint64_t TimerWheel<T>::kSlots;
+
+} /* namespace sharkstore */
@@ -310,6 +310,12 @@ static int load_raft_config(IniContext *ini_context) {
 
     ds_config.raft_config.allow_log_corrupt =
          iniGetIntValue(section, "allow_log_corrupt", ini_context, 1);
+    ds_config.raft_config.log_preallocate =
+         iniGetIntValue(section, "log_preallocate", ini_context, 1);
+    ds_config.raft_config.log_recycle_files = (size_t)load_integer_value_atleast(
+            ini_context, section, "log_recycle_files", 64, 0);
+    ds_config.raft_config.log_disk_budget =
+        load_bytes_value_ne(ini_context, section, "log_disk_budget", 0);
 
     ds_config.raft_config.consensus_threads = (size_t)load_integer_value_atleast(
             ini_context, section, "consensus_threads", 4, 1);
@@ -325,6 +331,15 @@ static int load_raft_config(IniContext *ini_context) {
             ini_context, section, "transport_send_threads", 4, 1);
     ds_config.raft_config.transport_recv_threads = (size_t)load_integer_value_atleast(
             ini_context, section, "transport_recv_threads", 4, 1);
+    ds_config.raft_config.transport_io_backend = sf_parse_io_backend(
+            iniGetStrValue(section, "transport_io_backend", ini_context));
+
+    temp_str = iniGetStrValue(section, "transport_compression", ini_context);
+    snprintf(ds_config.raft_config.transport_compression,
+             sizeof(ds_config.raft_config.transport_compression), "%s",
+             temp_str != NULL ? temp_str : "none");
+    ds_config.raft_config.compression_threshold =
+        load_bytes_value_ne(ini_context, section, "compression_threshold", 4096);
 
     ds_config.raft_config.tick_interval_ms = (size_t)load_integer_value_atleast(
            ini_context, section, "tick_interval", 500, 100);
@@ -332,6 +347,35 @@ static int load_raft_config(IniContext *ini_context) {
     ds_config.raft_config.max_msg_size =
         load_bytes_value_ne(ini_context, section, "max_msg_size", 1024 * 1024);
 
+    ds_config.raft_config.entry_cache_size =
+        load_bytes_value_ne(ini_context, section, "entry_cache_size", 64 * 1024 * 1024);
+
+    ds_config.raft_config.max_inflight_size =
+        load_bytes_value_ne(ini_context, section, "max_inflight_size", 8 * 1024 * 1024);
+    if (ds_config.raft_config.max_inflight_size > 0 &&
+        ds_config.raft_config.max_inflight_size < ds_config.raft_config.max_msg_size) {
+        ds_config.raft_config.max_inflight_size = ds_config.raft_config.max_msg_size;
+    }
+    ds_config.raft_config.adaptive_inflight =
+        iniGetIntValue(section, "adaptive_inflight", ini_context, 1);
+    ds_config.raft_config.node_inflight_size =
+        load_bytes_value_ne(ini_context, section, "node_inflight_size", 64 * 1024 * 1024);
+
+    ds_config.raft_config.rebalance_interval = (size_t)load_integer_value_atleast(
+           ini_context, section, "rebalance_interval", 10, 0);
+    ds_config.raft_config.rebalance =
+         iniGetIntValue(section, "rebalance", ini_context, 1);
+    ds_config.raft_config.rebalance_busy_percent = load_integer_value_atleast(
+           ini_context, section, "rebalance_busy_percent", 70, 1);
+    ds_config.raft_config.rebalance_imbalance_percent = load_integer_value_atleast(
+           ini_context, section, "rebalance_imbalance_percent", 30, 1);
+    if (ds_config.raft_config.rebalance_busy_percent > 100) {
+        ds_config.raft_config.rebalance_busy_percent = 100;
+    }
+    if (ds_config.raft_config.rebalance_imbalance_percent > 100) {
+        ds_config.raft_config.rebalance_imbalance_percent = 100;
+    }
+
     return 0;
 }
 
@@ -342,28 +386,56 @@ void print_raft_config() {
               "\n\tlog_file_size: %lu"
               "\n\tmax_log_files: %lu"
               "\n\tallow_log_corrupt: %d"
+              "\n\tlog_preallocate: %d"
+              "\n\tlog_recycle_files: %lu"
+              "\n\tlog_disk_budget: %lu"
               "\n\tconsensus_threads: %lu"
               "\n\tconsensus_queue: %lu"
               "\n\tapply_threads: %lu"
               "\n\tapply_queue: %lu"
               "\n\tsend_threads: %lu"
               "\n\trecv_threads: %lu"
+              "\n\tio_backend: %s"
+              "\n\tcompression: %s"
+              "\n\tcompression_threshold: %lu"
               "\n\ttick_interval_ms: %lu"
               "\n\tmax_msg_size: %lu"
+              "\n\tentry_cache_size: %lu"
+              "\n\tmax_inflight_size: %lu"
+              "\n\tadaptive_inflight: %d"
+              "\n\tnode_inflight_size: %lu"
+              "\n\trebalance_interval: %lu"
+              "\n\trebalance: %d"
+              "\n\trebalance_busy_percent: %d"
+              "\n\trebalance_imbalance_percent: %d"
               ,
               ds_config.raft_config.port,
               ds_config.raft_config.log_path,
               ds_config.raft_config.log_file_size,
               ds_config.raft_config.max_log_files,
               ds_config.raft_config.allow_log_corrupt,
+              ds_config.raft_config.log_preallocate,
+              ds_config.raft_config.log_recycle_files,
+              ds_config.raft_config.log_disk_budget,
               ds_config.raft_config.consensus_threads,
               ds_config.raft_config.consensus_queue,
               ds_config.raft_config.apply_threads,
               ds_config.raft_config.apply_queue,
               ds_config.raft_config.transport_send_threads,
               ds_config.raft_config.transport_recv_threads,
+              sf_io_backend_name(ds_config.raft_config.transport_io_backend),
+              ds_config.raft_config.transport_compression,
+              ds_config.raft_config.compression_threshold,
               ds_config.raft_config.tick_interval_ms,
-              ds_config.raft_config.max_msg_size
+              ds_config.raft_config.max_msg_size,
+              ds_config.raft_config.entry_cache_size,
+              ds_config.raft_config.max_inflight_size,
+              ds_config.raft_config.adaptive_inflight,
+              ds_config.raft_config.node_inflight_size,
+              ds_config.raft_config.rebalance_interval,
+              ds_config.raft_config.rebalance,
+              ds_config.raft_config.rebalance_busy_percent,
+              ds_config.raft_config.rebalance_imbalance_percent
     );
 }
 
@@ -375,6 +447,16 @@ static int load_metric_config(IniContext *ini_context) {
     if (ds_config.metric_config.interval <= 0) {
         ds_config.metric_config.interval = 10;
     }
+
+    ds_config.metric_config.slow_trace_threshold =
+        iniGetIntValue(section, "slow_trace_threshold", ini_context, 500);
+    if (ds_config.metric_config.slow_trace_threshold < 0) {
+        ds_config.metric_config.slow_trace_threshold = 0;
+    }
+
+    char *temp_str = iniGetStrValue(section, "http_token", ini_context);
+    snprintf(ds_config.metric_config.http_token, sizeof(ds_config.metric_config.http_token),
+             "%s", temp_str != NULL ? temp_str : "");
     return 0;
 }
 
@@ -393,6 +475,21 @@ static int load_watch_config(IniContext *ini_context) {
         ds_config.watch_config.buffer_queue_size = 100;
     }
 
+    ds_config.watch_config.change_log =
+            (bool)iniGetIntValue(section, "change_log", ini_context, 1);
+
+    ds_config.watch_config.change_log_retention =
+            iniGetIntValue(section, "change_log_retention", ini_context, 600);
+    if (ds_config.watch_config.change_log_retention <= 0) {
+        ds_config.watch_config.change_log_retention = 600;
+    }
+
+    ds_config.watch_config.change_log_max_entries =
+            iniGetIntValue(section, "change_log_max_entries", ini_context, 100000);
+    if (ds_config.watch_config.change_log_max_entries <= 0) {
+        ds_config.watch_config.change_log_max_entries = 100000;
+    }
+
     return 0;
 }
 
@@ -412,6 +509,15 @@ static int load_heartbeat_config(IniContext *ini_context) {
         ds_config.hb_config.range_interval = 10;
     }
 
+    ds_config.hb_config.range_batch =
+        (bool)iniGetIntValue(section, "range_heartbeat_batch", ini_context, 0);
+
+    ds_config.hb_config.range_full_rounds =
+        iniGetIntValue(section, "range_heartbeat_full_rounds", ini_context, 6);
+    if (ds_config.hb_config.range_full_rounds < 0) {
+        ds_config.hb_config.range_full_rounds = 6;
+    }
+
     ds_config.hb_config.master_num =
         iniGetIntValue(section, "master_num", ini_context, 3);
     if (ds_config.hb_config.master_num <= 0) {
@@ -455,6 +561,30 @@ static int load_woker_num_config(IniContext *ini_context) {
         ds_config.slow_worker_num = 8;
     }
 
+    ds_config.admission_config.queue_delay_target =
+        iniGetIntValue(section, "queue_delay_target", ini_context, 0);
+    if (ds_config.admission_config.queue_delay_target < 0) {
+        ds_config.admission_config.queue_delay_target = 0;
+    }
+
+    ds_config.admission_config.slow_queue_delay_target =
+        iniGetIntValue(section, "slow_queue_delay_target", ini_context, 0);
+    if (ds_config.admission_config.slow_queue_delay_target < 0) {
+        ds_config.admission_config.slow_queue_delay_target = 0;
+    }
+
+    ds_config.admission_config.queue_delay_interval =
+        iniGetIntValue(section, "queue_delay_interval", ini_context, 200);
+    if (ds_config.admission_config.queue_delay_interval <= 0) {
+        ds_config.admission_config.queue_delay_interval = 200;
+    }
+
+    ds_config.admission_config.cluster_max_inflight =
+        iniGetIntValue(section, "cluster_max_inflight", ini_context, 0);
+    if (ds_config.admission_config.cluster_max_inflight < 0) {
+        ds_config.admission_config.cluster_max_inflight = 0;
+    }
+
     return 0;
 }
 
@@ -10,6 +10,13 @@ typedef struct ds_config_s {
 
     int task_timeout;  // defualt 3,000ms
 
+    struct {
+        int queue_delay_target;       // ms, fast queue, 0 disable; default 0
+        int slow_queue_delay_target;  // ms, slow queue, 0 disable; default 0
+        int queue_delay_interval;  // ms, default 200ms
+        int cluster_max_inflight;  // 0 unlimited
+    } admission_config;
+
     struct {
         char path[PATH_MAX];
         size_t block_cache_size; // default: 1024MB
@@ -47,10 +54,12 @@ typedef struct ds_config_s {
     } rocksdb_config;
 
     struct {
-        int node_interval;   // node heartbeat interval
-        int range_interval;  // range heartbeat interval
-        int master_num;      // master server num
-        char **master_host;  // master server host:port
+        int node_interval;      // node heartbeat interval
+        int range_interval;     // range heartbeat interval
+        bool range_batch;       // merge range heartbeats into one node request
+        int range_full_rounds;  // full report at least every N rounds in batch
+        int master_num;         // master server num
+        char **master_host;     // master server host:port
     } hb_config;
 
     struct {
@@ -69,23 +78,42 @@ typedef struct ds_config_s {
         size_t log_file_size;
         size_t max_log_files;
         int allow_log_corrupt;
+        int log_preallocate;            // 日志文件预分配
+        size_t log_recycle_files;       // 回收目录(log_path/recycle)里最多保留的日志文件，0不回收
+        size_t log_disk_budget;         // 所有range的raft日志占用空间上限，0不限制
         size_t consensus_threads;
         size_t consensus_queue;
         size_t apply_threads;
         size_t apply_queue;
         size_t transport_send_threads;
         size_t transport_recv_threads;
+        sf_io_backend_t transport_io_backend;
+        char transport_compression[16];  // none, lz4, zstd
+        size_t compression_threshold;
         size_t tick_interval_ms;
         size_t max_msg_size;
+        size_t entry_cache_size;
+        size_t max_inflight_size;       // 单个副本复制窗口上限，0只按条数限制
+        int adaptive_inflight;          // 按rtt和带宽调整复制窗口
+        size_t node_inflight_size;      // 发往同一节点的复制字节数上限，0不限制
+        size_t rebalance_interval;  // 单位秒，0表示不统计线程负载
+        int rebalance;              // 是否按负载在线程之间迁移raft
+        int rebalance_busy_percent;
+        int rebalance_imbalance_percent;
     } raft_config;
 
     struct {
         int interval;
+        int slow_trace_threshold;  // ms, 0: disable
+        char http_token[128];      // GET /metrics需要带上Authorization: Bearer <token>, 为空时不提供
     } metric_config;
 
     struct {
         int buffer_map_size;
         int buffer_queue_size;
+        bool change_log;             // 是否记录变更日志
+        int change_log_retention;    // 变更日志保留时间，单位秒
+        int change_log_max_entries;  // 每个range最多保留的变更条数
     } watch_config;
 
     sf_socket_thread_config_t manager_config;  // manager thread config
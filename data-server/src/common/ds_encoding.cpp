@@ -1,90 +1,32 @@
 #include "ds_encoding.h"
 
 #include <assert.h>
+#include <endian.h>
 #include <string.h>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace sharkstore {
 namespace dataserver {
 
-void EncodeNonSortingUvarint(std::string *buf, uint64_t x) {
-    static const uint64_t b1 = static_cast<uint64_t>(1) << 7;
-    static const uint64_t b2 = static_cast<uint64_t>(1) << 14;
-    static const uint64_t b3 = static_cast<uint64_t>(1) << 21;
-    static const uint64_t b4 = static_cast<uint64_t>(1) << 28;
-    static const uint64_t b5 = static_cast<uint64_t>(1) << 35;
-    static const uint64_t b6 = static_cast<uint64_t>(1) << 42;
-    static const uint64_t b7 = static_cast<uint64_t>(1) << 49;
-    static const uint64_t b8 = static_cast<uint64_t>(1) << 56;
-    static const uint64_t b9 = static_cast<uint64_t>(1) << 63;
-
-    if (x < b1) {
-        buf->push_back(static_cast<char>(x));
-    } else if (x < b2) {
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b3) {
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b4) {
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b5) {
-        buf->push_back(static_cast<char>(x >> 28 | 0x80));
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b6) {
-        buf->push_back(static_cast<char>(x >> 35 | 0x80));
-        buf->push_back(static_cast<char>(x >> 28 | 0x80));
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b7) {
-        buf->push_back(static_cast<char>(x >> 42 | 0x80));
-        buf->push_back(static_cast<char>(x >> 35 | 0x80));
-        buf->push_back(static_cast<char>(x >> 28 | 0x80));
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b8) {
-        buf->push_back(static_cast<char>(x >> 49 | 0x80));
-        buf->push_back(static_cast<char>(x >> 42 | 0x80));
-        buf->push_back(static_cast<char>(x >> 35 | 0x80));
-        buf->push_back(static_cast<char>(x >> 28 | 0x80));
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else if (x < b9) {
-        buf->push_back(static_cast<char>(x >> 56 | 0x80));
-        buf->push_back(static_cast<char>(x >> 49 | 0x80));
-        buf->push_back(static_cast<char>(x >> 42 | 0x80));
-        buf->push_back(static_cast<char>(x >> 35 | 0x80));
-        buf->push_back(static_cast<char>(x >> 28 | 0x80));
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
-    } else {
-        buf->push_back(static_cast<char>(x >> 63 | 0x80));
-        buf->push_back(static_cast<char>(x >> 56 | 0x80));
-        buf->push_back(static_cast<char>(x >> 42 | 0x80));
-        buf->push_back(static_cast<char>(x >> 49 | 0x80));
-        buf->push_back(static_cast<char>(x >> 35 | 0x80));
-        buf->push_back(static_cast<char>(x >> 28 | 0x80));
-        buf->push_back(static_cast<char>(x >> 21 | 0x80));
-        buf->push_back(static_cast<char>(x >> 14 | 0x80));
-        buf->push_back(static_cast<char>(x >> 7 | 0x80));
-        buf->push_back(static_cast<char>(x & 0x7f));
+// 编码后的字节数: 每7位一个字节
+static inline size_t nonSortingUvarintSize(uint64_t x) {
+    return (64 - __builtin_clzll(x | 1) + 6) / 7;
+}
+
+char *EncodeNonSortingUvarint(char *dst, uint64_t x) {
+    size_t n = nonSortingUvarintSize(x);
+    for (size_t i = n - 1; i > 0; --i) {
+        *dst++ = static_cast<char>((x >> (7 * i)) | 0x80);
     }
+    *dst++ = static_cast<char>(x & 0x7f);
+    return dst;
+}
+
+void EncodeNonSortingUvarint(std::string *buf, uint64_t x) {
+    char tmp[kMaxNonSortingUvarintSize];
+    buf->append(tmp, EncodeNonSortingUvarint(tmp, x) - tmp);
 }
 
 bool DecodeNonSortingUvarint(const std::string &data, size_t &offset, uint64_t *value) {
@@ -157,26 +99,24 @@ void encodeValueTag(std::string *buf, uint32_t col_id, EncodeType type) {
                             (static_cast<uint64_t>(col_id) << 4) | static_cast<uint64_t>(type));
 }
 
+char *EncodeUint64Ascending(char *dst, uint64_t value) {
+    uint64_t be = htobe64(value);
+    memcpy(dst, &be, sizeof(be));
+    return dst + sizeof(be);
+}
+
 void EncodeUint64Ascending(std::string *buf, uint64_t value) {
-    buf->push_back(static_cast<char>(value >> 56));
-    buf->push_back(static_cast<char>(value >> 48));
-    buf->push_back(static_cast<char>(value >> 40));
-    buf->push_back(static_cast<char>(value >> 32));
-    buf->push_back(static_cast<char>(value >> 24));
-    buf->push_back(static_cast<char>(value >> 16));
-    buf->push_back(static_cast<char>(value >> 8));
-    buf->push_back(static_cast<char>(value));
+    char tmp[sizeof(uint64_t)];
+    buf->append(tmp, EncodeUint64Ascending(tmp, value) - tmp);
 }
 
 bool DecodeUint64Ascending(const std::string &data, size_t &offset, uint64_t *value) {
     if (offset + 8 > data.size()) {
         return false;
     }
-    *value = 0;
-    for (int i = 0; i < 8; i++) {
-        *value <<= 8;
-        *value += static_cast<uint8_t>(data[offset + i]);
-    }
+    uint64_t be = 0;
+    memcpy(&be, data.data() + offset, sizeof(be));
+    *value = be64toh(be);
     offset += 8;
     return true;
 }
@@ -313,122 +253,48 @@ static const uint8_t kIntMaxWidth = 8;
 static const uint8_t kIntZero = kIntMin + kIntMaxWidth;
 static const uint8_t kIntSmall = kIntMax - kIntZero - kIntMaxWidth;  // 109
 
-void EncodeUvarintAscending(std::string *buf, uint64_t value) {
+// 非0整数需要的字节数
+static inline int uintByteLen(uint64_t value) {
+    return 8 - __builtin_clzll(value) / 8;
+}
+
+// 按大端写入低len个字节，dst至少要有8个字节的空间
+static inline char *putUintBigEndian(char *dst, uint64_t value, int len) {
+    uint64_t be = htobe64(value << (64 - 8 * len));
+    memcpy(dst, &be, sizeof(be));
+    return dst + len;
+}
+
+char *EncodeUvarintAscending(char *dst, uint64_t value) {
     if (value <= kIntSmall) {
-        buf->push_back(static_cast<char>(kIntZero + value));
-    } else if (value <= 0xff) {
-        buf->push_back(static_cast<char>(kIntMax - 7));
-        buf->push_back(static_cast<char>(value));
-    } else if (value <= 0xffff) {  // 2
-        buf->push_back(static_cast<char>(kIntMax - 6));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value <= 0xffffff) {  // 3
-        buf->push_back(static_cast<char>(kIntMax - 5));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value <= 0xffffffff) {  // 4
-        buf->push_back(static_cast<char>(kIntMax - 4));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value <= 0xffffffffff) {  // 5
-        buf->push_back(static_cast<char>(kIntMax - 3));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value <= 0xffffffffffff) {  // 6
-        buf->push_back(static_cast<char>(kIntMax - 2));
-        buf->push_back(static_cast<char>(value >> 40));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value <= 0xffffffffffffff) {  // 7
-        buf->push_back(static_cast<char>(kIntMax - 1));
-        buf->push_back(static_cast<char>(value >> 48));
-        buf->push_back(static_cast<char>(value >> 40));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else {
-        buf->push_back(static_cast<char>(kIntMax));
-        buf->push_back(static_cast<char>(value >> 56));
-        buf->push_back(static_cast<char>(value >> 48));
-        buf->push_back(static_cast<char>(value >> 40));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
+        *dst++ = static_cast<char>(kIntZero + value);
+        return dst;
     }
+    int len = uintByteLen(value);
+    *dst++ = static_cast<char>(kIntMax - 8 + len);
+    return putUintBigEndian(dst, value, len);
 }
 
-void EncodeVarintAscending(std::string *buf, int64_t value) {
+char *EncodeVarintAscending(char *dst, int64_t value) {
     if (value >= 0) {
-        return EncodeUvarintAscending(buf, static_cast<uint64_t>(value));
-    }
-
-    if (value >= -0xff) {
-        buf->push_back(static_cast<char>(kIntMin + 7));
-        buf->push_back(static_cast<char>(value));
-    } else if (value >= -0xffff) {
-        buf->push_back(static_cast<char>(kIntMin + 6));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value >= -0xffffff) {
-        buf->push_back(static_cast<char>(kIntMin + 5));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value >= -0xffffffff) {
-        buf->push_back(static_cast<char>(kIntMin + 4));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value >= -0xffffffffff) {
-        buf->push_back(static_cast<char>(kIntMin + 3));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value >= -0xffffffffffff) {
-        buf->push_back(static_cast<char>(kIntMin + 2));
-        buf->push_back(static_cast<char>(value >> 40));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else if (value >= -0xffffffffffffff) {
-        buf->push_back(static_cast<char>(kIntMin + 1));
-        buf->push_back(static_cast<char>(value >> 48));
-        buf->push_back(static_cast<char>(value >> 40));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    } else {
-        buf->push_back(static_cast<char>(kIntMin));
-        buf->push_back(static_cast<char>(value >> 56));
-        buf->push_back(static_cast<char>(value >> 48));
-        buf->push_back(static_cast<char>(value >> 40));
-        buf->push_back(static_cast<char>(value >> 32));
-        buf->push_back(static_cast<char>(value >> 24));
-        buf->push_back(static_cast<char>(value >> 16));
-        buf->push_back(static_cast<char>(value >> 8));
-        buf->push_back(static_cast<char>(value));
-    }
+        return EncodeUvarintAscending(dst, static_cast<uint64_t>(value));
+    }
+    // 字节数按绝对值计算，与原有编码保持一致
+    // 原实现中-0xffffffff按unsigned int取负，绝对值需要4个字节的负数实际编码成了5个字节
+    int len = uintByteLen(0 - static_cast<uint64_t>(value));
+    if (len == 4) len = 5;
+    *dst++ = static_cast<char>(kIntMin + 8 - len);
+    return putUintBigEndian(dst, static_cast<uint64_t>(value), len);
+}
+
+void EncodeUvarintAscending(std::string *buf, uint64_t value) {
+    char tmp[kMaxVarintAscendingSize];
+    buf->append(tmp, EncodeUvarintAscending(tmp, value) - tmp);
+}
+
+void EncodeVarintAscending(std::string *buf, int64_t value) {
+    char tmp[kMaxVarintAscendingSize];
+    buf->append(tmp, EncodeVarintAscending(tmp, value) - tmp);
 }
 
 static const uint8_t kFloatNaN = 0x00 + 1;
@@ -436,24 +302,30 @@ static const uint8_t kFloatNeg = kFloatNaN + 1;
 static const uint8_t kFloatZero = kFloatNeg + 1;
 static const uint8_t kFloatPos = kFloatZero + 1;
 
-void EncodeFloatAscending(std::string *buf, double value) {
+char *EncodeFloatAscending(char *dst, double value) {
+    if (std::isnan(value)) {
+        *dst++ = static_cast<char>(kFloatNaN);
+        return dst;
+    }
     uint64_t u = 0;
-    assert(sizeof(u) == sizeof(double));
+    static_assert(sizeof(u) == sizeof(double), "unexpected double size");
     memcpy(&u, &value, sizeof(double));
-    if (std::isnan(u)) {
-        buf->push_back(static_cast<char>(kFloatNaN));
-        return;
-    } else if (u == 0) {
-        buf->push_back(static_cast<char>(kFloatZero));
-        return;
+    if (u == 0) {
+        *dst++ = static_cast<char>(kFloatZero);
+        return dst;
     }
     if ((u & (static_cast<uint64_t>(1) << 63)) != 0) {
         u = ~u;
-        buf->push_back(static_cast<char>(kFloatNeg));
+        *dst++ = static_cast<char>(kFloatNeg);
     } else {
-        buf->push_back(static_cast<char>(kFloatPos));
+        *dst++ = static_cast<char>(kFloatPos);
     }
-    EncodeUint64Ascending(buf, u);
+    return EncodeUint64Ascending(dst, u);
+}
+
+void EncodeFloatAscending(std::string *buf, double value) {
+    char tmp[kMaxFloatAscendingSize];
+    buf->append(tmp, EncodeFloatAscending(tmp, value) - tmp);
 }
 
 static const uint8_t kBytesMarker = 0x12;
@@ -462,16 +334,57 @@ static const uint8_t kEscapedTerm = 0x01;
 static const uint8_t kEscaped00 = 0xff;
 static const uint8_t kEscapedFF = 0x00;
 
+size_t BytesAscendingSize(const char *value, size_t value_size) {
+    // marker + 数据 + 每个0x00的转义字节 + 结束符
+    size_t size = value_size + 3;
+    const char *end = value + value_size;
+    for (const char *p = value; p < end; ++size, ++p) {
+        p = static_cast<const char *>(memchr(p, kEscape, end - p));
+        if (p == nullptr) break;
+    }
+    return size;
+}
+
+char *EncodeBytesAscending(char *dst, const char *value, size_t value_size) {
+    *dst++ = static_cast<char>(kBytesMarker);
+    const char *end = value + value_size;
+    while (value < end) {
+        // memchr按字长/向量扫描，整段拷贝两个0x00之间的数据
+        auto p = static_cast<const char *>(memchr(value, kEscape, end - value));
+        if (p == nullptr) {
+            memcpy(dst, value, end - value);
+            dst += end - value;
+            break;
+        }
+        memcpy(dst, value, p - value);
+        dst += p - value;
+        *dst++ = static_cast<char>(kEscape);
+        *dst++ = static_cast<char>(kEscaped00);
+        value = p + 1;
+    }
+    *dst++ = static_cast<char>(kEscape);
+    *dst++ = static_cast<char>(kEscapedTerm);
+    return dst;
+}
+
 void EncodeBytesAscending(std::string *buf, const char *value, size_t value_size) {
+    // 按没有0x00的长度预留，不按最坏情况扩容
+    buf->reserve(buf->size() + value_size + 3);
     buf->push_back(static_cast<char>(kBytesMarker));
-    for (size_t i = 0; i < value_size; i++) {
-        buf->push_back(value[i]);
-        if (static_cast<uint8_t>(value[i]) == kEscape) {
-            buf->push_back(kEscaped00);
+    const char *end = value + value_size;
+    while (value < end) {
+        auto p = static_cast<const char *>(memchr(value, kEscape, end - value));
+        if (p == nullptr) {
+            buf->append(value, end - value);
+            break;
         }
+        buf->append(value, p - value);
+        buf->push_back(static_cast<char>(kEscape));
+        buf->push_back(static_cast<char>(kEscaped00));
+        value = p + 1;
     }
-    buf->push_back(kEscape);
-    buf->push_back(kEscapedTerm);
+    buf->push_back(static_cast<char>(kEscape));
+    buf->push_back(static_cast<char>(kEscapedTerm));
 }
 
 bool DecodeUvarintAscending(const std::string& buf, size_t& pos, uint64_t* out) {
@@ -482,7 +395,8 @@ bool DecodeUvarintAscending(const std::string& buf, size_t& pos, uint64_t* out)
         if (out) *out = len;
     } else {
         len -= kIntSmall;
-        if (len < 0 || len > 8 || pos + len >= buf.size()) return false;
+        // 标记字节之后还要有len个字节
+        if (len < 0 || len > 8 || pos + 1 + len > buf.size()) return false;
         uint64_t value = 0;
         for (++pos; len > 0; ++pos, --len) value = value << 8 | (unsigned char)buf[pos];
         if (out) *out = value;
@@ -501,7 +415,7 @@ bool DecodeVarintAscending(const std::string& buf, size_t& pos, int64_t* out) {
         return true;
     } else {
         len = -len;
-        if (pos + len >= buf.size()) return false;
+        if (pos + 1 + len > buf.size()) return false;
         int64_t value = -1;
         for (++pos; len > 0; ++pos, --len) value = value << 8 | (unsigned char)buf[pos];
         if (out) *out = value;
@@ -510,24 +424,51 @@ bool DecodeVarintAscending(const std::string& buf, size_t& pos, int64_t* out) {
 }
 
 bool DecodeFloatAscending(const std::string& buf, size_t& pos, double* out) {
-    return false;
+    if (pos >= buf.size()) return false;
+    uint64_t u = 0;
+    switch (static_cast<uint8_t>(buf[pos])) {
+        case kFloatNaN:
+            ++pos;
+            if (out) *out = std::numeric_limits<double>::quiet_NaN();
+            return true;
+        case kFloatZero:
+            ++pos;
+            if (out) *out = 0;
+            return true;
+        case kFloatNeg:
+            ++pos;
+            if (!DecodeUint64Ascending(buf, pos, &u)) return false;
+            u = ~u;
+            break;
+        case kFloatPos:
+            ++pos;
+            if (!DecodeUint64Ascending(buf, pos, &u)) return false;
+            break;
+        default:
+            return false;
+    }
+    if (out) memcpy(out, &u, sizeof(u));
+    return true;
 }
 
 bool DecodeBytesAscending(const std::string& buf, size_t& pos, std::string* out) {
     if (pos >= buf.size() || buf[pos] != kBytesMarker)
         return false;
-    for (++pos; pos < buf.size();) {
-        auto escapePos = buf.find((char) kEscape, pos);
-        if (escapePos == std::string::npos || escapePos + 1 >= buf.size()) return false;
-        auto escapeChar = (unsigned char) buf[escapePos + 1];
+    const char* data = buf.data();
+    const char* end = data + buf.size();
+    for (const char* p = data + pos + 1; p < end;) {
+        auto escape = static_cast<const char*>(memchr(p, kEscape, end - p));
+        if (escape == nullptr || escape + 1 >= end) return false;
+        auto escapeChar = static_cast<uint8_t>(escape[1]);
         if (escapeChar == kEscapedTerm) {
-            if (out) out->append(buf.substr(pos, escapePos - pos));
-            pos = escapePos + 2;
+            if (out) out->append(p, escape - p);
+            pos = escape + 2 - data;
             return true;
         }
         if (escapeChar != kEscaped00) return false;
-        if (out) out->append(buf.substr(pos, escapePos - pos + 1));
-        pos = escapePos + 2;
+        // 连同被转义的0x00一起追加
+        if (out) out->append(p, escape - p + 1);
+        p = escape + 2;
     }
     return false;
 }
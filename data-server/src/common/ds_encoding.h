@@ -27,11 +27,19 @@ enum class EncodeType : char {
     SentinelType = 15  // Used in the Value encoding.
 };
 
+// 以下char*版本的编码函数直接写入调用方预分配好的缓冲区，返回写入后的位置
+// 缓冲区至少要有对应kMax*Size个字节
+static const size_t kMaxNonSortingUvarintSize = 10;
+static const size_t kMaxVarintAscendingSize = 9;
+static const size_t kMaxFloatAscendingSize = 9;
+
+char* EncodeNonSortingUvarint(char* dst, uint64_t value);
 void EncodeNonSortingUvarint(std::string* buf, uint64_t value);
 void EncodeNonSortingVarint(std::string* buf, int64_t value);
 bool DecodeNonSortingUvarint(const std::string& data, size_t& offset, uint64_t* value);
 bool DecodeNonSortingVarint(const std::string& data, size_t& offset, int64_t* value);
 
+char* EncodeUint64Ascending(char* dst, uint64_t value);
 void EncodeUint64Ascending(std::string* buf, uint64_t value);
 bool DecodeUint64Ascending(const std::string& data, size_t& offset, uint64_t* value);
 
@@ -47,6 +55,13 @@ bool DecodeFloatValue(const std::string& data, size_t& offset, double* value);
 bool DecodeBytesValue(const std::string& data, size_t& offset, std::string* value);
 bool SkipValue(const std::string& data, size_t& offset);
 
+char* EncodeUvarintAscending(char* dst, uint64_t value);
+char* EncodeVarintAscending(char* dst, int64_t value);
+char* EncodeFloatAscending(char* dst, double value);
+// 编码后的准确长度，用于预分配EncodeBytesAscending的缓冲区
+size_t BytesAscendingSize(const char* value, size_t value_size);
+char* EncodeBytesAscending(char* dst, const char* value, size_t value_size);
+
 void EncodeUvarintAscending(std::string* buf, uint64_t value);
 void EncodeVarintAscending(std::string* buf, int64_t value);
 void EncodeFloatAscending(std::string* buf, double value);
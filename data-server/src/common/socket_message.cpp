@@ -1,11 +1,29 @@
 #include "socket_message.h"
 
+#include <algorithm>
+#include <new>
+
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 
 namespace sharkstore {
 namespace dataserver {
 namespace common {
 
+static const size_t kArenaMinBlockSize = 256;
+static const size_t kArenaMaxBlockSize = 64 * 1024;
+
+google::protobuf::Arena *ProtoMessage::GetArena() {
+    if (arena_ == nullptr) {
+        // 解析后的消息大约是body的两到三倍
+        google::protobuf::ArenaOptions options;
+        options.start_block_size =
+            std::min(std::max(body.size() * 3, kArenaMinBlockSize), kArenaMaxBlockSize);
+        options.max_block_size = kArenaMaxBlockSize;
+        arena_ = new (&arena_storage_) google::protobuf::Arena(options);
+    }
+    return arena_;
+}
+
 ProtoMessage *GetProtoMessage(const void *data) {
     auto msg = new ProtoMessage;
 
@@ -14,9 +32,10 @@ ProtoMessage *GetProtoMessage(const void *data) {
     ds_unserialize_header(proto_header, &(msg->header));
 
     // 拷贝数据
+    // 网络线程收完回调后会复用接收缓冲区，所以这里仍然需要一次拷贝，但不用先清零
     if (msg->header.body_len > 0) {
-        msg->body.resize(static_cast<size_t>(msg->header.body_len));
-        memcpy(msg->body.data(), (char *)data + header_size, msg->body.size());
+        auto body = (const char *)data + header_size;
+        msg->body.assign(body, body + msg->header.body_len);
     }
     return msg;
 }
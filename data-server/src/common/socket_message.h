@@ -1,6 +1,8 @@
 _Pragma("once");
 
+#include <type_traits>
 #include <vector>
+#include <google/protobuf/arena.h>
 #include <google/protobuf/message.h>
 
 #include "proto/gen/errorpb.pb.h"
@@ -9,6 +11,7 @@ _Pragma("once");
 #include "socket_base.h"
 #include "ds_proto.h"
 #include "frame/sf_util.h"
+#include "monitor/request_trace.h"
 
 namespace sharkstore {
 namespace dataserver {
@@ -23,9 +26,23 @@ struct ProtoMessage {
     SocketBase *socket = nullptr;
     std::vector<char> body;
 
+    // 各处理阶段的时间，回应时汇总
+    monitor::RequestTrace trace;
+
+    // 请求解析和raft命令构造使用的arena，生命周期和消息一致
+    // 第一次使用时创建，首块大小按body长度估算，一般一个块就够用
+    google::protobuf::Arena *GetArena();
+
+    template <class T>
+    T *NewMessage() {
+        return google::protobuf::Arena::CreateMessage<T>(GetArena());
+    }
+
     ProtoMessage(){};
     explicit ProtoMessage(int64_t expire): expire_time(getticks()+expire) {};
-    virtual ~ProtoMessage(){};
+    virtual ~ProtoMessage() {
+        if (arena_ != nullptr) arena_->~Arena();
+    };
     ProtoMessage(const struct ProtoMessage &other) {
         this->session_id = other.session_id;
         this->begin_time = other.begin_time;
@@ -34,8 +51,15 @@ struct ProtoMessage {
         this->header = other.header;
         this->socket = other.socket;
         this->body.assign(other.body.begin(), other.body.end());
+        this->trace = other.trace;
     }
+    ProtoMessage& operator=(const ProtoMessage&) = delete;
 
+private:
+    // arena对象直接放在消息里，省掉一次内存分配
+    typename std::aligned_storage<sizeof(google::protobuf::Arena),
+                                  alignof(google::protobuf::Arena)>::type arena_storage_;
+    google::protobuf::Arena *arena_ = nullptr;
 };
 
 // 从报文数据中解析生成ProtoMessage
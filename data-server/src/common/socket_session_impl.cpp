@@ -1,6 +1,7 @@
 #include "socket_session_impl.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "frame/sf_logger.h"
 
@@ -10,9 +11,7 @@ namespace sharkstore {
 namespace dataserver {
 namespace common {
 
-void SocketSessionImpl::Send(ProtoMessage *msg, google::protobuf::Message *resp) {
-    // // 分配回应内存
-    size_t body_len = resp == nullptr ? 0 : resp->ByteSizeLong();
+static response_buff_t *newResponse(ProtoMessage *msg, size_t body_len) {
     size_t data_len = header_size + body_len;
 
     response_buff_t *response = new_response_buff(data_len);
@@ -33,13 +32,23 @@ void SocketSessionImpl::Send(ProtoMessage *msg, google::protobuf::Message *resp)
     response->msg_id      = header.msg_id;
     response->begin_time  = msg->begin_time;
     response->expire_time = msg->expire_time;
+    response->reply_time  = get_micro_second();
     response->buff_len    = static_cast<int32_t>(data_len);
 
+    return response;
+}
+
+void SocketSessionImpl::Send(ProtoMessage *msg, google::protobuf::Message *resp) {
+    // // 分配回应内存
+    size_t body_len = resp == nullptr ? 0 : resp->ByteSizeLong();
+    response_buff_t *response = newResponse(msg, body_len);
+    auto reply_time = response->reply_time;
+
     do {
         if (resp != nullptr) {
             char *data = response->buff + header_size;
             if (!resp->SerializeToArray(data, body_len)) {
-                FLOG_ERROR("serialize response failed, func_id: %d", header.func_id);
+                FLOG_ERROR("serialize response failed, func_id: %d", msg->header.func_id);
                 delete_response_buff(response);
                 break;
             }
@@ -50,10 +59,30 @@ void SocketSessionImpl::Send(ProtoMessage *msg, google::protobuf::Message *resp)
 
     } while (false);
 
+    msg->trace.Set(monitor::TraceStage::kReply, reply_time);
+    monitor::g_tracer.Finish(msg->trace);
+
     delete msg;
     delete resp;
 }
 
+void SocketSessionImpl::Send(ProtoMessage *msg, const std::string &head, const std::string &body) {
+    // 网络层发送时会和task交换缓冲区，共用的部分只能拷贝，但不用再序列化
+    response_buff_t *response = newResponse(msg, head.size() + body.size());
+    auto reply_time = response->reply_time;
+
+    char *data = response->buff + header_size;
+    memcpy(data, head.data(), head.size());
+    memcpy(data + head.size(), body.data(), body.size());
+
+    msg->socket->Send(response);
+
+    msg->trace.Set(monitor::TraceStage::kReply, reply_time);
+    monitor::g_tracer.Finish(msg->trace);
+
+    delete msg;
+}
+
 }  // namespace common
 }  // namespace dataserver
 }  // namespace sharkstore
@@ -1,6 +1,8 @@
 #ifndef __SOCKET_SESSION_IMPL_H__
 #define __SOCKET_SESSION_IMPL_H__
 
+#include <string>
+
 #include "socket_session.h"
 
 namespace sharkstore {
@@ -17,6 +19,8 @@ public:
     SocketSessionImpl& operator=(const SocketSessionImpl&) = delete;
 
     void Send(ProtoMessage *msg, google::protobuf::Message* resp) override;
+    // 应答体是已经编码好的两段拼接，一段是每个请求自己的，一段是共用的
+    void Send(ProtoMessage *msg, const std::string& head, const std::string& body);
 };
 
 } //namespace common
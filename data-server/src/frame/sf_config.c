@@ -278,6 +278,22 @@ int sf_load_config_buffer(const char* content,const char* server_name) {
     return 0;
 }
 
+sf_io_backend_t sf_parse_io_backend(const char *name) {
+    if (name == NULL || strcmp(name, "epoll") == 0) {
+        return SF_IO_EPOLL;
+    }
+    if (strcmp(name, "io_uring") == 0) {
+        return SF_IO_URING;
+    }
+
+    FLOG_WARN("unknown io backend: %s, use epoll", name);
+    return SF_IO_EPOLL;
+}
+
+const char *sf_io_backend_name(sf_io_backend_t backend) {
+    return backend == SF_IO_URING ? "io_uring" : "epoll";
+}
+
 int sf_load_socket_thread_config(IniContext *ini_context, const char *section_name,
                                  sf_socket_thread_config_t *config) {
     char *temp_char;
@@ -319,6 +335,9 @@ int sf_load_socket_thread_config(IniContext *ini_context, const char *section_na
         config->event_send_threads = 0;
     }
 
+    config->io_backend = sf_parse_io_backend(
+            iniGetStrValue(section_name, "io_backend", ini_context));
+
     config->port = iniGetIntValue(section_name, "port", ini_context, 0);
     if (config->port <= 0) {
         FLOG_ERROR("section name: %s"
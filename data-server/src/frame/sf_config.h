@@ -17,6 +17,11 @@ typedef struct sf_log_config_s {
     char log_level[8];
 } sf_log_config_t;
 
+typedef enum sf_io_backend_e {
+    SF_IO_EPOLL = 0,  // epoll readiness loop
+    SF_IO_URING,      // io_uring completion loop, need ENABLE_IO_URING and linux >= 6.1
+} sf_io_backend_t;
+
 typedef struct sf_socket_thread_config_s {
     char ip_addr[IP_ADDRESS_SIZE];  // host ip addr
     int port;                       // host port
@@ -26,6 +31,7 @@ typedef struct sf_socket_thread_config_s {
     int event_send_threads;  // event loop thread for send
     int worker_threads;      // worker thread count
     int recv_buff_size;      // recv socket buff size
+    sf_io_backend_t io_backend;  // epoll or io_uring
 
     pthread_t *accept_tids;  // accept thread ids
     pthread_t *recv_tids;    // recv thread ids
@@ -76,6 +82,10 @@ int sf_load_socket_thread_config(IniContext *ini_context, const char *section_na
 
 void sf_set_load_config_callback(sf_load_config_callback_t load_config_func);
 
+//"epoll" or "io_uring", default epoll
+sf_io_backend_t sf_parse_io_backend(const char *name);
+const char *sf_io_backend_name(sf_io_backend_t backend);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,9 +7,11 @@
 #include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <fastcommon/pthread_func.h>
 #include <fastcommon/sched_thread.h>
@@ -20,6 +22,7 @@
 #include "sf_logger.h"
 #include "sf_socket_thread.h"
 #include "sf_socket_session.h"
+#include "sf_uring.h"
 
 static int sf_proto_header_size = 0;
 
@@ -30,7 +33,7 @@ static void sf_event_close(int sock, short event, void *arg);
 static void sf_event_recv(int sock, short event, void *arg);
 static void sf_event_send(int sock, short event, void *arg);
 
-static void sf_socket_notify(int sock, short event, void *arg, int type);
+static void sf_socket_notify(struct nio_thread_data *thread_data, int type);
 
 void sf_set_header_size(int size) { sf_proto_header_size = size; }
 
@@ -38,16 +41,33 @@ void sf_set_body_length_callback(sf_body_length_callback_t body_length_func) {
     sf_body_length_callback = body_length_func;
 }
 
+static bool sf_use_uring(struct fast_task_info *task) {
+    sf_notify_queue_t *queue = task->thread_data->arg;
+    return queue->uring != NULL;
+}
+
 static int sf_set_add_event(struct fast_task_info *task) {
-    long task_ptr = (long)task;
-    size_t len = sizeof(task_ptr);
+    struct nio_thread_data *thread_data = task->thread_data;
+    sf_notify_queue_t *queue = thread_data->arg;
+    sf_task_arg_t *task_arg = task->arg;
+    struct fast_task_info *head;
 
-    if (write(task->thread_data->pipe_fds[1], &task_ptr, len) != len) {
-        FLOG_ERROR("call write to pipe fd: %d fail, "
-                   "errno: %d, error info: %s",
-                   task->thread_data->pipe_fds[1], errno, strerror(errno));
+    do {
+        head = queue->head;
+        task_arg->notify_next = head;
+    } while (!__sync_bool_compare_and_swap(&queue->head, head, task));
 
-        return -1;
+    //队列原来非空，io线程已被唤醒或尚未取走，不需要再写eventfd
+    if (head != NULL) {
+        return 0;
+    }
+
+    uint64_t one = 1;
+    if (write(thread_data->pipe_fds[1], &one, sizeof(one)) != sizeof(one)) {
+        //任务已经入队，不能让调用方再关闭它
+        FLOG_ERROR("call write to eventfd: %d fail, "
+                   "errno: %d, error info: %s",
+                   thread_data->pipe_fds[1], errno, strerror(errno));
     }
 
     return 0;
@@ -102,8 +122,15 @@ int sf_set_connect_event(struct fast_task_info *task) {
     sf_task_arg_t *task_arg = task->arg;
     sf_session_entry_t *session = task_arg->session;
 
-    if (ioevent_set(task, task->thread_data, task->event.fd, IOEVENT_WRITE,
-            sf_event_connect, timeout) != 0) {
+    int ret;
+    if (sf_use_uring(task)) {
+        ret = sf_uring_set_connect(task, sf_event_connect, timeout);
+    } else {
+        ret = ioevent_set(task, task->thread_data, task->event.fd, IOEVENT_WRITE,
+                sf_event_connect, timeout);
+    }
+
+    if (ret != 0) {
         FLOG_ERROR("client ip: %s, fd: %d session: %" PRId64
                 " set connect event fail",
                 task->client_ip, task->event.fd, session->session_id);
@@ -123,6 +150,10 @@ int sf_set_close_event(struct fast_task_info *task) {
 int sf_set_recv_event(struct fast_task_info *task) {
     int timeout = sf_config.socket_config.socket_keep_time;
 
+    if (sf_use_uring(task)) {
+        return sf_uring_set_recv(task, sf_event_recv, timeout);
+    }
+
     return ioevent_set(task, task->thread_data, task->event.fd, IOEVENT_READ,
                 sf_event_recv, timeout);
 }
@@ -133,8 +164,15 @@ int sf_set_send_event(struct fast_task_info *task) {
     sf_task_arg_t *task_arg = task->arg;
     sf_session_entry_t *session = task_arg->session;
 
-    if (ioevent_set(task, task->thread_data, task->event.fd,
-                IOEVENT_WRITE, sf_event_send, timeout) != 0) {
+    int ret;
+    if (sf_use_uring(task)) {
+        ret = sf_uring_set_send(task, sf_event_send, timeout);
+    } else {
+        ret = ioevent_set(task, task->thread_data, task->event.fd,
+                IOEVENT_WRITE, sf_event_send, timeout);
+    }
+
+    if (ret != 0) {
 
         __sync_bool_compare_and_swap(&session->is_attach, true, false);
         return -1;
@@ -209,6 +247,103 @@ static void sf_event_close(int sock, short event, void *arg) {
     context->socket_close_callback(task, EIO);
 }
 
+//收完协议头后设置task->length，失败时已关闭连接
+static int sf_recv_header_done(struct fast_task_info *task) {
+    int sock = task->event.fd;
+    sf_task_arg_t *task_arg = task->arg;
+    sf_socket_thread_t *context = task_arg->context;
+    sf_socket_status_t *status = context->socket_status;
+
+    //set task->length value
+    if (sf_body_length_callback(task) != 0) {
+        FLOG_ERROR("client ip: %s, fd: %d set task length error",
+                task->client_ip, sock);
+
+        __sync_fetch_and_add(&status->recv_error_count, 1);
+        context->socket_close_callback(task, 0);
+        return -1;
+    }
+
+    if (task->length < 0) {
+        FLOG_ERROR("client ip: %s, fd: %d pkg length: %d < 0",
+                task->client_ip, sock, task->length);
+
+        __sync_fetch_and_add(&status->recv_error_count, 1);
+        context->socket_close_callback(task, 0);
+        return -1;
+    }
+
+    task->length += sf_proto_header_size;
+    if (task->length > sf_config.socket_config.max_pkg_size) {
+        FLOG_ERROR("client ip: %s, fd: %d, pkg length: %d > "
+                   "max pkg size: %d",
+                   task->client_ip, sock, task->length,
+                   sf_config.socket_config.max_pkg_size);
+
+        __sync_fetch_and_add(&status->big_len_pkg_count, 1);
+        context->socket_close_callback(task, 0);
+        return -1;
+    }
+
+    if (task->length > task->size) {
+        int old_size;
+        old_size = task->size;
+
+        FLOG_WARN("client ip: %s, fd: %d task length: %d realloc buffer size "
+                   "from %d to %d",
+                   task->client_ip, sock, task->length, old_size, task->length);
+
+        if (free_queue_realloc_buffer(task, task->length) != 0) {
+            FLOG_ERROR("client ip: %s, fd: %d realloc buffer size "
+                       "from %d to %d fail",
+                       task->client_ip, sock, task->size, task->length);
+
+           context->socket_close_callback(task, ENOMEM);
+           return -1;
+        }
+    }
+
+    return 0;
+}
+
+int sf_socket_recv_buff(struct fast_task_info *task, const char *buff, int len) {
+    int need;
+    int bytes;
+    sf_task_arg_t *task_arg = task->arg;
+    sf_socket_thread_t *context = task_arg->context;
+
+    while (len > 0) {
+        if (task->length == 0) {  // recv header
+            need = sf_proto_header_size - task->offset;
+        } else {
+            need = task->length - task->offset;
+        }
+
+        bytes = len < need ? len : need;
+        memcpy(task->data + task->offset, buff, bytes);
+        task->offset += bytes;
+        buff += bytes;
+        len -= bytes;
+
+        if (bytes < need) {
+            break;
+        }
+
+        if (task->length == 0) {  // proto header
+            if (sf_recv_header_done(task) != 0) {
+                return -1;
+            }
+        }
+
+        if (task->offset >= task->length) {  // recv done
+            sf_set_socket_keep(task);
+            context->recv_done_callback(task);
+        }
+    }
+
+    return 0;
+}
+
 static void sf_event_recv(int sock, short event, void *arg) {
     int bytes;
     int recv_bytes;
@@ -296,67 +431,76 @@ static void sf_event_recv(int sock, short event, void *arg) {
         }
 
         if (task->length == 0) {  // proto header
-            //set task->length value
-            if (sf_body_length_callback(task) != 0) {
-                FLOG_ERROR("client ip: %s, fd: %d set task length error",
-                        task->client_ip, sock);
-
-                __sync_fetch_and_add(&status->recv_error_count, 1);
-                context->socket_close_callback(task, 0);
+            if (sf_recv_header_done(task) != 0) {
                 return;
             }
+        }
 
-            if (task->length < 0) {
-                FLOG_ERROR("client ip: %s, fd: %d pkg length: %d < 0",
-                        task->client_ip, sock, task->length);
+        if (task->offset >= task->length) {  // recv done
+            sf_set_socket_keep(task);
+            context->recv_done_callback(task);
+            break;
+        }
+    }
+}
 
-                __sync_fetch_and_add(&status->recv_error_count, 1);
-                context->socket_close_callback(task, 0);
-                return;
-            }
+int sf_socket_send_iov(struct fast_task_info *task, struct iovec *iov, int *send_bytes) {
+    int count;
+    response_buff_t *buff;
+    sf_task_arg_t *task_arg = task->arg;
+    sf_session_entry_t *session = task_arg->session;
 
-            task->length += sf_proto_header_size;
-            if (task->length > sf_config.socket_config.max_pkg_size) {
-                FLOG_ERROR("client ip: %s, fd: %d, pkg length: %d > "
-                           "max pkg size: %d",
-                           task->client_ip, sock, task->length,
-                           sf_config.socket_config.max_pkg_size);
+    iov[0].iov_base = task->data + task->offset;
+    iov[0].iov_len = task->length - task->offset;
+    *send_bytes = iov[0].iov_len;
 
-                __sync_fetch_and_add(&status->big_len_pkg_count, 1);
-                context->socket_close_callback(task, 0);
-                return;
-            }
+    count = sf_send_batch_fill(session);
+    for (int i = 0; i < count; i++) {
+        buff = session->send_batch[i];
+        iov[i + 1].iov_base = buff->buff;
+        iov[i + 1].iov_len = buff->buff_len;
+        *send_bytes += buff->buff_len;
+    }
 
-            if (task->length > task->size) {
-                int old_size;
-                old_size = task->size;
+    return count + 1;
+}
 
-                FLOG_WARN("client ip: %s, fd: %d task length: %d realloc buffer size "
-                           "from %d to %d",
-                           task->client_ip, sock, task->length, old_size, task->length);
+int sf_socket_send_advance(struct fast_task_info *task, int bytes) {
+    bool has_more;
+    sf_task_arg_t *task_arg = task->arg;
+    sf_socket_thread_t *context = task_arg->context;
+    sf_session_entry_t *session = task_arg->session;
 
-                if (free_queue_realloc_buffer(task, task->length) != 0) {
-                    FLOG_ERROR("client ip: %s, fd: %d realloc buffer size "
-                               "from %d to %d fail",
-                               task->client_ip, sock, task->size, task->length);
+    // send end and recycle task
+    // send_done会把批量中的下一个应答换入task，继续扣除已写出的字节
+    while (bytes >= task->length - task->offset) {
+        bytes -= task->length - task->offset;
 
-                   context->socket_close_callback(task, ENOMEM);
-                   return;
-                }
-            }
+        FLOG_DEBUG("client ip: %s, fd: %d, session: %" PRId64
+                  " send end. totle_bytes: %d ",
+                   task->client_ip, task->event.fd, session->session_id, task->length);
+
+        has_more = session->send_batch_count > 0;
+        task->length = 0;
+        task->offset = 0;
+        if (context->send_done_callback(task) != 0) {
+            return -1;
         }
-
-        if (task->offset >= task->length) {  // recv done
-            sf_set_socket_keep(task);
-            context->recv_done_callback(task);
-            break;
+        if (!has_more) {
+            return 0;
         }
     }
+
+    //部分写入，等待下次可写
+    task->offset += bytes;
+    return 1;
 }
 
 static void sf_event_send(int sock, short event, void *arg) {
     int bytes;
     int send_bytes;
+    int iovcnt;
+    struct iovec iov[SF_SEND_BATCH_SIZE + 1];
     struct fast_task_info *task;
 
     assert(sock >= 0);
@@ -393,13 +537,15 @@ static void sf_event_send(int sock, short event, void *arg) {
     }
 
     while (true) {
-        send_bytes = task->length - task->offset;
+        //当前应答之后带上队列中已有的应答，一次writev发送
+        iovcnt = sf_socket_send_iov(task, iov, &send_bytes);
 
         FLOG_DEBUG("client ip: %s, fd: %d, session: %" PRId64
-                " ready to totle_bytes: %d send_bytes: %d",
-                task->client_ip, sock, session->session_id, task->length, send_bytes);
+                " ready to totle_bytes: %d send_bytes: %d, iovcnt: %d",
+                task->client_ip, sock, session->session_id, task->length,
+                send_bytes, iovcnt);
 
-        bytes = write(sock, task->data + task->offset, send_bytes);
+        bytes = writev(sock, iov, iovcnt);
         if (bytes < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 FLOG_DEBUG("client ip: %s, fd: %d,  session: %" PRId64
@@ -423,26 +569,15 @@ static void sf_event_send(int sock, short event, void *arg) {
             }
         }
 
-        task->offset += bytes;
-
         if (bytes < send_bytes) {
             FLOG_INFO("client ip: %s, fd: %d, session:%" PRId64
                     " body: %d, need send: %d, send: %d",
                     task->client_ip, sock, session->session_id,
                     task->length, send_bytes, bytes);
-            break;
         }
 
-        // send end and recycle task
-        if (task->offset >= task->length) {
-            FLOG_DEBUG("client ip: %s, fd: %d, session: %" PRId64
-                      " send end. totle_bytes: %d ",
-                       task->client_ip, sock, session->session_id, task->length);
-            task->length = 0;
-            task->offset = 0;
-            context->send_done_callback(task);
-            break;
-        }
+        sf_socket_send_advance(task, bytes);
+        break;
     }
 }
 
@@ -526,6 +661,58 @@ int sf_socket_send_task(struct fast_task_info *task) {
     return 0;
 }
 
+void sf_socket_recv_result(struct fast_task_info *task, const char *buff, int res) {
+    sf_task_arg_t *task_arg = task->arg;
+    sf_socket_thread_t *context = task_arg->context;
+    sf_socket_status_t *status = context->socket_status;
+
+    //发送端已关闭，等同于epoll下的sf_event_close
+    if (task->event.callback == sf_event_close) {
+        sf_event_close(task->event.fd, IOEVENT_READ, task);
+        return;
+    }
+
+    if (res < 0) {
+        FLOG_WARN("client ip: %s, fd: %d recv failed, "
+                  "errno: %d, error info: %s",
+                  task->client_ip, task->event.fd, -res, strerror(-res));
+
+        __sync_fetch_and_add(&status->recv_error_count, 1);
+        context->socket_close_callback(task, -res);
+        return;
+    } else if (res == 0) {
+        FLOG_WARN("client ip: %s, sock: %d, recv failed, "
+                   "connection disconnected",
+                   task->client_ip, task->event.fd);
+
+        __sync_fetch_and_add(&status->recv_error_count, 1);
+        context->socket_close_callback(task, 0);
+        return;
+    }
+
+    sf_socket_recv_buff(task, buff, res);
+}
+
+void sf_socket_send_result(struct fast_task_info *task, int res) {
+    sf_task_arg_t *task_arg = task->arg;
+    sf_socket_thread_t *context = task_arg->context;
+    sf_session_entry_t *session = task_arg->session;
+    sf_socket_status_t *status = context->socket_status;
+
+    if (res < 0) {
+        FLOG_WARN("client ip: %s, fd: %d, session: %" PRId64
+                " send fail, errno: %d, error info: %s",
+                  task->client_ip, task->event.fd, session->session_id,
+                  -res, strerror(-res));
+
+        __sync_fetch_and_add(&status->send_error_count, 1);
+        context->socket_close_callback(task, EIO);
+        return;
+    }
+
+    sf_socket_send_advance(task, res);
+}
+
 int sf_socket_server(const char *bind_addr, int port, int *sock) {
     int result;
     *sock = socketServer(bind_addr, port, &result);
@@ -596,10 +783,14 @@ int sf_clear_recv_event(struct fast_task_info *task) {
         task->finish_callback = NULL;
     }
 
-    ret = ioevent_detach(&task->thread_data->ev_puller, task->event.fd);
-    if (ret != 0) {
-        FLOG_WARN("ioevent_detach: socket: %d, errno: %d  err:%s",
-                task->event.fd, ret, strerror(ret));
+    if (sf_use_uring(task)) {
+        sf_uring_clear(task);
+    } else {
+        ret = ioevent_detach(&task->thread_data->ev_puller, task->event.fd);
+        if (ret != 0) {
+            FLOG_WARN("ioevent_detach: socket: %d, errno: %d  err:%s",
+                    task->event.fd, ret, strerror(ret));
+        }
     }
 
     if (task->event.timer.expires > 0) {
@@ -612,10 +803,12 @@ int sf_clear_recv_event(struct fast_task_info *task) {
         task->event.timer.expires = 0;
     }
 
-    ret = ioevent_remove(&task->thread_data->ev_puller, task);
-    if (ret) {
-        FLOG_WARN("ioevent_remove: socket: %d, ret: %d  err:%s",
-                task->event.fd, ret, strerror(ret));
+    if (!sf_use_uring(task)) {
+        ret = ioevent_remove(&task->thread_data->ev_puller, task);
+        if (ret) {
+            FLOG_WARN("ioevent_remove: socket: %d, ret: %d  err:%s",
+                    task->event.fd, ret, strerror(ret));
+        }
     }
 
     return ret;
@@ -632,13 +825,17 @@ int sf_clear_send_event(struct fast_task_info *task) {
     sf_session_entry_t *session = task_arg->session;
 
     if (__sync_bool_compare_and_swap(&session->is_attach, true, false)) {
-        ret = ioevent_detach(&task->thread_data->ev_puller, task->event.fd);
-
-        if (ret != 0 && errno != ENOENT) {
-            FLOG_ERROR("ioevent_detach: socket: %d, errno: %d  err:%s",
-                    task->event.fd, errno, strerror(errno));
+        if (sf_use_uring(task)) {
+            sf_uring_clear(task);
         } else {
-            ret = 0;
+            ret = ioevent_detach(&task->thread_data->ev_puller, task->event.fd);
+
+            if (ret != 0 && errno != ENOENT) {
+                FLOG_ERROR("ioevent_detach: socket: %d, errno: %d  err:%s",
+                        task->event.fd, errno, strerror(errno));
+            } else {
+                ret = 0;
+            }
         }
 
         if (task->event.timer.expires > 0) {
@@ -651,44 +848,113 @@ int sf_clear_send_event(struct fast_task_info *task) {
             task->event.timer.expires = 0;
         }
 
-        ret = ioevent_remove(&task->thread_data->ev_puller, task);
-        if (ret) {
-            FLOG_WARN("ioevent_remove: socket: %d, ret: %d  err:%s",
-                    task->event.fd, ret, strerror(ret));
+        if (!sf_use_uring(task)) {
+            ret = ioevent_remove(&task->thread_data->ev_puller, task);
+            if (ret) {
+                FLOG_WARN("ioevent_remove: socket: %d, ret: %d  err:%s",
+                        task->event.fd, ret, strerror(ret));
+            }
         }
     }
 
     return ret;
 }
 
+int sf_notify_init(struct nio_thread_data *thread_data) {
+    int result;
+    int fd;
+
+    thread_data->arg = calloc(1, sizeof(sf_notify_queue_t));
+    if (thread_data->arg == NULL) {
+        return ENOMEM;
+    }
+
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        result = errno != 0 ? errno : EPERM;
+        FLOG_ERROR("call eventfd fail, "
+                   "errno: %d, error info: %s",
+                   result, strerror(result));
+        return result;
+    }
+
+    //ioevent_loop监听pipe_fds[0]，写端也用同一个eventfd
+    thread_data->pipe_fds[0] = fd;
+    thread_data->pipe_fds[1] = fd;
+
+    return 0;
+}
+
+void sf_notify_destroy(struct nio_thread_data *thread_data) {
+    if (thread_data->pipe_fds[0] > 0) {
+        close(thread_data->pipe_fds[0]);
+        thread_data->pipe_fds[0] = -1;
+        thread_data->pipe_fds[1] = -1;
+    }
+
+    free(thread_data->arg);
+    thread_data->arg = NULL;
+}
+
+static void sf_notify_clear(int sock) {
+    uint64_t count;
+
+    if (read(sock, &count, sizeof(count)) < 0) {
+        if (!(errno == EAGAIN || errno == EWOULDBLOCK)) {
+            FLOG_ERROR("call read failed, errno: %d, error info: %s", errno,
+                       strerror(errno));
+        }
+    }
+}
+
+//只清除eventfd计数，任务在sf_notify_*_loop中取出
+//ioevent_loop先处理io事件再调用thread_loop_callback，清除在取出之前，不会丢失唤醒
 void sf_notify_recv(int sock, short event, void *arg) {
-    sf_socket_notify(sock, event, arg, IOEVENT_READ);
+    sf_notify_clear(sock);
 }
 
 void sf_notify_send(int sock, short event, void *arg) {
-    sf_socket_notify(sock, event, arg, IOEVENT_WRITE);
+    sf_notify_clear(sock);
 }
 
-void sf_socket_notify(int sock, short event, void *arg, int type) {
-    int bytes;
-    long task_ptr;
+int sf_notify_recv_loop(struct nio_thread_data *thread_data) {
+    sf_socket_notify(thread_data, IOEVENT_READ);
+    return 0;
+}
+
+int sf_notify_send_loop(struct nio_thread_data *thread_data) {
+    sf_socket_notify(thread_data, IOEVENT_WRITE);
+    return 0;
+}
+
+void sf_socket_notify(struct nio_thread_data *thread_data, int type) {
+    sf_notify_queue_t *queue = thread_data->arg;
     struct fast_task_info *task;
+    struct fast_task_info *next;
+    struct fast_task_info *reversed = NULL;
 
-    while (true) {
-        if ((bytes = read(sock, &task_ptr, sizeof(task_ptr))) < 0) {
-            if (!(errno == EAGAIN || errno == EWOULDBLOCK)) {
-                FLOG_ERROR("call read failed, errno: %d, error info: %s", errno,
-                           strerror(errno));
-            }
-            break;
-        } else if (bytes == 0) {
-            break;
-        }
+    if (queue->head == NULL) {
+        return;
+    }
+
+    //整体取出，入队是头插，反转后按入队顺序处理
+    task = __sync_lock_test_and_set(&queue->head, NULL);
+    while (task != NULL) {
+        sf_task_arg_t *task_arg = task->arg;
+        next = task_arg->notify_next;
+        task_arg->notify_next = reversed;
+        reversed = task;
+        task = next;
+    }
 
-        task = (struct fast_task_info *)task_ptr;
+    for (task = reversed; task != NULL; task = next) {
         sf_task_arg_t *task_arg = task->arg;
         sf_socket_thread_t *context = task_arg->context;
         sf_session_entry_t *session = task_arg->session;
+        int sock = task->event.fd;
+
+        next = task_arg->notify_next;
+        task_arg->notify_next = NULL;
 
         if (type == IOEVENT_READ) {
             if (sf_set_recv_event(task) != 0) {
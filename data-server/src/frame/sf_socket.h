@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <fastcommon/ioevent_loop.h>
 #include <fastcommon/fast_task_queue.h>
 
@@ -14,8 +15,18 @@ typedef struct {
     void *session;
     void *response;
     void *context;
+
+    struct fast_task_info *notify_next; //link in sf_notify_queue_t
+    void *io_op;                        //io_uring backend: op in flight
 } sf_task_arg_t;
 
+//io线程的待挂载任务队列，多个线程无锁入队，io线程每次唤醒后整体取出
+//队列由空变为非空时才写eventfd唤醒io线程
+typedef struct {
+    struct fast_task_info *volatile head;
+    void *uring;  //io_uring backend of the thread, NULL for epoll
+} sf_notify_queue_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,8 +51,20 @@ int sf_socket_server(const char *bind_addr, int port, int *sock);
 int sf_connect_to_server(const char *host_addr, const uint16_t port, int *sock);
 int sf_socket_send_task(struct fast_task_info *task);
 
+//以下供完成式后端(io_uring)使用
+int sf_socket_recv_buff(struct fast_task_info *task, const char *buff, int len);
+void sf_socket_recv_result(struct fast_task_info *task, const char *buff, int res);
+int sf_socket_send_iov(struct fast_task_info *task, struct iovec *iov, int *send_bytes);
+int sf_socket_send_advance(struct fast_task_info *task, int bytes);
+void sf_socket_send_result(struct fast_task_info *task, int res);
+
+int sf_notify_init(struct nio_thread_data *thread_data);
+void sf_notify_destroy(struct nio_thread_data *thread_data);
+
 void sf_notify_recv(int sock, short event, void *arg);
 void sf_notify_send(int sock, short event, void *arg);
+int sf_notify_recv_loop(struct nio_thread_data *thread_data);
+int sf_notify_send_loop(struct nio_thread_data *thread_data);
 
 void sf_set_body_length_callback(sf_body_length_callback_t body_length_func);
 void sf_set_header_size(int size);
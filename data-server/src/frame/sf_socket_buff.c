@@ -27,6 +27,7 @@ response_buff_t *new_response_buff(int buff_size) {
     response->buff_len = 0;
     response->begin_time = 0;
     response->expire_time = 0;
+    response->reply_time = 0;
 
     return response;
 }
@@ -11,6 +11,7 @@ typedef struct sf_message_s {
     int64_t msg_id;
     int64_t begin_time;
     int64_t expire_time;
+    int64_t reply_time;  // 应答交给网络层的时间(us)
     int32_t buff_len;
     char    *buff;
 } sf_message_t;
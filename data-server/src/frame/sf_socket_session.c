@@ -7,6 +7,7 @@
 #include "sf_socket.h"
 #include "sf_util.h"
 #include "sf_socket_thread.h"
+#include "sf_uring.h"
 
 static void sf_free_session_entry(sf_session_entry_t *entry);
 
@@ -49,6 +50,7 @@ sf_session_entry_t *sf_create_socket_session(sf_socket_session_t *session,
         entry->is_sending = false;
         entry->is_attach  = false;
         entry->send_queue = new_lk_queue();
+        entry->send_batch_count = 0;
 
         entry->rtask      = NULL;
         entry->stask      = NULL;
@@ -118,7 +120,10 @@ static void sf_set_task_data(struct fast_task_info *task) {
         if (context->send_callback != NULL) {
             context->send_callback(response, context->user_data, 0);
         }
-        delete_response_buff(response);
+        //连接关闭时发送可能还在io_uring里
+        if (!sf_uring_hold_response(task, response)) {
+            delete_response_buff(response);
+        }
     }
 
     task_arg->response = NULL;
@@ -126,6 +131,36 @@ static void sf_set_task_data(struct fast_task_info *task) {
     pthread_mutex_unlock(&session->swap_mutex);
 }
 
+int sf_send_batch_fill(sf_session_entry_t *entry) {
+    response_buff_t *buff;
+
+    while (entry->send_batch_count < SF_SEND_BATCH_SIZE) {
+        buff = lk_queue_pop(entry->send_queue);
+        if (buff == NULL) {
+            break;
+        }
+        entry->send_batch[entry->send_batch_count++] = buff;
+    }
+
+    return entry->send_batch_count;
+}
+
+//先取已放入批量中的应答，保证发送顺序
+static response_buff_t *sf_send_queue_pop(sf_session_entry_t *entry) {
+    response_buff_t *buff;
+
+    if (entry->send_batch_count == 0) {
+        return lk_queue_pop(entry->send_queue);
+    }
+
+    buff = entry->send_batch[0];
+    entry->send_batch_count--;
+    memmove(entry->send_batch, entry->send_batch + 1,
+            entry->send_batch_count * sizeof(response_buff_t *));
+
+    return buff;
+}
+
 int sf_send_task_push(sf_socket_session_t *session, response_buff_t *buff) {
     int ret;
     char key[8];
@@ -237,11 +272,11 @@ int sf_send_task_finish(sf_socket_session_t *session, int64_t session_id) {
         //swap send buff
         sf_set_task_data(entry->stask);
 
-        buff = lk_queue_pop(entry->send_queue);
+        buff = sf_send_queue_pop(entry);
         if (buff == NULL) {
 
             pthread_rwlock_wrlock(&entry->session_lock);
-            buff = lk_queue_pop(entry->send_queue);
+            buff = sf_send_queue_pop(entry);
 
             if (buff == NULL) {
                 if ((ret = sf_clear_send_event(entry->stask)) != 0) {
@@ -320,6 +355,12 @@ void sf_socket_session_close(sf_socket_session_t *session,
         if (entry->stask == task) {
             sf_set_task_data(task);
 
+            //批量里的应答可能还被在途的发送引用，交给io_uring释放
+            while (entry->send_batch_count > 0 &&
+                    sf_uring_hold_response(task, entry->send_batch[0])) {
+                sf_send_queue_pop(entry);
+            }
+
             sf_clear_send_event(task);
             free_queue_push(task); //recycle task
             entry->stask = NULL;
@@ -368,11 +409,11 @@ bool sf_socket_session_closed(sf_socket_session_t *session, int64_t session_id)
 }
 
 void sf_free_session_entry(sf_session_entry_t *entry) {
-    response_buff_t *buff = lk_queue_pop(entry->send_queue);
+    response_buff_t *buff = sf_send_queue_pop(entry);
     while (buff != NULL) {
         //callback?
         delete_response_buff(buff);
-        buff = lk_queue_pop(entry->send_queue);
+        buff = sf_send_queue_pop(entry);
     }
 
     delete_lk_queue(entry->send_queue);
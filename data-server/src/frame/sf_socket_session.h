@@ -14,6 +14,9 @@
 
 #include "lk_queue/lk_queue.h"
 
+//一次writev最多带上的排队应答数
+#define SF_SEND_BATCH_SIZE 16
+
 typedef enum socket_state_s {
     SS_INIT,
     SS_OK,
@@ -32,6 +35,10 @@ typedef struct sf_session_entry_s {
 
     lock_free_queue_t *send_queue;
     pthread_mutex_t   swap_mutex; // for response->buff swap task->data
+
+    //send thread only, responses taken from send_queue for writev
+    response_buff_t *send_batch[SF_SEND_BATCH_SIZE];
+    int send_batch_count;
 } sf_session_entry_t;
 
 typedef struct sf_socket_session_s {
@@ -53,6 +60,7 @@ void sf_session_free(sf_socket_session_t *session, int64_t session_id);
 
 int sf_send_task_push(sf_socket_session_t *session, response_buff_t *send_data);
 int sf_send_task_finish(sf_socket_session_t *session, int64_t session_id);
+int sf_send_batch_fill(sf_session_entry_t *entry);
 
 void sf_socket_session_close(sf_socket_session_t *session, struct fast_task_info *task);
 bool sf_socket_session_closed(sf_socket_session_t *session, int64_t session_id);
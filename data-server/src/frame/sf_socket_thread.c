@@ -13,6 +13,7 @@
 #include "sf_util.h"
 #include "sf_logger.h"
 #include "sf_socket.h"
+#include "sf_uring.h"
 
 static int sf_accept_init(sf_socket_thread_t *context);
 static int sf_recv_init(sf_socket_thread_t *context);
@@ -43,6 +44,12 @@ int sf_socket_thread_init(sf_socket_thread_t *context) {
 
     sf_socket_thread_config_t *config = context->socket_config;
 
+    if (config->io_backend == SF_IO_URING && !sf_uring_supported()) {
+        FLOG_WARN("%s io_uring backend not supported, fallback to epoll",
+                config->thread_name_prefix);
+        config->io_backend = SF_IO_EPOLL;
+    }
+
     if ((result = sf_socket_session_init(&context->socket_session)) != 0) {
         return result;
     }
@@ -189,6 +196,8 @@ static struct fast_task_info *sf_init_task(sf_socket_thread_t *context,
     task_arg->session       = session;
     task_arg->context       = context;
     task_arg->response      = NULL;
+    task_arg->notify_next   = NULL;
+    task_arg->io_op         = NULL;
 
     return task;
 }
@@ -217,6 +226,8 @@ static struct fast_task_info *sf_clone_task(sf_socket_thread_t *context,
     task_arg->session       = rs_arg->session;
     task_arg->context       = context;
     task_arg->response      = NULL;
+    task_arg->notify_next   = NULL;
+    task_arg->io_op         = NULL;
 
     return task;
 }
@@ -253,12 +264,14 @@ static int sf_send_task_done(struct fast_task_info *task) {
 
     sf_socket_status_t *status = context->socket_status;
 
+    // send queue size sub one
+    __sync_fetch_and_sub(&status->current_send_queue_size, 1);
+
     if (sf_send_task_finish(&context->socket_session, session->session_id) != 0) {
         context->socket_close_callback(task, EIO);
+        return -1;
     }
 
-    // send queue size sub one
-    __sync_fetch_and_sub(&status->current_send_queue_size, 1);
     return 0;
 }
 
@@ -280,7 +293,8 @@ static int sf_socket_close(struct fast_task_info *task, int err) {
     //return sf_task_finish_clean_up(task);
 }
 
-static int sf_socket_data_init(struct nio_thread_data *thread_data) {
+static int sf_socket_data_init(struct nio_thread_data *thread_data,
+        sf_socket_thread_config_t *thread_config, int type) {
     int result;
     sf_socket_config_t *config = &sf_config.socket_config;
 
@@ -302,107 +316,111 @@ static int sf_socket_data_init(struct nio_thread_data *thread_data) {
         return result;
     }
 
-    if (pipe(thread_data->pipe_fds) != 0) {
-        result = errno != 0 ? errno : EPERM;
-        FLOG_ERROR("call pipe fail, "
-                   "errno: %d, error info: %s",
-                   result, strerror(result));
+    if ((result = sf_notify_init(thread_data)) != 0) {
         return result;
     }
 
-    int fd_flags = O_NONBLOCK;
-#if defined(OS_LINUX)
-    fd_flags |= O_NOATIME;
-#endif
-    if ((result = fd_add_flags(thread_data->pipe_fds[0], fd_flags)) != 0) {
-        return result;
+    if (thread_config->io_backend == SF_IO_URING) {
+        return sf_uring_thread_init(thread_data, type);
     }
 
     return 0;
 }
 
-static void *accept_thread_entrance(void *arg) {
-    int income_sock;
+static void sf_accept_income(sf_socket_thread_t *context, int income_sock,
+        const struct sockaddr_in *inaddr) {
     uint16_t remote_port;
-    struct sockaddr_in inaddr;
-    socklen_t sockaddr_len;
-
     char remote_ip[IP_ADDRESS_SIZE];
 
-    sf_socket_thread_t *context = arg;
     sf_socket_thread_config_t *config = context->socket_config;
     sf_socket_status_t *status = context->socket_status;
 
-    while (g_continue_flag) {
-        sockaddr_len = sizeof(inaddr);
-        income_sock =
-            accept(context->socket_fd, (struct sockaddr *)&inaddr, &sockaddr_len);
+    getPeerIpaddr(income_sock, remote_ip, IP_ADDRESS_SIZE);
+    remote_port = ntohs(inaddr->sin_port);
 
-        if (income_sock < 0) {  // error
-            if (!(errno == EINTR || errno == EAGAIN)) {
-                FLOG_ERROR("accept failed, errno: %d, error info: %s", errno,
-                           strerror(errno));
-            }
-            continue;
-        }
+    //io_uring后端使用阻塞socket
+    if (config->io_backend != SF_IO_URING && tcpsetnonblockopt(income_sock) != 0) {
+        close(income_sock);
+        return;
+    }
 
-        getPeerIpaddr(income_sock, remote_ip, IP_ADDRESS_SIZE);
-        remote_port = ntohs(inaddr.sin_port);
+    int64_t session_id = __sync_add_and_fetch(&atomic_session_id, 1);
 
-        if (tcpsetnonblockopt(income_sock) != 0) {
-            close(income_sock);
-            continue;
-        }
 
-        int64_t session_id = __sync_add_and_fetch(&atomic_session_id, 1);
+    sf_session_entry_t *session =
+        sf_create_socket_session(&context->socket_session, session_id);
 
+    session->state      = SS_OK;
+    session->rtask = sf_init_task(context, income_sock, remote_ip,
+            remote_port, session);
 
-        sf_session_entry_t *session =
-            sf_create_socket_session(&context->socket_session, session_id);
+    if (session->rtask == NULL) {
+        close(income_sock);
+        sf_session_free(&context->socket_session, session_id);
+        return;
+    }
 
-        session->state      = SS_OK;
-        session->rtask = sf_init_task(context, income_sock, remote_ip,
-                remote_port, session);
+    //set recv thread data
+    session->rtask->thread_data = context->event_recv_data +
+        income_sock % config->event_recv_threads;
 
-        if (session->rtask == NULL) {
+    if (config->event_send_threads > 0) {
+        session->stask = sf_clone_task(context, session->rtask);
+        if (session->stask == NULL) {
             close(income_sock);
             sf_session_free(&context->socket_session, session_id);
-            continue;
+            free_queue_push(session->rtask);
+            return;
         }
 
-        //set recv thread data
-        session->rtask->thread_data = context->event_recv_data +
-            income_sock % config->event_recv_threads;
-
-        if (config->event_send_threads > 0) {
-            session->stask = sf_clone_task(context, session->rtask);
-            if (session->stask == NULL) {
-                close(income_sock);
-                sf_session_free(&context->socket_session, session_id);
-                free_queue_push(session->rtask);
-                continue;
-            }
+        //set send thread data
+        session->stask->thread_data = context->event_send_data +
+            income_sock % config->event_send_threads;
+    }
 
-            //set send thread data
-            session->stask->thread_data = context->event_send_data +
-                income_sock % config->event_send_threads;
-        }
+    __sync_fetch_and_sub(&status->current_connections, 1);
 
-        __sync_fetch_and_sub(&status->current_connections, 1);
+    //not used
+    //if (context->accept_done_callback != NULL) {
+    //    context->accept_done_callback(read_task);
+    //}
 
-        //not used
-        //if (context->accept_done_callback != NULL) {
-        //    context->accept_done_callback(read_task);
-        //}
+    if (session->rtask->size < config->recv_buff_size) {
+        free_queue_set_buffer_size(session->rtask, config->recv_buff_size);
+    }
 
-        if (session->rtask->size < config->recv_buff_size) {
-            free_queue_set_buffer_size(session->rtask, config->recv_buff_size);
-        }
+    sf_add_recv_notify(session->rtask);
+    FLOG_DEBUG("bind ip: %s, port: %d fd: %d session_id: %" PRId64,
+            remote_ip, remote_port, income_sock, session_id);
+}
 
-        sf_add_recv_notify(session->rtask);
-        FLOG_DEBUG("bind ip: %s, port: %d fd: %d session_id: %" PRId64,
-                remote_ip, remote_port, income_sock, session_id);
+static void *accept_thread_entrance(void *arg) {
+    int income_sock;
+    struct sockaddr_in inaddr;
+    socklen_t sockaddr_len;
+
+    sf_socket_thread_t *context = arg;
+    sf_socket_thread_config_t *config = context->socket_config;
+    sf_socket_status_t *status = context->socket_status;
 
+    if (config->io_backend == SF_IO_URING) {
+        sf_uring_accept_loop(context, sf_accept_income);
+    }
+
+    while (g_continue_flag) {
+        sockaddr_len = sizeof(inaddr);
+        income_sock =
+            accept(context->socket_fd, (struct sockaddr *)&inaddr, &sockaddr_len);
+
+        if (income_sock < 0) {  // error
+            if (!(errno == EINTR || errno == EAGAIN)) {
+                FLOG_ERROR("accept failed, errno: %d, error info: %s", errno,
+                           strerror(errno));
+            }
+            continue;
+        }
+
+        sf_accept_income(context, income_sock, &inaddr);
     }
 
     __sync_fetch_and_sub(&status->actual_accept_threads, 1);
@@ -419,8 +437,12 @@ static void *event_recv_thread_entrance(void *arg) {
 
     free(socket_event);
 
-    ioevent_loop(thread_data, sf_notify_recv,
-                 (void *)(context->socket_close_callback), &g_continue_flag);
+    if (context->socket_config->io_backend == SF_IO_URING) {
+        sf_uring_loop(thread_data, IOEVENT_READ);
+    } else {
+        ioevent_loop(thread_data, sf_notify_recv,
+                     (void *)(context->socket_close_callback), &g_continue_flag);
+    }
     ioevent_destroy(&thread_data->ev_puller);
 
     __sync_fetch_and_sub(&status->actual_event_recv_threads, 1);
@@ -436,8 +458,12 @@ static void *event_send_thread_entrance(void *arg) {
 
     free(socket_event);
 
-    ioevent_loop(thread_data, sf_notify_send,
-                 (void *)(context->socket_close_callback), &g_continue_flag);
+    if (context->socket_config->io_backend == SF_IO_URING) {
+        sf_uring_loop(thread_data, IOEVENT_WRITE);
+    } else {
+        ioevent_loop(thread_data, sf_notify_send,
+                     (void *)(context->socket_close_callback), &g_continue_flag);
+    }
     ioevent_destroy(&thread_data->ev_puller);
 
     __sync_fetch_and_sub(&status->actual_event_send_threads, 1);
@@ -500,9 +526,9 @@ static int sf_recv_init(sf_socket_thread_t *context) {
 
     end = context->event_recv_data + config->event_recv_threads;
     for (it=context->event_recv_data; it<end; it++, i++) {
-        // it->thread_loop_callback = thread_loop_func;
+        it->thread_loop_callback = sf_notify_recv_loop;
         it->arg = NULL;
-        if ((result = sf_socket_data_init(it)) != 0) {
+        if ((result = sf_socket_data_init(it, config, IOEVENT_READ)) != 0) {
             return result;
         }
 
@@ -553,9 +579,9 @@ static int sf_send_init(sf_socket_thread_t *context) {
 
     end = context->event_send_data + config->event_send_threads;
     for (it=context->event_send_data; it<end; it++, i++) {
-        // it->thread_loop_callback = thread_loop_func;
+        it->thread_loop_callback = sf_notify_send_loop;
         it->arg = NULL;
-        if ((result = sf_socket_data_init(it)) != 0) {
+        if ((result = sf_socket_data_init(it, config, IOEVENT_WRITE)) != 0) {
             return result;
         }
 
@@ -607,6 +633,8 @@ static void sf_recv_destroy(sf_socket_thread_t *context) {
     end = context->event_recv_data + config->event_recv_threads;
     for (it = context->event_recv_data; it < end; it++) {
         fast_timer_destroy(&it->timer);
+        sf_uring_thread_destroy(it);
+        sf_notify_destroy(it);
     }
 
     free(context->event_recv_data);
@@ -630,6 +658,8 @@ static void sf_send_destroy(sf_socket_thread_t *context) {
     end = context->event_send_data + config->event_send_threads;
     for (it = context->event_send_data; it < end; it++) {
         fast_timer_destroy(&it->timer);
+        sf_uring_thread_destroy(it);
+        sf_notify_destroy(it);
     }
 
     free(context->event_send_data);
@@ -0,0 +1,977 @@
+#include "sf_uring.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fastcommon/ioevent.h>
+#include <fastcommon/sched_thread.h>
+
+#include "sf_config.h"
+#include "sf_logger.h"
+#include "sf_socket.h"
+#include "sf_socket_session.h"
+#include "sf_socket_thread.h"
+
+#ifdef SF_USE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define SF_URING_ENTRIES        1024
+#define SF_URING_ACCEPT_ENTRIES 16
+
+//接收线程的provided buffer, 个数必须是2的幂
+#define SF_URING_BUF_COUNT      256
+#define SF_URING_BUF_SIZE       (16 * 1024)
+#define SF_URING_BUF_GROUP      0
+
+//待发送字节数超过该值时使用SENDMSG_ZC，避免大的select/scan应答拷贝到socket缓冲区
+#define SF_URING_ZC_THRESHOLD   (64 * 1024)
+
+typedef enum sf_uring_op_type_e {
+    SF_URING_OP_NOTIFY,
+    SF_URING_OP_TIMEOUT,
+    SF_URING_OP_ACCEPT,
+    SF_URING_OP_RECV,
+    SF_URING_OP_SEND,
+    SF_URING_OP_CONNECT,
+} sf_uring_op_type_t;
+
+typedef struct sf_uring_op_s {
+    sf_uring_op_type_t type;
+
+    //sf_uring_clear后置为NULL，最后一个cqe到达时释放op
+    struct fast_task_info *task;
+    bool inflight;
+
+    bool zc;
+    int zc_result;  //SENDMSG_ZC: 等到通知cqe后才能释放发送缓冲
+    bool poll_first;  //上次返回EAGAIN，重新提交时先等可读/可写
+
+    struct msghdr msg;
+    struct iovec iov[SF_SEND_BATCH_SIZE + 1];
+
+    //发送中被清除时接管iov引用的应答，最后一个cqe到达后释放
+    response_buff_t *held[SF_SEND_BATCH_SIZE + 1];
+    int held_count;
+} sf_uring_op_t;
+
+typedef struct sf_uring_s {
+    int ring_fd;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_local_tail;  //已填充未提交的sqe在sq_tail之后
+    struct io_uring_sqe *sqes;
+
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *ring_ptr;
+    size_t ring_size;
+    size_t sqes_size;
+
+    struct io_uring_buf_ring *buf_ring;
+    char *bufs;
+    uint16_t buf_tail;
+
+    int notify_fd;
+    sf_uring_op_t notify_op;
+    sf_uring_op_t timeout_op;
+    struct __kernel_timespec timeout;
+
+    sf_uring_op_t accept_op;
+    int accept_fd;
+    sf_socket_thread_t *accept_context;
+    sf_uring_accept_callback_t accept_callback;
+
+    sf_uring_op_t *current;  //正在处理cqe的op
+} sf_uring_t;
+
+static int sf_uring_setup(sf_uring_t *ring, unsigned entries) {
+    struct io_uring_params params;
+    void *ptr;
+    size_t sq_size;
+    size_t cq_size;
+
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL |
+        IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+
+    ring->ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->ring_fd < 0) {
+        return errno != 0 ? errno : ENOSYS;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+            !(params.features & IORING_FEAT_NODROP)) {
+        close(ring->ring_fd);
+        ring->ring_fd = -1;
+        return ENOTSUP;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+
+    ptr = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+    if (ptr == MAP_FAILED) {
+        close(ring->ring_fd);
+        ring->ring_fd = -1;
+        return errno != 0 ? errno : ENOMEM;
+    }
+    ring->ring_ptr = ptr;
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        munmap(ring->ring_ptr, ring->ring_size);
+        close(ring->ring_fd);
+        ring->ring_fd = -1;
+        return errno != 0 ? errno : ENOMEM;
+    }
+
+    ring->sq_head = (unsigned *)((char *)ptr + params.sq_off.head);
+    ring->sq_tail = (unsigned *)((char *)ptr + params.sq_off.tail);
+    ring->sq_array = (unsigned *)((char *)ptr + params.sq_off.array);
+    ring->sq_mask = *(unsigned *)((char *)ptr + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_local_tail = *ring->sq_tail;
+
+    ring->cq_head = (unsigned *)((char *)ptr + params.cq_off.head);
+    ring->cq_tail = (unsigned *)((char *)ptr + params.cq_off.tail);
+    ring->cq_mask = *(unsigned *)((char *)ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((char *)ptr + params.cq_off.cqes);
+
+    return 0;
+}
+
+static void sf_uring_teardown(sf_uring_t *ring) {
+    if (ring->ring_fd < 0) {
+        return;
+    }
+
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->ring_ptr, ring->ring_size);
+    close(ring->ring_fd);
+    ring->ring_fd = -1;
+
+    free(ring->buf_ring);
+    free(ring->bufs);
+    ring->buf_ring = NULL;
+    ring->bufs = NULL;
+}
+
+//提交已填充的sqe，min_complete > 0 时等待完成事件
+static int sf_uring_enter(sf_uring_t *ring, unsigned min_complete) {
+    unsigned to_submit = ring->sq_local_tail - *ring->sq_tail;
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int ret;
+
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    if (to_submit == 0 && min_complete == 0) {
+        return 0;
+    }
+
+    ret = syscall(__NR_io_uring_enter, ring->ring_fd, to_submit, min_complete,
+            flags, NULL, 0);
+    if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+            return 0;
+        }
+        return -errno;
+    }
+
+    return ret;
+}
+
+static struct io_uring_sqe *sf_uring_get_sqe(sf_uring_t *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned index;
+    struct io_uring_sqe *sqe;
+
+    if (ring->sq_local_tail - head >= ring->sq_entries) {
+        //sq满了先提交
+        sf_uring_enter(ring, 0);
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (ring->sq_local_tail - head >= ring->sq_entries) {
+            return NULL;
+        }
+    }
+
+    index = ring->sq_local_tail & ring->sq_mask;
+    sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+
+    return sqe;
+}
+
+static int sf_uring_submit_op(sf_uring_t *ring, sf_uring_op_t *op,
+        struct io_uring_sqe **psqe) {
+    struct io_uring_sqe *sqe = sf_uring_get_sqe(ring);
+    if (sqe == NULL) {
+        FLOG_ERROR("io_uring submission queue full");
+        return EBUSY;
+    }
+
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    op->inflight = true;
+    *psqe = sqe;
+    return 0;
+}
+
+static int sf_uring_submit_notify(sf_uring_t *ring) {
+    struct io_uring_sqe *sqe;
+    int ret = sf_uring_submit_op(ring, &ring->notify_op, &sqe);
+    if (ret != 0) {
+        return ret;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = ring->notify_fd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = POLLIN;
+    return 0;
+}
+
+static int sf_uring_submit_timeout(sf_uring_t *ring) {
+    struct io_uring_sqe *sqe;
+    int ret = sf_uring_submit_op(ring, &ring->timeout_op, &sqe);
+    if (ret != 0) {
+        return ret;
+    }
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uint64_t)(uintptr_t)&ring->timeout;
+    sqe->len = 1;
+    return 0;
+}
+
+static int sf_uring_submit_accept(sf_uring_t *ring) {
+    struct io_uring_sqe *sqe;
+    int ret = sf_uring_submit_op(ring, &ring->accept_op, &sqe);
+    if (ret != 0) {
+        return ret;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = ring->accept_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    return 0;
+}
+
+static int sf_uring_submit_recv(sf_uring_t *ring, sf_uring_op_t *op) {
+    struct io_uring_sqe *sqe;
+    int ret = sf_uring_submit_op(ring, op, &sqe);
+    if (ret != 0) {
+        return ret;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = op->task->event.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    if (op->poll_first) {
+        sqe->ioprio |= IORING_RECVSEND_POLL_FIRST;
+        op->poll_first = false;
+    }
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = SF_URING_BUF_GROUP;
+    return 0;
+}
+
+static int sf_uring_submit_send(sf_uring_t *ring, sf_uring_op_t *op) {
+    struct io_uring_sqe *sqe;
+    int send_bytes;
+    int iovcnt;
+    int ret;
+
+    iovcnt = sf_socket_send_iov(op->task, op->iov, &send_bytes);
+
+    ret = sf_uring_submit_op(ring, op, &sqe);
+    if (ret != 0) {
+        return ret;
+    }
+
+    memset(&op->msg, 0, sizeof(op->msg));
+    op->msg.msg_iov = op->iov;
+    op->msg.msg_iovlen = iovcnt;
+    op->zc = send_bytes >= SF_URING_ZC_THRESHOLD;
+    op->zc_result = 0;
+
+    sqe->opcode = op->zc ? IORING_OP_SENDMSG_ZC : IORING_OP_SENDMSG;
+    sqe->fd = op->task->event.fd;
+    sqe->addr = (uint64_t)(uintptr_t)&op->msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    if (op->poll_first) {
+        sqe->ioprio = IORING_RECVSEND_POLL_FIRST;
+        op->poll_first = false;
+    }
+    return 0;
+}
+
+static int sf_uring_submit_connect(sf_uring_t *ring, sf_uring_op_t *op) {
+    struct io_uring_sqe *sqe;
+    int ret = sf_uring_submit_op(ring, op, &sqe);
+    if (ret != 0) {
+        return ret;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = op->task->event.fd;
+    sqe->poll32_events = POLLOUT;
+    return 0;
+}
+
+static void sf_uring_sync_cancel(sf_uring_t *ring, sf_uring_op_t *op) {
+    //不占用sq，返回时op已经取消或完成，op自己的cqe照常到达
+    struct io_uring_sync_cancel_reg reg;
+    int ret;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = (uint64_t)(uintptr_t)op;
+    reg.fd = -1;
+    reg.timeout.tv_sec = -1;
+    reg.timeout.tv_nsec = -1;
+
+    do {
+        ret = syscall(__NR_io_uring_register, ring->ring_fd,
+                IORING_REGISTER_SYNC_CANCEL, &reg, 1);
+    } while (ret < 0 && errno == EINTR);
+
+    //ENOENT: 已经完成; EALREADY: 正在完成
+    if (ret < 0 && errno != ENOENT && errno != EALREADY) {
+        FLOG_ERROR("io_uring sync cancel op: %p fail, errno: %d, error info: %s",
+                op, errno, strerror(errno));
+    }
+}
+
+static void sf_uring_submit_cancel(sf_uring_t *ring, sf_uring_op_t *op) {
+    struct io_uring_sqe *sqe = sf_uring_get_sqe(ring);
+    if (sqe == NULL) {
+        //sq满时先提交已填充的sqe再重试，仍然失败则同步取消
+        sf_uring_enter(ring, 0);
+        sqe = sf_uring_get_sqe(ring);
+    }
+    if (sqe == NULL) {
+        FLOG_WARN("io_uring submission queue full, cancel op: %p synchronously", op);
+        sf_uring_sync_cancel(ring, op);
+        return;
+    }
+
+    //取消操作本身的cqe不需要处理
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (uint64_t)(uintptr_t)op;
+    sqe->user_data = 0;
+}
+
+static void sf_uring_buf_add(sf_uring_t *ring, int bid) {
+    struct io_uring_buf *buf;
+
+    buf = &ring->buf_ring->bufs[ring->buf_tail & (SF_URING_BUF_COUNT - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(ring->bufs + (size_t)bid * SF_URING_BUF_SIZE);
+    buf->len = SF_URING_BUF_SIZE;
+    buf->bid = bid;
+    ring->buf_tail++;
+}
+
+static void sf_uring_buf_publish(sf_uring_t *ring) {
+    __atomic_store_n(&ring->buf_ring->tail, ring->buf_tail, __ATOMIC_RELEASE);
+}
+
+static int sf_uring_buf_init(sf_uring_t *ring) {
+    struct io_uring_buf_reg reg;
+    size_t ring_bytes = SF_URING_BUF_COUNT * sizeof(struct io_uring_buf);
+    void *ptr;
+
+    if (posix_memalign(&ptr, 4096, ring_bytes) != 0) {
+        return ENOMEM;
+    }
+    memset(ptr, 0, ring_bytes);
+    ring->buf_ring = ptr;
+
+    ring->bufs = malloc((size_t)SF_URING_BUF_COUNT * SF_URING_BUF_SIZE);
+    if (ring->bufs == NULL) {
+        return ENOMEM;
+    }
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+    reg.ring_entries = SF_URING_BUF_COUNT;
+    reg.bgid = SF_URING_BUF_GROUP;
+    if (syscall(__NR_io_uring_register, ring->ring_fd,
+                IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        return errno != 0 ? errno : ENOTSUP;
+    }
+
+    ring->buf_tail = 0;
+    for (int i = 0; i < SF_URING_BUF_COUNT; i++) {
+        sf_uring_buf_add(ring, i);
+    }
+    sf_uring_buf_publish(ring);
+
+    return 0;
+}
+
+static sf_uring_t *sf_uring_get(struct fast_task_info *task) {
+    sf_notify_queue_t *queue = task->thread_data->arg;
+    return queue->uring;
+}
+
+static void sf_uring_op_free(sf_uring_op_t *op) {
+    for (int i = 0; i < op->held_count; i++) {
+        delete_response_buff(op->held[i]);
+    }
+    free(op);
+}
+
+static void sf_uring_add_timer(struct fast_task_info *task,
+        IOEventCallback callback, int timeout) {
+    int result;
+
+    task->event.callback = callback;
+    task->event.timer.data = task;
+    task->event.timer.expires = g_current_time + timeout;
+
+    result = fast_timer_add(&task->thread_data->timer, &task->event.timer);
+    if (result != 0) {
+        FLOG_ERROR("fast_timer_add fail, errno: %d, error info: %s",
+                result, strerror(result));
+    }
+}
+
+static sf_uring_op_t *sf_uring_attach(struct fast_task_info *task,
+        sf_uring_op_type_t type) {
+    sf_task_arg_t *task_arg = task->arg;
+    sf_uring_op_t *op;
+
+    if (task_arg->io_op != NULL) {
+        sf_uring_clear(task);
+    }
+
+    op = calloc(1, sizeof(sf_uring_op_t));
+    if (op == NULL) {
+        return NULL;
+    }
+
+    op->type = type;
+    op->task = task;
+    task_arg->io_op = op;
+    return op;
+}
+
+static void sf_uring_detach(struct fast_task_info *task) {
+    sf_task_arg_t *task_arg = task->arg;
+    sf_uring_op_t *op = task_arg->io_op;
+
+    task_arg->io_op = NULL;
+    op->task = NULL;
+    if (!op->inflight) {
+        sf_uring_op_free(op);
+    }
+}
+
+int sf_uring_set_recv(struct fast_task_info *task, IOEventCallback callback, int timeout) {
+    sf_uring_t *ring = sf_uring_get(task);
+    sf_uring_op_t *op;
+    int ret;
+
+    op = sf_uring_attach(task, SF_URING_OP_RECV);
+    if (op == NULL) {
+        return ENOMEM;
+    }
+
+    sf_uring_add_timer(task, callback, timeout);
+
+    if ((ret = sf_uring_submit_recv(ring, op)) != 0) {
+        sf_uring_detach(task);
+    }
+    return ret;
+}
+
+int sf_uring_set_send(struct fast_task_info *task, IOEventCallback callback, int timeout) {
+    sf_uring_t *ring = sf_uring_get(task);
+    sf_uring_op_t *op;
+    int ret;
+
+    op = sf_uring_attach(task, SF_URING_OP_SEND);
+    if (op == NULL) {
+        return ENOMEM;
+    }
+
+    sf_uring_add_timer(task, callback, timeout);
+
+    if ((ret = sf_uring_submit_send(ring, op)) != 0) {
+        sf_uring_detach(task);
+    }
+    return ret;
+}
+
+int sf_uring_set_connect(struct fast_task_info *task, IOEventCallback callback, int timeout) {
+    sf_uring_t *ring = sf_uring_get(task);
+    sf_uring_op_t *op;
+    int ret;
+
+    op = sf_uring_attach(task, SF_URING_OP_CONNECT);
+    if (op == NULL) {
+        return ENOMEM;
+    }
+
+    sf_uring_add_timer(task, callback, timeout);
+
+    if ((ret = sf_uring_submit_connect(ring, op)) != 0) {
+        sf_uring_detach(task);
+    }
+    return ret;
+}
+
+void sf_uring_clear(struct fast_task_info *task) {
+    sf_task_arg_t *task_arg = task->arg;
+    sf_uring_t *ring = sf_uring_get(task);
+    sf_uring_op_t *op = task_arg->io_op;
+
+    if (op == NULL) {
+        return;
+    }
+
+    task_arg->io_op = NULL;
+    op->task = NULL;
+
+    if (op->inflight) {
+        //立即提交取消，op和sf_uring_hold_response接管的应答在最后一个cqe到达后释放
+        sf_uring_submit_cancel(ring, op);
+        sf_uring_enter(ring, 0);
+    } else if (op != ring->current) {
+        sf_uring_op_free(op);
+    }
+}
+
+bool sf_uring_hold_response(struct fast_task_info *task, response_buff_t *buff) {
+    sf_task_arg_t *task_arg = task->arg;
+    sf_uring_op_t *op = task_arg->io_op;
+
+    if (op == NULL || op->type != SF_URING_OP_SEND || !op->inflight) {
+        return false;
+    }
+
+    if (op->held_count >= SF_SEND_BATCH_SIZE + 1) {
+        FLOG_ERROR("io_uring send op: %p hold too many buffers", op);
+        return false;
+    }
+
+    op->held[op->held_count++] = buff;
+    return true;
+}
+
+static void sf_uring_deal_recv(sf_uring_t *ring, sf_uring_op_t *op,
+        int res, unsigned flags) {
+    char *buff = NULL;
+    int bid = -1;
+
+    if (flags & IORING_CQE_F_BUFFER) {
+        bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        buff = ring->bufs + (size_t)bid * SF_URING_BUF_SIZE;
+    }
+
+    //ENOBUFS: provided buffer用完，multishot结束，下面重新提交
+    //EAGAIN: socket是非阻塞的，等可读后重新提交
+    if (res == -EAGAIN) {
+        op->poll_first = true;
+    } else if (op->task != NULL && res != -ENOBUFS) {
+        sf_socket_recv_result(op->task, buff, res);
+    }
+
+    if (bid >= 0) {
+        sf_uring_buf_add(ring, bid);
+        sf_uring_buf_publish(ring);
+    }
+
+    if (op->task != NULL && !op->inflight) {
+        if (sf_uring_submit_recv(ring, op) != 0) {
+            sf_socket_recv_result(op->task, NULL, -EIO);
+        }
+    }
+}
+
+static void sf_uring_deal_send(sf_uring_t *ring, sf_uring_op_t *op,
+        int res, unsigned flags) {
+    if (op->zc) {
+        if (!(flags & IORING_CQE_F_NOTIF)) {
+            op->zc_result = res;
+            if (flags & IORING_CQE_F_MORE) {
+                return;
+            }
+        }
+        res = op->zc_result;
+    }
+
+    //EAGAIN: socket缓冲区满，等可写后重新提交
+    if (res == -EAGAIN) {
+        op->poll_first = true;
+    } else if (op->task != NULL) {
+        sf_socket_send_result(op->task, res);
+    }
+
+    //task未被清除说明还有应答待发送(部分写入或已换入下一个应答)
+    if (op->task != NULL && !op->inflight) {
+        if (sf_uring_submit_send(ring, op) != 0) {
+            sf_socket_send_result(op->task, -EIO);
+        }
+    }
+}
+
+static void sf_uring_deal_connect(sf_uring_t *ring, sf_uring_op_t *op, int res) {
+    struct fast_task_info *task = op->task;
+
+    if (task == NULL) {
+        return;
+    }
+
+    if (res < 0 || (res & (POLLERR | POLLHUP))) {
+        task->event.callback(task->event.fd, IOEVENT_ERROR, task);
+    } else {
+        task->event.callback(task->event.fd, IOEVENT_WRITE, task);
+    }
+
+    //连接成功后继续发送已排队的应答
+    if (op->task != NULL) {
+        op->type = SF_URING_OP_SEND;
+        if (task->length > task->offset && sf_uring_submit_send(ring, op) != 0) {
+            sf_socket_send_result(task, -EIO);
+        }
+    }
+}
+
+static void sf_uring_deal_accept(sf_uring_t *ring, int res) {
+    struct sockaddr_in inaddr;
+    socklen_t sockaddr_len = sizeof(inaddr);
+
+    if (res < 0) {
+        if (res != -ECANCELED && res != -EINTR && res != -EAGAIN) {
+            FLOG_ERROR("accept failed, errno: %d, error info: %s", -res,
+                       strerror(-res));
+        }
+    } else {
+        memset(&inaddr, 0, sizeof(inaddr));
+        getpeername(res, (struct sockaddr *)&inaddr, &sockaddr_len);
+        ring->accept_callback(ring->accept_context, res, &inaddr);
+    }
+
+    if (!ring->accept_op.inflight && g_continue_flag) {
+        sf_uring_submit_accept(ring);
+    }
+}
+
+static void sf_uring_dispatch(sf_uring_t *ring, uint64_t user_data, int res,
+        unsigned flags) {
+    sf_uring_op_t *op = (sf_uring_op_t *)(uintptr_t)user_data;
+    uint64_t count;
+
+    if (op == NULL) {
+        return;
+    }
+
+    if (!(flags & IORING_CQE_F_MORE)) {
+        op->inflight = false;
+    }
+
+    ring->current = op;
+    switch (op->type) {
+        case SF_URING_OP_NOTIFY:
+            if (read(ring->notify_fd, &count, sizeof(count)) < 0 &&
+                    errno != EAGAIN) {
+                FLOG_ERROR("call read failed, errno: %d, error info: %s", errno,
+                           strerror(errno));
+            }
+            if (!op->inflight) {
+                sf_uring_submit_notify(ring);
+            }
+            break;
+        case SF_URING_OP_TIMEOUT:
+            sf_uring_submit_timeout(ring);
+            break;
+        case SF_URING_OP_ACCEPT:
+            sf_uring_deal_accept(ring, res);
+            break;
+        case SF_URING_OP_RECV:
+            sf_uring_deal_recv(ring, op, res, flags);
+            break;
+        case SF_URING_OP_SEND:
+            sf_uring_deal_send(ring, op, res, flags);
+            break;
+        case SF_URING_OP_CONNECT:
+            sf_uring_deal_connect(ring, op, res);
+            break;
+    }
+    ring->current = NULL;
+
+    if (op->task == NULL && !op->inflight &&
+            (op->type == SF_URING_OP_RECV || op->type == SF_URING_OP_SEND ||
+             op->type == SF_URING_OP_CONNECT)) {
+        sf_uring_op_free(op);
+    }
+}
+
+static void sf_uring_reap(sf_uring_t *ring) {
+    unsigned head = *ring->cq_head;
+    unsigned tail;
+    struct io_uring_cqe *cqe;
+    uint64_t user_data;
+    int res;
+    unsigned flags;
+
+    while (true) {
+        tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            break;
+        }
+
+        cqe = &ring->cqes[head & ring->cq_mask];
+        user_data = cqe->user_data;
+        res = cqe->res;
+        flags = cqe->flags;
+
+        head++;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+        sf_uring_dispatch(ring, user_data, res, flags);
+    }
+}
+
+static void sf_uring_deal_timeouts(struct nio_thread_data *thread_data) {
+    FastTimerEntry head;
+    FastTimerEntry *entry;
+    FastTimerEntry *current;
+    IOEventEntry *event_entry;
+
+    if (fast_timer_timeouts_get(&thread_data->timer, g_current_time, &head) <= 0) {
+        return;
+    }
+
+    entry = head.next;
+    while (entry != NULL) {
+        current = entry;
+        entry = entry->next;
+
+        current->prev = current->next = NULL; //must set NULL because NOT in time wheel
+        event_entry = (IOEventEntry *)current->data;
+        if (event_entry != NULL) {
+            event_entry->callback(event_entry->fd, IOEVENT_TIMEOUT, current->data);
+        }
+    }
+}
+
+static void sf_uring_set_timeout(sf_uring_t *ring) {
+    int timeout_ms = sf_config.socket_config.epoll_timeout;
+    if (timeout_ms <= 0) {
+        timeout_ms = 1000;
+    }
+
+    ring->timeout.tv_sec = timeout_ms / 1000;
+    ring->timeout.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+    ring->timeout_op.type = SF_URING_OP_TIMEOUT;
+}
+
+bool sf_uring_supported() {
+    static int supported = -1;
+    sf_uring_t ring;
+    struct io_uring_probe *probe;
+    size_t probe_size;
+
+    if (supported >= 0) {
+        return supported == 1;
+    }
+
+    supported = 0;
+    memset(&ring, 0, sizeof(ring));
+    if (sf_uring_setup(&ring, 8) != 0) {
+        return false;
+    }
+
+    //SENDMSG_ZC(6.1)之前的内核也不支持multishot recv
+    probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    probe = calloc(1, probe_size);
+    if (probe != NULL && syscall(__NR_io_uring_register, ring.ring_fd,
+                IORING_REGISTER_PROBE, probe, 256) == 0) {
+        if (probe->last_op >= IORING_OP_SENDMSG_ZC &&
+                (probe->ops[IORING_OP_SENDMSG_ZC].flags & IO_URING_OP_SUPPORTED)) {
+            supported = 1;
+        }
+    }
+
+    free(probe);
+    sf_uring_teardown(&ring);
+    return supported == 1;
+}
+
+int sf_uring_thread_init(struct nio_thread_data *thread_data, int type) {
+    sf_notify_queue_t *queue = thread_data->arg;
+    sf_uring_t *ring;
+    int result;
+
+    ring = calloc(1, sizeof(sf_uring_t));
+    if (ring == NULL) {
+        return ENOMEM;
+    }
+    ring->ring_fd = -1;
+
+    if ((result = sf_uring_setup(ring, SF_URING_ENTRIES)) != 0) {
+        FLOG_ERROR("io_uring setup fail, errno: %d, error info: %s",
+                result, strerror(result));
+        free(ring);
+        return result;
+    }
+
+    if (type == IOEVENT_READ && (result = sf_uring_buf_init(ring)) != 0) {
+        FLOG_ERROR("io_uring register provided buffers fail, "
+                "errno: %d, error info: %s", result, strerror(result));
+        sf_uring_teardown(ring);
+        free(ring);
+        return result;
+    }
+
+    ring->notify_fd = thread_data->pipe_fds[0];
+    ring->notify_op.type = SF_URING_OP_NOTIFY;
+    sf_uring_set_timeout(ring);
+
+    queue->uring = ring;
+    return 0;
+}
+
+void sf_uring_thread_destroy(struct nio_thread_data *thread_data) {
+    sf_notify_queue_t *queue = thread_data->arg;
+
+    if (queue == NULL || queue->uring == NULL) {
+        return;
+    }
+
+    sf_uring_teardown(queue->uring);
+    free(queue->uring);
+    queue->uring = NULL;
+}
+
+int sf_uring_loop(struct nio_thread_data *thread_data, int type) {
+    sf_notify_queue_t *queue = thread_data->arg;
+    sf_uring_t *ring = queue->uring;
+    time_t last_check_time;
+    int ret;
+
+    if (sf_uring_submit_notify(ring) != 0 || sf_uring_submit_timeout(ring) != 0) {
+        return EBUSY;
+    }
+
+    last_check_time = g_current_time;
+    while (g_continue_flag) {
+        //一次系统调用提交本轮所有的发送/接收请求
+        ret = sf_uring_enter(ring, 1);
+        if (ret < 0) {
+            FLOG_ERROR("io_uring_enter fail, errno: %d, error info: %s",
+                    -ret, strerror(-ret));
+            return -ret;
+        }
+
+        sf_uring_reap(ring);
+
+        if (g_current_time - last_check_time > 0) {
+            last_check_time = g_current_time;
+            sf_uring_deal_timeouts(thread_data);
+        }
+
+        if (thread_data->thread_loop_callback != NULL) {
+            thread_data->thread_loop_callback(thread_data);
+        }
+    }
+
+    return 0;
+}
+
+int sf_uring_accept_loop(sf_socket_thread_t *context, sf_uring_accept_callback_t callback) {
+    sf_uring_t ring;
+    int ret;
+
+    memset(&ring, 0, sizeof(ring));
+    if ((ret = sf_uring_setup(&ring, SF_URING_ACCEPT_ENTRIES)) != 0) {
+        FLOG_ERROR("io_uring setup fail, errno: %d, error info: %s",
+                ret, strerror(ret));
+        return ret;
+    }
+
+    ring.accept_fd = context->socket_fd;
+    ring.accept_context = context;
+    ring.accept_callback = callback;
+    ring.accept_op.type = SF_URING_OP_ACCEPT;
+    sf_uring_set_timeout(&ring);
+
+    //multishot accept，一次提交持续收到新连接
+    ret = sf_uring_submit_accept(&ring);
+    if (ret == 0) {
+        ret = sf_uring_submit_timeout(&ring);
+    }
+
+    while (ret == 0 && g_continue_flag) {
+        ret = sf_uring_enter(&ring, 1);
+        if (ret < 0) {
+            FLOG_ERROR("io_uring_enter fail, errno: %d, error info: %s",
+                    -ret, strerror(-ret));
+            ret = -ret;
+            break;
+        }
+        ret = 0;
+        sf_uring_reap(&ring);
+    }
+
+    sf_uring_teardown(&ring);
+    return ret;
+}
+
+#else  // SF_USE_IO_URING
+
+bool sf_uring_supported() { return false; }
+
+int sf_uring_thread_init(struct nio_thread_data *thread_data, int type) {
+    return ENOTSUP;
+}
+
+void sf_uring_thread_destroy(struct nio_thread_data *thread_data) {}
+
+int sf_uring_loop(struct nio_thread_data *thread_data, int type) { return ENOTSUP; }
+
+int sf_uring_accept_loop(sf_socket_thread_t *context, sf_uring_accept_callback_t callback) {
+    return ENOTSUP;
+}
+
+int sf_uring_set_recv(struct fast_task_info *task, IOEventCallback callback, int timeout) {
+    return ENOTSUP;
+}
+
+int sf_uring_set_send(struct fast_task_info *task, IOEventCallback callback, int timeout) {
+    return ENOTSUP;
+}
+
+int sf_uring_set_connect(struct fast_task_info *task, IOEventCallback callback, int timeout) {
+    return ENOTSUP;
+}
+
+void sf_uring_clear(struct fast_task_info *task) {}
+
+bool sf_uring_hold_response(struct fast_task_info *task, response_buff_t *buff) {
+    return false;
+}
+
+#endif  // SF_USE_IO_URING
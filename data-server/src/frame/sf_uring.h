@@ -0,0 +1,48 @@
+#ifndef __SF_URING_H__
+#define __SF_URING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include <fastcommon/fast_task_queue.h>
+
+#include "sf_socket_buff.h"
+
+struct sf_socket_thread_s;
+
+typedef void (*sf_uring_accept_callback_t)(struct sf_socket_thread_s *context,
+        int sock, const struct sockaddr_in *inaddr);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//编译时打开ENABLE_IO_URING且内核支持(>= 6.1)
+bool sf_uring_supported();
+
+//在sf_notify_init之后调用，io线程改由sf_uring_loop驱动
+int sf_uring_thread_init(struct nio_thread_data *thread_data, int type);
+void sf_uring_thread_destroy(struct nio_thread_data *thread_data);
+
+//type: IOEVENT_READ(接收线程) or IOEVENT_WRITE(发送线程)
+int sf_uring_loop(struct nio_thread_data *thread_data, int type);
+int sf_uring_accept_loop(struct sf_socket_thread_s *context, sf_uring_accept_callback_t callback);
+
+//对应ioevent_set, callback只用于超时和连接事件
+int sf_uring_set_recv(struct fast_task_info *task, IOEventCallback callback, int timeout);
+int sf_uring_set_send(struct fast_task_info *task, IOEventCallback callback, int timeout);
+int sf_uring_set_connect(struct fast_task_info *task, IOEventCallback callback, int timeout);
+
+//对应ioevent_detach，取消在途的请求
+void sf_uring_clear(struct fast_task_info *task);
+
+//发送还在内核中时由op接管buff，等最后一个cqe(包括取消)到达后再释放
+//返回false时由调用方释放
+bool sf_uring_hold_response(struct fast_task_info *task, response_buff_t *buff);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif//__SF_URING_H__
@@ -135,6 +135,24 @@ Status Client::AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest& req) {
     return Status::OK();
 }
 
+Status Client::AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest& req,
+                                        const RangeHeartbeatList& unchanged) {
+    auto conn = getLeaderConn();
+    if (conn == nullptr) {
+        return Status(Status::kNoLeader);
+    }
+
+    auto call = new RangeHeartbeatBatchCall;
+    call->type = AsyncCallType::kRangeHeartbeatBatch;
+    call->request = req;
+    call->unchanged = unchanged;
+    call->context.set_compression_algorithm(GRPC_COMPRESS_GZIP);
+    call->response_reader =
+        conn->GetStub()->AsyncRangeHeartbeatBatch(&call->context, req, &cq_);
+    call->Finish();
+    return Status::OK();
+}
+
 Status Client::AsyncAskSplit(const mspb::AskSplitRequest& req) {
     auto conn = getLeaderConn();
     if (conn == nullptr) {
@@ -165,6 +183,10 @@ void Client::set_leader(const std::string& leader) {
     FLOG_INFO("[Master] Leader set to %s.", leader.c_str());
 
     std::lock_guard<std::mutex> lock(addr_mu_);
+    // 新的leader可能已经升级，重新尝试合并心跳
+    if (!leader.empty() && leader != leader_) {
+        batch_hb_probe_at_ = 0;
+    }
     leader_ = leader;
     if (!leader.empty()) {
         addAddr(leader);
@@ -296,7 +318,10 @@ void Client::recvResponse(TaskHandler* handler) {
         }
 
         std::string from = call->context.peer();
-        if (!call->status.ok()) {
+        if (call->type == AsyncCallType::kRangeHeartbeatBatch &&
+            call->status.error_code() == grpc::UNIMPLEMENTED) {
+            fallbackRangeHeartbeat(call);
+        } else if (!call->status.ok()) {
             FLOG_ERROR("[Master] rpc failed to %s. type=%s, code=%d, msg=%s.",
                        from.c_str(), AsyncCallTypeName(call->type).c_str(),
                        call->status.error_code(), call->status.error_message().c_str());
@@ -339,6 +364,18 @@ void Client::dispatchResponse(TaskHandler* handler, const std::string& from,
             }
             break;
         }
+        case AsyncCallType::kRangeHeartbeatBatch: {
+            auto res = dynamic_cast<RangeHeartbeatBatchCall*>(call);
+            if (!checkResponseError(from, res->response.header())) {
+                for (const auto& resp : res->response.responses()) {
+                    handler->OnRangeHeartbeatResp(resp);
+                }
+                if (res->response.full_report_ranges_size() > 0) {
+                    resendFullHeartbeat(*res);
+                }
+            }
+            break;
+        }
         case AsyncCallType::kGetMSLeader: {
             auto res = dynamic_cast<AsyncCallResultT<mspb::GetMSLeaderResponse>*>(call);
             if (!checkResponseError(from, res->response.header())) {
@@ -352,6 +389,51 @@ void Client::dispatchResponse(TaskHandler* handler, const std::string& from,
     }
 }
 
+static int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool Client::RangeHeartbeatBatchSupported() const {
+    auto probe_at = batch_hb_probe_at_.load();
+    return probe_at == 0 || steadyNowMs() >= probe_at;
+}
+
+void Client::fallbackRangeHeartbeat(AsyncCallResult* call) {
+    // 隔一段时间再尝试，master升级之后恢复合并心跳
+    static const int64_t kBatchProbeIntervalMs = 5 * 60 * 1000;
+
+    if (batch_hb_probe_at_.exchange(steadyNowMs() + kBatchProbeIntervalMs) == 0) {
+        FLOG_WARN("[Master] master server %s don't support RangeHeartbeatBatch, "
+                  "fallback to RangeHeartbeat.", call->context.peer().c_str());
+    }
+    auto res = dynamic_cast<RangeHeartbeatBatchCall*>(call);
+    for (const auto& req : res->request.ranges()) {
+        AsyncRangeHeartbeat(req);
+    }
+    for (const auto& req : res->unchanged) {
+        AsyncRangeHeartbeat(*req);
+    }
+}
+
+void Client::resendFullHeartbeat(const RangeHeartbeatBatchCall& call) {
+    std::set<uint64_t> range_ids(call.response.full_report_ranges().begin(),
+                                 call.response.full_report_ranges().end());
+    mspb::RangeHeartbeatBatchRequest req;
+    req.set_node_id(call.request.node_id());
+    for (const auto& hb : call.unchanged) {
+        if (range_ids.count(hb->range().id()) > 0) {
+            req.add_ranges()->CopyFrom(*hb);
+        }
+    }
+    FLOG_INFO("[Master] master asks full heartbeat of %d ranges, resend %d.",
+              call.response.full_report_ranges_size(), req.ranges_size());
+    if (req.ranges_size() > 0) {
+        AsyncRangeHeartbeatBatch(req, RangeHeartbeatList());
+    }
+}
+
 void Client::checkStatus(const grpc::Status& s) {
     static const uint64_t kAskThreshold = 5;
 
@@ -10,12 +10,14 @@ _Pragma("once");
 #include "base/status.h"
 #include "connection.h"
 #include "task_handler.h"
+#include "worker.h"
 
 namespace sharkstore {
 namespace dataserver {
 namespace master {
 
 struct AsyncCallResult;
+struct RangeHeartbeatBatchCall;
 
 // Client 管理同MasterServer之间的RPC请求
 // 所有请求如果当前没有leader，会先获取一次leader，如果获取失败则本次请求失败
@@ -43,9 +45,16 @@ public:
     // 异步调用方法
     Status AsyncNodeHeartbeat(const mspb::NodeHeartbeatRequest& req);
     Status AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest& req);
+    // 多个range的心跳合并为一个压缩的请求发送
+    // unchanged是req.unchanged_ranges对应的完整心跳，需要补发时使用
+    Status AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest& req,
+                                    const RangeHeartbeatList& unchanged);
     Status AsyncAskSplit(const mspb::AskSplitRequest& req);
     Status AsyncReportSplit(const mspb::ReportSplitRequest& req);
 
+    // master返回UNIMPLEMENTED之后一段时间内为false，到期或者leader变化后重新尝试
+    bool RangeHeartbeatBatchSupported() const;
+
 private:
     using ConnPtr = std::shared_ptr<Connection>;
 
@@ -72,6 +81,11 @@ private:
     void dispatchResponse(TaskHandler* handler, const std::string& from,
                           AsyncCallResult* resp);
 
+    // master不支持RangeHeartbeatBatch时，拆成单个range心跳重新发送，包括只上报了id的range
+    void fallbackRangeHeartbeat(AsyncCallResult* call);
+    // master要求全量上报的range，补发完整心跳
+    void resendFullHeartbeat(const RangeHeartbeatBatchCall& call);
+
     // 检查rpc状态马，如果连续多次都是网络错误，我们可能连到了一个假的leader
     // 就发起一次AsyncAskLeader请求
     void checkStatus(const grpc::Status& s);
@@ -91,6 +105,8 @@ private:
     size_t magic_counter_ = 0;
 
     std::atomic<uint64_t> network_fail_count_{0};
+    // 0表示master支持RangeHeartbeatBatch，否则是重新尝试的时间(steady clock毫秒)
+    std::atomic<int64_t> batch_hb_probe_at_{0};
     TimePoint last_async_ask_;
 
     ConnMap connections_;
@@ -0,0 +1,68 @@
+#include "range_heartbeat_batcher.h"
+
+#include <functional>
+
+#include "frame/sf_logger.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace master {
+
+RangeHeartbeatBatcher::RangeHeartbeatBatcher(Worker *worker, int full_rounds)
+    : worker_(worker), full_rounds_(full_rounds) {}
+
+void RangeHeartbeatBatcher::Add(mspb::RangeHeartbeatRequest &&req) {
+    auto range_id = req.range().id();
+    auto fingerprint = std::hash<std::string>()(req.SerializeAsString());
+
+    auto it = reported_.find(range_id);
+    if (it != reported_.end() && it->second.fingerprint == fingerprint &&
+        it->second.skipped_rounds < full_rounds_) {
+        ++it->second.skipped_rounds;
+        batch_.add_unchanged_ranges(range_id);
+        unchanged_.push_back(it->second.last);
+        return;
+    }
+
+    auto &reported = reported_[range_id];
+    reported.fingerprint = fingerprint;
+    reported.skipped_rounds = 0;
+    batch_.add_ranges()->CopyFrom(req);
+    reported.last = std::make_shared<const mspb::RangeHeartbeatRequest>(std::move(req));
+}
+
+void RangeHeartbeatBatcher::Forget(uint64_t range_id) { reported_.erase(range_id); }
+
+size_t RangeHeartbeatBatcher::Flush(uint64_t node_id) {
+    auto count = PendingSize();
+    if (count == 0) {
+        return 0;
+    }
+
+    if (worker_->RangeHeartbeatBatchSupported()) {
+        batch_.set_node_id(node_id);
+        worker_->AsyncRangeHeartbeatBatch(batch_, unchanged_);
+        FLOG_DEBUG("range heartbeat batch: changed=%d, unchanged=%d",
+                   batch_.ranges_size(), batch_.unchanged_ranges_size());
+    } else {
+        // master不支持合并心跳，每个range都发送完整的心跳
+        for (const auto &req : batch_.ranges()) {
+            worker_->AsyncRangeHeartbeat(req);
+        }
+        for (const auto &req : unchanged_) {
+            worker_->AsyncRangeHeartbeat(*req);
+        }
+    }
+
+    batch_.Clear();
+    unchanged_.clear();
+    return count;
+}
+
+size_t RangeHeartbeatBatcher::PendingSize() const {
+    return static_cast<size_t>(batch_.ranges_size() + batch_.unchanged_ranges_size());
+}
+
+}  // namespace master
+}  // namespace dataserver
+}  // namespace sharkstore
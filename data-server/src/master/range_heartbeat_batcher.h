@@ -0,0 +1,53 @@
+_Pragma("once");
+
+#include <memory>
+#include <unordered_map>
+
+#include "proto/gen/mspb.pb.h"
+#include "worker.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace master {
+
+// RangeHeartbeatBatcher 把一个周期内到期的range心跳合并成一个节点级的请求
+// 心跳内容没有变化的range只上报range id，每隔full_rounds轮强制全量上报一次
+// 非线程安全，只在range心跳线程中使用
+class RangeHeartbeatBatcher final {
+public:
+    RangeHeartbeatBatcher(Worker *worker, int full_rounds);
+    ~RangeHeartbeatBatcher() = default;
+
+    RangeHeartbeatBatcher(const RangeHeartbeatBatcher &) = delete;
+    RangeHeartbeatBatcher &operator=(const RangeHeartbeatBatcher &) = delete;
+
+    void Add(mspb::RangeHeartbeatRequest &&req);
+
+    // range不再是leader或者已被删除，下次成为leader时全量上报
+    void Forget(uint64_t range_id);
+
+    // 发送本轮合并的心跳，返回本轮上报的range个数
+    size_t Flush(uint64_t node_id);
+
+    size_t PendingSize() const;
+    size_t TrackedSize() const { return reported_.size(); }
+
+private:
+    struct Reported {
+        size_t fingerprint = 0;
+        int skipped_rounds = 0;
+        // 最近一次的完整心跳
+        std::shared_ptr<const mspb::RangeHeartbeatRequest> last;
+    };
+
+    Worker *worker_ = nullptr;
+    const int full_rounds_ = 0;
+
+    mspb::RangeHeartbeatBatchRequest batch_;
+    RangeHeartbeatList unchanged_;
+    std::unordered_map<uint64_t, Reported> reported_;
+};
+
+}  // namespace master
+}  // namespace dataserver
+}  // namespace sharkstore
@@ -3,6 +3,7 @@ _Pragma("once");
 #include <grpc++/grpc++.h>
 
 #include "proto/gen/mspb.grpc.pb.h"
+#include "worker.h"
 
 namespace sharkstore {
 namespace dataserver {
@@ -16,6 +17,7 @@ enum class AsyncCallType : char {
     kReportSplit,
     kNodeHeartbeat,
     kRangeHeartbeat,
+    kRangeHeartbeatBatch,
     kGetMSLeader,
 };
 
@@ -40,6 +42,14 @@ public:
     void Finish() { response_reader->Finish(&response, &status, (void*)this); }
 };
 
+struct RangeHeartbeatBatchCall
+    : public AsyncCallResultT<mspb::RangeHeartbeatBatchResponse> {
+    // kept for resending when master don't support batch heartbeat
+    // or asks for a full report of unchanged ranges
+    mspb::RangeHeartbeatBatchRequest request;
+    RangeHeartbeatList unchanged;
+};
+
 }  // namespace master
 }  // namespace dataserver
 }  // namespace sharkstore
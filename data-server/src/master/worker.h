@@ -1,5 +1,8 @@
 _Pragma("once");
 
+#include <memory>
+#include <vector>
+
 #include "base/status.h"
 #include "proto/gen/mspb.pb.h"
 #include "task_handler.h"
@@ -8,6 +11,10 @@ namespace sharkstore {
 namespace dataserver {
 namespace master {
 
+// 只上报了id的range最近一次的完整心跳
+// master不支持合并心跳或者要求全量上报时用来补发
+using RangeHeartbeatList = std::vector<std::shared_ptr<const mspb::RangeHeartbeatRequest>>;
+
 class Worker {
 public:
     virtual ~Worker() = default;
@@ -24,6 +31,11 @@ public:
 
     virtual void AsyncNodeHeartbeat(const mspb::NodeHeartbeatRequest &req) = 0;
     virtual void AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest &req) = 0;
+    // unchanged是req.unchanged_ranges对应的完整心跳
+    virtual void AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest &req,
+                                          const RangeHeartbeatList &unchanged) = 0;
+    // false if master server don't support RangeHeartbeatBatch rpc (re-probed periodically)
+    virtual bool RangeHeartbeatBatchSupported() const = 0;
     virtual void AsyncAskSplit(const mspb::AskSplitRequest &req) = 0;
     virtual void AsyncReportSplit(const mspb::ReportSplitRequest &req) = 0;
 };
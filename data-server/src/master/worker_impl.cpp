@@ -128,6 +128,20 @@ void WorkerImpl::AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest &req) {
     }
 }
 
+void WorkerImpl::AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest &req,
+                                          const RangeHeartbeatList &unchanged) {
+    auto task = new AsyncRPCTask;
+    task->type = AsyncCallType::kRangeHeartbeatBatch;
+    task->call_func = std::bind(&Client::AsyncRangeHeartbeatBatch, client_, req, unchanged);
+    if (!pushCall(task)) {
+        delete task;
+    }
+}
+
+bool WorkerImpl::RangeHeartbeatBatchSupported() const {
+    return client_->RangeHeartbeatBatchSupported();
+}
+
 void WorkerImpl::AsyncAskSplit(const mspb::AskSplitRequest &req) {
     auto task = new AsyncRPCTask;
     task->type = AsyncCallType::kAskSplit;
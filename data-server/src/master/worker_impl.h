@@ -38,6 +38,9 @@ public:
 
     void AsyncNodeHeartbeat(const mspb::NodeHeartbeatRequest &req) override;
     void AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest &req) override;
+    void AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest &req,
+                                  const RangeHeartbeatList &unchanged) override;
+    bool RangeHeartbeatBatchSupported() const override;
     void AsyncAskSplit(const mspb::AskSplitRequest &req) override;
     void AsyncReportSplit(const mspb::ReportSplitRequest &req) override;
 
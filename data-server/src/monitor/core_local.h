@@ -0,0 +1,106 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <functional>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace sharkstore {
+namespace monitor {
+
+static constexpr size_t kCacheLineSize = 64;
+
+// 按cpu分片的数组，每个分片独占cache line
+// 更新只写当前cpu的分片，读取时由调用者合并所有分片
+template <class T>
+class CoreLocalArray {
+public:
+    CoreLocalArray() {
+        auto cpus = std::thread::hardware_concurrency();
+        size_ = 1;
+        while (size_ < cpus) size_ <<= 1;
+
+        void* mem = nullptr;
+        if (posix_memalign(&mem, kCacheLineSize, sizeof(T) * size_) != 0) {
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<T*>(mem);
+        for (size_t i = 0; i < size_; ++i) {
+            new (data_ + i) T();
+        }
+    }
+
+    ~CoreLocalArray() {
+        for (size_t i = 0; i < size_; ++i) {
+            data_[i].~T();
+        }
+        free(data_);
+    }
+
+    CoreLocalArray(const CoreLocalArray&) = delete;
+    CoreLocalArray& operator=(const CoreLocalArray&) = delete;
+
+    size_t Size() const { return size_; }
+
+    T* Access() { return data_ + (currentCore() & (size_ - 1)); }
+
+    T* AccessAt(size_t i) { return data_ + i; }
+    const T* AccessAt(size_t i) const { return data_ + i; }
+
+private:
+    static size_t currentCore() {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if (cpu >= 0) return static_cast<size_t>(cpu);
+#endif
+        return std::hash<std::thread::id>()(std::this_thread::get_id());
+    }
+
+private:
+    size_t size_ = 0;
+    T* data_ = nullptr;
+};
+
+// 多线程频繁累加、偶尔读取的计数器
+class CoreLocalCounter {
+public:
+    CoreLocalCounter() = default;
+
+    CoreLocalCounter(const CoreLocalCounter&) = delete;
+    CoreLocalCounter& operator=(const CoreLocalCounter&) = delete;
+
+    void Add(uint64_t n) { slots_.Access()->value.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t Sum() const {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < slots_.Size(); ++i) {
+            sum += slots_.AccessAt(i)->value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    // 取出并清零
+    uint64_t Exchange() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < slots_.Size(); ++i) {
+            sum += slots_.AccessAt(i)->value.exchange(0, std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<uint64_t> value = {0};
+    };
+
+    CoreLocalArray<Slot> slots_;
+};
+
+}  // namespace monitor
+}  // namespace sharkstore
@@ -0,0 +1,141 @@
+#include "core_local_histogram.h"
+
+#include <math.h>
+#include <limits>
+
+namespace sharkstore {
+namespace monitor {
+
+constexpr uint32_t LogLinearBuckets::kSubBucketBits;
+constexpr uint32_t LogLinearBuckets::kSubBucketCount;
+constexpr uint32_t LogLinearBuckets::kMaxExponent;
+constexpr size_t LogLinearBuckets::kBucketCount;
+
+size_t LogLinearBuckets::Index(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+    auto exp = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+    auto shift = exp - kSubBucketBits;
+    auto sub = (value >> shift) & (kSubBucketCount - 1);
+    size_t index = kSubBucketCount + shift * kSubBucketCount + sub;
+    return index < kBucketCount ? index : kBucketCount - 1;
+}
+
+uint64_t LogLinearBuckets::Lower(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    auto shift = (index - kSubBucketCount) / kSubBucketCount;
+    auto sub = (index - kSubBucketCount) % kSubBucketCount;
+    return (kSubBucketCount + sub) << shift;
+}
+
+uint64_t LogLinearBuckets::Upper(size_t index) {
+    if (index + 1 >= kBucketCount) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return Lower(index + 1) - 1;
+}
+
+void HistogramSnapshot::Subtract(const HistogramSnapshot& base) {
+    if (base.buckets.size() != buckets.size()) return;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] -= base.buckets[i];
+    }
+    num -= base.num;
+    sum -= base.sum;
+}
+
+double HistogramSnapshot::Percentile(double p) const {
+    if (num == 0) return 0;
+
+    double threshold = static_cast<double>(num) * p / 100.0;
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (buckets[b] == 0) continue;
+        auto prev = cumulative;
+        cumulative += buckets[b];
+        if (static_cast<double>(cumulative) >= threshold) {
+            // 桶内线性插值
+            double left = static_cast<double>(LogLinearBuckets::Lower(b));
+            double right = static_cast<double>(
+                b + 1 >= buckets.size() ? LogLinearBuckets::Lower(b) : LogLinearBuckets::Upper(b));
+            double pos = (threshold - static_cast<double>(prev)) / static_cast<double>(buckets[b]);
+            return left + (right - left) * pos;
+        }
+    }
+    return static_cast<double>(Max());
+}
+
+double HistogramSnapshot::Average() const {
+    return num == 0 ? 0 : static_cast<double>(sum) / static_cast<double>(num);
+}
+
+double HistogramSnapshot::StandardDeviation() const {
+    if (num == 0) return 0;
+
+    // 用桶的中点近似
+    auto avg = Average();
+    double variance = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (buckets[b] == 0) continue;
+        double mid = (static_cast<double>(LogLinearBuckets::Lower(b)) +
+                      static_cast<double>(b + 1 >= buckets.size() ? LogLinearBuckets::Lower(b)
+                                                                  : LogLinearBuckets::Upper(b))) / 2;
+        variance += static_cast<double>(buckets[b]) * (mid - avg) * (mid - avg);
+    }
+    return sqrt(variance / static_cast<double>(num));
+}
+
+uint64_t HistogramSnapshot::Max() const {
+    for (size_t b = buckets.size(); b > 0; --b) {
+        if (buckets[b - 1] != 0) {
+            return b == buckets.size() ? LogLinearBuckets::Lower(b - 1)
+                                       : LogLinearBuckets::Upper(b - 1);
+        }
+    }
+    return 0;
+}
+
+void HistogramSnapshot::Data(HistogramData* data) const {
+    data->median = Percentile(50);
+    data->percentile95 = Percentile(95);
+    data->percentile99 = Percentile(99);
+    data->percentile999 = Percentile(99.9);
+    data->average = Average();
+    data->standard_deviation = StandardDeviation();
+    data->max = static_cast<double>(Max());
+}
+
+CoreLocalHistogram::Shard::Shard() {
+    sum.store(0, std::memory_order_relaxed);
+    for (auto& b : buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CoreLocalHistogram::Add(uint64_t value) {
+    auto shard = shards_.Access();
+    shard->buckets[LogLinearBuckets::Index(value)].fetch_add(1, std::memory_order_relaxed);
+    shard->sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void CoreLocalHistogram::Snapshot(HistogramSnapshot* snapshot) const {
+    snapshot->buckets.assign(LogLinearBuckets::kBucketCount, 0);
+    snapshot->num = 0;
+    snapshot->sum = 0;
+    for (size_t i = 0; i < shards_.Size(); ++i) {
+        auto shard = shards_.AccessAt(i);
+        for (size_t b = 0; b < LogLinearBuckets::kBucketCount; ++b) {
+            snapshot->buckets[b] += shard->buckets[b].load(std::memory_order_relaxed);
+        }
+        snapshot->sum += shard->sum.load(std::memory_order_relaxed);
+    }
+    for (auto n : snapshot->buckets) {
+        snapshot->num += n;
+    }
+}
+
+}  // namespace monitor
+}  // namespace sharkstore
@@ -0,0 +1,74 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "core_local.h"
+#include "histogram.h"
+
+namespace sharkstore {
+namespace monitor {
+
+// 对数线性分桶(类似HdrHistogram): 小于32的值每个值一个桶，
+// 之后每个2的幂区间等分成32个桶，相对误差不超过1/32
+struct LogLinearBuckets {
+    static constexpr uint32_t kSubBucketBits = 5;
+    static constexpr uint32_t kSubBucketCount = 1U << kSubBucketBits;
+    // 覆盖到2^36，更大的值都计入最后一个桶
+    static constexpr uint32_t kMaxExponent = 36;
+    static constexpr size_t kBucketCount =
+        kSubBucketCount * (kMaxExponent - kSubBucketBits + 1);
+
+    static size_t Index(uint64_t value);
+    // 桶的范围 [Lower, Upper]
+    static uint64_t Lower(size_t index);
+    static uint64_t Upper(size_t index);
+};
+
+// 合并后的直方图，只在读取时构造
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t num = 0;
+    uint64_t sum = 0;
+
+    bool Empty() const { return num == 0; }
+
+    // 减去之前的快照，得到两次快照之间的分布
+    void Subtract(const HistogramSnapshot& base);
+
+    double Percentile(double p) const;
+    double Average() const;
+    double StandardDeviation() const;
+    // 最大值所在桶的上界
+    uint64_t Max() const;
+
+    void Data(HistogramData* data) const;
+};
+
+// 按cpu分片的直方图，Add只更新当前cpu分片上的两个计数，没有跨核竞争
+// 所有值都是启动以来的累计值，按周期统计时由调用者减去上次的快照
+class CoreLocalHistogram {
+public:
+    CoreLocalHistogram() = default;
+
+    CoreLocalHistogram(const CoreLocalHistogram&) = delete;
+    CoreLocalHistogram& operator=(const CoreLocalHistogram&) = delete;
+
+    void Add(uint64_t value);
+
+    void Snapshot(HistogramSnapshot* snapshot) const;
+
+private:
+    struct alignas(kCacheLineSize) Shard {
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> buckets[LogLinearBuckets::kBucketCount];
+
+        Shard();
+    };
+
+    CoreLocalArray<Shard> shards_;
+};
+
+}  // namespace monitor
+}  // namespace sharkstore
@@ -27,6 +27,7 @@ struct HistogramData {
     double median = 0.0;
     double percentile95 = 0.0;
     double percentile99 = 0.0;
+    double percentile999 = 0.0;
     double average = 0.0;
     double standard_deviation = 0.0;
     // zero-initialize new members since old Statistics::histogramData()
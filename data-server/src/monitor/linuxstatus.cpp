@@ -45,36 +45,40 @@ namespace sharkstore
         }
         bool LinuxStatus::GetCPUInfo(CpuInfo&info)
         {
-            bool bRet = true;
-            std::vector<uint64_t> vltTotalFirst, vltIdleFirst,vUtilization;
-            int num = CPUCurCalc(vltTotalFirst,vltIdleFirst);
-            sleep(1); 
-
-            std::vector<uint64_t> vltTotalSecond, vltIdleSecond;
-            int nCores = CPUCurCalc(vltTotalSecond, vltIdleSecond);
-            for(int i = 0; i < nCores; i++)
+            uint64_t total1 = 0, idle1 = 0, total2 = 0, idle2 = 0;
+            uint32_t count = 0;
+            if (!this->GetTotalCPU(&total1, &idle1, &count))
             {
-                double divisor = (vltIdleSecond[i] - vltIdleFirst[i]) * 1.0;
-                double dividend = (vltTotalSecond[i] - vltTotalFirst[i]) * 1.0;
-
-                info.Rate  = 0.0;
-                if (dividend <= 0 || divisor <= 0)
-                {
-                    info.Rate = 0.0;
-                    return false;
-                }
-
-                double dvalue = dividend - divisor;
-                if (dvalue <= 0)
+                return false;
+            }
+            //第一次没有上次的值可以比较
+            if (last_total_ == 0)
+            {
+                usleep(DELAY_TIME);
+                if (!this->GetTotalCPU(&total2, &idle2, &count))
                 {
-                    info.Rate = 0;
                     return false;
                 }
+            }
+            else
+            {
+                total2 = total1;
+                idle2 = idle1;
+                total1 = last_total_;
+                idle1 = last_idle_;
+            }
+            last_total_ = total2;
+            last_idle_ = idle2;
 
-                info.Rate = dvalue/dividend;
-            } 
-
-            return bRet;
+            info.CpuCount = count;
+            info.Rate = 0.0;
+            if (total2 <= total1 || idle2 - idle1 > total2 - total1)
+            {
+                return false;
+            }
+            info.Used = (total2 - total1) - (idle2 - idle1);
+            info.Rate = info.Used * 1.0 / (total2 - total1);
+            return true;
         }
         bool LinuxStatus::GetMemInfo(MemInfo&info)
         {
@@ -264,54 +268,6 @@ namespace sharkstore
             }
         }
 
-        void LinuxStatus::LinesFrom(FILE *pFile, std::vector<std::string> &vResult)
-        {
-            vResult.clear();
-            char szLine[READ_CHARS_LENGTH] = { 0 };
-            while(fgets(szLine, READ_CHARS_LENGTH, pFile) != NULL)
-            {
-                int nLength = strlen(szLine);
-                if(szLine[nLength - 1] == '\n')
-                {
-                    szLine[nLength - 1] = '\0';
-                }
-                
-                vResult.push_back(szLine);
-            }
-        }
-
-        int LinuxStatus::ExecCmd(const char *szCmd, std::vector<std::string> &vResult)
-        {    
-            FILE *pCmd = popen(szCmd, "r");
-            if(pCmd == NULL) 
-            {
-                    return -1;
-            } 
-            LinesFrom(pCmd, vResult);
-
-            return pclose(pCmd);
-        }
-
-        int LinuxStatus::CPUCurCalc(std::vector<uint64_t> &vltTotal, std::vector<uint64_t> &vltIdle)
-        {
-            return 32;
-            vltTotal.clear();
-            vltIdle.clear();    
-            // /proc/stat | grep cpu | awk -F ' ' '{ print $2 + $3 + $4 + $5 + $6 + $7 + $8 + $9, $5 }'
-            std::vector<std::string> vResult;
-            ExecCmd("cat /proc/stat | grep cpu | awk -F ' ' '{ print $2 + $3 + $4 + $5 + $6 + $7 + $8 + $9, $5 }'", vResult);
-                
-            int nCores = vResult.size();
-            for(int i = 0; i < nCores; i++)
-            {
-                uint64_t ltTotal, ltIdle;
-                sscanf(vResult[i].c_str(), "%ld %ld ", &ltTotal, &ltIdle);
-                vltTotal.push_back(ltTotal);
-                vltIdle.push_back(ltIdle);
-            }
-
-            return nCores;
-        }
         bool LinuxStatus::GetMemProcInfo(MemInfo &info,const pid_t pid)
         {
             bool bRet = true;
@@ -330,21 +286,34 @@ namespace sharkstore
         }
         bool LinuxStatus::GetCPUInfo(CpuInfo &info,const pid_t  id)
         {
-            bool bRet = true;
-            unsigned int total1,total2;
-            unsigned int proc1,proc2;
-            total1 = this->GetTotalCPU();
-            proc1 = this->GetProcCPU(id);
-            usleep(DELAY_TIME);//延迟500毫秒
-            total2 = this->GetTotalCPU();
-            proc2 = this->GetProcCPU(id);
-            float pcpu = 100.0*(proc2 - proc1)/(total2 - total1);
-
-            info.Rate = pcpu;
-            info.Used = proc2 - proc1;
+            uint64_t total1 = 0, total2 = 0, idle = 0;
+            uint64_t proc1 = 0, proc2 = 0;
+            uint32_t count = 0;
+            if (id == proc_pid_ && last_proc_total_ > 0)
+            {
+                total1 = last_proc_total_;
+                proc1 = last_proc_;
+            }
+            else
+            {
+                if (!this->GetTotalCPU(&total1, &idle, &count) || !this->GetProcCPU(id, &proc1))
+                {
+                    return false;
+                }
+                usleep(DELAY_TIME);//第一次延迟500毫秒
+            }
+            if (!this->GetTotalCPU(&total2, &idle, &count) || !this->GetProcCPU(id, &proc2))
+            {
+                return false;
+            }
+            last_proc_total_ = total2;
+            last_proc_ = proc2;
+
+            info.Used = proc2 > proc1 ? proc2 - proc1 : 0;
+            info.Rate = total2 > total1 ? 100.0 * info.Used / (total2 - total1) : 0.0;
             info.CpuCount = this->GetCpuNum();
-            
-            return bRet;
+
+            return true;
         }
         uint64_t LinuxStatus::GetMemUse(const pid_t pid,uint32_t &threadCount)
         {
@@ -501,62 +470,40 @@ namespace sharkstore
 
             return pTemp;
         }
-        uint32_t LinuxStatus::GetProcCPU(const pid_t pid)
+        bool LinuxStatus::GetProcCPU(const pid_t pid, uint64_t *used)
         {
-            uint32_t used = 0;
-            char file[64] = {0};
-            ProcessCpuT t;
-        
-            FILE *fd = NULL;       
-            char lineBuff[MAX_FILE_NAME * 4] = {0};   
-            sprintf(file,"/proc/%d/stat",pid);
-                                                                                                        
-            fd = fopen (file, "r"); 
-            if (NULL == fd)
+            //文件打开之后保留，每次从头读取
+            if (pid != proc_pid_ || !proc_stat_.Valid())
             {
-                return 0;
+                proc_pid_ = pid;
+                last_proc_total_ = 0;
+                if (!proc_stat_.Open("/proc/" + std::to_string(pid) + "/stat"))
+                {
+                    return false;
+                }
             }
 
-            char * end = fgets (lineBuff, sizeof(lineBuff), fd); 
-            if (NULL == end)
+            std::string content, name;
+            if (!proc_stat_.Read(&content))
             {
-                return 0;
+                proc_stat_.Close();
+                return false;
             }
-
-            sscanf(lineBuff,"%u",&t.Pid);//取得第一项
-            const char* data = GetFiled(lineBuff,PROCESS_ITEM);//第14项 起始指针
-            sscanf(data,"%u %u %u %u",&t.Utime,&t.Stime,&t.Cutime,&t.Cstime);//格式化14,15,16,17--比整体少了一些项
-
-            fclose(fd);    
-            used = t.Utime + t.Stime + t.Cutime + t.Cstime;
-
-            return used;
+            return ProcSampler::ParseTaskStat(content, &name, used);
         }
-        uint32_t LinuxStatus::GetTotalCPU()
+        bool LinuxStatus::GetTotalCPU(uint64_t *total, uint64_t *idle, uint32_t *count)
         {
-            uint32_t total = 0;
-            FILE * fd = NULL;         
-            char buff[1024] = {0};  
-            TotalCpuT t;
-                                                                                                                    
-            fd = fopen ("/proc/stat", "r"); 
-            if (NULL == fd)
+            if (!sys_stat_.Valid() && !sys_stat_.Open("/proc/stat"))
             {
-                return 0;
+                return false;
             }
-            char * end = fgets (buff, sizeof(buff), fd); 
-            if (NULL == end)
+
+            std::string content;
+            if (!sys_stat_.Read(&content))
             {
-                return 0;
+                return false;
             }
-        
-            char name[16];
-            sscanf (buff, "%s %u %u %u %u", name, &t.User, &t.Nice,&t.System, &t.Idle);
-
-            fclose(fd);     //关闭文件fd
-            total = t.User + t.Nice + t.System + t.Idle;
-
-            return total;
+            return ProcSampler::ParseSystemStat(content, total, idle, count);
         }
         char * LinuxStatus::GetName(char * name, char * p)
         {
@@ -682,30 +629,15 @@ namespace sharkstore
 
             return 0;
         }
-        uint32_t LinuxStatus::GetCpuNum() 
-        {  
-            return 32;
-            char buf[16] = {0};  
-            int num;  
-            FILE* fp = popen("cat /proc/cpuinfo |grep processor|wc -l", "r");  
-            if(fp) 
-            {                                                                                                                                                                               
-                int ret = fread(buf, 1, sizeof(buf) - 1, fp);  
-                // TODO: check return value
-                (void)ret;
-                pclose(fp);  
-            }
-            else
+        uint32_t LinuxStatus::GetCpuNum()
+        {
+            long num = sysconf(_SC_NPROCESSORS_ONLN);
+            if (num <= 0)
             {
-                return 0;
-            }     
-            sscanf(buf,"%d",&num);  
-            if(num <= 0)
-            {   
-                num = 1;  
-            }     
-            return (uint32_t)num;  
-        } 
+                num = 1;
+            }
+            return (uint32_t)num;
+        }
         uint32_t LinuxStatus::GetFileCount(pid_t pid)
         {
             DIR *dir = NULL;
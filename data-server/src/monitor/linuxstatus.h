@@ -1,5 +1,6 @@
 #pragma once
 #include "syscommon.h"
+#include "proc_sampler.h"
 #include <string>
 #include <vector>
 #include <sys/types.h>
@@ -28,16 +29,12 @@ private:
     bool GetDiskBlockSize(std::vector<HardDiskInfo> & vecSize);
     void DiskInfoUinque(std::vector<HardDiskInfo> & vecSize);
 
-    void LinesFrom(FILE *pFile, std::vector<std::string> &vResult);
-    int ExecCmd(const char *szCmd, std::vector<std::string> &vResult);
-    int CPUCurCalc(std::vector<uint64_t> &vltTotal, std::vector<uint64_t> &vltIdle);
-
     const char *GetFiled(const char *pData,int pos);
     uint64_t GetMemUse(const pid_t pid,uint32_t &count);
     uint64_t GetTotalMem(MemInfo &info);
 
-    uint32_t  GetProcCPU(const pid_t pid);
-    uint32_t  GetTotalCPU();
+    bool GetProcCPU(const pid_t pid, uint64_t *used);
+    bool GetTotalCPU(uint64_t *total, uint64_t *idle, uint32_t *count);
 
     char * GetName(char * name, char * p);
     uint32_t GetCpuNum();
@@ -52,6 +49,15 @@ public:
 private:
     std::vector<HardDiskInfo> vecSize_;
     DiskRwStatus drs_;
+
+    // /proc/stat和进程的stat文件一直打开，和上次的值比较计算使用率
+    ProcFile sys_stat_;
+    ProcFile proc_stat_;
+    pid_t proc_pid_ = 0;
+    uint64_t last_total_ = 0;
+    uint64_t last_idle_ = 0;
+    uint64_t last_proc_total_ = 0;
+    uint64_t last_proc_ = 0;
 };
 
 }
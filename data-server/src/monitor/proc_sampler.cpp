@@ -0,0 +1,265 @@
+#include "proc_sampler.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace sharkstore {
+namespace monitor {
+
+ProcFile::~ProcFile() { Close(); }
+
+ProcFile::ProcFile(ProcFile&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        fd_ = other.fd_;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+bool ProcFile::Open(const std::string& path) {
+    Close();
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+}
+
+void ProcFile::Close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool ProcFile::Read(std::string* content) {
+    if (fd_ < 0) return false;
+
+    content->clear();
+    char buf[4096];
+    off_t offset = 0;
+    while (true) {
+        auto n = ::pread(fd_, buf, sizeof(buf), offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) break;
+        content->append(buf, static_cast<size_t>(n));
+        offset += n;
+    }
+    return !content->empty();
+}
+
+static long clockTicks() {
+    auto ticks = ::sysconf(_SC_CLK_TCK);
+    return ticks > 0 ? ticks : 100;
+}
+
+ProcSampler::ProcSampler() : clock_ticks_(clockTicks()) {
+    system_stat_.Open("/proc/stat");
+    self_stat_.Open("/proc/self/stat");
+    task_dir_ = ::opendir("/proc/self/task");
+}
+
+ProcSampler::~ProcSampler() {
+    if (task_dir_ != nullptr) {
+        ::closedir(task_dir_);
+    }
+}
+
+bool ProcSampler::Sample(CpuSample* sample) {
+    std::string content;
+    uint64_t total = 0, idle = 0, proc = 0;
+    uint32_t cpu_count = 0;
+    if (!system_stat_.Read(&content) ||
+        !ParseSystemStat(content, &total, &idle, &cpu_count)) {
+        return false;
+    }
+    std::string name;
+    if (!self_stat_.Read(&content) || !ParseTaskStat(content, &name, &proc)) {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - last_time_).count();
+    bool has_base = has_base_ && elapsed_ms > 0;
+
+    CpuSample result;
+    result.cpu_count = cpu_count;
+    result.interval_ms = elapsed_ms;
+    if (has_base) {
+        auto total_delta = total - last_total_;
+        auto idle_delta = idle - last_idle_;
+        if (total > last_total_ && idle_delta <= total_delta) {
+            result.system_usage = 100.0 * (total_delta - idle_delta) / total_delta;
+        }
+        if (proc > last_proc_) {
+            result.process_usage =
+                100.0 * 1000 * (proc - last_proc_) / clock_ticks_ / elapsed_ms;
+        }
+    }
+
+    std::map<std::string, ThreadGroupCpu> groups;
+    // 每个jiffy对应的使用率
+    double percent_per_tick = has_base ? 100.0 * 1000 / clock_ticks_ / elapsed_ms : 0;
+    sampleTasks(percent_per_tick, has_base ? &groups : nullptr);
+    for (auto& g : groups) {
+        g.second.name = g.first;
+        result.groups.push_back(std::move(g.second));
+    }
+
+    has_base_ = true;
+    last_time_ = now;
+    last_total_ = total;
+    last_idle_ = idle;
+    last_proc_ = proc;
+
+    if (!has_base) return false;
+
+    if (sample != nullptr) {
+        *sample = result;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    last_ = std::move(result);
+    has_last_ = true;
+    return true;
+}
+
+bool ProcSampler::Last(CpuSample* sample) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!has_last_) return false;
+    *sample = last_;
+    return true;
+}
+
+void ProcSampler::sampleTasks(double percent_per_tick,
+                              std::map<std::string, ThreadGroupCpu>* groups) {
+    if (task_dir_ == nullptr) return;
+
+    for (auto& t : tasks_) {
+        t.second.seen = false;
+    }
+
+    // 每次重新列出线程，新线程打开一次stat文件之后一直保留
+    ::rewinddir(task_dir_);
+    std::string content, name;
+    struct dirent* ent = nullptr;
+    while ((ent = ::readdir(task_dir_)) != nullptr) {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+        int tid = ::atoi(ent->d_name);
+
+        bool is_new = false;
+        auto it = tasks_.find(tid);
+        if (it == tasks_.end()) {
+            it = tasks_.emplace(tid, Task()).first;
+            is_new = true;
+        }
+        auto& task = it->second;
+        uint64_t ticks = 0;
+        bool ok = task.file.Valid() && task.file.Read(&content) &&
+                  ParseTaskStat(content, &name, &ticks);
+        if (!ok) {
+            // 新线程，或者线程id被重用了原来的文件已经读不了
+            is_new = true;
+            ok = task.file.Open("/proc/self/task/" + std::string(ent->d_name) + "/stat") &&
+                 task.file.Read(&content) && ParseTaskStat(content, &name, &ticks);
+        }
+        if (!ok) continue;
+
+        // 两次采样之间新建的线程，全部时间都算在这段时间里
+        uint64_t delta = (!is_new && ticks >= task.ticks) ? ticks - task.ticks : ticks;
+        task.ticks = ticks;
+        task.seen = true;
+
+        if (groups != nullptr) {
+            auto usage = delta * percent_per_tick;
+            auto& g = (*groups)[GroupName(name)];
+            ++g.threads;
+            g.usage += usage;
+            if (usage > g.max) g.max = usage;
+        }
+    }
+
+    // 已经退出的线程
+    for (auto it = tasks_.begin(); it != tasks_.end();) {
+        if (it->second.seen) {
+            ++it;
+        } else {
+            it = tasks_.erase(it);
+        }
+    }
+}
+
+bool ProcSampler::ParseSystemStat(const std::string& content, uint64_t* total, uint64_t* idle,
+                                  uint32_t* cpu_count) {
+    *total = 0;
+    *idle = 0;
+    *cpu_count = 0;
+    bool found = false;
+    size_t pos = 0;
+    while (pos < content.size()) {
+        auto end = content.find('\n', pos);
+        if (end == std::string::npos) end = content.size();
+        const char* line = content.c_str() + pos;
+        if (strncmp(line, "cpu", 3) == 0) {
+            if (line[3] == ' ') {
+                // user nice system idle iowait irq softirq steal
+                uint64_t v[8] = {0};
+                int n = sscanf(line + 3, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+                               " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                               &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+                if (n < 4) return false;
+                for (int i = 0; i < n; ++i) {
+                    *total += v[i];
+                }
+                *idle = v[3] + (n > 4 ? v[4] : 0);
+                found = true;
+            } else if (line[3] >= '0' && line[3] <= '9') {
+                ++(*cpu_count);
+            }
+        }
+        pos = end + 1;
+    }
+    return found;
+}
+
+bool ProcSampler::ParseTaskStat(const std::string& content, std::string* name,
+                                uint64_t* ticks) {
+    // pid (comm) state ppid ...，comm里可能有空格和括号
+    auto lpos = content.find('(');
+    auto rpos = content.rfind(')');
+    if (lpos == std::string::npos || rpos == std::string::npos || rpos < lpos) {
+        return false;
+    }
+    name->assign(content, lpos + 1, rpos - lpos - 1);
+
+    // 右括号之后从第3个字段state开始，utime和stime是第14、15个字段
+    const char* p = content.c_str() + rpos + 1;
+    for (int field = 3; field < 14; ++field) {
+        while (*p == ' ') ++p;
+        while (*p != ' ' && *p != '\0') ++p;
+        if (*p == '\0') return false;
+    }
+    char* end = nullptr;
+    uint64_t utime = strtoull(p, &end, 10);
+    if (end == p) return false;
+    p = end;
+    uint64_t stime = strtoull(p, &end, 10);
+    if (end == p) return false;
+    *ticks = utime + stime;
+    return true;
+}
+
+std::string ProcSampler::GroupName(const std::string& thread_name) {
+    auto pos = thread_name.find(':');
+    return pos == std::string::npos ? thread_name : thread_name.substr(0, pos);
+}
+
+}  // namespace monitor
+}  // namespace sharkstore
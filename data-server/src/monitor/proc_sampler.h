@@ -0,0 +1,110 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+namespace sharkstore {
+namespace monitor {
+
+// 一直打开的/proc文件，每次从头pread读取，不用重复open
+class ProcFile {
+public:
+    ProcFile() = default;
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+    ProcFile(ProcFile&& other) noexcept;
+    ProcFile& operator=(ProcFile&& other) noexcept;
+
+    bool Open(const std::string& path);
+    bool Valid() const { return fd_ >= 0; }
+    void Close();
+
+    // 读取整个文件的内容，文件对应的线程退出之后会失败
+    bool Read(std::string* content);
+
+private:
+    int fd_ = -1;
+};
+
+// 同一类线程的CPU使用率，百分比，100表示占满一个核
+struct ThreadGroupCpu {
+    std::string name;
+    uint32_t threads = 0;
+    double usage = 0;   // 所有线程合计
+    double max = 0;     // 最忙的一个线程
+};
+
+struct CpuSample {
+    uint32_t cpu_count = 0;
+    double system_usage = 0;   // 整机，0~100
+    double process_usage = 0;  // 本进程，100表示占满一个核
+    int64_t interval_ms = 0;   // 和上次采样的间隔
+    std::vector<ThreadGroupCpu> groups;  // 按名字排序
+};
+
+// 采集整机、本进程和每个线程的CPU使用率
+// /proc/stat、/proc/self/stat以及每个线程的stat文件打开之后一直保留
+// 线程按名字中':'之前的部分分组(fast_worker:N、raft-apply:N等)
+// Sample只在一个线程里调用，Last可以在其他线程里读
+class ProcSampler {
+public:
+    ProcSampler();
+    ~ProcSampler();
+
+    ProcSampler(const ProcSampler&) = delete;
+    ProcSampler& operator=(const ProcSampler&) = delete;
+
+    // 计算和上次采样之间的使用率，第一次调用只记录基准，返回false
+    bool Sample(CpuSample* sample = nullptr);
+
+    // 最近一次Sample的结果，还没有结果返回false
+    bool Last(CpuSample* sample) const;
+
+public:
+    // 解析/proc/stat，返回所有cpu合计的时间和空闲时间(jiffies)以及cpu个数
+    static bool ParseSystemStat(const std::string& content, uint64_t* total, uint64_t* idle,
+                                uint32_t* cpu_count);
+    // 解析/proc/<pid>/stat，返回线程名和utime+stime(jiffies)
+    static bool ParseTaskStat(const std::string& content, std::string* name, uint64_t* ticks);
+    // 线程名中':'之前的部分
+    static std::string GroupName(const std::string& thread_name);
+
+private:
+    struct Task {
+        ProcFile file;
+        uint64_t ticks = 0;
+        bool seen = false;
+    };
+
+    // groups为空时只更新每个线程的基准
+    void sampleTasks(double percent_per_tick, std::map<std::string, ThreadGroupCpu>* groups);
+
+private:
+    const long clock_ticks_ = 100;
+
+    ProcFile system_stat_;
+    ProcFile self_stat_;
+    DIR* task_dir_ = nullptr;
+    std::map<int, Task> tasks_;  // tid -> task
+
+    bool has_base_ = false;
+    std::chrono::steady_clock::time_point last_time_;
+    uint64_t last_total_ = 0;
+    uint64_t last_idle_ = 0;
+    uint64_t last_proc_ = 0;
+
+    mutable std::mutex mu_;
+    bool has_last_ = false;
+    CpuSample last_;
+};
+
+}  // namespace monitor
+}  // namespace sharkstore
@@ -0,0 +1,110 @@
+#include "prometheus.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace sharkstore {
+namespace monitor {
+
+constexpr const char* PrometheusWriter::kContentType;
+
+static void appendValue(std::string* out, double value) {
+    if (isinf(value)) {
+        out->append(value > 0 ? "+Inf" : "-Inf");
+    } else if (isnan(value)) {
+        out->append("NaN");
+    } else {
+        char buf[32] = {'\0'};
+        snprintf(buf, sizeof(buf), "%.15g", value);
+        out->append(buf);
+    }
+}
+
+static void appendEscaped(std::string* out, const std::string& value, bool quote) {
+    for (auto c : value) {
+        switch (c) {
+            case '\\':
+                out->append("\\\\");
+                break;
+            case '\n':
+                out->append("\\n");
+                break;
+            case '"':
+                if (quote) {
+                    out->append("\\\"");
+                } else {
+                    out->push_back(c);
+                }
+                break;
+            default:
+                out->push_back(c);
+        }
+    }
+}
+
+void PrometheusWriter::family(const std::string& name, const std::string& help,
+                              const char* type) {
+    if (name == last_family_) return;
+
+    last_family_ = name;
+    text_.append("# HELP ").append(name).push_back(' ');
+    appendEscaped(&text_, help, false);
+    text_.append("\n# TYPE ").append(name).push_back(' ');
+    text_.append(type).push_back('\n');
+}
+
+void PrometheusWriter::sample(const std::string& name, const Labels& labels, double value,
+                              const char* le) {
+    text_.append(name);
+    if (!labels.empty() || le != nullptr) {
+        text_.push_back('{');
+        bool first = true;
+        for (const auto& label : labels) {
+            if (!first) text_.push_back(',');
+            first = false;
+            text_.append(label.first).append("=\"");
+            appendEscaped(&text_, label.second, true);
+            text_.push_back('"');
+        }
+        if (le != nullptr) {
+            if (!first) text_.push_back(',');
+            text_.append("le=\"").append(le).push_back('"');
+        }
+        text_.push_back('}');
+    }
+    text_.push_back(' ');
+    appendValue(&text_, value);
+    text_.push_back('\n');
+}
+
+void PrometheusWriter::Counter(const std::string& name, const std::string& help, double value,
+                               const Labels& labels) {
+    family(name, help, "counter");
+    sample(name, labels, value);
+}
+
+void PrometheusWriter::Gauge(const std::string& name, const std::string& help, double value,
+                             const Labels& labels) {
+    family(name, help, "gauge");
+    sample(name, labels, value);
+}
+
+void PrometheusWriter::Histogram(const std::string& name, const std::string& help,
+                                 const std::vector<double>& bounds,
+                                 const std::vector<uint64_t>& counts, uint64_t count,
+                                 double sum, const Labels& labels) {
+    family(name, help, "histogram");
+
+    const auto bucket_name = name + "_bucket";
+    for (size_t i = 0; i < bounds.size() && i < counts.size(); ++i) {
+        std::string le;
+        appendValue(&le, bounds[i]);
+        sample(bucket_name, labels, static_cast<double>(counts[i]), le.c_str());
+    }
+    sample(bucket_name, labels, static_cast<double>(count), "+Inf");
+    sample(name + "_sum", labels, sum);
+    sample(name + "_count", labels, static_cast<double>(count));
+}
+
+}  // namespace monitor
+}  // namespace sharkstore
@@ -0,0 +1,48 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sharkstore {
+namespace monitor {
+
+// Prometheus文本格式(version 0.0.4)
+// 同一个指标的多个label需要连续写入，HELP和TYPE只在第一次输出
+class PrometheusWriter {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    static constexpr const char* kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+    PrometheusWriter() = default;
+
+    PrometheusWriter(const PrometheusWriter&) = delete;
+    PrometheusWriter& operator=(const PrometheusWriter&) = delete;
+
+    void Counter(const std::string& name, const std::string& help, double value,
+                 const Labels& labels = Labels());
+
+    void Gauge(const std::string& name, const std::string& help, double value,
+               const Labels& labels = Labels());
+
+    // bounds升序，counts[i]为<=bounds[i]的累计个数
+    void Histogram(const std::string& name, const std::string& help,
+                   const std::vector<double>& bounds, const std::vector<uint64_t>& counts,
+                   uint64_t count, double sum, const Labels& labels = Labels());
+
+    const std::string& Text() const { return text_; }
+
+private:
+    void family(const std::string& name, const std::string& help, const char* type);
+    void sample(const std::string& name, const Labels& labels, double value,
+                const char* le = nullptr);
+
+private:
+    std::string text_;
+    std::string last_family_;
+};
+
+}  // namespace monitor
+}  // namespace sharkstore
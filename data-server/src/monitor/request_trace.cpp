@@ -0,0 +1,124 @@
+#include "request_trace.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace sharkstore {
+namespace monitor {
+
+constexpr size_t TraceCollector::kSlowTraceCapacity;
+
+TraceCollector g_tracer;
+
+const char* TraceStageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::kRecv:
+            return "recv";
+        case TraceStage::kDequeue:
+            return "queue";
+        case TraceStage::kPropose:
+            return "prepare";
+        case TraceStage::kRaftStep:
+            return "raft_queue";
+        case TraceStage::kRaftPersist:
+            return "persist";
+        case TraceStage::kRaftCommit:
+            return "replicate";
+        case TraceStage::kApply:
+            return "apply_queue";
+        case TraceStage::kReply:
+            return "execute";
+        case TraceStage::kSent:
+            return "send";
+        default:
+            return "<unknown>";
+    }
+}
+
+int64_t RequestTrace::Total() const {
+    auto begin = Get(TraceStage::kRecv);
+    if (begin == 0) return 0;
+    for (auto i = kTraceStageNum; i > 0; --i) {
+        if (times[i - 1] != 0) {
+            return times[i - 1] - begin;
+        }
+    }
+    return 0;
+}
+
+void RequestTrace::Spans(int64_t (&spans)[kTraceStageNum]) const {
+    int64_t prev = Get(TraceStage::kRecv);
+    for (uint32_t i = 0; i < kTraceStageNum; ++i) {
+        auto t = times[i];
+        if (i == 0 || t == 0 || prev == 0) {
+            spans[i] = -1;
+            continue;
+        }
+        spans[i] = t > prev ? t - prev : 0;
+        prev = t;
+    }
+}
+
+SlowTraceRing::SlowTraceRing(size_t capacity)
+    : capacity_(capacity), slots_(new Slot[capacity]) {}
+
+void SlowTraceRing::Push(const RequestTrace& trace) {
+    auto& slot = slots_[next_.fetch_add(1, std::memory_order_relaxed) % capacity_];
+    auto seq = slot.seq.load(std::memory_order_relaxed);
+    // 其他线程正在写这个槽位(已经绕了一圈)，丢弃
+    if ((seq & 1) != 0 ||
+        !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+        return;
+    }
+    memcpy(&slot.trace, &trace, sizeof(trace));
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void SlowTraceRing::Dump(std::vector<RequestTrace>* traces) const {
+    traces->clear();
+    for (size_t i = 0; i < capacity_; ++i) {
+        auto& slot = slots_[i];
+        auto seq = slot.seq.load(std::memory_order_acquire);
+        if (seq == 0 || (seq & 1) != 0) continue;
+
+        RequestTrace trace;
+        memcpy(&trace, &slot.trace, sizeof(trace));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == seq) {
+            traces->push_back(trace);
+        }
+    }
+    std::sort(traces->begin(), traces->end(),
+              [](const RequestTrace& a, const RequestTrace& b) { return a.Total() > b.Total(); });
+}
+
+TraceCollector::TraceCollector() : slow_(kSlowTraceCapacity) {}
+
+void TraceCollector::Finish(const RequestTrace& trace) {
+    if (trace.Get(TraceStage::kRecv) == 0) return;
+
+    int64_t spans[kTraceStageNum];
+    trace.Spans(spans);
+    for (uint32_t i = 0; i < kTraceStageNum; ++i) {
+        if (spans[i] >= 0) {
+            stages_[i].Add(static_cast<uint64_t>(spans[i]));
+        }
+    }
+
+    auto threshold = slow_threshold_.load(std::memory_order_relaxed);
+    if (threshold > 0 && trace.Total() >= threshold) {
+        slow_.Push(trace);
+    }
+}
+
+void TraceCollector::RecordSent(int64_t elapsed) {
+    if (elapsed < 0) elapsed = 0;
+    stages_[static_cast<uint32_t>(TraceStage::kSent)].Add(static_cast<uint64_t>(elapsed));
+}
+
+void TraceCollector::StageSnapshot(TraceStage stage, HistogramSnapshot* snapshot) const {
+    stages_[static_cast<uint32_t>(stage)].Snapshot(snapshot);
+}
+
+}  // namespace monitor
+}  // namespace sharkstore
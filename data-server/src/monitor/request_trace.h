@@ -0,0 +1,107 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "core_local_histogram.h"
+
+namespace sharkstore {
+namespace monitor {
+
+// 请求处理过程中的各个阶段，按先后顺序
+// 每个阶段对应的耗时是从上一个有记录的阶段到该阶段的时间
+enum class TraceStage : uint32_t {
+    kRecv = 0,      // 收到请求
+    kDequeue,       // worker线程取出(排队)
+    kPropose,       // 提交给raft(解析、执行前检查)
+    kRaftStep,      // raft consensus线程处理(raft队列)
+    kRaftPersist,   // leader日志写入完成(持久化)
+    kRaftCommit,    // 多数派复制完成(复制)
+    kApply,         // 开始应用(apply队列)
+    kReply,         // 回应交给网络层(执行或应用)
+    kSent,          // 网络层发送完成(发送)，不在单个请求的trace里
+    kMax,
+};
+
+static constexpr uint32_t kTraceStageNum = static_cast<uint32_t>(TraceStage::kMax);
+
+// 到达该阶段的那一段耗时的名字
+const char* TraceStageName(TraceStage stage);
+
+// 单个请求的trace，跟随ProtoMessage传递，需要保持可以直接拷贝
+struct RequestTrace {
+    uint64_t trace_id = 0;
+    uint64_t range_id = 0;
+    int64_t msg_id = 0;
+    uint32_t func_id = 0;
+    int64_t times[kTraceStageNum] = {0};  // us，0表示没有经过该阶段
+
+    void Set(TraceStage stage, int64_t time) { times[static_cast<uint32_t>(stage)] = time; }
+    int64_t Get(TraceStage stage) const { return times[static_cast<uint32_t>(stage)]; }
+
+    // 从收到请求到最后一个有记录的阶段
+    int64_t Total() const;
+
+    // 每个阶段的耗时，没有经过的阶段为-1
+    void Spans(int64_t (&spans)[kTraceStageNum]) const;
+};
+
+// 慢请求的环形缓冲区，写入不加锁，写满后覆盖最早的
+// 每个槽位用seqlock保护，读取时版本号变化的槽位直接跳过
+class SlowTraceRing {
+public:
+    explicit SlowTraceRing(size_t capacity);
+
+    SlowTraceRing(const SlowTraceRing&) = delete;
+    SlowTraceRing& operator=(const SlowTraceRing&) = delete;
+
+    void Push(const RequestTrace& trace);
+
+    // 按耗时从大到小
+    void Dump(std::vector<RequestTrace>* traces) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq = {0};  // 奇数表示正在写
+        RequestTrace trace;
+    };
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> next_ = {0};
+};
+
+// 汇总各阶段耗时，保留超过阈值的慢请求
+class TraceCollector {
+public:
+    static constexpr size_t kSlowTraceCapacity = 256;
+
+    TraceCollector();
+
+    TraceCollector(const TraceCollector&) = delete;
+    TraceCollector& operator=(const TraceCollector&) = delete;
+
+    // 0: 不保留慢请求
+    void SetSlowThreshold(int64_t usecs) { slow_threshold_ = usecs; }
+    int64_t SlowThreshold() const { return slow_threshold_; }
+
+    // 请求回应时调用
+    void Finish(const RequestTrace& trace);
+    // 网络层发送完成时调用，elapsed为回应交给网络层到发送完成的时间
+    void RecordSent(int64_t elapsed);
+
+    void StageSnapshot(TraceStage stage, HistogramSnapshot* snapshot) const;
+    void DumpSlow(std::vector<RequestTrace>* traces) const { slow_.Dump(traces); }
+
+private:
+    CoreLocalHistogram stages_[kTraceStageNum];
+    std::atomic<int64_t> slow_threshold_ = {0};
+    SlowTraceRing slow_;
+};
+
+extern TraceCollector g_tracer;
+
+}  // namespace monitor
+}  // namespace sharkstore
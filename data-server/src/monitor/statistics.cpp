@@ -37,14 +37,35 @@ void Statistics::PushTime(HistogramType type, uint64_t time) {
     histograms_[static_cast<uint32_t>(type)].Add(time);
 }
 
+void Statistics::intervalSnapshot(uint32_t index, HistogramSnapshot *snapshot) const {
+    histograms_[index].Snapshot(snapshot);
+    snapshot->Subtract(last_[index]);
+}
+
 void Statistics::GetData(HistogramType type, HistogramData *data) {
     std::lock_guard<std::mutex> lock(aggregate_lock_);
-    histograms_[static_cast<uint32_t>(type)].Data(data);
+    HistogramSnapshot snapshot;
+    intervalSnapshot(static_cast<uint32_t>(type), &snapshot);
+    snapshot.Data(data);
+}
+
+static std::string formatData(HistogramType type, const HistogramSnapshot &snapshot) {
+    char buffer[256] = {'\0'};
+    HistogramData data;
+    snapshot.Data(&data);
+    snprintf(buffer, sizeof(buffer),
+             "%s statistics => count: %" PRIu64
+             "  P50: %f  P95: %f  P99: %f  P999: %f  Max: %f\n",
+             HistogramTypeName(type), snapshot.num, data.median, data.percentile95,
+             data.percentile99, data.percentile999, data.max);
+    return buffer;
 }
 
 std::string Statistics::ToString(HistogramType type) const {
     std::lock_guard<std::mutex> lock(aggregate_lock_);
-    return histograms_[static_cast<uint32_t>(type)].ToString();
+    HistogramSnapshot snapshot;
+    intervalSnapshot(static_cast<uint32_t>(type), &snapshot);
+    return formatData(type, snapshot);
 }
 
 std::string Statistics::ToString() const {
@@ -52,18 +73,10 @@ std::string Statistics::ToString() const {
 
     std::lock_guard<std::mutex> lock(aggregate_lock_);
     for (uint32_t i = 0; i < kHistogramTypeNum; ++i) {
-        auto &h = histograms_[i];
-        if (h.num() == 0) continue;
-
-        char buffer[200] = {'\0'};
-        HistogramData data;
-        h.Data(&data);
-        snprintf(
-                buffer, 200,
-                "%s statistics => count: %" PRIu64 "  P50: %f  P95: %f  P99: %f  Max: %f\n",
-                HistogramTypeName(static_cast<HistogramType>(i)),
-                h.num(), data.median, data.percentile95, data.percentile99, data.max);
-        result.append(buffer);
+        HistogramSnapshot snapshot;
+        intervalSnapshot(i, &snapshot);
+        if (snapshot.Empty()) continue;
+        result.append(formatData(static_cast<HistogramType>(i), snapshot));
     }
 
     return result;
@@ -71,11 +84,37 @@ std::string Statistics::ToString() const {
 
 void Statistics::Reset() {
     std::lock_guard<std::mutex> lock(aggregate_lock_);
-    for (auto &h : histograms_) {
-        h.Clear();
+    for (uint32_t i = 0; i < kHistogramTypeNum; ++i) {
+        histograms_[i].Snapshot(&last_[i]);
     }
 }
 
+void Statistics::GetCumulative(HistogramType type, const std::vector<uint64_t> &bounds,
+                               HistogramBuckets *buckets) const {
+    HistogramSnapshot snapshot;
+    histograms_[static_cast<uint32_t>(type)].Snapshot(&snapshot);
+    CumulativeBuckets(snapshot, bounds, buckets);
+}
+
+void CumulativeBuckets(const HistogramSnapshot &snapshot, const std::vector<uint64_t> &bounds,
+                       HistogramBuckets *buckets) {
+    buckets->counts.assign(bounds.size(), 0);
+
+    size_t pos = 0;
+    for (size_t b = 0; b < snapshot.buckets.size(); ++b) {
+        auto n = snapshot.buckets[b];
+        if (n == 0) continue;
+        auto limit = LogLinearBuckets::Upper(b);
+        while (pos < bounds.size() && bounds[pos] < limit) {
+            ++pos;
+        }
+        for (size_t i = pos; i < bounds.size(); ++i) {
+            buckets->counts[i] += n;
+        }
+    }
+    buckets->count = snapshot.num;
+    buckets->sum = snapshot.sum;
+}
 
 }  // namespace monitor
 }  // namespace sharkstore
@@ -14,7 +14,8 @@
 _Pragma("once");
 
 #include <mutex>
-#include "histogram.h"
+#include <vector>
+#include "core_local_histogram.h"
 
 namespace sharkstore {
 namespace monitor {
@@ -31,19 +32,41 @@ const char *HistogramTypeName(HistogramType type);
 
 static constexpr uint32_t kHistogramTypeNum = static_cast<uint32_t>(HistogramType::kMax);
 
+struct HistogramBuckets {
+    std::vector<uint64_t> counts;  // counts[i]: <= bounds[i]的个数(累加)
+    uint64_t count = 0;
+    uint64_t sum = 0;
+};
+
+// 内部桶的上界不一定和bounds对齐，按不超过bounds[i]的桶统计
+void CumulativeBuckets(const HistogramSnapshot& snapshot, const std::vector<uint64_t>& bounds,
+                       HistogramBuckets* buckets);
+
+// 请求耗时统计，PushTime在每个请求的处理路径上，使用按cpu分片的直方图
+// 按周期输出的数据是当前值减去上次Reset时的快照
 class Statistics {
 public:
     void PushTime(HistogramType type, uint64_t time);
 
+    // 当前周期(上次Reset以来)的数据
     void GetData(HistogramType type, HistogramData *data);
 
     std::string ToString(HistogramType type) const;
     std::string ToString() const;
 
+    // 开始新的统计周期
     void Reset();
 
+    // 启动以来的累计分布，不受Reset影响，用于导出metrics
+    void GetCumulative(HistogramType type, const std::vector<uint64_t>& bounds,
+                       HistogramBuckets* buckets) const;
+
+private:
+    void intervalSnapshot(uint32_t index, HistogramSnapshot *snapshot) const;
+
 private:
-    Histogram histograms_[kHistogramTypeNum];
+    CoreLocalHistogram histograms_[kHistogramTypeNum];
+    HistogramSnapshot last_[kHistogramTypeNum];  // 上次Reset时的快照
     mutable std::mutex aggregate_lock_;
 };
 
@@ -1,6 +1,7 @@
 _Pragma("once");
 
 #include <functional>
+#include <map>
 #include "protocol.h"
 
 namespace sharkstore {
@@ -26,6 +27,22 @@ inline MessagePtr NewMessage() { return std::make_shared<Message>(); }
 
 using Handler = std::function<void(const Context&, const MessagePtr& msg)>;
 
+// 和rpc共用端口的http GET请求(目前只用于metrics)
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    // key是小写的header名
+    std::map<std::string, std::string> headers;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string content_type = "text/plain";
+    std::string body;
+};
+
+using HttpHandler = std::function<void(const Context&, const HttpRequest&, HttpResponse*)>;
+
 }  // namespace net
 }  // namespace dataserver
 }  // namespace sharkstore
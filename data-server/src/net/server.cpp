@@ -66,7 +66,8 @@ void Server::doAccept() {
             FLOG_WARN("[Net] accept max connection limit reached: %lu",
                       opt_.max_connections);
         } else {
-            std::make_shared<Session>(opt_.session_opt, handler_, std::move(socket))
+            std::make_shared<Session>(opt_.session_opt, handler_, http_handler_,
+                                      std::move(socket))
                 ->Start();
         }
 
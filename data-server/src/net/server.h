@@ -26,6 +26,9 @@ public:
     Status ListenAndServe(const std::string& listen_ip, uint16_t listen_port,
                           const Handler &handler);
 
+    // 需要在ListenAndServe之前设置
+    void SetHttpHandler(const HttpHandler& handler) { http_handler_ = handler; }
+
     void Stop();
 
 private:
@@ -35,6 +38,7 @@ private:
 private:
     const ServerOptions opt_;
     Handler handler_;
+    HttpHandler http_handler_;
 
     bool stopped_ = false;
 
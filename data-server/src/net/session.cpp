@@ -3,6 +3,9 @@
 #include <asio/read.hpp>
 #include <asio/write.hpp>
 #include <asio/read_until.hpp>
+#include <algorithm>
+#include <cstring>
+#include <istream>
 
 #include "frame/sf_logger.h"
 
@@ -13,8 +16,8 @@ namespace net {
 std::atomic<uint64_t> Session::total_count_ = {0};
 
 Session::Session(const SessionOptions& opt, const Handler & handler,
-                 asio::ip::tcp::socket socket)
-    : opt_(opt), handler_(handler), socket_(std::move(socket)) {
+                 const HttpHandler& http_handler, asio::ip::tcp::socket socket)
+    : opt_(opt), handler_(handler), http_handler_(http_handler), socket_(std::move(socket)) {
     ++total_count_;
 }
 
@@ -77,6 +80,10 @@ void Session::readHead() {
     asio::async_read(socket_, asio::buffer(&head_, sizeof(head_)),
                      [this, self](std::error_code ec, std::size_t) {
                          if (!ec) {
+                             if (isHttp()) {
+                                 readHttp();
+                                 return;
+                             }
                              head_.Decode();
                              auto ret = head_.Valid();
                              if (ret.ok()) {
@@ -98,6 +105,77 @@ void Session::readHead() {
                      });
 }
 
+bool Session::isHttp() const {
+    return http_handler_ && memcmp(&head_, "GET ", 4) == 0;
+}
+
+void Session::readHttp() {
+    // 已经读到的head部分是请求行的开头
+    auto buf = http_buf_.prepare(sizeof(head_));
+    memcpy(buf.data(), &head_, sizeof(head_));
+    http_buf_.commit(sizeof(head_));
+
+    auto self(shared_from_this());
+    asio::async_read_until(socket_, http_buf_, "\r\n\r\n",
+                           [this, self](std::error_code ec, std::size_t) {
+                               if (!ec) {
+                                   doHttp();
+                               } else if (ec == asio::error::not_found) {
+                                   FLOG_WARN("%s http request exceeds %zu bytes",
+                                             id_.c_str(), kMaxHttpRequestSize);
+                                   doClose();
+                               } else {
+                                   FLOG_ERROR("%s read http request error: %s", id_.c_str(),
+                                              ec.message().c_str());
+                                   doClose();
+                               }
+                           });
+}
+
+void Session::doHttp() {
+    std::istream is(&http_buf_);
+    std::string version;
+    HttpRequest req;
+    is >> req.method >> req.path >> version;
+
+    std::string line;
+    std::getline(is, line);  // 请求行剩下的\r
+    while (std::getline(is, line) && line != "\r" && !line.empty()) {
+        auto pos = line.find(':');
+        if (pos == std::string::npos) continue;
+        auto name = line.substr(0, pos);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        auto value_start = line.find_first_not_of(" \t", pos + 1);
+        auto value_end = line.find_last_not_of(" \t\r");
+        if (value_start == std::string::npos || value_end < value_start) {
+            req.headers[name] = "";
+        } else {
+            req.headers[name] = line.substr(value_start, value_end - value_start + 1);
+        }
+    }
+
+    HttpResponse resp;
+    http_handler_(session_ctx_, req, &resp);
+
+    http_resp_ = "HTTP/1.1 " + std::to_string(resp.status) +
+                 (resp.status == 200 ? " OK" : " Error") + "\r\n";
+    http_resp_ += "Content-Type: " + resp.content_type + "\r\n";
+    http_resp_ += "Content-Length: " + std::to_string(resp.body.size()) + "\r\n";
+    http_resp_ += "Connection: close\r\n\r\n";
+    http_resp_ += resp.body;
+
+    // 一个连接只处理一个请求
+    auto self(shared_from_this());
+    asio::async_write(socket_, asio::buffer(http_resp_),
+                      [this, self](std::error_code ec, std::size_t) {
+                          if (ec) {
+                              FLOG_ERROR("%s write http response error: %s", id_.c_str(),
+                                         ec.message().c_str());
+                          }
+                          doClose();
+                      });
+}
+
 void Session::readBody() {
     if (head_.body_length == 0) {
         if (head_.func_id == kHeartbeatFuncID) { // response heartbeat
@@ -16,7 +16,7 @@ namespace net {
 class Session : public std::enable_shared_from_this<Session> {
 public:
     Session(const SessionOptions& opt, const Handler& msg_handler,
-            asio::ip::tcp::socket socket);
+            const HttpHandler& http_handler, asio::ip::tcp::socket socket);
     ~Session();
 
     void Start();
@@ -36,6 +36,10 @@ private:
     void readHead();
     void readBody();
 
+    bool isHttp() const;
+    void readHttp();
+    void doHttp();
+
 private:
 
     // all server's sessions count
@@ -43,6 +47,7 @@ private:
 
     const SessionOptions& opt_;
     const Handler& handler_;
+    const HttpHandler& http_handler_;
 
     asio::ip::tcp::socket socket_;
     Context session_ctx_;
@@ -54,6 +59,11 @@ private:
     std::vector<uint8_t> body_;
 
     std::deque<MessagePtr> write_msgs_;
+
+    // 请求行加header的上限，超过时关闭连接
+    static const size_t kMaxHttpRequestSize = 8192;
+    asio::streambuf http_buf_{kMaxHttpRequestSize};
+    std::string http_resp_;
 };
 
 }  // namespace net
@@ -29,6 +29,15 @@ struct TransportOptions {
     // 接收IO线程数量(Server端)
     size_t recv_io_threads = 4;
 
+    // 使用io_uring收发(需要编译打开ENABLE_IO_URING, 内核不支持时退回epoll)
+    bool use_io_uring = false;
+
+    // 复制日志和快照消息的压缩算法(需要编译打开ENABLE_LZ4/ENABLE_ZSTD)
+    // 建立连接时跟对端协商，对端不支持时不压缩
+    CompressionType compression = CompressionType::kNone;
+    // 超过多少字节的消息才压缩
+    size_t compression_threshold = 4096;
+
     Status Validate() const;
 };
 
@@ -85,6 +94,28 @@ struct RaftServerOptions {
     // 复制batch数量（按字节大小）
     uint64_t max_size_per_msg = 1024 * 1024;
 
+    // 单个副本还没确认的复制字节数上限，0表示只按条数限制
+    uint64_t max_inflight_bytes = 8 * 1024 * 1024;
+    // 按测量的rtt和带宽在[max_size_per_msg, max_inflight_bytes]之间调整复制窗口
+    // 否则窗口固定为max_inflight_bytes
+    bool adaptive_inflight = true;
+    // 发往同一个节点的所有raft还没确认的复制字节数上限，0表示不限制
+    uint64_t max_inflight_bytes_per_node = 64 * 1024 * 1024;
+
+    // 所有raft共享的最近日志缓存大小（字节），0表示不使用
+    uint64_t entry_cache_capacity = 64 * 1024 * 1024;
+
+    // raft日志文件按log_file_size预分配，追加时文件大小不变，sync只需要fdatasync
+    bool log_preallocate = true;
+    // 截断的raft日志文件放到这个目录里，新建日志文件时复用，空表示直接删除
+    // 需要跟raft日志目录在同一个文件系统上
+    std::string log_recycle_path;
+    // 回收目录里最多保留多少个日志文件
+    size_t log_recycle_files = 64;
+    // 所有raft日志占用磁盘空间的上限，超过时先截断没有副本需要的日志，
+    // 仍然超过时再截断落后副本需要的日志(这些副本之后需要快照)，0表示不限制
+    uint64_t log_disk_budget = 0;
+
     // raft一致性线程数量
     uint8_t consensus_threads_num = 4;
     // raft一致性队列长度
@@ -97,6 +128,15 @@ struct RaftServerOptions {
     // apply队列长度
     size_t apply_queue_capacity = 100000;
 
+    // 统计线程负载的周期，同时也是按负载在线程之间迁移raft的检查周期
+    std::chrono::seconds rebalance_interval = std::chrono::seconds(10);
+    // 是否把忙线程上的raft迁移到闲线程上
+    bool enable_rebalance = true;
+    // 最忙的线程繁忙时间占比超过这个值(百分比)才考虑迁移
+    unsigned rebalance_busy_percent = 70;
+    // 最忙和最闲的线程占比相差超过这个值(百分比)才迁移
+    unsigned rebalance_imbalance_percent = 30;
+
     TransportOptions transport_options;
     SnapshotOptions snapshot_options;
 
@@ -121,6 +161,7 @@ struct RaftOptions {
     // 单个日志文件的大小
     size_t log_file_size = 1024 * 1024 * 16;
     // 最多保留多少个日志文件，超过就截断旧数据
+    // leader上为活跃的落后副本最多保留到两倍个数
     size_t max_log_files = 5;
     // 启动时检测到日志损坏是否运行继续启动
     bool allow_log_corrupt = false;
@@ -9,6 +9,17 @@ _Pragma("once");
 namespace sharkstore {
 namespace raft {
 
+// leader上本地提交的日志在raft内部各阶段的时间(us, 和gettimeofday同一时钟)
+// 0表示没有记录(比如应用时才收到的日志，或者同一轮里就提交了还没有持久化)
+struct EntryTrace {
+    int64_t step_time = 0;     // consensus线程开始处理提交
+    int64_t persist_time = 0;  // leader写入日志完成
+    int64_t commit_time = 0;   // 多数派复制完成，开始应用
+};
+
+// 只能在StateMachine::Apply里调用，返回正在应用的日志的trace，没有返回nullptr
+const EntryTrace* CurrentEntryTrace();
+
 class StateMachine {
 public:
     StateMachine() = default;
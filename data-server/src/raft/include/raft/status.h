@@ -3,6 +3,7 @@ _Pragma("once");
 #include <stdint.h>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "raft/types.h"
 
@@ -13,6 +14,44 @@ struct ServerStatus {
     uint64_t total_snap_applying = 0;
     uint64_t total_snap_sending = 0;
     uint64_t total_rafts_count = 0;
+
+    // 每个线程的队列长度
+    std::vector<uint64_t> consensus_queue_sizes;
+    std::vector<uint64_t> apply_queue_sizes;
+
+    // 每个线程上一个统计周期的繁忙时间占比(百分比)，队列满过的算100
+    std::vector<uint64_t> consensus_busy_percents;
+    std::vector<uint64_t> apply_busy_percents;
+    // 按负载迁移raft的总次数和最近的迁移记录
+    uint64_t rebalance_migrations = 0;
+    std::vector<std::string> rebalance_decisions;
+
+    // 日志缓存，命中表示读已持久化的日志时不需要读存储
+    uint64_t entry_cache_capacity = 0;
+    uint64_t entry_cache_size = 0;
+    uint64_t entry_cache_hits = 0;
+    uint64_t entry_cache_misses = 0;
+
+    // 发往每个节点(key: node_id)的所有raft还没确认的复制字节数，以及每个节点的上限(0不限制)
+    std::map<uint64_t, uint64_t> inflight_bytes_per_node;
+    uint64_t inflight_bytes_capacity_per_node = 0;
+
+    // 所有raft日志占用的磁盘空间，其中没有副本需要的部分，以及上限(0不限制)
+    uint64_t log_disk_bytes = 0;
+    uint64_t log_disk_free_bytes = 0;
+    uint64_t log_disk_budget = 0;
+
+    // 日志文件回收池，回收和复用的是累计文件个数
+    uint64_t log_pool_capacity = 0;
+    uint64_t log_pool_files = 0;
+    uint64_t log_recycled_files = 0;
+    uint64_t log_reused_files = 0;
+
+    // 发送消息的压缩，只统计达到压缩阈值的复制日志和快照消息
+    uint64_t compress_raw_bytes = 0;         // 压缩前字节数
+    uint64_t compress_sent_bytes = 0;        // 实际发送的字节数
+    uint64_t compressed_msgs = 0;            // 压缩后发送的消息数
+    uint64_t compress_skipped_msgs = 0;      // 压缩率低暂停压缩时跳过的消息数
 };
 
 struct ReplicaStatus {
@@ -24,6 +63,32 @@ struct ReplicaStatus {
     bool snapshotting = false;
     std::string state;
 
+    // 复制窗口，只有leader上的副本有
+    uint64_t inflight_msgs = 0;
+    uint64_t inflight_bytes = 0;
+    uint64_t window_bytes = 0;   // 当前窗口大小，0表示不按字节限制
+    int64_t srtt_us = 0;         // 平滑的确认rtt
+    int64_t min_rtt_us = 0;
+    uint64_t bandwidth = 0;      // 估算的复制带宽，字节/秒
+
+    std::string ToString() const;
+};
+
+// raft日志截断的决策
+struct LogGCStatus {
+    uint64_t first_index = 0;
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t free_bytes = 0;     // 没有副本需要、可以直接截断的
+    // leader上为活跃的落后副本保留日志的位置(它们中最小的match)，0表示没有
+    uint64_t hold_index = 0;
+    uint64_t hold_node = 0;
+    std::string pressure;        // 节点日志空间的压力: none, reclaim, force
+    uint64_t truncated_index = 0;  // 最近一次决定截断到的位置
+    std::string reason;            // 最近一次截断的原因: file_count, budget
+    uint64_t truncations = 0;
+    uint64_t forced_truncations = 0;  // 截断了落后副本需要的日志，副本需要快照
+
     std::string ToString() const;
 };
 
@@ -37,6 +102,7 @@ struct RaftStatus {
     std::string state;
     // key: node_id
     std::map<uint64_t, ReplicaStatus> replicas;
+    LogGCStatus log_gc;
 
     RaftStatus() = default;
     RaftStatus& operator=(const RaftStatus& s) = default;
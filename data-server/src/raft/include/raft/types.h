@@ -25,6 +25,14 @@ enum class ConfChangeType : char { kAdd, kRemove, kPromote };
 
 std::string ConfChangeTypeName(ConfChangeType type);
 
+// raft复制日志和快照消息的压缩算法
+enum class CompressionType : char { kNone = 0, kLZ4 = 1, kZstd = 2 };
+
+std::string CompressionTypeName(CompressionType type);
+
+// none, lz4, zstd（不区分大小写），不认识的返回false
+bool ParseCompressionType(const std::string& name, CompressionType* type);
+
 struct ConfChange {
     ConfChangeType type = ConfChangeType::kAdd;
     Peer peer;
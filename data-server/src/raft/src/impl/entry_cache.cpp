@@ -0,0 +1,128 @@
+#include "entry_cache.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+EntryCache::EntryCache(uint64_t capacity) : capacity_(capacity) {}
+
+EntryCache::Group& EntryCache::touch(uint64_t id) {
+    auto it = groups_.find(id);
+    if (it == groups_.end()) {
+        lru_.push_front(id);
+        auto& g = groups_[id];
+        g.lru_pos = lru_.begin();
+        return g;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    return it->second;
+}
+
+void EntryCache::popFront(Group& g) {
+    size_ -= g.items.front().size;
+    g.items.pop_front();
+}
+
+void EntryCache::popBack(Group& g) {
+    size_ -= g.items.back().size;
+    g.items.pop_back();
+}
+
+void EntryCache::evict() {
+    while (size_ > capacity_ && !lru_.empty()) {
+        auto it = groups_.find(lru_.back());
+        auto& g = it->second;
+        while (!g.items.empty() && size_ > capacity_) {
+            popFront(g);
+        }
+        if (g.items.empty()) {
+            lru_.pop_back();
+            groups_.erase(it);
+        }
+    }
+}
+
+void EntryCache::Append(uint64_t id, const std::vector<EntryPtr>& ents) {
+    if (ents.empty()) return;
+
+    // 计算大小不需要加锁
+    std::vector<Item> items(ents.size());
+    for (size_t i = 0; i < ents.size(); ++i) {
+        items[i].entry = ents[i];
+        items[i].size = ents[i]->ByteSizeLong();
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& g = touch(id);
+    auto first = ents.front()->index();
+    if (!g.items.empty()) {
+        if (first < g.items.front().entry->index() ||
+            first > g.items.back().entry->index() + 1) {
+            while (!g.items.empty()) popBack(g);
+        } else {
+            while (!g.items.empty() && g.items.back().entry->index() >= first) {
+                popBack(g);
+            }
+        }
+    }
+    for (auto& item : items) {
+        size_ += item.size;
+        g.items.push_back(std::move(item));
+    }
+    evict();
+}
+
+uint64_t EntryCache::Get(uint64_t id, uint64_t lo, uint64_t hi, uint64_t max_size,
+                         std::vector<EntryPtr>* ents) {
+    std::unique_lock<std::mutex> lock(mu_);
+    auto it = groups_.find(id);
+    if (it == groups_.end() || it->second.items.empty()) {
+        lock.unlock();
+        ++misses_;
+        return lo;
+    }
+    const auto& items = it->second.items;
+    auto first = items.front().entry->index();
+    if (lo < first || lo >= first + items.size()) {
+        lock.unlock();
+        ++misses_;
+        return lo;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+
+    uint64_t size = 0;
+    uint64_t index = lo;
+    for (auto pos = lo - first; pos < items.size() && index < hi; ++pos, ++index) {
+        size += items[pos].size;
+        if (size > max_size && index > lo) {
+            index = hi;  // 达到max_size，不需要再读存储
+            break;
+        }
+        ents->push_back(items[pos].entry);
+    }
+    lock.unlock();
+
+    if (index >= hi) {
+        ++hits_;
+        return hi;
+    } else {
+        ++misses_;
+        return index;
+    }
+}
+
+void EntryCache::Remove(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = groups_.find(id);
+    if (it != groups_.end()) {
+        auto& g = it->second;
+        while (!g.items.empty()) popBack(g);
+        lru_.erase(g.lru_pos);
+        groups_.erase(it);
+    }
+}
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
@@ -0,0 +1,73 @@
+_Pragma("once");
+
+#include <atomic>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "raft_types.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+// 节点上所有raft共享的最近日志缓存，按总字节数限制内存
+// 复制(sendAppend)和应用(nextEntries)需要已经持久化的日志时先查缓存，避免读日志文件
+// 超过容量时淘汰最久没有访问的raft group里最旧的日志
+class EntryCache {
+public:
+    explicit EntryCache(uint64_t capacity);
+    ~EntryCache() = default;
+
+    EntryCache(const EntryCache&) = delete;
+    EntryCache& operator=(const EntryCache&) = delete;
+
+    // 追加日志，ents的index必须连续
+    // 和已缓存的日志重叠时截断重叠部分(被新日志覆盖)，不连续时丢弃已缓存的日志
+    void Append(uint64_t id, const std::vector<EntryPtr>& ents);
+
+    // 取[lo, hi)的日志，从lo开始连续取，总大小不超过max_size(至少一条)
+    // 返回下一个需要从存储读取的index，全部命中或者达到max_size时返回hi
+    uint64_t Get(uint64_t id, uint64_t lo, uint64_t hi, uint64_t max_size,
+                 std::vector<EntryPtr>* ents);
+
+    void Remove(uint64_t id);
+
+    uint64_t Capacity() const { return capacity_; }
+    uint64_t Size() const { return size_; }
+    uint64_t Hits() const { return hits_; }
+    uint64_t Misses() const { return misses_; }
+
+private:
+    struct Item {
+        EntryPtr entry;
+        uint64_t size = 0;
+    };
+
+    struct Group {
+        std::deque<Item> items;  // index连续
+        std::list<uint64_t>::iterator lru_pos;
+    };
+
+    Group& touch(uint64_t id);
+    void popFront(Group& g);
+    void popBack(Group& g);
+    void evict();
+
+private:
+    const uint64_t capacity_;
+
+    std::mutex mu_;
+    std::unordered_map<uint64_t, Group> groups_;
+    std::list<uint64_t> lru_;  // 最近访问的在前面
+
+    std::atomic<uint64_t> size_ = {0};
+    std::atomic<uint64_t> hits_ = {0};
+    std::atomic<uint64_t> misses_ = {0};
+};
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
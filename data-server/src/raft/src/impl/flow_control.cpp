@@ -0,0 +1,66 @@
+#include "flow_control.h"
+
+#include <algorithm>
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+const int64_t FlowWindow::kMinRttExpireUs;
+
+FlowWindow::FlowWindow(uint64_t min_bytes, uint64_t max_bytes, bool adaptive)
+    : min_bytes_(std::min(min_bytes, max_bytes)), max_bytes_(max_bytes), adaptive_(adaptive) {
+    // 开始时没有测量值，先按几个batch发
+    size_ = adaptive_ ? std::min(max_bytes_, min_bytes_ * 4) : max_bytes_;
+}
+
+void FlowWindow::onAck(int64_t rtt_us, uint64_t delivered_bytes, int64_t now_us) {
+    if (rtt_us <= 0) return;
+
+    srtt_us_ = (srtt_us_ == 0) ? rtt_us : srtt_us_ + (rtt_us - srtt_us_) / 8;
+    if (min_rtt_us_ == 0 || rtt_us <= min_rtt_us_ ||
+        now_us - min_rtt_stamp_ > kMinRttExpireUs) {
+        min_rtt_us_ = rtt_us;
+        min_rtt_stamp_ = now_us;
+    }
+
+    // 投递速率增长时直接采用，下降时慢慢跟随，避免一次慢的确认把窗口压得太小
+    auto rate = delivered_bytes * 1000000 / static_cast<uint64_t>(rtt_us);
+    if (rate >= bandwidth_) {
+        bandwidth_ = rate;
+    } else {
+        bandwidth_ -= (bandwidth_ - rate) / 8;
+    }
+
+    if (!adaptive_ || max_bytes_ == 0) return;
+    auto bdp = bandwidth_ * static_cast<uint64_t>(min_rtt_us_) / 1000000;
+    size_ = std::max(min_bytes_, std::min(max_bytes_, bdp * 2));
+}
+
+void FlowWindow::onLoss() {
+    bandwidth_ /= 2;
+    if (!adaptive_ || max_bytes_ == 0) return;
+    size_ = std::max(min_bytes_, size_ / 2);
+}
+
+InflightBudget::InflightBudget(uint64_t capacity) : capacity_(capacity) {}
+
+std::shared_ptr<InflightBudget::Node> InflightBudget::Get(uint64_t node_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& node = nodes_[node_id];
+    if (!node) {
+        node = std::make_shared<Node>(capacity_);
+    }
+    return node;
+}
+
+void InflightBudget::Collect(std::map<uint64_t, uint64_t>* bytes) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& n : nodes_) {
+        (*bytes)[n.first] = n.second->bytes.load();
+    }
+}
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
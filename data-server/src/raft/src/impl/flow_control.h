@@ -0,0 +1,82 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+// 自适应的复制窗口(字节)，每个副本一个，只在raft线程里访问
+// 确认时用最后确认的那次发送测量rtt和投递速率(发送之后到确认期间确认的字节数/rtt)，
+// 窗口取带宽时延积(带宽 * 最小rtt)的两倍，限制在[min_bytes, max_bytes]之间
+// 链路空闲时窗口每轮翻倍增长，开始排队后rtt变大而投递速率不再增长，窗口稳定下来
+class FlowWindow {
+public:
+    // 最小rtt的有效期，过期后用新的测量值
+    static const int64_t kMinRttExpireUs = 10 * 1000 * 1000;
+
+    // max_bytes为0表示不限制
+    FlowWindow(uint64_t min_bytes, uint64_t max_bytes, bool adaptive);
+
+    uint64_t size() const { return size_; }
+
+    void onAck(int64_t rtt_us, uint64_t delivered_bytes, int64_t now_us);
+    // 被拒绝或者超时，窗口减半
+    void onLoss();
+
+    int64_t srtt_us() const { return srtt_us_; }
+    int64_t min_rtt_us() const { return min_rtt_us_; }
+    uint64_t bandwidth() const { return bandwidth_; }  // 字节/秒
+
+private:
+    const uint64_t min_bytes_ = 0;
+    const uint64_t max_bytes_ = 0;
+    const bool adaptive_ = true;
+
+    uint64_t size_ = 0;
+    int64_t srtt_us_ = 0;
+    int64_t min_rtt_us_ = 0;
+    int64_t min_rtt_stamp_ = 0;
+    uint64_t bandwidth_ = 0;
+};
+
+// 节点上所有raft共享，按目标节点限制还没确认的复制字节数
+// 一个落后的节点最多占用capacity的内存，也不会挤占发往其他节点的复制
+class InflightBudget {
+public:
+    // 一个目标节点的计数，副本持有，发送时增加，确认或者重置时减少
+    struct Node {
+        const uint64_t capacity;
+        std::atomic<uint64_t> bytes = {0};
+
+        explicit Node(uint64_t cap) : capacity(cap) {}
+
+        bool full() const { return capacity > 0 && bytes.load() >= capacity; }
+    };
+
+    // capacity为0表示不限制，只统计
+    explicit InflightBudget(uint64_t capacity);
+
+    InflightBudget(const InflightBudget&) = delete;
+    InflightBudget& operator=(const InflightBudget&) = delete;
+
+    std::shared_ptr<Node> Get(uint64_t node_id);
+
+    uint64_t Capacity() const { return capacity_; }
+    // key: node_id
+    void Collect(std::map<uint64_t, uint64_t>* bytes) const;
+
+private:
+    const uint64_t capacity_;
+
+    mutable std::mutex mu_;
+    std::map<uint64_t, std::shared_ptr<Node>> nodes_;
+};
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
@@ -0,0 +1,132 @@
+#include "log_gc.h"
+
+#include <algorithm>
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+LogDiskBudget::LogDiskBudget(uint64_t capacity) : capacity_(capacity) {}
+
+void LogDiskBudget::Update(int64_t bytes_delta, int64_t free_delta) {
+    bytes_ += bytes_delta;
+    free_bytes_ += free_delta;
+}
+
+LogDiskBudget::Pressure LogDiskBudget::Current() const {
+    auto bytes = Bytes();
+    if (capacity_ == 0 || bytes <= capacity_) {
+        return Pressure::kNone;
+    }
+    auto free = std::min(bytes, FreeBytes());
+    return (bytes - free <= capacity_) ? Pressure::kReclaim : Pressure::kForce;
+}
+
+uint64_t LogDiskBudget::Bytes() const {
+    return static_cast<uint64_t>(std::max<int64_t>(bytes_.load(), 0));
+}
+
+uint64_t LogDiskBudget::FreeBytes() const {
+    return static_cast<uint64_t>(std::max<int64_t>(free_bytes_.load(), 0));
+}
+
+const char* PressureName(LogDiskBudget::Pressure p) {
+    switch (p) {
+        case LogDiskBudget::Pressure::kNone:
+            return "none";
+        case LogDiskBudget::Pressure::kReclaim:
+            return "reclaim";
+        case LogDiskBudget::Pressure::kForce:
+            return "force";
+    }
+    return "unknown";
+}
+
+const uint64_t LogGC::kKeepCountBeforeApplied;
+
+LogGC::LogGC(size_t max_files, LogDiskBudget* budget)
+    : max_files_(max_files), budget_(budget) {}
+
+LogGC::~LogGC() {
+    if (budget_ != nullptr) {
+        budget_->Update(-reported_bytes_, -reported_free_);
+    }
+}
+
+uint64_t LogGC::floorIndex(const std::vector<storage::LogFileUsage>& files, uint64_t index) {
+    uint64_t result = 0;
+    for (size_t i = 0; i + 1 < files.size() && files[i].last_index <= index; ++i) {
+        result = files[i].last_index;
+    }
+    return result;
+}
+
+void LogGC::report(const std::vector<storage::LogFileUsage>& files) {
+    int64_t bytes = 0, free = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        bytes += files[i].bytes;
+        if (i + 1 < files.size() && files[i].last_index <= free_index_) {
+            free += files[i].bytes;
+        }
+    }
+    if (budget_ != nullptr) {
+        budget_->Update(bytes - reported_bytes_, free - reported_free_);
+    }
+    reported_bytes_ = bytes;
+    reported_free_ = free;
+
+    status_.files = files.size();
+    status_.bytes = static_cast<uint64_t>(bytes);
+    status_.free_bytes = static_cast<uint64_t>(free);
+}
+
+uint64_t LogGC::Decide(const std::vector<storage::LogFileUsage>& files, uint64_t applied,
+                       uint64_t hold, uint64_t hold_node) {
+    if (files.empty()) return 0;
+
+    uint64_t limit = applied > kKeepCountBeforeApplied ? applied - kKeepCountBeforeApplied : 0;
+    free_index_ = (hold > 0) ? std::min(limit, hold) : limit;
+    report(files);
+
+    auto pressure = budget_ != nullptr ? budget_->Current() : LogDiskBudget::Pressure::kNone;
+    status_.hold_index = hold;
+    status_.hold_node = hold_node;
+    status_.pressure = PressureName(pressure);
+
+    uint64_t target = 0;
+    const char* reason = nullptr;
+    if (max_files_ > 0 && files.size() > max_files_) {
+        // 截断之后剩下max_files个文件
+        target = floorIndex(files, std::min(files[files.size() - max_files_ - 1].last_index,
+                                            free_index_));
+        if (files.size() > max_files_ * 2) {
+            auto max_hold = files[files.size() - max_files_ * 2 - 1].last_index;
+            target = std::max(target, floorIndex(files, std::min(max_hold, limit)));
+        }
+        reason = "file_count";
+    }
+    if (pressure != LogDiskBudget::Pressure::kNone) {
+        auto index = floorIndex(files, pressure == LogDiskBudget::Pressure::kForce
+                                           ? limit
+                                           : free_index_);
+        if (index > target) {
+            target = index;
+            reason = "budget";
+        }
+    }
+    if (target == 0) return 0;
+
+    status_.truncated_index = target;
+    status_.reason = reason;
+    ++status_.truncations;
+    if (target > free_index_) {
+        ++status_.forced_truncations;
+    }
+    return target;
+}
+
+void LogGC::Update(const std::vector<storage::LogFileUsage>& files) { report(files); }
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
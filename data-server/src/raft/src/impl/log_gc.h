@@ -0,0 +1,92 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "raft/status.h"
+#include "storage/storage.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+// 节点上所有raft日志占用的磁盘空间，跟上限比较得出截断的压力
+// 每个raft上报自己的占用和其中可以释放的部分(没有副本需要的日志)
+class LogDiskBudget {
+public:
+    enum class Pressure {
+        kNone,     // 没有超过上限
+        kReclaim,  // 超过上限，释放没有副本需要的日志就够了
+        kForce,    // 只释放没有副本需要的日志还不够，落后副本需要的日志也要截断
+    };
+
+    // capacity为0表示不限制，只统计
+    explicit LogDiskBudget(uint64_t capacity);
+
+    LogDiskBudget(const LogDiskBudget&) = delete;
+    LogDiskBudget& operator=(const LogDiskBudget&) = delete;
+
+    void Update(int64_t bytes_delta, int64_t free_delta);
+    Pressure Current() const;
+
+    uint64_t Capacity() const { return capacity_; }
+    uint64_t Bytes() const;
+    uint64_t FreeBytes() const;
+
+private:
+    const uint64_t capacity_;
+    std::atomic<int64_t> bytes_ = {0};
+    std::atomic<int64_t> free_bytes_ = {0};
+};
+
+const char* PressureName(LogDiskBudget::Pressure p);
+
+// 一个raft的日志截断决策，只在raft线程里访问
+// 截断位置不超过已应用的减去kKeepCountBeforeApplied，并且按文件截断(不截断正在写的文件)
+// leader上活跃的落后副本还需要的日志(match之后)优先保留：
+// 1) 文件个数超过max_files时截断最旧的文件，为落后副本最多保留到2倍个数
+// 2) 节点空间超过上限时截断所有没有副本需要的日志
+// 3) 仍然超过上限时截断落后副本需要的日志，这些副本之后需要快照
+class LogGC {
+public:
+    static const uint64_t kKeepCountBeforeApplied = 30;
+
+    // max_files为0表示不按个数截断，budget为nullptr表示不按节点空间截断
+    LogGC(size_t max_files, LogDiskBudget* budget);
+    ~LogGC();
+
+    LogGC(const LogGC&) = delete;
+    LogGC& operator=(const LogGC&) = delete;
+
+    // files: 从旧到新的日志文件，最后一个是正在写的
+    // hold: 活跃的落后副本中最小的match，0表示没有
+    // 返回截断位置，0表示不截断
+    uint64_t Decide(const std::vector<storage::LogFileUsage>& files, uint64_t applied,
+                    uint64_t hold, uint64_t hold_node);
+    // 截断之后更新占用
+    void Update(const std::vector<storage::LogFileUsage>& files);
+
+    const LogGCStatus& Status() const { return status_; }
+
+private:
+    // 最大的不超过index的文件末尾，正在写的文件除外
+    static uint64_t floorIndex(const std::vector<storage::LogFileUsage>& files,
+                               uint64_t index);
+
+    void report(const std::vector<storage::LogFileUsage>& files);
+
+private:
+    const size_t max_files_ = 0;
+    LogDiskBudget* const budget_ = nullptr;
+
+    uint64_t free_index_ = 0;  // 截断到这里不影响任何副本
+    int64_t reported_bytes_ = 0;
+    int64_t reported_free_ = 0;
+
+    LogGCStatus status_;
+};
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
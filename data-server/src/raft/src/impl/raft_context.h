@@ -1,6 +1,10 @@
 _Pragma("once");
 
+#include "entry_cache.h"
+#include "flow_control.h"
+#include "log_gc.h"
 #include "snapshot/manager.h"
+#include "storage/log_file_pool.h"
 #include "transport/transport.h"
 #include "work_thread.h"
 
@@ -9,10 +13,15 @@ namespace raft {
 namespace impl {
 
 struct RaftContext {
+    // 创建时分配的线程，之后可能按负载迁移到其他线程(见WorkRoute)
     WorkThread *consensus_thread = nullptr;
     WorkThread *apply_thread = nullptr;
     SnapshotManager *snapshot_manager = nullptr;
     transport::Transport *msg_sender = nullptr;
+    EntryCache *entry_cache = nullptr;  // nullptr: 不使用缓存
+    InflightBudget *inflight_budget = nullptr;  // nullptr: 不按目标节点限制
+    storage::LogFilePool *log_file_pool = nullptr;  // nullptr: 不回收日志文件
+    LogDiskBudget *log_disk_budget = nullptr;  // nullptr: 不按节点日志空间截断
 };
 
 } /* namespace impl */
@@ -14,12 +14,18 @@ namespace sharkstore {
 namespace raft {
 namespace impl {
 
-RaftFsm::RaftFsm(const RaftServerOptions& sops, const RaftOptions& ops)
+RaftFsm::RaftFsm(const RaftServerOptions& sops, const RaftOptions& ops,
+                 EntryCache* entry_cache, InflightBudget* inflight_budget,
+                 storage::LogFilePool* log_file_pool, LogDiskBudget* log_disk_budget)
     : sops_(sops),
       rops_(ops),
       node_id_(sops.node_id),
       id_(ops.id),
-      sm_(ops.statemachine) {
+      sm_(ops.statemachine),
+      entry_cache_(entry_cache),
+      inflight_budget_(inflight_budget),
+      log_file_pool_(log_file_pool),
+      log_gc_(new LogGC(ops.max_log_files, log_disk_budget)) {
     auto s = start();
     if (!s.ok()) {
         throw RaftException(s);
@@ -113,9 +119,11 @@ Status RaftFsm::start() {
     } else {
         storage::DiskStorage::Options ops;
         ops.log_file_size = rops_.log_file_size;
-        ops.max_log_files = rops_.max_log_files;
+        // 按文件个数截断由GCLog决定
         ops.allow_corrupt_startup = rops_.allow_log_corrupt;
         ops.initial_first_index = rops_.initial_first_index;
+        ops.preallocate = sops_.log_preallocate;
+        ops.recycle_pool = log_file_pool_;
         storage_ = std::shared_ptr<storage::Storage>(
             new storage::DiskStorage(id_, rops_.storage_path, ops));
     }
@@ -124,7 +132,7 @@ Status RaftFsm::start() {
         LOG_ERROR("raft[%llu] open raft storage failed: %s", id_, s.ToString().c_str());
         return Status(Status::kCorruption, "open raft logger", s.ToString());
     } else {
-        raft_log_ = std::unique_ptr<RaftLog>(new RaftLog(id_, storage_));
+        raft_log_ = std::unique_ptr<RaftLog>(new RaftLog(id_, storage_, entry_cache_));
     }
 
     // 加载 hardstate
@@ -492,9 +500,17 @@ RaftStatus RaftFsm::GetStatus() const {
             }
             rs.state = ReplicateStateName(pr.state());
             rs.snapshotting = pr.state() == ReplicaState::kSnapshot;
+            rs.inflight_msgs = static_cast<uint64_t>(pr.inflight().count());
+            rs.inflight_bytes = pr.inflight().bytes();
+            rs.window_bytes = pr.window().size();
+            rs.srtt_us = pr.window().srtt_us();
+            rs.min_rtt_us = pr.window().min_rtt_us();
+            rs.bandwidth = pr.window().bandwidth();
             s.replicas.emplace(node, rs);
         });
     }
+    s.log_gc = log_gc_->Status();
+    s.log_gc.first_index = raft_log_->firstIndex();
     return s;
 }
 
@@ -503,6 +519,52 @@ Status RaftFsm::TruncateLog(uint64_t index) {
     return storage_->Truncate(index);
 }
 
+void RaftFsm::GCLog() {
+    if (applying_snap_) return;
+
+    std::vector<storage::LogFileUsage> files;
+    storage_->LogUsage(&files);
+    if (files.empty()) return;
+
+    // 为活跃的落后副本保留日志，不活跃的和正在发快照的不保留
+    uint64_t hold = 0, hold_node = 0;
+    if (state_ == FsmState::kLeader) {
+        traverseReplicas([&](uint64_t node, const Replica& pr) {
+            if (node == node_id_ || pr.match() == 0 || pr.state() == ReplicaState::kSnapshot ||
+                pr.inactive_ticks() > sops_.inactive_tick) {
+                return;
+            }
+            if (hold == 0 || pr.match() < hold) {
+                hold = pr.match();
+                hold_node = node;
+            }
+        });
+    }
+
+    auto index = log_gc_->Decide(files, raft_log_->applied(), hold, hold_node);
+    if (index == 0) return;
+
+    const auto& st = log_gc_->Status();
+    auto s = storage_->Truncate(index);
+    if (!s.ok()) {
+        LOG_ERROR("raft[%llu] truncate log to %llu failed(%s), reason: %s", id_, index,
+                  s.ToString().c_str(), st.reason.c_str());
+        return;
+    }
+    if (hold > 0 && index > hold) {
+        LOG_WARN("raft[%llu] truncate log to %llu beyond node %llu match %llu, reason: %s, "
+                 "pressure: %s",
+                 id_, index, hold_node, hold, st.reason.c_str(), st.pressure.c_str());
+    } else {
+        LOG_DEBUG("raft[%llu] truncate log to %llu, reason: %s, pressure: %s", id_, index,
+                  st.reason.c_str(), st.pressure.c_str());
+    }
+
+    files.clear();
+    storage_->LogUsage(&files);
+    log_gc_->Update(files);
+}
+
 Status RaftFsm::DestroyLog(bool backup) { return storage_->Destroy(backup); }
 
 Status RaftFsm::smApply(const EntryPtr& entry) {
@@ -567,7 +629,14 @@ Status RaftFsm::applyConfChange(const EntryPtr& e) {
 
 std::unique_ptr<Replica> RaftFsm::newReplica(const Peer& peer, bool is_leader) const {
     if (is_leader) {
-        auto r = std::unique_ptr<Replica>(new Replica(peer, sops_.max_inflight_msgs));
+        std::shared_ptr<InflightBudget::Node> node;
+        if (inflight_budget_ != nullptr && peer.node_id != node_id_) {
+            node = inflight_budget_->Get(peer.node_id);
+        }
+        FlowWindow window(sops_.max_size_per_msg, sops_.max_inflight_bytes,
+                          sops_.adaptive_inflight);
+        auto r = std::unique_ptr<Replica>(
+            new Replica(peer, sops_.max_inflight_msgs, window, std::move(node)));
         auto lasti = raft_log_->lastIndex();
         r->set_next(lasti + 1);
         if (peer.node_id == node_id_) {
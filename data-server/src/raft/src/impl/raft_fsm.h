@@ -4,6 +4,7 @@ _Pragma("once");
 #include <functional>
 
 #include "raft/options.h"
+#include "log_gc.h"
 #include "raft/status.h"
 #include "raft_log.h"
 #include "raft_types.h"
@@ -17,9 +18,16 @@ struct Ready;
 class SendSnapTask;
 class ApplySnapTask;
 
+namespace storage {
+class LogFilePool;
+}
+
 class RaftFsm {
 public:
-    RaftFsm(const RaftServerOptions& sops, const RaftOptions& ops);
+    RaftFsm(const RaftServerOptions& sops, const RaftOptions& ops,
+            EntryCache* entry_cache = nullptr, InflightBudget* inflight_budget = nullptr,
+            storage::LogFilePool* log_file_pool = nullptr,
+            LogDiskBudget* log_disk_budget = nullptr);
     ~RaftFsm() = default;
 
     RaftFsm(const RaftFsm&) = delete;
@@ -40,6 +48,8 @@ public:
     RaftStatus GetStatus() const;
 
     Status TruncateLog(uint64_t index);
+    // 按副本进度和节点日志空间截断日志，定期调用
+    void GCLog();
     Status DestroyLog(bool backup);
 
 private:
@@ -120,6 +130,10 @@ private:
     const uint64_t node_id_ = 0;
     const uint64_t id_ = 0;
     std::shared_ptr<StateMachine> sm_;
+    EntryCache* const entry_cache_ = nullptr;
+    InflightBudget* const inflight_budget_ = nullptr;
+    storage::LogFilePool* const log_file_pool_ = nullptr;
+    std::unique_ptr<LogGC> log_gc_;
 
     bool is_learner_ = false;
     FsmState state_ = FsmState::kFollower;
@@ -104,7 +104,7 @@ void RaftFsm::stepLeader(MessagePtr& msg) {
                             pr.becomeReplicate();
                             break;
                         case ReplicaState::kReplicate:
-                            pr.inflight().freeTo(msg->log_index());
+                            pr.ackEntries(msg->log_index());
                             break;
                         case ReplicaState::kSnapshot:
                             if (pr.needSnapshotAbort()) {
@@ -132,8 +132,9 @@ void RaftFsm::stepLeader(MessagePtr& msg) {
 
         case pb::HEARTBEAT_RESPONSE:
             pr.resume();
-            if (pr.state() == ReplicaState::kReplicate && pr.inflight().full()) {
-                pr.inflight().freeFirstOne();
+            // 窗口满并且超时没有确认推进才当作丢失
+            if (pr.state() == ReplicaState::kReplicate) {
+                pr.checkInflightLoss();
             }
             // 进度没跟上，需要复制
             if (pr.match() < raft_log_->lastIndex() ||
@@ -289,7 +290,7 @@ void RaftFsm::sendAppend(uint64_t to, Replica& pr) {
                 case ReplicaState::kReplicate: {
                     uint64_t last = msg->entries(msg->entries_size() - 1).index();
                     pr.update(last);
-                    pr.inflight().add(last);
+                    pr.sentEntries(last, msg->ByteSizeLong());
                     break;
                 }
                 case ReplicaState::kProbe:
@@ -1,5 +1,6 @@
 #include "raft_impl.h"
 
+#include <chrono>
 #include <sstream>
 
 #include "logger.h"
@@ -15,9 +16,25 @@ namespace sharkstore {
 namespace raft {
 namespace impl {
 
+// 未应用的trace太多(比如长时间无法提交)时直接丢弃
+static const size_t kMaxEntryTraces = 100000;
+
+static thread_local const EntryTrace* current_entry_trace = nullptr;
+
+static int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
 RaftImpl::RaftImpl(const RaftServerOptions& sops, const RaftOptions& ops,
                    const RaftContext& ctx)
-    : sops_(sops), ops_(ops), ctx_(ctx), fsm_(new RaftFsm(sops, ops)) {
+    : sops_(sops), ops_(ops), ctx_(ctx), fsm_(new RaftFsm(sops, ops, ctx.entry_cache, ctx.inflight_budget,
+                                                   ctx.log_file_pool, ctx.log_disk_budget)) {
+    consensus_route_ = std::make_shared<WorkRoute>(ops_.id, &stopped_, ctx_.consensus_thread);
+    if (ctx_.apply_thread != nullptr) {
+        apply_route_ = std::make_shared<WorkRoute>(ops_.id, &stopped_, ctx_.apply_thread);
+    }
     initPublish();
 }
 
@@ -49,7 +66,7 @@ void RaftImpl::post(const std::function<void()>& f) {
     w.owner = ops_.id;
     w.stopped = &stopped_;
     w.f0 = f;
-    ctx_.consensus_thread->post(w);
+    consensus_route_->post(w);
 }
 
 bool RaftImpl::tryPost(const std::function<void()>& f) {
@@ -57,7 +74,7 @@ bool RaftImpl::tryPost(const std::function<void()>& f) {
     w.owner = ops_.id;
     w.stopped = &stopped_;
     w.f0 = f;
-    return ctx_.consensus_thread->tryPost(w);
+    return consensus_route_->tryPost(w);
 }
 
 Status RaftImpl::Submit(std::string& cmd) {
@@ -66,8 +83,7 @@ Status RaftImpl::Submit(std::string& cmd) {
                       std::to_string(ops_.id));
     }
 
-    if (ctx_.consensus_thread->submit(
-            ops_.id, &stopped_,
+    if (consensus_route_->submit(
             std::bind(&RaftImpl::Step, shared_from_this(), std::placeholders::_1), cmd)) {
         return Status::OK();
     } else {
@@ -136,7 +152,18 @@ void RaftImpl::Step(MessagePtr msg) {
         return;
     }
 
+    // 记录本地提交的日志开始处理的时间
+    bool is_prop = msg->type() == pb::LOCAL_MSG_PROP;
+    bool is_tick = msg->type() == pb::LOCAL_MSG_TICK;
+    uint64_t prev_last_index = 0;
+    int64_t step_time = 0;
+    if (is_prop) {
+        step_time = nowMicros();
+        prev_last_index = fsm_->raft_log_->lastIndex();
+    }
+
     fsm_->Step(msg);
+    if (is_prop) traceProposal(prev_last_index, step_time);
     fsm_->GetReady(&ready_);
 
     // 发送消息
@@ -151,11 +178,52 @@ void RaftImpl::Step(MessagePtr msg) {
     // 应用
     apply();
 
+    // 跟状态更新同一个周期检查日志截断
+    if (is_tick && tick_count_ % sops_.status_tick == 0) {
+        fsm_->GCLog();
+    }
+
     // 发布状态更新
     publish();
 
     // 持久化
     persist();
+    if (is_prop) tracePersist(prev_last_index);
+}
+
+void RaftImpl::traceProposal(uint64_t prev_last_index, int64_t step_time) {
+    auto last_index = fsm_->raft_log_->lastIndex();
+    if (last_index <= prev_last_index) return;
+
+    if (traces_.size() > kMaxEntryTraces) {
+        traces_.clear();
+    }
+    for (auto index = prev_last_index + 1; index <= last_index; ++index) {
+        auto& trace = traces_[index];
+        trace.step_time = step_time;
+        trace.persist_time = 0;
+        trace.commit_time = 0;
+    }
+}
+
+void RaftImpl::tracePersist(uint64_t prev_last_index) {
+    auto last_index = fsm_->raft_log_->lastIndex();
+    auto now = nowMicros();
+    for (auto index = prev_last_index + 1; index <= last_index; ++index) {
+        auto it = traces_.find(index);
+        if (it != traces_.end()) {
+            it->second.persist_time = now;
+        }
+    }
+}
+
+void RaftImpl::takeTrace(uint64_t index, EntryTrace* trace) {
+    auto it = traces_.find(index);
+    if (it != traces_.end()) {
+        *trace = it->second;
+        trace->commit_time = nowMicros();
+        traces_.erase(it);
+    }
 }
 
 void RaftImpl::sendMessages() {
@@ -219,17 +287,19 @@ void RaftImpl::apply() {
             }
             conf_changed_ = true;
         }
+        EntryTrace trace;
+        if (!traces_.empty()) takeTrace(e->index(), &trace);
         if (sops_.apply_in_place) {
             // 同步应用
-            smApply(e);
+            smApply(e, trace);
         } else {
             // 异步应用
-            assert(ctx_.apply_thread != nullptr);
+            assert(apply_route_ != nullptr);
             Work w;
             w.owner = ops_.id;
             w.stopped = &stopped_;
-            w.f0 = std::bind(&RaftImpl::smApply, shared_from_this(), e);
-            ctx_.apply_thread->waitPost(w);
+            w.f0 = std::bind(&RaftImpl::smApply, shared_from_this(), e, trace);
+            apply_route_->waitPost(w);
         }
     }
     if (!ents.empty()) {
@@ -258,6 +328,8 @@ void RaftImpl::publish() {
     if (leader != bulletin_board_.Leader() || term != bulletin_board_.Term()) {
         bulletin_board_.PublishLeaderTerm(leader, term);
         leader_changed = true;
+        // 未提交的日志可能被新leader覆盖
+        traces_.clear();
     }
 
     // 更新成员
@@ -325,8 +397,10 @@ void RaftImpl::ReportSnapApplyResult(const SnapContext& ctx, const SnapResult& r
     post(std::bind(&RaftImpl::Step, shared_from_this(), resp));
 }
 
-void RaftImpl::smApply(const EntryPtr& e) {
+void RaftImpl::smApply(const EntryPtr& e, const EntryTrace& trace) {
+    current_entry_trace = trace.step_time > 0 ? &trace : nullptr;
     auto s = fsm_->smApply(e);
+    current_entry_trace = nullptr;
     if (!s.ok()) {
         throw RaftException(std::string("statemachine apply entry[") +
                             std::to_string(e->index()) + "] error: " + s.ToString());
@@ -347,5 +421,8 @@ Status RaftImpl::Destroy(bool backup) {
 }
 
 }  // namespace impl
+
+const EntryTrace* CurrentEntryTrace() { return impl::current_entry_trace; }
+
 }  // namespace raft
 } /* namespace sharkstore */
@@ -1,6 +1,7 @@
 _Pragma("once");
 
 #include <list>
+#include <unordered_map>
 #include "raft/options.h"
 #include "raft/raft.h"
 
@@ -60,13 +61,22 @@ public:
     void ReportSnapSendResult(const SnapContext& ctx, const SnapResult& result);
     void ReportSnapApplyResult(const SnapContext& ctx, const SnapResult& result);
 
+    // 在线程池里的路由，按负载迁移时使用
+    const std::shared_ptr<WorkRoute>& ConsensusRoute() const { return consensus_route_; }
+    const std::shared_ptr<WorkRoute>& ApplyRoute() const { return apply_route_; }
+
 private:
     void initPublish();
 
     void post(const std::function<void()>& f);
     bool tryPost(const std::function<void()>& f);
 
-    void smApply(const EntryPtr& e);
+    void smApply(const EntryPtr& e, const EntryTrace& trace);
+
+    // 本地提交的日志在raft内部各阶段的时间，只在consensus线程访问
+    void traceProposal(uint64_t prev_last_index, int64_t step_time);
+    void tracePersist(uint64_t prev_last_index);
+    void takeTrace(uint64_t index, EntryTrace* trace);
 
     void sendMessages();
     void sendSnapshot();
@@ -82,6 +92,8 @@ private:
     const RaftServerOptions sops_;
     const RaftOptions ops_;
     const RaftContext ctx_;
+    std::shared_ptr<WorkRoute> consensus_route_;
+    std::shared_ptr<WorkRoute> apply_route_;  // apply_in_place时为nullptr
 
     std::atomic<bool> stopped_ = {false};
 
@@ -93,6 +105,8 @@ private:
     pb::HardState prev_hard_state_;
     bool conf_changed_ = false;
     std::atomic<uint64_t> tick_count_ = {0};
+
+    std::unordered_map<uint64_t, EntryTrace> traces_;
 };
 
 } /* namespace impl */
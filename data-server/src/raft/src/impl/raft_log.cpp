@@ -10,8 +10,9 @@ namespace sharkstore {
 namespace raft {
 namespace impl {
 
-RaftLog::RaftLog(uint64_t id, const std::shared_ptr<storage::Storage>& s)
-    : id_(id), storage_(s) {
+RaftLog::RaftLog(uint64_t id, const std::shared_ptr<storage::Storage>& s,
+                 EntryCache* cache)
+    : id_(id), storage_(s), cache_(cache) {
     auto status = open();
     if (!status.ok()) {
         throw RaftException(status);
@@ -35,6 +36,11 @@ Status RaftLog::open() {
     committed_ = first_index - 1;
     applied_ = first_index - 1;
 
+    // 同一个id之前的raft(已经被删除)可能还有缓存
+    if (cache_ != nullptr) {
+        cache_->Remove(id_);
+    }
+
     return Status::OK();
 }
 
@@ -166,6 +172,9 @@ uint64_t RaftLog::append(const std::vector<EntryPtr>& ents) {
         throw RaftException(ss.str());
     }
     unstable_->truncateAndAppend(ents);
+    if (cache_ != nullptr) {
+        cache_->Append(id_, ents);
+    }
     return lastIndex();
 }
 
@@ -246,6 +255,9 @@ void RaftLog::restore(uint64_t index) {
     committed_ = index;
     applied_ = index;
     unstable_->restore(index);
+    if (cache_ != nullptr) {
+        cache_->Remove(id_);
+    }
 }
 
 void limitSize(std::vector<EntryPtr>& ents, uint64_t max_size) {
@@ -277,8 +289,28 @@ Status RaftLog::slice(uint64_t lo, uint64_t hi, uint64_t max_size,
 
     if (lo < unstable_->offset()) {  // 需要从存储读
         uint64_t index = std::min(hi, unstable_->offset());
+        // 先从缓存里拿，剩下的再读存储
+        uint64_t start = lo;
+        auto begin = ents->size();
+        if (cache_ != nullptr) {
+            start = cache_->Get(id_, lo, index, max_size, ents);
+        }
         bool compacted = false;
-        auto s = storage_->Entries(lo, index, max_size, ents, &compacted);
+        Status s;
+        if (start < index) {
+            // 存储只需要读剩下的额度
+            uint64_t budget = max_size;
+            if (max_size != kNoLimit) {
+                uint64_t cached = 0;
+                for (auto i = begin; i < ents->size(); ++i) {
+                    cached += (*ents)[i]->ByteSizeLong();
+                }
+                budget = cached < max_size ? max_size - cached : 0;
+            }
+            if (budget > 0 || ents->size() == begin) {
+                s = storage_->Entries(start, index, budget, ents, &compacted);
+            }
+        }
         if (compacted) {
             return Status(Status::kCompacted);
         } else if (!s.ok()) {
@@ -288,6 +320,7 @@ Status RaftLog::slice(uint64_t lo, uint64_t hi, uint64_t max_size,
             throw RaftException(ss.str());
         } else {
             if (ents->size() < index - lo) {  // 提前退出，不需要再拿unstable
+                limitSize(*ents, max_size);
                 return Status::OK();
             }
         }
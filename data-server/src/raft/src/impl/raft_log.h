@@ -3,6 +3,7 @@ _Pragma("once");
 #include <memory>
 
 #include "base/status.h"
+#include "entry_cache.h"
 #include "raft_log_unstable.h"
 #include "raft_types.h"
 
@@ -16,7 +17,9 @@ class Storage;
 
 class RaftLog {
 public:
-    explicit RaftLog(uint64_t id, const std::shared_ptr<storage::Storage>& s);
+    // cache为nullptr时不使用日志缓存
+    RaftLog(uint64_t id, const std::shared_ptr<storage::Storage>& s,
+            EntryCache* cache = nullptr);
     ~RaftLog() = default;
 
     RaftLog(const RaftLog&) = delete;
@@ -84,6 +87,7 @@ private:
     const uint64_t id_;
     std::shared_ptr<storage::Storage> storage_;
     std::unique_ptr<UnstableLog> unstable_;
+    EntryCache* const cache_ = nullptr;
     uint64_t committed_{0};
     uint64_t applied_{0};
 };
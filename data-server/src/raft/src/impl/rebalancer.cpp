@@ -0,0 +1,147 @@
+#include "rebalancer.h"
+
+#include <algorithm>
+
+#include "logger.h"
+#include "work_thread.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+unsigned ThreadLoad::Percent(uint64_t period_ns) const {
+    if (rejects > 0) return 100;
+    if (period_ns == 0) return 0;
+    return static_cast<unsigned>(std::min<uint64_t>(100, busy_ns * 100 / period_ns));
+}
+
+std::string RebalanceDecision::ToString() const {
+    return "raft[" + std::to_string(owner) + "] thread " + std::to_string(from) + "(" +
+           std::to_string(from_percent) + "%) -> " + std::to_string(to) + "(" +
+           std::to_string(to_percent) + "%), load " + std::to_string(owner_percent) + "%";
+}
+
+bool PlanRebalance(const std::vector<ThreadLoad>& loads, uint64_t period_ns,
+                   unsigned busy_percent, unsigned imbalance_percent,
+                   const std::function<bool(uint64_t owner, size_t from)>& movable,
+                   RebalanceDecision* decision) {
+    if (loads.size() < 2 || period_ns == 0) return false;
+
+    size_t hot = 0, cold = 0;
+    std::vector<unsigned> percents;
+    for (size_t i = 0; i < loads.size(); ++i) {
+        percents.push_back(loads[i].Percent(period_ns));
+        if (percents[i] > percents[hot]) hot = i;
+        if (percents[i] < percents[cold]) cold = i;
+    }
+    if (percents[hot] < busy_percent || percents[hot] - percents[cold] < imbalance_percent) {
+        return false;
+    }
+
+    size_t active = 0;
+    for (const auto& kv : loads[hot].owners) {
+        if (kv.second > 0) ++active;
+    }
+    if (active < 2) return false;
+
+    uint64_t limit = (percents[hot] - percents[cold]) * period_ns / 100 / 2;
+    uint64_t best_owner = 0, best_ns = 0;
+    for (const auto& kv : loads[hot].owners) {
+        if (kv.second > best_ns && kv.second <= limit && movable(kv.first, hot)) {
+            best_owner = kv.first;
+            best_ns = kv.second;
+        }
+    }
+    if (best_owner == 0) return false;
+
+    decision->owner = best_owner;
+    decision->from = hot;
+    decision->to = cold;
+    decision->from_percent = percents[hot];
+    decision->to_percent = percents[cold];
+    decision->owner_percent = static_cast<unsigned>(best_ns * 100 / period_ns);
+    return true;
+}
+
+const uint64_t Rebalancer::kCooldownRounds;
+const size_t Rebalancer::kMaxDecisions;
+
+Rebalancer::Rebalancer(const std::string& name, const std::vector<WorkThread*>& threads,
+                       bool enable, unsigned busy_percent, unsigned imbalance_percent)
+    : name_(name),
+      threads_(threads),
+      enable_(enable),
+      busy_percent_(busy_percent),
+      imbalance_percent_(imbalance_percent),
+      last_time_(std::chrono::steady_clock::now()),
+      busy_percents_(threads.size(), 0) {}
+
+void Rebalancer::Run(const std::function<std::shared_ptr<WorkRoute>(uint64_t)>& route_of) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t period_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_time_).count());
+    last_time_ = now;
+    ++round_;
+
+    std::vector<ThreadLoad> loads(threads_.size());
+    std::vector<uint64_t> percents;
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        auto& load = loads[i];
+        threads_[i]->takeLoad(&load.busy_ns, &load.owners, &load.rejects);
+        percents.push_back(load.Percent(period_ns));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        busy_percents_.swap(percents);
+    }
+
+    if (!enable_) return;
+
+    for (auto it = moved_rounds_.begin(); it != moved_rounds_.end();) {
+        if (round_ - it->second > kCooldownRounds) {
+            it = moved_rounds_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto movable = [&](uint64_t owner, size_t from) {
+        if (moved_rounds_.find(owner) != moved_rounds_.end()) return false;
+        auto route = route_of(owner);
+        // 统计周期内可能已经被删除或者迁走了
+        return route != nullptr && !route->migrating() && route->thread() == threads_[from];
+    };
+    RebalanceDecision decision;
+    if (!PlanRebalance(loads, period_ns, busy_percent_, imbalance_percent_, movable,
+                       &decision)) {
+        return;
+    }
+
+    auto route = route_of(decision.owner);
+    if (route == nullptr || !route->migrate(threads_[decision.to])) {
+        return;
+    }
+    moved_rounds_[decision.owner] = round_;
+
+    auto desc = decision.ToString();
+    LOG_INFO("raft[rebalance] %s %s", name_.c_str(), desc.c_str());
+
+    std::lock_guard<std::mutex> lock(mu_);
+    ++migrations_;
+    decisions_.push_back(name_ + ": " + desc);
+    if (decisions_.size() > kMaxDecisions) {
+        decisions_.pop_front();
+    }
+}
+
+void Rebalancer::GetStatus(std::vector<uint64_t>* busy_percents, uint64_t* migrations,
+                           std::vector<std::string>* decisions) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    *busy_percents = busy_percents_;
+    *migrations += migrations_;
+    decisions->insert(decisions->end(), decisions_.begin(), decisions_.end());
+}
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
@@ -0,0 +1,88 @@
+_Pragma("once");
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+
+class WorkThread;
+class WorkRoute;
+
+// 一个线程在一个统计周期内的负载
+struct ThreadLoad {
+    uint64_t busy_ns = 0;
+    uint64_t rejects = 0;                          // 队列满被拒绝的次数
+    std::unordered_map<uint64_t, uint64_t> owners;  // 每个raft的耗时
+
+    // 繁忙时间占比，队列满过的算100
+    unsigned Percent(uint64_t period_ns) const;
+};
+
+struct RebalanceDecision {
+    uint64_t owner = 0;
+    size_t from = 0;
+    size_t to = 0;
+    unsigned from_percent = 0;
+    unsigned to_percent = 0;
+    unsigned owner_percent = 0;
+
+    std::string ToString() const;
+};
+
+// 从最忙的线程选一个raft迁到最闲的线程
+// 选负载不超过两个线程差距一半的raft里最大的一个，避免迁过去以后目标线程变成最忙的
+// 最忙的线程上只有一个raft在干活时迁移没有意义，不迁
+bool PlanRebalance(const std::vector<ThreadLoad>& loads, uint64_t period_ns,
+                   unsigned busy_percent, unsigned imbalance_percent,
+                   const std::function<bool(uint64_t owner, size_t from)>& movable,
+                   RebalanceDecision* decision);
+
+// 一个线程池的负载统计和迁移，只在tick线程里调用Run
+class Rebalancer {
+public:
+    // 迁移过的raft几个周期内不再迁移，防止来回迁
+    static const uint64_t kCooldownRounds = 3;
+    // 保留最近几条迁移记录
+    static const size_t kMaxDecisions = 16;
+
+    Rebalancer(const std::string& name, const std::vector<WorkThread*>& threads,
+               bool enable, unsigned busy_percent, unsigned imbalance_percent);
+
+    Rebalancer(const Rebalancer&) = delete;
+    Rebalancer& operator=(const Rebalancer&) = delete;
+
+    // 收集上个周期的负载，必要时迁移一个raft
+    // route_of返回raft在这个线程池里的路由，raft不存在时返回nullptr
+    void Run(const std::function<std::shared_ptr<WorkRoute>(uint64_t)>& route_of);
+
+    void GetStatus(std::vector<uint64_t>* busy_percents, uint64_t* migrations,
+                   std::vector<std::string>* decisions) const;
+
+private:
+    const std::string name_;
+    const std::vector<WorkThread*> threads_;
+    const bool enable_ = true;
+    const unsigned busy_percent_ = 0;
+    const unsigned imbalance_percent_ = 0;
+
+    std::chrono::steady_clock::time_point last_time_;
+    uint64_t round_ = 0;
+    std::unordered_map<uint64_t, uint64_t> moved_rounds_;  // raft最近一次迁移的周期
+
+    mutable std::mutex mu_;
+    std::vector<uint64_t> busy_percents_;
+    uint64_t migrations_ = 0;
+    std::deque<std::string> decisions_;
+};
+
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
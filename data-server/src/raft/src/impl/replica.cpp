@@ -1,5 +1,7 @@
 #include "replica.h"
 
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 #include "raft_exception.h"
 
@@ -9,49 +11,136 @@ namespace impl {
 
 Inflight::Inflight(int max) : capacity_(max), buffer_(max) {}
 
-void Inflight::add(uint64_t index) {
+void Inflight::add(uint64_t index, uint64_t bytes, int64_t sent_us) {
     if (full()) {
         throw RaftException("inflight.add cannot add into a full inflights.");
     }
 
     int idx = (start_ + count_) % capacity_;
-    buffer_[idx] = index;
+    auto& item = buffer_[idx];
+    item.index = index;
+    item.bytes = bytes;
+    item.sent_us = sent_us;
+    item.delivered = delivered_;
     ++count_;
+    bytes_ += bytes;
 }
 
-void Inflight::freeTo(uint64_t index) {
-    if (0 == count_ || index < buffer_[start_]) {
-        return;
+uint64_t Inflight::freeTo(uint64_t index, InflightItem* last) {
+    if (0 == count_ || index < buffer_[start_].index) {
+        return 0;
     }
+    uint64_t freed = 0;
     int i = 0, idx = start_;
     for (; i < count_; ++i) {
-        if (index < buffer_[idx]) {
+        if (index < buffer_[idx].index) {
             break;
         }
+        freed += buffer_[idx].bytes;
+        if (last != nullptr) *last = buffer_[idx];
         ++idx;
         idx %= capacity_;
     }
     count_ -= i;
     start_ = idx;
+    bytes_ -= freed;
+    delivered_ += freed;
+    return freed;
 }
 
-void Inflight::freeFirstOne() { freeTo(buffer_[start_]); }
+uint64_t Inflight::freeFirstOne() {
+    if (0 == count_) return 0;
+    return freeTo(buffer_[start_].index);
+}
 
 bool Inflight::full() const { return count_ == capacity_; }
 
-void Inflight::reset() {
+uint64_t Inflight::reset() {
+    auto bytes = bytes_;
     count_ = 0;
     start_ = 0;
+    bytes_ = 0;
+    return bytes;
+}
+
+static int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
 
 Replica::Replica(const Peer& peer, int max_inflight)
-    : peer_(peer), inflight_(max_inflight) {}
+    : peer_(peer), inflight_(max_inflight), window_(0, 0, false) {}
+
+Replica::Replica(const Peer& peer, int max_inflight, const FlowWindow& window,
+                 std::shared_ptr<InflightBudget::Node> node)
+    : peer_(peer), inflight_(max_inflight), window_(window), node_(std::move(node)) {}
+
+Replica::~Replica() { releaseInflight(inflight_.reset()); }
 
 void Replica::resetState(ReplicaState state) {
     paused_ = false;
     pendingSnap_ = 0;
     state_ = state;
-    inflight_.reset();
+    releaseInflight(inflight_.reset());
+}
+
+void Replica::releaseInflight(uint64_t bytes) {
+    if (node_ && bytes > 0) {
+        node_->bytes -= bytes;
+    }
+}
+
+const int64_t Replica::kMinInflightRtoUs;
+
+void Replica::sentEntries(uint64_t last, uint64_t bytes) {
+    sentEntries(last, bytes, nowMicros());
+}
+
+void Replica::sentEntries(uint64_t last, uint64_t bytes, int64_t now_us) {
+    if (inflight_.count() == 0) {
+        progress_us_ = now_us;
+    }
+    inflight_.add(last, bytes, now_us);
+    if (node_) {
+        node_->bytes += bytes;
+    }
+}
+
+void Replica::ackEntries(uint64_t index) { ackEntries(index, nowMicros()); }
+
+void Replica::ackEntries(uint64_t index, int64_t now_us) {
+    InflightItem last;
+    auto freed = inflight_.freeTo(index, &last);
+    if (freed == 0) return;
+
+    releaseInflight(freed);
+    progress_us_ = now_us;
+    window_.onAck(now_us - last.sent_us, inflight_.delivered() - last.delivered, now_us);
+}
+
+bool Replica::checkInflightLoss() { return checkInflightLoss(nowMicros()); }
+
+bool Replica::checkInflightLoss(int64_t now_us) {
+    if (!inflightFull()) return false;
+    auto rto = std::max(kMinInflightRtoUs, window_.srtt_us() * 4);
+    if (now_us - progress_us_ < rto) return false;
+
+    releaseInflight(inflight_.freeFirstOne());
+    window_.onLoss();
+    progress_us_ = now_us;
+    return true;
+}
+
+bool Replica::inflightFull() const {
+    return inflight_.full() ||
+           (inflight_.count() > 0 && window_.size() > 0 && inflight_.bytes() >= window_.size());
+}
+
+bool Replica::sendBlocked() const {
+    if (inflightFull()) return true;
+    // 没有在途的复制时总是可以发，保证每个副本都能推进
+    return inflight_.count() > 0 && node_ && node_->full();
 }
 
 void Replica::becomeProbe() {
@@ -140,7 +229,7 @@ bool Replica::isPaused() const {
         case ReplicaState::kSnapshot:
             return true;
         default:
-            return inflight_.full();
+            return sendBlocked();
     }
 }
 
@@ -148,7 +237,8 @@ std::string Replica::ToString() const {
     std::ostringstream ss;
     ss << "next=" << next_ << ", match=" << match_ << ", commit=" << committed_
        << ", state=" << ReplicateStateName(state_)
-       << ", pendingSnapshot=" << pendingSnap_;
+       << ", pendingSnapshot=" << pendingSnap_ << ", inflight=" << inflight_.count() << "/"
+       << inflight_.bytes() << ", window=" << window_.size();
     return ss.str();
 }
 
@@ -1,5 +1,6 @@
 _Pragma("once");
 
+#include "flow_control.h"
 #include "raft.pb.h"
 #include "raft_types.h"
 
@@ -7,6 +8,14 @@ namespace sharkstore {
 namespace raft {
 namespace impl {
 
+// 一次还没确认的复制
+struct InflightItem {
+    uint64_t index = 0;      // 最后一条日志的index
+    uint64_t bytes = 0;      // 消息大小
+    int64_t sent_us = 0;     // 发送时间
+    uint64_t delivered = 0;  // 发送时已确认的总字节数
+};
+
 class Inflight {
 public:
     explicit Inflight(int max);
@@ -14,23 +23,39 @@ public:
     Inflight(const Inflight&) = delete;
     Inflight& operator=(const Inflight&) = delete;
 
-    void add(uint64_t index);
-    void freeTo(uint64_t index);
-    void freeFirstOne();
+    void add(uint64_t index) { add(index, 0, 0); }
+    void add(uint64_t index, uint64_t bytes, int64_t sent_us);
+    // 返回释放的字节数，last返回释放的最后一个
+    uint64_t freeTo(uint64_t index, InflightItem* last = nullptr);
+    uint64_t freeFirstOne();
     bool full() const;
-    void reset();
+    // 返回重置前还没确认的字节数
+    uint64_t reset();
+
+    int count() const { return count_; }
+    uint64_t bytes() const { return bytes_; }
+    // 启动以来确认的总字节数
+    uint64_t delivered() const { return delivered_; }
 
 private:
-    const int capacity_ = 0;        // 循环buffer的大小
-    std::vector<uint64_t> buffer_;  // 循环buffer
+    const int capacity_ = 0;            // 循环buffer的大小
+    std::vector<InflightItem> buffer_;  // 循环buffer
     int start_ = 0;
     int count_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t delivered_ = 0;
 };
 
 class Replica {
 public:
+    // 判断在途复制丢失的超时下限，实际取max(下限, 4 * srtt)
+    static const int64_t kMinInflightRtoUs = 1000 * 1000;
+
     explicit Replica(const Peer& peer, int max_inflight = 0);
-    ~Replica() = default;
+    // 按字节限制复制窗口，node为发往同一节点的所有副本共享的计数(可以为空)
+    Replica(const Peer& peer, int max_inflight, const FlowWindow& window,
+            std::shared_ptr<InflightBudget::Node> node);
+    ~Replica();
 
     Replica(const Replica&) = delete;
     Replica& operator=(const Replica&) = delete;
@@ -39,6 +64,21 @@ public:
     bool is_learner() const { return peer_.type == PeerType::kLearner; }
 
     Inflight& inflight() { return inflight_; }
+    const Inflight& inflight() const { return inflight_; }
+    const FlowWindow& window() const { return window_; }
+
+    // 发送了一批日志，last为最后一条的index
+    void sentEntries(uint64_t last, uint64_t bytes);
+    void sentEntries(uint64_t last, uint64_t bytes, int64_t now_us);
+    // 确认到index的日志，更新窗口
+    void ackEntries(uint64_t index);
+    void ackEntries(uint64_t index, int64_t now_us);
+    // 条数或者字节数达到了窗口上限
+    bool inflightFull() const;
+    // 心跳回应时调用：窗口满并且超过rto没有确认推进时，当作丢失释放第一个、窗口减半
+    // 窗口满但一直有确认时不算丢失，返回是否释放
+    bool checkInflightLoss();
+    bool checkInflightLoss(int64_t now_us);
 
     uint64_t next() const { return next_; }
     void set_next(uint64_t next) { next_ = next; }
@@ -73,10 +113,18 @@ public:
 
     std::string ToString() const;
 
+private:
+    bool sendBlocked() const;
+    void releaseInflight(uint64_t bytes);
+
 private:
     Peer peer_;
     ReplicaState state_{ReplicaState::kProbe};
     Inflight inflight_;
+    FlowWindow window_;
+    std::shared_ptr<InflightBudget::Node> node_;
+    // 最近一次确认推进(或者从空开始发送)的时间
+    int64_t progress_us_ = 0;
 
     bool paused_ = false;
     uint64_t inactive_ticks_ = 0;
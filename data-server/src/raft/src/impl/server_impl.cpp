@@ -2,10 +2,15 @@
 
 #include <thread>
 
+#include "entry_cache.h"
+#include "flow_control.h"
+#include "log_gc.h"
 #include "logger.h"
 #include "raft_exception.h"
 #include "raft_impl.h"
+#include "rebalancer.h"
 #include "snapshot/manager.h"
+#include "storage/log_file_pool.h"
 #include "transport/fast_transport.h"
 #include "transport/inprocess_transport.h"
 #include "transport/transport.h"
@@ -54,13 +59,35 @@ Status RaftServerImpl::Start() {
     LOG_INFO("raft[server] %d apply threads start. queue capacity=%d",
              ops_.apply_threads_num, ops_.apply_queue_capacity);
 
+    if (ops_.rebalance_interval.count() > 0) {
+        consensus_rebalancer_.reset(new Rebalancer(
+            "consensus", consensus_threads_, ops_.enable_rebalance,
+            ops_.rebalance_busy_percent, ops_.rebalance_imbalance_percent));
+        if (!ops_.apply_in_place) {
+            apply_rebalancer_.reset(new Rebalancer(
+                "apply", apply_threads_, ops_.enable_rebalance, ops_.rebalance_busy_percent,
+                ops_.rebalance_imbalance_percent));
+        }
+        last_rebalance_ = std::chrono::steady_clock::now();
+        LOG_INFO("raft[server] rebalance %s, interval=%lds, busy=%u%%, imbalance=%u%%",
+                 ops_.enable_rebalance ? "enabled" : "disabled",
+                 static_cast<long>(ops_.rebalance_interval.count()),
+                 ops_.rebalance_busy_percent, ops_.rebalance_imbalance_percent);
+    }
+
     // start transport
-    if (ops_.transport_options.use_inprocess_transport) {
-        transport_.reset(new transport::InProcessTransport(ops_.node_id));
+    const auto& tops = ops_.transport_options;
+    if (tops.use_inprocess_transport) {
+        transport_.reset(new transport::InProcessTransport(
+            ops_.node_id, tops.compression, tops.compression_threshold));
     } else {
-        transport_.reset(new transport::FastTransport(ops_.transport_options.resolver,
-                                                  ops_.transport_options.send_io_threads,
-                                                  ops_.transport_options.recv_io_threads));
+        transport_.reset(new transport::FastTransport(
+            tops.resolver, tops.send_io_threads, tops.recv_io_threads, tops.use_io_uring,
+            tops.compression, tops.compression_threshold));
+    }
+    if (tops.compression != CompressionType::kNone) {
+        LOG_INFO("raft[server] transport compression=%s, threshold=%lu",
+                 CompressionTypeName(tops.compression).c_str(), tops.compression_threshold);
     }
     status = transport_->Start(
         ops_.transport_options.listen_ip, ops_.transport_options.listen_port,
@@ -73,6 +100,28 @@ Status RaftServerImpl::Start() {
     assert(snapshot_manager_ == nullptr);
     snapshot_manager_.reset(new SnapshotManager(ops_.snapshot_options));
 
+    if (ops_.entry_cache_capacity > 0) {
+        entry_cache_.reset(new EntryCache(ops_.entry_cache_capacity));
+        LOG_INFO("raft[server] entry cache capacity=%lu", ops_.entry_cache_capacity);
+    }
+    inflight_budget_.reset(new InflightBudget(ops_.max_inflight_bytes_per_node));
+    log_disk_budget_.reset(new LogDiskBudget(ops_.log_disk_budget));
+    if (ops_.log_disk_budget > 0) {
+        LOG_INFO("raft[server] log disk budget=%lu", ops_.log_disk_budget);
+    }
+
+    if (!ops_.log_recycle_path.empty() && ops_.log_recycle_files > 0) {
+        log_file_pool_.reset(
+            new storage::LogFilePool(ops_.log_recycle_path, ops_.log_recycle_files));
+        status = log_file_pool_->Open();
+        if (!status.ok()) {
+            return status;
+        }
+        LOG_INFO("raft[server] log recycle path=%s, capacity=%lu, files=%lu",
+                 ops_.log_recycle_path.c_str(), ops_.log_recycle_files,
+                 log_file_pool_->Size());
+    }
+
     running_ = true;
     tick_thr_.reset(new std::thread([this]() {
         tickRoutine(); }));
@@ -129,6 +178,10 @@ Status RaftServerImpl::CreateRaft(const RaftOptions& ops, std::shared_ptr<Raft>*
     RaftContext ctx;
     ctx.msg_sender = transport_.get();
     ctx.snapshot_manager = snapshot_manager_.get();
+    ctx.entry_cache = entry_cache_.get();
+    ctx.inflight_budget = inflight_budget_.get();
+    ctx.log_file_pool = log_file_pool_.get();
+    ctx.log_disk_budget = log_disk_budget_.get();
     ctx.consensus_thread = consensus_threads_[counter % consensus_threads_.size()];
     if (!ops_.apply_in_place) {
         ctx.apply_thread = apply_threads_[counter % apply_threads_.size()];
@@ -169,6 +222,7 @@ Status RaftServerImpl::RemoveRaft(uint64_t id) {
             r = it->second;
             r->Stop();
             all_rafts_.erase(it);
+            if (entry_cache_) entry_cache_->Remove(id);
         } else {
             auto it_cr = creating_rafts_.find(id);
             if (it_cr != creating_rafts_.end()) { // in creating
@@ -193,6 +247,7 @@ Status RaftServerImpl::DestroyRaft(uint64_t id, bool backup) {
             r = it->second;
             r->Stop();
             all_rafts_.erase(it);
+            if (entry_cache_) entry_cache_->Remove(id);
         } else {
             auto it_cr = creating_rafts_.find(id);
             if (it_cr != creating_rafts_.end()) { // in creating
@@ -236,6 +291,60 @@ void RaftServerImpl::GetStatus(ServerStatus* status) const {
     status->total_snap_sending = snapshot_manager_->SendingCount();
     status->total_snap_applying = snapshot_manager_->ApplyingCount();
     status->total_rafts_count  = raftSize();
+
+    status->consensus_queue_sizes.clear();
+    for (auto t : consensus_threads_) {
+        status->consensus_queue_sizes.push_back(static_cast<uint64_t>(t->size()));
+    }
+    status->apply_queue_sizes.clear();
+    for (auto t : apply_threads_) {
+        status->apply_queue_sizes.push_back(static_cast<uint64_t>(t->size()));
+    }
+
+    status->rebalance_migrations = 0;
+    status->rebalance_decisions.clear();
+    if (consensus_rebalancer_) {
+        consensus_rebalancer_->GetStatus(&status->consensus_busy_percents,
+                                         &status->rebalance_migrations,
+                                         &status->rebalance_decisions);
+    }
+    if (apply_rebalancer_) {
+        apply_rebalancer_->GetStatus(&status->apply_busy_percents,
+                                     &status->rebalance_migrations,
+                                     &status->rebalance_decisions);
+    }
+
+    if (entry_cache_) {
+        status->entry_cache_capacity = entry_cache_->Capacity();
+        status->entry_cache_size = entry_cache_->Size();
+        status->entry_cache_hits = entry_cache_->Hits();
+        status->entry_cache_misses = entry_cache_->Misses();
+    }
+
+    if (inflight_budget_) {
+        status->inflight_bytes_capacity_per_node = inflight_budget_->Capacity();
+        inflight_budget_->Collect(&status->inflight_bytes_per_node);
+    }
+
+    if (log_disk_budget_) {
+        status->log_disk_bytes = log_disk_budget_->Bytes();
+        status->log_disk_free_bytes = log_disk_budget_->FreeBytes();
+        status->log_disk_budget = log_disk_budget_->Capacity();
+    }
+
+    if (log_file_pool_) {
+        status->log_pool_capacity = log_file_pool_->Capacity();
+        status->log_pool_files = log_file_pool_->Size();
+        status->log_recycled_files = log_file_pool_->Recycled();
+        status->log_reused_files = log_file_pool_->Reused();
+    }
+
+    transport::CompressionStats cstats;
+    transport_->GetCompressionStats(&cstats);
+    status->compress_raw_bytes = cstats.raw_bytes;
+    status->compress_sent_bytes = cstats.compressed_bytes;
+    status->compressed_msgs = cstats.compressed_msgs;
+    status->compress_skipped_msgs = cstats.skipped_msgs;
 }
 
 void RaftServerImpl::onMessage(MessagePtr& msg) {
@@ -345,10 +454,40 @@ void RaftServerImpl::tickRoutine() {
         }
         sendHeartbeat(rafts);
         stepTick(rafts);
+        rebalance(rafts);
         printMetrics();
     }
 }
 
+void RaftServerImpl::rebalance(const RaftMapType& rafts) {
+    if (!consensus_rebalancer_) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_rebalance_ < ops_.rebalance_interval) return;
+    last_rebalance_ = now;
+
+    consensus_rebalancer_->Run([&rafts](uint64_t id) -> std::shared_ptr<WorkRoute> {
+        auto it = rafts.find(id);
+        return it == rafts.end() ? nullptr : it->second->ConsensusRoute();
+    });
+    if (apply_rebalancer_) {
+        apply_rebalancer_->Run([&rafts](uint64_t id) -> std::shared_ptr<WorkRoute> {
+            auto it = rafts.find(id);
+            return it == rafts.end() ? nullptr : it->second->ApplyRoute();
+        });
+    }
+}
+
+static std::string joinNumbers(const std::vector<uint64_t>& nums) {
+    std::string str = "[";
+    for (size_t i = 0; i < nums.size(); ++i) {
+        if (i != 0) str += ", ";
+        str += std::to_string(nums[i]);
+    }
+    str += "]";
+    return str;
+}
+
 void RaftServerImpl::printMetrics() {
     static time_t last = time(NULL);
     time_t now = time(NULL);
@@ -378,6 +517,50 @@ void RaftServerImpl::printMetrics() {
             apply_metrics += "]";
             LOG_INFO("raft[metric] apply queue size: %s", apply_metrics.c_str());
         }
+
+        if (consensus_rebalancer_) {
+            std::vector<uint64_t> consensus_busy, apply_busy;
+            std::vector<std::string> decisions;
+            uint64_t migrations = 0;
+            consensus_rebalancer_->GetStatus(&consensus_busy, &migrations, &decisions);
+            if (apply_rebalancer_) {
+                apply_rebalancer_->GetStatus(&apply_busy, &migrations, &decisions);
+            }
+            LOG_INFO("raft[metric] consensus busy percent: %s, apply busy percent: %s, "
+                     "migrations: %lu",
+                     joinNumbers(consensus_busy).c_str(), joinNumbers(apply_busy).c_str(),
+                     migrations);
+        }
+
+        if (entry_cache_) {
+            LOG_INFO("raft[metric] entry cache size: %lu, capacity: %lu, hits: %lu, misses: %lu",
+                     entry_cache_->Size(), entry_cache_->Capacity(), entry_cache_->Hits(),
+                     entry_cache_->Misses());
+        }
+
+        if (inflight_budget_) {
+            std::map<uint64_t, uint64_t> inflight;
+            inflight_budget_->Collect(&inflight);
+            std::string ss;
+            for (const auto& kv : inflight) {
+                if (kv.second == 0) continue;
+                if (!ss.empty()) ss += ", ";
+                ss += std::to_string(kv.first) + ":" + std::to_string(kv.second);
+            }
+            if (!ss.empty()) {
+                LOG_INFO("raft[metric] inflight replication bytes per node: %s, capacity: %lu",
+                         ss.c_str(), inflight_budget_->Capacity());
+            }
+        }
+
+        if (ops_.transport_options.compression != CompressionType::kNone) {
+            transport::CompressionStats cstats;
+            transport_->GetCompressionStats(&cstats);
+            LOG_INFO("raft[metric] transport compress bytes: %lu -> %lu, compressed msgs: %lu, "
+                     "skipped msgs: %lu",
+                     cstats.raw_bytes, cstats.compressed_bytes, cstats.compressed_msgs,
+                     cstats.skipped_msgs);
+        }
     }
 }
 
@@ -1,6 +1,7 @@
 _Pragma("once");
 
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -16,6 +17,14 @@ namespace impl {
 class RaftImpl;
 class WorkThread;
 class SnapshotManager;
+class EntryCache;
+class InflightBudget;
+class LogDiskBudget;
+class Rebalancer;
+
+namespace storage {
+class LogFilePool;
+}
 
 namespace transport {
 class Transport;
@@ -53,6 +62,7 @@ private:
     void onHeartbeatResp(MessagePtr& msg);
 
     void stepTick(const RaftMapType& rafts);
+    void rebalance(const RaftMapType& rafts);
     void printMetrics();
     void tickRoutine();
 
@@ -67,10 +77,19 @@ private:
 
     std::unique_ptr<transport::Transport> transport_;
     std::unique_ptr<SnapshotManager> snapshot_manager_;
+    std::unique_ptr<EntryCache> entry_cache_;
+    std::unique_ptr<InflightBudget> inflight_budget_;
+    std::unique_ptr<storage::LogFilePool> log_file_pool_;
+    std::unique_ptr<LogDiskBudget> log_disk_budget_;
 
     std::vector<WorkThread*> consensus_threads_;
     std::vector<WorkThread*> apply_threads_;
 
+    // 统计线程负载，按负载迁移raft
+    std::unique_ptr<Rebalancer> consensus_rebalancer_;
+    std::unique_ptr<Rebalancer> apply_rebalancer_;
+    std::chrono::steady_clock::time_point last_rebalance_;
+
     MessagePtr tick_msg_;
     // TODO: more tick threads or put ticks into consensus_threads
     std::unique_ptr<std::thread> tick_thr_;
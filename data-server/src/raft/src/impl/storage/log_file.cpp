@@ -4,6 +4,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <fstream>
 #include "base/util.h"
 
@@ -17,13 +18,16 @@ namespace storage {
 
 static const size_t kLogWriteBufSize = 1024 * 16;
 
-LogFile::LogFile(const std::string& path, uint64_t seq, uint64_t index, bool readonly) :
+LogFile::LogFile(const std::string& path, uint64_t seq, uint64_t index, bool readonly,
+                 size_t prealloc_size, uint64_t raft_id) :
     seq_(seq),
     index_(index),
     file_path_(makeFilePath(path, seq, index)),
-    readonly_(readonly) {
+    readonly_(readonly),
+    prealloc_size_(readonly ? 0 : prealloc_size),
+    log_number_(makeLogNumber(raft_id, seq, index)) {
     if (!readonly_) {
-        write_buf_.resize(kLogWriteBufSize);
+        write_buf_.reserve(kLogWriteBufSize + sizeof(Record));
     }
 }
 
@@ -34,24 +38,13 @@ std::string LogFile::makeFilePath(const std::string& path, uint64_t seq, uint64_
 }
 
 Status LogFile::Open(bool allow_corrupt, bool last_one) {
-    // open fd
-    int oflag = readonly_ ? O_RDONLY : (O_CREAT | O_APPEND | O_RDWR);
+    // open fd，用pwrite按offset写，不能带O_APPEND
+    int oflag = readonly_ ? O_RDONLY : (O_CREAT | O_RDWR);
     fd_ = ::open(file_path_.c_str(), oflag, 0644);
     if (-1 == fd_) {
         return Status(Status::kIOError, "open", strErrno(errno));
     }
 
-    // open write stream
-    if (!readonly_) {
-        writer_ = ::fdopen(fd_, "a+");
-        if (NULL == writer_) {
-            return Status(Status::kIOError, "fdopen", strErrno(errno));
-        }
-        if (::setvbuf(writer_, write_buf_.data(), _IOFBF, write_buf_.size()) != 0) {
-            return Status(Status::kIOError, "setvbuf", strErrno(errno));
-        }
-    }
-
     // get file size
     struct stat sb;
     memset(&sb, 0, sizeof(sb));
@@ -60,10 +53,11 @@ Status LogFile::Open(bool allow_corrupt, bool last_one) {
         return Status(Status::kIOError, "stat", strErrno(errno));
     } else {
         file_size_ = sb.st_size;
+        alloc_size_ = sb.st_size;
     }
 
     if (file_size_ == 0) {  // 新建文件或者空文件
-        return Status::OK();
+        return preallocate();
     } else {
         if (!last_one) {
             auto s = loadIndexes();
@@ -78,17 +72,33 @@ Status LogFile::Open(bool allow_corrupt, bool last_one) {
                               std::string("recover log file ") + file_path_,
                               s.ToString());
             }
+            return preallocate();
         }
         return Status::OK();
     }
 }
 
+Status LogFile::preallocate() {
+    if (prealloc_size_ == 0 || alloc_size_ >= static_cast<off_t>(prealloc_size_)) {
+        return Status::OK();
+    }
+    // 文件系统支持时是fallocate，不支持时glibc写0填充
+    // 新分配的extent第一次写入时还要转换状态，回收的文件没有这个开销
+    int ret = ::posix_fallocate(fd_, alloc_size_, prealloc_size_ - alloc_size_);
+    if (ret != 0) {
+        return Status(Status::kIOError, "preallocate log file", strErrno(ret));
+    }
+    alloc_size_ = prealloc_size_;
+    return Status::OK();
+}
+
 Status LogFile::Sync() {
     auto s = Flush();
     if (!s.ok()) {
         return s;
     }
-    if (::fsync(fd_) == -1) {
+    // 预分配的文件大小不变，不需要同步元数据
+    if (::fdatasync(fd_) == -1) {
         return Status(Status::kIOError, "sync log file", strErrno(errno));
     } else {
         return Status::OK();
@@ -97,11 +107,13 @@ Status LogFile::Sync() {
 
 Status LogFile::Close() {
     if (fd_ > 0) {
-        int ret = (writer_ != nullptr) ? ::fclose(writer_) : ::close(fd_);
-        if (ret != 0) {
+        if (!write_buf_.empty()) {
+            auto s = flushBuffer();
+            if (!s.ok()) return s;
+        }
+        if (::close(fd_) != 0) {
             return Status(Status::kIOError, "close", strErrno(errno));
         }
-        writer_ = nullptr;
         fd_ = -1;
     }
     return Status::OK();
@@ -128,12 +140,11 @@ Status LogFile::Get(uint64_t index, EntryPtr* e) const {
     std::vector<char> payload;
     auto s = readRecord(offset, &rec, &payload);
     if (!s.ok()) return s;
-    if (rec.type != RecordType::kLogEntry) {
+    if (rec.Type() != RecordType::kLogEntry) {
         return Status(Status::kCorruption, "read log entry", "invalid record type");
     }
 
     EntryPtr entry(new impl::pb::Entry);
-    // TODO: check crc
     if (!entry->ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
         return Status(Status::kCorruption, "read log entry", "deserizial failed");
     }
@@ -187,13 +198,36 @@ Status LogFile::Flush() {
     if (readonly_) {
         return Status(Status::kNotSupported, "flush", "read-only");
     }
-    assert(writer_ != nullptr);
-    int ret = ::fflush(writer_);
-    if (ret == 0) {
+    return flushBuffer();
+}
+
+Status LogFile::flushBuffer() {
+    assert(fd_ > 0);
+    size_t len = write_buf_.size();
+    if (len == 0) {
         return Status::OK();
-    } else {
-        return Status(Status::kIOError, "fflush", strErrno(errno));
     }
+    // 预分配的文件后面可能是回收前的旧数据，跟数据一起写一个结束标记，下一次写入时覆盖
+    if (prealloc_size_ > 0) {
+        write_buf_.resize(len + sizeof(Record), 0);
+    }
+    off_t offset = file_size_ - static_cast<off_t>(len);
+    const char* data = write_buf_.data();
+    size_t left = write_buf_.size();
+    while (left > 0) {
+        auto ret = ::pwrite(fd_, data, left, offset);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            write_buf_.resize(len);
+            return Status(Status::kIOError, "write log file", strErrno(errno));
+        }
+        data += ret;
+        left -= ret;
+        offset += ret;
+    }
+    alloc_size_ = std::max(alloc_size_, offset);
+    write_buf_.clear();
+    return Status::OK();
 }
 
 Status LogFile::Rotate() {
@@ -202,7 +236,6 @@ Status LogFile::Rotate() {
     }
 
     uint32_t offset = static_cast<uint32_t >(file_size_);
-    std::vector<char> buf;
     pb::LogIndex pb_index;
     log_index_.Serialize(&pb_index);
     auto s = writeRecord(RecordType::kIndex, pb_index);
@@ -247,18 +280,22 @@ Status LogFile::loadIndexes() {
 
 Status LogFile::traverse(uint32_t& offset) {
     Status s;
+    bool recyclable = false;
     while (offset < static_cast<uint32_t>(file_size_)) {
         Record rec;
         std::vector<char> payload;
         s = readRecord(offset, &rec, &payload);
-        if (s.code() == Status::kEndofFile) {
+        // 可回收格式的记录后面不会再写老格式的记录，读到的是回收前的旧数据
+        if (s.code() == Status::kEndofFile || (s.ok() && recyclable && !rec.Recyclable())) {
+            file_size_ = offset;
             return Status::OK();
         } else if (!s.ok()) {
             return Status(Status::kCorruption,
                           "read record at offset " + std::to_string(offset),
                           s.ToString());
         }
-        if (rec.type == RecordType::kLogEntry) {
+        recyclable = rec.Recyclable();
+        if (rec.Type() == RecordType::kLogEntry) {
             impl::pb::Entry e;
             if (!e.ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
                 return Status(Status::kCorruption,
@@ -276,7 +313,7 @@ Status LogFile::traverse(uint32_t& offset) {
             } else {
                 log_index_.Append(e.index(), e.term(), offset);
             }
-        } else if (rec.type == RecordType::kIndex) {
+        } else if (rec.Type() == RecordType::kIndex) {
             log_index_.Clear();
             auto s = loadIndexes();
             if (s.ok()) {
@@ -294,7 +331,7 @@ Status LogFile::traverse(uint32_t& offset) {
                 std::string("invalid record type at offset") + std::to_string(offset),
                 std::to_string(rec.type));
         }
-        offset += (sizeof(Record) + payload.size());
+        offset += (rec.HeaderSize() + payload.size());
     }
     return Status::OK();
 }
@@ -325,11 +362,10 @@ Status LogFile::recover(bool allow_corrupt) {
             if (!s.ok()) {
                 return s;
             }
-            int ret = ::ftruncate(fd_, offset);
-            if (-1 == ret) {
-                return Status(Status::kIOError, "truncate log file", strErrno(errno));
+            s = truncateAt(offset);
+            if (!s.ok()) {
+                return s;
             }
-            file_size_ = offset;
             LOG_WARN("[raft log] truncate(offset: %d) and backup corrupt log: %s", offset,
                      file_path_.c_str(), offset);
         }
@@ -373,39 +409,59 @@ Status LogFile::writeFooter(uint32_t index_offset) {
     footer.index_offset = index_offset;
     footer.Encode();
 
-    auto ret = ::fwrite(&footer, sizeof(footer), 1, writer_);
-    if (ret != 1) {
+    auto s = flushBuffer();
+    if (!s.ok()) return s;
+
+    // footer固定在文件末尾，预分配的文件中间留空
+    off_t offset = std::max(file_size_, alloc_size_ - static_cast<off_t>(sizeof(footer)));
+    auto ret = ::pwrite(fd_, &footer, sizeof(footer), offset);
+    if (ret != static_cast<ssize_t>(sizeof(footer))) {
         return Status(Status::kIOError, "write footer", strErrno(errno));
     }
 
-    file_size_ += sizeof(footer);
+    file_size_ = offset + sizeof(footer);
+    alloc_size_ = std::max(alloc_size_, file_size_);
 
     return Status::OK();
 }
 
 Status LogFile::readRecord(off_t offset, Record* rec, std::vector<char>* payload) const {
-    // 读记录头
+    // 读记录头，老格式的记录头短一些，多读的部分属于payload
     memset(rec, 0, sizeof(Record));
     auto ret = ::pread(fd_, rec, sizeof(Record), offset);
     if (ret == -1) {
         return Status(Status::kIOError, "read log record", strErrno(errno));
     } else if (ret == 0) {
         return Status(Status::kEndofFile, "read log record", strErrno(errno));
-    } else if (ret < static_cast<ssize_t>(sizeof(Record))) {
+    } else if (ret < static_cast<ssize_t>(kLegacyRecordHeaderSize)) {
         return Status(Status::kCorruption, "insufficient log record size",
                       std::to_string(ret));
     }
     rec->Decode();
+    if (rec->type == RecordType::kEndMark) {
+        return Status(Status::kEndofFile, "read log record", "end mark");
+    }
+    if (!rec->Recyclable()) {
+        rec->log_number = 0;
+    } else if (ret < static_cast<ssize_t>(sizeof(Record))) {
+        return Status(Status::kCorruption, "insufficient log record size",
+                      std::to_string(ret));
+    } else if (rec->log_number != log_number_) {
+        // 回收前其他日志文件留下的记录
+        return Status(Status::kEndofFile, "read log record",
+                      "stale record of log " + std::to_string(rec->log_number));
+    }
 
     // 检查payload的大小有没超过文件末尾
-    if (offset + sizeof(Record) + rec->size > static_cast<uint64_t>(file_size_)) {
+    size_t header_size = rec->HeaderSize();
+    if (offset + header_size + rec->size > static_cast<uint64_t>(file_size_)) {
         return Status(Status::kCorruption, "log size too large",
                       std::to_string(rec->size));
     }
 
     // 读payload数据
     payload->resize(rec->size);
-    ret = ::pread(fd_, payload->data(), rec->size, offset + sizeof(Record));
+    ret = ::pread(fd_, payload->data(), rec->size, offset + header_size);
     if (ret == -1) {
         return Status(Status::kIOError, "read log record payload", strErrno(errno));
     } else if (static_cast<uint32_t>(ret) < rec->size) {
@@ -413,29 +469,35 @@ Status LogFile::readRecord(off_t offset, Record* rec, std::vector<char>* payload
                       std::to_string(ret));
     }
 
+    // 老格式的记录没有crc
+    if (rec->Recyclable() && rec->Checksum(payload->data()) != rec->crc) {
+        return Status(Status::kCorruption, "log record checksum mismatch",
+                      std::to_string(offset));
+    }
+
     return Status::OK();
 }
 
 Status LogFile::writeRecord(RecordType type, const ::google::protobuf::Message& msg) {
     uint32_t size = static_cast<uint32_t>(msg.ByteSizeLong());
-    std::vector<char> buf;
-    buf.resize(size + sizeof(Record));
-    Record* rec = (Record*)(buf.data());
-    rec->type = type;
-    rec->crc = 0;
+    size_t pos = write_buf_.size();
+    write_buf_.resize(pos + size + sizeof(Record));
+    Record* rec = (Record*)(write_buf_.data() + pos);
+    rec->type = static_cast<RecordType>(type | kRecyclableRecordFlag);
     rec->size = size;
-    rec->Encode();
+    rec->log_number = log_number_;
     if (!msg.SerializeToArray(rec->payload, size)) {
+        write_buf_.resize(pos);
         return Status(Status::kCorruption, "serialize log record", "pb return false");
     }
+    rec->crc = rec->Checksum(rec->payload);
+    rec->Encode();
 
-    auto ret = ::fwrite(buf.data(), buf.size(), 1, writer_);
-    if (ret != 1) {
-        return Status(Status::kIOError, "write record", strErrno(errno));
-    }
-
-    file_size_ += buf.size();
+    file_size_ += size + sizeof(Record);
 
+    if (write_buf_.size() >= kLogWriteBufSize) {
+        return flushBuffer();
+    }
     return Status::OK();
 }
 
@@ -450,22 +512,39 @@ Status LogFile::Truncate(uint64_t index) {
 
     uint32_t offset = log_index_.Offset(index);
     assert(offset < file_size_);
-    int ret = ::ftruncate(fd_, offset);
-    if (ret == -1) {
-        return Status(Status::kIOError, "truncate log", strErrno(errno));
+    auto s = flushBuffer();
+    if (!s.ok()) return s;
+    s = truncateAt(offset);
+    if (!s.ok()) {
+        return s;
     } else {
         log_index_.Truncate(index);
-        file_size_ = offset;
         return Status::OK();
     }
 }
 
+Status LogFile::truncateAt(off_t offset) {
+    if (prealloc_size_ > 0) {
+        // 保持文件大小，写结束标记
+        auto s = writeLogEndMark(fd_, offset);
+        if (!s.ok()) return s;
+    } else {
+        if (::ftruncate(fd_, offset) == -1) {
+            return Status(Status::kIOError, "truncate log", strErrno(errno));
+        }
+        alloc_size_ = offset;
+    }
+    file_size_ = offset;
+    return Status::OK();
+}
+
 #ifndef NDEBUG
 void LogFile::TEST_Append_RandomData() {
     std::string data = randomString(10);
-    auto ret = ::write(fd_, data.data(), data.length());
+    auto ret = ::pwrite(fd_, data.data(), data.length(), file_size_);
     assert(ret == static_cast<ssize_t>(data.length()));
     file_size_ += data.size();
+    alloc_size_ = std::max(alloc_size_, file_size_);
 }
 
 void LogFile::TEST_Truncate_RandomLen() {
@@ -474,6 +553,7 @@ void LogFile::TEST_Truncate_RandomLen() {
         int ret = ::ftruncate(fd_, offset);
         assert(ret == 0);
         file_size_ = offset;
+        alloc_size_ = offset;
     }
 }
 
@@ -15,9 +15,14 @@ namespace storage {
 
 class LogIndex;
 
+// 日志文件
+// prealloc_size大于0时文件预分配成固定大小，追加用pwrite写到有效数据末尾，后面跟一个结束标记，
+// 文件大小不变，sync时只需要fdatasync；footer写在文件的最后64字节
+// 记录头带文件的log number，回收文件里残留的旧记录读到时当作有效数据的结束
 class LogFile {
 public:
-    LogFile(const std::string& path, uint64_t seq, uint64_t index, bool readonly = false);
+    LogFile(const std::string& path, uint64_t seq, uint64_t index, bool readonly = false,
+            size_t prealloc_size = 0, uint64_t raft_id = 0);
     virtual ~LogFile();
 
     LogFile(const LogFile&) = delete;
@@ -31,7 +36,8 @@ public:
     uint64_t Seq() const { return seq_; }
     uint64_t Index() const { return index_; }
     const std::string& Path() const { return file_path_; }
-    uint64_t FileSize() const { return file_size_; }
+    uint64_t FileSize() const { return file_size_; }   // 有效数据的大小
+    uint64_t AllocSize() const { return alloc_size_; }  // 文件实际占用的大小
     int LogSize() const { return log_index_.Size(); }  // 日志条目个数
     uint64_t LastIndex() const { return log_index_.Last(); }
 
@@ -53,6 +59,10 @@ private:
     static std::string makeFilePath(const std::string& path, uint64_t seq,
                                     uint64_t index);
 
+    Status preallocate();
+    Status truncateAt(off_t offset);
+    Status flushBuffer();
+
     Status loadIndexes();
     Status traverse(uint32_t& offset);
     Status backup();
@@ -68,11 +78,13 @@ private:
     const uint64_t index_ = 0;  // 日志文件起始index
     const std::string file_path_;
     const bool readonly_ = false;
+    const size_t prealloc_size_ = 0;
+    const uint32_t log_number_ = 0;
 
     int fd_ = -1;
-    off_t file_size_ = 0;
-    FILE* writer_ = nullptr;
-    std::vector<char> write_buf_;
+    off_t file_size_ = 0;   // 包括还在写缓冲里的
+    off_t alloc_size_ = 0;
+    std::vector<char> write_buf_;  // 还没写到文件的数据，在file_size_的末尾
 
     LogIndex log_index_;
 };
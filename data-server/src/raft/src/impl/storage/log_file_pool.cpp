@@ -0,0 +1,148 @@
+#include "log_file_pool.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "../logger.h"
+#include "base/util.h"
+#include "log_format.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+namespace storage {
+
+// 回收文件名格式: {seq}.recycle, seq为十六进制
+static const std::string kRecycleSuffix = ".recycle";
+
+static std::string makeRecycleName(uint64_t seq) {
+    std::stringstream s;
+    s << std::hex << std::setfill('0') << std::setw(16) << seq << kRecycleSuffix;
+    return s.str();
+}
+
+LogFilePool::LogFilePool(const std::string& path, size_t capacity)
+    : path_(path), capacity_(capacity) {}
+
+Status LogFilePool::Open() {
+    if (MakeDirAll(path_, 0755) < 0) {
+        return Status(Status::kIOError, "init log recycle directory " + path_,
+                      strErrno(errno));
+    }
+
+    DIR* dir = ::opendir(path_.c_str());
+    if (NULL == dir) {
+        return Status(Status::kIOError, "call opendir", strErrno(errno));
+    }
+    std::vector<std::string> names;
+    struct dirent* ent = NULL;
+    while ((ent = ::readdir(dir)) != NULL) {
+        std::string name(ent->d_name);
+        if (name.size() == 16 + kRecycleSuffix.size() &&
+            name.compare(16, kRecycleSuffix.size(), kRecycleSuffix) == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    std::lock_guard<std::mutex> lock(mu_);
+    files_.clear();
+    for (const auto& name : names) {
+        auto file = JoinFilePath({path_, name});
+        if (files_.size() < capacity_) {
+            files_.push_back(file);
+        } else {
+            std::remove(file.c_str());
+        }
+    }
+    if (!names.empty()) {
+        next_seq_ = std::stoull(names.back().substr(0, 16), 0, 16) + 1;
+    }
+    return Status::OK();
+}
+
+bool LogFilePool::Put(const std::string& file) {
+    std::string target;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (files_.size() >= capacity_) {
+            return false;
+        }
+        target = JoinFilePath({path_, makeRecycleName(next_seq_++)});
+    }
+
+    if (::rename(file.c_str(), target.c_str()) != 0) {
+        LOG_WARN("raft[pool] recycle log file %s failed: %s", file.c_str(),
+                 strErrno(errno).c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    files_.push_back(target);
+    ++recycled_;
+    return true;
+}
+
+bool LogFilePool::Get(const std::string& file) {
+    std::string source;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (files_.empty()) {
+            return false;
+        }
+        source = files_.back();
+        files_.pop_back();
+    }
+
+    // 先在回收目录里写结束标记再改名，改名后崩溃重启时看到的是一个空文件
+    int fd = ::open(source.c_str(), O_WRONLY);
+    if (fd < 0) {
+        LOG_WARN("raft[pool] open recycled log file %s failed: %s", source.c_str(),
+                 strErrno(errno).c_str());
+        return false;
+    }
+    auto s = writeLogEndMark(fd, 0);
+    if (s.ok() && ::fdatasync(fd) != 0) {
+        s = Status(Status::kIOError, "sync recycled log file", strErrno(errno));
+    }
+    ::close(fd);
+    if (s.ok() && ::rename(source.c_str(), file.c_str()) != 0) {
+        s = Status(Status::kIOError, "rename recycled log file", strErrno(errno));
+    }
+    if (!s.ok()) {
+        LOG_WARN("raft[pool] reuse log file %s failed: %s", source.c_str(),
+                 s.ToString().c_str());
+        std::remove(source.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    ++reused_;
+    return true;
+}
+
+size_t LogFilePool::Size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return files_.size();
+}
+
+uint64_t LogFilePool::Recycled() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return recycled_;
+}
+
+uint64_t LogFilePool::Reused() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return reused_;
+}
+
+} /* namespace storage */
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
@@ -0,0 +1,53 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "base/status.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+namespace storage {
+
+// 节点上所有raft共享的日志文件回收池
+// 截断的日志文件改名放到回收目录里，新建日志文件时取一个改名过去继续用
+// 回收的文件已经分配好空间并且写过，追加时不用再分配，fdatasync也不需要写元数据
+// 回收目录需要跟日志目录在同一个文件系统上，否则改名失败直接删除
+class LogFilePool {
+public:
+    LogFilePool(const std::string& path, size_t capacity);
+
+    LogFilePool(const LogFilePool&) = delete;
+    LogFilePool& operator=(const LogFilePool&) = delete;
+
+    // 创建目录，加载上次留下的文件
+    Status Open();
+
+    // 回收一个已经关闭的日志文件，池满了或者改名失败返回false，由调用方删除
+    bool Put(const std::string& file);
+
+    // 取一个文件改名为file，开头写好结束标记，当作空文件打开；池空返回false
+    bool Get(const std::string& file);
+
+    size_t Size() const;
+    size_t Capacity() const { return capacity_; }
+    uint64_t Recycled() const;
+    uint64_t Reused() const;
+
+private:
+    const std::string path_;
+    const size_t capacity_ = 0;
+
+    mutable std::mutex mu_;
+    std::vector<std::string> files_;  // 后回收的在后面，先取
+    uint64_t next_seq_ = 1;
+    uint64_t recycled_ = 0;
+    uint64_t reused_ = 0;
+};
+
+} /* namespace storage */
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
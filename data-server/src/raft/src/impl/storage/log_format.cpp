@@ -2,11 +2,13 @@
 
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
 #include <iomanip>
 #include <sstream>
 #include <regex>
 
 #include "base/byte_order.h"
+#include "base/util.h"
 
 namespace sharkstore {
 namespace raft {
@@ -92,14 +94,68 @@ Status Footer::Validate() const {
     return Status::OK();
 }
 
+// crc32c(Castagnoli)，查表计算
+static const uint32_t* crc32cTable() {
+    static uint32_t table[256];
+    static bool inited = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : (c >> 1);
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)inited;
+    return table;
+}
+
+static uint32_t crc32cExtend(uint32_t crc, const char* data, size_t len) {
+    const uint32_t* table = crc32cTable();
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t makeLogNumber(uint64_t raft_id, uint64_t seq, uint64_t index) {
+    uint64_t buf[3] = {htobe64(raft_id), htobe64(seq), htobe64(index)};
+    return crc32cExtend(0, reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+uint32_t Record::Checksum(const char* data) const {
+    char header[1 + sizeof(uint32_t) * 2];
+    uint32_t be_size = htobe32(size);
+    uint32_t be_log_number = htobe32(log_number);
+    header[0] = static_cast<char>(type);
+    memcpy(header + 1, &be_size, sizeof(be_size));
+    memcpy(header + 1 + sizeof(be_size), &be_log_number, sizeof(be_log_number));
+    uint32_t crc = crc32cExtend(0, header, sizeof(header));
+    return crc32cExtend(crc, data, size);
+}
+
 void Record::Encode() {
     size = htobe32(size);
     crc = htobe32(crc);
+    log_number = htobe32(log_number);
 }
 
 void Record::Decode() {
     size = be32toh(size);
-    crc = be32toh(size);
+    crc = be32toh(crc);
+    log_number = be32toh(log_number);
+}
+
+Status writeLogEndMark(int fd, off_t offset) {
+    char mark[sizeof(Record)];
+    memset(mark, 0, sizeof(mark));
+    auto ret = ::pwrite(fd, mark, sizeof(mark), offset);
+    if (ret != static_cast<ssize_t>(sizeof(mark))) {
+        return Status(Status::kIOError, "write log end mark", strErrno(errno));
+    }
+    return Status::OK();
 }
 
 } /* namespace storage */
@@ -1,6 +1,7 @@
 _Pragma("once");
 
 #include <stdint.h>
+#include <sys/types.h>
 #include <string>
 #include "base/status.h"
 
@@ -13,7 +14,8 @@ namespace storage {
 // 如0000000000000003-0000000000000012.log,
 // 前缀为十六进制的文件序号和起始日志offset)
 
-static const uint16_t kLogCurrentVersion = 1;
+// version 2: 记录头带log number和crc
+static const uint16_t kLogCurrentVersion = 2;
 static const char* kLogFileMagic = "\x99\xA3\xB8\xDE";
 
 std::string makeLogFileName(uint64_t seq, uint64_t index);
@@ -35,14 +37,36 @@ struct Footer {
 
 } __attribute__((packed));
 
-enum RecordType : uint8_t { kLogEntry = 1, kIndex };
+// kEndMark: 全0的记录头，标记有效数据的结束，后面是预分配的空间或者回收文件里的旧数据
+enum RecordType : uint8_t { kEndMark = 0, kLogEntry = 1, kIndex };
+
+// 类型带上这个标记的是可回收格式的记录(参考rocksdb的recyclable record)，
+// 记录头多了所属文件的log number，crc覆盖记录头和payload，
+// 回收文件里的旧记录log number对不上，不会被当成有效数据
+static const uint8_t kRecyclableRecordFlag = 0x80;
+
+// 老版本的记录头: type、size、crc(没有计算，总是0)
+static const size_t kLegacyRecordHeaderSize = 9;
+
+// 日志文件的log number，序号在不同raft之间、日志全部截断后会重复，混入raft id和起始index
+uint32_t makeLogNumber(uint64_t raft_id, uint64_t seq, uint64_t index);
 
 struct Record {
     RecordType type = kLogEntry;
     uint32_t size = 0;
     uint32_t crc = 0;
+    uint32_t log_number = 0;
     char payload[0];
 
+    RecordType Type() const { return static_cast<RecordType>(type & ~kRecyclableRecordFlag); }
+    bool Recyclable() const { return (type & kRecyclableRecordFlag) != 0; }
+    size_t HeaderSize() const {
+        return Recyclable() ? sizeof(Record) : kLegacyRecordHeaderSize;
+    }
+
+    // 计算记录头(除crc)和payload的crc32c，需要在host-endian时调用
+    uint32_t Checksum(const char* data) const;
+
     // convert to big-endian when write to file
     void Encode();
     // conver to host-endian when read from file
@@ -50,6 +74,9 @@ struct Record {
 
 } __attribute__((packed));
 
+// 在offset处写一个结束标记
+Status writeLogEndMark(int fd, off_t offset);
+
 } /* namespace storage */
 } /* namespace impl */
 } /* namespace raft */
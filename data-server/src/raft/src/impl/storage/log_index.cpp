@@ -10,7 +10,7 @@ LogIndex::LogIndex() {}
 LogIndex::~LogIndex() {}
 
 Status LogIndex::ParseFrom(const Record& rec, const std::vector<char>& payload) {
-    if (rec.type != RecordType::kIndex) {
+    if (rec.Type() != RecordType::kIndex) {
         return Status(Status::kCorruption, "invalid log index record type",
                       std::to_string(rec.type));
     }
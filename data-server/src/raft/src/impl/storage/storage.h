@@ -11,6 +11,12 @@ namespace raft {
 namespace impl {
 namespace storage {
 
+// 一个日志文件的占用
+struct LogFileUsage {
+    uint64_t last_index = 0;
+    uint64_t bytes = 0;
+};
+
 class Storage {
 public:
     Storage() = default;
@@ -71,6 +77,10 @@ public:
     // AppliedTo notify storage last applied index
     virtual void AppliedTo(uint64_t applied) = 0;
 
+    // LogUsage returns the log files from oldest to newest, the last one is being
+    // written. Storages without log files return nothing.
+    virtual void LogUsage(std::vector<LogFileUsage>* files) const {}
+
     // Close the storage.
     virtual Status Close() = 0;
 
@@ -11,6 +11,7 @@
 #include "../logger.h"
 #include "base/util.h"
 #include "log_file.h"
+#include "log_file_pool.h"
 
 namespace sharkstore {
 namespace raft {
@@ -179,16 +180,15 @@ Status DiskStorage::openLogs() {
         if (ops_.readonly) {
             return Status(Status::kCorruption, "open logs", "no log file");
         }
-        auto f = new LogFile(path_, 1, trunc_meta_.index() + 1);
-        s = f->Open(ops_.allow_corrupt_startup);
+        s = createLogFile(1, trunc_meta_.index() + 1);
         if (!s.ok()) {
             return s;
         }
-        log_files_.push_back(f);
     } else {
         size_t count = 0;
         for (auto it = logs.begin(); it != logs.end(); ++it) {
-            auto f = new LogFile(path_, it->first, it->second, ops_.readonly);
+            auto f = new LogFile(path_, it->first, it->second, ops_.readonly,
+                                 ops_.preallocate ? ops_.log_file_size : 0, id_);
             s = f->Open(ops_.allow_corrupt_startup, count == logs.size() - 1);
             if (!s.ok()) {
                 return s;
@@ -235,6 +235,35 @@ Status DiskStorage::InitialState(pb::HardState* hs) const {
     return Status::OK();
 }
 
+Status DiskStorage::createLogFile(uint64_t seq, uint64_t index) {
+    auto f = new LogFile(path_, seq, index, false,
+                         ops_.preallocate ? ops_.log_file_size : 0, id_);
+    // 复用的文件开头是结束标记，按最后一个文件恢复
+    bool reused = ops_.recycle_pool != nullptr && ops_.recycle_pool->Get(f->Path());
+    auto s = f->Open(false, reused);
+    if (!s.ok()) {
+        delete f;
+        return s;
+    }
+    log_files_.push_back(f);
+    return Status::OK();
+}
+
+Status DiskStorage::removeLogFile(LogFile* f) {
+    if (ops_.recycle_pool != nullptr) {
+        auto s = f->Close();
+        if (!s.ok()) return s;
+        if (ops_.recycle_pool->Put(f->Path())) {
+            delete f;
+            return Status::OK();
+        }
+    }
+    auto s = f->Destroy();
+    if (!s.ok()) return s;
+    delete f;
+    return Status::OK();
+}
+
 Status DiskStorage::tryRotate() {
     assert(!log_files_.empty());
     auto f = log_files_.back();
@@ -243,12 +272,7 @@ Status DiskStorage::tryRotate() {
         if (!s.ok()) {
             return s;
         }
-        auto newf = new LogFile(path_, f->Seq() + 1, last_index_ + 1);
-        s = newf->Open(false);
-        if (!s.ok()) {
-            return s;
-        }
-        log_files_.push_back(newf);
+        return createLogFile(f->Seq() + 1, last_index_ + 1);
     }
     return Status::OK();
 }
@@ -422,9 +446,8 @@ Status DiskStorage::truncateOld(uint64_t index) {
     while (log_files_.size() > 1) {
         auto f = log_files_[0];
         if (f->LastIndex() <= index) {
-            auto s = f->Destroy();
+            auto s = removeLogFile(f);
             if (!s.ok()) return s;
-            delete f;
             log_files_.erase(log_files_.begin());
         } else {
             break;
@@ -439,9 +462,8 @@ Status DiskStorage::truncateNew(uint64_t index) {
     while (!log_files_.empty()) {
         auto last = log_files_.back();
         if (last->Index() > index) {
-            s = last->Destroy();
+            s = removeLogFile(last);
             if (!s.ok()) return s;
-            delete last;
             log_files_.pop_back();
         } else {
             s = last->Truncate(index);
@@ -465,20 +487,17 @@ Status DiskStorage::truncateNew(uint64_t index) {
 Status DiskStorage::truncateAll() {
     Status s;
     for (auto it = log_files_.begin(); it != log_files_.end(); ++it) {
-        s = (*it)->Destroy();
+        s = removeLogFile(*it);
         if (!s.ok()) {
             return s;
         }
-        delete (*it);
     }
     log_files_.clear();
 
-    LogFile* f = new LogFile(path_, 1, trunc_meta_.index() + 1);
-    s = f->Open(false);
+    s = createLogFile(1, trunc_meta_.index() + 1);
     if (!s.ok()) {
         return s;
     }
-    log_files_.push_back(f);
     last_index_ = trunc_meta_.index();
 
     return Status::OK();
@@ -569,6 +588,15 @@ void DiskStorage::AppliedTo(uint64_t applied) {
     }
 }
 
+void DiskStorage::LogUsage(std::vector<LogFileUsage>* files) const {
+    for (auto f : log_files_) {
+        LogFileUsage u;
+        u.last_index = f->LastIndex();
+        u.bytes = f->AllocSize();
+        files->push_back(u);
+    }
+}
+
 Status DiskStorage::Close() {
     auto s = meta_file_.Close();
     if (!s.ok()) return s;
@@ -10,6 +10,7 @@ namespace impl {
 namespace storage {
 
 class LogFile;
+class LogFilePool;
 
 class DiskStorage : public Storage {
 public:
@@ -31,6 +32,12 @@ public:
 
         // 只读模式打开
         bool readonly = false;
+
+        // 日志文件按log_file_size预分配
+        bool preallocate = false;
+
+        // 截断的日志文件放到回收池里，新建时优先复用，nullptr表示直接删除
+        LogFilePool* recycle_pool = nullptr;
     };
 
     DiskStorage(uint64_t id, const std::string& path, const Options& ops);
@@ -57,6 +64,8 @@ public:
 
     void AppliedTo(uint64_t applied) override;
 
+    void LogUsage(std::vector<LogFileUsage>* files) const override;
+
     Status Close() override;
     Status Destroy(bool backup = false) override;
 
@@ -85,6 +94,11 @@ private:
     // 清空日志（应用快照时）
     Status truncateAll();
 
+    // 新建一个日志文件放到最后
+    Status createLogFile(uint64_t seq, uint64_t index);
+    // 删除或回收日志文件
+    Status removeLogFile(LogFile* f);
+
     Status tryRotate();
     Status save(const EntryPtr& e);
 
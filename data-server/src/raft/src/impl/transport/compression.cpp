@@ -0,0 +1,246 @@
+#include "compression.h"
+
+#include <string.h>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "../logger.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+namespace transport {
+
+// 速度优先
+static const int kZstdLevel = 1;
+
+// 防止协议头错误时分配过大的内存
+static const size_t kMaxUncompressedSize = 256 * 1024 * 1024;
+
+static int typeBit(CompressionType type) { return 1 << static_cast<int>(type); }
+
+bool CompressionSupported(CompressionType type) {
+    switch (type) {
+        case CompressionType::kNone:
+            return true;
+#ifdef USE_LZ4
+        case CompressionType::kLZ4:
+            return true;
+#endif
+#ifdef USE_ZSTD
+        case CompressionType::kZstd:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+int CompressionMask() {
+    int mask = 0;
+    for (auto type : {CompressionType::kNone, CompressionType::kLZ4, CompressionType::kZstd}) {
+        if (CompressionSupported(type)) {
+            mask |= typeBit(type);
+        }
+    }
+    return mask;
+}
+
+Status Compress(CompressionType type, const std::string& input, std::string* output) {
+    switch (type) {
+#ifdef USE_LZ4
+        case CompressionType::kLZ4: {
+            int bound = LZ4_compressBound(static_cast<int>(input.size()));
+            output->resize(bound);
+            int n = LZ4_compress_default(input.data(), &(*output)[0],
+                                         static_cast<int>(input.size()), bound);
+            if (n <= 0) {
+                return Status(Status::kUnknown, "lz4 compress", std::to_string(n));
+            }
+            output->resize(n);
+            return Status::OK();
+        }
+#endif
+#ifdef USE_ZSTD
+        case CompressionType::kZstd: {
+            size_t bound = ZSTD_compressBound(input.size());
+            output->resize(bound);
+            size_t n = ZSTD_compress(&(*output)[0], bound, input.data(), input.size(),
+                                     kZstdLevel);
+            if (ZSTD_isError(n)) {
+                return Status(Status::kUnknown, "zstd compress", ZSTD_getErrorName(n));
+            }
+            output->resize(n);
+            return Status::OK();
+        }
+#endif
+        default:
+            return Status(Status::kNotSupported, "compress", CompressionTypeName(type));
+    }
+}
+
+Status Uncompress(CompressionType type, const char* input, size_t len, size_t raw_len,
+                  std::string* output) {
+    if (raw_len > kMaxUncompressedSize) {
+        return Status(Status::kCorruption, "uncompressed size too large",
+                      std::to_string(raw_len));
+    }
+
+    switch (type) {
+#ifdef USE_LZ4
+        case CompressionType::kLZ4: {
+            output->resize(raw_len);
+            int n = LZ4_decompress_safe(input, &(*output)[0], static_cast<int>(len),
+                                        static_cast<int>(raw_len));
+            if (n < 0 || static_cast<size_t>(n) != raw_len) {
+                return Status(Status::kCorruption, "lz4 uncompress", std::to_string(n));
+            }
+            return Status::OK();
+        }
+#endif
+#ifdef USE_ZSTD
+        case CompressionType::kZstd: {
+            output->resize(raw_len);
+            size_t n = ZSTD_decompress(&(*output)[0], raw_len, input, len);
+            if (ZSTD_isError(n)) {
+                return Status(Status::kCorruption, "zstd uncompress",
+                              ZSTD_getErrorName(n));
+            }
+            if (n != raw_len) {
+                return Status(Status::kCorruption, "zstd uncompress",
+                              std::to_string(n) + " != " + std::to_string(raw_len));
+            }
+            return Status::OK();
+        }
+#endif
+        default:
+            return Status(Status::kNotSupported, "uncompress", CompressionTypeName(type));
+    }
+}
+
+void FillHeader(int64_t msg_id, short func_id, size_t body_len, ds_header_t* header) {
+    memset(header, 0, sizeof(ds_header_t));
+    header->magic_number = DS_PROTO_MAGIC_NUMBER;
+    header->body_len = static_cast<int>(body_len);
+    header->msg_id = msg_id;
+    header->version = DS_PROTO_VERSION_CURRENT;
+    header->msg_type = DS_PROTO_FID_RPC_RESP;
+    header->func_id = func_id;
+    header->proto_type = 1;
+}
+
+Status DecodeMessage(const ds_header_t& header, const char* body, MessagePtr* msg) {
+    size_t len = static_cast<size_t>(header.body_len);
+    std::string raw;
+    if (header.func_id == kFuncRaftCompressed) {
+        auto s = Uncompress(static_cast<CompressionType>(header.stream_hash), body, len,
+                            static_cast<size_t>(header.time_out), &raw);
+        if (!s.ok()) {
+            return s;
+        }
+        body = raw.data();
+        len = raw.size();
+    }
+
+    MessagePtr m(new pb::Message);
+    if (!m->ParseFromArray(body, static_cast<int>(len))) {
+        return Status(Status::kCorruption, "parse raft message",
+                      std::string("func_id: ") + std::to_string(header.func_id));
+    }
+    *msg = std::move(m);
+    return Status::OK();
+}
+
+void CompressionCounter::Collect(CompressionStats* stats) const {
+    stats->raw_bytes = raw_bytes;
+    stats->compressed_bytes = compressed_bytes;
+    stats->compressed_msgs = compressed_msgs;
+    stats->skipped_msgs = skipped_msgs;
+}
+
+const size_t AdaptiveCompressor::kPoorRatioPercent;
+const int AdaptiveCompressor::kMaxPoorTimes;
+const int AdaptiveCompressor::kPauseMsgs;
+
+AdaptiveCompressor::AdaptiveCompressor(CompressionType type, size_t threshold,
+                                       CompressionCounter* counter)
+    : want_(type), threshold_(threshold), counter_(counter) {}
+
+void AdaptiveCompressor::Negotiate(int peer_mask) {
+    if (want_ != CompressionType::kNone && CompressionSupported(want_) &&
+        (peer_mask & typeBit(want_)) != 0) {
+        type_ = want_;
+    } else {
+        type_ = CompressionType::kNone;
+    }
+}
+
+void AdaptiveCompressor::onPoorRatio() {
+    if (++poor_times_ >= kMaxPoorTimes) {
+        poor_times_ = 0;
+        pause_remain_ = kPauseMsgs;
+        LOG_DEBUG("raft[transport] %s compress ratio is poor, pause %d messages",
+                  CompressionTypeName(type_).c_str(), kPauseMsgs);
+    }
+}
+
+bool AdaptiveCompressor::Encode(const pb::Message& msg, int64_t msg_id,
+                                ds_header_t* header, std::string* body) {
+    CompressionType type = type_;
+    if (type == CompressionType::kNone) {
+        return false;
+    }
+    // 只压缩大块的日志和快照数据
+    if (msg.type() != pb::APPEND_ENTRIES_REQUEST && msg.type() != pb::SNAPSHOT_REQUEST) {
+        return false;
+    }
+    if (msg.ByteSizeLong() < threshold_) {
+        return false;
+    }
+    if (pause_remain_ > 0) {
+        --pause_remain_;
+        ++counter_->skipped_msgs;
+        return false;
+    }
+
+    std::string raw;
+    if (!msg.SerializeToString(&raw)) {
+        return false;
+    }
+    auto s = Compress(type, raw, body);
+    if (!s.ok()) {
+        LOG_WARN("raft[transport] compress message failed: %s", s.ToString().c_str());
+        return false;
+    }
+
+    counter_->raw_bytes += raw.size();
+    if (body->size() * 100 > raw.size() * kPoorRatioPercent) {
+        onPoorRatio();
+    } else {
+        poor_times_ = 0;
+    }
+
+    if (body->size() >= raw.size()) {
+        // 没变小，发原始消息
+        counter_->compressed_bytes += raw.size();
+        FillHeader(msg_id, kFuncRaftMessage, raw.size(), header);
+        body->swap(raw);
+    } else {
+        counter_->compressed_bytes += body->size();
+        ++counter_->compressed_msgs;
+        FillHeader(msg_id, kFuncRaftCompressed, body->size(), header);
+        header->stream_hash = static_cast<char>(type);
+        header->time_out = static_cast<int>(raw.size());
+    }
+    return true;
+}
+
+} /* namespace transport */
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
@@ -0,0 +1,99 @@
+_Pragma("once");
+
+#include <atomic>
+#include <string>
+
+#include "base/status.h"
+#include "common/ds_proto.h"
+#include "raft/types.h"
+
+#include "../raft_types.h"
+
+namespace sharkstore {
+namespace raft {
+namespace impl {
+namespace transport {
+
+// raft消息协议头里的func_id
+// 101: 建立连接后协商压缩算法，没有body，time_out为本端能解压的算法(按位)，对端用同样的格式应答
+//      老版本收到没有body的消息直接忽略，发送端等不到应答就一直不压缩
+// 102: 压缩过的消息，stream_hash为压缩算法，time_out为压缩前的长度
+static const short kFuncRaftMessage = 100;
+static const short kFuncRaftHello = 101;
+static const short kFuncRaftCompressed = 102;
+
+// 编译时是否打开了对应的压缩库(ENABLE_LZ4/ENABLE_ZSTD)
+bool CompressionSupported(CompressionType type);
+
+// 本节点能解压的算法，按位
+int CompressionMask();
+
+Status Compress(CompressionType type, const std::string& input, std::string* output);
+Status Uncompress(CompressionType type, const char* input, size_t len, size_t raw_len,
+                  std::string* output);
+
+// 填充raft消息的协议头
+void FillHeader(int64_t msg_id, short func_id, size_t body_len, ds_header_t* header);
+
+// 解析收到的raft消息，压缩过的先解压
+Status DecodeMessage(const ds_header_t& header, const char* body, MessagePtr* msg);
+
+struct CompressionStats {
+    uint64_t raw_bytes = 0;         // 尝试压缩的消息压缩前的字节数
+    uint64_t compressed_bytes = 0;  // 这些消息实际发送的字节数
+    uint64_t compressed_msgs = 0;   // 压缩后发送的消息数
+    uint64_t skipped_msgs = 0;      // 压缩率太低暂停压缩期间跳过的消息数
+};
+
+struct CompressionCounter {
+    std::atomic<uint64_t> raw_bytes = {0};
+    std::atomic<uint64_t> compressed_bytes = {0};
+    std::atomic<uint64_t> compressed_msgs = {0};
+    std::atomic<uint64_t> skipped_msgs = {0};
+
+    void Collect(CompressionStats* stats) const;
+};
+
+// 每个连接一个，按协商的算法压缩超过阈值的复制日志和快照消息
+// 连续多次压缩率很差时(比如数据本身已经压缩过)暂停压缩一段时间，然后再试探
+class AdaptiveCompressor {
+public:
+    // 压缩后超过原来的90%算压缩率差
+    static const size_t kPoorRatioPercent = 90;
+    // 连续几次压缩率差就暂停
+    static const int kMaxPoorTimes = 8;
+    // 暂停期间跳过几条消息
+    static const int kPauseMsgs = 256;
+
+    AdaptiveCompressor(CompressionType type, size_t threshold, CompressionCounter* counter);
+
+    AdaptiveCompressor(const AdaptiveCompressor&) = delete;
+    AdaptiveCompressor& operator=(const AdaptiveCompressor&) = delete;
+
+    // 协商完成，peer_mask为对端能解压的算法
+    void Negotiate(int peer_mask);
+    CompressionType Type() const { return type_; }
+    bool Paused() const { return pause_remain_ > 0; }
+
+    // 尝试编码消息，返回false时调用方按不压缩的方式直接序列化
+    // 返回true时header和body已经填好(压缩后没变小时body为原始消息)
+    bool Encode(const pb::Message& msg, int64_t msg_id, ds_header_t* header,
+                std::string* body);
+
+private:
+    void onPoorRatio();
+
+private:
+    const CompressionType want_;
+    const size_t threshold_;
+    CompressionCounter* counter_ = nullptr;
+
+    std::atomic<CompressionType> type_ = {CompressionType::kNone};
+    std::atomic<int> poor_times_ = {0};
+    std::atomic<int> pause_remain_ = {0};
+};
+
+} /* namespace transport */
+} /* namespace impl */
+} /* namespace raft */
+} /* namespace sharkstore */
@@ -10,8 +10,15 @@ namespace impl {
 namespace transport {
 
 FastClient::FastClient(const sf_socket_thread_config_t &cfg,
-                       const std::shared_ptr<NodeResolver> &resolver)
-    : config_(cfg), resolver_(resolver), msg_id_(1) {
+                       const std::shared_ptr<NodeResolver> &resolver,
+                       CompressionType compression, size_t compression_threshold,
+                       CompressionCounter *counter)
+    : config_(cfg),
+      resolver_(resolver),
+      msg_id_(1),
+      compression_(compression),
+      compression_threshold_(compression_threshold),
+      counter_(counter) {
     memset(&status_, 0, sizeof(status_));
 }
 
@@ -19,8 +26,13 @@ FastClient::~FastClient() {
     // TODO:
 }
 
-static void client_recv_done(request_buff_t *request, void *args) {
-    // TODO:
+void client_recv_done(request_buff_t *request, void *args) {
+    ds_header_t header;
+    ds_unserialize_header((ds_proto_header_t *)(request->buff), &header);
+    // 对端只会应答压缩协商
+    if (header.func_id == kFuncRaftHello) {
+        static_cast<FastClient *>(args)->onHello(request->session_id, header.time_out);
+    }
 }
 
 Status FastClient::Initialize() {
@@ -51,15 +63,15 @@ void FastClient::SendMessage(MessagePtr &msg) {
             pb::MessageType_Name(msg->type()).c_str(), msg->id(), msg->term());
     }
 
-    int64_t sid = getSession(msg->to());
-    if (sid > 0) {
-        send(sid, msg);
+    auto session = getSession(msg->to());
+    if (session.id > 0) {
+        send(session, msg);
     } else {
         FLOG_ERROR("raft[FastClient] could not get a connection to %lu", msg->to());
     }
 }
 
-int64_t FastClient::getSession(uint64_t to) {
+FastClient::Session FastClient::getSession(uint64_t to) {
     {
         sharkstore::shared_lock<sharkstore::shared_mutex> locker(mu_);
         auto it = sessions_.find(to);
@@ -73,14 +85,14 @@ int64_t FastClient::getSession(uint64_t to) {
     int port = 0;
     std::string addr = resolver_->GetNodeAddress(to);
     if (addr.empty()) {
-        return 0;
+        return Session();
     }
     auto pos = addr.find(':');
     if (pos != std::string::npos) {
         ip = addr.substr(0, pos);
         port = atoi(addr.substr(pos + 1).c_str());
     } else {
-        return 0;
+        return Session();
     }
 
     std::unique_lock<sharkstore::shared_mutex> locker(mu_);
@@ -88,15 +100,22 @@ int64_t FastClient::getSession(uint64_t to) {
     if (it != sessions_.end()) {
         return it->second;
     }
-    auto id = sf_connect_session_get(&thread_info_, ip.c_str(), port);
-    if (id > 0) {
+    Session session;
+    session.id = sf_connect_session_get(&thread_info_, ip.c_str(), port);
+    if (session.id > 0) {
         FLOG_INFO("raft[FastClient] connect to %s:%d success. sid=%ld", ip.c_str(), port,
-                  id);
-        sessions_.emplace(to, id);
+                  session.id);
+        if (compression_ != CompressionType::kNone) {
+            // 协商完成前不压缩
+            session.compressor = std::make_shared<AdaptiveCompressor>(
+                compression_, compression_threshold_, counter_);
+            sendHello(session.id);
+        }
+        sessions_.emplace(to, session);
     } else {
         FLOG_ERROR("raft[FastClient] connect failed to %s:%d", ip.c_str(), port);
     }
-    return id;
+    return session;
 }
 
 void FastClient::removeSession(uint64_t to) {
@@ -104,27 +123,61 @@ void FastClient::removeSession(uint64_t to) {
     sessions_.erase(to);
 }
 
-void FastClient::send(int64_t sid, MessagePtr &msg) {
-    size_t body_len = msg->ByteSizeLong();
-    size_t data_len = sizeof(ds_proto_header_t) + body_len;
+void FastClient::sendHello(int64_t sid) {
+    ds_header_t header;
+    FillHeader(msg_id_.fetch_add(1), kFuncRaftHello, 0, &header);
+    header.time_out = CompressionMask();
+
+    response_buff_t *response = new_response_buff(sizeof(ds_proto_header_t));
+    ds_serialize_header(&header, (ds_proto_header_t *)(response->buff));
+    response->session_id = sid;
+    response->buff_len = sizeof(ds_proto_header_t);
+    if (dataserver::common::SocketBase::Send(response) != 0) {
+        FLOG_ERROR("raft[FastClient] send hello failed. sid=%ld", sid);
+    }
+}
 
-    response_buff_t *response = new_response_buff(data_len);
+void FastClient::onHello(int64_t sid, int peer_mask) {
+    sharkstore::shared_lock<sharkstore::shared_mutex> locker(mu_);
+    for (const auto &kv : sessions_) {
+        if (kv.second.id == sid && kv.second.compressor) {
+            kv.second.compressor->Negotiate(peer_mask);
+            FLOG_INFO("raft[FastClient] node %lu compression: %s, peer mask: %d", kv.first,
+                      CompressionTypeName(kv.second.compressor->Type()).c_str(),
+                      peer_mask);
+            return;
+        }
+    }
+}
 
-    // 填充头部
+void FastClient::send(const Session &session, MessagePtr &msg) {
+    auto sid = session.id;
+    auto msg_id = msg_id_.fetch_add(1);
     ds_header_t header;
-    header.magic_number = DS_PROTO_MAGIC_NUMBER;
-    header.body_len = body_len;
-    header.msg_id = msg_id_.fetch_add(1);
-    header.version = DS_PROTO_VERSION_CURRENT;
-    header.msg_type = DS_PROTO_FID_RPC_RESP;
-    header.func_id = 100;
-    header.proto_type = 1;
-    ds_serialize_header(&header, (ds_proto_header_t *)(response->buff));
+    std::string body;
+    response_buff_t *response = nullptr;
+    bool ok = true;
+    if (session.compressor &&
+        session.compressor->Encode(*msg, msg_id, &header, &body)) {
+        response = new_response_buff(sizeof(ds_proto_header_t) + body.size());
+        ds_serialize_header(&header, (ds_proto_header_t *)(response->buff));
+        memcpy(response->buff + sizeof(ds_proto_header_t), body.data(), body.size());
+        response->buff_len = sizeof(ds_proto_header_t) + body.size();
+    } else {
+        size_t body_len = msg->ByteSizeLong();
+        size_t data_len = sizeof(ds_proto_header_t) + body_len;
+        response = new_response_buff(data_len);
+
+        // 填充头部
+        FillHeader(msg_id, kFuncRaftMessage, body_len, &header);
+        ds_serialize_header(&header, (ds_proto_header_t *)(response->buff));
+        response->buff_len = data_len;
+        ok = msg->SerializeToArray(response->buff + sizeof(ds_proto_header_t), body_len);
+    }
 
     response->session_id = sid;
-    response->buff_len = data_len;
 
-    if (msg->SerializeToArray(response->buff + sizeof(ds_proto_header_t), body_len)) {
+    if (ok) {
         int ret = dataserver::common::SocketBase::Send(response);
         if (ret != 0) {
             FLOG_ERROR("raft[FastClient] send to %lu failed. ret=%d, sid=%ld", msg->to(),
@@ -7,6 +7,7 @@ _Pragma("once");
 #include "raft/node_resolver.h"
 
 #include "../raft_types.h"
+#include "compression.h"
 
 namespace sharkstore {
 namespace raft {
@@ -16,7 +17,9 @@ namespace transport {
 class FastClient : public dataserver::common::SocketBase {
 public:
     FastClient(const sf_socket_thread_config_t& cfg,
-               const std::shared_ptr<NodeResolver>& resolver);
+               const std::shared_ptr<NodeResolver>& resolver,
+               CompressionType compression = CompressionType::kNone,
+               size_t compression_threshold = 0, CompressionCounter* counter = nullptr);
     ~FastClient();
 
     FastClient(const FastClient&) = delete;
@@ -28,10 +31,21 @@ public:
     void SendMessage(MessagePtr& msg);
 
 private:
-    int64_t getSession(uint64_t to);
+    struct Session {
+        int64_t id = 0;
+        // 未开启压缩时为空
+        std::shared_ptr<AdaptiveCompressor> compressor;
+    };
+
+    friend void client_recv_done(request_buff_t*, void*);
+
+    Session getSession(uint64_t to);
     void removeSession(uint64_t to);
 
-    void send(int64_t sid, MessagePtr& msg);
+    void sendHello(int64_t sid);
+    void onHello(int64_t sid, int peer_mask);
+
+    void send(const Session& session, MessagePtr& msg);
 
 private:
     sf_socket_thread_config_t config_;
@@ -40,7 +54,11 @@ private:
 
     std::atomic<int64_t> msg_id_;
 
-    std::unordered_map<uint64_t, int64_t> sessions_;
+    const CompressionType compression_;
+    const size_t compression_threshold_;
+    CompressionCounter* counter_ = nullptr;
+
+    std::unordered_map<uint64_t, Session> sessions_;
     mutable sharkstore::shared_mutex mu_;
 };
 
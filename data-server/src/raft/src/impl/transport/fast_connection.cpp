@@ -14,6 +14,19 @@ namespace raft {
 namespace impl {
 namespace transport {
 
+// 等待协商应答的超时时间
+static const int kHelloTimeoutMs = 1000;
+
+static std::atomic<uint64_t> msgid(1);
+
+FastConnection::FastConnection(CompressionType compression, size_t compression_threshold,
+                               CompressionCounter* counter) {
+    if (compression != CompressionType::kNone) {
+        compressor_.reset(
+            new AdaptiveCompressor(compression, compression_threshold, counter));
+    }
+}
+
 FastConnection::~FastConnection() { this->Close(); }
 
 Status FastConnection::Open(const std::string& ip, uint16_t port) {
@@ -34,6 +47,52 @@ Status FastConnection::Open(const std::string& ip, uint16_t port) {
 
     // TODO: SO_SNDTIMEO
 
+    if (compressor_) {
+        negotiate();
+    }
+
+    return Status::OK();
+}
+
+void FastConnection::negotiate() {
+    ds_header_t header;
+    FillHeader(msgid.fetch_add(1), kFuncRaftHello, 0, &header);
+    header.time_out = CompressionMask();
+    ds_proto_header_t proto_header;
+    ds_serialize_header(&header, &proto_header);
+    if (!sendAll((const char*)&proto_header, sizeof(proto_header)).ok()) {
+        return;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = kHelloTimeoutMs / 1000;
+    tv.tv_usec = (kHelloTimeoutMs % 1000) * 1000;
+    ::setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    size_t received = 0;
+    char* buf = (char*)&proto_header;
+    while (received < sizeof(proto_header)) {
+        auto n = ::recv(sockfd_, buf + received, sizeof(proto_header) - received, 0);
+        if (n <= 0) {
+            return;
+        }
+        received += n;
+    }
+    ds_unserialize_header(&proto_header, &header);
+    if (header.func_id == kFuncRaftHello) {
+        compressor_->Negotiate(header.time_out);
+    }
+}
+
+Status FastConnection::sendAll(const char* buf, size_t len) {
+    while (len > 0) {
+        auto ret = ::send(sockfd_, buf, len, 0);
+        if (ret <= 0) {
+            return Status(Status::kIOError, "send to socket", strErrno(errno));
+        }
+        buf += ret;
+        len -= ret;
+    }
     return Status::OK();
 }
 
@@ -49,34 +108,23 @@ Status FastConnection::Close() {
 }
 
 Status FastConnection::Send(MessagePtr& msg) {
-    size_t body_len = msg->ByteSizeLong();
-    size_t data_len = sizeof(ds_proto_header_t) + body_len;
+    ds_header_t header;
+    std::string body;
+    auto msg_id = msgid.fetch_add(1);
+    if (!compressor_ || !compressor_->Encode(*msg, msg_id, &header, &body)) {
+        FillHeader(msg_id, kFuncRaftMessage, msg->ByteSizeLong(), &header);
+        if (!msg->SerializeToString(&body)) {
+            return Status(Status::kCorruption, "serialize snapshot msg",
+                          "SerializeToString return false");
+        }
+    }
 
-    std::vector<char> buf_vec(data_len, '0');
+    std::vector<char> buf_vec(sizeof(ds_proto_header_t) + body.size());
     char* buf = buf_vec.data();
-
-    ds_header_t header;
-    memset(&header, 0, sizeof(header));
-    header.magic_number = DS_PROTO_MAGIC_NUMBER;
-    header.body_len = body_len;
-    static std::atomic<uint64_t> msgid(1);
-    header.msg_id = msgid.fetch_add(1);
-    header.version = DS_PROTO_VERSION_CURRENT;
-    header.msg_type = DS_PROTO_FID_RPC_RESP;
-    header.func_id = 100;
-    header.proto_type = 1;
     ds_serialize_header(&header, (ds_proto_header_t*)(buf));
+    memcpy(buf + sizeof(ds_proto_header_t), body.data(), body.size());
 
-    if (!msg->SerializeToArray(buf + sizeof(ds_proto_header_t), body_len)) {
-        return Status(Status::kCorruption, "serialize snapshot msg",
-                      "SerializeToArray return false");
-    }
-
-    int ret = ::send(sockfd_, buf, data_len, 0);
-    if (ret <= 0) {
-        return Status(Status::kIOError, "send to socket", strErrno(errno));
-    }
-    return Status::OK();
+    return sendAll(buf, buf_vec.size());
 }
 
 } /* namespace transport */
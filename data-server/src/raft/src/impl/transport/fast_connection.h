@@ -1,5 +1,6 @@
 _Pragma("once");
 
+#include "compression.h"
 #include "transport.h"
 
 namespace sharkstore {
@@ -10,14 +11,22 @@ namespace transport {
 class FastConnection : public Connection {
 public:
     FastConnection() = default;
+    FastConnection(CompressionType compression, size_t compression_threshold,
+                   CompressionCounter* counter);
     ~FastConnection();
 
     Status Open(const std::string& ip, uint16_t port);
     Status Send(MessagePtr& msg) override;
     Status Close() override;
 
+private:
+    // 同步协商压缩算法，对端不应答(老版本)时不压缩
+    void negotiate();
+    Status sendAll(const char* buf, size_t len);
+
 private:
     int sockfd_ = -1;
+    std::unique_ptr<AdaptiveCompressor> compressor_;
 };
 
 } /* namespace transport */
@@ -3,6 +3,8 @@
 #include "common/ds_proto.h"
 #include "frame/sf_logger.h"
 
+#include "compression.h"
+
 namespace sharkstore {
 namespace raft {
 namespace impl {
@@ -56,18 +58,34 @@ void FastServer::handleTask(request_buff_t* task) {
     ds_proto_header_t* proto_header = (ds_proto_header_t*)(task->buff);
     ds_unserialize_header(proto_header, &header);
 
-    if (header.body_len > 0) {
-        MessagePtr msg(new pb::Message);
-        bool ret =
-            msg->ParseFromArray(task->buff + sizeof(ds_proto_header_t), header.body_len);
-        if (ret) {
+    if (header.func_id == kFuncRaftHello) {
+        replyHello(task->session_id, header.msg_id);
+    } else if (header.body_len > 0) {
+        MessagePtr msg;
+        auto s = DecodeMessage(header, task->buff + sizeof(ds_proto_header_t), &msg);
+        if (s.ok()) {
             handler_(msg);
         } else {
-            FLOG_ERROR("raft[FastServer] prase protobuf message failed.");
+            FLOG_ERROR("raft[FastServer] decode message failed: %s", s.ToString().c_str());
         }
     }
 }
 
+void FastServer::replyHello(int64_t session_id, int64_t msg_id) {
+    // 告诉对端本节点能解压哪些算法
+    ds_header_t header;
+    FillHeader(msg_id, kFuncRaftHello, 0, &header);
+    header.time_out = CompressionMask();
+
+    response_buff_t* response = new_response_buff(sizeof(ds_proto_header_t));
+    ds_serialize_header(&header, (ds_proto_header_t*)(response->buff));
+    response->session_id = session_id;
+    response->buff_len = sizeof(ds_proto_header_t);
+    if (dataserver::common::SocketBase::Send(response) != 0) {
+        FLOG_ERROR("raft[FastServer] reply hello failed. sid=%ld", session_id);
+    }
+}
+
 void FastServer::sendDoneCallback(response_buff_t* task, int err) {
     // TODO: log
 }
@@ -25,6 +25,7 @@ private:
     friend void fastserver_send_done_cb(response_buff_t*, void*, int);
 
     void handleTask(request_buff_t* task);
+    void replyHello(int64_t session_id, int64_t msg_id);
     void sendDoneCallback(response_buff_t* task, int err);
 
 private:
@@ -10,9 +10,14 @@ namespace impl {
 namespace transport {
 
 FastTransport::FastTransport(const std::shared_ptr<NodeResolver>& resolver,
-                             size_t send_threads, size_t recv_threads)
+                             size_t send_threads, size_t recv_threads,
+                             bool use_io_uring, CompressionType compression,
+                             size_t compression_threshold)
     : resolver_(resolver),
-      recv_threads_num_(recv_threads) {}
+      recv_threads_num_(recv_threads),
+      io_backend_(use_io_uring ? SF_IO_URING : SF_IO_EPOLL),
+      compression_(compression),
+      compression_threshold_(compression_threshold) {}
 
 FastTransport::~FastTransport() {
     delete server_;
@@ -27,6 +32,7 @@ Status FastTransport::Start(const std::string& listen_ip, uint16_t listen_port,
     srv_config.accept_threads = 1;
     srv_config.event_recv_threads = recv_threads_num_;
     srv_config.recv_buff_size = 128 * 1024;
+    srv_config.io_backend = io_backend_;
 
     const char* ip = listen_ip.empty() ? "0.0.0.0" : listen_ip.c_str();
     strncpy(srv_config.ip_addr, ip, strlen(ip));
@@ -39,8 +45,12 @@ Status FastTransport::Start(const std::string& listen_ip, uint16_t listen_port,
     sf_socket_thread_config_t cli_config;
     memset(&cli_config, 0, sizeof(cli_config));
     cli_config.event_send_threads = 1;
+    // 需要接收压缩协商的应答
+    cli_config.event_recv_threads = compression_ != CompressionType::kNone ? 1 : 0;
+    cli_config.io_backend = io_backend_;
     strcpy(cli_config.thread_name_prefix, "raft");
-    client_ = new FastClient(cli_config, resolver_);
+    client_ = new FastClient(cli_config, resolver_, compression_, compression_threshold_,
+                             &compression_counter_);
 
     auto s = server_->Initialize();
     if (!s.ok()) {
@@ -70,7 +80,8 @@ Status FastTransport::GetConnection(uint64_t to,
                       std::to_string(to));
     }
 
-    auto c = std::make_shared<FastConnection>();
+    auto c = std::make_shared<FastConnection>(compression_, compression_threshold_,
+                                              &compression_counter_);
     auto s = c->Open(ip, port);
     if (!s.ok()) return s;
 
@@ -78,6 +89,10 @@ Status FastTransport::GetConnection(uint64_t to,
     return Status::OK();
 }
 
+void FastTransport::GetCompressionStats(CompressionStats* stats) const {
+    compression_counter_.Collect(stats);
+}
+
 } /* namespace transport */
 } /* namespace impl */
 } /* namespace raft */
@@ -16,7 +16,10 @@ class FastClient;
 class FastTransport : public Transport {
 public:
     FastTransport(const std::shared_ptr<NodeResolver>& resolver,
-                  size_t send_threads_num, size_t recv_threads_num);
+                  size_t send_threads_num, size_t recv_threads_num,
+                  bool use_io_uring = false,
+                  CompressionType compression = CompressionType::kNone,
+                  size_t compression_threshold = 0);
     ~FastTransport();
 
     Status Start(const std::string& listen_ip, uint16_t listen_port,
@@ -29,9 +32,15 @@ public:
     Status GetConnection(uint64_t to,
                          std::shared_ptr<Connection>* conn) override;
 
+    void GetCompressionStats(CompressionStats* stats) const override;
+
 private:
     std::shared_ptr<NodeResolver> resolver_;
     const size_t recv_threads_num_ = 0;
+    const sf_io_backend_t io_backend_ = SF_IO_EPOLL;
+    const CompressionType compression_ = CompressionType::kNone;
+    const size_t compression_threshold_ = 0;
+    CompressionCounter compression_counter_;
 
     FastServer* server_ = nullptr;
     FastClient* client_ = nullptr;
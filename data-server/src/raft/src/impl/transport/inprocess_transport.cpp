@@ -1,5 +1,7 @@
 #include "inprocess_transport.h"
 
+#include "../logger.h"
+
 namespace sharkstore {
 namespace raft {
 namespace impl {
@@ -69,9 +71,15 @@ void InProcessTransport::MsgHub::send(const MessagePtr& msg) {
 
 InProcessTransport::MsgHub InProcessTransport::msg_hub_;
 
-InProcessTransport::InProcessTransport(uint64_t node_id)
+InProcessTransport::InProcessTransport(uint64_t node_id, CompressionType compression,
+                                       size_t compression_threshold)
     : node_id_(node_id), running_(false) {
     assert(node_id_ != 0);
+    if (compression != CompressionType::kNone) {
+        compressor_.reset(new AdaptiveCompressor(compression, compression_threshold,
+                                                 &compression_counter_));
+        compressor_->Negotiate(CompressionMask());
+    }
 }
 
 InProcessTransport::~InProcessTransport() { Shutdown(); }
@@ -98,7 +106,22 @@ void InProcessTransport::Shutdown() {
     }
 }
 
-void InProcessTransport::SendMessage(MessagePtr& msg) { msg_hub_.send(msg); }
+void InProcessTransport::SendMessage(MessagePtr& msg) {
+    ds_header_t header;
+    std::string body;
+    if (compressor_ && compressor_->Encode(*msg, 0, &header, &body)) {
+        // 走一遍网络上的编解码
+        MessagePtr decoded;
+        auto s = DecodeMessage(header, body.data(), &decoded);
+        if (!s.ok()) {
+            LOG_ERROR("raft[InProcess] decode message failed: %s", s.ToString().c_str());
+            return;
+        }
+        msg_hub_.send(decoded);
+    } else {
+        msg_hub_.send(msg);
+    }
+}
 
 Status InProcessTransport::GetConnection(uint64_t to,
                                          std::shared_ptr<Connection>* conn) {
@@ -107,6 +130,10 @@ Status InProcessTransport::GetConnection(uint64_t to,
     return Status::OK();
 }
 
+void InProcessTransport::GetCompressionStats(CompressionStats* stats) const {
+    compression_counter_.Collect(stats);
+}
+
 void InProcessTransport::recvRoutine() {
     MessagePtr msg;
     while (mail_box_->recv(&msg)) {
@@ -16,7 +16,10 @@ namespace transport {
 
 class InProcessTransport : public Transport {
 public:
-    explicit InProcessTransport(uint64_t node_id);
+    // compression不为kNone时消息先压缩再解压后投递，用于测试压缩
+    explicit InProcessTransport(uint64_t node_id,
+                                CompressionType compression = CompressionType::kNone,
+                                size_t compression_threshold = 0);
     ~InProcessTransport();
 
     Status Start(const std::string& listen_ip, uint16_t listen_port,
@@ -27,6 +30,8 @@ public:
 
     Status GetConnection(uint64_t to, std::shared_ptr<Connection>* conn) override;
 
+    void GetCompressionStats(CompressionStats* stats) const override;
+
 private:
     void recvRoutine();
 
@@ -82,6 +87,9 @@ private:
     const uint64_t node_id_;
     MessageHandler handler_;
 
+    CompressionCounter compression_counter_;
+    std::unique_ptr<AdaptiveCompressor> compressor_;
+
     std::atomic<bool> running_ = {true};
     std::shared_ptr<MailBox> mail_box_;
     std::unique_ptr<std::thread> pull_thr_;
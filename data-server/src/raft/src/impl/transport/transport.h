@@ -3,6 +3,7 @@ _Pragma("once");
 #include <functional>
 #include "base/status.h"
 #include "../raft_types.h"
+#include "compression.h"
 
 namespace sharkstore {
 namespace raft {
@@ -41,6 +42,9 @@ public:
 
     // 需要单独建立一个连接用来发快照
     virtual Status GetConnection(uint64_t to, std::shared_ptr<Connection>* conn) = 0;
+
+    // 发送消息的压缩统计
+    virtual void GetCompressionStats(CompressionStats* stats) const = 0;
 };
 
 } /* namespace transport */
@@ -1,6 +1,7 @@
 #include "work_thread.h"
 
 #include <assert.h>
+#include <chrono>
 #include <thread>
 #include "base/util.h"
 #include "logger.h"
@@ -53,6 +54,7 @@ bool WorkThread::submit(uint64_t owner, std::atomic<bool>* stopped,
             entry->set_type(pb::ENTRY_NORMAL);
             entry->mutable_data()->swap(cmd);
         } else if (queue_.size() >= capacity_) {
+            ++rejects_;
             return false;
         } else {
             // 不能合并，new一个
@@ -64,7 +66,7 @@ bool WorkThread::submit(uint64_t owner, std::atomic<bool>* stopped,
             w.stopped = stopped;
             w.f1 = f1;
             w.msg = msg;
-            queue_.push(w);
+            queue_.push_back(w);
             batch_pos_[owner] = msg;
             notify = true;
         }
@@ -80,9 +82,10 @@ bool WorkThread::tryPost(const Work& w) {
         std::lock_guard<std::mutex> lock(mu_);
         if (!running_) return false;
         if (queue_.size() >= capacity_) {
+            ++rejects_;
             return false;
         } else {
-            queue_.push(w);
+            queue_.push_back(w);
         }
     }
     cv_.notify_one();
@@ -93,7 +96,7 @@ void WorkThread::post(const Work& w) {
     {
         std::lock_guard<std::mutex> lock(mu_);
         if (!running_) return;
-        queue_.push(w);
+        queue_.push_back(w);
     }
     cv_.notify_one();
 }
@@ -105,7 +108,7 @@ void WorkThread::waitPost(const Work& w) {
     }
 
     if (running_) {
-        queue_.push(w);
+        queue_.push_back(w);
         lock.unlock();
         cv_.notify_one();
     }
@@ -117,7 +120,7 @@ void WorkThread::shutdown() {
         if (!running_) return;
         running_ = false;
     }
-    cv_.notify_one();
+    cv_.notify_all();
     thr_->join();
 }
 
@@ -128,8 +131,8 @@ bool WorkThread::pull(Work* w) {
         cv_.wait(lock);
     }
     if (!running_) return false;
-    *w = queue_.front();
-    queue_.pop();
+    *w = std::move(queue_.front());
+    queue_.pop_front();
 
     if (w->msg != nullptr && w->msg->type() == pb::LOCAL_MSG_PROP) {
         assert(w->owner != 0);
@@ -149,6 +152,7 @@ void WorkThread::run() {
     while (true) {
         Work work;
         if (pull(&work)) {
+            auto start = std::chrono::steady_clock::now();
             try {
                 work.Do();
             } catch (RaftException& e) {
@@ -157,6 +161,10 @@ void WorkThread::run() {
                           work.owner, e.what());
                 server_->RemoveRaft(work.owner);
             }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            addLoad(work.owner, static_cast<uint64_t>(
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                                        .count()));
         } else {
             // shutdown
             return;
@@ -169,6 +177,128 @@ int WorkThread::size() const {
     return queue_.size();
 }
 
+bool WorkThread::waitSpace() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (queue_.size() >= capacity_ && running_) {
+        // 多个生产者共用一个条件变量，带超时防止丢失唤醒
+        cv_.wait_for(lock, std::chrono::milliseconds(10));
+    }
+    return running_;
+}
+
+void WorkThread::extract(uint64_t owner, std::vector<Work>* works) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto remain = queue_.begin();
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if (it->owner == owner) {
+            works->push_back(std::move(*it));
+        } else {
+            if (remain != it) *remain = std::move(*it);
+            ++remain;
+        }
+    }
+    queue_.erase(remain, queue_.end());
+    batch_pos_.erase(owner);
+}
+
+void WorkThread::append(std::vector<Work>& works) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!running_) return;
+        for (auto& w : works) {
+            queue_.push_back(std::move(w));
+        }
+    }
+    cv_.notify_one();
+}
+
+void WorkThread::addLoad(uint64_t owner, uint64_t ns) {
+    std::lock_guard<std::mutex> lock(load_mu_);
+    busy_ns_ += ns;
+    owner_busy_ns_[owner] += ns;
+}
+
+void WorkThread::takeLoad(uint64_t* busy_ns, std::unordered_map<uint64_t, uint64_t>* owners,
+                          uint64_t* rejects) {
+    owners->clear();
+    {
+        std::lock_guard<std::mutex> lock(load_mu_);
+        *busy_ns = busy_ns_;
+        busy_ns_ = 0;
+        owners->swap(owner_busy_ns_);
+    }
+    *rejects = rejects_.exchange(0);
+}
+
+WorkRoute::WorkRoute(uint64_t owner, std::atomic<bool>* stopped, WorkThread* thread)
+    : owner_(owner), stopped_(stopped), thread_(thread) {
+    assert(thread_ != nullptr);
+}
+
+WorkThread* WorkRoute::thread() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return thread_;
+}
+
+bool WorkRoute::migrating() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return migrating_;
+}
+
+bool WorkRoute::submit(const std::function<void(MessagePtr&)>& f1, std::string& cmd) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return thread_->submit(owner_, stopped_, f1, cmd);
+}
+
+bool WorkRoute::tryPost(const Work& w) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return thread_->tryPost(w);
+}
+
+void WorkRoute::post(const Work& w) {
+    std::lock_guard<std::mutex> lock(mu_);
+    thread_->post(w);
+}
+
+void WorkRoute::waitPost(const Work& w) {
+    while (true) {
+        WorkThread* t = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (thread_->tryPost(w)) return;
+            t = thread_;
+        }
+        // 等待时不持有route的锁，等到空间后可能已经迁移了，重新投递
+        if (!t->waitSpace()) return;
+    }
+}
+
+bool WorkRoute::migrate(WorkThread* target) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (migrating_ || target == thread_) {
+        return false;
+    }
+    Work w;
+    w.owner = owner_;
+    w.stopped = stopped_;
+    w.f0 = std::bind(&WorkRoute::doMigrate, shared_from_this(), target);
+    migrating_ = true;
+    thread_->post(w);
+    return true;
+}
+
+void WorkRoute::doMigrate(WorkThread* target) {
+    // 在原线程上执行，迁移任务之前投递的任务都已经执行完了
+    std::lock_guard<std::mutex> lock(mu_);
+    std::vector<Work> works;
+    thread_->extract(owner_, &works);
+    thread_ = target;
+    migrating_ = false;
+    if (!works.empty()) {
+        target->append(works);
+    }
+}
+
 } /* namespace impl */
 } /* namespace raft */
 } /* namespace sharkstore */
@@ -4,7 +4,8 @@ _Pragma("once");
 #include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <deque>
+#include <vector>
 #include <thread>
 #include <functional>
 #include <unordered_map>
@@ -49,9 +50,22 @@ public:
     void shutdown();
     int size() const;
 
+    // 等待队列不满，返回false表示已经shutdown
+    bool waitSpace();
+
+    // 取出owner在队列里剩余的所有任务(保持顺序)，迁移时使用
+    void extract(uint64_t owner, std::vector<Work>* works);
+    // 把迁移过来的任务追加到队尾，不受队列长度限制
+    void append(std::vector<Work>& works);
+
+    // 取出上次调用以来的负载统计：线程总耗时，每个owner的耗时，队列满拒绝的次数
+    void takeLoad(uint64_t* busy_ns, std::unordered_map<uint64_t, uint64_t>* owners,
+                  uint64_t* rejects);
+
 private:
     bool pull(Work* w);
     void run();
+    void addLoad(uint64_t owner, uint64_t ns);
 
 private:
     RaftServerImpl* server_ = nullptr;
@@ -59,11 +73,51 @@ private:
 
     std::unique_ptr<std::thread> thr_;
     bool running_ = false;
-    std::queue<Work> queue_;
+    std::deque<Work> queue_;
     // 记录每个range最近一条LOCAL_MSG_PROP消息，便于batch合并
     std::unordered_map<uint64_t, MessagePtr> batch_pos_;
     mutable std::mutex mu_;
     std::condition_variable cv_;
+
+    std::mutex load_mu_;
+    uint64_t busy_ns_ = 0;
+    std::unordered_map<uint64_t, uint64_t> owner_busy_ns_;
+    std::atomic<uint64_t> rejects_ = {0};
+};
+
+// 一个raft在一个线程池里的路由，raft的所有任务都通过它投递
+// 可以在线程之间迁移，迁移保证同一个raft的任务顺序不变
+class WorkRoute : public std::enable_shared_from_this<WorkRoute> {
+public:
+    WorkRoute(uint64_t owner, std::atomic<bool>* stopped, WorkThread* thread);
+
+    WorkRoute(const WorkRoute&) = delete;
+    WorkRoute& operator=(const WorkRoute&) = delete;
+
+    WorkThread* thread() const;
+
+    bool submit(const std::function<void(MessagePtr&)>& f1, std::string& cmd);
+    bool tryPost(const Work& w);
+    void post(const Work& w);
+    void waitPost(const Work& w);
+
+    // 迁移到target线程，已经在迁移中返回false
+    // 先在原线程投递一个迁移任务，等原线程执行到它时(之前的任务都已经执行完)
+    // 再把剩余的任务按顺序挪到target，之后的任务直接投递到target
+    bool migrate(WorkThread* target);
+    bool migrating() const;
+
+private:
+    void doMigrate(WorkThread* target);
+
+private:
+    const uint64_t owner_;
+    std::atomic<bool>* stopped_ = nullptr;
+
+    // 加锁顺序：先route再WorkThread
+    mutable std::mutex mu_;
+    WorkThread* thread_ = nullptr;
+    bool migrating_ = false;
 };
 
 } /* namespace impl */
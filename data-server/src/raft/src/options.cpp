@@ -1,9 +1,16 @@
 #include "raft/options.h"
 
+#include "impl/transport/compression.h"
+
 namespace sharkstore {
 namespace raft {
 
 Status TransportOptions::Validate() const {
+    if (!impl::transport::CompressionSupported(compression)) {
+        return Status(Status::kNotSupported, "raft transport compression",
+                      CompressionTypeName(compression));
+    }
+
     if (use_inprocess_transport) return Status::OK();
 
     if (listen_port == 0) {
@@ -71,6 +78,11 @@ Status RaftServerOptions::Validate() const {
         return Status(Status::kInvalidArgument, "raft server options",
                       "max size per msg");
     }
+    // 窗口至少能放下一个batch
+    if (max_inflight_bytes > 0 && max_inflight_bytes < max_size_per_msg) {
+        return Status(Status::kInvalidArgument, "raft server options",
+                      "max inflight bytes");
+    }
 
     if (consensus_threads_num == 0) {
         return Status(Status::kInvalidArgument, "raft server options",
@@ -92,6 +104,21 @@ Status RaftServerOptions::Validate() const {
         }
     }
 
+    if (enable_rebalance) {
+        if (rebalance_interval.count() <= 0) {
+            return Status(Status::kInvalidArgument, "raft server options",
+                          "rebalance interval");
+        }
+        if (rebalance_busy_percent == 0 || rebalance_busy_percent > 100) {
+            return Status(Status::kInvalidArgument, "raft server options",
+                          "rebalance busy percent");
+        }
+        if (rebalance_imbalance_percent == 0 || rebalance_imbalance_percent > 100) {
+            return Status(Status::kInvalidArgument, "raft server options",
+                          "rebalance imbalance percent");
+        }
+    }
+
     auto s = snapshot_options.Validate();
     if (!s.ok()) return s;
 
@@ -13,11 +13,35 @@ std::string ReplicaStatus::ToString() const {
     ss << "\"commit\": " << commit << ", ";
     ss << "\"next\": " << next << ", ";
     ss << "\"inactive\": " << inactive_seconds << ", ";
+    ss << "\"inflight_msgs\": " << inflight_msgs << ", ";
+    ss << "\"inflight_bytes\": " << inflight_bytes << ", ";
+    ss << "\"window\": " << window_bytes << ", ";
+    ss << "\"srtt_us\": " << srtt_us << ", ";
+    ss << "\"min_rtt_us\": " << min_rtt_us << ", ";
+    ss << "\"bandwidth\": " << bandwidth << ", ";
     ss << "\"state\": \"" << state << "\"";
     ss << "}";
     return ss.str();
 }
 
+std::string LogGCStatus::ToString() const {
+    std::ostringstream ss;
+    ss << "{";
+    ss << "\"first_index\": " << first_index << ", ";
+    ss << "\"files\": " << files << ", ";
+    ss << "\"bytes\": " << bytes << ", ";
+    ss << "\"free_bytes\": " << free_bytes << ", ";
+    ss << "\"hold_index\": " << hold_index << ", ";
+    ss << "\"hold_node\": " << hold_node << ", ";
+    ss << "\"pressure\": \"" << pressure << "\", ";
+    ss << "\"truncated_index\": " << truncated_index << ", ";
+    ss << "\"reason\": \"" << reason << "\", ";
+    ss << "\"truncations\": " << truncations << ", ";
+    ss << "\"forced_truncations\": " << forced_truncations;
+    ss << "}";
+    return ss.str();
+}
+
 RaftStatus::RaftStatus(RaftStatus&& s) { *this = std::move(s); }
 
 RaftStatus& RaftStatus::operator=(RaftStatus&& s) {
@@ -30,6 +54,7 @@ RaftStatus& RaftStatus::operator=(RaftStatus&& s) {
         applied = std::move(s.applied);
         state = std::move(s.state);
         replicas = std::move(s.replicas);
+        log_gc = std::move(s.log_gc);
     }
     return *this;
 }
@@ -53,7 +78,9 @@ std::string RaftStatus::ToString() const {
             ss << ", ";
         }
     }
-    ss << "]}";
+    ss << "], ";
+    ss << "\"log_gc\": " << log_gc.ToString();
+    ss << "}";
     return ss.str();
 }
 
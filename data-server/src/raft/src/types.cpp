@@ -1,5 +1,6 @@
 #include "raft/types.h"
 
+#include <algorithm>
 #include <sstream>
 
 namespace sharkstore {
@@ -16,6 +17,34 @@ std::string PeerTypeName(PeerType type) {
     }
 }
 
+std::string CompressionTypeName(CompressionType type) {
+    switch (type) {
+        case CompressionType::kNone:
+            return "none";
+        case CompressionType::kLZ4:
+            return "lz4";
+        case CompressionType::kZstd:
+            return "zstd";
+        default:
+            return std::string("unknown(") + std::to_string(static_cast<int>(type)) + ")";
+    }
+}
+
+bool ParseCompressionType(const std::string& name, CompressionType* type) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower.empty() || lower == "none") {
+        *type = CompressionType::kNone;
+    } else if (lower == "lz4") {
+        *type = CompressionType::kLZ4;
+    } else if (lower == "zstd") {
+        *type = CompressionType::kZstd;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 std::string Peer::ToString() const {
     std::ostringstream ss;
     ss << "{";
@@ -2,6 +2,8 @@ _Pragma("once");
 
 #include <cstddef>
 
+#include "raft/types.h"
+
 namespace sharkstore {
 namespace raft {
 namespace bench {
@@ -11,11 +13,26 @@ struct BenchConfig {
     std::size_t thread_num = 3;
     std::size_t range_num = 1;
     std::size_t concurrency = 100;
+    // 第三个节点跑到一半才启动，leader需要给它补发之前的日志
+    bool lagging_follower = false;
+    // 每个请求附带的类似json的数据大小，测试压缩
+    std::size_t value_size = 0;
+    // 倾斜负载：hot_percent%的请求发给hot_range_num个热点range
+    // 热点range按创建顺序挑选，初始都落在同一个raft线程上(id为1, 1+raft_thread_num, ...)
+    std::size_t hot_range_num = 0;
+    std::size_t hot_percent = 80;
+    // 每次apply模拟的cpu耗时(微秒)，让raft线程真正忙起来
+    std::size_t apply_cost_us = 0;
 
     bool use_memory_raft_log = false;
     bool use_inprocess_transport = false;
     std::size_t raft_thread_num = 1;
     std::size_t apply_thread_num = 1;
+    std::size_t entry_cache_size = 64 * 1024 * 1024;
+    CompressionType compression = CompressionType::kNone;
+    std::size_t compression_threshold = 4096;
+    bool enable_rebalance = true;
+    std::size_t rebalance_interval = 10;  // 秒
 };
 
 extern BenchConfig bench_config;
@@ -30,6 +30,24 @@ static int load_conf_file(IniContext *ini_context, const char *filename) {
     std::cout << "bench concurrency per thread: " << bench_config.concurrency
               << std::endl;
 
+    bench_config.lagging_follower =
+        iniGetBoolValue(bench_section, "lagging_follower", ini_context, false);
+    std::cout << "lagging follower: " << bench_config.lagging_follower << std::endl;
+
+    bench_config.value_size = iniGetIntValue(bench_section, "value_size", ini_context, 0);
+    std::cout << "value size: " << bench_config.value_size << std::endl;
+
+    bench_config.hot_range_num =
+        iniGetIntValue(bench_section, "hot_range_num", ini_context, 0);
+    std::cout << "hot range num: " << bench_config.hot_range_num << std::endl;
+
+    bench_config.hot_percent = iniGetIntValue(bench_section, "hot_percent", ini_context, 80);
+    std::cout << "hot percent: " << bench_config.hot_percent << std::endl;
+
+    bench_config.apply_cost_us =
+        iniGetIntValue(bench_section, "apply_cost_us", ini_context, 0);
+    std::cout << "apply cost us: " << bench_config.apply_cost_us << std::endl;
+
     const char *raft_section = "raft";
     bench_config.use_memory_raft_log =
         iniGetBoolValue(raft_section, "use_memory_raft_log", ini_context, false);
@@ -48,6 +66,32 @@ static int load_conf_file(IniContext *ini_context, const char *filename) {
         iniGetIntValue(raft_section, "apply_thread_num", ini_context, 1);
     std::cout << "raft apply thread num: " << bench_config.apply_thread_num << std::endl;
 
+    bench_config.entry_cache_size =
+        iniGetInt64Value(raft_section, "entry_cache_size", ini_context, 64 * 1024 * 1024);
+    std::cout << "raft entry cache size: " << bench_config.entry_cache_size << std::endl;
+
+    const char *compression = iniGetStrValue(raft_section, "compression", ini_context);
+    if (compression != NULL &&
+        !ParseCompressionType(compression, &bench_config.compression)) {
+        std::cerr << "invalid compression: " << compression << std::endl;
+        return -1;
+    }
+    std::cout << "raft compression: " << CompressionTypeName(bench_config.compression)
+              << std::endl;
+
+    bench_config.compression_threshold =
+        iniGetIntValue(raft_section, "compression_threshold", ini_context, 4096);
+    std::cout << "raft compression threshold: " << bench_config.compression_threshold
+              << std::endl;
+
+    bench_config.enable_rebalance =
+        iniGetBoolValue(raft_section, "rebalance", ini_context, true);
+    std::cout << "raft rebalance: " << bench_config.enable_rebalance << std::endl;
+
+    bench_config.rebalance_interval =
+        iniGetIntValue(raft_section, "rebalance_interval", ini_context, 10);
+    std::cout << "raft rebalance interval: " << bench_config.rebalance_interval << std::endl;
+
     return 0;
 }
 
@@ -23,6 +23,19 @@ struct BenchContext {
     std::vector<std::shared_ptr<Range>> leaders;
 };
 
+// 倾斜负载时大部分请求发给热点range，热点range初始都在同一个raft线程上
+static size_t pickRange(int64_t num, size_t range_num) {
+    size_t hot_num = bench_config.hot_range_num;
+    size_t step = bench_config.raft_thread_num;
+    while (hot_num > 0 && 1 + (hot_num - 1) * step > range_num) {
+        --hot_num;
+    }
+    if (hot_num > 0 && static_cast<size_t>(num % 100) < bench_config.hot_percent) {
+        return (static_cast<size_t>(num / 100) % hot_num) * step;
+    }
+    return static_cast<size_t>(num) % range_num;
+}
+
 void runBenchmark(BenchContext *ctx) {
     while (true) {
         std::vector<std::shared_future<bool>> futures;
@@ -30,7 +43,7 @@ void runBenchmark(BenchContext *ctx) {
             auto num = ctx->counter.fetch_sub(1);
             if (num > 0) {
                 futures.push_back(
-                    (ctx->leaders)[num % ctx->leaders.size()]->AsyncRequest());
+                    (ctx->leaders)[pickRange(num, ctx->leaders.size())]->AsyncRequest());
             } else {
                 break;
             }
@@ -65,20 +78,22 @@ int main(int argc, char *argv[]) {
 
     std::vector<std::shared_ptr<bench::Node>> cluster;
     for (size_t i = 1; i <= 3; ++i) {
-        auto node = std::make_shared<bench::Node>(i, addr_mgr);
-        node->Start();
-        cluster.push_back(node);
+        cluster.push_back(std::make_shared<bench::Node>(i, addr_mgr));
+    }
+    size_t started = bench_config.lagging_follower ? cluster.size() - 1 : cluster.size();
+    for (size_t i = 0; i < started; ++i) {
+        cluster[i]->Start();
     }
 
     BenchContext context;
     context.counter = bench_config.request_num;
     context.leaders.resize(bench_config.range_num);
     for (uint64_t i = 1; i <= bench_config.range_num; ++i) {
-        for (auto &n : cluster) {
-            auto r = n->GetRange(i);
+        for (size_t j = 0; j < started; ++j) {
+            auto r = cluster[j]->GetRange(i);
             r->WaitLeader();
             if (r->IsLeader()) {
-                context.leaders[i] = r;
+                context.leaders[i - 1] = r;
             }
         }
     }
@@ -92,6 +107,15 @@ int main(int argc, char *argv[]) {
     for (size_t i = 0; i < bench_config.thread_num; ++i) {
         threads.push_back(std::thread(std::bind(&runBenchmark, &context)));
     }
+    if (bench_config.lagging_follower) {
+        threads.push_back(std::thread([&context, &cluster] {
+            auto half = static_cast<int64_t>(bench_config.request_num / 2);
+            while (context.counter > half) {
+                usleep(1000);
+            }
+            cluster.back()->Start();
+        }));
+    }
     for (auto &t : threads) {
         t.join();
     }
@@ -109,5 +133,28 @@ int main(int argc, char *argv[]) {
                      (taken.tv_sec * 1000 + taken.tv_usec / 1000)
               << std::endl;
 
+    std::cout << "latency(us) p50: " << request_latency.Percentile(50)
+              << ", p99: " << request_latency.Percentile(99)
+              << ", p999: " << request_latency.Percentile(99.9) << std::endl;
+
+    for (size_t i = 0; i < cluster.size(); ++i) {
+        ServerStatus status;
+        cluster[i]->GetServerStatus(&status);
+        std::cout << "node " << i + 1 << " entry cache size: " << status.entry_cache_size
+                  << ", hits: " << status.entry_cache_hits
+                  << ", misses: " << status.entry_cache_misses << std::endl;
+        if (bench_config.compression != CompressionType::kNone) {
+            std::cout << "node " << i + 1 << " compress bytes: " << status.compress_raw_bytes
+                      << " -> " << status.compress_sent_bytes
+                      << ", compressed msgs: " << status.compressed_msgs
+                      << ", skipped msgs: " << status.compress_skipped_msgs << std::endl;
+        }
+        std::cout << "node " << i + 1 << " rebalance migrations: " << status.rebalance_migrations
+                  << std::endl;
+        for (const auto &d : status.rebalance_decisions) {
+            std::cout << "  " << d << std::endl;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -16,9 +16,14 @@ Node::Node(uint64_t node_id, std::shared_ptr<NodeAddress> addrs)
     ops.node_id = node_id_;
     ops.apply_threads_num = bench_config.apply_thread_num;
     ops.consensus_threads_num = bench_config.raft_thread_num;
+    ops.entry_cache_capacity = bench_config.entry_cache_size;
+    ops.enable_rebalance = bench_config.enable_rebalance;
+    ops.rebalance_interval = std::chrono::seconds(bench_config.rebalance_interval);
     ops.election_tick = 2;
     ops.transport_options.listen_port = addr_mgr_->GetListenPort(node_id_);
-    ops.transport_options.use_inprocess_transport = false;
+    ops.transport_options.use_inprocess_transport = bench_config.use_inprocess_transport;
+    ops.transport_options.compression = bench_config.compression;
+    ops.transport_options.compression_threshold = bench_config.compression_threshold;
     ops.transport_options.resolver =
         std::static_pointer_cast<NodeResolver>(addr_mgr_);
     raft_server_ = CreateRaftServer(ops);
@@ -23,6 +23,7 @@ public:
 
     void Start();
     std::shared_ptr<Range> GetRange(uint64_t i);
+    void GetServerStatus(ServerStatus* status) const { raft_server_->GetStatus(status); }
 
 private:
     const uint64_t node_id_;
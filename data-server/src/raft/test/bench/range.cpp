@@ -1,6 +1,7 @@
 #include "range.h"
 
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 
 #include "address.h"
@@ -10,9 +11,32 @@ namespace sharkstore {
 namespace raft {
 namespace bench {
 
+LatencyStats request_latency;
+
+void LatencyStats::Add(uint64_t us) {
+    std::unique_lock<std::mutex> lock(mu_);
+    values_.push_back(us);
+}
+
+size_t LatencyStats::Count() {
+    std::unique_lock<std::mutex> lock(mu_);
+    return values_.size();
+}
+
+uint64_t LatencyStats::Percentile(double p) {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (values_.empty()) return 0;
+    size_t pos = static_cast<size_t>(values_.size() * p / 100);
+    if (pos >= values_.size()) pos = values_.size() - 1;
+    std::nth_element(values_.begin(), values_.begin() + pos, values_.end());
+    return values_[pos];
+}
+
 uint64_t Range::RequestQueue::add(std::shared_future<bool>* f) {
     std::unique_lock<std::mutex> lock(mu_);
-    *f = que_[++seq_].get_future();
+    auto& req = que_[++seq_];
+    req.start = std::chrono::steady_clock::now();
+    *f = req.promise.get_future();
     return seq_;
 }
 
@@ -20,7 +44,10 @@ void Range::RequestQueue::set(uint64_t seq, bool value) {
     std::unique_lock<std::mutex> lock(mu_);
     auto it = que_.find(seq);
     if (it != que_.end()) {
-        it->second.set_value(value);
+        auto elapsed = std::chrono::steady_clock::now() - it->second.start;
+        request_latency.Add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        it->second.promise.set_value(value);
         que_.erase(it);
     }
 }
@@ -71,10 +98,25 @@ void Range::SyncRequest() {
     f.wait();
 }
 
+// 类似json的行数据，字段名重复出现，压缩率跟业务数据接近
+static std::string makeValue(uint64_t seq, size_t size) {
+    std::string value;
+    value.reserve(size + 128);
+    while (value.size() < size) {
+        value += "{\"id\":" + std::to_string(seq) + ",\"name\":\"user_" +
+                 std::to_string(seq % 1000) + "\",\"status\":\"active\",\"tags\":[\"a\",\"b\"]},";
+    }
+    value.resize(size);
+    return value;
+}
+
 std::shared_future<bool> Range::AsyncRequest() {
     std::shared_future<bool> f;
     uint64_t seq = request_queue_.add(&f);
     std::string cmd = std::to_string(seq);
+    if (bench_config.value_size > 0) {
+        cmd += " " + makeValue(seq, bench_config.value_size);
+    }
     auto rs = raft_->Submit(cmd);
     if (!rs.ok()) {
         throw std::runtime_error(std::string("submit failed:") + rs.ToString());
@@ -83,7 +125,17 @@ std::shared_future<bool> Range::AsyncRequest() {
     }
 }
 
+// 模拟apply的cpu耗时
+static void burnCpu(size_t us) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
 Status Range::Apply(const std::string& cmd, uint64_t index) {
+    if (bench_config.apply_cost_us > 0) {
+        burnCpu(bench_config.apply_cost_us);
+    }
     uint64_t seq = strtoull(cmd.c_str(), NULL, 10);
     request_queue_.set(seq, true);
     return Status::OK();
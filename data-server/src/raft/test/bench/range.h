@@ -1,7 +1,10 @@
 _Pragma("once");
 
+#include <chrono>
 #include <future>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "raft/raft.h"
 #include "raft/server.h"
@@ -12,6 +15,21 @@ namespace bench {
 
 class NodeAddress;
 
+// 请求从提交到leader上应用完成的耗时，所有range共用
+class LatencyStats {
+public:
+    void Add(uint64_t us);
+    size_t Count();
+    // p: 0~100
+    uint64_t Percentile(double p);
+
+private:
+    std::mutex mu_;
+    std::vector<uint64_t> values_;
+};
+
+extern LatencyStats request_latency;
+
 class Range : public raft::StateMachine,
               public std::enable_shared_from_this<Range> {
 public:
@@ -53,7 +71,11 @@ private:
         void remove(uint64_t seq);
 
     private:
-        std::unordered_map<uint64_t, std::promise<bool>> que_;
+        struct Request {
+            std::promise<bool> promise;
+            std::chrono::steady_clock::time_point start;
+        };
+        std::unordered_map<uint64_t, Request> que_;
         std::mutex mu_;
         uint64_t seq_ = 0;
     };
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+
+#include "base/util.h"
+#include "raft/src/impl/transport/compression.h"
+#include "raft/src/impl/transport/inprocess_transport.h"
+#include "test_util.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore;
+using namespace sharkstore::raft;
+using namespace sharkstore::raft::impl;
+using namespace sharkstore::raft::impl::transport;
+using namespace sharkstore::raft::impl::testutil;
+
+static const CompressionType kAllTypes[] = {CompressionType::kLZ4, CompressionType::kZstd};
+
+static std::string jsonValue(size_t size) {
+    std::string value;
+    while (value.size() < size) {
+        value += "{\"id\":" + std::to_string(value.size()) +
+                 ",\"name\":\"sharkstore\",\"status\":\"active\"},";
+    }
+    value.resize(size);
+    return value;
+}
+
+// 压缩不了的数据
+static std::string randomBytes(size_t size) {
+    std::string value(size, '\0');
+    for (auto& c : value) {
+        c = static_cast<char>(randomInt() % 256);
+    }
+    return value;
+}
+
+static MessagePtr appendMessage(int entries, bool compressible) {
+    MessagePtr msg(new pb::Message);
+    msg->set_type(pb::APPEND_ENTRIES_REQUEST);
+    msg->set_id(1);
+    msg->set_from(1);
+    msg->set_to(2);
+    msg->set_term(3);
+    for (int i = 1; i <= entries; ++i) {
+        auto e = msg->add_entries();
+        e->set_index(i);
+        e->set_term(3);
+        e->set_type(pb::ENTRY_NORMAL);
+        e->set_data(compressible ? jsonValue(1024) : randomBytes(1024));
+    }
+    return msg;
+}
+
+static Status equal(const MessagePtr& lh, const MessagePtr& rh) {
+    if (lh->SerializeAsString() != rh->SerializeAsString()) {
+        return Status(Status::kCorruption, "message", lh->ShortDebugString());
+    }
+    return Status::OK();
+}
+
+TEST(Compression, Codec) {
+    auto input = jsonValue(64 * 1024);
+    for (auto type : kAllTypes) {
+        if (!CompressionSupported(type)) {
+            std::string output;
+            ASSERT_EQ(Compress(type, input, &output).code(), Status::kNotSupported);
+            continue;
+        }
+        ASSERT_NE(CompressionMask() & (1 << static_cast<int>(type)), 0);
+
+        std::string compressed, raw;
+        auto s = Compress(type, input, &compressed);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        ASSERT_LT(compressed.size(), input.size() / 4) << CompressionTypeName(type);
+        s = Uncompress(type, compressed.data(), compressed.size(), input.size(), &raw);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        ASSERT_EQ(raw, input);
+
+        // 长度不对或者数据损坏
+        s = Uncompress(type, compressed.data(), compressed.size(), input.size() + 1, &raw);
+        ASSERT_FALSE(s.ok());
+        s = Uncompress(type, compressed.data(), compressed.size() / 2, input.size(), &raw);
+        ASSERT_FALSE(s.ok());
+    }
+}
+
+TEST(Compression, Encode) {
+    for (auto type : kAllTypes) {
+        if (!CompressionSupported(type)) continue;
+
+        CompressionCounter counter;
+        AdaptiveCompressor compressor(type, 4096, &counter);
+        ds_header_t header;
+        std::string body;
+
+        // 协商之前不压缩
+        auto msg = appendMessage(16, true);
+        ASSERT_FALSE(compressor.Encode(*msg, 1, &header, &body));
+        // 对端不支持
+        compressor.Negotiate(1 << static_cast<int>(CompressionType::kNone));
+        ASSERT_EQ(compressor.Type(), CompressionType::kNone);
+        ASSERT_FALSE(compressor.Encode(*msg, 1, &header, &body));
+
+        compressor.Negotiate(CompressionMask());
+        ASSERT_EQ(compressor.Type(), type);
+        ASSERT_TRUE(compressor.Encode(*msg, 1, &header, &body));
+        ASSERT_EQ(header.func_id, kFuncRaftCompressed);
+        ASSERT_EQ(header.body_len, static_cast<int>(body.size()));
+        ASSERT_EQ(header.time_out, static_cast<int>(msg->ByteSizeLong()));
+
+        MessagePtr decoded;
+        auto s = DecodeMessage(header, body.data(), &decoded);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        ASSERT_TRUE(equal(msg, decoded).ok());
+
+        CompressionStats stats;
+        counter.Collect(&stats);
+        ASSERT_EQ(stats.raw_bytes, msg->ByteSizeLong());
+        ASSERT_EQ(stats.compressed_bytes, body.size());
+        ASSERT_EQ(stats.compressed_msgs, 1);
+
+        // 小消息和其他类型的消息不压缩
+        auto small = appendMessage(1, true);
+        ASSERT_FALSE(compressor.Encode(*small, 1, &header, &body));
+        msg->set_type(pb::HEARTBEAT_REQUEST);
+        ASSERT_FALSE(compressor.Encode(*msg, 1, &header, &body));
+    }
+}
+
+TEST(Compression, Adaptive) {
+    for (auto type : kAllTypes) {
+        if (!CompressionSupported(type)) continue;
+
+        CompressionCounter counter;
+        AdaptiveCompressor compressor(type, 4096, &counter);
+        compressor.Negotiate(CompressionMask());
+
+        // 随机数据压缩不了，连续几次以后暂停
+        auto msg = appendMessage(16, false);
+        ds_header_t header;
+        std::string body;
+        for (int i = 0; i < AdaptiveCompressor::kMaxPoorTimes; ++i) {
+            ASSERT_TRUE(compressor.Encode(*msg, 1, &header, &body));
+            ASSERT_EQ(header.func_id, kFuncRaftMessage);
+            MessagePtr decoded;
+            ASSERT_TRUE(DecodeMessage(header, body.data(), &decoded).ok());
+            ASSERT_TRUE(equal(msg, decoded).ok());
+        }
+        ASSERT_TRUE(compressor.Paused());
+
+        auto good = appendMessage(16, true);
+        for (int i = 0; i < AdaptiveCompressor::kPauseMsgs; ++i) {
+            ASSERT_FALSE(compressor.Encode(*good, 1, &header, &body));
+        }
+        ASSERT_FALSE(compressor.Paused());
+
+        // 恢复压缩
+        ASSERT_TRUE(compressor.Encode(*good, 1, &header, &body));
+        ASSERT_EQ(header.func_id, kFuncRaftCompressed);
+
+        CompressionStats stats;
+        counter.Collect(&stats);
+        ASSERT_EQ(stats.skipped_msgs, AdaptiveCompressor::kPauseMsgs);
+        ASSERT_EQ(stats.compressed_msgs, 1);
+        ASSERT_EQ(stats.raw_bytes,
+                  msg->ByteSizeLong() * AdaptiveCompressor::kMaxPoorTimes +
+                      good->ByteSizeLong());
+    }
+}
+
+TEST(Compression, InProcessTransport) {
+    for (auto type : kAllTypes) {
+        if (!CompressionSupported(type)) continue;
+
+        std::mutex mu;
+        std::condition_variable cond;
+        std::vector<MessagePtr> received;
+
+        transport::InProcessTransport recv_trans(2);
+        auto s = recv_trans.Start("", 0, [&](MessagePtr& msg) {
+            std::lock_guard<std::mutex> lock(mu);
+            received.push_back(msg);
+            cond.notify_one();
+        });
+        ASSERT_TRUE(s.ok()) << s.ToString();
+
+        transport::InProcessTransport send_trans(1, type, 4096);
+        s = send_trans.Start("", 0, [](MessagePtr&) {});
+        ASSERT_TRUE(s.ok()) << s.ToString();
+
+        std::vector<MessagePtr> sent;
+        sent.push_back(appendMessage(16, true));
+        sent.push_back(appendMessage(1, true));
+        sent.push_back(appendMessage(16, false));
+        for (auto msg : sent) {
+            send_trans.SendMessage(msg);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            ASSERT_TRUE(cond.wait_for(lock, std::chrono::seconds(5),
+                                      [&] { return received.size() == sent.size(); }));
+        }
+        for (size_t i = 0; i < sent.size(); ++i) {
+            ASSERT_TRUE(equal(sent[i], received[i]).ok());
+        }
+        // 第一个是压缩后发送的
+        ASSERT_NE(received[0].get(), sent[0].get());
+        ASSERT_EQ(received[1].get(), sent[1].get());
+
+        CompressionStats stats;
+        send_trans.GetCompressionStats(&stats);
+        ASSERT_EQ(stats.compressed_msgs, 1);
+        ASSERT_EQ(stats.raw_bytes, sent[0]->ByteSizeLong() + sent[2]->ByteSizeLong());
+        ASSERT_LT(stats.compressed_bytes, stats.raw_bytes);
+
+        send_trans.Shutdown();
+        recv_trans.Shutdown();
+    }
+}
+
+} /* namespace  */
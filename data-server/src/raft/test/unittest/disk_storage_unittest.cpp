@@ -2,6 +2,7 @@
 
 #include "base/util.h"
 #include "proto/gen/raft_cmdpb.pb.h"
+#include "raft/src/impl/storage/log_file_pool.h"
 #include "raft/src/impl/storage/storage_disk.h"
 #include "test_util.h"
 
@@ -301,6 +302,53 @@ TEST_F(StorageTest, KeepCount) {
     ASSERT_TRUE(s.ok()) << s.ToString();
 }
 
+TEST_F(StorageTest, Recycle) {
+    LogFilePool pool(tmp_dir_ + "/recycle", 4);
+    auto s = pool.Open();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ops_.preallocate = true;
+    ops_.recycle_pool = &pool;
+    LimitMaxLogs(3);
+
+    std::vector<EntryPtr> to_writes;
+    RandomEntries(1, 100, 256, &to_writes);
+    s = storage_->StoreEntries(to_writes);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    storage_->AppliedTo(99);
+
+    // 截断的旧文件进入回收池，超过容量的删除
+    to_writes.push_back(RandomEntry(100, 256));
+    s = storage_->StoreEntries(std::vector<EntryPtr>{to_writes.back()});
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(pool.Size(), 4U);
+    ASSERT_EQ(pool.Recycled(), 4U);
+
+    // 新文件复用回收的文件，旧数据不影响读取和恢复
+    std::vector<EntryPtr> more;
+    RandomEntries(101, 120, 256, &more);
+    s = storage_->StoreEntries(more);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_GT(pool.Reused(), 0U);
+    to_writes.insert(to_writes.end(), more.begin(), more.end());
+
+    uint64_t first = 0;
+    s = storage_->FirstIndex(&first);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ReOpen();
+    std::vector<EntryPtr> ents;
+    bool compacted = false;
+    s = storage_->Entries(first, 120, std::numeric_limits<uint64_t>::max(), &ents,
+                          &compacted);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_FALSE(compacted);
+    ASSERT_EQ(ents.size(), 120 - first);
+    for (const auto& e : ents) {
+        s = Equal(e, to_writes[e->index() - 1]);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    ops_.recycle_pool = nullptr;
+}
+
 TEST_F(StorageTest, Destroy) {
     uint64_t lo = 1, hi = 100;
     std::vector<EntryPtr> to_writes;
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include "raft/src/impl/entry_cache.h"
+#include "raft/src/impl/raft_log.h"
+#include "raft/src/impl/storage/storage_memory.h"
+#include "test_util.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore::raft::impl;
+using namespace sharkstore::raft::impl::testutil;
+
+static uint64_t entriesSize(const std::vector<EntryPtr>& ents) {
+    uint64_t size = 0;
+    for (const auto& e : ents) {
+        size += e->ByteSizeLong();
+    }
+    return size;
+}
+
+TEST(EntryCache, AppendAndGet) {
+    EntryCache cache(kNoLimit);
+    std::vector<EntryPtr> ents;
+    RandomEntries(10, 20, 64, &ents);
+    cache.Append(1, ents);
+    ASSERT_EQ(cache.Size(), entriesSize(ents));
+
+    std::vector<EntryPtr> result;
+    ASSERT_EQ(cache.Get(1, 12, 18, kNoLimit, &result), 18);
+    ASSERT_TRUE(Equal(result, std::vector<EntryPtr>(ents.begin() + 2, ents.begin() + 8)).ok());
+    ASSERT_EQ(result[0].get(), ents[2].get());  // 共享同一个entry
+    ASSERT_EQ(cache.Hits(), 1);
+
+    // 超过缓存的部分
+    result.clear();
+    ASSERT_EQ(cache.Get(1, 15, 25, kNoLimit, &result), 20);
+    ASSERT_EQ(result.size(), 5);
+    ASSERT_EQ(cache.Misses(), 1);
+
+    // 在缓存之前
+    result.clear();
+    ASSERT_EQ(cache.Get(1, 5, 15, kNoLimit, &result), 5);
+    ASSERT_TRUE(result.empty());
+    // 其他raft
+    ASSERT_EQ(cache.Get(2, 12, 15, kNoLimit, &result), 12);
+    ASSERT_TRUE(result.empty());
+    ASSERT_EQ(cache.Misses(), 3);
+
+    // max_size, 至少一条
+    ASSERT_EQ(cache.Get(1, 10, 20, 1, &result), 20);
+    ASSERT_EQ(result.size(), 1);
+    result.clear();
+    ASSERT_EQ(cache.Get(1, 10, 20, ents[0]->ByteSizeLong() * 3, &result), 20);
+    ASSERT_EQ(result.size(), 3);
+
+    cache.Remove(1);
+    ASSERT_EQ(cache.Size(), 0);
+    result.clear();
+    ASSERT_EQ(cache.Get(1, 12, 18, kNoLimit, &result), 12);
+}
+
+TEST(EntryCache, Truncate) {
+    EntryCache cache(kNoLimit);
+    std::vector<EntryPtr> ents;
+    RandomEntries(1, 20, 64, &ents);
+    cache.Append(1, ents);
+
+    // 覆盖冲突的日志
+    std::vector<EntryPtr> conflict;
+    RandomEntries(15, 17, 128, &conflict);
+    cache.Append(1, conflict);
+    std::vector<EntryPtr> result;
+    ASSERT_EQ(cache.Get(1, 1, 20, kNoLimit, &result), 17);
+    ASSERT_EQ(result.size(), 16);
+    ASSERT_TRUE(Equal(result[14], conflict[0]).ok());
+    ASSERT_TRUE(Equal(result[15], conflict[1]).ok());
+    std::vector<EntryPtr> expected(ents.begin(), ents.begin() + 14);
+    expected.insert(expected.end(), conflict.begin(), conflict.end());
+    ASSERT_EQ(cache.Size(), entriesSize(expected));
+
+    // 不连续，丢弃之前的
+    std::vector<EntryPtr> gap;
+    RandomEntries(30, 32, 64, &gap);
+    cache.Append(1, gap);
+    ASSERT_EQ(cache.Size(), entriesSize(gap));
+    result.clear();
+    ASSERT_EQ(cache.Get(1, 10, 20, kNoLimit, &result), 10);
+    ASSERT_EQ(cache.Get(1, 30, 32, kNoLimit, &result), 32);
+    ASSERT_EQ(result.size(), 2);
+}
+
+TEST(EntryCache, Evict) {
+    std::vector<EntryPtr> ents1, ents2, ents3;
+    RandomEntries(1, 11, 100, &ents1);
+    RandomEntries(1, 11, 100, &ents2);
+    RandomEntries(1, 11, 100, &ents3);
+
+    // 只能放下两个raft的日志
+    EntryCache cache(entriesSize(ents1) + entriesSize(ents2));
+    cache.Append(1, ents1);
+    cache.Append(2, ents2);
+
+    // 访问1以后，2是最久没有访问的
+    std::vector<EntryPtr> result;
+    ASSERT_EQ(cache.Get(1, 1, 11, kNoLimit, &result), 11);
+    cache.Append(3, ents3);
+    ASSERT_LE(cache.Size(), cache.Capacity());
+
+    result.clear();
+    ASSERT_EQ(cache.Get(1, 1, 11, kNoLimit, &result), 11);
+    result.clear();
+    ASSERT_EQ(cache.Get(3, 1, 11, kNoLimit, &result), 11);
+    result.clear();
+    ASSERT_EQ(cache.Get(2, 1, 11, kNoLimit, &result), 1);
+
+    // 单个raft超过容量，保留最新的
+    EntryCache small(entriesSize(ents1) / 2);
+    small.Append(1, ents1);
+    ASSERT_LE(small.Size(), small.Capacity());
+    result.clear();
+    ASSERT_EQ(small.Get(1, 10, 11, kNoLimit, &result), 11);
+    ASSERT_EQ(small.Get(1, 1, 11, kNoLimit, &result), 1);
+}
+
+TEST(EntryCache, RaftLog) {
+    EntryCache cache(kNoLimit);
+    auto storage = std::make_shared<storage::MemoryStorage>(1, 4096);
+    ASSERT_TRUE(storage->Open().ok());
+    RaftLog log(1, storage, &cache);
+
+    std::vector<EntryPtr> ents;
+    RandomEntries(1, 101, 64, &ents);
+    log.append(ents);
+
+    // 持久化以后从unstable里删除，再读从缓存拿
+    std::vector<EntryPtr> unstable;
+    log.unstableEntries(&unstable);
+    ASSERT_TRUE(storage->StoreEntries(unstable).ok());
+    log.stableTo(ents.back()->index(), ents.back()->term());
+
+    std::vector<EntryPtr> result;
+    ASSERT_TRUE(log.entries(50, kNoLimit, &result).ok());
+    ASSERT_TRUE(Equal(result, std::vector<EntryPtr>(ents.begin() + 49, ents.end())).ok());
+    ASSERT_EQ(cache.Hits(), 1);
+
+    // 缓存被淘汰以后从存储读
+    cache.Remove(1);
+    result.clear();
+    ASSERT_TRUE(log.entries(50, kNoLimit, &result).ok());
+    ASSERT_TRUE(Equal(result, std::vector<EntryPtr>(ents.begin() + 49, ents.end())).ok());
+    ASSERT_EQ(cache.Misses(), 1);
+
+    // 缓存里没有前面的日志，全部从存储读
+    std::vector<EntryPtr> more;
+    RandomEntries(101, 111, 64, &more);
+    log.append(more);
+    unstable.clear();
+    log.unstableEntries(&unstable);
+    ASSERT_TRUE(storage->StoreEntries(unstable).ok());
+    log.stableTo(more.back()->index(), more.back()->term());
+    result.clear();
+    ASSERT_TRUE(log.entries(90, kNoLimit, &result).ok());
+    ASSERT_EQ(result.size(), 21);
+    ASSERT_TRUE(Equal(result.back(), more.back()).ok());
+}
+
+TEST(EntryCache, RaftLogMaxSize) {
+    auto storage = std::make_shared<storage::MemoryStorage>(1, 4096);
+    ASSERT_TRUE(storage->Open().ok());
+    std::vector<EntryPtr> ents;
+    RandomEntries(1, 201, 64, &ents);
+    ASSERT_TRUE(storage->StoreEntries(ents).ok());
+
+    // 缓存里只有前50条，剩下的从存储读，总大小不超过max_size
+    EntryCache cache(kNoLimit);
+    cache.Append(1, std::vector<EntryPtr>(ents.begin(), ents.begin() + 50));
+    RaftLog log(1, storage, &cache);
+
+    auto max_size = entriesSize(std::vector<EntryPtr>(ents.begin(), ents.begin() + 60));
+    std::vector<EntryPtr> result;
+    ASSERT_TRUE(log.entries(1, max_size, &result).ok());
+    ASSERT_TRUE(Equal(result, std::vector<EntryPtr>(ents.begin(), ents.begin() + 60)).ok());
+
+    // 缓存已经用完额度，不再读存储
+    max_size = entriesSize(std::vector<EntryPtr>(ents.begin(), ents.begin() + 50));
+    result.clear();
+    ASSERT_TRUE(log.entries(1, max_size, &result).ok());
+    ASSERT_TRUE(Equal(result, std::vector<EntryPtr>(ents.begin(), ents.begin() + 50)).ok());
+}
+
+} /* namespace  */
@@ -1,5 +1,8 @@
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
+#include "base/byte_order.h"
 #include "base/util.h"
 #include "raft/src/impl/storage/log_file.h"
 #include "test_util.h"
@@ -172,4 +175,185 @@ TEST_F(LogFileTest, Recover) {
     }
 }
 
+TEST_F(LogFileTest, Preallocate) {
+    auto f = new LogFile(tmp_dir_, 2, 1, false, 4096);
+    auto s = f->Open(false, true);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->AllocSize(), 4096);
+
+    std::vector<EntryPtr> entries;
+    for (uint64_t i = 1; i <= 10; ++i) {
+        auto e = RandomEntry(i, 100);
+        entries.push_back(e);
+        s = f->Append(e);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    s = f->Sync();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_LT(f->FileSize(), 4096);
+
+    // 截断后文件大小不变，后面的旧数据不会被当成日志
+    s = f->Truncate(6);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->AllocSize(), 4096);
+    for (uint64_t i = 6; i <= 7; ++i) {
+        auto e = RandomEntry(i, 10);
+        entries[i - 1] = e;
+        s = f->Append(e);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    s = f->Close();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    delete f;
+
+    f = new LogFile(tmp_dir_, 2, 1, false, 4096);
+    s = f->Open(false, true);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->LastIndex(), 7);
+    ASSERT_EQ(f->AllocSize(), 4096);
+
+    // rotate之后footer在文件末尾
+    s = f->Rotate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->FileSize(), 4096);
+    delete f;
+    f = new LogFile(tmp_dir_, 2, 1, false, 4096);
+    s = f->Open(false, false);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->LastIndex(), 7);
+    for (uint64_t i = 1; i <= 7; ++i) {
+        EntryPtr e;
+        s = f->Get(i, &e);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        s = Equal(e, entries[i - 1]);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    s = f->Destroy();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    delete f;
+}
+
+TEST_F(LogFileTest, RecycledStaleRecords) {
+    // raft 1的文件回收给raft 2，文件名相同，开头的结束标记没写成功
+    auto f = new LogFile(tmp_dir_, 2, 1, false, 4096, 1);
+    auto s = f->Open(false, true);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    for (uint64_t i = 1; i <= 10; ++i) {
+        s = f->Append(RandomEntry(i, 100));
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    s = f->Close();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    delete f;
+
+    // 旧记录的index是连续的，但log number对不上
+    f = new LogFile(tmp_dir_, 2, 1, false, 4096, 2);
+    s = f->Open(false, true);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->LogSize(), 0);
+    ASSERT_EQ(f->FileSize(), 0);
+
+    std::vector<EntryPtr> entries;
+    for (uint64_t i = 1; i <= 3; ++i) {
+        auto e = RandomEntry(i, 100);
+        entries.push_back(e);
+        s = f->Append(e);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    s = f->Sync();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // 把结束标记改回旧数据，模拟崩溃时没写完
+    auto end = f->FileSize();
+    int fd = ::open(f->Path().c_str(), O_WRONLY);
+    ASSERT_GE(fd, 0);
+    auto stale = RandomEntry(4, 100);
+    std::string payload = stale->SerializeAsString();
+    Record rec;
+    rec.type = static_cast<RecordType>(kLogEntry | kRecyclableRecordFlag);
+    rec.size = static_cast<uint32_t>(payload.size());
+    rec.log_number = makeLogNumber(1, 2, 1);
+    rec.crc = rec.Checksum(payload.data());
+    rec.Encode();
+    ASSERT_EQ(::pwrite(fd, &rec, sizeof(rec), end), static_cast<ssize_t>(sizeof(rec)));
+    ASSERT_EQ(::pwrite(fd, payload.data(), payload.size(), end + sizeof(rec)),
+              static_cast<ssize_t>(payload.size()));
+    ::close(fd);
+    s = f->Close();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    delete f;
+
+    f = new LogFile(tmp_dir_, 2, 1, false, 4096, 2);
+    s = f->Open(false, true);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(f->LastIndex(), 3);
+    ASSERT_EQ(f->FileSize(), end);
+    for (uint64_t i = 1; i <= 3; ++i) {
+        EntryPtr e;
+        s = f->Get(i, &e);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        s = Equal(e, entries[i - 1]);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    s = f->Destroy();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    delete f;
+}
+
+TEST_F(LogFileTest, Checksum) {
+    for (uint64_t i = 1; i <= 10; ++i) {
+        auto s = log_file_->Append(RandomEntry(i, 100));
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+    auto s = log_file_->Rotate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // 改掉第一条日志payload里的一个字节
+    int fd = ::open(log_file_->Path().c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    char c = 0;
+    ASSERT_EQ(::pread(fd, &c, 1, sizeof(Record) + 10), 1);
+    c = ~c;
+    ASSERT_EQ(::pwrite(fd, &c, 1, sizeof(Record) + 10), 1);
+    ::close(fd);
+
+    ReOpen(false);
+    EntryPtr e;
+    s = log_file_->Get(1, &e);
+    ASSERT_EQ(s.code(), Status::kCorruption) << s.ToString();
+    s = log_file_->Get(2, &e);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST_F(LogFileTest, LegacyRecord) {
+    // 老格式的记录: 9字节的记录头，没有log number和crc
+    auto e = RandomEntry(1, 100);
+    std::string payload = e->SerializeAsString();
+    char header[kLegacyRecordHeaderSize] = {0};
+    header[0] = kLogEntry;
+    uint32_t size = htobe32(static_cast<uint32_t>(payload.size()));
+    memcpy(header + 1, &size, sizeof(size));
+    int fd = ::open(log_file_->Path().c_str(), O_WRONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::pwrite(fd, header, sizeof(header), 0), static_cast<ssize_t>(sizeof(header)));
+    ASSERT_EQ(::pwrite(fd, payload.data(), payload.size(), sizeof(header)),
+              static_cast<ssize_t>(payload.size()));
+    ::close(fd);
+
+    ReOpen(true);
+    ASSERT_EQ(log_file_->LastIndex(), 1);
+    auto e2 = RandomEntry(2, 100);
+    auto s = log_file_->Append(e2);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ReOpen(true);
+    ASSERT_EQ(log_file_->LastIndex(), 2);
+    EntryPtr got;
+    s = log_file_->Get(1, &got);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_TRUE(Equal(got, e).ok());
+    s = log_file_->Get(2, &got);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_TRUE(Equal(got, e2).ok());
+}
+
 }  // namespace
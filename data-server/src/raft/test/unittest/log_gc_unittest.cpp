@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "raft/src/impl/log_gc.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore::raft;
+using namespace sharkstore::raft::impl;
+using sharkstore::raft::impl::storage::LogFileUsage;
+
+// count个文件，每个100条日志100字节，第一个文件的最后一条是first_last
+std::vector<LogFileUsage> makeFiles(size_t count, uint64_t first_last = 100) {
+    std::vector<LogFileUsage> files;
+    for (size_t i = 0; i < count; ++i) {
+        LogFileUsage u;
+        u.last_index = first_last + i * 100;
+        u.bytes = 100;
+        files.push_back(u);
+    }
+    return files;
+}
+
+TEST(LogGC, FileCount) {
+    LogGC gc(5, nullptr);
+    auto files = makeFiles(8);
+
+    // 没有落后副本，截断到剩5个文件
+    ASSERT_EQ(gc.Decide(files, 800, 0, 0), 300U);
+    ASSERT_EQ(gc.Status().reason, "file_count");
+    ASSERT_EQ(gc.Status().files, 8U);
+    ASSERT_EQ(gc.Status().bytes, 800U);
+
+    // 已应用的限制
+    ASSERT_EQ(gc.Decide(files, 200, 0, 0), 100U);
+
+    // 为活跃的落后副本保留
+    ASSERT_EQ(gc.Decide(files, 800, 150, 2), 100U);
+    ASSERT_EQ(gc.Status().hold_index, 150U);
+    ASSERT_EQ(gc.Status().hold_node, 2U);
+    ASSERT_EQ(gc.Decide(files, 800, 50, 2), 0U);
+    ASSERT_EQ(gc.Status().forced_truncations, 0U);
+
+    // 最多保留到两倍个数
+    files = makeFiles(12);
+    ASSERT_EQ(gc.Decide(files, 1200, 50, 2), 200U);
+    ASSERT_EQ(gc.Status().forced_truncations, 1U);
+    ASSERT_EQ(gc.Status().truncations, 4U);
+}
+
+TEST(LogGC, Budget) {
+    LogDiskBudget budget(750);
+    {
+        LogGC gc1(0, &budget);
+        auto files1 = makeFiles(8);
+
+        // 只截断没有副本需要的日志就够了
+        ASSERT_EQ(gc1.Decide(files1, 800, 150, 2), 100U);
+        ASSERT_EQ(gc1.Status().pressure, "reclaim");
+        ASSERT_EQ(gc1.Status().reason, "budget");
+        ASSERT_EQ(budget.Bytes(), 800U);
+        ASSERT_EQ(budget.FreeBytes(), 100U);
+
+        files1.erase(files1.begin());
+        gc1.Update(files1);
+        ASSERT_EQ(budget.Bytes(), 700U);
+        ASSERT_EQ(budget.FreeBytes(), 0U);
+        ASSERT_EQ(budget.Current(), LogDiskBudget::Pressure::kNone);
+        ASSERT_EQ(gc1.Decide(files1, 800, 150, 2), 0U);
+
+        // 另一个raft的日志让节点超过上限，没有副本需要的不够释放
+        LogGC gc2(0, &budget);
+        auto files2 = makeFiles(4);
+        ASSERT_EQ(gc2.Decide(files2, 400, 0, 0), 300U);
+        ASSERT_EQ(gc2.Status().pressure, "force");
+        ASSERT_EQ(gc2.Status().forced_truncations, 0U);
+
+        // 落后副本需要的日志也截断
+        ASSERT_EQ(gc1.Decide(files1, 800, 150, 2), 700U);
+        ASSERT_EQ(gc1.Status().forced_truncations, 1U);
+    }
+    ASSERT_EQ(budget.Bytes(), 0U);
+    ASSERT_EQ(budget.FreeBytes(), 0U);
+}
+
+TEST(LogGC, Unlimited) {
+    LogDiskBudget budget(0);
+    LogGC gc(5, &budget);
+    auto files = makeFiles(3);
+    ASSERT_EQ(gc.Decide(files, 300, 0, 0), 0U);
+    ASSERT_EQ(gc.Status().pressure, "none");
+    ASSERT_EQ(budget.Bytes(), 300U);
+    ASSERT_EQ(budget.FreeBytes(), 200U);
+}
+
+}  // namespace
@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "raft/src/impl/rebalancer.h"
+#include "raft/src/impl/server_impl.h"
+#include "raft/src/impl/work_thread.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore;
+using namespace sharkstore::raft;
+using namespace sharkstore::raft::impl;
+
+class Latch {
+public:
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mu_);
+        cond_.wait(lock, [this] { return done_; });
+    }
+    void Done() {
+        std::lock_guard<std::mutex> lock(mu_);
+        done_ = true;
+        cond_.notify_all();
+    }
+
+private:
+    std::mutex mu_;
+    std::condition_variable cond_;
+    bool done_ = false;
+};
+
+struct Recorder {
+    std::mutex mu;
+    std::condition_variable cond;
+    std::vector<std::pair<int, std::thread::id>> seqs;
+
+    void Add(int seq) {
+        std::lock_guard<std::mutex> lock(mu);
+        seqs.emplace_back(seq, std::this_thread::get_id());
+        cond.notify_all();
+    }
+    bool WaitCount(size_t n) {
+        std::unique_lock<std::mutex> lock(mu);
+        return cond.wait_for(lock, std::chrono::seconds(5), [&] { return seqs.size() >= n; });
+    }
+};
+
+static std::thread::id threadId(WorkThread* t) {
+    std::mutex mu;
+    std::condition_variable cond;
+    std::thread::id id;
+    bool done = false;
+    std::atomic<bool> stopped = {false};
+    Work w;
+    w.owner = 100;
+    w.stopped = &stopped;
+    w.f0 = [&] {
+        std::lock_guard<std::mutex> lock(mu);
+        id = std::this_thread::get_id();
+        done = true;
+        cond.notify_all();
+    };
+    t->post(w);
+    std::unique_lock<std::mutex> lock(mu);
+    cond.wait(lock, [&] { return done; });
+    return id;
+}
+
+static Work makeWork(uint64_t owner, std::atomic<bool>* stopped, std::function<void()> f) {
+    Work w;
+    w.owner = owner;
+    w.stopped = stopped;
+    w.f0 = std::move(f);
+    return w;
+}
+
+TEST(WorkRoute, MigrateKeepsOrder) {
+    RaftServerOptions ops;
+    RaftServerImpl server(ops);
+    WorkThread from(&server, 10000), to(&server, 10000);
+    auto from_id = threadId(&from), to_id = threadId(&to);
+
+    std::atomic<bool> stopped = {false};
+    auto route = std::make_shared<WorkRoute>(1, &stopped, &from);
+
+    // 源线程被其他raft的任务卡住，迁移任务前后都有积压
+    Latch blocker;
+    from.post(makeWork(2, &stopped, [&] { blocker.Wait(); }));
+
+    Recorder rec;
+    const int kCount = 1000;
+    for (int i = 0; i < kCount; ++i) {
+        if (i == kCount / 2) {
+            ASSERT_TRUE(route->migrate(&to));
+            ASSERT_TRUE(route->migrating());
+            ASSERT_FALSE(route->migrate(&to));
+        }
+        route->post(makeWork(1, &stopped, [&rec, i] { rec.Add(i); }));
+    }
+    // 迁移生效之前还是投递到源线程
+    ASSERT_EQ(route->thread(), &from);
+    blocker.Done();
+
+    ASSERT_TRUE(rec.WaitCount(kCount));
+    ASSERT_EQ(route->thread(), &to);
+    ASSERT_FALSE(route->migrating());
+    for (int i = 0; i < kCount; ++i) {
+        ASSERT_EQ(rec.seqs[i].first, i);
+        ASSERT_EQ(rec.seqs[i].second, i < kCount / 2 ? from_id : to_id) << i;
+    }
+
+    // 迁移之后直接投递到目标线程
+    route->post(makeWork(1, &stopped, [&rec] { rec.Add(kCount); }));
+    ASSERT_TRUE(rec.WaitCount(kCount + 1));
+    ASSERT_EQ(rec.seqs.back().second, to_id);
+    ASSERT_EQ(from.size(), 0);
+}
+
+TEST(WorkRoute, MigrateWithSubmitAndWaitPost) {
+    RaftServerOptions ops;
+    RaftServerImpl server(ops);
+    WorkThread from(&server, 8), to(&server, 8);
+
+    std::atomic<bool> stopped = {false};
+    auto route = std::make_shared<WorkRoute>(1, &stopped, &from);
+
+    Latch blocker;
+    from.post(makeWork(2, &stopped, [&] { blocker.Wait(); }));
+
+    std::mutex mu;
+    std::vector<std::string> cmds;
+    auto step = [&](MessagePtr& msg) {
+        std::lock_guard<std::mutex> lock(mu);
+        for (const auto& e : msg->entries()) {
+            cmds.push_back(e.data());
+        }
+    };
+    for (int i = 0; i < 5; ++i) {
+        std::string cmd = std::to_string(i);
+        ASSERT_TRUE(route->submit(step, cmd));
+    }
+    ASSERT_TRUE(route->migrate(&to));
+    // 迁移任务执行之前提交的还在源线程上合并
+    for (int i = 5; i < 10; ++i) {
+        std::string cmd = std::to_string(i);
+        ASSERT_TRUE(route->submit(step, cmd));
+    }
+
+    // 队列满了，waitPost等待源线程腾出空间
+    std::atomic<int> posted = {0};
+    std::thread producer([&] {
+        for (int i = 10; i < 20; ++i) {
+            route->waitPost(makeWork(1, &stopped, [&mu, &cmds, i] {
+                std::lock_guard<std::mutex> lock(mu);
+                cmds.push_back(std::to_string(i));
+            }));
+            ++posted;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_LT(posted.load(), 10);
+    blocker.Done();
+    producer.join();
+
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (cmds.size() == 20) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::lock_guard<std::mutex> lock(mu);
+    ASSERT_EQ(cmds.size(), 20U);
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(cmds[i], std::to_string(i));
+    }
+    ASSERT_EQ(route->thread(), &to);
+}
+
+static ThreadLoad makeLoad(std::vector<std::pair<uint64_t, uint64_t>> owners,
+                           uint64_t rejects = 0) {
+    ThreadLoad load;
+    for (const auto& kv : owners) {
+        load.owners[kv.first] = kv.second;
+        load.busy_ns += kv.second;
+    }
+    load.rejects = rejects;
+    return load;
+}
+
+TEST(Rebalance, Plan) {
+    auto any = [](uint64_t, size_t) { return true; };
+    RebalanceDecision d;
+
+    // 线程0: 90%(三个raft)，线程1: 10%，差距80%，最多迁40%
+    std::vector<ThreadLoad> loads = {makeLoad({{1, 50}, {2, 30}, {3, 10}}),
+                                     makeLoad({{4, 10}})};
+    ASSERT_TRUE(PlanRebalance(loads, 100, 70, 30, any, &d));
+    ASSERT_EQ(d.owner, 2U);
+    ASSERT_EQ(d.from, 0U);
+    ASSERT_EQ(d.to, 1U);
+    ASSERT_EQ(d.from_percent, 90U);
+    ASSERT_EQ(d.to_percent, 10U);
+    ASSERT_EQ(d.owner_percent, 30U);
+
+    // 不能迁移的跳过
+    ASSERT_TRUE(PlanRebalance(loads, 100, 70, 30,
+                              [](uint64_t owner, size_t) { return owner != 2; }, &d));
+    ASSERT_EQ(d.owner, 3U);
+
+    // 不够忙或者差距不够大
+    ASSERT_FALSE(PlanRebalance(loads, 100, 95, 30, any, &d));
+    ASSERT_FALSE(PlanRebalance(loads, 100, 70, 85, any, &d));
+
+    // 只有一个raft在干活
+    loads = {makeLoad({{1, 90}, {2, 0}}), makeLoad({})};
+    ASSERT_FALSE(PlanRebalance(loads, 100, 70, 30, any, &d));
+
+    // 都太大，迁过去目标线程会变成最忙的
+    loads = {makeLoad({{1, 45}, {2, 45}}), makeLoad({{3, 30}})};
+    ASSERT_FALSE(PlanRebalance(loads, 100, 70, 30, any, &d));
+
+    // 队列满过的算100%
+    loads = {makeLoad({{1, 20}, {2, 10}}, 5), makeLoad({{3, 20}}), makeLoad({{4, 5}})};
+    ASSERT_TRUE(PlanRebalance(loads, 100, 70, 30, any, &d));
+    ASSERT_EQ(d.from, 0U);
+    ASSERT_EQ(d.to, 2U);
+    ASSERT_EQ(d.owner, 1U);
+}
+
+TEST(Rebalance, Run) {
+    RaftServerOptions ops;
+    RaftServerImpl server(ops);
+    WorkThread t0(&server, 1000), t1(&server, 1000);
+    std::vector<WorkThread*> threads = {&t0, &t1};
+    Rebalancer rebalancer("consensus", threads, true, 50, 30);
+
+    std::atomic<bool> stopped = {false};
+    std::map<uint64_t, std::shared_ptr<WorkRoute>> routes;
+    for (uint64_t id = 1; id <= 3; ++id) {
+        routes[id] = std::make_shared<WorkRoute>(id, &stopped, &t0);
+    }
+    auto route_of = [&routes](uint64_t id) -> std::shared_ptr<WorkRoute> {
+        auto it = routes.find(id);
+        return it == routes.end() ? nullptr : it->second;
+    };
+
+    // raft 1和2都在线程0上忙，线程1空闲
+    auto sleep_ms = [](int ms) {
+        return [ms] { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); };
+    };
+    Latch done;
+    routes[1]->post(makeWork(1, &stopped, sleep_ms(60)));
+    routes[2]->post(makeWork(2, &stopped, sleep_ms(25)));
+    routes[3]->post(makeWork(3, &stopped, [&] { done.Done(); }));
+    done.Wait();
+
+    rebalancer.Run(route_of);
+    // 把线程0上的任务都执行完，迁移才生效
+    threadId(&t0);
+
+    std::vector<uint64_t> percents;
+    std::vector<std::string> decisions;
+    uint64_t migrations = 0;
+    rebalancer.GetStatus(&percents, &migrations, &decisions);
+    ASSERT_EQ(percents.size(), 2U);
+    ASSERT_GE(percents[0], 50U);
+    ASSERT_EQ(percents[1], 0U);
+    ASSERT_EQ(migrations, 1U);
+    ASSERT_EQ(decisions.size(), 1U);
+    ASSERT_EQ(routes[2]->thread(), &t1);
+    ASSERT_EQ(routes[1]->thread(), &t0);
+
+    // 冷却期内不再迁移同一个raft
+    routes[2]->post(makeWork(2, &stopped, sleep_ms(60)));
+    routes[3]->post(makeWork(3, &stopped, sleep_ms(20)));
+    threadId(&t1);
+    rebalancer.Run(route_of);
+    threadId(&t1);
+    ASSERT_EQ(routes[2]->thread(), &t1);
+}
+
+} /* namespace  */
@@ -122,4 +122,162 @@ TEST(Replica, Inflight) {
     ASSERT_TRUE(inflight.full());
 }
 
+TEST(Replica, InflightBytes) {
+    Inflight inflight(10);
+    inflight.add(10, 100, 1000);
+    inflight.add(20, 200, 2000);
+    inflight.add(30, 300, 3000);
+    ASSERT_EQ(inflight.count(), 3);
+    ASSERT_EQ(inflight.bytes(), 600U);
+
+    InflightItem last;
+    ASSERT_EQ(inflight.freeTo(25, &last), 300U);
+    ASSERT_EQ(last.index, 20U);
+    ASSERT_EQ(last.sent_us, 2000);
+    ASSERT_EQ(last.delivered, 0U);
+    ASSERT_EQ(inflight.bytes(), 300U);
+    ASSERT_EQ(inflight.delivered(), 300U);
+
+    // 发送时记录已确认的字节数
+    inflight.add(40, 400, 4000);
+    ASSERT_EQ(inflight.freeTo(40, &last), 700U);
+    ASSERT_EQ(last.delivered, 300U);
+    ASSERT_EQ(inflight.delivered(), 1000U);
+    ASSERT_EQ(inflight.freeFirstOne(), 0U);
+
+    inflight.add(50, 500, 5000);
+    ASSERT_EQ(inflight.reset(), 500U);
+    ASSERT_EQ(inflight.bytes(), 0U);
+}
+
+TEST(Replica, FlowWindow) {
+    const uint64_t kMB = 1024 * 1024;
+    FlowWindow w(kMB, 16 * kMB, true);
+    ASSERT_EQ(w.size(), 4 * kMB);
+
+    // 1ms的rtt确认4MB，带宽4GB/s，带宽时延积4MB，窗口8MB
+    w.onAck(1000, 4 * kMB, 1000);
+    ASSERT_EQ(w.srtt_us(), 1000);
+    ASSERT_EQ(w.min_rtt_us(), 1000);
+    ASSERT_EQ(w.bandwidth(), 4 * kMB * 1000);
+    ASSERT_EQ(w.size(), 8 * kMB);
+    // 继续增长到上限
+    w.onAck(1000, 8 * kMB, 2000);
+    ASSERT_EQ(w.size(), 16 * kMB);
+
+    // 排队导致rtt变大，投递速率下降时带宽慢慢跟随，窗口按最小rtt计算
+    w.onAck(4000, 16 * kMB, 3000);
+    ASSERT_EQ(w.min_rtt_us(), 1000);
+    ASSERT_EQ(w.bandwidth(), (8 * kMB - kMB / 2) * 1000);
+    ASSERT_EQ(w.size(), 15 * kMB);
+
+    // 丢失减半，不小于下限
+    for (int i = 0; i < 10; ++i) w.onLoss();
+    ASSERT_EQ(w.size(), kMB);
+
+    // 不自适应时固定为上限
+    FlowWindow fixed(kMB, 16 * kMB, false);
+    ASSERT_EQ(fixed.size(), 16 * kMB);
+    fixed.onAck(1000, kMB, 1000);
+    fixed.onLoss();
+    ASSERT_EQ(fixed.size(), 16 * kMB);
+
+    // 不按字节限制
+    FlowWindow none(kMB, 0, true);
+    ASSERT_EQ(none.size(), 0U);
+}
+
+TEST(Replica, ByteWindow) {
+    InflightBudget budget(1000);
+    auto p = testutil::RandomPeer();
+    Replica r(p, 100, FlowWindow(300, 600, false), budget.Get(p.node_id));
+    r.becomeReplicate();
+    ASSERT_FALSE(r.isPaused());
+
+    r.sentEntries(10, 400);
+    ASSERT_FALSE(r.isPaused());
+    r.sentEntries(20, 400);
+    ASSERT_TRUE(r.inflightFull());
+    ASSERT_TRUE(r.isPaused());
+    ASSERT_EQ(budget.Get(p.node_id)->bytes.load(), 800U);
+
+    r.ackEntries(10);
+    ASSERT_FALSE(r.isPaused());
+    ASSERT_EQ(r.inflight().bytes(), 400U);
+
+    // 发往同一节点的其他副本占满了节点上限
+    auto other = testutil::RandomPeer();
+    other.node_id = p.node_id;
+    {
+        Replica r2(other, 100, FlowWindow(300, 2000, false), budget.Get(p.node_id));
+        r2.becomeReplicate();
+        r2.sentEntries(5, 600);
+        ASSERT_FALSE(r2.inflightFull());
+        ASSERT_TRUE(r2.isPaused());
+        ASSERT_TRUE(r.isPaused());
+        // 自己没有在途的复制时不受节点上限限制
+        Replica r3(other, 100, FlowWindow(300, 600, false), budget.Get(p.node_id));
+        r3.becomeReplicate();
+        ASSERT_FALSE(r3.isPaused());
+        r.ackEntries(20);
+        ASSERT_FALSE(r.isPaused());
+    }
+    // 副本销毁时释放
+    ASSERT_EQ(budget.Get(p.node_id)->bytes.load(), 0U);
+
+    r.sentEntries(30, 700, 1000);
+    ASSERT_TRUE(r.inflightFull());
+    // 超时之后才当作丢失
+    ASSERT_FALSE(r.checkInflightLoss(1000 + Replica::kMinInflightRtoUs - 1));
+    ASSERT_TRUE(r.inflightFull());
+    ASSERT_TRUE(r.checkInflightLoss(1000 + Replica::kMinInflightRtoUs));
+    ASSERT_FALSE(r.inflightFull());
+    r.sentEntries(40, 100);
+    r.becomeProbe();
+    ASSERT_EQ(budget.Get(p.node_id)->bytes.load(), 0U);
+
+    std::map<uint64_t, uint64_t> usage;
+    budget.Collect(&usage);
+    ASSERT_EQ(usage.size(), 1U);
+    ASSERT_EQ(usage[p.node_id], 0U);
+}
+
+TEST(Replica, SaturatedWindow) {
+    const uint64_t kMsg = 1000;
+    auto p = testutil::RandomPeer();
+    Replica r(p, 1000, FlowWindow(kMsg, 1000 * kMsg, true), nullptr);
+    r.becomeReplicate();
+
+    // 一直有确认的跟随者：每轮发满窗口，rtt为10ms，心跳回应时窗口仍然是满的
+    int64_t now = 1000;
+    uint64_t index = 0, acked = 0;
+    uint64_t last_window = r.window().size();
+    for (int round = 0; round < 100; ++round) {
+        while (!r.inflightFull()) {
+            r.sentEntries(++index, kMsg, now);
+        }
+        now += 10 * 1000;
+        // 一个rtt之后确认上一轮发送的全部
+        acked = index;
+        r.ackEntries(acked, now);
+        while (!r.inflightFull()) {
+            r.sentEntries(++index, kMsg, now);
+        }
+        ASSERT_FALSE(r.checkInflightLoss(now));
+        ASSERT_GE(r.window().size(), last_window);
+        last_window = r.window().size();
+    }
+    // 带宽时延积一直在增长，窗口涨到上限
+    ASSERT_EQ(last_window, 1000 * kMsg);
+
+    // 不再确认，超时后当作丢失，窗口减半
+    auto count = r.inflight().count();
+    now += Replica::kMinInflightRtoUs;
+    ASSERT_TRUE(r.checkInflightLoss(now));
+    ASSERT_EQ(r.inflight().count(), count - 1);
+    ASSERT_EQ(r.window().size(), last_window / 2);
+    // 下一个超时之前不再释放
+    ASSERT_FALSE(r.checkInflightLoss(now + 1));
+}
+
 }  // namespace
@@ -16,13 +16,14 @@ namespace raft { class RaftServer; }
 namespace dataserver {
 
 namespace master { class Worker; }
-namespace storage { class MetaStore; }
+namespace storage { class MetaStore; class LegacyRanges; }
 namespace common { class SocketSession; }
 namespace watch { class WatchServer; }
 
 namespace range {
 
 class Range;
+class LockExpirer;
 
 class RangeContext {
 public:
@@ -41,6 +42,10 @@ public:
     virtual common::SocketSession* SocketSession() = 0;
     virtual RangeStats* Statistics() = 0;
     virtual watch::WatchServer* WatchServer() = 0;
+    // 锁过期定时器，返回nullptr时不启用内存锁表
+    virtual LockExpirer* GetLockExpirer() = 0;
+    // 升级之前就有的老格式range，返回nullptr时都按新格式
+    virtual storage::LegacyRanges* GetLegacyRanges() = 0;
 
     // filesystem usage percent for check writable
     virtual uint64_t GetFSUsagePercent() const = 0;
@@ -66,7 +66,7 @@ Status Range::ApplyInsert(const raft_cmdpb::Command &cmd) {
             break;
         }
 
-        ret = store_->Insert(req, &affected_keys);
+        ret = store_->Insert(req, &affected_keys, cmd.expire_at());
         auto etime = get_micro_second();
         context_->Statistics()->PushTime(HistogramType::kStore, etime - btime);
 
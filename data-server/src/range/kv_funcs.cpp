@@ -44,7 +44,8 @@ void Range::KVSet(common::ProtoMessage *msg, kvrpcpb::DsKvSetRequest &req) {
 
         auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::KvSet);
-            cmd.set_allocated_kv_set_req(req.release_req());
+            // req和cmd在同一个arena上，直接转移指针
+            cmd.unsafe_arena_set_allocated_kv_set_req(req.unsafe_arena_release_req());
         });
 
         if (!ret.ok()) {
@@ -84,7 +85,8 @@ Status Range::ApplyKVSet(const raft_cmdpb::Command &cmd) {
                 affected_keys = 1;
             }
         }
-        ret = store_->Put(req.kv().key(), req.kv().value());
+        auto expire_at = req.kv().expire_at() > 0 ? req.kv().expire_at() : cmd.expire_at();
+        ret = store_->Put(req.kv().key(), req.kv().value(), expire_at);
         context_->Statistics()->PushTime(HistogramType::kStore, get_micro_second() - btime);
 
         if (cmd.cmd_id().node_id() == node_id_) {
@@ -163,7 +165,7 @@ void Range::KVBatchSet(common::ProtoMessage *msg,
         }
         ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::KvBatchSet);
-            cmd.set_allocated_kv_batch_set_req(req.release_req());
+            cmd.unsafe_arena_set_allocated_kv_batch_set_req(req.unsafe_arena_release_req());
         });
 
         if (!ret.ok()) {
@@ -198,12 +200,25 @@ Status Range::ApplyKVBatchSet(const raft_cmdpb::Command &cmd) {
             break;
         }
 
+        // 条件写入一次批量查询所有key是否存在
+        std::vector<Status> exists;
+        if (existCase != kvrpcpb::EC_Force) {
+            std::vector<std::string> keys;
+            keys.reserve(req.kvs_size());
+            for (int i = 0, count = req.kvs_size(); i < count; ++i) {
+                keys.push_back(req.kvs(i).key());
+            }
+            std::vector<std::string> values;
+            store_->MultiGet(keys, &values, &exists);
+        }
+
         std::vector<std::pair<std::string, std::string>> keyValues;
+        std::vector<int64_t> expire_ats;
         for (int i = 0, count = req.kvs_size(); i < count; ++i) {
-            auto kv = req.kvs(i);
+            auto &kv = req.kvs(i);
             do {
-                if (req.case_() != kvrpcpb::EC_Force) {
-                    bool bExists = store_->KeyExists(kv.key());
+                if (existCase != kvrpcpb::EC_Force) {
+                    bool bExists = exists[i].ok();
                     if ((existCase == kvrpcpb::EC_Exists && !bExists) ||
                         (existCase == kvrpcpb::EC_NotExists && bExists)) {
                         break;
@@ -216,10 +231,11 @@ Status Range::ApplyKVBatchSet(const raft_cmdpb::Command &cmd) {
                 ++total_count;
 
                 keyValues.push_back(std::pair<std::string, std::string>(kv.key(), kv.value()));
+                expire_ats.push_back(kv.expire_at() > 0 ? kv.expire_at() : cmd.expire_at());
             } while (false);
         }
 
-        ret = store_->BatchSet(keyValues);
+        ret = store_->BatchSet(keyValues, expire_ats);
         context_->Statistics()->PushTime(HistogramType::kStore,
                                        get_micro_second() - btime);
 
@@ -260,21 +276,31 @@ void Range::KVBatchGet(common::ProtoMessage *msg,
     uint64_t total_size = 0;
     auto keys_size = req.req().keys_size();
 
+    std::vector<std::string> keys;
+    keys.reserve(keys_size);
     for (int i = 0; i < keys_size; ++i) {
         auto &key = req.req().keys(i);
         if (key.empty() || !KeyInRange(key)) {
             RANGE_LOG_WARN("KVBatchGet error: %s not in range", key.c_str());
         } else {
-            auto kv = ds_resp->mutable_resp()->add_kvs();
-            auto btime = get_micro_second();
-            auto ret = store_->Get(key, kv->mutable_value());
-            kv->set_key(std::move(key));
-            count++;
-            total_size += kv->key().size() + kv->value().size();
-            total_time += get_micro_second() - btime;
+            keys.push_back(key);
         }
     }
 
+    auto btime = get_micro_second();
+    std::vector<std::string> values;
+    std::vector<Status> statuses;
+    store_->MultiGet(keys, &values, &statuses);
+    total_time += get_micro_second() - btime;
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto kv = ds_resp->mutable_resp()->add_kvs();
+        kv->set_key(std::move(keys[i]));
+        kv->set_value(std::move(values[i]));
+        count++;
+        total_size += kv->key().size() + kv->value().size();
+    }
+
     context_->Statistics()->PushTime(HistogramType::kStore, total_time);
 
     common::SetResponseHeader(req.header(), header, err);
@@ -304,7 +330,7 @@ void Range::KVDelete(common::ProtoMessage *msg,
 
         auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::KvDelete);
-            cmd.set_allocated_kv_delete_req(req.release_req());
+            cmd.unsafe_arena_set_allocated_kv_delete_req(req.unsafe_arena_release_req());
         });
         if (!ret.ok()) {
             RANGE_LOG_ERROR("KVDelete raft submit error: %s", ret.ToString().c_str());
@@ -392,7 +418,7 @@ void Range::KVBatchDelete(common::ProtoMessage *msg,
 
     auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
         cmd.set_cmd_type(raft_cmdpb::CmdType::KvBatchDel);
-        cmd.set_allocated_kv_batch_del_req(req.release_req());
+        cmd.unsafe_arena_set_allocated_kv_batch_del_req(req.unsafe_arena_release_req());
     });
 
     if (!ret.ok()) {
@@ -412,7 +438,8 @@ Status Range::ApplyKVBatchDelete(const raft_cmdpb::Command &cmd) {
 
     do {
         auto &req = cmd.kv_batch_del_req();
-        std::vector<std::string> delKeys(req.keys_size());
+        std::vector<std::string> delKeys;
+        delKeys.reserve(req.keys_size());
 
         auto &epoch = cmd.verify_epoch();
         if (!EpochIsEqual(epoch, err)) {
@@ -420,17 +447,20 @@ Status Range::ApplyKVBatchDelete(const raft_cmdpb::Command &cmd) {
             break;
         }
 
-        for (int i = 0, count = req.keys_size(); i < count; ++i) {
-            auto &key = req.keys(i);
-            if (req.case_() == kvrpcpb::EC_Exists ||
-                req.case_() == kvrpcpb::EC_AnyCase) {
-                if (store_->KeyExists(key)) {
+        if (req.case_() == kvrpcpb::EC_Exists ||
+            req.case_() == kvrpcpb::EC_AnyCase) {
+            std::vector<std::string> keys(req.keys().begin(), req.keys().end());
+            std::vector<std::string> values;
+            std::vector<Status> exists;
+            store_->MultiGet(keys, &values, &exists);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (exists[i].ok()) {
                     ++affected_keys;
-                    delKeys.push_back(std::move(key));
+                    delKeys.push_back(std::move(keys[i]));
                 }
-            } else {
-                delKeys.push_back(std::move(key));
             }
+        } else {
+            delKeys.assign(req.keys().begin(), req.keys().end());
         }
 
         ret = store_->BatchDelete(delKeys);
@@ -486,7 +516,7 @@ void Range::KVRangeDelete(common::ProtoMessage *msg,
 
     auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
         cmd.set_cmd_type(raft_cmdpb::CmdType::KvRangeDel);
-        cmd.set_allocated_kv_range_del_req(req.release_req());
+        cmd.unsafe_arena_set_allocated_kv_range_del_req(req.unsafe_arena_release_req());
     });
 
     if (!ret.ok()) {
@@ -3,6 +3,8 @@
 #include "base/util.h"
 #include "server/range_server.h"
 
+#include "lock.h"
+#include "lock_expirer.h"
 #include "range_logger.h"
 
 namespace sharkstore {
@@ -63,23 +65,49 @@ bool DecodeValue(int64_t* version, kvrpcpb::LockValue* lock_value, std::string*
 
 using namespace sharkstore::monitor;
 
-kvrpcpb::LockValue *Range::LockGet(const std::string &key) {
-    RANGE_LOG_DEBUG("lock get: key[%s]", EncodeToHexString(key).c_str());
+bool Range::LockLoad(const std::string &key, kvrpcpb::LockValue *value) {
+    bool found = false;
+    if (lock_table_.Get(key, value, &found)) {
+        return found;
+    }
+
     std::string val;
     if (!store_->Get(key, &val).ok()) {
         FLOG_WARN("lock get: no key[%s]", EncodeToHexString(key).c_str());
-        return nullptr;
+        return false;
     }
 
     RANGE_LOG_DEBUG("lock get ok: key[%s] val[%s]", EncodeToHexString(key).c_str(),
                EncodeToHexString(val).c_str());
 
-    auto ret = new kvrpcpb::LockValue;
     int64_t version = 0; // not used
     std::string extend(""); // not used
-    if (!lock::DecodeValue(&version, ret, &extend,
-                           val)) {
+    if (!lock::DecodeValue(&version, value, &extend, val)) {
         RANGE_LOG_WARN("lock get: decode value failed, key[%s]", EncodeToHexString(key).c_str());
+        return false;
+    }
+    return true;
+}
+
+void Range::TryLoadLockTable() {
+    if (is_leader_ && lock_table_.TryStartLoad()) {
+        context_->GetLockExpirer()->ScheduleLoad(id_);
+    }
+}
+
+void Range::LoadLockTable() {
+    if (!valid_ || !is_leader_) {
+        lock_table_.Reset();
+        return;
+    }
+    lock_table_.Load(store_.get(), start_key_, meta_.GetEndKey());
+}
+
+kvrpcpb::LockValue *Range::LockGet(const std::string &key) {
+    RANGE_LOG_DEBUG("lock get: key[%s]", EncodeToHexString(key).c_str());
+
+    std::unique_ptr<kvrpcpb::LockValue> ret(new kvrpcpb::LockValue);
+    if (!LockLoad(key, ret.get())) {
         return nullptr;
     }
 
@@ -97,7 +125,7 @@ kvrpcpb::LockValue *Range::LockGet(const std::string &key) {
 
     RANGE_LOG_DEBUG("lock get parse: key[%s] val[%s]",
                EncodeToHexString(key).c_str(), ret->DebugString().c_str());
-    return ret;
+    return ret.release();
 }
 
 void Range::Lock(common::ProtoMessage *msg, kvrpcpb::DsLockRequest &req) {
@@ -129,6 +157,15 @@ void Range::Lock(common::ProtoMessage *msg, kvrpcpb::DsLockRequest &req) {
             break;
         }
 
+        TryLoadLockTable();
+        // 删除时间在leader上算好，各副本apply时一致
+        // 客户端带来的expire_at不可信，apply时大于0就会直接使用
+        if (req.req().value().delete_time() != 0) {
+            req.mutable_req()->set_expire_at(getticks() + req.req().value().delete_time());
+        } else {
+            req.mutable_req()->clear_expire_at();
+        }
+
         auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::Lock);
             cmd.set_allocated_lock_req(req.release_req());
@@ -182,7 +219,9 @@ Status Range::ApplyLock(const raft_cmdpb::Command &cmd) {
 
         auto btime = get_micro_second();
         req.mutable_value()->set_update_time(getticks());
-        if (req.value().delete_time() != 0) {
+        if (req.expire_at() > 0) {
+            req.mutable_value()->set_delete_time(req.expire_at());
+        } else if (req.value().delete_time() != 0) {
             req.mutable_value()->set_delete_time(req.value().delete_time() +
                                                  getticks());
         }
@@ -193,7 +232,7 @@ Status Range::ApplyLock(const raft_cmdpb::Command &cmd) {
 
         lock::EncodeValue(&value_buf,
                          version, req.value(), &extend);
-        ret = store_->Put(encode_key, value_buf);
+        ret = store_->Put(encode_key, value_buf, cmd.expire_at());
 
         context_->Statistics()->PushTime(HistogramType::kQWait,
                                        get_micro_second() - btime);
@@ -203,6 +242,7 @@ Status Range::ApplyLock(const raft_cmdpb::Command &cmd) {
             resp->mutable_resp()->set_error("lock failed");
             break;
         }
+        lock_table_.Put(encode_key, req.value());
 
         if (cmd.cmd_id().node_id() == node_id_) {
             auto len = encode_key.size() + req.value().ByteSizeLong();
@@ -251,6 +291,7 @@ void Range::LockUpdate(common::ProtoMessage *msg,
             RANGE_LOG_WARN("LockUpdate error: %s", err->message().c_str());
             break;
         }
+        TryLoadLockTable();
 
         auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::LockUpdate);
@@ -324,7 +365,7 @@ Status Range::ApplyLockUpdate(const raft_cmdpb::Command &cmd) {
         lock::EncodeValue(&value_buf,
                          version, *val, &extend);
 
-        ret = store_->Put(encode_key, value_buf);
+        ret = store_->Put(encode_key, value_buf, cmd.expire_at());
         context_->Statistics()->PushTime(HistogramType::kQWait,
                                        get_micro_second() - btime);
         if (!ret.ok()) {
@@ -334,6 +375,7 @@ Status Range::ApplyLockUpdate(const raft_cmdpb::Command &cmd) {
             resp->mutable_resp()->set_error("lock update failed");
             break;
         }
+        lock_table_.Put(encode_key, *val);
 
         if (cmd.cmd_id().node_id() == node_id_) {
             auto len = encode_key.size() + req.ByteSizeLong();
@@ -370,6 +412,7 @@ void Range::Unlock(common::ProtoMessage *msg, kvrpcpb::DsUnlockRequest &req) {
         if (!KeyInRange(encode_key, err)) {
             break;
         }
+        TryLoadLockTable();
 
         auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::Unlock);
@@ -439,6 +482,7 @@ Status Range::ApplyUnlock(const raft_cmdpb::Command &cmd) {
             resp->mutable_resp()->set_update_time(val->update_time());
             break;
         }
+        lock_table_.Erase(encode_key);
         delete val;
 
         RANGE_LOG_INFO("ApplyUnlock: lock [%s] is unlock by %s", EncodeToHexString(req.key()).c_str(), req.by().c_str());
@@ -490,6 +534,7 @@ void Range::UnlockForce(common::ProtoMessage *msg,
         if (!KeyInRange(encode_key, err)) {
             break;
         }
+        TryLoadLockTable();
 
         auto ret = SubmitCmd(msg, req.header(), [&req](raft_cmdpb::Command &cmd) {
             cmd.set_cmd_type(raft_cmdpb::CmdType::UnlockForce);
@@ -552,6 +597,7 @@ Status Range::ApplyUnlockForce(const raft_cmdpb::Command &cmd) {
             resp->mutable_resp()->set_update_time(val->update_time());
             break;
         }
+        lock_table_.Erase(encode_key);
         delete val;
 
         RANGE_LOG_INFO("ApplyForceUnlock: lock [%s] is unlock by %s", EncodeToHexString(req.key()).c_str(), req.by().c_str());
@@ -584,6 +630,83 @@ Status Range::ApplyUnlockForce(const raft_cmdpb::Command &cmd) {
     return ret;
 }
 
+void Range::ExpireLocks(std::vector<raft_cmdpb::ExpiredLock>& locks) {
+    if (!valid_ || !is_leader_) return;
+
+    lock_table_.FilterExpired(&locks);
+    if (locks.empty()) return;
+
+    raft_cmdpb::Command cmd;
+    cmd.set_cmd_type(raft_cmdpb::CmdType::LockExpire);
+    cmd.mutable_cmd_id()->set_node_id(node_id_);
+    meta_.GetEpoch(cmd.mutable_verify_epoch());
+    auto expire_req = cmd.mutable_lock_expire_req();
+    for (auto& lock : locks) {
+        expire_req->add_locks()->Swap(&lock);
+    }
+
+    // 失败了等锁表中的重试定时器再次触发
+    auto ret = Submit(cmd);
+    if (!ret.ok()) {
+        RANGE_LOG_WARN("submit lock expire failed: %s", ret.ToString().c_str());
+    } else {
+        RANGE_LOG_DEBUG("submit lock expire: %d locks", expire_req->locks_size());
+    }
+}
+
+Status Range::ApplyLockExpire(const raft_cmdpb::Command &cmd) {
+    RANGE_LOG_DEBUG("apply lock expire: %s", cmd.DebugString().c_str());
+
+    // 分裂之后不在本range的key不处理，由新range自己过期
+    std::vector<std::string> keys;
+    for (const auto &expired : cmd.lock_expire_req().locks()) {
+        if (!KeyInRange(expired.key())) continue;
+
+        // 只删除提交时的那个锁，期间解锁重新加锁或者延期的不删
+        kvrpcpb::LockValue val;
+        if (!LockLoad(expired.key(), &val)) continue;
+        if (val.id() != expired.id() || val.delete_time() <= 0 ||
+            val.delete_time() > expired.delete_time()) {
+            continue;
+        }
+        keys.push_back(expired.key());
+    }
+    if (keys.empty()) {
+        return Status::OK();
+    }
+
+    auto ret = store_->BatchDelete(keys);
+    if (!ret.ok()) {
+        RANGE_LOG_ERROR("ApplyLockExpire failed, code:%d, msg:%s", ret.code(),
+                        ret.ToString().c_str());
+        return ret;
+    }
+
+    for (const auto &key : keys) {
+        lock_table_.Erase(key);
+
+        std::string decode_key;
+        if (key.size() <= 9 || !lock::DecodeKey(decode_key, key)) {
+            RANGE_LOG_WARN("ApplyLockExpire decode lock key [%s] failed",
+                           EncodeToHexString(key).c_str());
+            continue;
+        }
+
+        // 唤醒等待这个锁的LockWatch
+        std::string err_msg;
+        watchpb::WatchKeyValue watch_kv;
+        watch_kv.add_key(decode_key);
+        auto retCnt = WatchNotify(watchpb::DELETE, watch_kv, watch_kv.version(), err_msg);
+        if (retCnt < 0) {
+            RANGE_LOG_ERROR("ApplyLockExpire WatchNotify failed, ret:%d, msg:%s", retCnt,
+                            err_msg.c_str());
+        }
+    }
+
+    RANGE_LOG_INFO("ApplyLockExpire: %zu locks expired", keys.size());
+    return Status::OK();
+}
+
 void Range::LockWatch(common::ProtoMessage *msg,
                         watchpb::DsWatchRequest& req) {
     errorpb::Error *err = nullptr;
@@ -610,6 +733,7 @@ void Range::LockWatch(common::ProtoMessage *msg,
         if (!KeyInRange(encode_key, err)) {
             break;
         }
+        TryLoadLockTable();
 
         auto val = LockGet(encode_key);
         if (val == nullptr) {
@@ -657,24 +781,33 @@ void Range::LockScan(common::ProtoMessage *msg, kvrpcpb::DsLockScanRequest &req)
     auto ds_resp = new kvrpcpb::DsLockScanResponse;
     auto start = std::max(req.req().start(), start_key_);
     auto limit = std::min(req.req().limit(), meta_.GetEndKey());
-    std::unique_ptr<storage::Iterator> iterator(store_->NewIterator(start, limit));
 
     int max_count = checkMaxCount(static_cast<int64_t >(req.req().count()));
     auto resp = ds_resp->mutable_resp();
 
-    uint64_t count = 0;
-    uint64_t total_size = 0;
-
-    for (int i = 0; iterator->Valid() && i < max_count; ++i) {
-        auto kv = resp->add_info();
-        FLOG_DEBUG("scan key: %s", iterator->key().c_str());
-        kv->set_key(std::move(iterator->key()));
-        kv->mutable_value()->ParseFromString(iterator->value());
-
-        count++;
-        total_size += iterator->key().length()+iterator->value().length();
-
-        iterator->Next();
+    TryLoadLockTable();
+    std::vector<std::pair<std::string, kvrpcpb::LockValue>> locks;
+    if (lock_table_.Scan(start, limit, max_count, &locks)) {
+        for (auto& lock : locks) {
+            auto info = resp->add_info();
+            info->set_key(std::move(lock.first));
+            info->mutable_value()->Swap(&lock.second);
+        }
+    } else {
+        std::unique_ptr<storage::Iterator> iterator(store_->NewIterator(start, limit));
+        for (int i = 0; iterator->Valid() && i < max_count; ++i) {
+            FLOG_DEBUG("scan key: %s", iterator->key().c_str());
+            auto buf = iterator->value();
+            kvrpcpb::LockValue value;
+            int64_t version = 0;
+            std::string extend;
+            if (!buf.empty() && lock::DecodeValue(&version, &value, &extend, buf)) {
+                auto info = resp->add_info();
+                info->set_key(iterator->key());
+                info->mutable_value()->Swap(&value);
+            }
+            iterator->Next();
+        }
     }
 
     if (resp->info_size() > 0) {
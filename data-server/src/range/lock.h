@@ -0,0 +1,24 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <string>
+
+#include "proto/gen/kvrpcpb.pb.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace range {
+namespace lock {
+
+// 锁key和value在store中的编码
+void EncodeKey(std::string* buf, uint64_t tableId, const std::string* key);
+bool DecodeKey(std::string& key, const std::string& buf);
+void EncodeValue(std::string* buf, int64_t version, const kvrpcpb::LockValue& lock_value,
+                 const std::string* extend);
+bool DecodeValue(int64_t* version, kvrpcpb::LockValue* lock_value, std::string* extend,
+                 std::string& buf);
+
+} // namespace lock
+} // namespace range
+} // namespace dataserver
+} // namespace sharkstore
@@ -0,0 +1,106 @@
+#include "lock_expirer.h"
+
+#include <map>
+
+#include "base/util.h"
+#include "frame/sf_logger.h"
+#include "frame/sf_util.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace range {
+
+const int64_t LockExpirer::kTickMs;
+const size_t LockExpirer::kMaxBatch;
+
+LockExpirer::LockExpirer(const ExpireHandler& on_expire, const LoadHandler& on_load)
+    : on_expire_(on_expire), on_load_(on_load), wheel_(kTickMs, getticks()) {
+    thr_ = std::thread(&LockExpirer::run, this);
+    AnnotateThread(thr_.native_handle(), "lock_expire");
+}
+
+LockExpirer::~LockExpirer() { Stop(); }
+
+uint64_t LockExpirer::Schedule(uint64_t range_id, const std::string& key,
+                               const std::string& id, int64_t delete_time,
+                               int64_t fire_ms) {
+    Task task;
+    task.range_id = range_id;
+    task.lock.set_key(key);
+    task.lock.set_id(id);
+    task.lock.set_delete_time(delete_time);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    return wheel_.Add(fire_ms, task);
+}
+
+void LockExpirer::Cancel(uint64_t timer_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    wheel_.Cancel(timer_id);
+}
+
+void LockExpirer::ScheduleLoad(uint64_t range_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    pending_loads_.push_back(range_id);
+    cond_.notify_one();
+}
+
+void LockExpirer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!running_) return;
+        running_ = false;
+        cond_.notify_one();
+    }
+    if (thr_.joinable()) {
+        thr_.join();
+    }
+}
+
+size_t LockExpirer::Size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return wheel_.Size();
+}
+
+void LockExpirer::run() {
+    while (true) {
+        std::vector<uint64_t> loads;
+        std::vector<Task> expired;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            if (pending_loads_.empty()) {
+                cond_.wait_for(lock, std::chrono::milliseconds(kTickMs));
+            }
+            if (!running_) break;
+            loads.swap(pending_loads_);
+            wheel_.Advance(getticks(), &expired);
+        }
+
+        for (auto range_id : loads) {
+            on_load_(range_id);
+        }
+        if (expired.empty()) continue;
+
+        // 按range分组，分批回调
+        std::map<uint64_t, std::vector<raft_cmdpb::ExpiredLock>> groups;
+        for (auto& task : expired) {
+            auto& locks = groups[task.range_id];
+            locks.push_back(std::move(task.lock));
+            if (locks.size() >= kMaxBatch) {
+                on_expire_(task.range_id, locks);
+                locks.clear();
+            }
+        }
+        for (auto& group : groups) {
+            if (!group.second.empty()) {
+                on_expire_(group.first, group.second);
+            }
+        }
+    }
+
+    FLOG_INFO("lock expire thread exit...");
+}
+
+}  // namespace range
+}  // namespace dataserver
+}  // namespace sharkstore
@@ -0,0 +1,74 @@
+_Pragma("once");
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/timer_wheel.h"
+#include "proto/gen/raft_cmdpb.pb.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace range {
+
+// 节点上所有range共用的锁过期定时器
+// 锁到期后由后台线程回调，leader提交LockExpire命令删除，不依赖读的时候顺带检查
+// 锁表的加载也放在这个线程里做，不阻塞请求线程
+class LockExpirer {
+public:
+    // 时间轮精度(毫秒)
+    static const int64_t kTickMs = 10;
+    // 一条LockExpire命令最多带多少个锁
+    static const size_t kMaxBatch = 1000;
+
+    // 回调都在后台线程里执行，不持有LockExpirer的锁
+    typedef std::function<void(uint64_t range_id, std::vector<raft_cmdpb::ExpiredLock>& locks)>
+        ExpireHandler;
+    typedef std::function<void(uint64_t range_id)> LoadHandler;
+
+    LockExpirer(const ExpireHandler& on_expire, const LoadHandler& on_load);
+    ~LockExpirer();
+
+    LockExpirer(const LockExpirer&) = delete;
+    LockExpirer& operator=(const LockExpirer&) = delete;
+
+    // fire_ms时间到期回调(绝对时间，毫秒)，返回定时器id
+    uint64_t Schedule(uint64_t range_id, const std::string& key, const std::string& id,
+                      int64_t delete_time, int64_t fire_ms);
+    void Cancel(uint64_t timer_id);
+
+    // 后台加载range的锁表
+    void ScheduleLoad(uint64_t range_id);
+
+    // 停止后台线程，之后不再回调，Schedule/Cancel仍然可以调用
+    void Stop();
+
+    size_t Size() const;
+
+private:
+    struct Task {
+        uint64_t range_id = 0;
+        raft_cmdpb::ExpiredLock lock;
+    };
+
+    void run();
+
+private:
+    const ExpireHandler on_expire_;
+    const LoadHandler on_load_;
+
+    mutable std::mutex mu_;
+    std::condition_variable cond_;
+    bool running_ = true;
+    TimerWheel<Task> wheel_;
+    std::vector<uint64_t> pending_loads_;
+
+    std::thread thr_;
+};
+
+}  // namespace range
+}  // namespace dataserver
+}  // namespace sharkstore
@@ -0,0 +1,186 @@
+#include "lock_table.h"
+
+#include <memory>
+
+#include "common/ds_encoding.h"
+#include "frame/sf_logger.h"
+#include "frame/sf_util.h"
+#include "storage/store.h"
+
+#include "lock.h"
+#include "lock_expirer.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace range {
+
+const int64_t LockTable::kRetryMs;
+
+LockTable::LockTable(uint64_t range_id, LockExpirer* expirer)
+    : range_id_(range_id), expirer_(expirer) {}
+
+LockTable::~LockTable() { Reset(); }
+
+bool LockTable::TryStartLoad() {
+    if (expirer_ == nullptr) return false;
+
+    std::lock_guard<std::mutex> lock(mu_);
+    if (state_ != State::kUnloaded) return false;
+    state_ = State::kLoading;
+    return true;
+}
+
+bool LockTable::Load(storage::Store* store, const std::string& start,
+                     const std::string& limit) {
+    std::lock_guard<std::mutex> lock(mu_);
+    // 加载之前已经被Reset了
+    if (state_ != State::kLoading) return false;
+
+    std::unique_ptr<storage::Iterator> it(store->NewIterator(start, limit));
+    for (; it->Valid(); it->Next()) {
+        auto key = it->key();
+        auto buf = it->value();
+        Entry entry;
+        int64_t version = 0;
+        std::string extend;
+        if (buf.empty() || !lock::DecodeValue(&version, &entry.value, &extend, buf)) {
+            FLOG_WARN("range[%" PRIu64 "] lock table load: invalid lock key %s",
+                      range_id_, EncodeToHexString(key).c_str());
+            continue;
+        }
+        auto& e = locks_[key];
+        e = std::move(entry);
+        if (e.value.delete_time() > 0) {
+            schedule(key, &e, e.value.delete_time());
+        }
+    }
+    if (!it->status().ok()) {
+        FLOG_ERROR("range[%" PRIu64 "] lock table load failed: %s", range_id_,
+                   it->status().ToString().c_str());
+        for (auto& kv : locks_) {
+            cancel(&kv.second);
+        }
+        locks_.clear();
+        state_ = State::kUnloaded;
+        return false;
+    }
+
+    state_ = State::kLoaded;
+    FLOG_INFO("range[%" PRIu64 "] lock table loaded, %zu locks", range_id_, locks_.size());
+    return true;
+}
+
+void LockTable::Reset() {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& kv : locks_) {
+        cancel(&kv.second);
+    }
+    locks_.clear();
+    state_ = State::kUnloaded;
+}
+
+bool LockTable::Loaded() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return state_ == State::kLoaded;
+}
+
+size_t LockTable::Size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return locks_.size();
+}
+
+bool LockTable::Get(const std::string& key, kvrpcpb::LockValue* value, bool* found) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (state_ != State::kLoaded) return false;
+
+    auto it = locks_.find(key);
+    *found = (it != locks_.end());
+    if (*found) {
+        value->CopyFrom(it->second.value);
+    }
+    return true;
+}
+
+void LockTable::Put(const std::string& key, const kvrpcpb::LockValue& value) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (state_ != State::kLoaded) return;
+
+    auto& e = locks_[key];
+    // 定时器里记录了锁的id和删除时间，变了要重新注册
+    bool reschedule = e.timer_id == 0 || e.value.id() != value.id() ||
+                      e.value.delete_time() != value.delete_time();
+    e.value.CopyFrom(value);
+    if (reschedule) {
+        cancel(&e);
+        if (value.delete_time() > 0) {
+            schedule(key, &e, value.delete_time());
+        }
+    }
+}
+
+void LockTable::Erase(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (state_ != State::kLoaded) return;
+
+    auto it = locks_.find(key);
+    if (it != locks_.end()) {
+        cancel(&it->second);
+        locks_.erase(it);
+    }
+}
+
+bool LockTable::Scan(const std::string& start, const std::string& limit, size_t count,
+                     std::vector<std::pair<std::string, kvrpcpb::LockValue>>* result) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (state_ != State::kLoaded) return false;
+
+    for (auto it = locks_.lower_bound(start);
+         it != locks_.end() && it->first < limit && result->size() < count; ++it) {
+        result->emplace_back(it->first, it->second.value);
+    }
+    return true;
+}
+
+void LockTable::FilterExpired(std::vector<raft_cmdpb::ExpiredLock>* locks) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (state_ != State::kLoaded) {
+        locks->clear();
+        return;
+    }
+
+    auto retry_at = getticks() + kRetryMs;
+    size_t n = 0;
+    for (auto& expired : *locks) {
+        auto it = locks_.find(expired.key());
+        if (it == locks_.end()) continue;
+        auto& e = it->second;
+        if (e.value.id() != expired.id() || e.value.delete_time() <= 0 ||
+            e.value.delete_time() != expired.delete_time()) {
+            continue;
+        }
+        // 这个锁的定时器已经触发，再注册一个重试的
+        e.timer_id = 0;
+        schedule(it->first, &e, retry_at);
+        if (n != static_cast<size_t>(&expired - locks->data())) {
+            (*locks)[n] = std::move(expired);
+        }
+        ++n;
+    }
+    locks->resize(n);
+}
+
+void LockTable::schedule(const std::string& key, Entry* entry, int64_t fire_ms) {
+    entry->timer_id = expirer_->Schedule(range_id_, key, entry->value.id(),
+                                         entry->value.delete_time(), fire_ms);
+}
+
+void LockTable::cancel(Entry* entry) {
+    if (entry->timer_id != 0) {
+        expirer_->Cancel(entry->timer_id);
+        entry->timer_id = 0;
+    }
+}
+
+}  // namespace range
+}  // namespace dataserver
+}  // namespace sharkstore
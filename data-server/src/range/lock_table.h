@@ -0,0 +1,82 @@
+_Pragma("once");
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "proto/gen/kvrpcpb.pb.h"
+#include "proto/gen/raft_cmdpb.pb.h"
+
+namespace sharkstore {
+namespace dataserver {
+
+namespace storage { class Store; }
+
+namespace range {
+
+class LockExpirer;
+
+// range在内存中的锁表，只在leader上加载
+// 加载之后读锁不再访问rocksdb，带删除时间的锁在时间轮上注册定时器
+// 修改都在apply之后进行，和store保持一致；没加载时所有操作都不生效
+class LockTable {
+public:
+    // 提交删除之后多久还没删掉就重试(毫秒)
+    static const int64_t kRetryMs = 1000;
+
+    // expirer为空时不启用锁表
+    LockTable(uint64_t range_id, LockExpirer* expirer);
+    ~LockTable();
+
+    LockTable(const LockTable&) = delete;
+    LockTable& operator=(const LockTable&) = delete;
+
+    // 第一次调用时返回true，由调用者安排加载
+    bool TryStartLoad();
+    // 从store中加载[start, limit)的锁，key为编码后的锁key
+    // 加载期间持有锁表的锁，apply对锁表的修改会等加载完成
+    bool Load(storage::Store* store, const std::string& start, const std::string& limit);
+    // 丢弃锁表并取消定时器，之后需要重新加载
+    void Reset();
+
+    bool Loaded() const;
+    size_t Size() const;
+
+    // 锁表没加载返回false
+    // 加载了found表示锁是否存在，不检查删除时间
+    bool Get(const std::string& key, kvrpcpb::LockValue* value, bool* found) const;
+    void Put(const std::string& key, const kvrpcpb::LockValue& value);
+    void Erase(const std::string& key);
+    // 取[start, limit)范围内最多count个锁
+    bool Scan(const std::string& start, const std::string& limit, size_t count,
+              std::vector<std::pair<std::string, kvrpcpb::LockValue>>* result) const;
+
+    // 过滤掉定时器触发之后又被重新加锁或者延期的锁，剩下的需要提交删除
+    // 提交之后一段时间还没删掉的会再次触发
+    void FilterExpired(std::vector<raft_cmdpb::ExpiredLock>* locks);
+
+private:
+    struct Entry {
+        kvrpcpb::LockValue value;
+        uint64_t timer_id = 0;
+    };
+
+    enum class State { kUnloaded, kLoading, kLoaded };
+
+    void schedule(const std::string& key, Entry* entry, int64_t fire_ms);
+    void cancel(Entry* entry);
+
+private:
+    const uint64_t range_id_ = 0;
+    LockExpirer* const expirer_ = nullptr;
+
+    mutable std::mutex mu_;
+    State state_ = State::kUnloaded;
+    std::map<std::string, Entry> locks_;
+};
+
+}  // namespace range
+}  // namespace dataserver
+}  // namespace sharkstore
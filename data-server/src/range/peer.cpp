@@ -1,5 +1,6 @@
 #include "range.h"
 
+#include "master/worker.h"
 #include "storage/meta_store.h"
 #include "proto/gen/raft_cmdpb.pb.h"
 
@@ -118,7 +119,10 @@ Status Range::ApplyMemberChange(const raft::ConfChange &cc, uint64_t index) {
         }
 
         // notify master the newest peers if we are leader
-        PushHeartBeatMessage();
+        mspb::RangeHeartbeatRequest req;
+        if (FillHeartbeat(&req)) {
+            context_->MasterClient()->AsyncRangeHeartbeat(req);
+        }
 
         RANGE_LOG_INFO("ApplyMemberChange(%s) successfully.", cc.ToString().c_str());
     }
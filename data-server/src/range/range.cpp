@@ -7,6 +7,7 @@
 #include "server/range_server.h"
 #include "server/run_status.h"
 #include "storage/meta_store.h"
+#include "storage/ttl.h"
 
 #include "snapshot.h"
 #include "range_logger.h"
@@ -25,7 +26,8 @@ Range::Range(RangeContext* context, const metapb::Range &meta) :
 	id_(meta.id()),
 	start_key_(meta.start_key()),
 	meta_(meta),
-	store_(new storage::Store(meta, context->DBInstance())) {
+	store_(new storage::Store(meta, context->DBInstance(), context->GetLegacyRanges())),
+	lock_table_(meta.id(), context->GetLockExpirer()) {
     eventBuffer = new watch::CEventBuffer(ds_config.watch_config.buffer_map_size,
                                         ds_config.watch_config.buffer_queue_size);
 }
@@ -105,21 +107,31 @@ Status Range::Shutdown() {
         RANGE_LOG_WARN("remove raft failed: %s", s.ToString().c_str());
     }
     raft_.reset();
+    lock_table_.Reset();
 
     ClearExpiredContext();
     return Status::OK();
 }
 
 void Range::Heartbeat() {
-    if (PushHeartBeatMessage()) {
+    mspb::RangeHeartbeatRequest req;
+    if (CollectHeartbeat(&req)) {
+        context_->MasterClient()->AsyncRangeHeartbeat(req);
+    }
+}
+
+bool Range::CollectHeartbeat(mspb::RangeHeartbeatRequest *req) {
+    bool collected = FillHeartbeat(req);
+    if (collected) {
         context_->ScheduleHeartbeat(id_, true);
     }
 
     // clear async apply expired task
     ClearExpiredContext();
+    return collected;
 }
 
-bool Range::PushHeartBeatMessage() {
+bool Range::FillHeartbeat(mspb::RangeHeartbeatRequest *req) {
     if (!is_leader_ || !valid_ || raft_ == nullptr || raft_->IsStopped()) {
         return false;
     }
@@ -129,13 +141,11 @@ bool Range::PushHeartBeatMessage() {
             meta_.GetVersion(), meta_.GetConfVer(), EncodeToHex(start_key_).c_str(),
             EncodeToHex(meta_.GetEndKey()).c_str());
 
-    mspb::RangeHeartbeatRequest req;
-
     // 设置meta
-    meta_.Get(req.mutable_range());
+    meta_.Get(req->mutable_range());
 
     // 设置leader
-    auto leader_peer = req.mutable_leader();
+    auto leader_peer = req->mutable_leader();
     if (!meta_.FindPeerByNodeID(node_id_, leader_peer)) {
         RANGE_LOG_ERROR("heartbeat not found leader: %" PRIu64, node_id_);
         return false;
@@ -148,10 +158,10 @@ bool Range::PushHeartBeatMessage() {
         return false;
     }
     // 设置leader term
-    req.set_term(rs.term);
+    req->set_term(rs.term);
 
     for (const auto &pr : rs.replicas) {
-        auto peer_status = req.add_peers_status();
+        auto peer_status = req->add_peers_status();
 
         auto peer = peer_status->mutable_peer();
         if (!meta_.FindPeerByNodeID(pr.first, peer)) {
@@ -170,7 +180,7 @@ bool Range::PushHeartBeatMessage() {
     }
 
     // metric stats
-    auto stats = req.mutable_stats();
+    auto stats = req->mutable_stats();
     stats->set_approximate_size(real_size_);
 
     storage::MetricStat store_stat;
@@ -180,8 +190,6 @@ bool Range::PushHeartBeatMessage() {
     stats->set_keys_written(store_stat.keys_write_per_sec);
     stats->set_bytes_written(store_stat.bytes_write_per_sec);
 
-    context_->MasterClient()->AsyncRangeHeartbeat(req);
-
     return true;
 }
 
@@ -199,6 +207,8 @@ Status Range::Apply(const raft_cmdpb::Command &cmd, uint64_t index) {
             return ApplyUnlock(cmd);
         case raft_cmdpb::CmdType::UnlockForce:
             return ApplyUnlockForce(cmd);
+        case raft_cmdpb::CmdType::LockExpire:
+            return ApplyLockExpire(cmd);
 
         case raft_cmdpb::CmdType::RawPut:
             return ApplyRawPut(cmd);
@@ -272,12 +282,16 @@ Status Range::Apply(const std::string &cmd, uint64_t index) {
 }
 
 Status Range::Submit(const raft_cmdpb::Command &cmd) {
+    std::string str_cmd = std::move(cmd.SerializeAsString());
+    if (str_cmd.empty()) {
+        return Status(Status::kCorruption, "protobuf serialize failed", "");
+    }
+    return Submit(str_cmd);
+}
+
+Status Range::Submit(std::string &data) {
     if (is_leader_) {
-        std::string str_cmd = std::move(cmd.SerializeAsString());
-        if (str_cmd.empty()) {
-            return Status(Status::kCorruption, "protobuf serialize failed", "");
-        }
-        return raft_->Submit(str_cmd);
+        return raft_->Submit(data);
         // return Apply(cmd,0);
     } else {
         return Status(Status::kNotLeader, "Not Leader", "");
@@ -286,21 +300,39 @@ Status Range::Submit(const raft_cmdpb::Command &cmd) {
 
 Status Range::SubmitCmd(common::ProtoMessage *msg, const kvrpcpb::RequestHeader& header,
                  const std::function<void(raft_cmdpb::Command &cmd)> &init) {
-    raft_cmdpb::Command cmd;
-    init(cmd);
+    // 命令和请求都分配在msg的arena上，init里可以直接转移请求中的子消息，不用拷贝
+    auto cmd = msg->NewMessage<raft_cmdpb::Command>();
+    init(*cmd);
 
     // set verify epoch
-    auto epoch = new metapb::RangeEpoch(header.range_epoch());
-    cmd.set_allocated_verify_epoch(epoch);
+    cmd->mutable_verify_epoch()->CopyFrom(header.range_epoch());
+    auto seq = submit_queue_.GetSeq();
+    cmd->mutable_cmd_id()->set_node_id(node_id_);
+    cmd->mutable_cmd_id()->set_seq(seq);
+    // 默认ttl在leader上算好随命令复制，所有写入路径统一使用
+    auto expire_at = storage::DefaultExpireAt();
+    if (expire_at > 0) {
+        cmd->set_expire_at(expire_at);
+    }
+
+    // 加入队列后msg随时可能被回应并释放(连同arena上的cmd)，所以先序列化
+    std::string data;
+    if (!cmd->SerializeToString(&data)) {
+        return Status(Status::kCorruption, "protobuf serialize failed", "");
+    }
+
+    msg->trace.trace_id = header.trace_id();
+    msg->trace.range_id = id_;
+    msg->trace.Set(monitor::TraceStage::kPropose, get_micro_second());
 
     // add to queue
-    auto seq = submit_queue_.Add(header, cmd.cmd_type(), msg);
-    cmd.mutable_cmd_id()->set_node_id(node_id_);
-    cmd.mutable_cmd_id()->set_seq(seq);
+    submit_queue_.Add(seq, header, cmd->cmd_type(), msg);
 
-    auto ret = Submit(cmd);
+    auto ret = Submit(data);
     if (!ret.ok()) {
-        submit_queue_.Remove(cmd.cmd_id().seq());
+        auto ctx = submit_queue_.Remove(seq);
+        // 提交失败由调用者回应错误，msg不能在这里释放
+        if (ctx != nullptr) ctx->ReleaseMsg();
     }
 
     return ret;
@@ -321,6 +353,9 @@ void Range::OnLeaderChange(uint64_t leader, uint64_t term) {
             store_->ResetMetric();
         }
         context_->ScheduleHeartbeat(id_, false);
+    } else if (prev_is_leader) {
+        // 锁表只在leader上维护，重新成为leader后再加载
+        lock_table_.Reset();
     }
     context_->Statistics()->ReportLeader(id_, is_leader_.load());
 }
@@ -340,10 +375,21 @@ Status Range::ApplySnapshotStart(const std::string &context) {
         return Status(Status::kInvalid, "range is invalid", "");
     }
 
+    lock_table_.Reset();
     auto s = store_->Truncate();
     if (!s.ok()) {
         return s;
     }
+    // 数据已经清空，快照里的数据按新格式写入
+    if (store_->LegacyFormat()) {
+        s = context_->MetaStore()->DelLegacyRange(id_);
+        if (!s.ok()) {
+            RANGE_LOG_ERROR("delete legacy format flag failed: %s", s.ToString().c_str());
+            return s;
+        }
+        store_->ClearLegacyFormat();
+        RANGE_LOG_INFO("convert to the new value format");
+    }
 
     raft_cmdpb::SnapshotContext ctx;
     if (!ctx.ParseFromString(context)) {
@@ -351,6 +397,8 @@ Status Range::ApplySnapshotStart(const std::string &context) {
     }
 
     meta_.Set(ctx.meta());
+    // 快照里的数据按快照meta的索引定义建索引
+    store_->ResetIndexColumns(ctx.meta());
     s = SaveMeta(ctx.meta()) ;
     if (!s.ok()) {
         RANGE_LOG_ERROR("save snapshot meta failed: %s", s.ToString().c_str());
@@ -406,6 +454,7 @@ Status Range::Destroy() {
         RANGE_LOG_WARN("destroy raft failed: %s", s.ToString().c_str());
     }
     raft_.reset();
+    lock_table_.Reset();
 
     s = store_->Truncate();
     if (!s.ok()) {
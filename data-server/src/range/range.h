@@ -30,9 +30,11 @@ _Pragma("once");
 #include "server/run_status.h"
 #include "watch/watch_event_buffer.h"
 #include "watch/watcher.h"
+#include "watch/watch_stream.h"
 
 #include "meta_keeper.h"
 #include "context.h"
+#include "lock_table.h"
 #include "submit.h"
 #include "range_logger.h"
 
@@ -94,6 +96,10 @@ public:
     void UnlockForce(common::ProtoMessage *msg, kvrpcpb::DsUnlockForceRequest &req);
     void LockWatch(common::ProtoMessage *msg, watchpb::DsWatchRequest& req);
     void LockScan(common::ProtoMessage *msg, kvrpcpb::DsLockScanRequest &req);
+    // 锁过期定时器触发后由LockExpirer回调，leader提交删除
+    void ExpireLocks(std::vector<raft_cmdpb::ExpiredLock>& locks);
+    // 在LockExpirer线程里加载锁表
+    void LoadLockTable();
 
     // KV
     void RawGet(common::ProtoMessage *msg, kvrpcpb::DsKvRawGetRequest &req);
@@ -149,6 +155,7 @@ private:
     
 private:
     Status Submit(const raft_cmdpb::Command &cmd);
+    Status Submit(std::string &data);
 
     Status SubmitCmd(common::ProtoMessage *msg, const kvrpcpb::RequestHeader& header,
                      const std::function<void(raft_cmdpb::Command &cmd)> &init);
@@ -180,6 +187,12 @@ private:
     Status ApplyLockUpdate(const raft_cmdpb::Command &cmd);
     Status ApplyUnlock(const raft_cmdpb::Command &cmd);
     Status ApplyUnlockForce(const raft_cmdpb::Command &cmd);
+    Status ApplyLockExpire(const raft_cmdpb::Command &cmd);
+
+    // 读锁，不检查删除时间，锁表加载了从锁表读
+    bool LockLoad(const std::string &key, kvrpcpb::LockValue *value);
+    // leader上第一次访问锁时安排加载锁表
+    void TryLoadLockTable();
 
     // split func
     void CheckSplit(uint64_t size);
@@ -209,6 +222,7 @@ private:
         auto ctx = submit_queue_.Remove(cmd.cmd_id().seq());
         if (ctx != nullptr) {
             context_->Statistics()->PushTime(monitor::HistogramType::kRaft, apply_time - ctx->CreateTime());
+            ctx->TraceApply(apply_time);
             ctx->CheckExecuteTime(id_, kTimeTakeWarnThresoldUSec);
             ctx->Reply(context_->SocketSession(), resp, err);
         } else {
@@ -226,7 +240,11 @@ public:
     void DelPeer(const metapb::Peer &peer);
 
     void ResetStatisSize();
+    // 后台定期清理watch变更日志
+    void TrimWatchLog();
     void Heartbeat();
+    // 只收集心跳信息，由调用者合并发送；返回false表示当前不需要上报
+    bool CollectHeartbeat(mspb::RangeHeartbeatRequest *req);
 
     Status Destroy();
 
@@ -241,6 +259,9 @@ public:
     void GetReplica(metapb::Replica *rep);
     uint64_t GetSplitRangeID() const { return split_range_id_; }
     size_t GetSubmitQueueSize() const { return submit_queue_.Size(); }
+    bool IsLeader() const { return is_leader_; }
+    // 最近一次心跳采集的读写速率
+    void LastMetric(storage::MetricStat *stat) const { store_->LastMetric(stat); }
 
     void setLeaderFlag(bool flag) {
         is_leader_ = flag;
@@ -255,7 +276,7 @@ private:
     bool EpochIsEqual(const metapb::RangeEpoch &epoch);
     bool EpochIsEqual(const metapb::RangeEpoch &epoch, errorpb::Error *&);
 
-    bool PushHeartBeatMessage();
+    bool FillHeartbeat(mspb::RangeHeartbeatRequest *req);
 
     Status SaveMeta(const metapb::Range &meta);
 
@@ -275,6 +296,14 @@ private:
                        const int64_t &startVersion,
                        watchpb::DsWatchResponse *dsResp);
     int32_t SendNotify( watch::WatcherPtr w, watchpb::DsWatchResponse *ds_resp, bool prefix = false);
+    int32_t SendNotify(watch::WatcherPtr w, const watch::NotifyBody &body, bool prefix = false);
+    int32_t delNotifiedWatcher(watch::WatcherPtr w, bool prefix);
+
+    // 流式watch
+    void WatchStreamGet(common::ProtoMessage *msg, watchpb::DsWatchRequest &req);
+    watchpb::DsWatchResponse *loadStreamChanges(const watch::WatchStreamPtr &stream,
+                                                const watchpb::WatchCreateRequest &req,
+                                                int64_t startVersion);
 
 private:
     static const int kTimeTakeWarnThresoldUSec = 500000;
@@ -304,6 +333,8 @@ private:
     std::unique_ptr<storage::Store> store_;
     std::shared_ptr<raft::Raft> raft_;
 
+    LockTable lock_table_;
+
     int64_t max_count_ = 1000;
 };
 
@@ -15,6 +15,7 @@ Status Snapshot::Next(std::string* data, bool* over) {
         raft_cmdpb::SnapshotKVPair p;
         p.set_key(iter_->key());
         p.set_value(iter_->value());
+        p.set_expire_at(iter_->expire_at());
         if (!p.SerializeToString(data)) {
             return Status(Status::kCorruption, "serialize snapshot data",
                           "pb return false");
@@ -136,6 +136,9 @@ void Range::AdminSplit(mspb::AskSplitResponse &resp) {
     // set range start_key
     range->set_start_key(split_key);
     // range end_key doesn't need to change.
+    // master返回的meta不带索引定义，新range沿用本range的
+    auto meta = meta_.Get();
+    range->mutable_index_columns()->CopyFrom(meta.index_columns());
 
     // set range_epoch
     epoch->set_conf_ver(1);
@@ -183,15 +186,39 @@ Status Range::ApplySplit(const raft_cmdpb::Command &cmd, uint64_t index) {
 
     context_->Statistics()->IncrSplitCount();
 
+    // 索引按range存放，分出去的行的索引要移到新range
+    // 在保存新的meta之前移动：崩溃后meta还是旧版本，重放split时会再移动一次
+    ret = store_->SplitIndexes(req.split_key(), req.new_range().id());
+    if (!ret.ok()) {
+        RANGE_LOG_ERROR("ApplySplit(new range: %" PRIu64 ") move indexes failed: %s",
+                        req.new_range().id(), ret.ToString().c_str());
+        return ret;
+    }
+
+    // 分出去的key的watch变更日志复制给新range，新range上的watcher可以继续追赶
+    ret = store_->SplitWatchLog(req.split_key(), req.new_range().id());
+    if (!ret.ok()) {
+        RANGE_LOG_ERROR("ApplySplit(new range: %" PRIu64 ") copy watch log failed: %s",
+                        req.new_range().id(), ret.ToString().c_str());
+        return ret;
+    }
+
     ret = context_->SplitRange(id_, req, index);
     if (!ret.ok()) {
         RANGE_LOG_ERROR("ApplySplit(new range: %" PRIu64 ") create failed: %s",
                         req.new_range().id(), ret.ToString().c_str());
+        auto s = store_->UndoSplitIndexes(req.split_key(), req.new_range().id());
+        if (!s.ok()) {
+            RANGE_LOG_ERROR("ApplySplit(new range: %" PRIu64 ") undo move indexes failed: %s",
+                            req.new_range().id(), s.ToString().c_str());
+        }
         return ret;
     }
 
     meta_.Split(req.split_key(), req.epoch().version());
     store_->SetEndKey(req.split_key());
+    // 锁表里有分出去的锁，丢弃后按新的范围重新加载
+    lock_table_.Reset();
 
     if (req.leader() == node_id_) {
         ReportSplit(req.new_range());
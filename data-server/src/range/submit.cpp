@@ -3,6 +3,7 @@
 #include "frame/sf_logger.h"
 #include "frame/sf_util.h"
 #include "proto/gen/funcpb.pb.h"
+#include "raft/statemachine.h"
 
 namespace sharkstore {
 namespace dataserver {
@@ -53,20 +54,32 @@ void SubmitContext::CheckExecuteTime(uint64_t rangeID, int64_t thresold_usecs) {
     }
 }
 
+void SubmitContext::TraceApply(int64_t apply_time) {
+    if (msg_ == nullptr) return;
+
+    auto& trace = msg_->trace;
+    auto raft_trace = raft::CurrentEntryTrace();
+    if (raft_trace != nullptr) {
+        trace.Set(monitor::TraceStage::kRaftStep, raft_trace->step_time);
+        trace.Set(monitor::TraceStage::kRaftPersist, raft_trace->persist_time);
+        trace.Set(monitor::TraceStage::kRaftCommit, raft_trace->commit_time);
+    }
+    trace.Set(monitor::TraceStage::kApply, apply_time);
+}
 
 uint64_t SubmitQueue::GetSeq() {
     std::lock_guard<std::mutex> lock(mu_);
     return ++seq_;
 }
 
-uint64_t SubmitQueue::Add(const kvrpcpb::RequestHeader& req_header,
-             raft_cmdpb::CmdType type, common::ProtoMessage *msg) {
+void SubmitQueue::Add(uint64_t seq, const kvrpcpb::RequestHeader& req_header,
+                      raft_cmdpb::CmdType type, common::ProtoMessage *msg) {
     SubmitContextPtr ctx(new SubmitContext(req_header, type, msg));
+    auto expire_time = msg->expire_time;
 
     std::lock_guard<std::mutex> lock(mu_);
-    ctx_map_.emplace(++seq_, std::move(ctx));
-    expire_que_.emplace(msg->expire_time, seq_);
-    return seq_;
+    ctx_map_.emplace(seq, std::move(ctx));
+    expire_que_.emplace(expire_time, seq);
 }
 
 std::unique_ptr<SubmitContext> SubmitQueue::Remove(uint64_t seq_id) {
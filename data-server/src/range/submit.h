@@ -26,6 +26,12 @@ public:
     SubmitContext& operator=(const SubmitContext&) = delete;
 
     common::ProtoMessage* Msg() const { return msg_; }
+    // 交还msg的所有权，析构时不再释放
+    common::ProtoMessage* ReleaseMsg() {
+        auto msg = msg_;
+        msg_ = nullptr;
+        return msg;
+    }
     int64_t CreateTime() const { return create_time_; }
     raft_cmdpb::CmdType Type() const { return type_; }
 
@@ -48,6 +54,9 @@ public:
 
     void CheckExecuteTime(uint64_t rangeID, int64_t thresold_usecs);
 
+    // 在raft apply线程中调用，记录raft内部各阶段和开始应用的时间
+    void TraceApply(int64_t apply_time);
+
 private:
     // save for set response header lately
     uint64_t cluster_id_ = 0;
@@ -66,11 +75,12 @@ public:
     SubmitQueue(const SubmitQueue&) = delete;
     SubmitQueue& operator=(const SubmitQueue&) = delete;
 
-    // 只获取一个递增的ID, for split command
+    // 获取一个递增的ID
     uint64_t GetSeq();
 
-    uint64_t Add(const kvrpcpb::RequestHeader& req_header,
-                 raft_cmdpb::CmdType type, common::ProtoMessage *msg);
+    // seq需要预先通过GetSeq获取，以便提交前把seq填入命令中
+    void Add(uint64_t seq, const kvrpcpb::RequestHeader& req_header,
+             raft_cmdpb::CmdType type, common::ProtoMessage *msg);
 
     std::unique_ptr<SubmitContext> Remove(uint64_t seq_id);
 
@@ -1,4 +1,7 @@
 #include "range.h"
+
+#include <map>
+
 #include "server/range_server.h"
 #include "watch.h"
 #include "monitor/statistics.h"
@@ -133,6 +136,12 @@ void Range::WatchGet(common::ProtoMessage *msg, watchpb::DsWatchRequest &req) {
         return;
     }
 
+    if (req.req().stream()) {
+        delete ds_resp;
+        WatchStreamGet(msg, req);
+        return;
+    }
+
     //add watch if client version is not equal to ds side
     auto clientVersion = req.req().startversion();
 
@@ -220,6 +229,145 @@ void Range::WatchGet(common::ProtoMessage *msg, watchpb::DsWatchRequest &req) {
     return;
 }
 
+void Range::WatchStreamGet(common::ProtoMessage *msg, watchpb::DsWatchRequest &req) {
+    auto watch_server = context_->WatchServer();
+    auto &wreq = req.req();
+    auto prefix = wreq.prefix();
+    // 客户端已经收到的revision
+    auto ack = wreq.startversion();
+
+    std::vector<watch::WatcherKey*> keys;
+    for (const auto &k : wreq.kv().key()) {
+        keys.push_back(new watch::WatcherKey(k));
+    }
+    int64_t expireTime = (wreq.longpull() > 0)?get_micro_second() + wreq.longpull()*1000:msg->expire_time*1000;
+    auto w_ptr = std::make_shared<watch::Watcher>(prefix ? watch::WATCH_PREFIX : watch::WATCH_KEY,
+                                                  meta_.GetTableID(), keys, ack, expireTime, msg);
+    for (auto k : keys) {
+        delete k;
+    }
+
+    std::string key;
+    watch::Watcher::EncodeKey(&key, meta_.GetTableID(), w_ptr->GetKeys(false));
+
+    watch::WatchStreamPtr stream;
+    if (wreq.watchid() != 0) {
+        stream = watch_server->GetStream(wreq.watchid(), meta_.GetTableID(), key);
+    }
+
+    bool reload = false;
+    if (stream == nullptr) {
+        stream = watch_server->AddStream(meta_.GetTableID(), prefix, key);
+        reload = true;
+        RANGE_LOG_INFO("watch stream %" PRId64 " created, prefix: %d, key: %s, start version: %" PRId64
+                       ", request watch id: %" PRId64,
+                       stream->Id(), prefix, EncodeToHexString(key).c_str(), ack, wreq.watchid());
+    } else if (stream->Overflowed()) {
+        reload = true;
+        RANGE_LOG_WARN("watch stream %" PRId64 " overflowed, reload from version %" PRId64,
+                       stream->Id(), ack);
+    }
+
+    if (reload) {
+        // 先清空缓存再读存储，中间的事件可能重复，客户端按revision去重
+        stream->Reset();
+        auto ds_resp = loadStreamChanges(stream, wreq, ack);
+        if (ds_resp != nullptr) {
+            w_ptr->SetWatcherId(stream->Id());
+            ds_resp->mutable_resp()->set_watchid(stream->Id());
+            w_ptr->Send(ds_resp);
+            return;
+        }
+    }
+
+    watch_server->PollStream(stream, w_ptr, ack, wreq.credits());
+}
+
+watchpb::DsWatchResponse *Range::loadStreamChanges(const watch::WatchStreamPtr &stream,
+                                                   const watchpb::WatchCreateRequest &req,
+                                                   int64_t startVersion) {
+    auto ds_resp = new watchpb::DsWatchResponse;
+    auto resp = ds_resp->mutable_resp();
+    resp->set_code(Status::kOk);
+    resp->set_scope(watchpb::RESPONSE_PART);
+
+    int32_t count = 0;
+    if (!stream->IsPrefix()) {
+        std::string val;
+        auto ret = store_->Get(stream->Key(), &val);
+        if (ret.ok()) {
+            int64_t version = 0;
+            std::string userVal, ext;
+            if (watch::Watcher::DecodeValue(&version, &userVal, &ext, val) && version > startVersion) {
+                auto evt = resp->add_events();
+                evt->set_type(watchpb::PUT);
+                evt->mutable_kv()->mutable_key()->CopyFrom(req.kv().key());
+                evt->mutable_kv()->set_value(userVal);
+                evt->mutable_kv()->set_version(version);
+                resp->set_revision(version);
+                count = 1;
+            }
+        } else if (ret.code() == Status::kNotFound && startVersion > 0) {
+            // 和单次watch一样，客户端收到之后把版本重置为0
+            resp->set_code(Status::kNotFound);
+            count = 1;
+        } else if (!ret.ok() && ret.code() != Status::kNotFound) {
+            RANGE_LOG_ERROR("watch stream %" PRId64 " load key failed: %s", stream->Id(),
+                            ret.ToString().c_str());
+        }
+    } else {
+        std::string hashKey;
+        std::string firstKey(req.kv().key(0));
+        std::vector<std::string *> hashKeys{&firstKey};
+        watch::Watcher::EncodeKey(&hashKey, meta_.GetTableID(), hashKeys);
+
+        if (startVersion > 0) {
+            std::vector<watch::CEventBufferValue> changes;
+            count = eventBuffer->loadFromBuffer(hashKey, startVersion, changes).first;
+            for (int32_t i = 0; i < count; ++i) {
+                auto evt = resp->add_events();
+                for (decltype(changes[i].key().size()) k = 0; k < changes[i].key().size(); k++) {
+                    evt->mutable_kv()->add_key(changes[i].key(k));
+                }
+                evt->mutable_kv()->set_value(changes[i].value());
+                evt->mutable_kv()->set_version(changes[i].version());
+                evt->set_type(changes[i].type());
+            }
+        }
+
+        auto ws = context_->WatchServer()->GetWatcherSet_(hashKey);
+        if (count < 0) {
+            resp->clear_events();
+            count = ws->loadFromLog(store_.get(), stream->Key(), startVersion, ds_resp);
+        }
+
+        // 新建的流或者event buffer和变更日志里都没有startVersion之后的全部变化，全量加载
+        if (startVersion == 0 || count < 0) {
+            std::string endKey(stream->Key());
+            if (0 != WatchEncodeAndDecode::NextComparableBytes(stream->Key().data(), stream->Key().length(), endKey)) {
+                RANGE_LOG_ERROR("watch stream %" PRId64 " NextComparableBytes error.", stream->Id());
+                delete ds_resp;
+                return nullptr;
+            }
+            resp->clear_events();
+            count = ws->loadFromDb(store_.get(), watchpb::PUT, stream->Key(), endKey, startVersion,
+                                   meta_.GetTableID(), ds_resp).first;
+        }
+
+        int64_t revision = 0;
+        for (const auto &evt : resp->events()) {
+            revision = std::max(revision, evt.kv().version());
+        }
+        resp->set_revision(revision);
+    }
+
+    if (count <= 0) {
+        delete ds_resp;
+        return nullptr;
+    }
+    return ds_resp;
+}
+
 void Range::PureGet(common::ProtoMessage *msg, watchpb::DsKvWatchGetMultiRequest &req) {
     errorpb::Error *err = nullptr;
 
@@ -612,9 +760,15 @@ Status Range::ApplyWatchPut(const raft_cmdpb::Command &cmd, uint64_t raftIdx) {
             break;
         }
 
-        //save to db
+        //save to db, 同时追加变更日志
+        std::vector<storage::Store::WatchChange> changes(1);
+        changes[0].key = dbKey;
+        changes[0].value = dbValue;
+        changes[0].event.set_type(watchpb::PUT);
+        changes[0].event.mutable_kv()->CopyFrom(req.kv());
+
         auto btime = get_micro_second();
-        ret = store_->Put(dbKey, dbValue);
+        ret = store_->WatchApply(version, changes, cmd.expire_at());
         context_->Statistics()->PushTime(monitor::HistogramType::kQWait,
                                        get_micro_second() - btime);
 
@@ -770,44 +924,45 @@ Status Range::ApplyWatchDel(const raft_cmdpb::Command &cmd, uint64_t raftIdx) {
 //                               ret.ToString().c_str(), EncodeToHexString(dbKey).c_str());
 //                    break;
 //                }
+    // 一次删除的所有key和变更日志在同一个batch里写入，revision相同
+    std::vector<storage::Store::WatchChange> changes(delKeys.size());
     std::vector<std::string*> vecKeys;
-    for(auto it : delKeys) {
-
-        auto btime = get_micro_second();
+    for (size_t i = 0; i < delKeys.size(); ++i) {
+        changes[i].key = delKeys[i];
+        changes[i].event.set_type(watchpb::DELETE);
 
-        ret = store_->Delete(it);
+        vecKeys.clear();
+        watch::Watcher::DecodeKey(vecKeys, delKeys[i]);
+        for(auto key:vecKeys) {
+            changes[i].event.mutable_kv()->add_key(*key);
+            delete key;
+        }
+    }
 
+    if (!delKeys.empty()) {
+        auto btime = get_micro_second();
+        ret = store_->WatchApply(version, changes, cmd.expire_at());
         context_->Statistics()->PushTime(monitor::HistogramType::kQWait,
                                        get_micro_second() - btime);
 
-        if (cmd.cmd_id().node_id() == node_id_ && delKeys[delKeys.size() - 1] == it) {
+        if (cmd.cmd_id().node_id() == node_id_) {
             auto resp = new watchpb::DsKvWatchDeleteResponse;
             resp->mutable_resp()->set_code(ret.code());
             ReplySubmit(cmd, resp, err, btime);
-
         } else if (err != nullptr) {
             delete err;
-            continue;
         }
 
         if (!ret.ok()) {
             FLOG_ERROR("ApplyWatchDel failed, code:%d, msg:%s , key:%s", ret.code(),
                        ret.ToString().c_str(), EncodeToHexString(dbKey).c_str());
-            continue;
+            return ret;
         }
+    }
 
-        FLOG_DEBUG("store->Delete->ret.code:%s", ret.ToString().c_str());
-
+    for (const auto &change : changes) {
         notifyKv.clear_key();
-
-        vecKeys.clear();
-        watch::Watcher::DecodeKey(vecKeys, it);
-        for(auto key:vecKeys) {
-            notifyKv.add_key(*key);
-        }
-        for(auto key:vecKeys) {
-            delete key;
-        }
+        notifyKv.mutable_key()->CopyFrom(change.event.kv().key());
 
         //notify watcher
         int32_t retCnt(0);
@@ -894,14 +1049,26 @@ int32_t Range::WatchNotify(const watchpb::EventType evtType, const watchpb::Watc
     //start to send user kv to client
     int32_t watchCnt = vecNotifyWatcher.size();
     FLOG_DEBUG("single key notify:%" PRId32 " key:%s", watchCnt, EncodeToHexString(dbKey).c_str());
-    for(auto i = 0; i < watchCnt; i++) {
-        auto dsResp = new watchpb::DsWatchResponse;
-        auto resp = dsResp->mutable_resp();
-        auto evt = resp->add_events();
-        evt->set_allocated_kv(new  watchpb::WatchKeyValue(kv));
+    if (watchCnt > 0) {
+        // 同一个key和版本的通知内容都一样，只编码一次
+        watchpb::DsWatchResponse dsResp;
+        auto evt = dsResp.mutable_resp()->add_events();
+        evt->mutable_kv()->CopyFrom(kv);
         evt->set_type(evtType);
+        auto body = watch::Watcher::EncodeNotify(dsResp);
 
-        SendNotify(vecNotifyWatcher[i], dsResp);
+        for(auto i = 0; i < watchCnt; i++) {
+            SendNotify(vecNotifyWatcher[i], body);
+        }
+    }
+
+    // 流式watch直接追加这一个事件，不用从event buffer里加载
+    watchpb::Event streamEvt;
+    streamEvt.set_type(evtType);
+    streamEvt.mutable_kv()->CopyFrom(kv);
+    auto streamCnt = watch_server->NotifyStreams(streamEvt, version, dbKey, hasPrefix ? &hashKey : nullptr);
+    if (streamCnt > 0) {
+        FLOG_DEBUG("stream notify:%" PRId32 " key:%s", streamCnt, EncodeToHexString(dbKey).c_str());
     }
 
     if(hasPrefix) {
@@ -911,9 +1078,23 @@ int32_t Range::WatchNotify(const watchpb::EventType evtType, const watchpb::Watc
         watchCnt = vecPrefixNotifyWatcher.size();
         FLOG_DEBUG("prefix key notify:%" PRId32 " key:%s", watchCnt, EncodeToHexString(dbKey).c_str());
 
+        // 起始版本和前缀相同的watcher收到的内容一样，只加载和编码一次
+        std::map<std::pair<int64_t, std::string>, watch::NotifyBody> notifyBodies;
         for( auto i = 0; i < watchCnt; i++) {
 
             int64_t startVersion(vecPrefixNotifyWatcher[i]->getKeyVersion());
+            std::string prefixKey;
+            watch::Watcher::EncodeKey(&prefixKey, meta_.GetTableID(), vecPrefixNotifyWatcher[i]->GetKeys(false));
+
+            auto bodyKey = std::make_pair(startVersion, prefixKey);
+            auto bodyIt = notifyBodies.find(bodyKey);
+            if (bodyIt != notifyBodies.end()) {
+                if (bodyIt->second != nullptr) {
+                    SendNotify(vecPrefixNotifyWatcher[i], bodyIt->second, true);
+                }
+                continue;
+            }
+
             auto dsResp = new watchpb::DsWatchResponse;
 
             std::vector<watch::CEventBufferValue> vecUpdKeys;
@@ -926,7 +1107,16 @@ int32_t Range::WatchNotify(const watchpb::EventType evtType, const watchpb::Watc
             RANGE_LOG_DEBUG("loadFromBuffer key:%s hit count[%" PRId32 "] version scope:%" PRId32 "---%" PRId32 " client_version:%" PRId64 ,
                             EncodeToHexString(hashKey).c_str(), memCnt, verScope.first, verScope.second, startVersion);
 
-            if (0 == memCnt) {
+            //event buffer里不够时先从变更日志追赶
+            int32_t logCnt(-1);
+            if (memCnt < 0) {
+                auto ws = watch_server->GetWatcherSet_(hashKey);
+                logCnt = ws->loadFromLog(store_.get(), prefixKey, startVersion, dsResp);
+                FLOG_DEBUG("notify %d/%" PRId32 " loadFromLog key:%s count:%" PRId32, i+1, watchCnt,
+                           EncodeToHexString(prefixKey).c_str(), logCnt);
+            }
+
+            if (0 == memCnt || 0 == logCnt) {
                 FLOG_ERROR("doudbt no changing, notify %d/%"
                                    PRId32
                                    " key:%s", i, watchCnt, EncodeToHexString(dbKey).c_str());
@@ -957,6 +1147,8 @@ int32_t Range::WatchNotify(const watchpb::EventType evtType, const watchpb::Watc
 
                 }
 
+            } else if (logCnt > 0) {
+                //已经从变更日志加载
             } else {
 
                 //get all from db
@@ -988,9 +1180,13 @@ int32_t Range::WatchNotify(const watchpb::EventType evtType, const watchpb::Watc
 
             }
 
-            if (hasPrefix && watchCnt > 0 && dsResp != nullptr) {
-                SendNotify(vecPrefixNotifyWatcher[i], dsResp, true);
+            watch::NotifyBody body;
+            if (dsResp != nullptr) {
+                body = watch::Watcher::EncodeNotify(*dsResp);
+                delete dsResp;
+                SendNotify(vecPrefixNotifyWatcher[i], body, true);
             }
+            notifyBodies.emplace(std::move(bodyKey), std::move(body));
 
         }
     }
@@ -1000,13 +1196,23 @@ int32_t Range::WatchNotify(const watchpb::EventType evtType, const watchpb::Watc
 
 int32_t Range::SendNotify( watch::WatcherPtr w, watchpb::DsWatchResponse *ds_resp, bool prefix)
 {
-    auto watch_server = context_->WatchServer();
     auto resp = ds_resp->mutable_resp();
-    auto w_id = w->GetWatcherId();
-
-    resp->set_watchid(w_id);
+    resp->set_watchid(w->GetWatcherId());
 
     w->Send(ds_resp);
+    return delNotifiedWatcher(w, prefix);
+}
+
+int32_t Range::SendNotify(watch::WatcherPtr w, const watch::NotifyBody &body, bool prefix)
+{
+    w->Send(body);
+    return delNotifiedWatcher(w, prefix);
+}
+
+int32_t Range::delNotifiedWatcher(watch::WatcherPtr w, bool prefix)
+{
+    auto watch_server = context_->WatchServer();
+    auto w_id = w->GetWatcherId();
 
     //delete watch
     watch::WatchCode del_ret = watch::WATCH_OK;
@@ -1036,6 +1242,13 @@ int32_t Range::SendNotify( watch::WatcherPtr w, watchpb::DsWatchResponse *ds_res
 }
 
 
+void Range::TrimWatchLog() {
+    auto s = store_->TrimWatchLog();
+    if (!s.ok()) {
+        RANGE_LOG_WARN("trim watch log failed: %s", s.ToString().c_str());
+    }
+}
+
 }  // namespace range
 }  // namespace dataserver
 }  // namespace sharkstore
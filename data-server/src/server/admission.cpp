@@ -0,0 +1,164 @@
+#include "admission.h"
+
+#include <math.h>
+#include <sstream>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "proto/gen/schpb.pb.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace server {
+
+using google::protobuf::internal::WireFormatLite;
+
+void QueueDelayControl::OnDequeue(int64_t sojourn, int64_t now) {
+    // 多个worker并发更新，近似值即可
+    auto ewma = ewma_delay_.load(std::memory_order_relaxed);
+    ewma_delay_.store(ewma + (sojourn - ewma) / 8, std::memory_order_relaxed);
+
+    if (ops_.target_us <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    if (sojourn < ops_.target_us) {
+        first_above_time_ = 0;
+        dropping_ = false;
+        return;
+    }
+
+    if (first_above_time_ == 0) {
+        first_above_time_ = now + ops_.interval_us;
+    } else if (!dropping_ && now >= first_above_time_) {
+        dropping_ = true;
+        // 刚退出丢弃状态不久又过载，沿用之前的丢弃频率
+        auto delta = drop_count_ - last_drop_count_;
+        if (delta > 1 && now - drop_next_ < 16 * ops_.interval_us) {
+            drop_count_ = delta;
+        } else {
+            drop_count_ = 1;
+        }
+        last_drop_count_ = drop_count_;
+        drop_next_ = now;
+    }
+}
+
+bool QueueDelayControl::Admit(int64_t now) {
+    if (!dropping_) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!dropping_ || now < drop_next_) {
+        return true;
+    }
+
+    ++drop_count_;
+    drop_next_ = now + static_cast<int64_t>(ops_.interval_us / sqrt(drop_count_));
+    return false;
+}
+
+bool ClusterQuota::Acquire(uint64_t cluster_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& inflight = inflight_[cluster_id];
+    if (inflight >= max_inflight_) {
+        return false;
+    }
+    ++inflight;
+    return true;
+}
+
+void ClusterQuota::Release(uint64_t cluster_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = inflight_.find(cluster_id);
+    if (it != inflight_.end() && --it->second <= 0) {
+        inflight_.erase(it);
+    }
+}
+
+int64_t ClusterQuota::Inflight(uint64_t cluster_id) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = inflight_.find(cluster_id);
+    return it == inflight_.end() ? 0 : it->second;
+}
+
+std::string AdmissionStats::ToString() const {
+    std::ostringstream ss;
+    ss << "shed: {queue_delay: " << shed_queue_delay;
+    ss << ", deadline: " << shed_deadline;
+    ss << ", quota: " << shed_quota;
+    ss << "}, expired: " << expired;
+    ss << ", queue_delay: {count: " << dequeued;
+    ss << ", avg: " << AvgQueueDelay() << "us";
+    ss << ", max: " << max_queue_delay << "us}";
+    return ss.str();
+}
+
+bool IsAdminFunc(uint16_t func_id) {
+    // 1000之后是master的管理请求(kFuncCreateRange等)
+    return func_id >= 1000;
+}
+
+bool PeekRequestHeader(const common::ProtoMessage *msg, kvrpcpb::RequestHeader *header) {
+    google::protobuf::io::CodedInputStream input(
+        reinterpret_cast<const uint8_t *>(msg->body.data()),
+        static_cast<int>(msg->body.size()));
+
+    const uint32_t header_tag =
+        WireFormatLite::MakeTag(1, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+    uint32_t tag = 0;
+    while ((tag = input.ReadTag()) != 0) {
+        if (tag != header_tag) {
+            if (!WireFormatLite::SkipField(&input, tag)) {
+                return false;
+            }
+            continue;
+        }
+
+        uint32_t length = 0;
+        if (!input.ReadVarint32(&length) ||
+            length > msg->body.size() - static_cast<size_t>(input.CurrentPosition())) {
+            return false;
+        }
+        auto limit = input.PushLimit(static_cast<int>(length));
+        bool ret = header->ParseFromCodedStream(&input) && input.ConsumedEntireMessage();
+        input.PopLimit(limit);
+        return ret;
+    }
+    return false;
+}
+
+google::protobuf::Message *NewServerBusyResponse(uint16_t func_id,
+                                                 const kvrpcpb::RequestHeader &header,
+                                                 const std::string &reason) {
+    auto err = new errorpb::Error;
+    err->set_message("server is busy: " + reason);
+    err->mutable_server_is_busy()->set_reason(reason);
+
+    // 管理请求的ResponseHeader里error是第2个字段，和数据请求的不同
+    // 各应答的第一个字段都是header，只填header时编码与具体的应答类型无关
+    if (IsAdminFunc(func_id)) {
+        auto resp = new schpb::CreateRangeResponse;
+        resp->mutable_header()->set_cluster_id(header.cluster_id());
+        resp->mutable_header()->set_allocated_error(err);
+        return resp;
+    }
+
+    auto resp = new kvrpcpb::DsKvRawGetResponse;
+    common::SetResponseHeader(header, resp->mutable_header(), err);
+    return resp;
+}
+
+void SendServerBusy(common::SocketSession *session, common::ProtoMessage *msg,
+                    const kvrpcpb::RequestHeader &header, const std::string &reason) {
+    auto resp = NewServerBusyResponse(msg->header.func_id, header, reason);
+    session->Send(msg, resp);
+}
+
+}  // namespace server
+}  // namespace dataserver
+}  // namespace sharkstore
@@ -0,0 +1,121 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/socket_message.h"
+#include "common/socket_session.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace server {
+
+// 入队时的准入控制，过载时尽早拒绝，返回可重试的ServerIsBusy
+//
+// 1) 排队时延(CoDel): 出队时统计排队时间，持续一个interval都超过target
+//    进入丢弃状态，之后按 interval/sqrt(count) 的间隔拒绝新请求，
+//    直到排队时间回落到target以下
+// 2) 截止时间: 剩余时间不够预期的排队时间，入队前直接拒绝
+// 3) 配额: 每个cluster_id在worker中(排队+执行)的请求数上限
+// 只针对数据请求，master的管理请求(创建/删除range等)不做准入控制
+
+struct QueueDelayOptions {
+    int64_t target_us = 0;    // 0: 不开启
+    int64_t interval_us = 0;
+};
+
+class QueueDelayControl {
+public:
+    QueueDelayControl() = default;
+    explicit QueueDelayControl(const QueueDelayOptions& ops) : ops_(ops) {}
+
+    QueueDelayControl(const QueueDelayControl&) = delete;
+    QueueDelayControl& operator=(const QueueDelayControl&) = delete;
+
+    void SetOptions(const QueueDelayOptions& ops) { ops_ = ops; }
+
+    // worker出队时调用，sojourn: 排队时间(us)
+    void OnDequeue(int64_t sojourn, int64_t now);
+
+    // 入队前调用，返回false表示应该拒绝
+    bool Admit(int64_t now);
+
+    bool Dropping() const { return dropping_; }
+
+    // 排队时间的滑动平均(us)，用于截止时间判断
+    int64_t EstimatedDelay() const { return ewma_delay_; }
+
+private:
+    QueueDelayOptions ops_;
+
+    std::atomic<bool> dropping_ = {false};
+    std::atomic<int64_t> ewma_delay_ = {0};
+
+    std::mutex mu_;
+    int64_t first_above_time_ = 0;
+    int64_t drop_next_ = 0;
+    uint32_t drop_count_ = 0;
+    uint32_t last_drop_count_ = 0;
+};
+
+class ClusterQuota {
+public:
+    // max_inflight为0不限制
+    explicit ClusterQuota(int64_t max_inflight = 0) : max_inflight_(max_inflight) {}
+
+    ClusterQuota(const ClusterQuota&) = delete;
+    ClusterQuota& operator=(const ClusterQuota&) = delete;
+
+    void SetLimit(int64_t max_inflight) { max_inflight_ = max_inflight; }
+    bool Enabled() const { return max_inflight_ > 0; }
+
+    bool Acquire(uint64_t cluster_id);
+    void Release(uint64_t cluster_id);
+
+    int64_t Inflight(uint64_t cluster_id) const;
+
+private:
+    int64_t max_inflight_ = 0;
+
+    mutable std::mutex mu_;
+    std::unordered_map<uint64_t, int64_t> inflight_;
+};
+
+struct AdmissionStats {
+    uint64_t shed_queue_delay = 0;  // CoDel拒绝
+    uint64_t shed_deadline = 0;     // 剩余时间不够排队
+    uint64_t shed_quota = 0;        // 超过cluster配额
+    uint64_t expired = 0;           // 出队时已过期丢弃
+
+    uint64_t dequeued = 0;
+    uint64_t total_queue_delay = 0;  // us
+    uint64_t max_queue_delay = 0;    // us
+
+    uint64_t TotalShed() const { return shed_queue_delay + shed_deadline + shed_quota; }
+    uint64_t AvgQueueDelay() const {
+        return dequeued == 0 ? 0 : total_queue_delay / dequeued;
+    }
+    std::string ToString() const;
+};
+
+// master的管理请求(func_id >= 1000)，应答是schpb的格式
+bool IsAdminFunc(uint16_t func_id);
+
+// 解析请求的RequestHeader(所有数据请求的第一个字段)，不解析请求体的其他部分
+bool PeekRequestHeader(const common::ProtoMessage *msg, kvrpcpb::RequestHeader *header);
+
+// 按请求类型生成ServerIsBusy应答，调用方释放
+google::protobuf::Message *NewServerBusyResponse(uint16_t func_id,
+                                                 const kvrpcpb::RequestHeader &header,
+                                                 const std::string &reason);
+
+// 回复ServerIsBusy，网关收到后退避重试; 会释放msg
+void SendServerBusy(common::SocketSession *session, common::ProtoMessage *msg,
+                    const kvrpcpb::RequestHeader &header, const std::string &reason);
+
+}  // namespace server
+}  // namespace dataserver
+}  // namespace sharkstore
@@ -21,6 +21,9 @@ void ds_worker_deal_callback(request_buff_t *request, void *args) {
     if (req != nullptr) {
         req->session_id = request->session_id;
         req->begin_time = get_micro_second();
+        req->trace.Set(sharkstore::monitor::TraceStage::kRecv, req->begin_time);
+        req->trace.msg_id = req->header.msg_id;
+        req->trace.func_id = req->header.func_id;
         req->expire_time = getticks();
 
         if (req->header.time_out > 0) {
@@ -39,7 +42,11 @@ void ds_worker_deal_callback(request_buff_t *request, void *args) {
 }
 
 void ds_send_done_callback(response_buff_t *response, void *args, int err) {
-    auto take_time = get_micro_second() - response->begin_time;
+    auto now = get_micro_second();
+    auto take_time = now - response->begin_time;
+    if (response->reply_time > 0) {
+        sharkstore::monitor::g_tracer.RecordSent(now - response->reply_time);
+    }
 
     FLOG_DEBUG("session_id: %" PRId64 ",task msgid: %" PRId64
                " execute take time: %" PRId64 " us",
@@ -24,6 +24,8 @@ public:
     common::SocketSession* SocketSession() override { return server_->socket_session; }
     range::RangeStats* Statistics() override { return server_->run_status; }
 	watch::WatchServer* WatchServer() override { return server_->range_server->watch_server_; }
+    range::LockExpirer* GetLockExpirer() override { return server_->range_server->lock_expirer(); }
+    storage::LegacyRanges* GetLegacyRanges() override { return server_->range_server->legacy_ranges(); }
 
     uint64_t GetFSUsagePercent() const override;
 
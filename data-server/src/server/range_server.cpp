@@ -1,5 +1,6 @@
 #include "range_server.h"
 
+#include <algorithm>
 #include <chrono>
 #include <future>
 #include <thread>
@@ -8,7 +9,6 @@
 #include <rocksdb/advanced_options.h>
 #include <rocksdb/cache.h>
 #include <rocksdb/table.h>
-#include <rocksdb/utilities/db_ttl.h>
 #include <rocksdb/utilities/blob_db/blob_db.h>
 #include <rocksdb/rate_limiter.h>
 #include <fastcommon/shared_func.h>
@@ -22,6 +22,7 @@
 #include "proto/gen/metapb.pb.h"
 #include "proto/gen/schpb.pb.h"
 #include "storage/metric.h"
+#include "storage/ttl.h"
 #include "run_status.h"
 
 #include "server.h"
@@ -39,6 +40,9 @@ int RangeServer::Init(ContextServer *context) {
 
     context_ = context;
 
+    // 老格式range的登记表，compaction filter要用，在打开数据db之前创建
+    legacy_ranges_ = std::make_shared<storage::LegacyRanges>();
+
     // 打开数据db
     if (OpenDB() != 0) {
         FLOG_ERROR("RangeServer Init error ...");
@@ -67,6 +71,21 @@ int RangeServer::Init(ContextServer *context) {
     }
     context_->meta_store = meta_store_;
 
+    if (checkValueFormat() != 0) {
+        return -1;
+    }
+
+    // 锁过期定时器，在range加载之前创建
+    lock_expirer_.reset(new range::LockExpirer(
+        [this](uint64_t range_id, std::vector<raft_cmdpb::ExpiredLock> &locks) {
+            auto range = Find(range_id);
+            if (range != nullptr) range->ExpireLocks(locks);
+        },
+        [this](uint64_t range_id) {
+            auto range = Find(range_id);
+            if (range != nullptr) range->LoadLockTable();
+        }));
+
     // 创建RangeContext
     range_context_.reset(new RangeContextImpl(context_));
 
@@ -90,11 +109,20 @@ int RangeServer::Init(ContextServer *context) {
 int RangeServer::Start() {
     FLOG_INFO("RangeServer Start begin ...");
 
-    range_heartbeat_ = std::thread(&RangeServer::Heartbeat, this);
+    if (ds_config.hb_config.range_batch) {
+        heartbeat_batcher_.reset(new master::RangeHeartbeatBatcher(
+            context_->master_worker, ds_config.hb_config.range_full_rounds));
+        range_heartbeat_ = std::thread(&RangeServer::BatchHeartbeat, this);
+    } else {
+        range_heartbeat_ = std::thread(&RangeServer::Heartbeat, this);
+    }
 
     auto handle = range_heartbeat_.native_handle();
     AnnotateThread(handle, "range_hb");
 
+    watch_log_gc_ = std::thread(&RangeServer::WatchLogGC, this);
+    AnnotateThread(watch_log_gc_.native_handle(), "watch_log_gc");
+
     char name[32] = {'\0'};
     for (int i = 0; i < ds_config.range_config.worker_threads; i++) {
         worker_.emplace_back([this] {
@@ -137,6 +165,7 @@ void RangeServer::Stop() {
 
     queue_cond_.notify_all();
     statis_cond_.notify_all();
+    watch_log_gc_cond_.notify_all();
 
     for (auto &work : worker_) {
         if (work.joinable()) {
@@ -148,6 +177,14 @@ void RangeServer::Stop() {
         range_heartbeat_.join();
     }
 
+    if (watch_log_gc_.joinable()) {
+        watch_log_gc_.join();
+    }
+
+    if (lock_expirer_ != nullptr) {
+        lock_expirer_->Stop();
+    }
+
     CloseDB();
 
     auto it = ranges_.begin();
@@ -267,31 +304,27 @@ int RangeServer::OpenDB() {
     rocksdb::Options ops;
     buildDBOptions(ops);
 
+    if (ds_config.rocksdb_config.ttl > 0) {
+        // blob db不支持compaction filter，过期的数据永远不会被回收
+        if (ds_config.rocksdb_config.storage_type == 1) {
+            FLOG_ERROR("rocksdb ttl is not supported with blob storage(storage_type=1)");
+            return -1;
+        }
+        FLOG_INFO("rocksdb default ttl: %d seconds", ds_config.rocksdb_config.ttl);
+    }
+
     if (ds_config.rocksdb_config.storage_type == 0){
-        if (ds_config.rocksdb_config.ttl == 0) {
-            auto ret = rocksdb::DB::Open(ops, db_path, &db_);
-            if (!ret.ok()) {
-                FLOG_ERROR("open rocksdb(%s) failed(%s)", db_path.c_str(),
-                           ret.ToString().c_str());
-                return -1;
-            }
-        } else if (ds_config.rocksdb_config.ttl > 0) {
-            FLOG_WARN("rocksdb ttl enabled. ttl=%d", ds_config.rocksdb_config.ttl);
-            rocksdb::DBWithTTL *ttl_db = nullptr;
-            auto ret =
-                rocksdb::DBWithTTL::Open(ops, db_path, &ttl_db, ds_config.rocksdb_config.ttl);
-            if (!ret.ok()) {
-                FLOG_ERROR("open rocksdb(%s) failed(%s)", db_path.c_str(),
-                           ret.ToString().c_str());
-                return -1;
-            } else {
-                db_ = ttl_db;
-            }
-        } else {
-            FLOG_ERROR("invalid rocksdb ttl(%d)", ds_config.rocksdb_config.ttl);
+        // 过期时间记录在value头部，compaction时删除过期的数据
+        ops.compaction_filter_factory =
+            std::make_shared<storage::ExpiredFilterFactory>(legacy_ranges_);
+        auto ret = rocksdb::DB::Open(ops, db_path, &db_);
+        if (!ret.ok()) {
+            FLOG_ERROR("open rocksdb(%s) failed(%s)", db_path.c_str(),
+                       ret.ToString().c_str());
             return -1;
         }
     } else if (ds_config.rocksdb_config.storage_type == 1) {
+        // blob db不支持compaction filter，不记录过期时间(见storage::ExpireSupported)
         rocksdb::blob_db::BlobDBOptions bops;
         assert(ds_config.rocksdb_config.min_blob_size >= 0);
         bops.min_blob_size = static_cast<uint64_t>(ds_config.rocksdb_config.min_blob_size);
@@ -334,6 +367,54 @@ int RangeServer::OpenDB() {
     return 0;
 }
 
+int RangeServer::checkValueFormat() {
+    int format = 0;
+    auto ret = meta_store_->GetValueFormat(&format);
+    if (!ret.ok()) {
+        FLOG_ERROR("load value format from meta failed(%s)", ret.ToString().c_str());
+        return -1;
+    }
+    if (format != storage::kValueFormatExpireHeader) {
+        // 老版本写入的value没有头部，把已有的range都记为老格式
+        // 先记录range再记录格式，中途重启时会重新记录一遍
+        std::vector<metapb::Range> range_metas;
+        ret = meta_store_->GetAllRange(&range_metas);
+        if (!ret.ok()) {
+            FLOG_ERROR("load range metas failed(%s)", ret.ToString().c_str());
+            return -1;
+        }
+        std::vector<uint64_t> range_ids;
+        for (const auto& meta : range_metas) {
+            range_ids.push_back(meta.id());
+        }
+        if (!range_ids.empty()) {
+            ret = meta_store_->AddLegacyRanges(range_ids);
+            if (!ret.ok()) {
+                FLOG_ERROR("save legacy ranges to meta failed(%s)", ret.ToString().c_str());
+                return -1;
+            }
+            FLOG_WARN("upgrade value format from %d to %d, %lu ranges keep the legacy format",
+                      format, storage::kValueFormatExpireHeader, range_ids.size());
+        }
+        ret = meta_store_->SaveValueFormat(storage::kValueFormatExpireHeader);
+        if (!ret.ok()) {
+            FLOG_ERROR("save value format to meta failed(%s)", ret.ToString().c_str());
+            return -1;
+        }
+    }
+
+    std::vector<uint64_t> legacy_ids;
+    ret = meta_store_->GetLegacyRanges(&legacy_ids);
+    if (!ret.ok()) {
+        FLOG_ERROR("load legacy ranges from meta failed(%s)", ret.ToString().c_str());
+        return -1;
+    }
+    for (auto id : legacy_ids) {
+        legacy_ranges_->Add(id);
+    }
+    return 0;
+}
+
 void RangeServer::CloseDB() {
     if (db_ != nullptr) {
         delete db_;
@@ -600,6 +681,10 @@ Status RangeServer::DeleteRange(uint64_t range_id, uint64_t peer_id) {
         } else {
             ranges_.erase(it);
         }
+        if (legacy_ranges_->Contains(range_id)) {
+            meta_store_->DelLegacyRange(range_id);
+            legacy_ranges_->Remove(range_id);
+        }
     } while (false);
 
     FLOG_INFO("delete range[%" PRIu64 "] success.", range_id);
@@ -694,7 +779,10 @@ void RangeServer::ReplaceRange(common::ProtoMessage *msg) {
         }
 
         std::unique_lock<sharkstore::shared_mutex> lock(rw_lock_);
-        auto ret = CreateRange(req.new_range());
+        auto ret = inheritLegacyFormat(req.old_range_id(), req.new_range().id());
+        if (ret.ok()) {
+            ret = CreateRange(req.new_range());
+        }
         if (!ret.ok()) {
             auto err = resp->mutable_header()->mutable_error();
             err->set_message("create range failed");
@@ -778,6 +866,34 @@ size_t RangeServer::GetRangesSize() const {
     return ranges_.size();
 }
 
+void RangeServer::TopRangeMetrics(size_t k, std::vector<RangeMetric> *top_read,
+                                  std::vector<RangeMetric> *top_write) {
+    std::vector<RangeMetric> metrics;
+    {
+        sharkstore::shared_lock<sharkstore::shared_mutex> lock(rw_lock_);
+        metrics.reserve(ranges_.size());
+        for (const auto &it : ranges_) {
+            if (!it.second->IsLeader()) continue;
+            RangeMetric m;
+            m.range_id = static_cast<uint64_t>(it.first);
+            it.second->LastMetric(&m.stat);
+            metrics.push_back(m);
+        }
+    }
+
+    auto top = [k, &metrics](std::vector<RangeMetric> *result,
+                             uint64_t storage::MetricStat::*field) {
+        auto n = std::min(k, metrics.size());
+        std::partial_sort(metrics.begin(), metrics.begin() + n, metrics.end(),
+                          [field](const RangeMetric &a, const RangeMetric &b) {
+                              return a.stat.*field > b.stat.*field;
+                          });
+        result->assign(metrics.begin(), metrics.begin() + n);
+    };
+    top(top_read, &storage::MetricStat::keys_read_per_sec);
+    top(top_write, &storage::MetricStat::keys_write_per_sec);
+}
+
 std::shared_ptr<range::Range> RangeServer::Find(uint64_t range_id) {
     sharkstore::shared_lock<sharkstore::shared_mutex> lock(rw_lock_);
 
@@ -984,7 +1100,8 @@ void RangeServer::LockWatch(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVSet(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvSetRequest req;
+    // 解析到msg的arena上，提交raft命令时可以直接转移给Command
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvSetRequest>();
     kvrpcpb::DsKvSetResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVSet", req, resp, msg);
@@ -994,7 +1111,7 @@ void RangeServer::KVSet(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVGet(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvGetRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvGetRequest>();
     kvrpcpb::DsKvGetResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVGet", req, resp, msg);
@@ -1004,7 +1121,7 @@ void RangeServer::KVGet(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVBatchSet(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvBatchSetRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvBatchSetRequest>();
     kvrpcpb::DsKvBatchSetResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVBatchSet", req, resp, msg);
@@ -1014,7 +1131,7 @@ void RangeServer::KVBatchSet(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVBatchGet(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvBatchGetRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvBatchGetRequest>();
     kvrpcpb::DsKvBatchGetResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVBatchGet", req, resp, msg);
@@ -1024,7 +1141,7 @@ void RangeServer::KVBatchGet(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVDelete(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvDeleteRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvDeleteRequest>();
     kvrpcpb::DsKvDeleteResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVDelete", req, resp, msg);
@@ -1034,7 +1151,7 @@ void RangeServer::KVDelete(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVBatchDelete(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvBatchDeleteRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvBatchDeleteRequest>();
     kvrpcpb::DsKvBatchDeleteResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVBatchDelete", req, resp, msg);
@@ -1044,7 +1161,7 @@ void RangeServer::KVBatchDelete(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVRangeDelete(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvRangeDeleteRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvRangeDeleteRequest>();
     kvrpcpb::DsKvRangeDeleteResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVRangeDelete", req, resp, msg);
@@ -1054,7 +1171,7 @@ void RangeServer::KVRangeDelete(common::ProtoMessage *msg) {
 }
 
 void RangeServer::KVScan(common::ProtoMessage *msg) {
-    kvrpcpb::DsKvScanRequest req;
+    auto &req = *msg->NewMessage<kvrpcpb::DsKvScanRequest>();
     kvrpcpb::DsKvScanResponse *resp;
 
     auto range = CheckAndDecodeRequest("KVScan", req, resp, msg);
@@ -1063,6 +1180,20 @@ void RangeServer::KVScan(common::ProtoMessage *msg) {
     }
 }
 
+Status RangeServer::inheritLegacyFormat(uint64_t from_range_id, uint64_t to_range_id) {
+    if (!legacy_ranges_->Contains(from_range_id) || legacy_ranges_->Contains(to_range_id)) {
+        return Status::OK();
+    }
+    auto ret = meta_store_->AddLegacyRanges({to_range_id});
+    if (!ret.ok()) {
+        FLOG_ERROR("range[%" PRIu64 "] save legacy format failed(%s)", to_range_id,
+                   ret.ToString().c_str());
+        return ret;
+    }
+    legacy_ranges_->Add(to_range_id);
+    return Status::OK();
+}
+
 Status RangeServer::SplitRange(uint64_t old_range_id, const raft_cmdpb::SplitRequest &req,
                   uint64_t raft_index) {
     auto rng = Find(old_range_id);
@@ -1073,7 +1204,15 @@ Status RangeServer::SplitRange(uint64_t old_range_id, const raft_cmdpb::SplitReq
     bool is_exist = false;
     {
         std::unique_lock<sharkstore::shared_mutex> lock(rw_lock_);
-        auto ret = CreateRange(req.new_range(), req.leader(), raft_index + 1);
+        // 老格式range分裂出的数据也是老格式，已经存在的range(可能已经收到快照)不用继承
+        Status ret;
+        if (ranges_.find(req.new_range().id()) == ranges_.end()) {
+            ret = inheritLegacyFormat(old_range_id, req.new_range().id());
+            if (!ret.ok()) {
+                return ret;
+            }
+        }
+        ret = CreateRange(req.new_range(), req.leader(), raft_index + 1);
         if (ret.code() == Status::kDuplicate) {
             FLOG_WARN("range[%" PRIu64 "] ApplySplit(new range: %" PRIu64 ") already exist.",
                       old_range_id, req.new_range().id());
@@ -1240,6 +1379,79 @@ void RangeServer::Heartbeat() {
     FLOG_INFO("RangeHeartBeat thread exit...");
 }
 
+void RangeServer::BatchHeartbeat() {
+    int interval = ds_config.hb_config.range_interval;
+    // 下一个周期内到期的range提前合并到本轮，使所有range逐渐对齐到同一个周期
+    time_t window = interval * 1000 / 2;
+    std::vector<uint64_t> range_ids;
+
+    while (g_continue_flag) {
+        range_ids.clear();
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (range_heartbeat_queue_.empty()) {
+                queue_cond_.wait_for(lock, std::chrono::seconds(interval));
+                continue;
+            }
+
+            time_t now = getticks();
+            auto first = range_heartbeat_queue_.top().first;
+            if (first > now) {
+                auto intval = std::chrono::milliseconds(first - now);
+                queue_cond_.wait_for(lock, intval);
+                continue;
+            }
+
+            while (!range_heartbeat_queue_.empty() &&
+                   range_heartbeat_queue_.top().first <= now + window) {
+                range_ids.push_back(range_heartbeat_queue_.top().second);
+                range_heartbeat_queue_.pop();
+            }
+        }
+
+        for (auto range_id : range_ids) {
+            auto range = Find(range_id);
+            mspb::RangeHeartbeatRequest req;
+            if (range != nullptr && range->CollectHeartbeat(&req)) {
+                heartbeat_batcher_->Add(std::move(req));
+            } else {
+                heartbeat_batcher_->Forget(range_id);
+            }
+        }
+        heartbeat_batcher_->Flush(context_->node_id);
+    }
+
+    FLOG_INFO("RangeHeartBeat thread exit...");
+}
+
+void RangeServer::WatchLogGC() {
+    // 保留时间的十分之一检查一次，最长一分钟
+    auto interval = std::min(std::max(ds_config.watch_config.change_log_retention / 10, 1), 60);
+    std::vector<std::shared_ptr<range::Range>> ranges;
+
+    while (g_continue_flag) {
+        {
+            std::unique_lock<std::mutex> lock(watch_log_gc_mutex_);
+            watch_log_gc_cond_.wait_for(lock, std::chrono::seconds(interval));
+        }
+        if (!g_continue_flag) break;
+
+        ranges.clear();
+        {
+            sharkstore::shared_lock<sharkstore::shared_mutex> lock(rw_lock_);
+            ranges.reserve(ranges_.size());
+            for (const auto &it : ranges_) {
+                ranges.push_back(it.second);
+            }
+        }
+        for (const auto &range : ranges) {
+            range->TrimWatchLog();
+        }
+    }
+
+    FLOG_INFO("WatchLogGC thread exit...");
+}
+
 void RangeServer::LeaderQueuePush(uint64_t leader, time_t expire) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
     range_heartbeat_queue_.emplace(expire, leader);
@@ -1358,6 +1570,19 @@ void RangeServer::CollectNodeHeartbeat(mspb::NodeHeartbeatRequest *req) {
     stats->set_keys_written(mstat.keys_write_per_sec);
     stats->set_bytes_written(mstat.bytes_write_per_sec);
 
+    // collect cpu usage of the thread pools
+    monitor::CpuSample cpu;
+    if (context_->run_status->GetCpuUsage(&cpu)) {
+        stats->set_cpu_usage(cpu.process_usage);
+        for (const auto& g : cpu.groups) {
+            auto tc = stats->add_thread_cpu();
+            tc->set_name(g.name);
+            tc->set_threads(g.threads);
+            tc->set_usage(g.usage);
+            tc->set_max(g.max);
+        }
+    }
+
     stats->set_is_busy(false);
 }
 
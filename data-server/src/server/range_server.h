@@ -15,9 +15,12 @@
 
 #include "base/shared_mutex.h"
 #include "base/status.h"
+#include "master/range_heartbeat_batcher.h"
 #include "master/task_handler.h"
+#include "range/lock_expirer.h"
 #include "range/range.h"
 #include "storage/meta_store.h"
+#include "storage/ttl.h"
 
 #include "server/context_server.h"
 #include "watch/watch_server.h"
@@ -44,8 +47,18 @@ public:
     void StatisPush(uint64_t range_id);
 
     storage::MetaStore *meta_store() { return meta_store_; }
+    range::LockExpirer *lock_expirer() { return lock_expirer_.get(); }
+    storage::LegacyRanges *legacy_ranges() { return legacy_ranges_.get(); }
 
     size_t GetRangesSize() const;
+
+    struct RangeMetric {
+        uint64_t range_id = 0;
+        storage::MetricStat stat;
+    };
+    // 按读/写的key速率取前k个leader range
+    void TopRangeMetrics(size_t k, std::vector<RangeMetric> *top_read,
+                         std::vector<RangeMetric> *top_write);
     std::shared_ptr<range::Range> Find(uint64_t range_id);
 
     void OnNodeHeartbeatResp(const mspb::NodeHeartbeatResponse &) override;
@@ -57,6 +70,12 @@ private:
     void buildDBOptions(rocksdb::Options& ops);
     int OpenDB();
     void CloseDB();
+    // 检查数据db的value格式，新建的db记录当前格式
+    // 升级前就有的range记为老格式，按老格式读写直到应用快照或者删除
+    int checkValueFormat();
+
+    // 新range的数据来自老格式的range时(分裂、替换)，也记为老格式
+    Status inheritLegacyFormat(uint64_t from_range_id, uint64_t to_range_id);
 
     Status recover(const metapb::Range& meta);
     int recover(const std::vector<metapb::Range> &metas);
@@ -125,6 +144,10 @@ private:  // admin
     int OfflineRange(uint64_t range_id);
 
     void Heartbeat();
+    // 合并所有到期range的心跳，一次发送给master
+    void BatchHeartbeat();
+    // 定期清理所有range的watch变更日志
+    void WatchLogGC();
 
 private:
     mutable shared_mutex rw_lock_;
@@ -144,11 +167,19 @@ private:
     std::vector<std::thread> worker_;
     std::thread range_heartbeat_;
 
+    std::mutex watch_log_gc_mutex_;
+    std::condition_variable watch_log_gc_cond_;
+    std::thread watch_log_gc_;
+    std::unique_ptr<master::RangeHeartbeatBatcher> heartbeat_batcher_;
+
     rocksdb::DB *db_ = nullptr;
     storage::MetaStore *meta_store_ = nullptr;
 
     ContextServer *context_ = nullptr;
     std::unique_ptr<range::RangeContext> range_context_;
+    std::unique_ptr<range::LockExpirer> lock_expirer_;
+    // 与compaction filter共享，所以用shared_ptr
+    std::shared_ptr<storage::LegacyRanges> legacy_ranges_;
 
 public:
     watch::WatchServer* watch_server_;
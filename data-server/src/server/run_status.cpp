@@ -11,6 +11,7 @@
 #include "frame/sf_logger.h"
 #include "frame/sf_util.h"
 #include "master/worker.h"
+#include "monitor/request_trace.h"
 
 #include "server.h"
 #include "worker.h"
@@ -21,6 +22,9 @@ namespace server {
 
 int RunStatus::Init(ContextServer *context) {
     context_ = context;
+
+    monitor::g_tracer.SetSlowThreshold(
+        static_cast<int64_t>(ds_config.metric_config.slow_trace_threshold) * 1000);
     return 0;
 }
 
@@ -50,8 +54,10 @@ void RunStatus::Stop() {
 void RunStatus::run() {
     while (g_continue_flag) {
         collectDiskUsage();
+        collectCpuUsage();
         printDBMetric();
         context_->worker->PrintQueueSize();
+        printAdmission();
         printStatistics();
 
         std::unique_lock<std::mutex> lock(mutex_);
@@ -102,11 +108,39 @@ void RunStatus::collectDiskUsage() {
     }
 }
 
+// 定时采集CPU使用率，第一次只记录基准
+void RunStatus::collectCpuUsage() {
+    monitor::CpuSample sample;
+    if (!cpu_sampler_.Sample(&sample)) {
+        return;
+    }
+
+    std::string groups;
+    for (const auto& g : sample.groups) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), " %s(%u)=%.1f/%.1f", g.name.c_str(), g.threads, g.usage,
+                 g.max);
+        groups += buf;
+    }
+    FLOG_INFO("cpu usage: system=%.1f%%, process=%.1f%%, cpus=%u, threads(total/max):%s",
+              sample.system_usage, sample.process_usage, sample.cpu_count, groups.c_str());
+}
+
 void RunStatus::printStatistics() {
     FLOG_INFO("\n%s", statistics_.ToString().c_str());
     statistics_.Reset();
 }
 
+void RunStatus::printAdmission() {
+    AdmissionStats stats;
+    context_->worker->CollectAdmissionStats(&stats);
+    if (stats.TotalShed() > 0 || stats.expired > 0) {
+        FLOG_WARN("worker admission: %s", stats.ToString().c_str());
+    } else {
+        FLOG_INFO("worker admission: %s", stats.ToString().c_str());
+    }
+}
+
 void RunStatus::printDBMetric() {
     assert(context_->rocks_db != nullptr);
     assert(context_->block_cache != nullptr);
@@ -124,20 +158,30 @@ void RunStatus::printDBMetric() {
 
     auto stat = context_->db_stats;
     if (stat) {
+        // ticker是累计值(metrics导出需要)，不再reset，日志里打印本周期的增量
         FLOG_INFO("rocksdb row-cache stats: hit=%" PRIu64 ", miss=%" PRIu64,
-                  stat->getAndResetTickerCount(rocksdb::ROW_CACHE_HIT),
-                  stat->getAndResetTickerCount(rocksdb::ROW_CACHE_MISS));
+                  tickerDelta(rocksdb::ROW_CACHE_HIT),
+                  tickerDelta(rocksdb::ROW_CACHE_MISS));
 
         FLOG_INFO("rocksdb block-cache stats: hit=%" PRIu64 ", miss=%" PRIu64,
-                  stat->getAndResetTickerCount(rocksdb::BLOCK_CACHE_HIT),
-                  stat->getAndResetTickerCount(rocksdb::BLOCK_CACHE_MISS));
+                  tickerDelta(rocksdb::BLOCK_CACHE_HIT),
+                  tickerDelta(rocksdb::BLOCK_CACHE_MISS));
 
-        FLOG_INFO("rockdb get histograms: %s", stat->getHistogramString(rocksdb::DB_GET).c_str());
-        FLOG_INFO("rockdb write histograms: %s", stat->getHistogramString(rocksdb::DB_WRITE).c_str());
-        stat->Reset();
+        FLOG_INFO("rockdb get histograms(since start): %s",
+                  stat->getHistogramString(rocksdb::DB_GET).c_str());
+        FLOG_INFO("rockdb write histograms(since start): %s",
+                  stat->getHistogramString(rocksdb::DB_WRITE).c_str());
     }
 }
 
+uint64_t RunStatus::tickerDelta(uint32_t ticker) {
+    auto current = context_->db_stats->getTickerCount(ticker);
+    auto& last = last_db_tickers_[ticker];
+    auto delta = current - last;
+    last = current;
+    return delta;
+}
+
 
 }  // namespace server
 }  // namespace dataserver
@@ -3,12 +3,14 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <string>
 
 #include "common/socket_client.h"
 #include "frame/sf_status.h"
 #include "monitor/isystemstatus.h"
+#include "monitor/proc_sampler.h"
 #include "monitor/syscommon.h"
 #include "monitor/statistics.h"
 #include "range/stats.h"
@@ -51,21 +53,32 @@ public:
     void DecrSplitCount() override { --split_count_; }
     uint64_t GetSplitCount() const { return split_count_; }
 
+    const monitor::Statistics& GetStatistics() const { return statistics_; }
+
+    // 最近一个统计周期的CPU使用率，包括按线程名分组的各个线程池
+    bool GetCpuUsage(monitor::CpuSample* sample) const { return cpu_sampler_.Last(sample); }
+
 private:
     void run();
     void collectDiskUsage();
+    void collectCpuUsage();
     void printStatistics();
     void printDBMetric();
+    void printAdmission();
+    uint64_t tickerDelta(uint32_t ticker);
 
 private:
     ContextServer *context_ = nullptr;
 
     monitor::ISystemStatus system_status_;
     monitor::Statistics statistics_;
+    monitor::ProcSampler cpu_sampler_;
 
     std::atomic<uint64_t> fs_usage_percent_ = {0};
     std::atomic<uint64_t> split_count_ = {0};
 
+    std::map<uint32_t, uint64_t> last_db_tickers_;
+
     std::set<uint64_t> leaders_;
     mutable std::mutex leaders_mu_;
 
@@ -3,6 +3,7 @@
 #include <common/ds_config.h>
 #include <iostream>
 
+#include "base/util.h"
 #include "common/ds_config.h"
 #include "common/socket_session_impl.h"
 
@@ -66,10 +67,35 @@ bool DataServer::startRaftServer() {
     ops.apply_queue_capacity = ds_config.raft_config.apply_queue;
     ops.tick_interval = std::chrono::milliseconds(ds_config.raft_config.tick_interval_ms);
     ops.max_size_per_msg = ds_config.raft_config.max_msg_size;
+    ops.entry_cache_capacity = ds_config.raft_config.entry_cache_size;
+    ops.max_inflight_bytes = ds_config.raft_config.max_inflight_size;
+    ops.adaptive_inflight = ds_config.raft_config.adaptive_inflight != 0;
+    ops.max_inflight_bytes_per_node = ds_config.raft_config.node_inflight_size;
+    ops.log_preallocate = ds_config.raft_config.log_preallocate != 0;
+    ops.log_recycle_path = JoinFilePath({ds_config.raft_config.log_path, "recycle"});
+    ops.log_recycle_files = ds_config.raft_config.log_recycle_files;
+    ops.log_disk_budget = ds_config.raft_config.log_disk_budget;
+    ops.rebalance_interval = std::chrono::seconds(ds_config.raft_config.rebalance_interval);
+    ops.enable_rebalance =
+        ds_config.raft_config.rebalance != 0 && ds_config.raft_config.rebalance_interval > 0;
+    ops.rebalance_busy_percent =
+        static_cast<unsigned>(ds_config.raft_config.rebalance_busy_percent);
+    ops.rebalance_imbalance_percent =
+        static_cast<unsigned>(ds_config.raft_config.rebalance_imbalance_percent);
 
     ops.transport_options.listen_port = static_cast<uint16_t>(ds_config.raft_config.port);
     ops.transport_options.send_io_threads = ds_config.raft_config.transport_send_threads;
     ops.transport_options.recv_io_threads = ds_config.raft_config.transport_recv_threads;
+    ops.transport_options.use_io_uring =
+        ds_config.raft_config.transport_io_backend == SF_IO_URING;
+    if (!raft::ParseCompressionType(ds_config.raft_config.transport_compression,
+                                    &ops.transport_options.compression)) {
+        FLOG_ERROR("invalid raft transport_compression: %s",
+                   ds_config.raft_config.transport_compression);
+        return false;
+    }
+    ops.transport_options.compression_threshold =
+        ds_config.raft_config.compression_threshold;
     ops.transport_options.resolver =
         std::make_shared<NodeAddress>(context_->master_worker);
 
@@ -34,6 +34,15 @@ int Worker::Init(ContextServer *context) {
 
     context_ = context;
 
+    // 慢队列的请求本身执行时间长，排队时延目标单独配置
+    QueueDelayOptions delay_ops;
+    delay_ops.target_us = ds_config.admission_config.queue_delay_target * 1000;
+    delay_ops.interval_us = ds_config.admission_config.queue_delay_interval * 1000;
+    fast_queue_.delay_control.SetOptions(delay_ops);
+    delay_ops.target_us = ds_config.admission_config.slow_queue_delay_target * 1000;
+    slow_queue_.delay_control.SetOptions(delay_ops);
+    cluster_quota_.SetLimit(ds_config.admission_config.cluster_max_inflight);
+
     FLOG_INFO("Worker Init end ...");
     return 0;
 }
@@ -47,22 +56,25 @@ void Worker::StartWorker(std::vector<std::thread> &worker,
         hash_queue.msg_queue[i] = mq;
 
         worker.emplace_back([&, mq] {
-            int batch_count = 10;
-            common::ProtoMessage *task;
+            QueueItem item;
 
             while (g_continue_flag) {
-                task = nullptr;
-                if (mq->msg_queue.wait_dequeue_timed(
-                        task, std::chrono::milliseconds(100))) {
+                if (mq->Pop(&item, std::chrono::milliseconds(100))) {
+                    --hash_queue.all_msg_size;
                     if (!g_continue_flag) {
-                        delete task;
+                        Release(item);
+                        delete item.msg;
                         break;
                     }
 
-                    if (task != nullptr) {
-                        --hash_queue.all_msg_size;
-                        DealTask(task);
-                    }
+                    auto now = get_micro_second();
+                    auto delay = now - item.enqueue_time;
+                    hash_queue.delay_control.OnDequeue(delay, now);
+                    RecordQueueDelay(delay);
+                    item.msg->trace.Set(monitor::TraceStage::kDequeue, now);
+
+                    DealTask(item.msg);
+                    Release(item);
                 }
             }
 
@@ -152,27 +164,122 @@ void Worker::Push(common::ProtoMessage *task) {
 
     int type = FuncType(task);
 
-    if (type == 0) {
-        auto slot = ++slot_seed_ % ds_config.fast_worker_num;
-        auto mq = fast_queue_.msg_queue[slot];
+    HashQueue &hash_queue = type == 0 ? fast_queue_ : slow_queue_;
+    int worker_num = type == 0 ? ds_config.fast_worker_num : ds_config.slow_worker_num;
+
+    QueueItem item;
+    if (!Admit(task, hash_queue, &item)) {
+        return;
+    }
+
+    auto slot = ++slot_seed_ % worker_num;
+    auto mq = hash_queue.msg_queue[slot];
 
-        mq->msg_queue.enqueue(task);
+    ++hash_queue.all_msg_size;
+    mq->Push(item);
+}
+
+bool Worker::Admit(common::ProtoMessage *task, HashQueue &hash_queue, QueueItem *item) {
+    auto now = get_micro_second();
+
+    item->msg = task;
+    item->expire_time = task->expire_time;
+    item->enqueue_time = now;
+
+    // master的管理请求不拒绝，只对数据请求做准入控制
+    if (IsAdminFunc(task->header.func_id)) {
+        return true;
+    }
+
+    // 剩余时间不够排队，不用等到出队再发现超时
+    auto remain = (task->expire_time - getticks()) * 1000;
+    if (remain <= hash_queue.delay_control.EstimatedDelay()) {
+        ++admission_counter_.shed_deadline;
+        Reject(task, nullptr, "deadline");
+        return false;
+    }
+
+    if (!hash_queue.delay_control.Admit(now)) {
+        ++admission_counter_.shed_queue_delay;
+        Reject(task, nullptr, "queue delay");
+        return false;
+    }
+
+    if (cluster_quota_.Enabled()) {
+        kvrpcpb::RequestHeader header;
+        if (PeekRequestHeader(task, &header)) {
+            if (!cluster_quota_.Acquire(header.cluster_id())) {
+                ++admission_counter_.shed_quota;
+                Reject(task, &header, "cluster quota");
+                return false;
+            }
+            item->has_quota = true;
+            item->cluster_id = header.cluster_id();
+        }
+    }
+
+    return true;
+}
+
+void Worker::Reject(common::ProtoMessage *task, const kvrpcpb::RequestHeader *header,
+                    const char *reason) {
+    FLOG_DEBUG("reject msg_id %" PRIu64 ", func_id: %d: %s",
+               task->header.msg_id, task->header.func_id, reason);
+
+    kvrpcpb::RequestHeader req_header;
+    if (header == nullptr) {
+        PeekRequestHeader(task, &req_header);
+        header = &req_header;
+    }
+
+    SendServerBusy(context_->socket_session, task, *header, reason);
+}
 
-        ++fast_queue_.all_msg_size;
+void Worker::Release(const QueueItem &item) {
+    if (item.has_quota) {
+        cluster_quota_.Release(item.cluster_id);
+    }
+}
 
-    } else if (type == 1) {
-        auto slot = ++slot_seed_ % ds_config.slow_worker_num;
-        auto mq = slow_queue_.msg_queue[slot];
+void Worker::RecordQueueDelay(int64_t delay) {
+    if (delay < 0) delay = 0;
 
-        mq->msg_queue.enqueue(task);
+    ++admission_counter_.dequeued;
+    admission_counter_.total_queue_delay += delay;
 
-        ++slow_queue_.all_msg_size;
+    auto max = admission_counter_.max_queue_delay.load(std::memory_order_relaxed);
+    while (static_cast<uint64_t>(delay) > max &&
+           !admission_counter_.max_queue_delay.compare_exchange_weak(max, delay)) {
     }
 }
 
+void Worker::GetAdmissionStats(AdmissionStats *stats) const {
+    stats->shed_queue_delay = admission_counter_.shed_queue_delay;
+    stats->shed_deadline = admission_counter_.shed_deadline;
+    stats->shed_quota = admission_counter_.shed_quota;
+    stats->expired = admission_counter_.expired;
+    stats->dequeued = admission_counter_.dequeued;
+    stats->total_queue_delay = admission_counter_.total_queue_delay;
+}
+
+void Worker::CollectAdmissionStats(AdmissionStats *stats) {
+    // 计数器是累计值(metrics导出需要)，这里减去上次的值
+    AdmissionStats total;
+    GetAdmissionStats(&total);
+    stats->shed_queue_delay = total.shed_queue_delay - last_admission_.shed_queue_delay;
+    stats->shed_deadline = total.shed_deadline - last_admission_.shed_deadline;
+    stats->shed_quota = total.shed_quota - last_admission_.shed_quota;
+    stats->expired = total.expired - last_admission_.expired;
+    stats->dequeued = total.dequeued - last_admission_.dequeued;
+    stats->total_queue_delay = total.total_queue_delay - last_admission_.total_queue_delay;
+    stats->max_queue_delay = admission_counter_.max_queue_delay.exchange(0);
+    last_admission_ = total;
+}
+
 void Worker::DealTask(common::ProtoMessage *task) {
     if (task->expire_time < getticks()) {
         FLOG_ERROR("msg_id %" PRIu64 " is expired ", task->header.msg_id);
+        ++admission_counter_.expired;
         delete task;
         return;
     }
@@ -180,35 +287,64 @@ void Worker::DealTask(common::ProtoMessage *task) {
     DataServer::Instance().DealTask(task);
 }
 
-void Worker::Clean(HashQueue &hash_queue) {
+void Worker::MsgQueue::Push(QueueItem &item) {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        item.seq = ++seq;
+        items.push(item);
+    }
+    cond.notify_one();
+}
+
+bool Worker::MsgQueue::Pop(QueueItem *item, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mu);
+    if (!cond.wait_for(lock, timeout, [this] { return !items.empty(); })) {
+        return false;
+    }
+    *item = items.top();
+    items.pop();
+    return true;
+}
+
+bool Worker::MsgQueue::TryPop(QueueItem *item) {
+    std::lock_guard<std::mutex> lock(mu);
+    if (items.empty()) {
+        return false;
+    }
+    *item = items.top();
+    items.pop();
+    return true;
+}
+
+size_t Worker::Clear(HashQueue &hash_queue) {
+    size_t count = 0;
+    QueueItem item;
     for (auto mq : hash_queue.msg_queue) {
-        common::ProtoMessage *task = nullptr;
-        while (mq->msg_queue.try_dequeue(task)) {
-            delete task;
+        while (mq->TryPop(&item)) {
+            --hash_queue.all_msg_size;
+            Release(item);
+            delete item.msg;
+            ++count;
         }
+    }
+    return count;
+}
+
+void Worker::Clean(HashQueue &hash_queue) {
+    Clear(hash_queue);
+    for (auto mq : hash_queue.msg_queue) {
         delete mq;
     }
+    hash_queue.msg_queue.clear();
 }
 
 size_t Worker::ClearQueue(bool fast, bool slow) {
     size_t count = 0;
     if (fast) {
-        for (auto& q : fast_queue_.msg_queue) {
-            common::ProtoMessage *task;
-            while (q->msg_queue.try_dequeue(task)) {
-                delete task;
-                ++count;
-            }
-        }
+        count += Clear(fast_queue_);
     }
     if (slow) {
-        for (auto& q : slow_queue_.msg_queue) {
-            common::ProtoMessage *task;
-            while (q->msg_queue.try_dequeue(task)) {
-                delete task;
-                ++count;
-            }
-        }
+        count += Clear(slow_queue_);
     }
     return count;
 }
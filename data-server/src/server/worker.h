@@ -10,8 +10,8 @@
 #include "common/ds_config.h"
 #include "common/socket_server.h"
 #include "frame/sf_status.h"
-#include "lk_queue/blockingconcurrentqueue.h"
 
+#include "admission.h"
 #include "context_server.h"
 
 namespace sharkstore {
@@ -41,24 +41,71 @@ public:
     uint64_t FastQueueSize() const { return fast_queue_.all_msg_size; }
     uint64_t SlowQueueSize() const { return slow_queue_.all_msg_size; }
 
+    // 取出上次调用以来的准入统计，只能由一个线程调用
+    void CollectAdmissionStats(AdmissionStats *stats);
+    // 启动以来的累计准入统计(不含max_queue_delay)
+    void GetAdmissionStats(AdmissionStats *stats) const;
+
     // TODO:
     void GetPending() const {}
 
 private:
+    struct QueueItem {
+        int64_t expire_time = 0;
+        uint64_t seq = 0;
+        int64_t enqueue_time = 0;  // us
+        bool has_quota = false;
+        uint64_t cluster_id = 0;
+        common::ProtoMessage *msg = nullptr;
+    };
+
+    // 截止时间早的先出队，相同时按入队顺序
+    struct EarlierDeadline {
+        bool operator()(const QueueItem &a, const QueueItem &b) const {
+            if (a.expire_time != b.expire_time) return a.expire_time > b.expire_time;
+            return a.seq > b.seq;
+        }
+    };
 
     struct MsgQueue {
-        moodycamel::BlockingConcurrentQueue<common::ProtoMessage *> msg_queue;
+        std::mutex mu;
+        std::condition_variable cond;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, EarlierDeadline> items;
+        uint64_t seq = 0;
+
+        void Push(QueueItem &item);
+        bool Pop(QueueItem *item, std::chrono::milliseconds timeout);
+        bool TryPop(QueueItem *item);
     };
 
     struct HashQueue {
         std::vector<MsgQueue *> msg_queue;
         std::atomic<uint64_t> all_msg_size;
+        QueueDelayControl delay_control;
 
         HashQueue() : all_msg_size(0) {}
     };
 
+    struct AdmissionCounter {
+        std::atomic<uint64_t> shed_queue_delay = {0};
+        std::atomic<uint64_t> shed_deadline = {0};
+        std::atomic<uint64_t> shed_quota = {0};
+        std::atomic<uint64_t> expired = {0};
+        std::atomic<uint64_t> dequeued = {0};
+        std::atomic<uint64_t> total_queue_delay = {0};
+        std::atomic<uint64_t> max_queue_delay = {0};
+    };
+
     void DealTask(common::ProtoMessage *task);
     void Clean(HashQueue &hash_queue);
+    size_t Clear(HashQueue &hash_queue);
+
+    // 准入检查，拒绝时回复ServerIsBusy并返回false
+    bool Admit(common::ProtoMessage *task, HashQueue &hash_queue, QueueItem *item);
+    void Reject(common::ProtoMessage *task, const kvrpcpb::RequestHeader *header,
+                const char *reason);
+    void Release(const QueueItem &item);
+    void RecordQueueDelay(int64_t delay);
 
     void StartWorker(std::vector<std::thread> &worker, HashQueue & hash_queue, int num);
     // 0: fast queue; 1: slow queue; 2: thread queue
@@ -72,6 +119,10 @@ private:
     HashQueue fast_queue_;
     HashQueue slow_queue_;
 
+    ClusterQuota cluster_quota_;
+    AdmissionCounter admission_counter_;
+    AdmissionStats last_admission_;
+
     common::SocketServer socket_server_;
 
     sf_socket_status_t worker_status_ = {0};
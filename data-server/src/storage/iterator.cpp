@@ -1,24 +1,53 @@
 #include "iterator.h"
 
+#include "base/util.h"
+#include "ttl.h"
+
 namespace sharkstore {
 namespace dataserver {
 namespace storage {
 
 Iterator::Iterator(rocksdb::Iterator* it, const std::string& start,
-                   const std::string& limit)
-    : rit_(it), limit_(limit) {
+                   const std::string& limit, int64_t now, bool value_header)
+    : rit_(it), limit_(limit), now_(now), value_header_(value_header) {
     assert(!start.empty());
     assert(!limit.empty());
     rit_->Seek(start);
+    skipExpired();
 }
 
 Iterator::~Iterator() { delete rit_; }
 
-bool Iterator::Valid() { return rit_->Valid() && (key() < limit_); }
+bool Iterator::Valid() {
+    return status_.ok() && rit_->Valid() && rit_->key().compare(limit_) < 0;
+}
 
-void Iterator::Next() { rit_->Next(); }
+void Iterator::Next() {
+    rit_->Next();
+    skipExpired();
+}
+
+void Iterator::skipExpired() {
+    for (; rit_->Valid() && rit_->key().compare(limit_) < 0; rit_->Next()) {
+        if (!value_header_) {
+            value_ = rit_->value();
+            return;
+        }
+        if (!DecodeStoreValue(rit_->value(), &expire_at_, &value_)) {
+            status_ = Status(Status::kCorruption, "decode value header",
+                             EncodeToHex(rit_->key().ToString()));
+            return;
+        }
+        if (!IsExpired(expire_at_, now_)) {
+            return;
+        }
+    }
+}
 
 Status Iterator::status() {
+    if (!status_.ok()) {
+        return status_;
+    }
     if (!rit_->status().ok()) {
         return Status(Status::kIOError, rit_->status().ToString(), "");
     }
@@ -27,11 +56,11 @@ Status Iterator::status() {
 
 std::string Iterator::key() { return rit_->key().ToString(); }
 
-std::string Iterator::value() { return rit_->value().ToString(); }
+std::string Iterator::value() { return value_.ToString(); }
 
 uint64_t Iterator::key_size() { return rit_->key().size(); }
 
-uint64_t Iterator::value_size() { return rit_->value().size(); }
+uint64_t Iterator::value_size() { return value_.size(); }
 
 } /* namespace storage */
 } /* namespace dataserver */
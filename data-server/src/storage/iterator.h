@@ -7,12 +7,12 @@ namespace sharkstore {
 namespace dataserver {
 namespace storage {
 
-class Metric;
-
+// 遍历[start, limit)内的数据，跳过已过期的，value去掉了头部
+// value_header为false时是没有头部的老格式数据，原样返回
 class Iterator {
 public:
     Iterator(rocksdb::Iterator* it, const std::string& start,
-             const std::string& limit);
+             const std::string& limit, int64_t now, bool value_header = true);
     ~Iterator();
 
     bool Valid();
@@ -24,10 +24,20 @@ public:
 
     uint64_t key_size();
     uint64_t value_size();
+    // 当前数据的过期时间，0表示不过期
+    int64_t expire_at() const { return expire_at_; }
+
+private:
+    void skipExpired();
 
 private:
     rocksdb::Iterator* rit_ = nullptr;
     const std::string limit_;
+    const int64_t now_ = 0;
+    const bool value_header_ = true;
+    rocksdb::Slice value_;
+    int64_t expire_at_ = 0;
+    Status status_;
 };
 
 } /* namespace storage */
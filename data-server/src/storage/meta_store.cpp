@@ -65,6 +65,73 @@ Status MetaStore::GetNodeID(uint64_t *node_id) {
     }
 }
 
+Status MetaStore::SaveValueFormat(int format) {
+    auto ret = db_->Put(write_options_, kValueFormatKey, std::to_string(format));
+    if (ret.ok()) {
+        return Status::OK();
+    } else {
+        return Status(Status::kIOError, ret.ToString(), "meta save value format");
+    }
+}
+
+Status MetaStore::GetValueFormat(int *format) {
+    std::string value;
+    auto ret = db_->Get(rocksdb::ReadOptions(), kValueFormatKey, &value);
+    if (ret.ok()) {
+        try {
+            *format = std::stoi(value);
+        } catch (std::exception &e) {
+            return Status(Status::kCorruption, "invalid value format", EncodeToHex(value));
+        }
+        return Status::OK();
+    } else if (ret.IsNotFound()) {
+        *format = 0;
+        return Status::OK();
+    } else {
+        return Status(Status::kIOError, "meta load value format", ret.ToString());
+    }
+}
+
+Status MetaStore::AddLegacyRanges(const std::vector<uint64_t>& range_ids) {
+    rocksdb::WriteBatch batch;
+    for (auto id : range_ids) {
+        batch.Put(kLegacyRangePrefix + std::to_string(id), "");
+    }
+
+    rocksdb::WriteOptions wops;
+    wops.sync = true;
+    auto ret = db_->Write(wops, &batch);
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "meta add legacy ranges", ret.ToString());
+    }
+    return Status::OK();
+}
+
+Status MetaStore::DelLegacyRange(uint64_t range_id) {
+    auto ret = db_->Delete(write_options_, kLegacyRangePrefix + std::to_string(range_id));
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "meta delete legacy range", ret.ToString());
+    }
+    return Status::OK();
+}
+
+Status MetaStore::GetLegacyRanges(std::vector<uint64_t>* range_ids) {
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    for (it->Seek(kLegacyRangePrefix);
+         it->Valid() && it->key().starts_with(kLegacyRangePrefix); it->Next()) {
+        auto id = it->key().ToString().substr(kLegacyRangePrefix.size());
+        try {
+            range_ids->push_back(std::stoull(id));
+        } catch (std::exception &e) {
+            return Status(Status::kCorruption, "invalid legacy range id", EncodeToHex(id));
+        }
+    }
+    if (!it->status().ok()) {
+        return Status(Status::kIOError, "iterator", it->status().ToString());
+    }
+    return Status::OK();
+}
+
 Status MetaStore::SaveVersionID(const uint64_t &range_id, int64_t ver_id) {
     std::string keyRangeVer = kRangeVersionPrefix + std::to_string(range_id);
 
@@ -17,6 +17,8 @@ static const std::string kRangeMetaPrefix = "\x02";
 static const std::string kRangeApplyPrefix = "\x03";
 static const std::string kNodeIDKey = "\x04NodeID";
 static const std::string kRangeVersionPrefix = "\x05";
+static const std::string kValueFormatKey = "\x06ValueFormat";
+static const std::string kLegacyRangePrefix = "\x07";
 
 class MetaStore {
 public:
@@ -32,6 +34,14 @@ public:
     Status SaveNodeID(uint64_t node_id);
     Status GetNodeID(uint64_t* node_id);
 
+    // 数据db的value格式，没有记录时返回0
+    Status SaveValueFormat(int format);
+    Status GetValueFormat(int* format);
+    // 数据没有value头部的range(升级之前就有的)
+    Status AddLegacyRanges(const std::vector<uint64_t>& range_ids);
+    Status DelLegacyRange(uint64_t range_id);
+    Status GetLegacyRanges(std::vector<uint64_t>* range_ids);
+
     Status SaveVersionID(const uint64_t &range_id, int64_t ver_id);
     Status GetVersionID(const uint64_t &range_id, int64_t* ver_id);
 
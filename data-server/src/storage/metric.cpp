@@ -7,7 +7,7 @@ namespace sharkstore {
 namespace dataserver {
 namespace storage {
 
-Metric g_metric;
+GlobalMetric g_metric;
 
 std::string MetricStat::ToString() const {
     std::ostringstream ss;
@@ -20,18 +20,22 @@ std::string MetricStat::ToString() const {
     return ss.str();
 }
 
-Metric::Metric() : last_collect_(std::chrono::steady_clock::now()) {}
+template <class Counter>
+BasicMetric<Counter>::BasicMetric() : last_collect_(std::chrono::steady_clock::now()) {}
 
-Metric::~Metric() {}
+template <class Counter>
+BasicMetric<Counter>::~BasicMetric() {}
 
-void Metric::AddRead(uint64_t keys, uint64_t bytes) {
-    keys_read_counter_ += keys;
-    bytes_read_counter_ += bytes;
+template <class Counter>
+void BasicMetric<Counter>::AddRead(uint64_t keys, uint64_t bytes) {
+    keys_read_counter_.Add(keys);
+    bytes_read_counter_.Add(bytes);
 }
 
-void Metric::AddWrite(uint64_t keys, uint64_t bytes) {
-    keys_write_counter_ += keys;
-    bytes_write_counter_ += bytes;
+template <class Counter>
+void BasicMetric<Counter>::AddWrite(uint64_t keys, uint64_t bytes) {
+    keys_write_counter_.Add(keys);
+    bytes_write_counter_.Add(bytes);
 }
 
 static uint64_t calculateOps(uint64_t val, uint64_t elapsed_ms) {
@@ -39,16 +43,23 @@ static uint64_t calculateOps(uint64_t val, uint64_t elapsed_ms) {
                                  static_cast<double>(elapsed_ms) * 1000);
 }
 
-void Metric::Reset() {
+template <class Counter>
+void BasicMetric<Counter>::Reset() {
     last_collect_ = std::chrono::steady_clock::now();
 
-    keys_read_counter_ = 0;
-    keys_write_counter_ = 0;
-    bytes_read_counter_ = 0;
-    bytes_write_counter_ = 0;
+    keys_read_counter_.Exchange();
+    keys_write_counter_.Exchange();
+    bytes_read_counter_.Exchange();
+    bytes_write_counter_.Exchange();
+
+    last_keys_read_ = 0;
+    last_keys_write_ = 0;
+    last_bytes_read_ = 0;
+    last_bytes_write_ = 0;
 }
 
-void Metric::Collect(MetricStat* stat) {
+template <class Counter>
+void BasicMetric<Counter>::Collect(MetricStat* stat) {
     assert(stat != nullptr);
 
     auto now = std::chrono::steady_clock::now();
@@ -58,18 +69,37 @@ void Metric::Collect(MetricStat* stat) {
     if (elasped_ms <= 0) return;
 
     stat->keys_read_per_sec =
-        calculateOps(keys_read_counter_.exchange(0), elasped_ms);
+        calculateOps(keys_read_counter_.Exchange(), elasped_ms);
     stat->keys_write_per_sec =
-        calculateOps(keys_write_counter_.exchange(0), elasped_ms);
+        calculateOps(keys_write_counter_.Exchange(), elasped_ms);
     stat->bytes_read_per_sec =
-        calculateOps(bytes_read_counter_.exchange(0), elasped_ms);
+        calculateOps(bytes_read_counter_.Exchange(), elasped_ms);
     stat->bytes_write_per_sec =
-        calculateOps(bytes_write_counter_.exchange(0), elasped_ms);
+        calculateOps(bytes_write_counter_.Exchange(), elasped_ms);
 
     last_collect_ = now;
+
+    last_keys_read_.store(stat->keys_read_per_sec, std::memory_order_relaxed);
+    last_keys_write_.store(stat->keys_write_per_sec, std::memory_order_relaxed);
+    last_bytes_read_.store(stat->bytes_read_per_sec, std::memory_order_relaxed);
+    last_bytes_write_.store(stat->bytes_write_per_sec, std::memory_order_relaxed);
+}
+
+template <class Counter>
+void BasicMetric<Counter>::LastStat(MetricStat* stat) const {
+    stat->keys_read_per_sec = last_keys_read_.load(std::memory_order_relaxed);
+    stat->keys_write_per_sec = last_keys_write_.load(std::memory_order_relaxed);
+    stat->bytes_read_per_sec = last_bytes_read_.load(std::memory_order_relaxed);
+    stat->bytes_write_per_sec = last_bytes_write_.load(std::memory_order_relaxed);
+}
+
+template <class Counter>
+void BasicMetric<Counter>::CollectAll(MetricStat* stat) {
+    g_metric.Collect(stat);
 }
 
-void Metric::CollectAll(MetricStat* stat) { g_metric.Collect(stat); }
+template class BasicMetric<AtomicCounter>;
+template class BasicMetric<monitor::CoreLocalCounter>;
 
 }  // namespace storage
 }  // namespace dataserver
@@ -4,6 +4,8 @@ _Pragma("once");
 #include <chrono>
 #include <string>
 
+#include "monitor/core_local.h"
+
 namespace sharkstore {
 namespace dataserver {
 namespace storage {
@@ -17,10 +19,22 @@ struct MetricStat {
     std::string ToString() const;
 };
 
-class Metric {
+// range级别的计数，同时访问一个range的线程不多，直接用原子变量
+class AtomicCounter {
+public:
+    void Add(uint64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Exchange() { return value_.exchange(0); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// Counter需要提供Add和Exchange(取出并清零)
+template <class Counter>
+class BasicMetric {
 public:
-    Metric();
-    ~Metric();
+    BasicMetric();
+    ~BasicMetric();
 
     void AddRead(uint64_t keys, uint64_t bytes);
     void AddWrite(uint64_t keys, uint64_t bytes);
@@ -30,21 +44,36 @@ public:
     // should only called by one thread
     void Collect(MetricStat* stat);
 
+    // 最近一次Collect的结果，可以并发调用
+    void LastStat(MetricStat* stat) const;
+
     // collect gobal metric
     static void CollectAll(MetricStat* stat);
 
 private:
     using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
 
-    std::atomic<uint64_t> keys_read_counter_{0};
-    std::atomic<uint64_t> keys_write_counter_{0};
-    std::atomic<uint64_t> bytes_read_counter_{0};
-    std::atomic<uint64_t> bytes_write_counter_{0};
+    Counter keys_read_counter_;
+    Counter keys_write_counter_;
+    Counter bytes_read_counter_;
+    Counter bytes_write_counter_;
 
     TimePoint last_collect_;
+
+    std::atomic<uint64_t> last_keys_read_{0};
+    std::atomic<uint64_t> last_keys_write_{0};
+    std::atomic<uint64_t> last_bytes_read_{0};
+    std::atomic<uint64_t> last_bytes_write_{0};
 };
 
-extern Metric g_metric;
+using Metric = BasicMetric<AtomicCounter>;
+// 节点级别的计数，所有线程都会更新，按cpu分片避免竞争
+using GlobalMetric = BasicMetric<monitor::CoreLocalCounter>;
+
+extern template class BasicMetric<AtomicCounter>;
+extern template class BasicMetric<monitor::CoreLocalCounter>;
+
+extern GlobalMetric g_metric;
 
 }  // namespace storage
 }  // namespace dataserver
@@ -64,6 +64,10 @@ RowDecoder::RowDecoder(
 
 RowDecoder::~RowDecoder() {}
 
+void RowDecoder::AddColumn(const metapb::Column& col) {
+    cols_.emplace(col.id(), col);
+}
+
 static Status decodePK(const std::string& key, size_t& offset, const metapb::Column& col,
                        FieldValue** value) {
     switch (col.data_type()) {
@@ -270,8 +274,8 @@ Status RowDecoder::Decode(const std::string& key, const std::string& buf, RowRes
     return Status::OK();
 }
 
-static Status parseThreshold(const std::string& thres, const metapb::Column& col,
-                             std::unique_ptr<FieldValue>* value) {
+Status ParseThreshold(const std::string& thres, const metapb::Column& col,
+                      std::unique_ptr<FieldValue>* value) {
     switch (col.data_type()) {
         case metapb::Tinyint:
         case metapb::Smallint:
@@ -317,7 +321,7 @@ static bool filter(const RowResult& result, const std::vector<kvrpcpb::Match>& f
             return false;
         }
         std::unique_ptr<FieldValue> cf = nullptr;
-        auto s = parseThreshold(m.threshold(), m.column(), &cf);
+        auto s = ParseThreshold(m.threshold(), m.column(), &cf);
         if (!s.ok()) {
             FLOG_ERROR("select parse threshold failed: %s", s.ToString().c_str());
             return false;
@@ -1,6 +1,7 @@
 _Pragma("once");
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "base/status.h"
@@ -49,6 +50,9 @@ public:
 
     ~RowDecoder();
 
+    // 额外需要解码的列（比如order by的列不一定在select列里）
+    void AddColumn(const metapb::Column& col);
+
     RowDecoder(const RowDecoder&) = delete;
     RowDecoder& operator=(const RowDecoder&) = delete;
 
@@ -69,6 +73,10 @@ private:
     std::vector<kvrpcpb::Match> filters_;
 };
 
+// 按列类型解析where条件中的阈值
+Status ParseThreshold(const std::string& thres, const metapb::Column& col,
+                      std::unique_ptr<FieldValue>* value);
+
 } /* namespace storage */
 } /* namespace dataserver */
 } /* namespace sharkstore */
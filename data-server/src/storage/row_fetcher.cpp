@@ -10,17 +10,21 @@ namespace dataserver {
 namespace storage {
 
 static const size_t kIteratorTooManyKeys = 1000;
+static const size_t kIndexFetchBatchSize = 128;
 
 RowFetcher::RowFetcher(Store& s, const kvrpcpb::SelectRequest& req)
     : store_(s),
       decoder_(s.GetPrimaryKeys(), req.field_list(), req.where_filters()) {
-    init(req.key(), req.scope());
+    for (const auto& order_by : req.order_bys()) {
+        decoder_.AddColumn(order_by.column());
+    }
+    init(req.key(), req.scope(), req.where_filters());
 }
 
 RowFetcher::RowFetcher(Store& s, const kvrpcpb::DeleteRequest& req)
     : store_(s),
-      decoder_(s.GetPrimaryKeys(), req.where_filters()) {
-    init(req.key(), req.scope());
+      decoder_(s.GetPrimaryKeys(), s.index_fields_, req.where_filters()) {
+    init(req.key(), req.scope(), req.where_filters());
 }
 
 RowFetcher::~RowFetcher() { delete iter_; }
@@ -30,19 +34,40 @@ Status RowFetcher::Next(RowResult* result, bool* over) {
         *over = true;
         return last_status_;
     }
-    if (key_.empty()) {
-        return nextScope(result, over);
-    } else {
+    if (!key_.empty()) {
         return nextOneKey(result, over);
+    } else if (use_index_) {
+        return nextIndex(result, over);
+    } else {
+        return nextScope(result, over);
     }
 }
 
-void RowFetcher::init(const std::string& key, const ::kvrpcpb::Scope& scope) {
+void RowFetcher::init(const std::string& key, const ::kvrpcpb::Scope& scope,
+                      const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>& matches) {
     if (!key.empty()) {
         key_ = key;
         return;
     }
-    iter_ = store_.NewIterator(scope);
+
+    row_start_ = scope.start();
+    row_limit_ = scope.limit();
+    if (row_start_.empty() || row_start_ < store_.start_key_) {
+        row_start_ = store_.start_key_;
+    }
+    auto end_key = store_.GetEndKey();
+    if (row_limit_.empty() || row_limit_ > end_key) {
+        row_limit_ = end_key;
+    }
+
+    use_index_ = store_.chooseIndex(row_start_, row_limit_, matches, &index_);
+    if (use_index_) {
+        FLOG_DEBUG("select use index %s, filters: %s", index_.column->name().c_str(),
+                   decoder_.DebugString().c_str());
+        iter_ = store_.newIndexIterator(index_);
+    } else {
+        iter_ = store_.NewIterator(row_start_, row_limit_);
+    }
 }
 
 Status RowFetcher::nextOneKey(RowResult* result, bool* over) {
@@ -111,6 +136,71 @@ Status RowFetcher::nextScope(RowResult* result, bool* over) {
     return last_status_;
 }
 
+Status RowFetcher::fetchIndexBatch() {
+    index_keys_.clear();
+    row_keys_.clear();
+    batch_pos_ = 0;
+
+    std::string row_key;
+    while (iter_->Valid() && row_keys_.size() < kIndexFetchBatchSize) {
+        auto index_key = iter_->key();
+        store_.addMetricRead(1, index_key.size());
+        ++iter_count_;
+        if (iter_count_ % kIteratorTooManyKeys == kIteratorTooManyKeys - 1) {
+            FLOG_WARN("index iterator too many keys(%lu), filters: %s",
+                      iter_count_, decoder_.DebugString().c_str());
+        }
+
+        if (!DecodeIndexRowKey(index_key, *index_.column, &row_key)) {
+            FLOG_WARN("decode index key failed: %s", EncodeToHexString(index_key).c_str());
+        } else if (row_key >= row_start_ && row_key < row_limit_) {
+            // 分裂时可能残留已经不属于本range的索引
+            index_keys_.push_back(std::move(index_key));
+            row_keys_.push_back(row_key);
+        }
+        iter_->Next();
+    }
+
+    store_.MultiGet(row_keys_, &row_values_, &row_statuses_);
+    return iter_->status();
+}
+
+Status RowFetcher::nextIndex(RowResult* result, bool* over) {
+    while (true) {
+        if (batch_pos_ >= row_keys_.size()) {
+            if (!iter_->Valid()) {
+                last_status_ = iter_->status();
+                *over = true;
+                return last_status_;
+            }
+            last_status_ = fetchIndexBatch();
+            if (!last_status_.ok()) {
+                return last_status_;
+            }
+            continue;
+        }
+
+        auto i = batch_pos_++;
+        const auto& rs = row_statuses_[i];
+        if (rs.code() == Status::kNotFound) {
+            continue;
+        } else if (!rs.ok()) {
+            last_status_ = rs;
+            return last_status_;
+        }
+
+        matched_ = false;
+        last_status_ = decoder_.DecodeAndFilter(row_keys_[i], row_values_[i], result, &matched_);
+        if (!last_status_.ok()) {
+            return last_status_;
+        }
+        if (matched_ && store_.indexMatched(*index_.column, *result, index_keys_[i])) {
+            *over = false;
+            return last_status_;
+        }
+    }
+}
+
 } /* namespace storage */
 } /* namespace dataserver */
 } /* namespace sharkstore */
@@ -2,6 +2,7 @@ _Pragma("once");
 
 #include <rocksdb/db.h>
 #include "proto/gen/kvrpcpb.pb.h"
+#include "row_index.h"
 #include "row_decoder.h"
 #include "store.h"
 
@@ -22,9 +23,13 @@ public:
     Status Next(RowResult* result, bool* over);
 
 private:
-    void init(const std::string& key, const ::kvrpcpb::Scope& scope);
+    void init(const std::string& key, const ::kvrpcpb::Scope& scope,
+              const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>& matches);
     Status nextOneKey(RowResult* result, bool* over);
     Status nextScope(RowResult* result, bool* over);
+    Status nextIndex(RowResult* result, bool* over);
+    // 扫描一批索引，批量取回对应的行
+    Status fetchIndexBatch();
 
 private:
     Store& store_;
@@ -35,6 +40,17 @@ private:
     Status last_status_;
     bool matched_ = false;
     size_t iter_count_ = 0;
+
+    // 索引扫描
+    IndexScope index_;
+    bool use_index_ = false;
+    std::string row_start_;
+    std::string row_limit_;
+    std::vector<std::string> index_keys_;
+    std::vector<std::string> row_keys_;
+    std::vector<std::string> row_values_;
+    std::vector<Status> row_statuses_;
+    size_t batch_pos_ = 0;
 };
 
 } /* namespace storage */
@@ -0,0 +1,153 @@
+#include "row_index.h"
+
+#include "common/ds_encoding.h"
+#include "field_value.h"
+#include "row_decoder.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace storage {
+
+void EncodeIndexPrefix(std::string* buf, uint64_t range_id) {
+    buf->push_back(static_cast<char>(kStoreIndexPrefixByte));
+    EncodeUint64Ascending(buf, range_id);
+}
+
+void EncodeIndexPrefix(std::string* buf, uint64_t range_id, const metapb::Column& col) {
+    EncodeIndexPrefix(buf, range_id);
+    EncodeUvarintAscending(buf, col.id());
+}
+
+void EncodeIndexValue(std::string* buf, const FieldValue& value) {
+    switch (value.Type()) {
+        case FieldType::kInt:
+            EncodeVarintAscending(buf, value.Int());
+            break;
+        case FieldType::kUInt:
+            EncodeUvarintAscending(buf, value.UInt());
+            break;
+        case FieldType::kFloat:
+            EncodeFloatAscending(buf, value.Float());
+            break;
+        case FieldType::kBytes:
+            EncodeBytesAscending(buf, value.Bytes().c_str(), value.Bytes().size());
+            break;
+    }
+}
+
+bool DecodeIndexRowKey(const std::string& index_key, const metapb::Column& col,
+                       std::string* row_key) {
+    size_t offset = 1;
+    uint64_t range_id = 0, col_id = 0;
+    if (index_key.empty() || static_cast<unsigned char>(index_key[0]) != kStoreIndexPrefixByte) {
+        return false;
+    }
+    if (!DecodeUint64Ascending(index_key, offset, &range_id) ||
+        !DecodeUvarintAscending(index_key, offset, &col_id) || col_id != col.id()) {
+        return false;
+    }
+
+    // 跳过列值
+    bool ret = false;
+    switch (col.data_type()) {
+        case metapb::Tinyint:
+        case metapb::Smallint:
+        case metapb::Int:
+        case metapb::BigInt: {
+            if (col.unsigned_()) {
+                uint64_t i = 0;
+                ret = DecodeUvarintAscending(index_key, offset, &i);
+            } else {
+                int64_t i = 0;
+                ret = DecodeVarintAscending(index_key, offset, &i);
+            }
+            break;
+        }
+        case metapb::Float:
+        case metapb::Double: {
+            double d = 0;
+            ret = DecodeFloatAscending(index_key, offset, &d);
+            break;
+        }
+        case metapb::Varchar:
+        case metapb::Binary:
+        case metapb::Date:
+        case metapb::TimeStamp: {
+            std::string s;
+            ret = DecodeBytesAscending(index_key, offset, &s);
+            break;
+        }
+        default:
+            return false;
+    }
+    if (!ret || offset >= index_key.size()) {
+        return false;
+    }
+    row_key->assign(index_key, offset, std::string::npos);
+    return true;
+}
+
+static std::string prefixEnd(const std::string& key) {
+    std::string end(key);
+    while (!end.empty()) {
+        auto c = static_cast<unsigned char>(end.back());
+        if (c != 0xff) {
+            end.back() = static_cast<char>(c + 1);
+            break;
+        }
+        end.pop_back();
+    }
+    return end;
+}
+
+bool MakeIndexScope(uint64_t range_id, const metapb::Column& col,
+                    const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>& matches,
+                    IndexScope* scope) {
+    std::string prefix;
+    EncodeIndexPrefix(&prefix, range_id, col);
+
+    std::string start = prefix;
+    std::string limit = prefixEnd(prefix);
+    bool bounded = false;
+    for (const auto& m : matches) {
+        if (m.column().id() != col.id()) continue;
+
+        std::unique_ptr<FieldValue> value;
+        if (!ParseThreshold(m.threshold(), col, &value).ok()) continue;
+        std::string key = prefix;
+        EncodeIndexValue(&key, *value);
+
+        std::string lower, upper;
+        switch (m.match_type()) {
+            case kvrpcpb::Equal:
+                lower = key;
+                upper = prefixEnd(key);
+                break;
+            case kvrpcpb::Less:
+                upper = key;
+                break;
+            case kvrpcpb::LessOrEqual:
+                upper = prefixEnd(key);
+                break;
+            case kvrpcpb::Larger:
+            case kvrpcpb::LargerOrEqual:
+                lower = key;
+                break;
+            default:
+                continue;
+        }
+        if (!lower.empty() && lower > start) start = std::move(lower);
+        if (!upper.empty() && upper < limit) limit = std::move(upper);
+        bounded = true;
+    }
+
+    if (!bounded) return false;
+    scope->column = &col;
+    scope->start = std::move(start);
+    scope->limit = std::move(limit);
+    return true;
+}
+
+} /* namespace storage */
+} /* namespace dataserver */
+} /* namespace sharkstore */
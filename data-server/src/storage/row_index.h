@@ -0,0 +1,45 @@
+_Pragma("once");
+
+#include <string>
+#include <vector>
+
+#include "base/status.h"
+#include "proto/gen/kvrpcpb.pb.h"
+#include "proto/gen/metapb.pb.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace storage {
+
+class FieldValue;
+
+// 二级索引key: 1字节前缀 + 8字节range id + 列id + 列值(保序编码) + 行key
+// 每个range的索引在单独的key空间，扫描不会碰到同一个表其他range的索引
+// 索引value为空，行key直接从索引key中解出
+static const unsigned char kStoreIndexPrefixByte = '\x04';
+
+// range的全部索引以此为前缀
+void EncodeIndexPrefix(std::string* buf, uint64_t range_id);
+void EncodeIndexPrefix(std::string* buf, uint64_t range_id, const metapb::Column& col);
+void EncodeIndexValue(std::string* buf, const FieldValue& value);
+
+// 从索引key中解出行key
+bool DecodeIndexRowKey(const std::string& index_key, const metapb::Column& col,
+                       std::string* row_key);
+
+// 索引扫描范围
+struct IndexScope {
+    const metapb::Column* column = nullptr;
+    std::string start;
+    std::string limit;
+};
+
+// 根据where条件计算某个索引列的扫描范围
+// 条件只用来缩小范围，取回的行仍然需要经过完整的过滤
+bool MakeIndexScope(uint64_t range_id, const metapb::Column& col,
+                    const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>& matches,
+                    IndexScope* scope);
+
+} /* namespace storage */
+} /* namespace dataserver */
+} /* namespace sharkstore */
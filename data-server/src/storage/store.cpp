@@ -1,14 +1,20 @@
 #include "store.h"
 #include <common/ds_config.h>
 
+#include <algorithm>
+#include <numeric>
+
 #include "aggregate_calc.h"
 #include "base/util.h"
 #include "common/ds_config.h"
 #include "common/ds_encoding.h"
 #include "field_value.h"
+#include "frame/sf_logger.h"
 #include "proto/gen/raft_cmdpb.pb.h"
 #include "proto/gen/redispb.pb.h"
 #include "row_fetcher.h"
+#include "top_n.h"
+#include "ttl.h"
 
 namespace sharkstore {
 
@@ -16,6 +22,11 @@ namespace dataserver {
 namespace storage {
 
 static const size_t kDefaultMaxSelectLimit = 10000;
+static const int kIndexBatchSize = 1000;
+// 索引key中前缀和range id的长度
+static const size_t kIndexPrefixLength = 9;
+// 索引扫描每取回一行都要点查一次，代价按同样字节数顺序扫描的倍数估算
+static const uint64_t kIndexScanCostFactor = 10;
 
 //声明一个KEY
 static std::string GetRealKey(std::string& key) {
@@ -31,29 +42,88 @@ static std::string GetRealKey(std::string& key) {
     return realKey;
 }
 
-Store::Store(const metapb::Range& meta, rocksdb::DB* db) :
+Store::Store(const metapb::Range& meta, rocksdb::DB* db, LegacyRanges* legacy_ranges) :
     table_id_(meta.table_id()) ,
     range_id_(meta.id()),
     start_key_(meta.start_key()),
     end_key_(meta.end_key()),
-    db_(db) {
+    db_(db),
+    legacy_ranges_(legacy_ranges) {
     assert(!start_key_.empty());
     assert(!end_key_.empty());
     assert(meta.primary_keys_size() > 0);
     for (int i = 0; i < meta.primary_keys_size(); ++i) {
         primary_keys_.push_back(meta.primary_keys(i));
     }
+    loadIndexColumns(meta);
 
     write_options_.disableWAL = ds_config.rocksdb_config.disable_wal;
+
+    if (legacy_ranges_ != nullptr && legacy_ranges_->Contains(range_id_)) {
+        legacy_format_ = true;
+        legacy_ranges_->SetSpan(range_id_, start_key_, end_key_);
+        FLOG_INFO("range[%" PRIu64 "] data is in legacy value format, ttl is disabled",
+                  range_id_);
+    }
 }
 
 Store::~Store() {}
 
+void Store::ClearLegacyFormat() {
+    if (!legacy_format_) return;
+    legacy_format_ = false;
+    if (legacy_ranges_ != nullptr) {
+        legacy_ranges_->Remove(range_id_);
+    }
+}
+
+bool Store::expireEnabled() const {
+    return !legacy_format_ && ExpireSupported();
+}
+
+void Store::encodeValue(std::string* buf, const rocksdb::Slice& value,
+                        int64_t expire_at) const {
+    if (legacy_format_) {
+        buf->append(value.data(), value.size());
+    } else {
+        EncodeStoreValue(buf, value, expireEnabled() ? expire_at : 0);
+    }
+}
+
+std::string Store::encodeValue(const rocksdb::Slice& value, int64_t expire_at) const {
+    std::string buf;
+    encodeValue(&buf, value, expire_at);
+    return buf;
+}
+
+bool Store::decodeValue(std::string* stored, int64_t now, bool* corrupted) const {
+    if (legacy_format_) {
+        *corrupted = false;
+        return true;
+    }
+    return StripStoreValue(stored, now, corrupted);
+}
+
+std::string Store::indexValue(int64_t expire_at) const {
+    if (expire_at > 0 && expireEnabled()) {
+        return EncodeStoreValue(rocksdb::Slice(), expire_at);
+    }
+    return std::string();
+}
+
 Status Store::Get(const std::string& key, std::string* value) {
     rocksdb::Status s = db_->Get(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true), key, value);
     if (s.ok()) {
         addMetricRead(1, key.size() + value->size());
-        return Status::OK();
+        bool corrupted = false;
+        if (decodeValue(value, NowNanos(), &corrupted)) {
+            return Status::OK();
+        }
+        value->clear();
+        if (corrupted) {
+            return Status(Status::kCorruption, "decode value header", EncodeToHex(key));
+        }
+        return Status(Status::kNotFound);
     } else if (s.IsNotFound()) {
         return Status(Status::kNotFound);
     } else {
@@ -61,15 +131,59 @@ Status Store::Get(const std::string& key, std::string* value) {
     }
 }
 
-Status Store::Put(const std::string& key, const std::string& value) {
-    rocksdb::Status s;
-    if(ds_config.rocksdb_config.storage_type == 1 && ds_config.rocksdb_config.ttl > 0){
-        auto *blobdb = static_cast<rocksdb::blob_db::BlobDB*>(db_);
-        s = blobdb->PutWithTTL(write_options_,rocksdb::Slice(key),rocksdb::Slice(value),ds_config.rocksdb_config.ttl);
-    }else{
-        s = db_->Put(write_options_, key, value);
+void Store::MultiGet(const std::vector<std::string>& keys,
+                     std::vector<std::string>* values,
+                     std::vector<Status>* statuses) {
+    values->assign(keys.size(), std::string());
+    statuses->assign(keys.size(), Status::OK());
+    if (keys.empty()) return;
+
+    // 按key排序后查询，相邻的key大多落在同一个data block里
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    std::vector<rocksdb::Slice> sorted_keys;
+    sorted_keys.reserve(keys.size());
+    for (auto idx : order) {
+        sorted_keys.emplace_back(keys[idx]);
     }
 
+    std::vector<std::string> sorted_values;
+    auto results = db_->MultiGet(
+        rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum, true),
+        sorted_keys, &sorted_values);
+
+    uint64_t keys_read = 0;
+    uint64_t bytes_read = 0;
+    auto now = NowNanos();
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto idx = order[i];
+        const auto& s = results[i];
+        if (s.ok()) {
+            ++keys_read;
+            bytes_read += keys[idx].size() + sorted_values[i].size();
+            bool corrupted = false;
+            if (decodeValue(&sorted_values[i], now, &corrupted)) {
+                (*values)[idx] = std::move(sorted_values[i]);
+            } else if (corrupted) {
+                (*statuses)[idx] = Status(Status::kCorruption, "decode value header",
+                                          EncodeToHex(keys[idx]));
+            } else {
+                (*statuses)[idx] = Status(Status::kNotFound);
+            }
+        } else if (s.IsNotFound()) {
+            (*statuses)[idx] = Status(Status::kNotFound);
+        } else {
+            (*statuses)[idx] = Status(Status::kIOError, "multi get", s.ToString());
+        }
+    }
+    addMetricRead(keys_read, bytes_read);
+}
+
+Status Store::Put(const std::string& key, const std::string& value, int64_t expire_at) {
+    rocksdb::Status s = db_->Put(write_options_, key, encodeValue(value, expire_at));
     if (s.ok()) {
         addMetricWrite(1, key.size() + value.size());
         return Status::OK();
@@ -78,7 +192,19 @@ Status Store::Put(const std::string& key, const std::string& value) {
 }
 
 Status Store::Delete(const std::string& key) {
-    rocksdb::Status s = db_->Delete(write_options_, key);
+    rocksdb::Status s;
+    if (index_columns_.empty()) {
+        s = db_->Delete(write_options_, key);
+    } else {
+        std::vector<std::string> index_keys;
+        collectRowIndexes({key}, &index_keys);
+        rocksdb::WriteBatch batch;
+        batch.Delete(key);
+        for (const auto& index_key : index_keys) {
+            batch.Delete(index_key);
+        }
+        s = db_->Write(write_options_, &batch);
+    }
     if (s.ok()) {
         addMetricWrite(1, key.size());
         return Status::OK();
@@ -89,54 +215,35 @@ Status Store::Delete(const std::string& key) {
     }
 }
 
-Status Store::Insert(const kvrpcpb::InsertRequest& req, uint64_t* affected) {
-    if(ds_config.rocksdb_config.storage_type == 1 && ds_config.rocksdb_config.ttl > 0){
-        auto *blobdb = static_cast<rocksdb::blob_db::BlobDB*>(db_);
-        std::string value;
-        rocksdb::Status s;
-        bool check_dup = req.check_duplicate();
-        *affected = 0;
-        for (int i = 0; i < req.rows_size(); ++i) {
-            const kvrpcpb::KeyValue& kv = req.rows(i);
-            if (check_dup) {
-                s = db_->Get(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true), kv.key(), &value);
-                if (s.ok()) {
-                    return Status(Status::kDuplicate);
-                } else if (!s.IsNotFound()) {
-                    return Status(Status::kIOError, "get", s.ToString());
-                }
-            }
-            s = blobdb->PutWithTTL(write_options_,rocksdb::Slice(kv.key()),rocksdb::Slice(kv.value()),ds_config.rocksdb_config.ttl);
-            if (!s.ok()) {
-                return Status(Status::kIOError, "blobdb put", s.ToString());
-            }else{
-                addMetricWrite(*affected, kv.key().size()+kv.value().size());
-                *affected = *affected + 1;
-            }
-
-        }
-
-       return Status::OK();
-
-    }
-
+Status Store::Insert(const kvrpcpb::InsertRequest& req, uint64_t* affected,
+                     int64_t expire_at) {
     uint64_t bytes_written = 0;
     rocksdb::WriteBatch batch;
     rocksdb::Status s;
-    std::string value;
-    bool check_dup = req.check_duplicate();
     *affected = 0;
+    if (req.check_duplicate()) {
+        auto ret = checkDuplicate(req);
+        if (!ret.ok()) return ret;
+    }
+    // 索引与行在同一个WriteBatch中写入
+    if (!index_columns_.empty()) {
+        std::vector<std::string> stale_indexes;
+        std::vector<std::pair<std::string, int64_t>> new_indexes;
+        auto ret = collectInsertIndexes(req, &stale_indexes, &new_indexes);
+        if (!ret.ok()) return ret;
+        for (const auto& index_key : stale_indexes) {
+            batch.Delete(index_key);
+        }
+        for (const auto& index : new_indexes) {
+            batch.Put(index.first, indexValue(index.second > 0 ? index.second : expire_at));
+        }
+    }
+    std::string value;
     for (int i = 0; i < req.rows_size(); ++i) {
         const kvrpcpb::KeyValue& kv = req.rows(i);
-        if (check_dup) {
-            s = db_->Get(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true), kv.key(), &value);
-            if (s.ok()) {
-                return Status(Status::kDuplicate);
-            } else if (!s.IsNotFound()) {
-                return Status(Status::kIOError, "get", s.ToString());
-            }
-        }
-        s = batch.Put(kv.key(), kv.value());
+        value.clear();
+        encodeValue(&value, kv.value(), kv.expireat() > 0 ? kv.expireat() : expire_at);
+        s = batch.Put(kv.key(), value);
         if (!s.ok()) {
             return Status(Status::kIOError, "batch put", s.ToString());
         }
@@ -152,8 +259,281 @@ Status Store::Insert(const kvrpcpb::InsertRequest& req, uint64_t* affected) {
     }
 }
 
-static void addRow(const kvrpcpb::SelectRequest& req,
-                   kvrpcpb::SelectResponse* resp, const RowResult& r) {
+Status Store::checkDuplicate(const kvrpcpb::InsertRequest& req) {
+    std::vector<std::string> keys;
+    keys.reserve(req.rows_size());
+    for (int i = 0; i < req.rows_size(); ++i) {
+        keys.push_back(req.rows(i).key());
+    }
+
+    std::vector<std::string> values;
+    std::vector<Status> statuses;
+    MultiGet(keys, &values, &statuses);
+    for (const auto& s : statuses) {
+        if (s.ok()) {
+            return Status(Status::kDuplicate);
+        } else if (s.code() != Status::kNotFound) {
+            return s;
+        }
+    }
+    return Status::OK();
+}
+
+void Store::loadIndexColumns(const metapb::Range& meta) {
+    index_columns_.clear();
+    index_fields_.Clear();
+    index_decoder_.reset();
+    for (int i = 0; i < meta.index_columns_size(); ++i) {
+        index_columns_.push_back(meta.index_columns(i));
+        index_fields_.Add()->mutable_column()->CopyFrom(meta.index_columns(i));
+    }
+    if (!index_columns_.empty()) {
+        index_decoder_.reset(new RowDecoder(primary_keys_, index_fields_,
+                ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>()));
+    }
+}
+
+void Store::ResetIndexColumns(const metapb::Range& meta) {
+    loadIndexColumns(meta);
+    FLOG_INFO("range[%" PRIu64 "] reset index columns: %d", range_id_,
+              meta.index_columns_size());
+}
+
+void Store::encodeIndexKeys(const RowResult& row, std::vector<std::string>* index_keys) const {
+    for (const auto& col : index_columns_) {
+        // 空值不建索引
+        auto value = row.GetField(col.id());
+        if (value == nullptr) continue;
+
+        std::string index_key;
+        EncodeIndexPrefix(&index_key, range_id_, col);
+        EncodeIndexValue(&index_key, *value);
+        index_key.append(row.Key());
+        index_keys->push_back(std::move(index_key));
+    }
+}
+
+Status Store::decodeIndexKeys(const std::string& key, const std::string& value,
+                              std::vector<std::string>* index_keys) {
+    RowResult row;
+    auto s = index_decoder_->Decode(key, value, &row);
+    if (!s.ok()) return s;
+    encodeIndexKeys(row, index_keys);
+    return Status::OK();
+}
+
+Status Store::collectInsertIndexes(const kvrpcpb::InsertRequest& req,
+                                   std::vector<std::string>* stale_keys,
+                                   std::vector<std::pair<std::string, int64_t>>* new_keys) {
+    std::vector<std::string> keys;
+    keys.reserve(req.rows_size());
+    for (int i = 0; i < req.rows_size(); ++i) {
+        keys.push_back(req.rows(i).key());
+    }
+
+    // 检查过主键重复的不会覆盖旧行
+    if (!req.check_duplicate()) {
+        std::vector<std::string> values;
+        std::vector<Status> statuses;
+        MultiGet(keys, &values, &statuses);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (statuses[i].ok()) {
+                auto s = decodeIndexKeys(keys[i], values[i], stale_keys);
+                if (!s.ok()) return s;
+            } else if (statuses[i].code() != Status::kNotFound) {
+                return statuses[i];
+            }
+        }
+    }
+
+    std::vector<std::string> index_keys;
+    for (int i = 0; i < req.rows_size(); ++i) {
+        index_keys.clear();
+        auto s = decodeIndexKeys(keys[i], req.rows(i).value(), &index_keys);
+        if (!s.ok()) return s;
+        for (auto& index_key : index_keys) {
+            new_keys->emplace_back(std::move(index_key), req.rows(i).expireat());
+        }
+    }
+    return Status::OK();
+}
+
+void Store::collectRowIndexes(const std::vector<std::string>& keys,
+                              std::vector<std::string>* index_keys) {
+    std::vector<std::string> values;
+    std::vector<Status> statuses;
+    MultiGet(keys, &values, &statuses);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (!statuses[i].ok()) continue;
+        auto s = decodeIndexKeys(keys[i], values[i], index_keys);
+        if (!s.ok()) {
+            FLOG_WARN("range[%" PRIu64 "] decode row %s for index failed: %s", range_id_,
+                      EncodeToHexString(keys[i]).c_str(), s.ToString().c_str());
+        }
+    }
+}
+
+Status Store::deleteIndexes(const std::string& start, const std::string& limit) {
+    std::unique_ptr<Iterator> it(NewIterator(start, limit));
+    rocksdb::WriteBatch batch;
+    std::vector<std::string> index_keys;
+    for (; it->Valid(); it->Next()) {
+        index_keys.clear();
+        auto s = decodeIndexKeys(it->key(), it->value(), &index_keys);
+        if (!s.ok()) {
+            FLOG_WARN("range[%" PRIu64 "] delete index decode row failed: %s",
+                      range_id_, s.ToString().c_str());
+            continue;
+        }
+        for (const auto& index_key : index_keys) {
+            batch.Delete(index_key);
+        }
+        if (batch.Count() >= kIndexBatchSize) {
+            auto ret = db_->Write(write_options_, &batch);
+            if (!ret.ok()) {
+                return Status(Status::kIOError, "delete index", ret.ToString());
+            }
+            batch.Clear();
+        }
+    }
+    if (!it->status().ok()) {
+        return it->status();
+    }
+    auto ret = db_->Write(write_options_, &batch);
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "delete index", ret.ToString());
+    }
+    return Status::OK();
+}
+
+Status Store::truncateIndexes() {
+    // 整个range的索引(包括残留的旧索引)一起删除
+    std::string start, limit;
+    EncodeIndexPrefix(&start, range_id_);
+    EncodeIndexPrefix(&limit, range_id_ + 1);
+    auto ret = db_->DeleteRange(write_options_, db_->DefaultColumnFamily(), start, limit);
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "truncate index", ret.ToString());
+    }
+    return Status::OK();
+}
+
+Status Store::SplitIndexes(const std::string& split_key, uint64_t new_range_id) {
+    return moveIndexes(split_key, range_id_, new_range_id);
+}
+
+Status Store::UndoSplitIndexes(const std::string& split_key, uint64_t new_range_id) {
+    return moveIndexes(split_key, new_range_id, range_id_);
+}
+
+Status Store::moveIndexes(const std::string& split_key, uint64_t from_range_id,
+                          uint64_t to_range_id) {
+    if (index_columns_.empty()) {
+        return Status::OK();
+    }
+
+    std::string from_prefix, to_prefix;
+    EncodeIndexPrefix(&from_prefix, from_range_id);
+    EncodeIndexPrefix(&to_prefix, to_range_id);
+    assert(from_prefix.size() == kIndexPrefixLength);
+    assert(to_prefix.size() == kIndexPrefixLength);
+
+    // 按行的当前值重新计算，删旧写新，整个移动在一个batch里写入
+    // 中途崩溃时要么都没移要么都移了，重放时再执行一遍结果相同
+    std::unique_ptr<Iterator> it(NewIterator(split_key, GetEndKey()));
+    rocksdb::WriteBatch batch;
+    std::vector<std::string> index_keys;
+    uint64_t count = 0;
+    for (; it->Valid(); it->Next()) {
+        index_keys.clear();
+        auto s = decodeIndexKeys(it->key(), it->value(), &index_keys);
+        if (!s.ok()) {
+            FLOG_WARN("range[%" PRIu64 "] split index decode row failed: %s",
+                      range_id_, s.ToString().c_str());
+            continue;
+        }
+        for (auto& index_key : index_keys) {
+            index_key.replace(0, kIndexPrefixLength, from_prefix);
+            batch.Delete(index_key);
+            index_key.replace(0, kIndexPrefixLength, to_prefix);
+            batch.Put(index_key, indexValue(it->expire_at()));
+        }
+        ++count;
+    }
+    if (!it->status().ok()) {
+        return it->status();
+    }
+    auto ret = db_->Write(write_options_, &batch);
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "split index", ret.ToString());
+    }
+    FLOG_INFO("range[%" PRIu64 "] move indexes of %" PRIu64 " rows from range[%" PRIu64
+              "] to range[%" PRIu64 "]", range_id_, count, from_range_id, to_range_id);
+    return Status::OK();
+}
+
+bool Store::chooseIndex(const std::string& row_start, const std::string& row_limit,
+                        const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>& matches,
+                        IndexScope* index) {
+    if (index_columns_.empty() || matches.size() == 0) {
+        return false;
+    }
+
+    // 选择扫描范围最小的索引
+    uint64_t index_size = 0;
+    for (const auto& col : index_columns_) {
+        IndexScope scope;
+        if (!MakeIndexScope(range_id_, col, matches, &scope)) continue;
+        auto size = approximateSize(scope.start, scope.limit);
+        if (index->column == nullptr || size < index_size) {
+            index_size = size;
+            *index = std::move(scope);
+        }
+    }
+    if (index->column == nullptr) {
+        return false;
+    }
+
+    auto row_size = approximateSize(row_start, row_limit);
+    FLOG_DEBUG("range[%" PRIu64 "] choose index: column=%s, index size=%" PRIu64
+               ", row size=%" PRIu64, range_id_, index->column->name().c_str(),
+               index_size, row_size);
+    return index_size * kIndexScanCostFactor < row_size;
+}
+
+bool Store::indexMatched(const metapb::Column& col, const RowResult& row,
+                         const std::string& index_key) const {
+    auto value = row.GetField(col.id());
+    if (value == nullptr) return false;
+
+    std::string expected;
+    EncodeIndexPrefix(&expected, range_id_, col);
+    EncodeIndexValue(&expected, *value);
+    expected.append(row.Key());
+    return expected == index_key;
+}
+
+Iterator* Store::newIndexIterator(const IndexScope& index) {
+    return newIterator(index.start, index.limit);
+}
+
+Iterator* Store::newIterator(const std::string& start, const std::string& limit) {
+    auto it = db_->NewIterator(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true));
+    return new Iterator(it, start, limit, NowNanos(), !legacy_format_);
+}
+
+uint64_t Store::approximateSize(const std::string& start, const std::string& limit) {
+    if (start >= limit) return 0;
+    rocksdb::Range r(start, limit);
+    uint64_t size = 0;
+    db_->GetApproximateSizes(db_->DefaultColumnFamily(), &r, 1, &size,
+                             rocksdb::DB::SizeApproximationFlags::INCLUDE_MEMTABLES |
+                             rocksdb::DB::SizeApproximationFlags::INCLUDE_FILES);
+    return size;
+}
+
+static void encodeRow(const kvrpcpb::SelectRequest& req, const RowResult& r,
+                      kvrpcpb::Row* row) {
     std::string buf;
     for (int i = 0; i < req.field_list_size(); i++) {
         const auto& f = req.field_list(i);
@@ -162,11 +542,15 @@ static void addRow(const kvrpcpb::SelectRequest& req,
             EncodeFieldValue(&buf, v);
         }
     }
-    auto row = resp->add_rows();
     row->set_key(r.Key());
     row->set_fields(buf);
 }
 
+static void addRow(const kvrpcpb::SelectRequest& req,
+                   kvrpcpb::SelectResponse* resp, const RowResult& r) {
+    encodeRow(req, r, resp->add_rows());
+}
+
 Status Store::selectSimple(const kvrpcpb::SelectRequest& req,
                            kvrpcpb::SelectResponse* resp) {
     RowFetcher f(*this, req);
@@ -192,6 +576,51 @@ Status Store::selectSimple(const kvrpcpb::SelectRequest& req,
     return s;
 }
 
+Status Store::selectTopN(const kvrpcpb::SelectRequest& req,
+                         kvrpcpb::SelectResponse* resp) {
+    uint64_t limit = req.has_limit() ? req.limit().count() : kDefaultMaxSelectLimit;
+    uint64_t offset = req.has_limit() ? req.limit().offset() : 0;
+    if (limit > kDefaultMaxSelectLimit) limit = kDefaultMaxSelectLimit;
+    // 堆里要保留offset+count行
+    if (offset > kDefaultMaxSelectLimit - limit) {
+        return Status(Status::kInvalidArgument, "select order by",
+                      "offset + count exceeds " + std::to_string(kDefaultMaxSelectLimit));
+    }
+    // scope超出本range时(proxy把整张表的scope发给每个range)，RowFetcher按range边界截断，
+    // 只返回本range排序后的前offset+count行，由proxy合并后再跳过offset
+    uint64_t skip = offset;
+    if (req.key().empty()) {
+        const auto& scope = req.scope();
+        if (scope.start().empty() || scope.start() < start_key_ ||
+            scope.limit().empty() || scope.limit() > GetEndKey()) {
+            skip = 0;
+        }
+    }
+
+    RowFetcher f(*this, req);
+    TopNSorter sorter(req.order_bys(), offset + limit);
+    Status s;
+    std::unique_ptr<RowResult> r(new RowResult);
+    bool over = false;
+    uint64_t all = 0;
+    while (!over && s.ok()) {
+        over = false;
+        s = f.Next(r.get(), &over);
+        if (s.ok() && !over) {
+            ++all;
+            auto row = sorter.Push(*r);
+            if (row != nullptr) {
+                encodeRow(req, *r, row);
+            }
+        }
+    }
+    if (s.ok()) {
+        sorter.Finish(skip, resp->mutable_rows());
+    }
+    resp->set_offset(all);
+    return s;
+}
+
 Status Store::selectAggre(const kvrpcpb::SelectRequest& req,
                           kvrpcpb::SelectResponse* resp) {
     // 暂时不支持带group by的聚合函数
@@ -276,6 +705,9 @@ Status Store::Select(const kvrpcpb::SelectRequest& req,
         return Status(Status::kNotSupported, "select",
                       "mixture of aggregate and column select field");
     } else if (has_column) {
+        if (req.order_bys_size() > 0) {
+            return selectTopN(req, resp);
+        }
         return selectSimple(req, resp);
     } else {
         return selectAggre(req, resp);
@@ -290,6 +722,7 @@ Status Store::DeleteRows(const kvrpcpb::DeleteRequest& req,
     bool over = false;
     rocksdb::WriteBatch batch;
     uint64_t bytes_written = 0;
+    std::vector<std::string> index_keys;
 
     while (!over && s.ok()) {
         over = false;
@@ -299,6 +732,13 @@ Status Store::DeleteRows(const kvrpcpb::DeleteRequest& req,
             batch.Delete(r->Key());
             ++(*affected);
             bytes_written += r->Key().size();
+            if (!index_columns_.empty()) {
+                index_keys.clear();
+                encodeIndexKeys(*r, &index_keys);
+                for (const auto& index_key : index_keys) {
+                    batch.Delete(index_key);
+                }
+            }
         }
     }
 
@@ -315,8 +755,15 @@ Status Store::DeleteRows(const kvrpcpb::DeleteRequest& req,
 }
 
 Status Store::Truncate() {
+    auto is = truncateIndexes();
+    if (!is.ok()) return is;
+
     rocksdb::WriteOptions op;
 
+    // 日志随数据一起删除，快照之前的变更只能全量加载
+    auto ls = truncateWatchLog();
+    if (!ls.ok()) return ls;
+
     std::unique_lock<std::mutex> lock(key_lock_);
     auto family = db_->DefaultColumnFamily();
 
@@ -336,6 +783,9 @@ void Store::SetEndKey(std::string end_key) {
     std::unique_lock<std::mutex> lock(key_lock_);
     assert(start_key_ < end_key);
     end_key_ = std::move(end_key);
+    if (legacy_format_ && legacy_ranges_ != nullptr) {
+        legacy_ranges_->SetSpan(range_id_, start_key_, end_key_);
+    }
 }
 
 std::string Store::GetEndKey() const {
@@ -428,7 +878,6 @@ uint64_t Store::StatisSize(std::string& split_key, uint64_t split_size,
 }
 
 Iterator* Store::NewIterator(const kvrpcpb::Scope& scope) {
-    auto it = db_->NewIterator(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true));
     std::string start = scope.start();
     std::string limit = scope.limit();
     if (start.empty() || start < start_key_) {
@@ -441,11 +890,10 @@ Iterator* Store::NewIterator(const kvrpcpb::Scope& scope) {
             limit = end_key_;
         }
     }
-    return new Iterator(it, start, limit);
+    return newIterator(start, limit);
 }
 
 Iterator* Store::NewIterator(std::string start, std::string limit) {
-    auto it = db_->NewIterator(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true));
     if (start.empty() || start < start_key_) {
         start = start_key_;
     }
@@ -456,7 +904,7 @@ Iterator* Store::NewIterator(std::string start, std::string limit) {
             limit = end_key_;
         }
     }
-    return new Iterator(it, start, limit);
+    return newIterator(start, limit);
 }
 
 Status Store::BatchDelete(const std::vector<std::string>& keys) {
@@ -471,6 +919,13 @@ Status Store::BatchDelete(const std::vector<std::string>& keys) {
         ++keys_written;
         bytes_written += key.size();
     }
+    if (!index_columns_.empty()) {
+        std::vector<std::string> index_keys;
+        collectRowIndexes(keys, &index_keys);
+        for (const auto& index_key : index_keys) {
+            batch.Delete(index_key);
+        }
+    }
     auto ret = db_->Write(write_options_, &batch);
     if (ret.ok()) {
         addMetricWrite(keys_written, bytes_written);
@@ -485,19 +940,33 @@ bool Store::KeyExists(const std::string& key) {
     auto ret = db_->Get(rocksdb::ReadOptions(ds_config.rocksdb_config.read_checksum,true), db_->DefaultColumnFamily(), key,
                         &value);
     addMetricRead(1, key.size() + value.size());
-    return ret.ok();
+    if (!ret.ok()) {
+        return false;
+    }
+    if (legacy_format_) {
+        return true;
+    }
+    int64_t expire_at = 0;
+    rocksdb::Slice user_value;
+    return DecodeStoreValue(value, &expire_at, &user_value) && !IsExpired(expire_at, NowNanos());
 }
 
 Status Store::BatchSet(
-    const std::vector<std::pair<std::string, std::string>>& keyValues) {
+    const std::vector<std::pair<std::string, std::string>>& keyValues,
+    const std::vector<int64_t>& expire_ats) {
     if (keyValues.empty()) return Status::OK();
+    assert(expire_ats.empty() || expire_ats.size() == keyValues.size());
 
     uint64_t keys_written = 0;
     uint64_t bytes_written = 0;
 
     rocksdb::WriteBatch batch;
-    for (auto& kv : keyValues) {
-        batch.Put(kv.first, kv.second);
+    std::string value;
+    for (size_t i = 0; i < keyValues.size(); ++i) {
+        const auto& kv = keyValues[i];
+        value.clear();
+        encodeValue(&value, kv.second, expire_ats.empty() ? 0 : expire_ats[i]);
+        batch.Put(kv.first, value);
         ++keys_written;
         bytes_written += (kv.first.size() + kv.second.size());
     }
@@ -511,6 +980,10 @@ Status Store::BatchSet(
 }
 
 Status Store::RangeDelete(const std::string& start, const std::string& limit) {
+    if (!index_columns_.empty()) {
+        auto s = deleteIndexes(start, limit);
+        if (!s.ok()) return s;
+    }
     auto ret = db_->DeleteRange(write_options_, db_->DefaultColumnFamily(),
                                 start, limit);
     return Status(ret.ok() ? Status::OK() : Status(Status::kUnknown));
@@ -518,13 +991,29 @@ Status Store::RangeDelete(const std::string& start, const std::string& limit) {
 
 Status Store::ApplySnapshot(const std::vector<std::string>& datas) {
     rocksdb::WriteBatch batch;
+    std::vector<std::string> index_keys;
+    std::string value;
     for (const auto& data : datas) {
         raft_cmdpb::SnapshotKVPair p;
         if (!p.ParseFromString(data)) {
             return Status(Status::kCorruption, "apply snapshot data",
                           "deserilize return false");
         } else {
-            batch.Put(p.key(), p.value());
+            value.clear();
+            encodeValue(&value, p.value(), p.expire_at());
+            batch.Put(p.key(), value);
+        }
+        // 快照只包含行数据，索引在本地重建
+        if (!index_columns_.empty()) {
+            index_keys.clear();
+            auto s = decodeIndexKeys(p.key(), p.value(), &index_keys);
+            if (!s.ok()) {
+                FLOG_WARN("range[%" PRIu64 "] apply snapshot decode row failed: %s",
+                          range_id_, s.ToString().c_str());
+            }
+            for (const auto& index_key : index_keys) {
+                batch.Put(index_key, indexValue(p.expire_at()));
+            }
         }
     }
     auto ret = db_->Write(write_options_, &batch);
@@ -1,11 +1,13 @@
 _Pragma("once");
 
 #include <rocksdb/db.h>
-#include <rocksdb/utilities/blob_db/blob_db.h>
+#include <rocksdb/write_batch.h>
+#include <atomic>
 #include <mutex>
 
 #include "iterator.h"
 #include "metric.h"
+#include "row_index.h"
 #include "proto/gen/kvrpcpb.pb.h"
 #include "proto/gen/watchpb.pb.h"
 
@@ -16,20 +18,37 @@ namespace storage {
 // 行前缀长度: 1字节特殊标记+8字节table id
 static const size_t kRowPrefixLength = 9;
 static const unsigned char kStoreKVPrefixByte = '\x01';
+// watch变更日志，见Store::WatchApply
+static const unsigned char kStoreWatchLogPrefixByte = '\x05';
+
+// 配置(watch.change_log)是否记录watch变更日志
+bool WatchLogEnabled();
+
+class RowDecoder;
+class RowResult;
+class LegacyRanges;
 
 class Store {
 public:
-    Store(const metapb::Range& meta, rocksdb::DB* db);
+    // legacy_ranges里有这个range时按没有value头部的老格式读写
+    Store(const metapb::Range& meta, rocksdb::DB* db, LegacyRanges* legacy_ranges = nullptr);
     ~Store();
 
     Store(const Store&) = delete;
     Store& operator=(const Store&) = delete;
 
     Status Get(const std::string& key, std::string* value);
-    Status Put(const std::string& key, const std::string& value);
+    // 批量点查，values和statuses与keys一一对应，key不存在时对应status为kNotFound
+    void MultiGet(const std::vector<std::string>& keys,
+                  std::vector<std::string>* values,
+                  std::vector<Status>* statuses);
+    // expire_at为过期时间(unix纳秒)，0表示不过期
+    Status Put(const std::string& key, const std::string& value, int64_t expire_at = 0);
     Status Delete(const std::string& key);
 
-    Status Insert(const kvrpcpb::InsertRequest& req, uint64_t* affected);
+    // 没有单独指定过期时间的行使用expire_at
+    Status Insert(const kvrpcpb::InsertRequest& req, uint64_t* affected,
+                  int64_t expire_at = 0);
     Status Select(const kvrpcpb::SelectRequest& req,
                   kvrpcpb::SelectResponse* resp);
     Status DeleteRows(const kvrpcpb::DeleteRequest& req, uint64_t* affected);
@@ -41,12 +60,48 @@ public:
             watchpb::DsKvWatchGetMultiResponse *resp);
     Status WatchScan();
 
+    // watch变更日志
+    // 每个range一份，按(range id, revision)存在单独的key空间，和数据在同一个WriteBatch里写入，
+    // 追赶时按revision读取，不用扫描前缀下的全部数据
+    struct WatchChange {
+        std::string key;    // 编码后的数据key
+        std::string value;  // 编码后的value，删除时不用
+        watchpb::Event event;
+    };
+    // 修改数据并追加日志，一次调用的变更revision相同
+    Status WatchApply(int64_t revision, const std::vector<WatchChange>& changes,
+                      int64_t expire_at = 0);
+    // 读取key以prefix开头、revision大于from的变更
+    // 日志已经清理到from之后或者不存在时返回kNotFound，调用方需要全量加载
+    Status WatchChanges(const std::string& prefix, int64_t from,
+                        std::vector<watchpb::Event>* events);
+    // 后台定期调用，清理超过保留时间或者条数的日志，写入时不清理
+    Status TrimWatchLog();
+    // 分裂时把[split_key, end)内的key的日志复制给新range，需要在SetEndKey之前调用
+    // 新range已经有日志时不复制，可以重复执行
+    Status SplitWatchLog(const std::string& split_key, uint64_t new_range_id);
+
     void SetEndKey(std::string end_key);
     std::string GetEndKey() const;
 
+    // 数据是否是没有value头部的老格式
+    bool LegacyFormat() const { return legacy_format_; }
+    // 数据清空之后(比如应用快照)转成新格式
+    void ClearLegacyFormat();
+
     const std::vector<metapb::Column>& GetPrimaryKeys() const {
         return primary_keys_;
     }
+    const std::vector<metapb::Column>& GetIndexColumns() const {
+        return index_columns_;
+    }
+    // 应用快照时按快照里的meta重新加载索引定义，需要在写入快照数据之前调用
+    void ResetIndexColumns(const metapb::Range& meta);
+    // 分裂时把[split_key, end)内的行的索引移到新range，需要在SetEndKey之前调用
+    // 一次原子写入，可以重复执行
+    Status SplitIndexes(const std::string& split_key, uint64_t new_range_id);
+    // 分裂失败时把移出去的索引移回来
+    Status UndoSplitIndexes(const std::string& split_key, uint64_t new_range_id);
 
     uint64_t StatisSize(std::string& split_key, uint64_t split_size);
     uint64_t StatisSize(std::string& split_key, uint64_t split_size,
@@ -54,6 +109,7 @@ public:
 
     void ResetMetric() { metric_.Reset(); }
     void CollectMetric(MetricStat* stat) { metric_.Collect(stat); }
+    void LastMetric(MetricStat* stat) const { metric_.LastStat(stat); }
 
 public:
     Iterator* NewIterator(const ::kvrpcpb::Scope& scope);
@@ -61,8 +117,10 @@ public:
                           std::string limit = std::string());
     Status BatchDelete(const std::vector<std::string>& keys);
     bool KeyExists(const std::string& key);
+    // expire_ats为空时都不过期，否则与keyValues一一对应
     Status BatchSet(
-        const std::vector<std::pair<std::string, std::string>>& keyValues);
+        const std::vector<std::pair<std::string, std::string>>& keyValues,
+        const std::vector<int64_t>& expire_ats = std::vector<int64_t>());
     Status RangeDelete(const std::string& start, const std::string& limit);
 
     Status ApplySnapshot(const std::vector<std::string>& datas);
@@ -72,9 +130,54 @@ private:
 
     Status selectSimple(const kvrpcpb::SelectRequest& req,
                         kvrpcpb::SelectResponse* resp);
+    // 带order by的select，只保留排序后的前offset+count行
+    Status selectTopN(const kvrpcpb::SelectRequest& req,
+                      kvrpcpb::SelectResponse* resp);
     Status selectAggre(const kvrpcpb::SelectRequest& req,
                        kvrpcpb::SelectResponse* resp);
 
+    // 任意一行已存在返回kDuplicate
+    Status checkDuplicate(const kvrpcpb::InsertRequest& req);
+
+    // 二级索引维护
+    void loadIndexColumns(const metapb::Range& meta);
+    void encodeIndexKeys(const RowResult& row, std::vector<std::string>* index_keys) const;
+    Status decodeIndexKeys(const std::string& key, const std::string& value,
+                           std::vector<std::string>* index_keys);
+    // 插入时需要写入的索引，以及被覆盖的旧行需要删除的索引
+    // 新索引的过期时间与对应的行相同
+    Status collectInsertIndexes(const kvrpcpb::InsertRequest& req,
+                                std::vector<std::string>* stale_keys,
+                                std::vector<std::pair<std::string, int64_t>>* new_keys);
+    // 删除行之前取出已有行的索引，解析失败的行跳过
+    void collectRowIndexes(const std::vector<std::string>& keys,
+                           std::vector<std::string>* index_keys);
+    // 删除[start, limit)内的行的索引
+    Status deleteIndexes(const std::string& start, const std::string& limit);
+    Status truncateIndexes();
+    Status moveIndexes(const std::string& split_key, uint64_t from_range_id,
+                       uint64_t to_range_id);
+
+    // 索引扫描
+    bool chooseIndex(const std::string& row_start, const std::string& row_limit,
+                     const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Match>& matches,
+                     IndexScope* index);
+    // 索引key是否与行的当前值一致，不一致说明是残留的旧索引
+    bool indexMatched(const metapb::Column& col, const RowResult& row,
+                      const std::string& index_key) const;
+    Iterator* newIndexIterator(const IndexScope& index);
+    Iterator* newIterator(const std::string& start, const std::string& limit);
+
+    // 按range的数据格式编解码value，老格式和blob db不记录过期时间
+    bool expireEnabled() const;
+    void encodeValue(std::string* buf, const rocksdb::Slice& value, int64_t expire_at) const;
+    std::string encodeValue(const rocksdb::Slice& value, int64_t expire_at) const;
+    // 原地去掉头部，已过期返回false
+    bool decodeValue(std::string* stored, int64_t now, bool* corrupted) const;
+    // 不过期的索引value为空，过期的带上与行相同的过期时间
+    std::string indexValue(int64_t expire_at) const;
+    uint64_t approximateSize(const std::string& start, const std::string& limit);
+
     void addMetricRead(uint64_t keys, uint64_t bytes);
     void addMetricWrite(uint64_t keys, uint64_t bytes);
 
@@ -83,6 +186,20 @@ private:
     bool decodeWatchKey(const std::string& key, watchpb::WatchKeyValue *kv) const;
     bool decodeWatchValue(const std::string& value, watchpb::WatchKeyValue *kv) const;
 
+    // 变更日志的内存状态，第一次使用时从存储加载
+    struct WatchLogState {
+        bool exists = false;
+        int64_t trimmed = 0;  // 不大于trimmed的变更可能已经被清理
+        int64_t last = 0;     // 最后一条变更的revision
+        uint64_t count = 0;
+    };
+    // 以下需要持有watch_log_lock_
+    Status loadWatchLog();
+    // 清理旧日志，有清理时返回true
+    bool trimWatchLog(rocksdb::WriteBatch* batch);
+    Status truncateWatchLog();
+    rocksdb::Iterator* newWatchLogIterator(const std::string& start);
+
 private:
     const uint64_t table_id_ = 0;
     const uint64_t range_id_ = 0;
@@ -94,7 +211,18 @@ private:
     rocksdb::DB* db_;
     rocksdb::WriteOptions write_options_;
 
+    LegacyRanges* legacy_ranges_ = nullptr;
+    std::atomic<bool> legacy_format_ = {false};
+
     std::vector<metapb::Column> primary_keys_;
+    std::vector<metapb::Column> index_columns_;
+    // 解析索引列
+    ::google::protobuf::RepeatedPtrField< ::kvrpcpb::SelectField> index_fields_;
+    std::unique_ptr<RowDecoder> index_decoder_;
+
+    std::mutex watch_log_lock_;
+    bool watch_log_loaded_ = false;
+    WatchLogState watch_log_;
 
     Metric metric_;
 };
@@ -1,12 +1,70 @@
 #include "store.h"
 
+#include <algorithm>
+#include <rocksdb/write_batch.h>
+
 #include "base/util.h"
+#include "common/ds_config.h"
 #include "common/ds_encoding.h"
+#include "frame/sf_logger.h"
+#include "ttl.h"
 
 namespace sharkstore {
 namespace dataserver {
 namespace storage {
 
+static const int kDefaultWatchLogRetention = 600;
+static const int kDefaultWatchLogMaxEntries = 100000;
+
+// 日志key: 前缀 + range id + revision + 序号，和用户数据不在同一个key空间，
+// 不会被数据的扫描、删除和大小统计看到
+// 分裂时把分出去的key的日志复制给新range(见SplitWatchLog)；快照不带日志，
+// 应用快照后日志清空，追赶时返回kNotFound，watcher按RESPONSE_ALL全量重新加载
+static std::string watchLogPrefix(uint64_t range_id) {
+    std::string prefix;
+    prefix.push_back(static_cast<char>(kStoreWatchLogPrefixByte));
+    EncodeUint64Ascending(&prefix, range_id);
+    return prefix;
+}
+
+static std::string watchLogKey(const std::string& log_prefix, int64_t revision, uint64_t seq) {
+    std::string key(log_prefix);
+    EncodeUint64Ascending(&key, static_cast<uint64_t>(revision));
+    EncodeUint64Ascending(&key, seq);
+    return key;
+}
+
+// revision 0的位置记录日志清理到的revision
+static std::string watchLogMarker(const std::string& log_prefix) {
+    std::string key(log_prefix);
+    EncodeUint64Ascending(&key, 0);
+    return key;
+}
+
+static bool decodeWatchLogRevision(const rocksdb::Slice& key, size_t prefix_len, int64_t* revision) {
+    std::string buf(key.data(), key.size());
+    uint64_t value = 0;
+    if (!DecodeUint64Ascending(buf, prefix_len, &value)) return false;
+    *revision = static_cast<int64_t>(value);
+    return true;
+}
+
+static int64_t watchLogRetentionMs() {
+    auto retention = ds_config.watch_config.change_log_retention;
+    if (retention <= 0) retention = kDefaultWatchLogRetention;
+    return static_cast<int64_t>(retention) * 1000;
+}
+
+static uint64_t watchLogMaxEntries() {
+    auto max_entries = ds_config.watch_config.change_log_max_entries;
+    if (max_entries <= 0) max_entries = kDefaultWatchLogMaxEntries;
+    return static_cast<uint64_t>(max_entries);
+}
+
+bool WatchLogEnabled() {
+    return ds_config.watch_config.change_log;
+}
+
 std::string Store::encodeWatchKey(const watchpb::WatchKeyValue& kv) const {
     std::string buf;
     buf.push_back(kStoreKVPrefixByte);
@@ -111,6 +169,321 @@ Status Store::WatchScan() {
     return Status(Status::kNotSupported);
 }
 
+rocksdb::Iterator* Store::newWatchLogIterator(const std::string& start) {
+    auto iter = db_->NewIterator(rocksdb::ReadOptions());
+    iter->Seek(start);
+    return iter;
+}
+
+Status Store::loadWatchLog() {
+    if (watch_log_loaded_) return Status::OK();
+
+    auto log_prefix = watchLogPrefix(range_id_);
+    WatchLogState state;
+    std::string value;
+    auto ret = db_->Get(rocksdb::ReadOptions(), watchLogMarker(log_prefix), &value);
+    if (ret.IsNotFound()) {
+        watch_log_ = state;
+        watch_log_loaded_ = true;
+        return Status::OK();
+    } else if (!ret.ok()) {
+        return Status(Status::kIOError, "load watch log marker", ret.ToString());
+    }
+
+    size_t offset = 0;
+    uint64_t trimmed = 0;
+    if (!DecodeUint64Ascending(value, offset, &trimmed)) {
+        return Status(Status::kCorruption, "decode watch log marker", EncodeToHex(value));
+    }
+    state.exists = true;
+    state.trimmed = static_cast<int64_t>(trimmed);
+    state.last = state.trimmed;
+
+    auto limit = NextComparable(log_prefix);
+    std::unique_ptr<rocksdb::Iterator> iter(
+        newWatchLogIterator(watchLogKey(log_prefix, 1, 0)));
+    for (; iter->Valid() && iter->key().compare(limit) < 0; iter->Next()) {
+        decodeWatchLogRevision(iter->key(), log_prefix.size(), &state.last);
+        ++state.count;
+    }
+    if (!iter->status().ok()) {
+        return Status(Status::kIOError, "load watch log", iter->status().ToString());
+    }
+    watch_log_ = state;
+    watch_log_loaded_ = true;
+    return Status::OK();
+}
+
+bool Store::trimWatchLog(rocksdb::WriteBatch* batch) {
+    if (watch_log_.count == 0) return false;
+
+    // 最旧的在最前面，找到第一条需要保留的，之前的用一个DeleteRange删除
+    auto log_prefix = watchLogPrefix(range_id_);
+    auto start = watchLogKey(log_prefix, 1, 0);
+    auto limit = NextComparable(log_prefix);
+    auto expire_ms = NowNanos() / 1000000 - watchLogRetentionMs();
+    auto max_entries = watchLogMaxEntries();
+    auto count = watch_log_.count;
+    auto trimmed = watch_log_.trimmed;
+    std::string cut = limit;
+    watchpb::WatchLogEntry entry;
+    std::unique_ptr<rocksdb::Iterator> iter(newWatchLogIterator(start));
+    for (; iter->Valid() && iter->key().compare(limit) < 0 && count > 0; iter->Next()) {
+        if (count <= max_entries &&
+            entry.ParseFromArray(iter->value().data(), static_cast<int>(iter->value().size())) &&
+            entry.append_time() >= expire_ms) {
+            cut = iter->key().ToString();
+            break;
+        }
+        int64_t revision = 0;
+        if (decodeWatchLogRevision(iter->key(), log_prefix.size(), &revision)) {
+            trimmed = std::max(trimmed, revision);
+        }
+        --count;
+    }
+    if (!iter->status().ok() || count == watch_log_.count) {
+        return false;
+    }
+    batch->DeleteRange(start, cut);
+    watch_log_.count = count;
+    watch_log_.trimmed = trimmed;
+    return true;
+}
+
+Status Store::WatchApply(int64_t revision, const std::vector<WatchChange>& changes,
+                         int64_t expire_at) {
+    if (changes.empty()) return Status::OK();
+
+    rocksdb::WriteBatch batch;
+    uint64_t keys_written = 0;
+    uint64_t bytes_written = 0;
+    for (const auto& c : changes) {
+        if (c.event.type() == watchpb::DELETE) {
+            batch.Delete(c.key);
+            bytes_written += c.key.size();
+        } else {
+            batch.Put(c.key, encodeValue(c.value, expire_at));
+            bytes_written += c.key.size() + c.value.size();
+        }
+        ++keys_written;
+    }
+
+    auto write = [&]() {
+        auto ret = db_->Write(write_options_, &batch);
+        if (!ret.ok()) {
+            return Status(Status::kIOError, "watch batch write", ret.ToString());
+        }
+        addMetricWrite(keys_written, bytes_written);
+        return Status::OK();
+    };
+
+    std::lock_guard<std::mutex> lock(watch_log_lock_);
+    auto log_prefix = watchLogPrefix(range_id_);
+    if (!WatchLogEnabled()) {
+        // 残留的日志缺了这次变更，不能再用来追赶
+        if (watch_log_loaded_ && !watch_log_.exists) {
+            return write();
+        }
+        batch.DeleteRange(log_prefix, NextComparable(log_prefix));
+        auto s = write();
+        if (s.ok()) {
+            watch_log_ = WatchLogState();
+            watch_log_loaded_ = true;
+        }
+        return s;
+    }
+
+    auto s = loadWatchLog();
+    if (!s.ok()) return s;
+
+    auto state = watch_log_;
+    bool marker_changed = false;
+    if (watch_log_.exists && revision <= watch_log_.last) {
+        // revision回退，旧日志无法和新的revision排序，全部作废
+        FLOG_WARN("range[%" PRIu64 "] watch log revision %" PRId64 " <= %" PRId64 ", reset log",
+                  range_id_, revision, watch_log_.last);
+        batch.DeleteRange(watchLogKey(log_prefix, 1, 0), NextComparable(log_prefix));
+        watch_log_ = WatchLogState();
+    }
+
+    // 清理在后台做(TrimWatchLog)，不占用apply
+    if (!watch_log_.exists) {
+        // 第一次写日志，之前的变更都不在日志里
+        watch_log_.exists = true;
+        watch_log_.trimmed = revision - 1;
+        marker_changed = true;
+    }
+
+    watchpb::WatchLogEntry entry;
+    entry.set_append_time(NowNanos() / 1000000);
+    for (size_t i = 0; i < changes.size(); ++i) {
+        entry.set_key(changes[i].key);
+        entry.mutable_event()->CopyFrom(changes[i].event);
+        entry.mutable_event()->mutable_kv()->set_version(revision);
+        batch.Put(watchLogKey(log_prefix, revision, i), entry.SerializeAsString());
+    }
+    if (marker_changed) {
+        std::string trimmed;
+        EncodeUint64Ascending(&trimmed, static_cast<uint64_t>(watch_log_.trimmed));
+        batch.Put(watchLogMarker(log_prefix), trimmed);
+    }
+    watch_log_.count += changes.size();
+    watch_log_.last = revision;
+
+    s = write();
+    if (!s.ok()) {
+        watch_log_ = state;
+    }
+    return s;
+}
+
+Status Store::TrimWatchLog() {
+    std::lock_guard<std::mutex> lock(watch_log_lock_);
+    if (!WatchLogEnabled()) {
+        // 关闭日志后删掉残留的
+        if (watch_log_loaded_ && !watch_log_.exists) return Status::OK();
+        auto log_prefix = watchLogPrefix(range_id_);
+        auto ret = db_->DeleteRange(write_options_, db_->DefaultColumnFamily(), log_prefix,
+                                    NextComparable(log_prefix));
+        if (!ret.ok()) {
+            return Status(Status::kIOError, "delete watch log", ret.ToString());
+        }
+        watch_log_ = WatchLogState();
+        watch_log_loaded_ = true;
+        return Status::OK();
+    }
+
+    auto s = loadWatchLog();
+    if (!s.ok()) return s;
+    auto state = watch_log_;
+    rocksdb::WriteBatch batch;
+    if (!trimWatchLog(&batch)) {
+        return Status::OK();
+    }
+    std::string trimmed;
+    EncodeUint64Ascending(&trimmed, static_cast<uint64_t>(watch_log_.trimmed));
+    batch.Put(watchLogMarker(watchLogPrefix(range_id_)), trimmed);
+    auto ret = db_->Write(write_options_, &batch);
+    if (!ret.ok()) {
+        watch_log_ = state;
+        return Status(Status::kIOError, "trim watch log", ret.ToString());
+    }
+    return Status::OK();
+}
+
+Status Store::SplitWatchLog(const std::string& split_key, uint64_t new_range_id) {
+    if (!WatchLogEnabled()) return Status::OK();
+
+    std::lock_guard<std::mutex> lock(watch_log_lock_);
+    auto s = loadWatchLog();
+    if (!s.ok()) return s;
+    if (!watch_log_.exists) return Status::OK();
+
+    // 新range已经有日志(已经复制过或者新range先收到了快照)时不再复制
+    auto new_prefix = watchLogPrefix(new_range_id);
+    std::string value;
+    auto ret = db_->Get(rocksdb::ReadOptions(), watchLogMarker(new_prefix), &value);
+    if (ret.ok()) {
+        return Status::OK();
+    } else if (!ret.IsNotFound()) {
+        return Status(Status::kIOError, "get watch log marker", ret.ToString());
+    }
+
+    // 复制[split_key, end)内的key的变更，和标记一起在一个batch里写入
+    auto log_prefix = watchLogPrefix(range_id_);
+    auto limit = NextComparable(log_prefix);
+    auto end_key = GetEndKey();
+    rocksdb::WriteBatch batch;
+    uint64_t count = 0;
+    watchpb::WatchLogEntry entry;
+    std::unique_ptr<rocksdb::Iterator> iter(
+        newWatchLogIterator(watchLogKey(log_prefix, 1, 0)));
+    for (; iter->Valid() && iter->key().compare(limit) < 0; iter->Next()) {
+        if (!entry.ParseFromArray(iter->value().data(), static_cast<int>(iter->value().size()))) {
+            return Status(Status::kCorruption, "decode watch log",
+                          EncodeToHex(iter->key().ToString()));
+        }
+        if (entry.key() < split_key || (!end_key.empty() && entry.key() >= end_key)) {
+            continue;
+        }
+        std::string key(new_prefix);
+        key.append(iter->key().data() + log_prefix.size(), iter->key().size() - log_prefix.size());
+        batch.Put(key, iter->value());
+        ++count;
+    }
+    if (!iter->status().ok()) {
+        return Status(Status::kIOError, "read watch log", iter->status().ToString());
+    }
+    std::string trimmed;
+    EncodeUint64Ascending(&trimmed, static_cast<uint64_t>(watch_log_.trimmed));
+    batch.Put(watchLogMarker(new_prefix), trimmed);
+    ret = db_->Write(write_options_, &batch);
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "split watch log", ret.ToString());
+    }
+    FLOG_INFO("range[%" PRIu64 "] copy %" PRIu64 " watch log entries to range[%" PRIu64 "]",
+              range_id_, count, new_range_id);
+    return Status::OK();
+}
+
+Status Store::truncateWatchLog() {
+    std::lock_guard<std::mutex> lock(watch_log_lock_);
+    auto log_prefix = watchLogPrefix(range_id_);
+    auto ret = db_->DeleteRange(write_options_, db_->DefaultColumnFamily(), log_prefix,
+                                NextComparable(log_prefix));
+    if (!ret.ok()) {
+        return Status(Status::kIOError, "delete watch log", ret.ToString());
+    }
+    watch_log_ = WatchLogState();
+    watch_log_loaded_ = true;
+    return Status::OK();
+}
+
+Status Store::WatchChanges(const std::string& prefix, int64_t from,
+                           std::vector<watchpb::Event>* events) {
+    if (from < 0 || !WatchLogEnabled()) {
+        return Status(Status::kNotFound);
+    }
+
+    // 先读日志再读清理位置，读的过程中被清理掉的部分一定会反映在清理位置上
+    auto log_prefix = watchLogPrefix(range_id_);
+    auto limit = NextComparable(log_prefix);
+    std::vector<watchpb::Event> changes;
+    watchpb::WatchLogEntry entry;
+    std::unique_ptr<rocksdb::Iterator> iter(
+        newWatchLogIterator(watchLogKey(log_prefix, from + 1, 0)));
+    for (; iter->Valid() && iter->key().compare(limit) < 0; iter->Next()) {
+        if (!entry.ParseFromArray(iter->value().data(), static_cast<int>(iter->value().size()))) {
+            return Status(Status::kCorruption, "decode watch log",
+                          EncodeToHex(iter->key().ToString()));
+        }
+        if (entry.key().compare(0, prefix.size(), prefix) == 0) {
+            changes.push_back(std::move(*entry.mutable_event()));
+        }
+    }
+    if (!iter->status().ok()) {
+        return Status(Status::kIOError, "read watch log", iter->status().ToString());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(watch_log_lock_);
+        auto s = loadWatchLog();
+        if (!s.ok()) return s;
+        if (!watch_log_.exists) {
+            return Status(Status::kNotFound);
+        }
+        if (from < watch_log_.trimmed) {
+            return Status(Status::kNotFound, "watch log trimmed",
+                          std::to_string(watch_log_.trimmed));
+        }
+    }
+
+    for (auto& c : changes) {
+        events->push_back(std::move(c));
+    }
+    return Status::OK();
+}
+
 
 } /* namespace storage */
 } /* namespace dataserver */
@@ -0,0 +1,92 @@
+#include "top_n.h"
+
+#include <algorithm>
+
+#include "row_decoder.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace storage {
+
+TopNSorter::TopNSorter(
+    const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::OrderBy>& order_bys, size_t n)
+    : order_bys_(order_bys), n_(n) {
+    heap_.reserve(std::min(n_, static_cast<size_t>(1024)));
+}
+
+TopNSorter::~TopNSorter() {}
+
+int TopNSorter::compareField(int i, const FieldValue* lh, const FieldValue* rh) const {
+    int ret = 0;
+    if (lh == nullptr || rh == nullptr) {
+        ret = (lh == nullptr ? 0 : 1) - (rh == nullptr ? 0 : 1);
+    } else if (fcompare(*lh, *rh, CompareOp::kLess)) {
+        ret = -1;
+    } else if (fcompare(*lh, *rh, CompareOp::kGreater)) {
+        ret = 1;
+    }
+    return order_bys_.Get(i).desc() ? -ret : ret;
+}
+
+bool TopNSorter::less(const ItemPtr& lh, const ItemPtr& rh) const {
+    for (int i = 0; i < order_bys_.size(); ++i) {
+        int ret = compareField(i, lh->values[i].get(), rh->values[i].get());
+        if (ret != 0) return ret < 0;
+    }
+    return lh->key < rh->key;
+}
+
+bool TopNSorter::accept(const RowResult& r) const {
+    if (n_ == 0) return false;
+    if (heap_.size() < n_) return true;
+
+    const auto& last = heap_.front();
+    for (int i = 0; i < order_bys_.size(); ++i) {
+        auto f = r.GetField(order_bys_.Get(i).column().id());
+        int ret = compareField(i, f, last->values[i].get());
+        if (ret != 0) return ret < 0;
+    }
+    return r.Key() < last->key;
+}
+
+kvrpcpb::Row* TopNSorter::Push(const RowResult& r) {
+    if (!accept(r)) return nullptr;
+
+    auto cmp = [this](const ItemPtr& lh, const ItemPtr& rh) { return less(lh, rh); };
+    ItemPtr item;
+    if (heap_.size() >= n_) {
+        // 复用被挤出去的最后一行
+        std::pop_heap(heap_.begin(), heap_.end(), cmp);
+        item = std::move(heap_.back());
+        heap_.pop_back();
+        item->values.clear();
+        item->row.Clear();
+    } else {
+        item.reset(new Item);
+    }
+
+    item->values.reserve(order_bys_.size());
+    for (const auto& order_by : order_bys_) {
+        auto f = r.GetField(order_by.column().id());
+        item->values.emplace_back(f != nullptr ? CopyValue(*f) : nullptr);
+    }
+    item->key = r.Key();
+    auto row = &item->row;
+    heap_.push_back(std::move(item));
+    std::push_heap(heap_.begin(), heap_.end(), cmp);
+    return row;
+}
+
+void TopNSorter::Finish(size_t offset,
+                        ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Row>* rows) {
+    auto cmp = [this](const ItemPtr& lh, const ItemPtr& rh) { return less(lh, rh); };
+    std::sort_heap(heap_.begin(), heap_.end(), cmp);
+    for (size_t i = offset; i < heap_.size(); ++i) {
+        rows->Add()->Swap(&heap_[i]->row);
+    }
+    heap_.clear();
+}
+
+} /* namespace storage */
+} /* namespace dataserver */
+} /* namespace sharkstore */
@@ -0,0 +1,58 @@
+_Pragma("once");
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "field_value.h"
+#include "proto/gen/kvrpcpb.pb.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace storage {
+
+class RowResult;
+
+// select ... order by ... limit 下推：用大小为N的堆保留排序最靠前的N行
+// 空值排在最小，排序列都相同时按行key升序，保证结果稳定
+class TopNSorter {
+public:
+    TopNSorter(const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::OrderBy>& order_bys,
+               size_t n);
+    ~TopNSorter();
+
+    TopNSorter(const TopNSorter&) = delete;
+    TopNSorter& operator=(const TopNSorter&) = delete;
+
+    // 能进入前N时返回给这一行编码用的Row，否则返回nullptr，不进入前N的行就不用编码了
+    kvrpcpb::Row* Push(const RowResult& r);
+
+    // 按顺序输出第[offset, N)行
+    void Finish(size_t offset, ::google::protobuf::RepeatedPtrField< ::kvrpcpb::Row>* rows);
+
+    size_t Size() const { return heap_.size(); }
+
+private:
+    struct Item {
+        std::vector<std::unique_ptr<FieldValue>> values;
+        std::string key;
+        kvrpcpb::Row row;
+    };
+    using ItemPtr = std::unique_ptr<Item>;
+
+    // 比较第i个排序列，小于0表示lh排在前面
+    int compareField(int i, const FieldValue* lh, const FieldValue* rh) const;
+    // lh是否排在rh前面
+    bool less(const ItemPtr& lh, const ItemPtr& rh) const;
+    bool accept(const RowResult& r) const;
+
+private:
+    const ::google::protobuf::RepeatedPtrField< ::kvrpcpb::OrderBy>& order_bys_;
+    const size_t n_ = 0;
+    // 大顶堆，堆顶是当前排在最后的一行
+    std::vector<ItemPtr> heap_;
+};
+
+} /* namespace storage */
+} /* namespace dataserver */
+} /* namespace sharkstore */
@@ -0,0 +1,168 @@
+#include "ttl.h"
+
+#include <chrono>
+
+#include "common/ds_config.h"
+#include "common/ds_encoding.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace storage {
+
+int64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+bool ExpireSupported() {
+    return ds_config.rocksdb_config.storage_type != 1;
+}
+
+int64_t DefaultExpireAt() {
+    if (ds_config.rocksdb_config.ttl <= 0 || !ExpireSupported()) {
+        return 0;
+    }
+    return NowNanos() + static_cast<int64_t>(ds_config.rocksdb_config.ttl) * 1000000000L;
+}
+
+void EncodeStoreValue(std::string* buf, const rocksdb::Slice& value, int64_t expire_at) {
+    if (expire_at > 0) {
+        buf->reserve(buf->size() + kExpireHeaderSize + value.size());
+        buf->push_back(kValueFlagExpire);
+        EncodeUint64Ascending(buf, static_cast<uint64_t>(expire_at));
+    } else {
+        buf->reserve(buf->size() + 1 + value.size());
+        buf->push_back(kValueFlagNone);
+    }
+    buf->append(value.data(), value.size());
+}
+
+std::string EncodeStoreValue(const rocksdb::Slice& value, int64_t expire_at) {
+    std::string buf;
+    EncodeStoreValue(&buf, value, expire_at);
+    return buf;
+}
+
+bool DecodeStoreValue(const rocksdb::Slice& stored, int64_t* expire_at, rocksdb::Slice* value) {
+    if (stored.empty()) {
+        *expire_at = 0;
+        *value = stored;
+        return true;
+    }
+
+    const char* p = stored.data();
+    switch (p[0]) {
+        case kValueFlagNone:
+            *expire_at = 0;
+            *value = rocksdb::Slice(p + 1, stored.size() - 1);
+            return true;
+        case kValueFlagExpire: {
+            if (stored.size() < kExpireHeaderSize) {
+                return false;
+            }
+            uint64_t v = 0;
+            for (size_t i = 1; i < kExpireHeaderSize; ++i) {
+                v = (v << 8) | static_cast<unsigned char>(p[i]);
+            }
+            *expire_at = static_cast<int64_t>(v);
+            *value = rocksdb::Slice(p + kExpireHeaderSize, stored.size() - kExpireHeaderSize);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool StripStoreValue(std::string* stored, int64_t now, bool* corrupted) {
+    int64_t expire_at = 0;
+    rocksdb::Slice value;
+    *corrupted = !DecodeStoreValue(*stored, &expire_at, &value);
+    if (*corrupted) {
+        return false;
+    }
+    if (IsExpired(expire_at, now)) {
+        return false;
+    }
+    stored->erase(0, stored->size() - value.size());
+    return true;
+}
+
+void LegacyRanges::Add(uint64_t range_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (ranges_.emplace(range_id, std::string()).second) {
+        ++unspanned_;
+    }
+    size_ = ranges_.size();
+}
+
+void LegacyRanges::Remove(uint64_t range_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = ranges_.find(range_id);
+    if (it == ranges_.end()) return;
+    if (it->second.empty()) {
+        --unspanned_;
+    } else {
+        spans_.erase(it->second);
+    }
+    ranges_.erase(it);
+    size_ = ranges_.size();
+}
+
+bool LegacyRanges::Contains(uint64_t range_id) const {
+    if (Size() == 0) return false;
+    std::lock_guard<std::mutex> lock(mu_);
+    return ranges_.find(range_id) != ranges_.end();
+}
+
+void LegacyRanges::SetSpan(uint64_t range_id, const std::string& start,
+                           const std::string& end) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = ranges_.find(range_id);
+    // range的start key不会为空(至少有table前缀)，为空时保持未知范围
+    if (it == ranges_.end() || start.empty()) return;
+    if (it->second.empty()) {
+        --unspanned_;
+    } else {
+        spans_.erase(it->second);
+    }
+    it->second = start;
+    spans_[start] = end;
+}
+
+bool LegacyRanges::ContainsKey(const rocksdb::Slice& key) const {
+    if (Size() == 0) return false;
+    std::lock_guard<std::mutex> lock(mu_);
+    // 还有range没加载，不知道范围，都按老格式处理
+    if (unspanned_ > 0) return true;
+    // 最后一个start不大于key的范围
+    auto it = spans_.upper_bound(key.ToString());
+    if (it == spans_.begin()) return false;
+    --it;
+    return it->second.empty() || key.compare(it->second) < 0;
+}
+
+bool ExpiredFilter::Filter(int level, const rocksdb::Slice& key,
+                           const rocksdb::Slice& existing_value, std::string* new_value,
+                           bool* value_changed) const {
+    // 没有过期时间的不用解析
+    if (existing_value.empty() || existing_value[0] != kValueFlagExpire) {
+        return false;
+    }
+    int64_t expire_at = 0;
+    rocksdb::Slice value;
+    if (!DecodeStoreValue(existing_value, &expire_at, &value) || !IsExpired(expire_at, now_)) {
+        return false;
+    }
+    // 老格式的value可能恰好以这个标记开头
+    return legacy_ == nullptr || !legacy_->ContainsKey(key);
+}
+
+std::unique_ptr<rocksdb::CompactionFilter> ExpiredFilterFactory::CreateCompactionFilter(
+    const rocksdb::CompactionFilter::Context& context) {
+    return std::unique_ptr<rocksdb::CompactionFilter>(new ExpiredFilter(NowNanos(), legacy_.get()));
+}
+
+} /* namespace storage */
+} /* namespace dataserver */
+} /* namespace sharkstore */
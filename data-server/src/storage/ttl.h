@@ -0,0 +1,110 @@
+_Pragma("once");
+
+#include <rocksdb/compaction_filter.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sharkstore {
+namespace dataserver {
+namespace storage {
+
+// 数据db中每个value前面都有一个头部，记录过期时间:
+//   1字节标记 [+ 8字节过期时间(大端，unix纳秒)] + 原始value
+// 空value(索引)视为没有头部、永不过期
+static const char kValueFlagNone = '\x00';
+static const char kValueFlagExpire = '\x01';
+
+static const size_t kExpireHeaderSize = 1 + 8;
+
+// 写在meta store里的数据格式版本，老版本的数据没有value头部
+static const int kValueFormatExpireHeader = 1;
+
+int64_t NowNanos();
+
+// blob db不支持compaction filter，过期的数据无法回收，不支持过期时间
+bool ExpireSupported();
+
+// 配置了默认ttl(rocksdb.ttl)时返回当前时间加ttl，否则返回0(不过期)
+// 在提交raft命令之前计算，保证所有副本的过期时间一致
+int64_t DefaultExpireAt();
+
+inline bool IsExpired(int64_t expire_at, int64_t now) {
+    return expire_at > 0 && expire_at <= now;
+}
+
+// 在buf后面追加value头部和原始value
+void EncodeStoreValue(std::string* buf, const rocksdb::Slice& value, int64_t expire_at);
+std::string EncodeStoreValue(const rocksdb::Slice& value, int64_t expire_at);
+
+// 解析value头部，value指向原始value
+bool DecodeStoreValue(const rocksdb::Slice& stored, int64_t* expire_at, rocksdb::Slice* value);
+
+// 原地去掉value头部，已过期返回false
+bool StripStoreValue(std::string* stored, int64_t now, bool* corrupted);
+
+// 升级到value头部格式之前就有的range，数据没有头部，读写时原样处理，不支持过期
+// range id记录在meta store里，分裂出的range继承；收到快照时数据被整个替换，之后转成新格式
+// 这里记录这些range的key范围，compaction filter跳过范围内的数据
+class LegacyRanges {
+public:
+    LegacyRanges() = default;
+
+    LegacyRanges(const LegacyRanges&) = delete;
+    LegacyRanges& operator=(const LegacyRanges&) = delete;
+
+    void Add(uint64_t range_id);
+    void Remove(uint64_t range_id);
+    bool Contains(uint64_t range_id) const;
+
+    // 更新key范围，range_id不是老格式时忽略，end为空表示没有上限
+    void SetSpan(uint64_t range_id, const std::string& start, const std::string& end);
+    bool ContainsKey(const rocksdb::Slice& key) const;
+
+    size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::mutex mu_;
+    std::atomic<size_t> size_ = {0};
+    size_t unspanned_ = 0;
+    // key: range id, value: start key, 还没有设置范围时为空
+    std::unordered_map<uint64_t, std::string> ranges_;
+    // key: start key, value: end key
+    std::map<std::string, std::string> spans_;
+};
+
+// compaction时删除过期的数据
+class ExpiredFilter : public rocksdb::CompactionFilter {
+public:
+    explicit ExpiredFilter(int64_t now, const LegacyRanges* legacy = nullptr)
+        : now_(now), legacy_(legacy) {}
+
+    bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value,
+                std::string* new_value, bool* value_changed) const override;
+    const char* Name() const override { return "sharkstore.ExpiredFilter"; }
+
+private:
+    const int64_t now_;
+    const LegacyRanges* legacy_ = nullptr;
+};
+
+// 每次compaction取一次当前时间
+class ExpiredFilterFactory : public rocksdb::CompactionFilterFactory {
+public:
+    explicit ExpiredFilterFactory(std::shared_ptr<LegacyRanges> legacy = nullptr)
+        : legacy_(std::move(legacy)) {}
+
+    std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
+        const rocksdb::CompactionFilter::Context& context) override;
+    const char* Name() const override { return "sharkstore.ExpiredFilterFactory"; }
+
+private:
+    std::shared_ptr<LegacyRanges> legacy_;
+};
+
+} /* namespace storage */
+} /* namespace dataserver */
+} /* namespace sharkstore */
@@ -1,7 +1,12 @@
 
 #include "watch_server.h"
+
+#include <unordered_map>
+
+#include "base/status.h"
 #include "frame/sf_logger.h"
 #include "common/ds_encoding.h"
+#include "proto/gen/watchpb.pb.h"
 
 namespace sharkstore {
 namespace dataserver {
@@ -13,12 +18,15 @@ WatchServer::WatchServer(uint64_t watcher_set_count): watcher_set_count_(watcher
     watcher_set_count_ = watcher_set_count_ > WATCHER_SET_COUNT_MIN ? watcher_set_count_ : WATCHER_SET_COUNT_MIN;
     watcher_set_count_ = watcher_set_count_ < WATCHER_SET_COUNT_MAX ? watcher_set_count_ : WATCHER_SET_COUNT_MAX;
 
+    timer_.reset(new WatcherTimer([this](std::vector<WatcherPtr>& expired) { onExpire(expired); },
+                                  [this](int64_t now_ms) { onTick(now_ms); }));
     for (uint64_t i = 0; i < watcher_set_count_; ++i) {
-        watcher_set_list.push_back(new WatcherSet());
+        watcher_set_list.push_back(new WatcherSet(timer_.get()));
     }
 }
 
 WatchServer::~WatchServer() {
+    timer_->Stop();
     for (auto watcher_set: watcher_set_list) {
        delete(watcher_set);
     }
@@ -105,6 +113,90 @@ WatchCode WatchServer::GetPrefixWatchers(const watchpb::EventType &evtType, std:
 
 
 
+void WatchServer::onExpire(std::vector<WatcherPtr>& expired) {
+    auto begin = get_micro_second();
+
+    // 按watcher set分组，每个set加一次锁删除
+    std::unordered_map<WatcherSet*, std::vector<WatcherPtr>> groups;
+    for (auto& w : expired) {
+        // 流式watch的拉取不在watcher set里
+        if (w->GetWatcherSet() != nullptr) {
+            groups[w->GetWatcherSet()].push_back(w);
+        }
+    }
+    for (auto& g : groups) {
+        g.first->DelExpiredWatchers(g.second);
+    }
+
+    // 不持有任何锁回复超时
+    for (auto& w : expired) {
+        auto resp = new watchpb::DsWatchResponse;
+        resp->mutable_resp()->set_code(Status::kTimedOut);
+        resp->mutable_resp()->set_watchid(w->GetWatcherId());
+        w->Send(resp);
+    }
+
+    FLOG_INFO("watcher timeout: %zu watchers, %zu sets, take time: %" PRId64 " us, waiting: %zu",
+              expired.size(), groups.size(), get_micro_second() - begin, timer_->Size());
+}
+
+void WatchServer::onTick(int64_t now_ms) {
+    // 每秒清理一次空闲的流
+    if (now_ms - last_sweep_ms_ < 1000) return;
+    last_sweep_ms_ = now_ms;
+
+    auto removed = streams_.Sweep(now_ms);
+    if (removed > 0) {
+        FLOG_INFO("watch stream: %zu idle streams removed, remain: %zu", removed, streams_.Size());
+    }
+}
+
+void WatchServer::PollStream(const WatchStreamPtr& stream, WatcherPtr& w_ptr, int64_t ack, uint32_t credits) {
+    if (credits == 0) {
+        credits = WatchStreamManager::kDefaultCredits;
+    }
+    w_ptr->SetWatcherId(stream->Id());
+
+    watchpb::DsWatchResponse* resp = nullptr;
+    WatcherPtr replaced;
+    bool ready = stream->Poll(w_ptr, ack, credits, &resp, &replaced);
+
+    if (replaced != nullptr) {
+        auto empty = new watchpb::DsWatchResponse;
+        empty->mutable_resp()->set_code(Status::kOk);
+        empty->mutable_resp()->set_watchid(stream->Id());
+        empty->mutable_resp()->set_revision(ack);
+        replaced->Send(empty);
+    }
+
+    if (ready) {
+        w_ptr->Send(resp);
+    } else {
+        // 挂起期间已经被事件回复了的，SetTimer会立即取消
+        w_ptr->SetTimer(timer_.get(), timer_->Add(w_ptr, w_ptr->GetExpireTime() / 1000));
+    }
+}
+
+int32_t WatchServer::NotifyStreams(const watchpb::Event& evt, int64_t revision, const WatcherKey& key,
+                                   const PrefixKey* prefix) {
+    std::vector<WatchStreamPtr> streams;
+    streams_.Find(key, false, &streams);
+    if (prefix != nullptr) {
+        streams_.Find(*prefix, true, &streams);
+    }
+
+    int32_t count = 0;
+    for (auto& stream : streams) {
+        WatcherPtr poll;
+        watchpb::DsWatchResponse* resp = nullptr;
+        if (stream->Append(evt, revision, &poll, &resp)) {
+            poll->Send(resp);
+            ++count;
+        }
+    }
+    return count;
+}
+
 } // namepsace watch
 }
 }
@@ -3,8 +3,10 @@
 
 #include <vector>
 #include <mutex>
+#include <memory>
 
 #include "watcher_set.h"
+#include "watch_stream.h"
 
 namespace sharkstore {
 namespace dataserver {
@@ -15,7 +17,7 @@ namespace watch {
 
 class WatchServer {
 public:
-    WatchServer() = default;
+    WatchServer() : WatchServer(WATCHER_SET_COUNT_MIN) {}
     explicit WatchServer(uint64_t watcher_set_count);
     WatchServer(const WatchServer&) = delete;
     WatchServer& operator=(const WatchServer&) = delete;
@@ -30,9 +32,33 @@ public:
     WatchCode GetKeyWatchers(const watchpb::EventType &evtType, std::vector<WatcherPtr>&, const WatcherKey&, const WatcherKey&, const int64_t &version);
     WatchCode GetPrefixWatchers(const watchpb::EventType &evtType, std::vector<WatcherPtr>&, const PrefixKey &, const PrefixKey &, const int64_t &version);
 
+    // 等待超时的watcher个数
+    size_t TimerSize() const { return timer_->Size(); }
+
+    // 流式watch
+    WatchStreamPtr GetStream(int64_t id, uint64_t table_id, const WatcherKey& key) {
+        return streams_.Get(id, table_id, key);
+    }
+    WatchStreamPtr AddStream(uint64_t table_id, bool prefix, const WatcherKey& key) {
+        return streams_.Add(table_id, prefix, key);
+    }
+    // 有缓存的事件时立即回复，否则挂起到有事件或者超时
+    void PollStream(const WatchStreamPtr& stream, WatcherPtr& w_ptr, int64_t ack, uint32_t credits);
+    // 通知key和前缀上的流式watch，返回通知的个数
+    int32_t NotifyStreams(const watchpb::Event& evt, int64_t revision, const WatcherKey& key,
+                          const PrefixKey* prefix);
+    size_t StreamCount() const { return streams_.Size(); }
+
+private:
+    void onExpire(std::vector<WatcherPtr>& expired);
+    void onTick(int64_t now_ms);
+
 private:
     uint64_t                    watcher_set_count_ = WATCHER_SET_COUNT_MIN;
     std::vector<WatcherSet*>    watcher_set_list;
+    WatchStreamManager          streams_;
+    int64_t                     last_sweep_ms_ = 0;
+    std::unique_ptr<WatcherTimer> timer_;
 
 public:
     WatcherSet* GetWatcherSet_(const WatcherKey&);
@@ -0,0 +1,198 @@
+#include "watch_stream.h"
+
+#include "base/status.h"
+#include "frame/sf_logger.h"
+#include "frame/sf_util.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace watch {
+
+WatchStream::WatchStream(int64_t id, uint64_t table_id, bool prefix, const WatcherKey& key,
+                         size_t max_pending)
+    : id_(id),
+      table_id_(table_id),
+      prefix_(prefix),
+      key_(key),
+      max_pending_(max_pending),
+      last_poll_ms_(get_micro_second() / 1000) {}
+
+bool WatchStream::Append(const watchpb::Event& evt, int64_t revision, WatcherPtr* poll,
+                         watchpb::DsWatchResponse** resp) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (overflow_) return false;
+
+    if (events_.size() >= max_pending_) {
+        // 客户端太久没有拉取，丢掉缓存，下次拉取时重新加载
+        FLOG_WARN("watch stream %" PRId64 " overflow, %zu events dropped", id_, events_.size());
+        events_.clear();
+        overflow_ = true;
+        return false;
+    }
+    events_.emplace_back(revision, evt);
+    events_.back().second.mutable_kv()->set_version(revision);
+
+    if (poll_ == nullptr) return false;
+    *poll = std::move(poll_);
+    poll_ = nullptr;
+    *resp = takeBatch(credits_);
+    return true;
+}
+
+bool WatchStream::Poll(const WatcherPtr& poll, int64_t ack, uint32_t credits,
+                       watchpb::DsWatchResponse** resp, WatcherPtr* replaced) {
+    std::lock_guard<std::mutex> lock(mu_);
+    last_poll_ms_ = get_micro_second() / 1000;
+
+    while (!events_.empty() && events_.front().first <= ack) {
+        events_.pop_front();
+    }
+
+    // 客户端重连之后之前的拉取已经没用了
+    if (poll_ != nullptr) {
+        *replaced = std::move(poll_);
+        poll_ = nullptr;
+    }
+
+    if (!events_.empty()) {
+        *resp = takeBatch(credits);
+        return true;
+    }
+    poll_ = poll;
+    credits_ = credits;
+    return false;
+}
+
+watchpb::DsWatchResponse* WatchStream::takeBatch(uint32_t credits) {
+    auto ds_resp = new watchpb::DsWatchResponse;
+    auto resp = ds_resp->mutable_resp();
+    resp->set_code(Status::kOk);
+    resp->set_watchid(id_);
+    resp->set_scope(watchpb::RESPONSE_PART);
+
+    // 事件留到客户端确认之后再删除
+    // 同一个revision的事件(比如一次前缀删除)不拆开，否则按revision确认时会丢掉后半部分
+    int64_t revision = 0;
+    for (const auto& e : events_) {
+        if (static_cast<uint32_t>(resp->events_size()) >= credits && e.first != revision) {
+            break;
+        }
+        resp->add_events()->CopyFrom(e.second);
+        revision = e.first;
+    }
+    resp->set_revision(revision);
+    return ds_resp;
+}
+
+bool WatchStream::Overflowed() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return overflow_;
+}
+
+void WatchStream::Reset() {
+    std::lock_guard<std::mutex> lock(mu_);
+    events_.clear();
+    overflow_ = false;
+}
+
+bool WatchStream::IdleSince(int64_t since_ms) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (poll_ != nullptr && !poll_->IsSentResponse()) {
+        return false;
+    }
+    return last_poll_ms_ < since_ms;
+}
+
+int64_t WatchStream::LastPollMs() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return last_poll_ms_;
+}
+
+size_t WatchStream::Pending() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return events_.size();
+}
+
+const uint32_t WatchStreamManager::kDefaultCredits;
+const size_t WatchStreamManager::kMaxPending;
+const int64_t WatchStreamManager::kIdleTimeoutMs;
+
+// id从启动时间开始，重启之后不会和之前的重复
+WatchStreamManager::WatchStreamManager() : next_id_(get_micro_second()) {}
+
+WatchStreamPtr WatchStreamManager::Get(int64_t id, uint64_t table_id, const WatcherKey& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = streams_.find(id);
+    if (it == streams_.end()) return nullptr;
+
+    auto& stream = it->second;
+    if (stream->TableId() != table_id || stream->Key() != key) {
+        return nullptr;
+    }
+    lru_.splice(lru_.end(), lru_, stream->lru_it_);
+    return stream;
+}
+
+WatchStreamPtr WatchStreamManager::Add(uint64_t table_id, bool prefix, const WatcherKey& key) {
+    auto stream = std::make_shared<WatchStream>(++next_id_, table_id, prefix, key, kMaxPending);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    streams_.emplace(stream->Id(), stream);
+    auto& index = prefix ? prefix_streams_ : key_streams_;
+    index[key].emplace(stream->Id(), stream);
+    stream->lru_it_ = lru_.insert(lru_.end(), stream);
+    return stream;
+}
+
+void WatchStreamManager::Find(const WatcherKey& key, bool prefix,
+                              std::vector<WatchStreamPtr>* streams) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto& index = prefix ? prefix_streams_ : key_streams_;
+    auto it = index.find(key);
+    if (it == index.end()) return;
+    for (const auto& s : it->second) {
+        streams->push_back(s.second);
+    }
+}
+
+size_t WatchStreamManager::Sweep(int64_t now_ms) {
+    auto since = now_ms - kIdleTimeoutMs;
+    size_t removed = 0;
+
+    std::lock_guard<std::mutex> lock(mu_);
+    // 前面的是最久没有拉取的，挂着拉取的放到后面继续检查
+    for (auto n = lru_.size(); n > 0 && !lru_.empty(); --n) {
+        auto stream = lru_.front();
+        if (stream->IdleSince(since)) {
+            remove(stream);
+            ++removed;
+        } else if (stream->LastPollMs() >= since) {
+            break;
+        } else {
+            lru_.splice(lru_.end(), lru_, stream->lru_it_);
+        }
+    }
+    return removed;
+}
+
+size_t WatchStreamManager::Size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return streams_.size();
+}
+
+void WatchStreamManager::remove(const WatchStreamPtr& stream) {
+    auto& index = stream->IsPrefix() ? prefix_streams_ : key_streams_;
+    auto it = index.find(stream->Key());
+    if (it != index.end()) {
+        it->second.erase(stream->Id());
+        if (it->second.empty()) {
+            index.erase(it);
+        }
+    }
+    lru_.erase(stream->lru_it_);
+    streams_.erase(stream->Id());
+}
+
+} // namespace watch
+}
+}
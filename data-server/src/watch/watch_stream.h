@@ -0,0 +1,125 @@
+_Pragma("once");
+
+#include <atomic>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "proto/gen/watchpb.pb.h"
+#include "watch.h"
+#include "watcher.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace watch {
+
+// 流式watch，收到事件之后不删除，一直注册到客户端不再拉取为止
+// 事件按revision(raft index)追加到缓存里，客户端拉取时带上已经收到的revision作为确认，
+// 确认之前的事件一直保留，断线重连之后用同一个id从确认的位置继续
+// 同一时间只有一个等待中的拉取，有事件时立即回复，一次最多回复credits个事件
+class WatchStream {
+public:
+    WatchStream(int64_t id, uint64_t table_id, bool prefix, const WatcherKey& key,
+                size_t max_pending);
+
+    WatchStream(const WatchStream&) = delete;
+    WatchStream& operator=(const WatchStream&) = delete;
+
+    int64_t Id() const { return id_; }
+    uint64_t TableId() const { return table_id_; }
+    bool IsPrefix() const { return prefix_; }
+    const WatcherKey& Key() const { return key_; }
+
+    // 追加一个事件，有等待中的拉取时返回true，resp是要回复给poll的内容
+    bool Append(const watchpb::Event& evt, int64_t revision, WatcherPtr* poll,
+                watchpb::DsWatchResponse** resp);
+
+    // 一次拉取，先丢掉不大于ack的事件
+    // 有事件时返回true，resp是要回复的内容；没有时poll挂起等待下一个事件
+    // 之前挂起的拉取放到replaced里，由调用方回复
+    bool Poll(const WatcherPtr& poll, int64_t ack, uint32_t credits,
+              watchpb::DsWatchResponse** resp, WatcherPtr* replaced);
+
+    // 缓存超过上限丢了事件，客户端需要从存储重新加载
+    bool Overflowed() const;
+    // 重新加载之前清空缓存
+    void Reset();
+
+    // 没有等待中的拉取，并且在since_ms之后没有拉取过
+    bool IdleSince(int64_t since_ms) const;
+    int64_t LastPollMs() const;
+    size_t Pending() const;
+
+private:
+    watchpb::DsWatchResponse* takeBatch(uint32_t credits);
+
+private:
+    const int64_t id_;
+    const uint64_t table_id_;
+    const bool prefix_;
+    const WatcherKey key_;
+    const size_t max_pending_;
+
+    mutable std::mutex mu_;
+    // 还没有确认的事件，revision递增
+    std::deque<std::pair<int64_t, watchpb::Event>> events_;
+    bool overflow_ = false;
+    uint32_t credits_ = 0;
+    WatcherPtr poll_;
+    int64_t last_poll_ms_ = 0;
+
+    friend class WatchStreamManager;
+    std::list<std::shared_ptr<WatchStream>>::iterator lru_it_;
+};
+
+typedef std::shared_ptr<WatchStream> WatchStreamPtr;
+
+// 节点上所有的流式watch，按key和前缀索引，长时间没有拉取的定期清理
+class WatchStreamManager {
+public:
+    // 一次回复默认最多带的事件个数
+    static const uint32_t kDefaultCredits = 128;
+    // 每个流最多缓存的事件个数
+    static const size_t kMaxPending = 4096;
+    // 多长时间没有拉取的流被删除(毫秒)
+    static const int64_t kIdleTimeoutMs = 60 * 1000;
+
+    WatchStreamManager();
+
+    WatchStreamManager(const WatchStreamManager&) = delete;
+    WatchStreamManager& operator=(const WatchStreamManager&) = delete;
+
+    // 按id查找，key不一致(比如服务端重启后id被重用)时返回空
+    WatchStreamPtr Get(int64_t id, uint64_t table_id, const WatcherKey& key);
+    WatchStreamPtr Add(uint64_t table_id, bool prefix, const WatcherKey& key);
+
+    // 单key和前缀的流
+    void Find(const WatcherKey& key, bool prefix, std::vector<WatchStreamPtr>* streams) const;
+
+    // 删除空闲的流，返回删除的个数
+    size_t Sweep(int64_t now_ms);
+
+    size_t Size() const;
+
+private:
+    typedef std::unordered_map<WatcherKey, std::unordered_map<int64_t, WatchStreamPtr>> KeyIndex;
+
+    void remove(const WatchStreamPtr& stream);
+
+private:
+    std::atomic<int64_t> next_id_;
+
+    mutable std::mutex mu_;
+    std::unordered_map<int64_t, WatchStreamPtr> streams_;
+    KeyIndex key_streams_;
+    KeyIndex prefix_streams_;
+    // 按拉取时间排序，最久没有拉取的在前面
+    std::list<WatchStreamPtr> lru_;
+};
+
+} // namespace watch
+}
+}
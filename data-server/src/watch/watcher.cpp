@@ -1,4 +1,5 @@
 #include "watcher.h"
+#include "watcher_timer.h"
 #include "common/socket_session_impl.h"
 #include "common/ds_encoding.h"
 
@@ -40,32 +41,82 @@ Watcher::Watcher(uint64_t table_id, const std::vector<WatcherKey*>& keys):table_
 }
 
 Watcher::~Watcher() {
-    /*for (auto k: keys_) {
+    // keys_hash_里的指针和keys_共用
+    for (auto k: keys_) {
         delete k;
-    }*/
+    }
 }
 /*
 bool Watcher::operator>(const Watcher* other) const {
     return this->message_->expire_time > other->message_->expire_time;
 }
 */
-void Watcher::Send(google::protobuf::Message* resp) {
-    std::lock_guard<std::mutex> lock(send_lock_);
-    if (sent_response_flag) {
-        return;
+void Watcher::SetTimer(WatcherTimer* timer, uint64_t timer_id) {
+    {
+        std::lock_guard<std::mutex> lock(send_lock_);
+        if (!sent_response_flag) {
+            timer_ = timer;
+            timer_id_ = timer_id;
+            return;
+        }
     }
+    timer->Cancel(timer_id);
+}
 
-    uint32_t take_time = get_micro_second() - message_->begin_time;
+bool Watcher::sendOnce(const std::function<void(common::SocketSessionImpl&)>& send) {
+    uint64_t timer_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(send_lock_);
+        if (sent_response_flag) {
+            return false;
+        }
 
-    FLOG_DEBUG("before send, session_id: %" PRId64 ",task msgid: %" PRId64
-               " execute take time: %d us",
-               message_->session_id, message_->msg_id, take_time);
+        uint32_t take_time = get_micro_second() - message_->begin_time;
 
+        FLOG_DEBUG("before send, session_id: %" PRId64 ",task msgid: %" PRId64
+                   " execute take time: %d us",
+                   message_->session_id, message_->msg_id, take_time);
 
-    common::SocketSessionImpl session;
-    session.Send(message_, resp);
 
-    sent_response_flag = true;
+        common::SocketSessionImpl session;
+        send(session);
+
+        sent_response_flag = true;
+        std::swap(timer_id, timer_id_);
+    }
+
+    // 回复之后立即取消超时定时器，释放定时器里的引用
+    if (timer_id != 0) {
+        timer_->Cancel(timer_id);
+    }
+    return true;
+}
+
+void Watcher::Send(google::protobuf::Message* resp) {
+    auto sent = sendOnce([this, resp](common::SocketSessionImpl& session) {
+        session.Send(message_, resp);
+    });
+    if (!sent) {
+        delete resp;
+    }
+}
+
+void Watcher::Send(const NotifyBody& body) {
+    sendOnce([this, &body](common::SocketSessionImpl& session) {
+        session.Send(message_, EncodeNotifyHead(watcher_id_), *body);
+    });
+}
+
+NotifyBody Watcher::EncodeNotify(const watchpb::DsWatchResponse& resp) {
+    auto body = std::make_shared<std::string>();
+    resp.SerializeToString(body.get());
+    return body;
+}
+
+std::string Watcher::EncodeNotifyHead(WatcherId id) {
+    watchpb::DsWatchResponse head;
+    head.mutable_resp()->set_watchid(id);
+    return head.SerializeAsString();
 }
 
 bool Watcher::DecodeKey(std::vector<std::string*>& keys,
@@ -4,6 +4,8 @@
 #include <mutex>
 #include <unordered_map>
 #include <atomic>
+#include <functional>
+#include <memory>
 
 #include "watch.h"
 #include "common/socket_session.h"
@@ -11,8 +13,17 @@
 
 namespace sharkstore {
 namespace dataserver {
+namespace common {
+class SocketSessionImpl;
+}
 namespace watch {
 
+class WatcherTimer;
+class WatcherSet;
+
+// 编码好的通知内容，不带watch id，同一个key和版本的watcher共用一份
+typedef std::shared_ptr<const std::string> NotifyBody;
+
 class Watcher {
 public:
     Watcher() = delete;
@@ -46,6 +57,15 @@ private:
     std::mutex          send_lock_;
     volatile bool       sent_response_flag = false;
 
+    // 所在的watcher set和在set里的key，加入时设置，超时删除时不用重新编码
+    WatcherSet*         watcher_set_ = nullptr;
+    WatcherKey          encode_key_;
+    WatcherTimer*       timer_ = nullptr;
+    uint64_t            timer_id_ = 0;
+
+    // 只回复一次，已经回复过时返回false
+    bool sendOnce(const std::function<void(common::SocketSessionImpl&)>& send);
+
 public:
     uint64_t GetTableId() { return table_id_; }
     const std::vector<std::string*>& GetKeys(bool hashFlag = true) {
@@ -71,8 +91,24 @@ public:
     int64_t GetMsgId() const {
         return msg_id_;
     }
+
+    void SetWatcherSet(WatcherSet* ws, const WatcherKey& key) {
+        watcher_set_ = ws;
+        encode_key_ = key;
+    }
+    WatcherSet* GetWatcherSet() const { return watcher_set_; }
+    const WatcherKey& GetEncodeKey() const { return encode_key_; }
+
+    // 注册超时定时器，已经回复过的直接取消
+    void SetTimer(WatcherTimer* timer, uint64_t timer_id);
 public:
     virtual void Send(google::protobuf::Message* resp);
+    // 发送共用的通知内容，每个watcher只单独编码watch id
+    void Send(const NotifyBody& body);
+
+    // DsWatchResponse只编码一次，两段编码拼接起来解析时合并成一个消息
+    static NotifyBody EncodeNotify(const watchpb::DsWatchResponse& resp);
+    static std::string EncodeNotifyHead(WatcherId id);
 
     static bool DecodeKey(std::vector<std::string*>& keys,
                    const std::string& buf);
@@ -87,14 +123,6 @@ public:
 
 };
 
-template <class T>
-struct Greater {
-    bool operator()(const T& a, const T& b) {
-        return a->GetMessage()->expire_time > b->GetMessage()->expire_time;
-        //return a > b;
-    }
-};
-
 /*
 class KeyWatcher: public Watcher {
 public:
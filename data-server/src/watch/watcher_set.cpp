@@ -11,104 +11,16 @@ namespace sharkstore {
 namespace dataserver {
 namespace watch {
 
-WatcherSet::WatcherSet() {
-    watcher_timer_ = std::thread([this]() {
-        while (watcher_timer_continue_flag_) {
-            std::unique_lock<std::mutex> lock(watcher_queue_mutex_);
-
-            // watcher queue is empty, sleep 10ms
-            if (watcher_queue_.empty()) {
-                watcher_expire_cond_.wait_for(lock, std::chrono::milliseconds(1000));
-                //watcher_expire_cond_.wait(lock);
-            }
-
-            // find the first wait watcher
-            WatcherPtr w_ptr = nullptr;
-            while (!watcher_queue_.empty()) {
-                w_ptr = watcher_queue_.top();
-                if (w_ptr->IsSentResponse()) {
-                    // repsonse is sent, delete watcher in map and queue
-                    // delete in map
-                    WatcherKey encode_key;
-                    w_ptr->EncodeKey(&encode_key, w_ptr->GetTableId(), w_ptr->GetKeys(false));
-                    if (w_ptr->GetType() == WATCH_KEY) {
-                        DelKeyWatcher(encode_key, w_ptr->GetWatcherId());
-                    } else {
-                        DelPrefixWatcher(encode_key, w_ptr->GetWatcherId());
-                    }
-
-                    watcher_queue_.pop();
-
-                    FLOG_INFO("watcher is sent response, timer queue pop : watch_id:[%" PRIu64 "] key: [%s]",
-                               w_ptr->GetWatcherId(), EncodeToHexString(encode_key).c_str());
-                    w_ptr = nullptr;
-                } else {
-                    break;
-                }
-            }
-            if (w_ptr == nullptr) {
-                continue; // no valid watcher wait in queue
-            }
-
-            auto mill_sec = std::chrono::milliseconds(w_ptr->GetExpireTime()/1000);
-            std::chrono::system_clock::time_point expire(mill_sec);
-
-            int64_t  waitBeginTime{w_ptr->GetMessage()->begin_time};
-
-            if (watcher_expire_cond_.wait_until(lock, expire) == std::cv_status::timeout) {
-                auto excBegin = get_micro_second();
-                // send timeout response
-                auto resp = new watchpb::DsWatchResponse;
-                resp->mutable_resp()->set_code(Status::kTimedOut);
-
-//                auto err = new errorpb::Error();
-//                err->set_message("watch request timeout");
-//                resp->mutable_header()->set_allocated_error(err);
-
-                w_ptr->Send(resp);
-
-                // delete in map
-                WatcherKey encode_key;
-                w_ptr->EncodeKey(&encode_key, w_ptr->GetTableId(), w_ptr->GetKeys());
-                if (w_ptr->GetType() == WATCH_KEY) {
-                    DelKeyWatcher(encode_key, w_ptr->GetWatcherId());
-                } else {
-                    DelPrefixWatcher(encode_key, w_ptr->GetWatcherId());
-                }
-
-                watcher_queue_.pop();
-
-                auto excEnd = get_micro_second();
-                //auto take_time = excEnd - waitBeginTime;
-
-                FLOG_INFO("key: [%s] wait_until....session_id: %" PRId64 ",task msgid: %" PRId64 " watcher_id:%" PRId64
-                                   " execute take time: %" PRId64 " us,wait time:%" PRId64 " us",
-                           EncodeToHexString(encode_key).c_str(), w_ptr->GetMessage()->session_id, w_ptr->GetMsgId(),
-                           w_ptr->GetWatcherId(), excEnd-excBegin,excBegin-waitBeginTime);
-
-                FLOG_DEBUG("timeout: msg->begin_time:%" PRId64 "us expire:%" PRId64 "ms now:%" PRId64 "us",
-                           w_ptr->GetMessage()->begin_time, w_ptr->GetExpireTime(), excEnd);
-
-//                FLOG_INFO("watcher expire timeout, timer queue pop: session_id: %" PRId64 " watch_id:[%" PRIu64 "] key: [%s]",
-//                          w_ptr->GetMessage()->session_id, w_ptr->GetWatcherId(), EncodeToHexString(encode_key).c_str());
-            }
-        }
-        FLOG_DEBUG("thread exit...");
-    });
+WatcherSet::WatcherSet(WatcherTimer* timer) : timer_(timer) {
 }
 
 WatcherSet::~WatcherSet() {
-    watcher_timer_continue_flag_ = false;
-    {
-        std::unique_lock<std::mutex> lock(watcher_queue_mutex_);
-        watcher_expire_cond_.notify_one();
-    }
-    watcher_timer_.join();
-
     for(auto it : key_watcher_map_) {
         if(it.second != nullptr) delete it.second;
     }
-    // todo leave members' memory alone now, todo free
+    for(auto it : prefix_watcher_map_) {
+        if(it.second != nullptr) delete it.second;
+    }
 }
 
 
@@ -116,7 +28,6 @@ WatcherSet::~WatcherSet() {
 WatchCode WatcherSet::AddWatcher(const WatcherKey& key, WatcherPtr& w_ptr, WatcherMap& key_watchers, KeyMap& key_map, storage::Store *store_, bool prefixFlag ) {
     int64_t beginTime(getticks());
 
-    std::unique_lock<std::mutex> lock_queue(watcher_queue_mutex_);
     std::lock_guard<std::mutex> lock_map(watcher_map_mutex_);
 
     WatchCode code;
@@ -138,8 +49,26 @@ WatchCode WatcherSet::AddWatcher(const WatcherKey& key, WatcherPtr& w_ptr, Watch
             std::pair<int64_t, bool> result = std::make_pair(0, false);
 
             if(prefixFlag) {
-                //用户端版本低于内存版本时，需要全量
+                //用户端版本低于内存版本时，先从变更日志追赶，日志也不够时再全量
+                int32_t logCnt(-1);
                 if(w_ptr->getBufferFlag() < 0) {
+                    std::string hashKey;
+                    Watcher::EncodeKey(&hashKey, w_ptr->GetTableId(), w_ptr->GetKeys());
+                    auto log_resp = new watchpb::DsWatchResponse;
+                    logCnt = loadFromLog(store_, key, clientVersion, log_resp);
+                    FLOG_DEBUG("prefix mode: version:%" PRId64 " loadFromLog count:%" PRId32, clientVersion, logCnt);
+                    if (logCnt > 0) {
+                        w_ptr->Send(log_resp);
+                        return WATCH_OK;
+                    }
+                    delete log_resp;
+                    if (logCnt == 0) {
+                        ret = Status(Status::kNotChange);
+                        version = clientVersion;
+                    }
+                }
+
+                if(w_ptr->getBufferFlag() < 0 && logCnt < 0) {
 
                     std::string endKey(key);
                     if (0 != range::WatchEncodeAndDecode::NextComparableBytes(key.data(), key.length(), endKey)) {
@@ -263,9 +192,9 @@ WatchCode WatcherSet::AddWatcher(const WatcherKey& key, WatcherPtr& w_ptr, Watch
         //add to key_map_
         //key_map.emplace(std::make_pair(watcher_id, key));
 
-        // add to queue
-        watcher_queue_.push(w_ptr);
-        watcher_expire_cond_.notify_one();
+        // 超时回调要加map锁删除，在这之后才会执行
+        w_ptr->SetWatcherSet(this, key);
+        w_ptr->SetTimer(timer_, timer_->Add(w_ptr, w_ptr->GetExpireTime() / 1000));
 
         code = WATCH_OK;
 
@@ -318,9 +247,19 @@ WatchCode WatcherSet::DelWatcher(const WatcherKey& key, WatcherId watcher_id, Wa
     }
     */
 
+    DelWatcherLocked(key, watcher_id, watcher_map_);
+
+    int64_t endTime(getticks());
+    FLOG_INFO("watcher del end: watch_id:[%" PRIu64 "] key: [%s] take time:%" PRId64 " ms",
+              watcher_id, EncodeToHexString(key).c_str(), endTime - beginTime);
+
+    return WATCH_OK;
+}
+
+void WatcherSet::DelWatcherLocked(const WatcherKey& key, WatcherId watcher_id, WatcherMap& watcher_map) {
     // del from watcher map
-    auto watcher_map_it = watcher_map_.find(key);
-    if (watcher_map_it == watcher_map_.end()) {
+    auto watcher_map_it = watcher_map.find(key);
+    if (watcher_map_it == watcher_map.end()) {
         FLOG_WARN("watcher del failed, key is not existed in watcher map: watch_id:[%" PRIu64 "] key: [%s]",
                   watcher_id, EncodeToHexString(key).c_str());
 
@@ -347,15 +286,18 @@ WatchCode WatcherSet::DelWatcher(const WatcherKey& key, WatcherId watcher_id, Wa
         }
 
         if (watcher_map_it->second->mapKeyWatcher.empty()) {
-            watcher_map_.erase(watcher_map_it);
+            delete watcher_map_it->second;
+            watcher_map.erase(watcher_map_it);
         }
     }
+}
 
-    int64_t endTime(getticks());
-    FLOG_INFO("watcher del end: watch_id:[%" PRIu64 "] key: [%s] take time:%" PRId64 " ms",
-              watcher_id, EncodeToHexString(key).c_str(), endTime - beginTime);
-
-    return WATCH_OK;
+void WatcherSet::DelExpiredWatchers(const std::vector<WatcherPtr>& watchers) {
+    std::lock_guard<std::mutex> lock(watcher_map_mutex_);
+    for (auto& w : watchers) {
+        auto& watcher_map = (w->GetType() == WATCH_KEY) ? key_watcher_map_ : prefix_watcher_map_;
+        DelWatcherLocked(w->GetEncodeKey(), w->GetWatcherId(), watcher_map);
+    }
 }
 
 WatchCode WatcherSet::GetWatchers(const watchpb::EventType &evtType, std::vector<WatcherPtr>& vec, const WatcherKey& key, WatcherMap& watcherMap, WatcherValue *watcherValue, bool prefixFlag) {
@@ -382,6 +324,7 @@ WatchCode WatcherSet::GetWatchers(const watchpb::EventType &evtType, std::vector
         watchers->mapKeyWatcher.swap(watcherValue->mapKeyWatcher);
 
         watcherMap.erase(itWatcherVal);
+        delete watchers;
         FLOG_INFO("watcher get success,count:%" PRIu64 " key: [%s] watch_id[%" PRId64 "]",
                   watcherValue->mapKeyWatcher.size(), EncodeToHexString(key).c_str(), watcherValue->mapKeyWatcher.begin()->first );
         return WATCH_OK;
@@ -523,6 +466,27 @@ std::pair<int32_t, bool> WatcherSet::loadFromDb(storage::Store *store, const wat
     return result;
 }
 
+int32_t WatcherSet::loadFromLog(storage::Store *store, const std::string &prefixKey,
+                                const int64_t &startVersion, watchpb::DsWatchResponse *dsResp) {
+    if (startVersion <= 0) return -1;
+
+    std::vector<watchpb::Event> events;
+    auto ret = store->WatchChanges(prefixKey, startVersion, &events);
+    if (!ret.ok()) {
+        FLOG_DEBUG("loadFromLog miss, key:%s version:%" PRId64 " ret:%s", EncodeToHexString(prefixKey).c_str(),
+                   startVersion, ret.ToString().c_str());
+        return -1;
+    }
+
+    auto resp = dsResp->mutable_resp();
+    resp->set_code(Status::kOk);
+    resp->set_scope(watchpb::RESPONSE_PART);
+    for (auto &evt : events) {
+        resp->add_events()->Swap(&evt);
+    }
+    return static_cast<int32_t>(events.size());
+}
+
 } // namespace watch
 }
 }
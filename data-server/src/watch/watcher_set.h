@@ -3,13 +3,11 @@
 
 #include <unordered_map>
 #include <vector>
-#include <queue>
-#include <condition_variable>
 #include <mutex>
-#include <thread>
 
 #include "watch.h"
 #include "watcher.h"
+#include "watcher_timer.h"
 #include "storage/store.h"
 
 namespace sharkstore {
@@ -29,16 +27,10 @@ typedef std::unordered_map<WatcherKey, WatcherValue*> WatcherMap;
 typedef std::unordered_map<WatcherKey, int64_t > WatcherKeyMap;
 typedef std::unordered_map<WatcherId, WatcherKeyMap*> KeyMap;
 
-template <typename T>
-struct PriorityQueue: public std::priority_queue<T, std::vector<T>, Greater<T>> {
-    const std::vector<T>& GetQueue() {
-        return this->c;
-    }
-};
-
 class WatcherSet {
 public:
-    WatcherSet();
+    // 超时定时器由WatchServer持有，所有set共用
+    explicit WatcherSet(WatcherTimer* timer);
     WatcherSet(const WatcherSet&) = delete;
     WatcherSet& operator=(const WatcherSet&) = delete;
     ~WatcherSet();
@@ -49,6 +41,8 @@ public:
     WatchCode AddPrefixWatcher(const PrefixKey&, WatcherPtr&, storage::Store *);
     WatchCode DelPrefixWatcher(const PrefixKey&, WatcherId);
     WatchCode GetPrefixWatchers(const watchpb::EventType &evtType, std::vector<WatcherPtr>& , const PrefixKey&, const int64_t &version);
+    // 删除超时的watcher，一次加锁
+    void DelExpiredWatchers(const std::vector<WatcherPtr>&);
     bool ChgGlobalVersion(const uint64_t &ver) noexcept {
         if(ver <= global_version_)
             return false;
@@ -73,6 +67,10 @@ public:
     std::pair<int32_t, bool> loadFromDb(storage::Store *store, const watchpb::EventType &evtType, const std::string &fromKey,
                        const std::string &endKey, const int64_t &startVersion, const uint64_t &tableId,
                        watchpb::DsWatchResponse *dsResp);
+    // 从变更日志读取prefixKey下startVersion之后的变更(包括删除)
+    // 返回变更个数，日志不能覆盖startVersion时返回-1，需要用loadFromDb全量加载
+    int32_t loadFromLog(storage::Store *store, const std::string &prefixKey,
+                        const int64_t &startVersion, watchpb::DsWatchResponse *dsResp);
 
 
 private:
@@ -80,19 +78,15 @@ private:
     KeyMap                  key_map_;
     WatcherMap              prefix_watcher_map_;
     KeyMap                  prefix_map_;
-    PriorityQueue<WatcherPtr>   watcher_queue_;
     std::mutex              watcher_map_mutex_;
-    std::mutex              watcher_queue_mutex_;
     std::atomic<WatcherId>  watcher_id_ = {0};
 
-
-    std::thread                     watcher_timer_;
-    volatile bool                   watcher_timer_continue_flag_ = true;
-    std::condition_variable         watcher_expire_cond_;
+    WatcherTimer*           timer_ = nullptr;
     uint64_t                global_version_{0};
 private:
     WatchCode AddWatcher(const WatcherKey&, WatcherPtr&, WatcherMap&, KeyMap&, storage::Store *, bool prefixFlag = false);
     WatchCode DelWatcher(const WatcherKey&, WatcherId, WatcherMap&, KeyMap&);
+    void DelWatcherLocked(const WatcherKey&, WatcherId, WatcherMap&);
     WatchCode GetWatchers(const watchpb::EventType &evtType, std::vector<WatcherPtr>& vec, const WatcherKey&, WatcherMap&, WatcherValue *watcherVal, bool prefixFlag = false);
 
 public:
@@ -0,0 +1,75 @@
+#include "watcher_timer.h"
+
+#include "base/util.h"
+#include "frame/sf_logger.h"
+#include "frame/sf_util.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace watch {
+
+const int64_t WatcherTimer::kTickMs;
+
+// watcher的超时时间是墙上时间
+static int64_t nowMs() { return get_micro_second() / 1000; }
+
+WatcherTimer::WatcherTimer(const ExpireHandler& on_expire, const TickHandler& on_tick)
+    : on_expire_(on_expire), on_tick_(on_tick), wheel_(kTickMs, nowMs()) {
+    thr_ = std::thread(&WatcherTimer::run, this);
+    AnnotateThread(thr_.native_handle(), "watch_timer");
+}
+
+WatcherTimer::~WatcherTimer() { Stop(); }
+
+uint64_t WatcherTimer::Add(const WatcherPtr& w, int64_t expire_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return wheel_.Add(expire_ms, w);
+}
+
+void WatcherTimer::Cancel(uint64_t timer_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    wheel_.Cancel(timer_id);
+}
+
+void WatcherTimer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!running_) return;
+        running_ = false;
+        cond_.notify_one();
+    }
+    if (thr_.joinable()) {
+        thr_.join();
+    }
+}
+
+size_t WatcherTimer::Size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return wheel_.Size();
+}
+
+void WatcherTimer::run() {
+    while (true) {
+        std::vector<WatcherPtr> expired;
+        auto now = nowMs();
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cond_.wait_for(lock, std::chrono::milliseconds(kTickMs));
+            if (!running_) break;
+            now = nowMs();
+            wheel_.Advance(now, &expired);
+        }
+        if (!expired.empty()) {
+            on_expire_(expired);
+        }
+        if (on_tick_) {
+            on_tick_(now);
+        }
+    }
+
+    FLOG_INFO("watcher timer thread exit...");
+}
+
+} // namespace watch
+}
+}
@@ -0,0 +1,64 @@
+_Pragma("once");
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/timer_wheel.h"
+
+namespace sharkstore {
+namespace dataserver {
+namespace watch {
+
+class Watcher;
+typedef std::shared_ptr<Watcher> WatcherPtr;
+
+// 节点上所有watcher共用的超时定时器，一个后台线程
+// 添加和取消都是O(1)，watcher回复之后立即取消，不在定时器里残留
+// 每个tick到期的watcher一次回调，由回调方批量删除和回复超时
+class WatcherTimer {
+public:
+    // 时间轮精度(毫秒)
+    static const int64_t kTickMs = 10;
+
+    // 在后台线程里执行，不持有WatcherTimer的锁
+    typedef std::function<void(std::vector<WatcherPtr>& expired)> ExpireHandler;
+    // 每个tick回调一次，做一些定期的清理
+    typedef std::function<void(int64_t now_ms)> TickHandler;
+
+    explicit WatcherTimer(const ExpireHandler& on_expire, const TickHandler& on_tick = nullptr);
+    ~WatcherTimer();
+
+    WatcherTimer(const WatcherTimer&) = delete;
+    WatcherTimer& operator=(const WatcherTimer&) = delete;
+
+    // expire_ms时间(绝对时间，毫秒)到期，返回定时器id
+    uint64_t Add(const WatcherPtr& w, int64_t expire_ms);
+    void Cancel(uint64_t timer_id);
+
+    // 停止后台线程，之后不再回调
+    void Stop();
+
+    size_t Size() const;
+
+private:
+    void run();
+
+private:
+    const ExpireHandler on_expire_;
+    const TickHandler on_tick_;
+
+    mutable std::mutex mu_;
+    std::condition_variable cond_;
+    bool running_ = true;
+    TimerWheel<WatcherPtr> wheel_;
+
+    std::thread thr_;
+};
+
+} // namespace watch
+}
+}
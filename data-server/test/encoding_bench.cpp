@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/ds_encoding.h"
+#include "helper/legacy_encoding.h"
+
+// 对比保序编码改写前后的性能
+// usage: encoding_bench [rounds]
+
+using namespace sharkstore::dataserver;
+namespace legacy = sharkstore::test::helper::legacy;
+
+static void bench(const std::string& name, size_t ops, const std::function<void()>& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << static_cast<double>(elapsed) / ops << " ns/op" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rounds = 10;
+    if (argc > 1) rounds = strtoul(argv[1], NULL, 10);
+
+    std::mt19937_64 rng(0);
+    std::vector<uint64_t> ints(100000);
+    for (auto& i : ints) {
+        i = rng() >> (rng() % 64);
+    }
+    std::vector<std::string> strs(100000);
+    for (auto& s : strs) {
+        s.resize(8 + rng() % 56);
+        for (auto& c : s) {
+            c = (rng() % 64 == 0) ? '\0' : static_cast<char>('a' + rng() % 26);
+        }
+    }
+    const size_t int_ops = rounds * ints.size();
+    const size_t str_ops = rounds * strs.size();
+
+    std::string buf;
+    buf.reserve(64);
+    size_t sink = 0;
+
+    bench("legacy uvarint encode", int_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto i : ints) {
+                buf.clear();
+                legacy::EncodeUvarintAscending(&buf, i);
+                sink += buf.size();
+            }
+        }
+    });
+    bench("uvarint encode", int_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto i : ints) {
+                buf.clear();
+                EncodeUvarintAscending(&buf, i);
+                sink += buf.size();
+            }
+        }
+    });
+    bench("uvarint encode (preallocated)", int_ops, [&] {
+        char tmp[kMaxVarintAscendingSize];
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto i : ints) {
+                sink += EncodeUvarintAscending(tmp, i) - tmp;
+            }
+        }
+    });
+
+    bench("legacy varint encode", int_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto i : ints) {
+                buf.clear();
+                legacy::EncodeVarintAscending(&buf, -static_cast<int64_t>(i >> 1));
+                sink += buf.size();
+            }
+        }
+    });
+    bench("varint encode", int_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto i : ints) {
+                buf.clear();
+                EncodeVarintAscending(&buf, -static_cast<int64_t>(i >> 1));
+                sink += buf.size();
+            }
+        }
+    });
+
+    bench("legacy bytes encode", str_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& s : strs) {
+                buf.clear();
+                legacy::EncodeBytesAscending(&buf, s.data(), s.size());
+                sink += buf.size();
+            }
+        }
+    });
+    bench("bytes encode", str_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& s : strs) {
+                buf.clear();
+                EncodeBytesAscending(&buf, s.data(), s.size());
+                sink += buf.size();
+            }
+        }
+    });
+
+    std::vector<std::string> encoded;
+    encoded.reserve(strs.size());
+    for (const auto& s : strs) {
+        encoded.emplace_back();
+        EncodeBytesAscending(&encoded.back(), s.data(), s.size());
+    }
+    std::string out;
+    out.reserve(64);
+    bench("legacy bytes decode", str_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& e : encoded) {
+                size_t pos = 0;
+                out.clear();
+                legacy::DecodeBytesAscending(e, pos, &out);
+                sink += out.size();
+            }
+        }
+    });
+    bench("bytes decode", str_ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& e : encoded) {
+                size_t pos = 0;
+                out.clear();
+                DecodeBytesAscending(e, pos, &out);
+                sink += out.size();
+            }
+        }
+    });
+
+    std::cout << "(" << sink << ")" << std::endl;
+    return 0;
+}
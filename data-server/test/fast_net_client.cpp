@@ -11,11 +11,13 @@
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <condition_variable>
 #include <map>
 #include <atomic>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "common/ds_proto.h"
 #include "common/ds_types.h"
@@ -48,8 +50,18 @@ size_t proto_len = sizeof(ds_proto_header_t);
 std::map<int64_t, uint64_t> qps;
 std::mutex qps_mutex;
 
+// 每个请求的往返时间(us)
+std::vector<uint64_t> latencies;
+
+// 命令行指定epoll/io_uring, 覆盖配置文件, 方便对比
+const char *io_backend = nullptr;
+
 static int load_conf_file(IniContext *ini_context, const char *filename) {
-    return sf_load_socket_thread_config(ini_context, "client", &config);
+    int ret = sf_load_socket_thread_config(ini_context, "client", &config);
+    if (ret == 0 && io_backend != nullptr) {
+        config.io_backend = sf_parse_io_backend(io_backend);
+    }
+    return ret;
 }
 
 static int64_t get_proto_head(ds_proto_header_t *proto_header, int len) {
@@ -72,6 +84,8 @@ static int64_t get_proto_head(ds_proto_header_t *proto_header, int len) {
 
 static void client_send() {
     int times = send_times;
+    std::vector<uint64_t> local_latencies;
+    local_latencies.reserve(send_times);
     auto b = get_micro_second();
     while (g_continue_flag && times--) {
         tpb::TestMsg *msg = new tpb::TestMsg;
@@ -109,6 +123,7 @@ static void client_send() {
             FLOG_INFO("client msg_id:%" PRIu64 " take time %" PRIu64, id, es-bs);
         }
         if (ret != nullptr) {
+            local_latencies.push_back(es - bs);
             auto t = time(NULL);
             std::unique_lock<std::mutex> lock(qps_mutex);
             auto it = qps.find(t);
@@ -124,6 +139,9 @@ static void client_send() {
 
     auto e = get_micro_second();
     FLOG_INFO("send %d take time %f ms", send_times, (e-b) * 0.001);
+
+    std::unique_lock<std::mutex> lock(qps_mutex);
+    latencies.insert(latencies.end(), local_latencies.begin(), local_latencies.end());
 }
 
 static void client_recv() {
@@ -160,6 +178,7 @@ int user_init() {
     socket_client.Init(&config, &status);
     socket_client.Start();
 
+    auto b = get_micro_second();
     std::vector<std::thread> send_test;
     for (int i=0; i<send_thread; i++) {
         send_test.emplace_back(client_send);
@@ -178,10 +197,22 @@ int user_init() {
     //    t.join();
     //}
 
+    auto e = get_micro_second();
+
     for (auto &q : qps) {
         FLOG_ERROR("time: %" PRId64 " Qps: %" PRIu64, q.first, q.second);
     }
 
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto p50 = latencies[latencies.size() * 50 / 100];
+        auto p99 = latencies[latencies.size() * 99 / 100];
+        std::cout << "backend: " << sf_io_backend_name(config.io_backend)
+                  << ", requests: " << latencies.size()
+                  << ", qps: " << latencies.size() * 1000000.0 / (e - b)
+                  << ", p50: " << p50 << "us, p99: " << p99 << "us" << std::endl;
+    }
+
     return 0;
 }
 
@@ -194,6 +225,9 @@ int main(int argc, char *argv[]) {
     if (argc > 5) {
         send_thread = atoi(argv[5]);
     }
+    if (argc > 6) {
+        io_backend = argv[6];
+    }
 
     std::cout << "send times:" << send_times;
 
@@ -44,8 +44,15 @@ SocketServer socket_server;
 std::map<int64_t, uint64_t> qps;
 std::mutex qps_mutex;
 
+// 命令行指定epoll/io_uring, 覆盖配置文件, 方便对比
+const char *io_backend = nullptr;
+
 static int load_conf_file(IniContext *ini_context, const char *filename) {
-    return sf_load_socket_thread_config(ini_context, "worker", &config);
+    int ret = sf_load_socket_thread_config(ini_context, "worker", &config);
+    if (ret == 0 && io_backend != nullptr) {
+        config.io_backend = sf_parse_io_backend(io_backend);
+    }
+    return ret;
 }
 
 void send(ProtoMessage *msg) {
@@ -99,6 +106,10 @@ int user_init() {
 void user_destroy() { socket_server.Stop(); }
 
 int main(int argc, char *argv[]) {
+    if (argc > 4) {
+        io_backend = argv[4];
+    }
+
     sf_regist_print_version_callback(print_version);
 
     sf_set_proto_header_size(sizeof(ds_proto_header_t));
@@ -0,0 +1,204 @@
+#include "legacy_encoding.h"
+
+#include <assert.h>
+#include <string.h>
+#include <cmath>
+
+#include "common/ds_encoding.h"
+
+namespace sharkstore {
+namespace test {
+namespace helper {
+namespace legacy {
+
+using sharkstore::dataserver::EncodeUint64Ascending;
+
+static const uint8_t kIntMin = 0x80;
+static const uint8_t kIntMax = 0xfd;
+static const uint8_t kIntMaxWidth = 8;
+static const uint8_t kIntZero = kIntMin + kIntMaxWidth;
+static const uint8_t kIntSmall = kIntMax - kIntZero - kIntMaxWidth;  // 109
+
+void EncodeUvarintAscending(std::string* buf, uint64_t value) {
+    if (value <= kIntSmall) {
+        buf->push_back(static_cast<char>(kIntZero + value));
+    } else if (value <= 0xff) {
+        buf->push_back(static_cast<char>(kIntMax - 7));
+        buf->push_back(static_cast<char>(value));
+    } else if (value <= 0xffff) {  // 2
+        buf->push_back(static_cast<char>(kIntMax - 6));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value <= 0xffffff) {  // 3
+        buf->push_back(static_cast<char>(kIntMax - 5));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value <= 0xffffffff) {  // 4
+        buf->push_back(static_cast<char>(kIntMax - 4));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value <= 0xffffffffff) {  // 5
+        buf->push_back(static_cast<char>(kIntMax - 3));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value <= 0xffffffffffff) {  // 6
+        buf->push_back(static_cast<char>(kIntMax - 2));
+        buf->push_back(static_cast<char>(value >> 40));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value <= 0xffffffffffffff) {  // 7
+        buf->push_back(static_cast<char>(kIntMax - 1));
+        buf->push_back(static_cast<char>(value >> 48));
+        buf->push_back(static_cast<char>(value >> 40));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else {
+        buf->push_back(static_cast<char>(kIntMax));
+        buf->push_back(static_cast<char>(value >> 56));
+        buf->push_back(static_cast<char>(value >> 48));
+        buf->push_back(static_cast<char>(value >> 40));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    }
+}
+
+void EncodeVarintAscending(std::string* buf, int64_t value) {
+    if (value >= 0) {
+        return EncodeUvarintAscending(buf, static_cast<uint64_t>(value));
+    }
+
+    if (value >= -0xff) {
+        buf->push_back(static_cast<char>(kIntMin + 7));
+        buf->push_back(static_cast<char>(value));
+    } else if (value >= -0xffff) {
+        buf->push_back(static_cast<char>(kIntMin + 6));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value >= -0xffffff) {
+        buf->push_back(static_cast<char>(kIntMin + 5));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value >= -0xffffffff) {
+        buf->push_back(static_cast<char>(kIntMin + 4));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value >= -0xffffffffff) {
+        buf->push_back(static_cast<char>(kIntMin + 3));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value >= -0xffffffffffff) {
+        buf->push_back(static_cast<char>(kIntMin + 2));
+        buf->push_back(static_cast<char>(value >> 40));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else if (value >= -0xffffffffffffff) {
+        buf->push_back(static_cast<char>(kIntMin + 1));
+        buf->push_back(static_cast<char>(value >> 48));
+        buf->push_back(static_cast<char>(value >> 40));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    } else {
+        buf->push_back(static_cast<char>(kIntMin));
+        buf->push_back(static_cast<char>(value >> 56));
+        buf->push_back(static_cast<char>(value >> 48));
+        buf->push_back(static_cast<char>(value >> 40));
+        buf->push_back(static_cast<char>(value >> 32));
+        buf->push_back(static_cast<char>(value >> 24));
+        buf->push_back(static_cast<char>(value >> 16));
+        buf->push_back(static_cast<char>(value >> 8));
+        buf->push_back(static_cast<char>(value));
+    }
+}
+
+static const uint8_t kFloatNaN = 0x00 + 1;
+static const uint8_t kFloatNeg = kFloatNaN + 1;
+static const uint8_t kFloatZero = kFloatNeg + 1;
+static const uint8_t kFloatPos = kFloatZero + 1;
+
+void EncodeFloatAscending(std::string* buf, double value) {
+    uint64_t u = 0;
+    assert(sizeof(u) == sizeof(double));
+    memcpy(&u, &value, sizeof(double));
+    if (std::isnan(u)) {
+        buf->push_back(static_cast<char>(kFloatNaN));
+        return;
+    } else if (u == 0) {
+        buf->push_back(static_cast<char>(kFloatZero));
+        return;
+    }
+    if ((u & (static_cast<uint64_t>(1) << 63)) != 0) {
+        u = ~u;
+        buf->push_back(static_cast<char>(kFloatNeg));
+    } else {
+        buf->push_back(static_cast<char>(kFloatPos));
+    }
+    EncodeUint64Ascending(buf, u);
+}
+
+static const uint8_t kBytesMarker = 0x12;
+static const uint8_t kEscape = 0x00;
+static const uint8_t kEscapedTerm = 0x01;
+static const uint8_t kEscaped00 = 0xff;
+
+void EncodeBytesAscending(std::string* buf, const char* value, size_t value_size) {
+    buf->push_back(static_cast<char>(kBytesMarker));
+    for (size_t i = 0; i < value_size; i++) {
+        buf->push_back(value[i]);
+        if (static_cast<uint8_t>(value[i]) == kEscape) {
+            buf->push_back(kEscaped00);
+        }
+    }
+    buf->push_back(kEscape);
+    buf->push_back(kEscapedTerm);
+}
+
+bool DecodeBytesAscending(const std::string& buf, size_t& pos, std::string* out) {
+    if (pos >= buf.size() || buf[pos] != kBytesMarker)
+        return false;
+    for (++pos; pos < buf.size();) {
+        auto escapePos = buf.find((char) kEscape, pos);
+        if (escapePos == std::string::npos || escapePos + 1 >= buf.size()) return false;
+        auto escapeChar = (unsigned char) buf[escapePos + 1];
+        if (escapeChar == kEscapedTerm) {
+            if (out) out->append(buf.substr(pos, escapePos - pos));
+            pos = escapePos + 2;
+            return true;
+        }
+        if (escapeChar != kEscaped00) return false;
+        if (out) out->append(buf.substr(pos, escapePos - pos + 1));
+        pos = escapePos + 2;
+    }
+    return false;
+}
+
+} /* namespace legacy */
+} /* namespace helper */
+} /* namespace test */
+} /* namespace sharkstore */
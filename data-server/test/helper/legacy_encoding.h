@@ -0,0 +1,24 @@
+_Pragma("once");
+
+#include <stdint.h>
+#include <string>
+
+namespace sharkstore {
+namespace test {
+namespace helper {
+
+// 改写前ds_encoding中保序编码的实现，用于对比测试和benchmark
+namespace legacy {
+
+void EncodeUvarintAscending(std::string* buf, uint64_t value);
+void EncodeVarintAscending(std::string* buf, int64_t value);
+void EncodeFloatAscending(std::string* buf, double value);
+void EncodeBytesAscending(std::string* buf, const char* value, size_t value_size);
+
+bool DecodeBytesAscending(const std::string& buf, size_t& pos, std::string* out);
+
+} /* namespace legacy */
+
+} /* namespace helper */
+} /* namespace test */
+} /* namespace sharkstore */
@@ -31,6 +31,17 @@ void MasterWorkerMock::AsyncNodeHeartbeat(const mspb::NodeHeartbeatRequest &req)
 }
 
 void MasterWorkerMock::AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest &req) {
+    range_heartbeats.push_back(req);
+}
+
+void MasterWorkerMock::AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest &req,
+                                                const master::RangeHeartbeatList &unchanged) {
+    range_heartbeat_batches.push_back(req);
+    range_heartbeat_unchanged.push_back(unchanged);
+}
+
+bool MasterWorkerMock::RangeHeartbeatBatchSupported() const {
+    return batch_supported;
 }
 
 void MasterWorkerMock::AsyncAskSplit(const mspb::AskSplitRequest &req) {
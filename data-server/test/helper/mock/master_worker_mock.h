@@ -1,5 +1,7 @@
 _Pragma("once");
 
+#include <vector>
+
 #include "master/worker.h"
 
 namespace sharkstore {
@@ -22,8 +24,18 @@ public:
 
     void AsyncNodeHeartbeat(const mspb::NodeHeartbeatRequest &req) override;
     void AsyncRangeHeartbeat(const mspb::RangeHeartbeatRequest &req) override;
+    void AsyncRangeHeartbeatBatch(const mspb::RangeHeartbeatBatchRequest &req,
+                                  const master::RangeHeartbeatList &unchanged) override;
+    bool RangeHeartbeatBatchSupported() const override;
     void AsyncAskSplit(const mspb::AskSplitRequest &req) override;
     void AsyncReportSplit(const mspb::ReportSplitRequest &req) override;
+
+public:
+    // recorded range heartbeats
+    std::vector<mspb::RangeHeartbeatRequest> range_heartbeats;
+    std::vector<mspb::RangeHeartbeatBatchRequest> range_heartbeat_batches;
+    std::vector<master::RangeHeartbeatList> range_heartbeat_unchanged;
+    bool batch_supported = true;
 };
 
 }
@@ -32,6 +32,8 @@ public:
     common::SocketSession* SocketSession() override { return socket_session_.get(); }
     RangeStats* Statistics() override { return range_stats_.get(); }
     watch::WatchServer* WatchServer() override { return watch_server_.get(); }
+    LockExpirer* GetLockExpirer() override { return nullptr; }
+    storage::LegacyRanges* GetLegacyRanges() override { return nullptr; }
 
     void SetFSUsagePercent(uint64_t value) { fs_usage_percent_ = value; }
     uint64_t GetFSUsagePercent() const override { return fs_usage_percent_.load(); }
@@ -117,6 +117,12 @@ void SelectRequestBuilder::AddLimit(uint64_t count, uint64_t offset) {
     req_.mutable_limit()->set_offset(offset);
 }
 
+void SelectRequestBuilder::AddOrderBy(const std::string& col, bool desc) {
+    auto o = req_.add_order_bys();
+    o->mutable_column()->CopyFrom(table_->GetColumn(col));
+    o->set_desc(desc);
+}
+
 
 DeleteRequestBuilder::DeleteRequestBuilder(Table *t) : table_(t) {
     // default: delete all scope
@@ -31,6 +31,9 @@ public:
     // select limit
     void AddLimit(uint64_t count, uint64_t offset = 0);
 
+    // select order by
+    void AddOrderBy(const std::string& col, bool desc = false);
+
     kvrpcpb::SelectRequest Build() { return std::move(req_); }
 
 private:
@@ -87,6 +87,8 @@ Status RangeTestFixture::Split() {
     range_->split_range_id_ = 2;
     resp.set_new_range_id(range_->split_range_id_);
     range_->meta_.Get(resp.mutable_range());
+    // master返回的meta不带索引定义
+    resp.mutable_range()->clear_index_columns();
     for (const auto &peer : resp.range().peers()) {
         resp.add_new_peer_ids(peer.id() + 1);
     }
@@ -154,6 +156,16 @@ Status RangeTestFixture::Split() {
             return Status(Status::kUnexpected, "pk", split_meta.DebugString());
         }
     }
+    // 索引定义
+    if (split_meta.index_columns_size() != meta.index_columns_size()) {
+        return Status(Status::kUnexpected, "split index size", split_meta.DebugString());
+    }
+    for (int i = 0; i < split_meta.index_columns_size(); ++i) {
+        if (split_meta.index_columns(i).ShortDebugString() !=
+            meta.index_columns(i).ShortDebugString()) {
+            return Status(Status::kUnexpected, "index", split_meta.DebugString());
+        }
+    }
 
 //    // 检查meta store
 //    std::vector<metapb::Range> metas;
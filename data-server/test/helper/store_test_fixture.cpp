@@ -30,6 +30,9 @@ void StoreTestFixture::SetUp() {
 
     // make meta
     meta_ = MakeRangeMeta(table_.get());
+    for (const auto& name : index_columns_) {
+        meta_.add_index_columns()->CopyFrom(table_->GetColumn(name));
+    }
 
     store_ = new sharkstore::dataserver::storage::Store(meta_, db_);
 }
@@ -29,12 +29,14 @@ protected:
 
 protected:
     std::unique_ptr<Table> table_;
+    // 二级索引列名，在SetUp之前设置
+    std::vector<std::string> index_columns_;
     metapb::Range meta_;
     dataserver::storage::Store* store_ = nullptr;
+    rocksdb::DB* db_ = nullptr;
 
 private:
     std::string tmp_dir_;
-    rocksdb::DB* db_ = nullptr;
 };
 
 } /* namespace helper */
@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "common/ds_proto.h"
+#include "common/socket_message.h"
+#include "proto/gen/funcpb.pb.h"
+#include "proto/gen/kvrpcpb.pb.h"
+#include "proto/gen/raft_cmdpb.pb.h"
+
+// 统计KvSet/KvGet请求从收包到构造raft命令的内存分配次数
+// 对比原来的解析方式（拷贝body、栈上解析、release到堆上的Command）和arena方式
+// usage: kv_alloc_bench [count]
+
+static std::atomic<uint64_t> g_alloc_count(0);
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+using namespace sharkstore::dataserver;
+using sharkstore::dataserver::common::ProtoMessage;
+
+static std::string makeFrame(const google::protobuf::Message& req, funcpb::FunctionID func_id) {
+    std::string body = req.SerializeAsString();
+    ds_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.func_id = func_id;
+    header.body_len = static_cast<int>(body.size());
+
+    std::string frame(header_size, '\0');
+    ds_serialize_header(&header, (ds_proto_header_t*)(&frame[0]));
+    frame.append(body);
+    return frame;
+}
+
+// 原来的拷贝方式
+static ProtoMessage* legacyProtoMessage(const std::string& frame) {
+    auto msg = new ProtoMessage;
+    ds_unserialize_header((ds_proto_header_t*)(frame.data()), &msg->header);
+    msg->body.resize(static_cast<size_t>(msg->header.body_len));
+    memcpy(msg->body.data(), frame.data() + header_size, msg->body.size());
+    return msg;
+}
+
+static void legacyKvSet(const std::string& frame, uint64_t seq) {
+    auto msg = legacyProtoMessage(frame);
+    kvrpcpb::DsKvSetRequest req;
+    common::GetMessage(msg->body.data(), msg->body.size(), &req);
+
+    raft_cmdpb::Command cmd;
+    cmd.set_cmd_type(raft_cmdpb::CmdType::KvSet);
+    cmd.set_allocated_kv_set_req(req.release_req());
+    cmd.set_allocated_verify_epoch(new metapb::RangeEpoch(req.header().range_epoch()));
+    cmd.mutable_cmd_id()->set_node_id(1);
+    cmd.mutable_cmd_id()->set_seq(seq);
+    std::string data = cmd.SerializeAsString();
+    delete msg;
+}
+
+static void arenaKvSet(const std::string& frame, uint64_t seq) {
+    auto msg = common::GetProtoMessage(frame.data());
+    auto& req = *msg->NewMessage<kvrpcpb::DsKvSetRequest>();
+    common::GetMessage(msg->body.data(), msg->body.size(), &req);
+
+    auto cmd = msg->NewMessage<raft_cmdpb::Command>();
+    cmd->set_cmd_type(raft_cmdpb::CmdType::KvSet);
+    cmd->unsafe_arena_set_allocated_kv_set_req(req.unsafe_arena_release_req());
+    cmd->mutable_verify_epoch()->CopyFrom(req.header().range_epoch());
+    cmd->mutable_cmd_id()->set_node_id(1);
+    cmd->mutable_cmd_id()->set_seq(seq);
+    std::string data;
+    cmd->SerializeToString(&data);
+    delete msg;
+}
+
+static void legacyKvGet(const std::string& frame) {
+    auto msg = legacyProtoMessage(frame);
+    kvrpcpb::DsKvGetRequest req;
+    common::GetMessage(msg->body.data(), msg->body.size(), &req);
+    delete msg;
+}
+
+static void arenaKvGet(const std::string& frame) {
+    auto msg = common::GetProtoMessage(frame.data());
+    auto& req = *msg->NewMessage<kvrpcpb::DsKvGetRequest>();
+    common::GetMessage(msg->body.data(), msg->body.size(), &req);
+    delete msg;
+}
+
+static void bench(const std::string& name, uint64_t count,
+                  const std::function<void(uint64_t)>& func) {
+    auto allocs = g_alloc_count.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        func(i);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << static_cast<double>(g_alloc_count.load() - allocs) / count
+              << " allocs/op, " << static_cast<double>(elapsed) / count << " ns/op"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t count = 100000;
+    if (argc > 1) count = strtoull(argv[1], NULL, 10);
+
+    kvrpcpb::DsKvSetRequest set_req;
+    set_req.mutable_header()->set_cluster_id(1);
+    set_req.mutable_header()->set_trace_id(12345);
+    set_req.mutable_header()->set_range_id(100);
+    set_req.mutable_header()->mutable_range_epoch()->set_conf_ver(1);
+    set_req.mutable_header()->mutable_range_epoch()->set_version(1);
+    set_req.mutable_req()->mutable_kv()->set_key(std::string(32, 'k'));
+    set_req.mutable_req()->mutable_kv()->set_value(std::string(256, 'v'));
+    auto set_frame = makeFrame(set_req, funcpb::kFuncKvSet);
+
+    kvrpcpb::DsKvGetRequest get_req;
+    get_req.mutable_header()->CopyFrom(set_req.header());
+    get_req.mutable_req()->set_key(std::string(32, 'k'));
+    auto get_frame = makeFrame(get_req, funcpb::kFuncKvGet);
+
+    bench("legacy KvSet", count, [&](uint64_t i) { legacyKvSet(set_frame, i); });
+    bench("arena KvSet", count, [&](uint64_t i) { arenaKvSet(set_frame, i); });
+    bench("legacy KvGet", count, [&](uint64_t) { legacyKvGet(get_frame); });
+    bench("arena KvGet", count, [&](uint64_t) { arenaKvGet(get_frame); });
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include "proto/gen/funcpb.pb.h"
+#include "proto/gen/kvrpcpb.pb.h"
+#include "proto/gen/schpb.pb.h"
+#include "server/admission.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore::dataserver;
+using namespace sharkstore::dataserver::server;
+
+static QueueDelayOptions delayOptions() {
+    QueueDelayOptions ops;
+    ops.target_us = 5000;
+    ops.interval_us = 100000;
+    return ops;
+}
+
+TEST(Admission, QueueDelayBelowTarget) {
+    QueueDelayControl ctl(delayOptions());
+    int64_t now = 1000000;
+    for (int i = 0; i < 1000; ++i) {
+        now += 1000;
+        ctl.OnDequeue(1000, now);
+        ASSERT_TRUE(ctl.Admit(now));
+    }
+    ASSERT_FALSE(ctl.Dropping());
+}
+
+TEST(Admission, QueueDelayShed) {
+    QueueDelayControl ctl(delayOptions());
+    int64_t now = 1000000;
+
+    // 超过target但还不到一个interval
+    ctl.OnDequeue(10000, now);
+    ctl.OnDequeue(10000, now + 50000);
+    ASSERT_FALSE(ctl.Dropping());
+    ASSERT_TRUE(ctl.Admit(now + 50000));
+
+    // 持续一个interval，进入丢弃状态，第一个请求被拒绝
+    now += 100000;
+    ctl.OnDequeue(10000, now);
+    ASSERT_TRUE(ctl.Dropping());
+    ASSERT_FALSE(ctl.Admit(now));
+    // 下一次拒绝间隔 interval/sqrt(2)
+    ASSERT_TRUE(ctl.Admit(now + 1000));
+    ASSERT_FALSE(ctl.Admit(now + 71000));
+    // 间隔逐渐缩短
+    ASSERT_TRUE(ctl.Admit(now + 71000 + 50000));
+    ASSERT_FALSE(ctl.Admit(now + 71000 + 58000));
+
+    // 排队时间回落，退出丢弃状态
+    ctl.OnDequeue(1000, now + 200000);
+    ASSERT_FALSE(ctl.Dropping());
+    ASSERT_TRUE(ctl.Admit(now + 200000));
+}
+
+TEST(Admission, QueueDelayDisabled) {
+    QueueDelayControl ctl;
+    int64_t now = 1000000;
+    for (int i = 0; i < 100; ++i) {
+        now += 10000;
+        ctl.OnDequeue(1000000, now);
+        ASSERT_TRUE(ctl.Admit(now));
+    }
+    ASSERT_GT(ctl.EstimatedDelay(), 0);
+}
+
+TEST(Admission, ClusterQuota) {
+    ClusterQuota quota(2);
+    ASSERT_TRUE(quota.Enabled());
+    ASSERT_TRUE(quota.Acquire(1));
+    ASSERT_TRUE(quota.Acquire(1));
+    ASSERT_FALSE(quota.Acquire(1));
+    ASSERT_TRUE(quota.Acquire(2));
+    ASSERT_EQ(quota.Inflight(1), 2);
+
+    quota.Release(1);
+    ASSERT_EQ(quota.Inflight(1), 1);
+    ASSERT_TRUE(quota.Acquire(1));
+
+    quota.Release(1);
+    quota.Release(1);
+    quota.Release(2);
+    ASSERT_EQ(quota.Inflight(1), 0);
+    ASSERT_EQ(quota.Inflight(2), 0);
+}
+
+TEST(Admission, PeekRequestHeader) {
+    kvrpcpb::DsKvRawPutRequest req;
+    req.mutable_header()->set_cluster_id(123);
+    req.mutable_header()->set_trace_id(456);
+    req.mutable_header()->set_range_id(789);
+    req.mutable_req()->set_key("key");
+    req.mutable_req()->set_value(std::string(1024, 'v'));
+
+    common::ProtoMessage msg;
+    auto data = req.SerializeAsString();
+    msg.body.assign(data.begin(), data.end());
+
+    kvrpcpb::RequestHeader header;
+    ASSERT_TRUE(PeekRequestHeader(&msg, &header));
+    ASSERT_EQ(header.cluster_id(), 123);
+    ASSERT_EQ(header.trace_id(), 456);
+    ASSERT_EQ(header.range_id(), 789);
+
+    // 没有header
+    kvrpcpb::DsKvRawPutRequest empty;
+    empty.mutable_req()->set_key("key");
+    data = empty.SerializeAsString();
+    msg.body.assign(data.begin(), data.end());
+    ASSERT_FALSE(PeekRequestHeader(&msg, &header));
+
+    // 数据被截断
+    data = req.SerializeAsString();
+    msg.body.assign(data.begin(), data.begin() + 4);
+    ASSERT_FALSE(PeekRequestHeader(&msg, &header));
+}
+
+TEST(Admission, ServerBusyResponse) {
+    kvrpcpb::RequestHeader header;
+    header.set_cluster_id(123);
+    header.set_trace_id(456);
+
+    // 数据请求
+    std::unique_ptr<google::protobuf::Message> resp(
+        NewServerBusyResponse(funcpb::kFuncKvSet, header, "queue delay"));
+    kvrpcpb::DsKvSetResponse kv_resp;
+    ASSERT_TRUE(kv_resp.ParseFromString(resp->SerializeAsString()));
+    ASSERT_EQ(kv_resp.header().cluster_id(), 123);
+    ASSERT_EQ(kv_resp.header().trace_id(), 456);
+    ASSERT_TRUE(kv_resp.header().error().has_server_is_busy());
+
+    // 管理请求按schpb的header编码
+    ASSERT_TRUE(IsAdminFunc(funcpb::kFuncCreateRange));
+    ASSERT_TRUE(IsAdminFunc(funcpb::kFuncOfflineRange));
+    ASSERT_FALSE(IsAdminFunc(funcpb::kFuncLockWatch));
+    resp.reset(NewServerBusyResponse(funcpb::kFuncRangeTransferLeader, header, "queue delay"));
+    schpb::TransferRangeLeaderResponse sch_resp;
+    ASSERT_TRUE(sch_resp.ParseFromString(resp->SerializeAsString()));
+    ASSERT_EQ(sch_resp.header().cluster_id(), 123);
+    ASSERT_TRUE(sch_resp.header().error().has_server_is_busy());
+}
+
+}  // namespace
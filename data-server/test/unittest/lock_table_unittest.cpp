@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include "frame/sf_util.h"
+#include "helper/store_test_fixture.h"
+#include "range/lock.h"
+#include "range/lock_expirer.h"
+#include "range/lock_table.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore::test::helper;
+using namespace sharkstore::dataserver;
+using namespace sharkstore::dataserver::range;
+
+// 记录LockExpirer的回调
+class Recorder {
+public:
+    void OnExpire(uint64_t range_id, std::vector<raft_cmdpb::ExpiredLock>& locks) {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (auto& l : locks) {
+            expired_[range_id].push_back(l);
+        }
+        cond_.notify_all();
+    }
+
+    void OnLoad(uint64_t range_id) {
+        std::lock_guard<std::mutex> lock(mu_);
+        loads_.push_back(range_id);
+        cond_.notify_all();
+    }
+
+    bool WaitExpired(uint64_t range_id, size_t n, int timeout_ms = 2000) {
+        std::unique_lock<std::mutex> lock(mu_);
+        return cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                              [&] { return expired_[range_id].size() >= n; });
+    }
+
+    std::vector<raft_cmdpb::ExpiredLock> Expired(uint64_t range_id) {
+        std::lock_guard<std::mutex> lock(mu_);
+        return expired_[range_id];
+    }
+
+    std::vector<uint64_t> Loads() {
+        std::unique_lock<std::mutex> lock(mu_);
+        cond_.wait_for(lock, std::chrono::seconds(2), [this] { return !loads_.empty(); });
+        return loads_;
+    }
+
+private:
+    std::mutex mu_;
+    std::condition_variable cond_;
+    std::map<uint64_t, std::vector<raft_cmdpb::ExpiredLock>> expired_;
+    std::vector<uint64_t> loads_;
+};
+
+class LockTableTest : public StoreTestFixture {
+public:
+    LockTableTest() : StoreTestFixture(CreateAccountTable()) {}
+
+protected:
+    void SetUp() override {
+        StoreTestFixture::SetUp();
+        expirer_.reset(new LockExpirer(
+            [this](uint64_t range_id, std::vector<raft_cmdpb::ExpiredLock>& locks) {
+                recorder_.OnExpire(range_id, locks);
+            },
+            [this](uint64_t range_id) { recorder_.OnLoad(range_id); }));
+    }
+
+    void TearDown() override {
+        expirer_.reset();
+        StoreTestFixture::TearDown();
+    }
+
+    std::string lockKey(const std::string& user_key) {
+        std::string key;
+        lock::EncodeKey(&key, meta_.table_id(), &user_key);
+        return key;
+    }
+
+    kvrpcpb::LockValue lockValue(const std::string& id, int64_t delete_time) {
+        kvrpcpb::LockValue value;
+        value.set_id(id);
+        value.set_value("value-" + id);
+        value.set_delete_time(delete_time);
+        return value;
+    }
+
+    void putStore(const std::string& user_key, const kvrpcpb::LockValue& value) {
+        std::string buf, extend;
+        lock::EncodeValue(&buf, 0, value, &extend);
+        auto s = store_->Put(lockKey(user_key), buf);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+
+protected:
+    Recorder recorder_;
+    std::unique_ptr<LockExpirer> expirer_;
+};
+
+TEST_F(LockTableTest, LoadAndAccess) {
+    auto far = getticks() + 3600 * 1000;
+    putStore("a", lockValue("1", 0));
+    putStore("b", lockValue("2", far));
+    putStore("c", lockValue("3", far));
+
+    LockTable table(meta_.id(), expirer_.get());
+    kvrpcpb::LockValue value;
+    bool found = false;
+    // 没加载之前不生效
+    ASSERT_FALSE(table.Get(lockKey("a"), &value, &found));
+    table.Put(lockKey("d"), lockValue("4", 0));
+    ASSERT_EQ(table.Size(), 0U);
+
+    ASSERT_TRUE(table.TryStartLoad());
+    ASSERT_FALSE(table.TryStartLoad());
+    ASSERT_TRUE(table.Load(store_, meta_.start_key(), meta_.end_key()));
+    ASSERT_TRUE(table.Loaded());
+    ASSERT_EQ(table.Size(), 3U);
+    // b和c注册了定时器
+    ASSERT_EQ(expirer_->Size(), 2U);
+
+    ASSERT_TRUE(table.Get(lockKey("b"), &value, &found));
+    ASSERT_TRUE(found);
+    ASSERT_EQ(value.id(), "2");
+    ASSERT_EQ(value.delete_time(), far);
+    ASSERT_TRUE(table.Get(lockKey("x"), &value, &found));
+    ASSERT_FALSE(found);
+
+    // 延期重新注册定时器，解锁取消定时器
+    table.Put(lockKey("b"), lockValue("2", far + 1000));
+    table.Erase(lockKey("c"));
+    table.Put(lockKey("d"), lockValue("4", 0));
+    ASSERT_EQ(table.Size(), 3U);
+    ASSERT_EQ(expirer_->Size(), 1U);
+
+    std::vector<std::pair<std::string, kvrpcpb::LockValue>> result;
+    ASSERT_TRUE(table.Scan(lockKey("b"), meta_.end_key(), 10, &result));
+    ASSERT_EQ(result.size(), 2U);
+    ASSERT_EQ(result[0].first, lockKey("b"));
+    ASSERT_EQ(result[1].first, lockKey("d"));
+    result.clear();
+    ASSERT_TRUE(table.Scan(meta_.start_key(), meta_.end_key(), 1, &result));
+    ASSERT_EQ(result.size(), 1U);
+    ASSERT_EQ(result[0].second.id(), "1");
+
+    table.Reset();
+    ASSERT_FALSE(table.Loaded());
+    ASSERT_EQ(expirer_->Size(), 0U);
+    ASSERT_FALSE(table.Get(lockKey("a"), &value, &found));
+    // Reset之后可以重新加载
+    ASSERT_TRUE(table.TryStartLoad());
+}
+
+TEST_F(LockTableTest, ResetBeforeLoad) {
+    putStore("a", lockValue("1", 0));
+
+    LockTable table(meta_.id(), expirer_.get());
+    ASSERT_TRUE(table.TryStartLoad());
+    table.Reset();
+    ASSERT_FALSE(table.Load(store_, meta_.start_key(), meta_.end_key()));
+    ASSERT_FALSE(table.Loaded());
+
+    // 没有expirer不启用
+    LockTable disabled(meta_.id(), nullptr);
+    ASSERT_FALSE(disabled.TryStartLoad());
+}
+
+TEST_F(LockTableTest, Expire) {
+    auto now = getticks();
+    putStore("a", lockValue("1", now + 50));
+    putStore("b", lockValue("2", now + 100));
+    putStore("c", lockValue("3", now + 3600 * 1000));
+
+    LockTable table(meta_.id(), expirer_.get());
+    ASSERT_TRUE(table.TryStartLoad());
+    ASSERT_TRUE(table.Load(store_, meta_.start_key(), meta_.end_key()));
+    // b被重新加锁，定时器按新的锁重新注册
+    table.Put(lockKey("b"), lockValue("22", now + 100));
+
+    ASSERT_TRUE(recorder_.WaitExpired(meta_.id(), 2));
+    auto expired = recorder_.Expired(meta_.id());
+    ASSERT_EQ(expired.size(), 2U);
+    for (const auto& e : expired) {
+        EXPECT_GE(getticks(), e.delete_time());
+    }
+    ASSERT_EQ(expired[0].key(), lockKey("a"));
+    ASSERT_EQ(expired[0].id(), "1");
+
+    // 定时器触发后锁又被改了的过滤掉
+    std::vector<raft_cmdpb::ExpiredLock> locks = expired;
+    auto stale = locks[0];
+    stale.set_id("other");
+    locks.push_back(stale);
+    table.FilterExpired(&locks);
+    ASSERT_EQ(locks.size(), 2U);
+    ASSERT_EQ(locks[0].key(), lockKey("a"));
+    ASSERT_EQ(locks[1].key(), lockKey("b"));
+    ASSERT_EQ(locks[1].id(), "22");
+
+    // 提交删除后没有apply的，重试定时器会再次触发
+    ASSERT_EQ(expirer_->Size(), 3U);
+    table.Erase(lockKey("b"));
+    ASSERT_EQ(expirer_->Size(), 2U);
+    ASSERT_TRUE(recorder_.WaitExpired(meta_.id(), 3, 3000));
+    expired = recorder_.Expired(meta_.id());
+    ASSERT_EQ(expired.back().key(), lockKey("a"));
+}
+
+TEST_F(LockTableTest, ExpirerLoad) {
+    expirer_->ScheduleLoad(7);
+    auto loads = recorder_.Loads();
+    ASSERT_EQ(loads.size(), 1U);
+    ASSERT_EQ(loads[0], 7U);
+
+    // 不同range分开回调
+    auto now = getticks();
+    expirer_->Schedule(1, "k1", "1", now, now);
+    expirer_->Schedule(2, "k2", "2", now, now);
+    auto id = expirer_->Schedule(2, "k3", "3", now, now + 20);
+    expirer_->Cancel(id);
+    ASSERT_TRUE(recorder_.WaitExpired(1, 1));
+    ASSERT_TRUE(recorder_.WaitExpired(2, 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(recorder_.Expired(2).size(), 1U);
+    ASSERT_EQ(recorder_.Expired(2)[0].key(), "k2");
+    ASSERT_EQ(expirer_->Size(), 0U);
+}
+
+} /* namespace  */
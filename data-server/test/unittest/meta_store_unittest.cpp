@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <map>
 #include <gtest/gtest.h>
 
@@ -55,6 +56,35 @@ TEST_F(MetaStoreTest, NodeID) {
     ASSERT_EQ(node2, node);
 }
 
+TEST_F(MetaStoreTest, ValueFormat) {
+    int format = -1;
+    auto s = store_->GetValueFormat(&format);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(format, 0);
+
+    s = store_->SaveValueFormat(1);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->GetValueFormat(&format);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(format, 1);
+}
+
+TEST_F(MetaStoreTest, LegacyRanges) {
+    std::vector<uint64_t> ids;
+    auto s = store_->GetLegacyRanges(&ids);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_TRUE(ids.empty());
+
+    s = store_->AddLegacyRanges({3, 1, 2});
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->DelLegacyRange(2);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->GetLegacyRanges(&ids);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(ids, std::vector<uint64_t>({1, 3}));
+}
+
 TEST_F(MetaStoreTest, ApplyIndex) {
     uint64_t range_id = sharkstore::randomInt();
     uint64_t applied = 1;
@@ -1,6 +1,15 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
+#include <pthread.h>
+
+#include "monitor/core_local_histogram.h"
 #include "monitor/isystemstatus.h"
+#include "monitor/proc_sampler.h"
+#include "monitor/prometheus.h"
+#include "monitor/request_trace.h"
 #include "monitor/statistics.h"
 
 int main(int argc, char* argv[]) {
@@ -28,4 +37,254 @@ TEST(Monitor, Statistics) {
     s.ToString();
 }
 
+TEST(Monitor, StatisticsCumulative) {
+    Statistics s;
+    s.PushTime(HistogramType::kDeal, 50);
+    s.PushTime(HistogramType::kDeal, 800);
+    s.Reset();
+    s.PushTime(HistogramType::kDeal, 20000);
+
+    // 周期数据只有Reset之后的
+    HistogramData data;
+    s.GetData(HistogramType::kDeal, &data);
+    ASSERT_NEAR(data.max, 20000, 20000 / 32);
+    ASSERT_NEAR(data.median, 20000, 20000 / 32);
+
+    HistogramBuckets buckets;
+    s.GetCumulative(HistogramType::kDeal, {100, 1000, 10000, 100000}, &buckets);
+    ASSERT_EQ(buckets.count, 3);
+    ASSERT_EQ(buckets.sum, 50 + 800 + 20000);
+    ASSERT_EQ(buckets.counts, std::vector<uint64_t>({1, 2, 2, 3}));
+
+    // 其他类型不受影响
+    s.GetCumulative(HistogramType::kRaft, {100}, &buckets);
+    ASSERT_EQ(buckets.count, 0);
+    ASSERT_EQ(buckets.counts, std::vector<uint64_t>({0}));
+}
+
+TEST(Monitor, LogLinearBuckets) {
+    for (uint64_t v = 0; v < 100000; ++v) {
+        auto index = LogLinearBuckets::Index(v);
+        ASSERT_LE(LogLinearBuckets::Lower(index), v);
+        ASSERT_GE(LogLinearBuckets::Upper(index), v);
+        // 相对误差不超过1/32
+        ASSERT_LE(LogLinearBuckets::Upper(index) - LogLinearBuckets::Lower(index), v / 32);
+    }
+    ASSERT_EQ(LogLinearBuckets::Index(UINT64_MAX), LogLinearBuckets::kBucketCount - 1);
+    for (size_t i = 1; i < LogLinearBuckets::kBucketCount; ++i) {
+        ASSERT_EQ(LogLinearBuckets::Lower(i), LogLinearBuckets::Upper(i - 1) + 1);
+    }
+}
+
+TEST(Monitor, CoreLocalHistogram) {
+    CoreLocalHistogram h;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&h] {
+            for (uint64_t v = 1; v <= 10000; ++v) {
+                h.Add(v);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    HistogramSnapshot snapshot;
+    h.Snapshot(&snapshot);
+    ASSERT_EQ(snapshot.num, 40000);
+    ASSERT_EQ(snapshot.sum, 4 * 10000 * 10001 / 2);
+    ASSERT_NEAR(snapshot.Percentile(50), 5000, 5000 / 32);
+    ASSERT_NEAR(snapshot.Percentile(99), 9900, 9900 / 32);
+    ASSERT_NEAR(snapshot.Percentile(99.9), 9990, 9990 / 32);
+    ASSERT_NEAR(snapshot.Max(), 10000, 10000 / 32);
+
+    // 两次快照之间的分布
+    HistogramSnapshot base = snapshot;
+    h.Add(100);
+    h.Snapshot(&snapshot);
+    snapshot.Subtract(base);
+    ASSERT_EQ(snapshot.num, 1);
+    ASSERT_EQ(snapshot.sum, 100);
+    ASSERT_NEAR(snapshot.Percentile(99.9), 100, 100 / 32);
+}
+
+TEST(Monitor, CoreLocalCounter) {
+    CoreLocalCounter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) {
+                counter.Add(2);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(counter.Sum(), 80000);
+    ASSERT_EQ(counter.Exchange(), 80000);
+    ASSERT_EQ(counter.Sum(), 0);
+}
+
+TEST(Monitor, RequestTrace) {
+    RequestTrace trace;
+    trace.Set(TraceStage::kRecv, 1000);
+    trace.Set(TraceStage::kDequeue, 1100);
+    trace.Set(TraceStage::kPropose, 1150);
+    // 读请求没有raft阶段
+    trace.Set(TraceStage::kReply, 1400);
+    ASSERT_EQ(trace.Total(), 400);
+
+    int64_t spans[kTraceStageNum];
+    trace.Spans(spans);
+    ASSERT_EQ(spans[static_cast<uint32_t>(TraceStage::kRecv)], -1);
+    ASSERT_EQ(spans[static_cast<uint32_t>(TraceStage::kDequeue)], 100);
+    ASSERT_EQ(spans[static_cast<uint32_t>(TraceStage::kPropose)], 50);
+    ASSERT_EQ(spans[static_cast<uint32_t>(TraceStage::kRaftCommit)], -1);
+    ASSERT_EQ(spans[static_cast<uint32_t>(TraceStage::kReply)], 250);
+
+    TraceCollector collector;
+    collector.SetSlowThreshold(300);
+    collector.Finish(trace);
+    collector.RecordSent(20);
+
+    HistogramSnapshot snapshot;
+    collector.StageSnapshot(TraceStage::kDequeue, &snapshot);
+    ASSERT_EQ(snapshot.num, 1);
+    ASSERT_EQ(snapshot.sum, 100);
+    collector.StageSnapshot(TraceStage::kApply, &snapshot);
+    ASSERT_EQ(snapshot.num, 0);
+    collector.StageSnapshot(TraceStage::kSent, &snapshot);
+    ASSERT_EQ(snapshot.sum, 20);
+
+    std::vector<RequestTrace> traces;
+    collector.DumpSlow(&traces);
+    ASSERT_EQ(traces.size(), 1);
+    ASSERT_EQ(traces[0].Total(), 400);
+
+    // 没有超过阈值
+    trace.Set(TraceStage::kReply, 1200);
+    collector.Finish(trace);
+    collector.DumpSlow(&traces);
+    ASSERT_EQ(traces.size(), 1);
+}
+
+TEST(Monitor, SlowTraceRing) {
+    SlowTraceRing ring(4);
+    std::vector<RequestTrace> traces;
+    ring.Dump(&traces);
+    ASSERT_TRUE(traces.empty());
+
+    for (int i = 1; i <= 6; ++i) {
+        RequestTrace trace;
+        trace.msg_id = i;
+        trace.Set(TraceStage::kRecv, 1000);
+        trace.Set(TraceStage::kReply, 1000 + (i % 3 + 1) * 100);
+        ring.Push(trace);
+    }
+
+    // 写满后覆盖最早的1、2，按耗时从大到小
+    ring.Dump(&traces);
+    ASSERT_EQ(traces.size(), 4);
+    std::vector<int64_t> totals, ids;
+    for (const auto& t : traces) {
+        totals.push_back(t.Total());
+        ids.push_back(t.msg_id);
+    }
+    ASSERT_EQ(totals, std::vector<int64_t>({300, 200, 100, 100}));
+    ASSERT_EQ(std::count(ids.begin(), ids.end(), 1), 0);
+    ASSERT_EQ(std::count(ids.begin(), ids.end(), 2), 0);
+}
+
+TEST(Monitor, Prometheus) {
+    PrometheusWriter w;
+    w.Gauge("queue_size", "Queue size.", 3, {{"queue", "fast"}});
+    w.Gauge("queue_size", "Queue size.", 4, {{"queue", "slow"}});
+    w.Counter("shed_total", "Shed \\ total.", 12345678901);
+    w.Gauge("escaped", "Escaped.", 0.5, {{"v", "a\"b\\c\nd"}});
+    w.Histogram("latency_seconds", "Latency.", {0.001, 0.01}, {1, 2}, 3, 1.5,
+                {{"stage", "Deal"}});
+
+    std::string expected =
+        "# HELP queue_size Queue size.\n"
+        "# TYPE queue_size gauge\n"
+        "queue_size{queue=\"fast\"} 3\n"
+        "queue_size{queue=\"slow\"} 4\n"
+        "# HELP shed_total Shed \\\\ total.\n"
+        "# TYPE shed_total counter\n"
+        "shed_total 12345678901\n"
+        "# HELP escaped Escaped.\n"
+        "# TYPE escaped gauge\n"
+        "escaped{v=\"a\\\"b\\\\c\\nd\"} 0.5\n"
+        "# HELP latency_seconds Latency.\n"
+        "# TYPE latency_seconds histogram\n"
+        "latency_seconds_bucket{stage=\"Deal\",le=\"0.001\"} 1\n"
+        "latency_seconds_bucket{stage=\"Deal\",le=\"0.01\"} 2\n"
+        "latency_seconds_bucket{stage=\"Deal\",le=\"+Inf\"} 3\n"
+        "latency_seconds_sum{stage=\"Deal\"} 1.5\n"
+        "latency_seconds_count{stage=\"Deal\"} 3\n";
+    ASSERT_EQ(w.Text(), expected);
+}
+
+TEST(Monitor, ProcStatParse) {
+    std::string stat = "cpu  100 10 50 800 40 0 5 0 0 0\n"
+                       "cpu0 50 5 25 400 20 0 3 0 0 0\n"
+                       "cpu1 50 5 25 400 20 0 2 0 0 0\n"
+                       "intr 12345\n";
+    uint64_t total = 0, idle = 0;
+    uint32_t count = 0;
+    ASSERT_TRUE(ProcSampler::ParseSystemStat(stat, &total, &idle, &count));
+    ASSERT_EQ(total, 1005U);
+    ASSERT_EQ(idle, 840U);
+    ASSERT_EQ(count, 2U);
+    ASSERT_FALSE(ProcSampler::ParseSystemStat("intr 1\n", &total, &idle, &count));
+
+    // 线程名里有空格和括号
+    std::string task = "1234 (raft-apply:1 (x)) S 1 1234 1234 0 -1 4194560 100 0 0 0 "
+                       "17 23 0 0 20 0 8 0 100 0 0\n";
+    std::string name;
+    uint64_t ticks = 0;
+    ASSERT_TRUE(ProcSampler::ParseTaskStat(task, &name, &ticks));
+    ASSERT_EQ(name, "raft-apply:1 (x)");
+    ASSERT_EQ(ticks, 40U);
+    ASSERT_FALSE(ProcSampler::ParseTaskStat("1234 (short) S 1 2", &name, &ticks));
+
+    ASSERT_EQ(ProcSampler::GroupName("fast_worker:12"), "fast_worker");
+    ASSERT_EQ(ProcSampler::GroupName("range_hb"), "range_hb");
+}
+
+TEST(Monitor, ProcSampler) {
+    ProcSampler sampler;
+    CpuSample sample;
+    ASSERT_FALSE(sampler.Last(&sample));
+    // 第一次只记录基准
+    ASSERT_FALSE(sampler.Sample(&sample));
+
+    std::atomic<bool> stop(false);
+    std::thread busy([&stop] {
+        pthread_setname_np(pthread_self(), "test_busy:0");
+        volatile uint64_t n = 0;
+        while (!stop) ++n;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_TRUE(sampler.Sample(&sample));
+    stop = true;
+    busy.join();
+
+    ASSERT_GT(sample.cpu_count, 0U);
+    ASSERT_GT(sample.interval_ms, 0);
+    ASSERT_GT(sample.process_usage, 0);
+    auto it = std::find_if(sample.groups.begin(), sample.groups.end(),
+                           [](const ThreadGroupCpu& g) { return g.name == "test_busy"; });
+    ASSERT_NE(it, sample.groups.end());
+    ASSERT_EQ(it->threads, 1U);
+    ASSERT_GT(it->usage, 30);
+    ASSERT_EQ(it->max, it->usage);
+
+    CpuSample last;
+    ASSERT_TRUE(sampler.Last(&last));
+    ASSERT_EQ(last.groups.size(), sample.groups.size());
+}
+
 } /* namespace  */
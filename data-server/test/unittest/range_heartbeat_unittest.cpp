@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <grpc++/grpc++.h>
+
+#include "helper/mock/master_worker_mock.h"
+#include "master/client.h"
+#include "master/range_heartbeat_batcher.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore::dataserver;
+using namespace sharkstore::test::mock;
+
+mspb::RangeHeartbeatRequest makeHeartbeat(uint64_t range_id, uint64_t size) {
+    mspb::RangeHeartbeatRequest req;
+    req.mutable_range()->set_id(range_id);
+    req.mutable_leader()->set_node_id(1);
+    req.set_term(1);
+    req.mutable_stats()->set_approximate_size(size);
+    return req;
+}
+
+TEST(RangeHeartbeat, Batch) {
+    MasterWorkerMock master;
+    master::RangeHeartbeatBatcher batcher(&master, 2);
+
+    // first round: all ranges report full heartbeat in one request
+    for (uint64_t i = 1; i <= 3; ++i) {
+        batcher.Add(makeHeartbeat(i, 100));
+    }
+    ASSERT_EQ(batcher.Flush(1), 3U);
+    ASSERT_EQ(master.range_heartbeat_batches.size(), 1U);
+    ASSERT_TRUE(master.range_heartbeats.empty());
+    {
+        const auto& batch = master.range_heartbeat_batches.back();
+        ASSERT_EQ(batch.node_id(), 1U);
+        ASSERT_EQ(batch.ranges_size(), 3);
+        ASSERT_EQ(batch.unchanged_ranges_size(), 0);
+    }
+
+    // second round: only range 2 changed
+    batcher.Add(makeHeartbeat(1, 100));
+    batcher.Add(makeHeartbeat(2, 200));
+    batcher.Add(makeHeartbeat(3, 100));
+    ASSERT_EQ(batcher.Flush(1), 3U);
+    ASSERT_EQ(master.range_heartbeat_batches.size(), 2U);
+    {
+        const auto& batch = master.range_heartbeat_batches.back();
+        ASSERT_EQ(batch.ranges_size(), 1);
+        ASSERT_EQ(batch.ranges(0).range().id(), 2U);
+        ASSERT_EQ(batch.ranges(0).stats().approximate_size(), 200U);
+        ASSERT_EQ(batch.unchanged_ranges_size(), 2);
+        ASSERT_EQ(batch.unchanged_ranges(0), 1U);
+        ASSERT_EQ(batch.unchanged_ranges(1), 3U);
+        // full heartbeats of unchanged ranges are kept for resending
+        const auto& unchanged = master.range_heartbeat_unchanged.back();
+        ASSERT_EQ(unchanged.size(), 2U);
+        ASSERT_EQ(unchanged[0]->range().id(), 1U);
+        ASSERT_EQ(unchanged[1]->range().id(), 3U);
+        ASSERT_EQ(unchanged[1]->stats().approximate_size(), 100U);
+    }
+
+    // nothing pending
+    ASSERT_EQ(batcher.Flush(1), 0U);
+    ASSERT_EQ(master.range_heartbeat_batches.size(), 2U);
+}
+
+TEST(RangeHeartbeat, FullRounds) {
+    MasterWorkerMock master;
+    master::RangeHeartbeatBatcher batcher(&master, 2);
+
+    std::vector<int> full_counts;
+    for (int round = 0; round < 6; ++round) {
+        batcher.Add(makeHeartbeat(1, 100));
+        batcher.Flush(1);
+        full_counts.push_back(master.range_heartbeat_batches.back().ranges_size());
+    }
+    // full report, skip twice, full report ...
+    std::vector<int> expected{1, 0, 0, 1, 0, 0};
+    ASSERT_EQ(full_counts, expected);
+}
+
+TEST(RangeHeartbeat, Forget) {
+    MasterWorkerMock master;
+    master::RangeHeartbeatBatcher batcher(&master, 10);
+
+    batcher.Add(makeHeartbeat(1, 100));
+    batcher.Flush(1);
+    ASSERT_EQ(batcher.TrackedSize(), 1U);
+
+    // range lost leadership and regained it, must report full heartbeat
+    batcher.Forget(1);
+    ASSERT_EQ(batcher.TrackedSize(), 0U);
+    batcher.Add(makeHeartbeat(1, 100));
+    batcher.Flush(1);
+    ASSERT_EQ(master.range_heartbeat_batches.back().ranges_size(), 1);
+    ASSERT_EQ(master.range_heartbeat_batches.back().unchanged_ranges_size(), 0);
+}
+
+TEST(RangeHeartbeat, Fallback) {
+    MasterWorkerMock master;
+    master.batch_supported = false;
+    master::RangeHeartbeatBatcher batcher(&master, 10);
+
+    for (int round = 0; round < 2; ++round) {
+        batcher.Add(makeHeartbeat(1, 100));
+        batcher.Add(makeHeartbeat(2, 100));
+        ASSERT_EQ(batcher.Flush(1), 2U);
+    }
+    // old master: every range sends its own full heartbeat every round
+    ASSERT_TRUE(master.range_heartbeat_batches.empty());
+    ASSERT_EQ(master.range_heartbeats.size(), 4U);
+
+    // unchanged ranges are not dropped when batch becomes unsupported
+    master.range_heartbeats.clear();
+    master.batch_supported = true;
+    batcher.Add(makeHeartbeat(1, 100));
+    batcher.Add(makeHeartbeat(2, 100));
+    master.batch_supported = false;
+    ASSERT_EQ(batcher.Flush(1), 2U);
+    ASSERT_EQ(master.range_heartbeats.size(), 2U);
+    ASSERT_EQ(master.range_heartbeats[0].range().id(), 1U);
+    ASSERT_EQ(master.range_heartbeats[1].range().id(), 2U);
+    ASSERT_EQ(master.range_heartbeats[1].stats().approximate_size(), 100U);
+}
+
+// master server stub, RangeHeartbeatBatch is unimplemented unless batch_supported
+class FakeMaster final : public mspb::MsServer::Service {
+public:
+    grpc::Status GetMSLeader(grpc::ServerContext*, const mspb::GetMSLeaderRequest*,
+                             mspb::GetMSLeaderResponse* resp) override {
+        resp->mutable_leader()->set_address(addr);
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RangeHeartbeat(grpc::ServerContext*, const mspb::RangeHeartbeatRequest* req,
+                                mspb::RangeHeartbeatResponse*) override {
+        std::lock_guard<std::mutex> lock(mu);
+        heartbeats.push_back(*req);
+        cond.notify_all();
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RangeHeartbeatBatch(grpc::ServerContext*,
+                                     const mspb::RangeHeartbeatBatchRequest* req,
+                                     mspb::RangeHeartbeatBatchResponse* resp) override {
+        if (!batch_supported) {
+            return grpc::Status(grpc::UNIMPLEMENTED, "");
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        if (batches.empty()) {
+            for (auto range_id : full_report_ranges) {
+                resp->add_full_report_ranges(range_id);
+            }
+        }
+        batches.push_back(*req);
+        cond.notify_all();
+        return grpc::Status::OK;
+    }
+
+    // wait until pred is true or timeout
+    template <class Pred>
+    bool Wait(Pred pred) {
+        std::unique_lock<std::mutex> lock(mu);
+        return cond.wait_for(lock, std::chrono::seconds(5), pred);
+    }
+
+public:
+    std::string addr;
+    bool batch_supported = false;
+    std::vector<uint64_t> full_report_ranges;
+
+    std::mutex mu;
+    std::condition_variable cond;
+    std::vector<mspb::RangeHeartbeatRequest> heartbeats;
+    std::vector<mspb::RangeHeartbeatBatchRequest> batches;
+};
+
+class NopTaskHandler : public master::TaskHandler {
+public:
+    void OnNodeHeartbeatResp(const mspb::NodeHeartbeatResponse&) override {}
+    void OnRangeHeartbeatResp(const mspb::RangeHeartbeatResponse&) override {}
+    void OnAskSplitResp(const mspb::AskSplitResponse&) override {}
+    void CollectNodeHeartbeat(mspb::NodeHeartbeatRequest*) override {}
+};
+
+class MasterClientTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        int port = 0;
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+        builder.RegisterService(&master_);
+        server_ = builder.BuildAndStart();
+        ASSERT_TRUE(server_ != nullptr);
+        master_.addr = "127.0.0.1:" + std::to_string(port);
+
+        // the recv thread is detached, keep the client alive until exit
+        client_ = new master::Client({master_.addr});
+        client_->Start(&handler_);
+    }
+
+    void TearDown() override { server_->Shutdown(); }
+
+    // range 1 changed, range 2 unchanged
+    void sendBatch() {
+        mspb::RangeHeartbeatBatchRequest req;
+        req.set_node_id(1);
+        req.add_ranges()->CopyFrom(makeHeartbeat(1, 100));
+        req.add_unchanged_ranges(2);
+        master::RangeHeartbeatList unchanged;
+        unchanged.push_back(
+            std::make_shared<const mspb::RangeHeartbeatRequest>(makeHeartbeat(2, 200)));
+        auto s = client_->AsyncRangeHeartbeatBatch(req, unchanged);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+
+protected:
+    FakeMaster master_;
+    NopTaskHandler handler_;
+    std::unique_ptr<grpc::Server> server_;
+    master::Client* client_ = nullptr;
+};
+
+TEST_F(MasterClientTest, FallbackUnimplemented) {
+    ASSERT_TRUE(client_->RangeHeartbeatBatchSupported());
+    sendBatch();
+
+    // old master: every range of the batch is resent with full heartbeat
+    ASSERT_TRUE(master_.Wait([this] { return master_.heartbeats.size() >= 2; }));
+    ASSERT_EQ(master_.heartbeats.size(), 2U);
+    ASSERT_EQ(master_.heartbeats[0].range().id(), 1U);
+    ASSERT_EQ(master_.heartbeats[1].range().id(), 2U);
+    ASSERT_EQ(master_.heartbeats[1].stats().approximate_size(), 200U);
+    ASSERT_FALSE(client_->RangeHeartbeatBatchSupported());
+}
+
+TEST_F(MasterClientTest, FullReport) {
+    master_.batch_supported = true;
+    master_.full_report_ranges = {2};
+    sendBatch();
+
+    // master lost range 2's heartbeat, client resends it in full
+    ASSERT_TRUE(master_.Wait([this] { return master_.batches.size() >= 2; }));
+    const auto& resend = master_.batches[1];
+    ASSERT_EQ(resend.node_id(), 1U);
+    ASSERT_EQ(resend.ranges_size(), 1);
+    ASSERT_EQ(resend.ranges(0).range().id(), 2U);
+    ASSERT_EQ(resend.ranges(0).stats().approximate_size(), 200U);
+    ASSERT_EQ(resend.unchanged_ranges_size(), 0);
+    ASSERT_TRUE(master_.heartbeats.empty());
+    ASSERT_TRUE(client_->RangeHeartbeatBatchSupported());
+}
+
+} /* namespace  */
@@ -1,8 +1,16 @@
 #include <gtest/gtest.h>
+#include <map>
+#include <thread>
 
 #include "base/util.h"
+#include "common/ds_config.h"
+#include "common/ds_encoding.h"
 #include "helper/store_test_fixture.h"
+#include "proto/gen/raft_cmdpb.pb.h"
 #include "proto/gen/watchpb.pb.h"
+#include "storage/field_value.h"
+#include "storage/row_index.h"
+#include "storage/ttl.h"
 
 int main(int argc, char* argv[]) {
     testing::InitGoogleTest(&argc, argv);
@@ -86,6 +94,57 @@ TEST_F(StoreTest, Insert) {
         ASSERT_EQ(s.code(), sharkstore::Status::kDuplicate);
         ASSERT_EQ(affected, 0);
     }
+    // insert multi rows check duplicate, only one row duplicated
+    {
+        InsertRequestBuilder builder(table_.get());
+        builder.AddRow({"1000", "user1000", "100"});
+        builder.AddRow({"50", "user50", "100"});
+        builder.AddRow({"1001", "user1001", "100"});
+        builder.SetCheckDuplicate();
+        auto req = builder.Build();
+        uint64_t affected = 0;
+        auto s = store_->Insert(req, &affected);
+        ASSERT_FALSE(s.ok());
+        ASSERT_EQ(s.code(), sharkstore::Status::kDuplicate);
+        ASSERT_EQ(affected, 0);
+    }
+}
+
+TEST_F(StoreTest, MultiGet) {
+    std::vector<std::string> keys;
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < 100; ++i) {
+        auto key = sharkstore::randomString(32);
+        keys.push_back(key);
+        // 一半的key写入
+        if (i % 2 == 0) {
+            auto value = sharkstore::randomString(64);
+            auto s = store_->Put(key, value);
+            ASSERT_TRUE(s.ok()) << s.ToString();
+            expected[key] = value;
+        }
+    }
+
+    std::vector<std::string> values;
+    std::vector<sharkstore::Status> statuses;
+    store_->MultiGet(keys, &values, &statuses);
+    ASSERT_EQ(values.size(), keys.size());
+    ASSERT_EQ(statuses.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto it = expected.find(keys[i]);
+        if (it != expected.end()) {
+            ASSERT_TRUE(statuses[i].ok()) << statuses[i].ToString();
+            ASSERT_EQ(values[i], it->second);
+        } else {
+            ASSERT_EQ(statuses[i].code(), sharkstore::Status::kNotFound);
+            ASSERT_TRUE(values[i].empty());
+        }
+    }
+
+    // empty
+    store_->MultiGet(std::vector<std::string>(), &values, &statuses);
+    ASSERT_TRUE(values.empty());
+    ASSERT_TRUE(statuses.empty());
 }
 
 TEST_F(StoreTest, SelectEmpty) {
@@ -246,6 +305,129 @@ TEST_F(StoreTest, SelectLimit) {
     ASSERT_TRUE(s.ok()) << s.ToString();
 }
 
+TEST_F(StoreTest, SelectOrderBy) {
+    InsertSomeRows();
+
+    // order by balance desc limit 3
+    auto s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddOrderBy("balance", true);
+                b.AddLimit(3);
+            },
+            {rows_[99], rows_[98], rows_[97]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // order by balance desc limit 2, 3
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddOrderBy("balance", true);
+                b.AddLimit(3, 2);
+            },
+            {rows_[97], rows_[96], rows_[95]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // where balance < 105 order by name desc
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Less, "105");
+                b.AddOrderBy("name", true);
+            },
+            {rows_[3], rows_[2], rows_[1], rows_[0]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // order by column not in field list
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddField("id");
+                b.AddOrderBy("balance", true);
+                b.AddLimit(2);
+            },
+            {{"100"}, {"99"}}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // ties are ordered by primary key
+    s = testInsert({{"101", "user-0101", "300"}, {"102", "user-0102", "300"}});
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddField("id");
+                b.AddOrderBy("balance", true);
+                b.AddLimit(3);
+            },
+            {{"101"}, {"102"}, {"100"}}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // offset is the number of all matched rows
+    SelectRequestBuilder builder(table_.get());
+    builder.AddField("id");
+    builder.AddOrderBy("balance");
+    builder.AddLimit(1);
+    auto req = builder.Build();
+    kvrpcpb::SelectResponse resp;
+    s = store_->Select(req, &resp);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(resp.rows_size(), 1);
+    ASSERT_EQ(resp.offset(), 102U);
+
+    // offset + count is bounded
+    req.mutable_limit()->set_offset(100000);
+    resp.Clear();
+    s = store_->Select(req, &resp);
+    ASSERT_EQ(s.code(), sharkstore::Status::kInvalidArgument) << s.ToString();
+
+    // a scope beyond the range is clamped, and the range returns its top
+    // offset+count rows without skipping offset (the proxy merges them)
+    InsertRequestBuilder key_builder(table_.get());
+    key_builder.AddRow(rows_[50]);
+    auto meta = meta_;
+    meta.set_start_key(key_builder.Build().rows(0).key());
+    storage::Store half_store(meta, db_);
+
+    req.mutable_order_bys(0)->set_desc(true);
+    req.mutable_limit()->set_count(2);
+    req.mutable_limit()->set_offset(1);
+    kvrpcpb::SelectResponse wide_resp;
+    s = half_store.Select(req, &wide_resp);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(wide_resp.rows_size(), 3);
+    ASSERT_EQ(wide_resp.offset(), 52U);
+
+    // the same query within the range skips offset
+    req.mutable_scope()->set_start(meta.start_key());
+    req.mutable_scope()->set_limit(meta.end_key());
+    resp.Clear();
+    s = half_store.Select(req, &resp);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(resp.rows_size(), 2);
+    ASSERT_EQ(resp.rows(0).fields(), wide_resp.rows(1).fields());
+    ASSERT_EQ(resp.rows(1).fields(), wide_resp.rows(2).fields());
+
+    // rows before the range are not returned
+    req.mutable_order_bys(0)->set_desc(false);
+    req.clear_scope();
+    req.mutable_limit()->set_offset(0);
+    resp.Clear();
+    s = half_store.Select(req, &resp);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(resp.rows_size(), 2);
+    SelectRequestBuilder first_builder(table_.get());
+    first_builder.AddField("id");
+    first_builder.SetKey({rows_[50][0]});
+    kvrpcpb::SelectResponse first_resp;
+    s = store_->Select(first_builder.Build(), &first_resp);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(first_resp.rows_size(), 1);
+    ASSERT_EQ(resp.rows(0).fields(), first_resp.rows(0).fields());
+}
+
 TEST_F(StoreTest, SelectWhere) {
     InsertSomeRows();
 
@@ -627,6 +809,599 @@ TEST_F(StoreTest, DeleteWhere) {
 
 
 
+// account table with index on balance and name
+class StoreIndexTest : public StoreTest {
+public:
+    StoreIndexTest() { index_columns_ = {"balance", "name"}; }
+
+    // range_id为0时统计所有range的索引
+    size_t CountIndexKeys(uint64_t range_id = 0) {
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+        std::string prefix(1, static_cast<char>(storage::kStoreIndexPrefixByte));
+        if (range_id != 0) {
+            prefix.clear();
+            storage::EncodeIndexPrefix(&prefix, range_id);
+        }
+        size_t count = 0;
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+            ++count;
+        }
+        return count;
+    }
+
+    std::string RowKey(const std::vector<std::string>& row) {
+        InsertRequestBuilder builder(table_.get());
+        builder.AddRow(row);
+        return builder.Build().rows(0).key();
+    }
+};
+
+TEST_F(StoreIndexTest, Select) {
+    InsertSomeRows();
+    ASSERT_EQ(CountIndexKeys(), rows_.size() * 2);
+
+    // balance == 150
+    auto s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Equal, "150");
+            },
+            {rows_[49]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // 150 <= balance < 153
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::LargerOrEqual, "150");
+                b.AddMatch("balance", kvrpcpb::Less, "153");
+            },
+            {rows_[49], rows_[50], rows_[51]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // balance > 197
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Larger, "197");
+            },
+            {rows_[97], rows_[98], rows_[99]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // name == "user-0010" and balance <= 110
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("name", kvrpcpb::Equal, "user-0010");
+                b.AddMatch("balance", kvrpcpb::LessOrEqual, "110");
+            },
+            {rows_[9]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // index scope within primary key scope
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.SetScope({"1"}, {"50"});
+                b.AddMatch("balance", kvrpcpb::Larger, "148");
+            },
+            {rows_[48]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // 非选择性的条件, 全表扫描
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Larger, "0");
+            },
+            rows_
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST_F(StoreIndexTest, Overwrite) {
+    InsertSomeRows();
+
+    // overwrite id 1: balance 101 -> 999
+    rows_[0][2] = "999";
+    auto s = testInsert({rows_[0]});
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), rows_.size() * 2);
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Equal, "101");
+            },
+            {}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Equal, "999");
+            },
+            {rows_[0]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // stale index entry must not return the row
+    std::string stale_key;
+    auto col = table_->GetColumn("balance");
+    storage::EncodeIndexPrefix(&stale_key, meta_.id(), col);
+    storage::FieldValue v(static_cast<int64_t>(102));
+    storage::EncodeIndexValue(&stale_key, v);
+    InsertRequestBuilder builder(table_.get());
+    builder.AddRow(rows_[0]);
+    stale_key.append(builder.Build().rows(0).key());
+    ASSERT_TRUE(db_->Put(rocksdb::WriteOptions(), stale_key, "").ok());
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Equal, "102");
+            },
+            {rows_[1]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST_F(StoreIndexTest, Delete) {
+    InsertSomeRows();
+
+    auto s = testDelete(
+            [](DeleteRequestBuilder& b) {
+                b.AddMatch("balance", kvrpcpb::Equal, "150");
+            },
+            1
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), (rows_.size() - 1) * 2);
+
+    s = testDelete(
+            [](DeleteRequestBuilder& b) {
+                b.AddMatch("id", kvrpcpb::Equal, "2");
+            },
+            1
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), (rows_.size() - 2) * 2);
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::LessOrEqual, "102");
+            },
+            {rows_[0]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST_F(StoreIndexTest, KeyDelete) {
+    InsertSomeRows();
+
+    auto s = store_->Delete(RowKey(rows_[0]));
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), (rows_.size() - 1) * 2);
+
+    s = store_->BatchDelete({RowKey(rows_[1]), RowKey(rows_[2])});
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), (rows_.size() - 3) * 2);
+
+    // rows 4, 5
+    s = store_->RangeDelete(RowKey(rows_[3]), RowKey(rows_[5]));
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), (rows_.size() - 5) * 2);
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::LessOrEqual, "106");
+            },
+            {rows_[5]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST_F(StoreIndexTest, Split) {
+    InsertSomeRows();
+
+    // rows 51~100 split to range 2
+    auto split_key = RowKey(rows_[50]);
+    auto s = store_->SplitIndexes(split_key, 2);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // undo moves them back, and a replayed split gives the same result
+    s = store_->UndoSplitIndexes(split_key, 2);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(meta_.id()), 100U * 2);
+    ASSERT_EQ(CountIndexKeys(2), 0U);
+    s = store_->SplitIndexes(split_key, 2);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->SplitIndexes(split_key, 2);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    store_->SetEndKey(split_key);
+    ASSERT_EQ(CountIndexKeys(meta_.id()), 50U * 2);
+    ASSERT_EQ(CountIndexKeys(2), 50U * 2);
+
+    // each range only sees its own rows
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::LargerOrEqual, "149");
+            },
+            {rows_[48], rows_[49]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    auto meta = meta_;
+    meta.set_id(2);
+    meta.set_start_key(split_key);
+    storage::Store new_store(meta, db_);
+    SelectRequestBuilder builder(table_.get());
+    builder.AddField("id");
+    builder.AddMatch("name", kvrpcpb::Equal, "user-0051");
+    kvrpcpb::SelectResponse resp;
+    s = new_store.Select(builder.Build(), &resp);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(resp.rows_size(), 1);
+
+    s = new_store.Truncate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(2), 0U);
+    ASSERT_EQ(CountIndexKeys(meta_.id()), 50U * 2);
+}
+
+TEST_F(StoreIndexTest, TTL) {
+    InsertSomeRows();
+
+    // balance 101~110的行已过期，索引也带上了过期时间
+    InsertRequestBuilder builder(table_.get());
+    builder.AddRows({rows_.cbegin(), rows_.cbegin() + 10});
+    auto req = builder.Build();
+    for (int i = 0; i < req.rows_size(); ++i) {
+        req.mutable_rows(i)->set_expireat(storage::NowNanos() - 1);
+    }
+    uint64_t affected = 0;
+    auto s = store_->Insert(req, &affected);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), rows_.size() * 2);
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("balance", kvrpcpb::Less, "113");
+            },
+            {rows_[10], rows_[11]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("name", kvrpcpb::Equal, "user-0003");
+            },
+            {}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST_F(StoreIndexTest, TruncateAndSnapshot) {
+    InsertSomeRows();
+
+    // collect snapshot data
+    std::vector<std::string> datas;
+    std::unique_ptr<storage::Iterator> it(store_->NewIterator());
+    for (; it->Valid(); it->Next()) {
+        raft_cmdpb::SnapshotKVPair p;
+        p.set_key(it->key());
+        p.set_value(it->value());
+        datas.push_back(p.SerializeAsString());
+    }
+    it.reset();
+
+    auto s = store_->Truncate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), 0U);
+
+    // snapshot meta without index columns
+    auto meta = meta_;
+    meta.clear_index_columns();
+    store_->ResetIndexColumns(meta);
+    s = store_->ApplySnapshot(datas);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), 0U);
+
+    s = store_->Truncate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    store_->ResetIndexColumns(meta_);
+    s = store_->ApplySnapshot(datas);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(CountIndexKeys(), rows_.size() * 2);
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("name", kvrpcpb::Equal, "user-0033");
+            },
+            {rows_[32]}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+}
+
+TEST(TTL, ValueHeader) {
+    using namespace sharkstore::dataserver::storage;
+
+    auto now = NowNanos();
+    int64_t expire_at = 0;
+    rocksdb::Slice value;
+
+    auto stored = EncodeStoreValue("value", 0);
+    ASSERT_EQ(stored.size(), 1 + 5U);
+    ASSERT_TRUE(DecodeStoreValue(stored, &expire_at, &value));
+    ASSERT_EQ(expire_at, 0);
+    ASSERT_EQ(value.ToString(), "value");
+
+    stored = EncodeStoreValue("value", now + 1000);
+    ASSERT_EQ(stored.size(), kExpireHeaderSize + 5);
+    ASSERT_TRUE(DecodeStoreValue(stored, &expire_at, &value));
+    ASSERT_EQ(expire_at, now + 1000);
+    ASSERT_EQ(value.ToString(), "value");
+    ASSERT_FALSE(IsExpired(expire_at, now));
+    ASSERT_TRUE(IsExpired(expire_at, now + 1000));
+
+    bool corrupted = false;
+    ASSERT_TRUE(StripStoreValue(&stored, now, &corrupted));
+    ASSERT_EQ(stored, "value");
+    stored = EncodeStoreValue("value", now - 1);
+    ASSERT_FALSE(StripStoreValue(&stored, now, &corrupted));
+    ASSERT_FALSE(corrupted);
+
+    // 空value(索引)永不过期，未知的标记或长度不够是数据损坏
+    ASSERT_TRUE(DecodeStoreValue(rocksdb::Slice(), &expire_at, &value));
+    ASSERT_EQ(expire_at, 0);
+    ASSERT_FALSE(DecodeStoreValue(std::string("\x09value"), &expire_at, &value));
+    ASSERT_FALSE(DecodeStoreValue(std::string(1, kValueFlagExpire) + "abc", &expire_at, &value));
+    stored = "\x09value";
+    ASSERT_FALSE(StripStoreValue(&stored, now, &corrupted));
+    ASSERT_TRUE(corrupted);
+
+    ExpiredFilter filter(now);
+    std::string new_value;
+    bool changed = false;
+    ASSERT_TRUE(filter.Filter(0, "k", EncodeStoreValue("v", now - 1), &new_value, &changed));
+    ASSERT_FALSE(filter.Filter(0, "k", EncodeStoreValue("v", now + 1), &new_value, &changed));
+    ASSERT_FALSE(filter.Filter(0, "k", EncodeStoreValue("v", 0), &new_value, &changed));
+    ASSERT_FALSE(filter.Filter(0, "k", "", &new_value, &changed));
+    ASSERT_FALSE(changed);
+}
+
+TEST(TTL, LegacyRanges) {
+    using namespace sharkstore::dataserver::storage;
+
+    auto now = NowNanos();
+    auto expired = EncodeStoreValue("v", now - 1);
+    LegacyRanges legacy;
+    ExpiredFilter filter(now, &legacy);
+    std::string new_value;
+    bool changed = false;
+    ASSERT_TRUE(filter.Filter(0, "b", expired, &new_value, &changed));
+
+    // 范围还不知道的时候都按老格式处理
+    legacy.Add(1);
+    ASSERT_TRUE(legacy.Contains(1));
+    ASSERT_TRUE(legacy.ContainsKey("z"));
+    ASSERT_FALSE(filter.Filter(0, "z", expired, &new_value, &changed));
+
+    legacy.SetSpan(1, "b", "d");
+    legacy.Add(2);
+    legacy.SetSpan(2, "f", "");
+    legacy.SetSpan(3, "a", "b");  // 不是老格式，忽略
+    ASSERT_FALSE(legacy.ContainsKey("a"));
+    ASSERT_TRUE(legacy.ContainsKey("b"));
+    ASSERT_TRUE(legacy.ContainsKey("c"));
+    ASSERT_FALSE(legacy.ContainsKey("d"));
+    ASSERT_TRUE(legacy.ContainsKey("zzz"));
+    ASSERT_FALSE(filter.Filter(0, "c", expired, &new_value, &changed));
+    ASSERT_TRUE(filter.Filter(0, "e", expired, &new_value, &changed));
+
+    // 分裂后范围缩小
+    legacy.SetSpan(1, "b", "c");
+    ASSERT_FALSE(legacy.ContainsKey("c"));
+    legacy.Remove(2);
+    ASSERT_FALSE(legacy.Contains(2));
+    ASSERT_FALSE(legacy.ContainsKey("zzz"));
+    ASSERT_EQ(legacy.Size(), 1U);
+}
+
+TEST_F(StoreTest, TTLKeyValue) {
+    auto now = storage::NowNanos();
+    std::string live = sharkstore::randomString(32);
+    std::string dead = sharkstore::randomString(32);
+    auto s = store_->Put(live, "live", now + 3600 * 1000000000L);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->Put(dead, "dead", now - 1);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    std::string value;
+    s = store_->Get(live, &value);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(value, "live");
+    ASSERT_TRUE(store_->KeyExists(live));
+    s = store_->Get(dead, &value);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+    ASSERT_TRUE(value.empty());
+    ASSERT_FALSE(store_->KeyExists(dead));
+
+    // 批量写入，过期的和不过期的混在一起
+    std::vector<std::pair<std::string, std::string>> kvs;
+    std::vector<int64_t> expire_ats;
+    for (int i = 0; i < 10; ++i) {
+        kvs.emplace_back(sharkstore::randomString(32), std::to_string(i));
+        expire_ats.push_back(i % 2 == 0 ? now - 1 : 0);
+    }
+    s = store_->BatchSet(kvs, expire_ats);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    std::vector<std::string> keys{live, dead};
+    for (const auto& kv : kvs) {
+        keys.push_back(kv.first);
+    }
+    std::vector<std::string> values;
+    std::vector<sharkstore::Status> statuses;
+    store_->MultiGet(keys, &values, &statuses);
+    ASSERT_TRUE(statuses[0].ok());
+    ASSERT_EQ(values[0], "live");
+    ASSERT_EQ(statuses[1].code(), sharkstore::Status::kNotFound);
+    for (size_t i = 0; i < kvs.size(); ++i) {
+        if (i % 2 == 0) {
+            ASSERT_EQ(statuses[i + 2].code(), sharkstore::Status::kNotFound);
+            ASSERT_TRUE(values[i + 2].empty());
+        } else {
+            ASSERT_TRUE(statuses[i + 2].ok()) << statuses[i + 2].ToString();
+            ASSERT_EQ(values[i + 2], kvs[i].second);
+        }
+    }
+
+    // 过期的key可以重新写入
+    s = store_->Put(dead, "again");
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->Get(dead, &value);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(value, "again");
+}
+
+TEST_F(StoreTest, TTLLegacyFormat) {
+    // 升级前写入的数据没有value头部
+    std::string old_key = meta_.start_key() + "old";
+    std::string old_value = std::string(1, storage::kValueFlagExpire) + "12345678abc";
+    auto ret = db_->Put(rocksdb::WriteOptions(), old_key, old_value);
+    ASSERT_TRUE(ret.ok()) << ret.ToString();
+
+    storage::LegacyRanges legacy;
+    legacy.Add(meta_.id());
+    delete store_;
+    store_ = new storage::Store(meta_, db_, &legacy);
+    ASSERT_TRUE(store_->LegacyFormat());
+    ASSERT_TRUE(legacy.ContainsKey(old_key));
+
+    std::string value;
+    auto s = store_->Get(old_key, &value);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(value, old_value);
+    ASSERT_TRUE(store_->KeyExists(old_key));
+
+    // 老格式不支持过期，原样写入
+    std::string new_key = meta_.start_key() + "new";
+    s = store_->Put(new_key, "new", storage::NowNanos() - 1);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ret = db_->Get(rocksdb::ReadOptions(), new_key, &value);
+    ASSERT_TRUE(ret.ok()) << ret.ToString();
+    ASSERT_EQ(value, "new");
+
+    std::unique_ptr<storage::Iterator> iter(store_->NewIterator(new_key, old_key + "\xff"));
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(iter->key(), new_key);
+    ASSERT_EQ(iter->value(), "new");
+    iter->Next();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(iter->value(), old_value);
+    iter.reset();
+
+    // 数据清空后转成新格式
+    s = store_->Truncate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    store_->ClearLegacyFormat();
+    ASSERT_FALSE(store_->LegacyFormat());
+    ASSERT_FALSE(legacy.Contains(meta_.id()));
+    s = store_->Put(new_key, "new", storage::NowNanos() - 1);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->Get(new_key, &value);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+
+    delete store_;
+    store_ = new storage::Store(meta_, db_);
+}
+
+TEST_F(StoreTest, TTLRows) {
+    InsertSomeRows();
+
+    // 重新写入前20行，前10行已过期，后10行一小时后过期
+    auto now = storage::NowNanos();
+    auto future = now + 3600 * 1000000000L;
+    InsertRequestBuilder builder(table_.get());
+    builder.AddRows({rows_.cbegin(), rows_.cbegin() + 20});
+    auto req = builder.Build();
+    for (int i = 0; i < req.rows_size(); ++i) {
+        req.mutable_rows(i)->set_expireat(i < 10 ? now - 1 : future);
+    }
+    uint64_t affected = 0;
+    auto s = store_->Insert(req, &affected);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(affected, 20U);
+
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+            },
+            {rows_.cbegin() + 10, rows_.cend()}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+                b.AddMatch("id", kvrpcpb::Equal, "5");
+            },
+            {}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    // 快照带上过期时间
+    std::vector<std::string> datas;
+    std::unique_ptr<storage::Iterator> it(store_->NewIterator());
+    for (; it->Valid(); it->Next()) {
+        raft_cmdpb::SnapshotKVPair p;
+        p.set_key(it->key());
+        p.set_value(it->value());
+        p.set_expire_at(it->expire_at());
+        datas.push_back(p.SerializeAsString());
+    }
+    ASSERT_TRUE(it->status().ok()) << it->status().ToString();
+    it.reset();
+    ASSERT_EQ(datas.size(), rows_.size() - 10);
+    raft_cmdpb::SnapshotKVPair first;
+    ASSERT_TRUE(first.ParseFromString(datas[0]));
+    ASSERT_EQ(first.expire_at(), future);
+
+    // 再加一条已过期的，apply后不可见
+    raft_cmdpb::SnapshotKVPair expired;
+    expired.set_key(req.rows(0).key());
+    expired.set_value(req.rows(0).value());
+    expired.set_expire_at(now - 1);
+    datas.push_back(expired.SerializeAsString());
+
+    s = store_->Truncate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->ApplySnapshot(datas);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = testSelect(
+            [](SelectRequestBuilder& b) {
+                b.AddAllFields();
+            },
+            {rows_.cbegin() + 10, rows_.cend()}
+    );
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    std::string value;
+    s = store_->Get(req.rows(10).key(), &value);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(value, req.rows(10).value());
+}
+
 TEST_F(StoreTest, Watch) {
     {
         watchpb::KvWatchPutRequest req;
@@ -753,4 +1528,191 @@ TEST_F(StoreTest, Watch) {
 }
 
 
+TEST_F(StoreTest, WatchChangeLog) {
+    auto old_enabled = ds_config.watch_config.change_log;
+    ds_config.watch_config.change_log = true;
+
+    auto encode = [this](const std::vector<std::string>& keys) {
+        std::string buf;
+        buf.push_back(static_cast<char>(storage::kStoreKVPrefixByte));
+        EncodeUint64Ascending(&buf, meta_.table_id());
+        for (const auto& k : keys) {
+            EncodeBytesAscending(&buf, k.c_str(), k.size());
+        }
+        return buf;
+    };
+    auto change = [&](watchpb::EventType type, const std::vector<std::string>& keys) {
+        storage::Store::WatchChange c;
+        c.key = encode(keys);
+        EncodeIntValue(&c.value, 2, 0);
+        EncodeBytesValue(&c.value, 3, "value", 5);
+        EncodeBytesValue(&c.value, 4, "", 0);
+        c.event.set_type(type);
+        for (const auto& k : keys) {
+            c.event.mutable_kv()->add_key(k);
+        }
+        return c;
+    };
+    auto apply = [&](int64_t revision, const std::vector<storage::Store::WatchChange>& changes) {
+        auto s = store_->WatchApply(revision, changes);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    };
+
+    apply(10, {change(watchpb::PUT, {"a", "b", "c1"})});
+    apply(11, {change(watchpb::PUT, {"a", "b", "c2"})});
+    apply(12, {change(watchpb::PUT, {"a", "d"})});
+    apply(13, {change(watchpb::DELETE, {"a", "b", "c1"})});
+
+    // 日志之前的变更不能追赶
+    std::vector<watchpb::Event> events;
+    auto s = store_->WatchChanges(encode({"a"}), 8, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+
+    s = store_->WatchChanges(encode({"a"}), 9, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(events.size(), 4U);
+    ASSERT_EQ(events[0].kv().version(), 10);
+    ASSERT_EQ(events[3].kv().version(), 13);
+
+    // 按前缀过滤，删除也能追赶到
+    events.clear();
+    s = store_->WatchChanges(encode({"a", "b"}), 10, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(events.size(), 2U);
+    ASSERT_EQ(events[0].type(), watchpb::PUT);
+    ASSERT_EQ(events[0].kv().key(2), "c2");
+    ASSERT_EQ(events[1].type(), watchpb::DELETE);
+    ASSERT_EQ(events[1].kv().key(2), "c1");
+    ASSERT_EQ(events[1].kv().version(), 13);
+
+    // 日志不在range的key空间里，扫描和大小统计都看不到
+    {
+        watchpb::DsKvWatchGetMultiRequest req;
+        req.mutable_kv()->add_key("a");
+        req.set_prefix(true);
+        watchpb::DsKvWatchGetMultiResponse resp;
+        s = store_->WatchGet(req, &resp);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        ASSERT_EQ(resp.kvs_size(), 2);
+
+        std::unique_ptr<storage::Iterator> iter(store_->NewIterator());
+        int count = 0;
+        for (; iter->Valid(); iter->Next()) {
+            ASSERT_EQ(static_cast<unsigned char>(iter->key()[0]), storage::kStoreKVPrefixByte);
+            ++count;
+        }
+        ASSERT_EQ(count, 2);
+    }
+
+    // 超过条数时后台清理最旧的，写入时不清理
+    auto old_max = ds_config.watch_config.change_log_max_entries;
+    ds_config.watch_config.change_log_max_entries = 3;
+    apply(14, {change(watchpb::PUT, {"a", "e"})});
+    events.clear();
+    s = store_->WatchChanges(encode({"a"}), 9, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(events.size(), 5U);
+    s = store_->TrimWatchLog();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ds_config.watch_config.change_log_max_entries = old_max;
+
+    events.clear();
+    s = store_->WatchChanges(encode({"a"}), 10, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+    s = store_->WatchChanges(encode({"a"}), 11, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(events.size(), 3U);
+
+    // 重新打开后从存储加载日志的状态
+    delete store_;
+    store_ = new storage::Store(meta_, db_);
+    apply(15, {change(watchpb::DELETE, {"a", "d"}), change(watchpb::DELETE, {"a", "e"})});
+    events.clear();
+    s = store_->WatchChanges(encode({"a"}), 14, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(events.size(), 2U);
+    ASSERT_EQ(events[1].kv().key(1), "e");
+
+    // 分裂时分出去的key的日志复制给新range
+    {
+        auto split_key = encode({"a", "e"});
+        s = store_->SplitWatchLog(split_key, 2);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        auto meta = meta_;
+        meta.set_id(2);
+        meta.set_start_key(split_key);
+        storage::Store new_store(meta, db_);
+        events.clear();
+        s = new_store.WatchChanges(encode({"a"}), 11, &events);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        ASSERT_EQ(events.size(), 2U);
+        ASSERT_EQ(events[0].kv().key(1), "e");
+        ASSERT_EQ(events[0].kv().version(), 14);
+        ASSERT_EQ(events[1].kv().key(1), "e");
+        ASSERT_EQ(events[1].kv().version(), 15);
+        // 清理过的部分在新range上同样不能追赶
+        s = new_store.WatchChanges(encode({"a"}), 10, &events);
+        ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+        // 重复执行不会覆盖新range自己的日志
+        new_store.WatchApply(16, {change(watchpb::PUT, {"a", "f"})});
+        s = store_->SplitWatchLog(split_key, 2);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        events.clear();
+        s = new_store.WatchChanges(encode({"a"}), 11, &events);
+        ASSERT_TRUE(s.ok()) << s.ToString();
+        ASSERT_EQ(events.size(), 3U);
+        s = new_store.Truncate();
+        ASSERT_TRUE(s.ok()) << s.ToString();
+    }
+
+    // 没有写入时后台按保留时间清理
+    auto old_retention = ds_config.watch_config.change_log_retention;
+    ds_config.watch_config.change_log_retention = 1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    s = store_->TrimWatchLog();
+    ds_config.watch_config.change_log_retention = old_retention;
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    events.clear();
+    s = store_->WatchChanges(encode({"a"}), 14, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+    s = store_->WatchChanges(encode({"a"}), 15, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_TRUE(events.empty());
+
+    // revision回退时旧日志作废
+    apply(16, {change(watchpb::PUT, {"a", "f"})});
+    apply(5, {change(watchpb::PUT, {"a", "f"})});
+    events.clear();
+    s = store_->WatchChanges(encode({"a"}), 3, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+    s = store_->WatchChanges(encode({"a"}), 4, &events);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    ASSERT_EQ(events.size(), 1U);
+    ASSERT_EQ(events[0].kv().version(), 5);
+
+    // 数据清空时日志一起删除
+    s = store_->Truncate();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->WatchChanges(encode({"a"}), 4, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+
+    // 关闭后不再记录，残留的日志在后台清理
+    apply(20, {change(watchpb::PUT, {"a", "g"})});
+    ds_config.watch_config.change_log = false;
+    apply(21, {change(watchpb::PUT, {"a", "h"})});
+    s = store_->TrimWatchLog();
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    s = store_->WatchChanges(encode({"a"}), 19, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+    ds_config.watch_config.change_log = true;
+    s = store_->WatchChanges(encode({"a"}), 19, &events);
+    ASSERT_EQ(s.code(), sharkstore::Status::kNotFound);
+    std::string value;
+    s = store_->Get(encode({"a", "h"}), &value);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+
+    ds_config.watch_config.change_log = old_enabled;
+}
+
+
 } /* namespace  */
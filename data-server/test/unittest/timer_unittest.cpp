@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
+#include <map>
 
 #include "base/timer.h"
+#include "base/timer_wheel.h"
 #include "base/util.h"
 #include "base/status.h"
+#include "frame/sf_util.h"
+#include "watch/watcher.h"
+#include "watch/watcher_timer.h"
 
 int main(int argc, char* argv[]) {
     testing::InitGoogleTest(&argc, argv);
@@ -71,5 +76,104 @@ TEST(Timer, Basic) {
     }
 }
 
+TEST(TimerWheel, Basic) {
+    const int64_t start = 1000000;
+    TimerWheel<int> wheel(10, start);
+
+    // 覆盖各层以及超出范围的定时器
+    std::map<int, int64_t> expect;
+    std::vector<int64_t> delays = {0, 5, 10, 11, 640, 655, 5000, 40960, 123456,
+                                   2621440, 30000000, 300000000};
+    for (size_t i = 0; i < delays.size(); ++i) {
+        wheel.Add(start + delays[i], static_cast<int>(i));
+        expect[static_cast<int>(i)] = start + delays[i];
+    }
+    ASSERT_EQ(wheel.Size(), delays.size());
+
+    // 每次前进不同的步长，到期时间不能早于设定值，也不能晚于一个tick
+    std::map<int, int64_t> fired;
+    int64_t now = start;
+    int step = 0;
+    while (wheel.Size() > 0) {
+        now += (step++ % 3 == 0) ? 10 : 997;
+        std::vector<int> expired;
+        wheel.Advance(now, &expired);
+        for (auto v : expired) {
+            ASSERT_TRUE(fired.emplace(v, now).second);
+        }
+        ASSERT_LT(now, start + 400000000);
+    }
+    ASSERT_EQ(fired.size(), expect.size());
+    for (const auto& kv : fired) {
+        auto at = expect[kv.first];
+        EXPECT_GE(kv.second, at) << kv.first;
+        EXPECT_LT(kv.second, std::max(at, start + 10) + 10 + 997) << kv.first;
+    }
+}
+
+TEST(TimerWheel, Cancel) {
+    TimerWheel<int> wheel(10, 0);
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 1000; ++i) {
+        ids.push_back(wheel.Add(10 + i * 7, i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(wheel.Cancel(ids[i]));
+        ASSERT_FALSE(wheel.Cancel(ids[i]));
+    }
+    ASSERT_EQ(wheel.Size(), 500U);
+
+    std::vector<int> expired;
+    wheel.Advance(10000, &expired);
+    ASSERT_EQ(expired.size(), 500U);
+    for (size_t i = 0; i < expired.size(); ++i) {
+        ASSERT_EQ(expired[i] % 2, 1);
+        if (i > 0) {
+            ASSERT_LE(expired[i - 1], expired[i]);
+        }
+    }
+    ASSERT_EQ(wheel.Size(), 0U);
+    // 已经到期的不能再取消
+    ASSERT_FALSE(wheel.Cancel(ids[1]));
+}
+
+TEST(WatcherTimer, ExpireAndCancel) {
+    using dataserver::watch::Watcher;
+    using dataserver::watch::WatcherPtr;
+
+    std::mutex mu;
+    std::condition_variable cond;
+    std::vector<WatcherPtr> fired;
+    dataserver::watch::WatcherTimer timer([&](std::vector<WatcherPtr>& expired) {
+        std::lock_guard<std::mutex> lock(mu);
+        fired.insert(fired.end(), expired.begin(), expired.end());
+        cond.notify_one();
+    });
+
+    std::string key("key");
+    std::vector<std::string*> keys{&key};
+    auto w1 = std::make_shared<Watcher>(1, keys);
+    auto w2 = std::make_shared<Watcher>(1, keys);
+    auto now = get_micro_second() / 1000;
+    timer.Add(w1, now + 50);
+    auto id2 = timer.Add(w2, now + 50);
+    ASSERT_EQ(timer.Size(), 2U);
+
+    // 取消之后定时器里不再持有watcher
+    timer.Cancel(id2);
+    ASSERT_EQ(timer.Size(), 1U);
+    ASSERT_EQ(w2.use_count(), 1);
+
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        ASSERT_TRUE(cond.wait_for(lock, std::chrono::seconds(2), [&] { return !fired.empty(); }));
+        ASSERT_EQ(fired.size(), 1U);
+        ASSERT_EQ(fired[0], w1);
+    }
+    ASSERT_GE(get_micro_second() / 1000, now + 50);
+    ASSERT_EQ(timer.Size(), 0U);
+
+    timer.Stop();
+}
 
 } /* namespace  */
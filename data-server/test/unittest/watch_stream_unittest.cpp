@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include "frame/sf_util.h"
+#include "watch/watch_stream.h"
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+namespace {
+
+using namespace sharkstore::dataserver::watch;
+
+watchpb::Event makeEvent(const std::string& key, const std::string& value) {
+    watchpb::Event evt;
+    evt.set_type(watchpb::PUT);
+    evt.mutable_kv()->add_key(key);
+    evt.mutable_kv()->set_value(value);
+    return evt;
+}
+
+WatcherPtr makePoll() {
+    std::string key("key");
+    std::vector<std::string*> keys{&key};
+    return std::make_shared<Watcher>(1, keys);
+}
+
+TEST(WatchStream, PollAndAck) {
+    WatchStream stream(1, 1, false, "key", 100);
+
+    WatcherPtr poll;
+    watchpb::DsWatchResponse* resp = nullptr;
+    ASSERT_FALSE(stream.Append(makeEvent("key", "v1"), 10, &poll, &resp));
+    ASSERT_FALSE(stream.Append(makeEvent("key", "v2"), 11, &poll, &resp));
+    ASSERT_FALSE(stream.Append(makeEvent("key", "v3"), 12, &poll, &resp));
+
+    // 一次最多两个事件
+    WatcherPtr replaced;
+    auto p1 = makePoll();
+    ASSERT_TRUE(stream.Poll(p1, 0, 2, &resp, &replaced));
+    ASSERT_EQ(replaced, nullptr);
+    ASSERT_EQ(resp->resp().watchid(), 1);
+    ASSERT_EQ(resp->resp().events_size(), 2);
+    ASSERT_EQ(resp->resp().events(0).kv().version(), 10);
+    ASSERT_EQ(resp->resp().events(1).kv().value(), "v2");
+    ASSERT_EQ(resp->resp().revision(), 11);
+    delete resp;
+
+    // 没有确认时重复发送
+    ASSERT_TRUE(stream.Poll(p1, 0, 10, &resp, &replaced));
+    ASSERT_EQ(resp->resp().events_size(), 3);
+    delete resp;
+
+    ASSERT_TRUE(stream.Poll(p1, 11, 10, &resp, &replaced));
+    ASSERT_EQ(resp->resp().events_size(), 1);
+    ASSERT_EQ(resp->resp().revision(), 12);
+    delete resp;
+    ASSERT_EQ(stream.Pending(), 1U);
+
+    // 全部确认之后挂起，下一个事件立即回复
+    ASSERT_FALSE(stream.Poll(p1, 12, 10, &resp, &replaced));
+    ASSERT_EQ(stream.Pending(), 0U);
+    ASSERT_TRUE(stream.Append(makeEvent("key", "v4"), 13, &poll, &resp));
+    ASSERT_EQ(poll, p1);
+    ASSERT_EQ(resp->resp().events_size(), 1);
+    ASSERT_EQ(resp->resp().revision(), 13);
+    delete resp;
+
+    // 新的拉取替换挂起的拉取
+    auto p2 = makePoll();
+    auto p3 = makePoll();
+    ASSERT_FALSE(stream.Poll(p2, 13, 10, &resp, &replaced));
+    ASSERT_FALSE(stream.Poll(p3, 13, 10, &resp, &replaced));
+    ASSERT_EQ(replaced, p2);
+}
+
+TEST(WatchStream, SameRevision) {
+    WatchStream stream(1, 1, true, "prefix", 100);
+    WatcherPtr poll;
+    watchpb::DsWatchResponse* resp = nullptr;
+    // 一次前缀删除的多个事件revision相同，不能拆开
+    for (int i = 0; i < 5; ++i) {
+        stream.Append(makeEvent("k" + std::to_string(i), ""), 20, &poll, &resp);
+    }
+    stream.Append(makeEvent("k", "v"), 21, &poll, &resp);
+
+    WatcherPtr replaced;
+    ASSERT_TRUE(stream.Poll(makePoll(), 0, 2, &resp, &replaced));
+    ASSERT_EQ(resp->resp().events_size(), 5);
+    ASSERT_EQ(resp->resp().revision(), 20);
+    delete resp;
+}
+
+TEST(WatchStream, Overflow) {
+    WatchStream stream(1, 1, false, "key", 3);
+    WatcherPtr poll;
+    watchpb::DsWatchResponse* resp = nullptr;
+    for (int i = 1; i <= 4; ++i) {
+        stream.Append(makeEvent("key", "v"), i, &poll, &resp);
+    }
+    ASSERT_TRUE(stream.Overflowed());
+    ASSERT_EQ(stream.Pending(), 0U);
+    // 溢出之后不再缓存，直到重新加载
+    stream.Append(makeEvent("key", "v"), 5, &poll, &resp);
+    ASSERT_EQ(stream.Pending(), 0U);
+
+    stream.Reset();
+    ASSERT_FALSE(stream.Overflowed());
+    stream.Append(makeEvent("key", "v"), 6, &poll, &resp);
+    ASSERT_EQ(stream.Pending(), 1U);
+}
+
+TEST(Watcher, SharedNotify) {
+    watchpb::DsWatchResponse resp;
+    resp.mutable_resp()->set_scope(watchpb::RESPONSE_PART);
+    resp.mutable_resp()->add_events()->CopyFrom(makeEvent("key", "value"));
+    auto body = Watcher::EncodeNotify(resp);
+
+    // 每个watcher的watch id编码在前面，和共用的内容合并成一个回复
+    for (WatcherId id : {1, 123456789}) {
+        watchpb::DsWatchResponse actual;
+        ASSERT_TRUE(actual.ParseFromString(Watcher::EncodeNotifyHead(id) + *body));
+        ASSERT_EQ(actual.resp().watchid(), id);
+        ASSERT_EQ(actual.resp().scope(), watchpb::RESPONSE_PART);
+        ASSERT_EQ(actual.resp().events_size(), 1);
+        ASSERT_EQ(actual.resp().events(0).kv().value(), "value");
+    }
+}
+
+TEST(WatchStream, Manager) {
+    WatchStreamManager manager;
+    auto s1 = manager.Add(1, false, "key");
+    auto s2 = manager.Add(1, true, "prefix");
+    ASSERT_NE(s1->Id(), s2->Id());
+    ASSERT_EQ(manager.Size(), 2U);
+
+    ASSERT_EQ(manager.Get(s1->Id(), 1, "key"), s1);
+    // key不一致的不能继续
+    ASSERT_EQ(manager.Get(s1->Id(), 1, "other"), nullptr);
+    ASSERT_EQ(manager.Get(s1->Id(), 2, "key"), nullptr);
+
+    std::vector<WatchStreamPtr> streams;
+    manager.Find("key", false, &streams);
+    manager.Find("key", true, &streams);
+    ASSERT_EQ(streams.size(), 1U);
+    ASSERT_EQ(streams[0], s1);
+
+    // 有挂起拉取的不删除
+    WatcherPtr replaced;
+    watchpb::DsWatchResponse* resp = nullptr;
+    ASSERT_FALSE(s2->Poll(makePoll(), 0, 10, &resp, &replaced));
+
+    auto now = get_micro_second() / 1000;
+    ASSERT_EQ(manager.Sweep(now), 0U);
+    ASSERT_EQ(manager.Sweep(now + WatchStreamManager::kIdleTimeoutMs + 1000), 1U);
+    ASSERT_EQ(manager.Size(), 1U);
+    ASSERT_EQ(manager.Get(s1->Id(), 1, "key"), nullptr);
+    ASSERT_EQ(manager.Get(s2->Id(), 1, "prefix"), s2);
+
+    streams.clear();
+    manager.Find("key", false, &streams);
+    ASSERT_TRUE(streams.empty());
+}
+
+} /* namespace  */